@@ -0,0 +1,122 @@
+#include <smart_food/algorithms/cost_optimizer.hpp>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+constexpr int kNutrients = 40;
+
+/**
+ * Build a synthetic food table: every food lists about a fifth of the
+ * nutrients, with amounts loosely correlated to its price.
+ */
+std::vector<std::shared_ptr<Ingredient>> makeFoods(std::size_t count, unsigned seed, std::size_t& nonzeros) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> price(0.001, 0.02);
+    std::uniform_real_distribution<double> density(0.0, 1.0);
+    std::bernoulli_distribution lists(0.2);
+
+    std::vector<std::shared_ptr<Ingredient>> foods;
+    foods.reserve(count);
+    nonzeros = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        auto food = std::make_shared<Ingredient>("Food " + std::to_string(i), 100.0, Ingredient::Unit::GRAM);
+        const double unitPrice = price(rng);
+        food->setUnitPrice(unitPrice);
+        for (int n = 0; n < kNutrients; ++n) {
+            if (lists(rng)) {
+                food->addNutritionalInfo("nutrient " + std::to_string(n), 100.0 * density(rng) * (0.5 + 50.0 * unitPrice));
+                ++nonzeros;
+            }
+        }
+        foods.push_back(food);
+    }
+    return foods;
+}
+
+/**
+ * Build a week of family shopping: 21 meals of 6 ingredients drawn from a
+ * pantry of `ingredients` items, and 1 to 3 pack sizes of each item in every
+ * store, about half of them with a volume discount.
+ */
+void makeWeek(int ingredients, int stores, unsigned seed, CostOptimizer& optimizer,
+              std::vector<std::shared_ptr<Ingredient>>& required) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, ingredients - 1);
+    std::uniform_int_distribution<int> sizes(1, 3);
+    std::uniform_int_distribution<int> amount(1, 40);
+    std::uniform_real_distribution<double> price(0.5, 2.0);
+    const int packSizes[] = {100, 250, 400, 500, 750, 1000, 1500, 2000};
+
+    for (int meal = 0; meal < 21; ++meal) {
+        for (int k = 0; k < 6; ++k) {
+            required.push_back(std::make_shared<Ingredient>("Item " + std::to_string(pick(rng)),
+                                                            25.0 * amount(rng), Ingredient::Unit::GRAM));
+        }
+    }
+    for (int store = 0; store < stores; ++store) {
+        for (int item = 0; item < ingredients; ++item) {
+            for (int s = sizes(rng); s > 0; --s) {
+                const int size = packSizes[rng() % 8];
+                PackOffer offer("Store " + std::to_string(store), "Item " + std::to_string(item), size,
+                                Ingredient::Unit::GRAM, size / 250.0 * price(rng));
+                if (rng() % 2) {
+                    offer.addPriceTier(2 + static_cast<int>(rng() % 4), offer.getPackPrice() * 0.85);
+                }
+                optimizer.addOffer(offer);
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    std::vector<CostOptimizer::NutrientTarget> targets;
+    for (int n = 0; n < kNutrients; ++n) {
+        // Every fourth nutrient is also capped, as sodium or sugar would be
+        double maximum = n % 4 == 0 ? 400.0 : std::numeric_limits<double>::infinity();
+        targets.push_back({"nutrient " + std::to_string(n), 100.0 + 5.0 * n, maximum});
+    }
+
+    std::printf("%-10s %10s %12s %12s %12s %12s %12s\n",
+                "foods", "nutrients", "nonzeros", "solve_ms", "iterations", "status", "cost");
+    for (std::size_t size : {1000u, 5000u, 20000u, 50000u}) {
+        std::size_t nonzeros = 0;
+        CostOptimizer optimizer(makeFoods(size, 42, nonzeros));
+        auto solution = optimizer.minimizeCost(targets);
+        const char* status = solution.status == CostOptimizer::Status::OPTIMAL      ? "optimal"
+                             : solution.status == CostOptimizer::Status::INFEASIBLE ? "infeasible"
+                                                                                    : "limit";
+        std::printf("%-10zu %10d %12zu %12.3f %12zu %12s %12.3f\n",
+                    size,
+                    kNutrients,
+                    nonzeros,
+                    solution.solveTime.count() / 1000.0,
+                    solution.iterations,
+                    status,
+                    solution.totalCost);
+    }
+
+    std::printf("\n%-10s %10s %12s %12s %12s %12s\n",
+                "stores", "items", "offers", "solve_ms", "purchases", "cost");
+    for (int stores : {1, 3, 6, 12}) {
+        CostOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{});
+        std::vector<std::shared_ptr<Ingredient>> required;
+        makeWeek(60, stores, 7, optimizer, required);
+        auto plan = optimizer.optimizePurchases(required);
+        std::printf("%-10d %10d %12zu %12.3f %12zu %12.3f\n",
+                    stores,
+                    60,
+                    optimizer.getOfferCount(),
+                    plan.solveTime.count() / 1000.0,
+                    plan.purchases.size(),
+                    plan.totalCost);
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <smart_food/algorithms/expiry_ranker.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+using Steady = std::chrono::steady_clock;
+
+double millisSince(Steady::time_point start) {
+    return std::chrono::duration<double, std::milli>(Steady::now() - start).count();
+}
+
+/**
+ * Build a catalog of `recipes` recipes of 4 to 12 ingredients drawn from
+ * `names` ingredients, popular ones more often.
+ */
+std::vector<std::shared_ptr<Recipe>> makeCatalog(int recipes, int names, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::geometric_distribution<int> pick(8.0 / names);
+    std::uniform_int_distribution<int> size(4, 12);
+    std::vector<std::shared_ptr<Ingredient>> ingredients;
+    for (int n = 0; n < names; ++n) {
+        ingredients.push_back(std::make_shared<Ingredient>("Item " + std::to_string(n), 100.0,
+                                                           Ingredient::Unit::GRAM));
+    }
+    std::vector<std::shared_ptr<Recipe>> catalog;
+    catalog.reserve(static_cast<std::size_t>(recipes));
+    for (int r = 0; r < recipes; ++r) {
+        auto recipe = std::make_shared<Recipe>("Recipe " + std::to_string(r));
+        for (int i = size(rng); i > 0; --i) {
+            recipe->addIngredient(ingredients[static_cast<std::size_t>(pick(rng) % names)]);
+        }
+        catalog.push_back(recipe);
+    }
+    return catalog;
+}
+
+/// A pantry of `lots` lots over distinct ingredients, expiring over the next two weeks
+std::vector<std::shared_ptr<Ingredient>> makePantry(int lots, int names, unsigned seed, Clock::time_point now) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, names - 1);
+    std::uniform_int_distribution<int> shelfLife(0, 14 * 24);
+    std::uniform_real_distribution<double> price(0.002, 0.02);
+    std::vector<std::shared_ptr<Ingredient>> pantry;
+    for (int l = 0; l < lots; ++l) {
+        auto lot = std::make_shared<Ingredient>("Item " + std::to_string(pick(rng)), 500.0, Ingredient::Unit::GRAM);
+        lot->setUnitPrice(price(rng));
+        lot->setExpiryDate(now + std::chrono::hours(shelfLife(rng)));
+        pantry.push_back(lot);
+    }
+    return pantry;
+}
+
+} // namespace
+
+int main() {
+    const int recipes = 500000;
+    const int names = 2000;
+    const auto now = Clock::from_time_t(1700000000);
+
+    auto catalog = makeCatalog(recipes, names, 42);
+    auto start = Steady::now();
+    ExpiryRanker ranker(catalog);
+    std::printf("Indexed %d recipes in %.0f ms\n", recipes, millisSince(start));
+
+    for (int lots : {40, 150, 400}) {
+        auto pantry = makePantry(lots, names, 7, now);
+        start = Steady::now();
+        ranker.setPantry(pantry, now);
+        const double update = millisSince(start);
+
+        const int repeats = 20;
+        std::size_t matched = 0;
+        start = Steady::now();
+        for (int i = 0; i < repeats; ++i) {
+            matched += ranker.rank(20).size();
+        }
+        const double rank = millisSince(start) / repeats;
+        std::printf("Pantry of %3d lots (%zu at risk): setPantry %.2f ms, rank top %zu %.2f ms\n", lots,
+                    ranker.getAtRiskCount(), update, matched / repeats, rank);
+    }
+
+    // Incremental catalog changes
+    auto extra = makeCatalog(1000, names, 99);
+    start = Steady::now();
+    for (const auto& recipe : extra) {
+        ranker.addRecipe(recipe);
+    }
+    for (int r = 0; r < 1000; ++r) {
+        ranker.removeRecipe(catalog[static_cast<std::size_t>(r)]->getId());
+    }
+    std::printf("Added and removed 1000 recipes each in %.2f ms\n", millisSince(start));
+    return 0;
+}
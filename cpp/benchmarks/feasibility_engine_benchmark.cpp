@@ -0,0 +1,95 @@
+#include <smart_food/algorithms/feasibility_engine.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+using Steady = std::chrono::steady_clock;
+
+double millisSince(Steady::time_point start) {
+    return std::chrono::duration<double, std::milli>(Steady::now() - start).count();
+}
+
+/**
+ * Build a catalog of `recipes` recipes of 4 to 12 ingredients drawn from
+ * `names` ingredients, popular ones more often, written for 1 to 6 servings.
+ */
+std::vector<std::shared_ptr<Recipe>> makeCatalog(int recipes, int names, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::geometric_distribution<int> pick(8.0 / names);
+    std::uniform_int_distribution<int> size(4, 12);
+    std::uniform_int_distribution<int> servings(1, 6);
+    std::uniform_real_distribution<double> grams(20.0, 600.0);
+    std::vector<std::shared_ptr<Recipe>> catalog;
+    catalog.reserve(static_cast<std::size_t>(recipes));
+    for (int r = 0; r < recipes; ++r) {
+        auto recipe = std::make_shared<Recipe>("Recipe " + std::to_string(r));
+        recipe->setServings(servings(rng));
+        for (int i = size(rng); i > 0; --i) {
+            recipe->addIngredient(std::make_shared<Ingredient>("Item " + std::to_string(pick(rng) % names),
+                                                               grams(rng), Ingredient::Unit::GRAM));
+        }
+        catalog.push_back(recipe);
+    }
+    return catalog;
+}
+
+} // namespace
+
+int main() {
+    const int recipes = 500000;
+    const int names = 2000;
+    const auto now = Clock::from_time_t(1700000000);
+
+    auto catalog = makeCatalog(recipes, names, 42);
+    auto start = Steady::now();
+    FeasibilityEngine engine(catalog, 2);
+    std::printf("Indexed %d recipes in %.0f ms\n", recipes, millisSince(start));
+
+    // A well stocked pantry of the 300 most common ingredients
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> kilos(0.2, 3.0);
+    std::vector<std::shared_ptr<Ingredient>> pantry;
+    for (int n = 0; n < 300; ++n) {
+        pantry.push_back(std::make_shared<Ingredient>("Item " + std::to_string(n), kilos(rng),
+                                                      Ingredient::Unit::KILOGRAM));
+    }
+    start = Steady::now();
+    engine.setPantry(pantry, now);
+    std::printf("setPantry: %.2f ms, %zu recipes cookable\n", millisSince(start), engine.getCookable().size());
+
+    // Cooking and shopping: one ingredient at a time
+    const int updates = 10000;
+    std::uniform_int_distribution<int> item(0, 299);
+    std::uniform_real_distribution<double> grams(50.0, 500.0);
+    std::vector<std::shared_ptr<Ingredient>> amounts;
+    for (int u = 0; u < updates; ++u) {
+        amounts.push_back(std::make_shared<Ingredient>("Item " + std::to_string(item(rng)), grams(rng),
+                                                       Ingredient::Unit::GRAM));
+    }
+    start = Steady::now();
+    for (int u = 0; u < updates; ++u) {
+        if (u % 2 == 0) {
+            engine.removeStock(*amounts[static_cast<std::size_t>(u)]);
+        } else {
+            engine.addStock(*amounts[static_cast<std::size_t>(u)]);
+        }
+    }
+    std::printf("Stock update: %.2f us each\n", 1000.0 * millisSince(start) / updates);
+
+    start = Steady::now();
+    engine.setServings(3);
+    std::printf("setServings (full recount): %.2f ms\n", millisSince(start));
+
+    start = Steady::now();
+    auto results = engine.evaluate();
+    std::printf("evaluate with shortfalls: %.2f ms for %zu recipes\n", millisSince(start), results.size());
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <smart_food/algorithms/kitchen_scheduler.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+using Steady = std::chrono::steady_clock;
+
+double millisSince(Steady::time_point start) {
+    return std::chrono::duration<double, std::milli>(Steady::now() - start).count();
+}
+
+/// Build `recipes` recipes of 6 to 10 steps, some of them starting in parallel with the previous one
+std::vector<std::shared_ptr<Recipe>> makeBatch(int recipes, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> steps(6, 10);
+    std::uniform_int_distribution<int> minutes(2, 45);
+    std::uniform_int_distribution<int> kind(0, 5);
+    std::vector<std::shared_ptr<Recipe>> batch;
+    for (int r = 0; r < recipes; ++r) {
+        auto recipe = std::make_shared<Recipe>("Recipe " + std::to_string(r));
+        const int count = steps(rng);
+        for (int s = 1; s <= count; ++s) {
+            Recipe::Step step{s, "Step", std::chrono::minutes(minutes(rng)), std::nullopt, {}};
+            switch (kind(rng)) {
+            case 0: step.resources = {{"oven", 1}}; break;
+            case 1: step.resources = {{"burner", 1}}; break;
+            case 2: step.resources = {{"burner", 2}, {"hands", 1}}; break;
+            default: step.resources = {{"hands", 1}}; break;
+            }
+            if (s > 2 && rng() % 4 == 0) {
+                step.dependsOn = std::vector<int>{s - 2};
+            }
+            recipe->addStep(step);
+        }
+        batch.push_back(recipe);
+    }
+    return batch;
+}
+
+} // namespace
+
+int main() {
+    KitchenScheduler scheduler({{"burner", 6}, {"hands", 4}, {"oven", 2}});
+    for (int recipes : {3, 12, 40, 100}) {
+        auto batch = makeBatch(recipes, 42);
+        long sequential = 0;
+        for (const auto& recipe : batch) {
+            sequential += recipe->getTotalTime().count();
+        }
+        auto start = Steady::now();
+        auto timeline = scheduler.schedule(batch);
+        std::printf("%3d recipes, %4zu steps: makespan %4ld min (lower bound %4ld, one at a time %5ld)%s in %.1f ms\n",
+                    recipes, timeline.steps.size(), static_cast<long>(timeline.makespan.count()),
+                    static_cast<long>(timeline.lowerBound.count()), sequential,
+                    timeline.optimal ? ", optimal" : "", millisSince(start));
+    }
+    return 0;
+}
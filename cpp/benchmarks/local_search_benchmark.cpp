@@ -0,0 +1,96 @@
+#include <smart_food/algorithms/meal_planner.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+/**
+ * Build a synthetic catalog: every recipe uses three ingredients out of a
+ * shared pool, and is allowed in one or two slot types.
+ */
+MealPlanner makePlanner(std::size_t recipeCount, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, 199);
+    std::uniform_real_distribution<double> grams(50.0, 250.0);
+    std::uniform_real_distribution<double> pricePerGram(0.002, 0.03);
+    std::uniform_real_distribution<double> caloriesPerGram(0.3, 3.5);
+    std::uniform_real_distribution<double> proteinPerGram(0.0, 0.25);
+    std::uniform_int_distribution<int> typePick(0, 3);
+
+    std::vector<std::shared_ptr<Recipe>> recipes;
+    std::vector<std::vector<Meal::Type>> types;
+    for (std::size_t i = 0; i < recipeCount; ++i) {
+        auto recipe = std::make_shared<Recipe>("Recipe " + std::to_string(i));
+        for (int j = 0; j < 3; ++j) {
+            double quantity = grams(rng);
+            auto ingredient = std::make_shared<Ingredient>(
+                "Ingredient " + std::to_string(pick(rng)), quantity, Ingredient::Unit::GRAM);
+            ingredient->setUnitPrice(pricePerGram(rng));
+            ingredient->addNutritionalInfo("calories", quantity * caloriesPerGram(rng));
+            ingredient->addNutritionalInfo("protein", quantity * proteinPerGram(rng));
+            recipe->addIngredient(ingredient);
+        }
+        recipes.push_back(recipe);
+        types.push_back({static_cast<Meal::Type>(typePick(rng)), static_cast<Meal::Type>(typePick(rng))});
+    }
+
+    MealPlanner planner(recipes);
+    for (std::size_t i = 0; i < recipeCount; ++i) {
+        planner.setAllowedTypes(recipes[i]->getId(), types[i]);
+    }
+    return planner;
+}
+
+} // namespace
+
+int main() {
+    MealPlanner::Constraints constraints;
+    constraints.days = 28;
+    constraints.nutrients.push_back({"calories", 1800.0, 2400.0});
+    constraints.nutrients.push_back({"protein", 60.0, 1e9});
+    constraints.maxRepeats = 2;
+    constraints.minDaysBetweenRepeats = 7;
+
+    MealPlanner planner = makePlanner(5000, 42);
+    MealPlanner::Options options;
+    options.strategy = MealPlanner::Strategy::LOCAL_SEARCH;
+    options.seed = 1;
+    options.maxEvaluations = 8000000;
+
+    const std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::size_t> threadCounts;
+    for (std::size_t threads = 1; threads < cores; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(cores);
+
+    std::printf("%-8s %12s %14s %14s %8s %10s %10s\n",
+                "threads", "solve_ms", "evaluations", "evals_per_s", "speedup", "feasible", "cost");
+    double baseline = 0.0;
+    for (std::size_t threads : threadCounts) {
+        options.threads = threads;
+        auto plan = planner.plan(constraints, options);
+        const double seconds = plan.solveTime.count() / 1e6;
+        const double rate = plan.nodesExplored / seconds;
+        if (baseline == 0.0) {
+            baseline = rate;
+        }
+        std::printf("%-8zu %12.1f %14zu %14.0f %8.2f %10s %10.2f\n",
+                    threads,
+                    seconds * 1000.0,
+                    plan.nodesExplored,
+                    rate,
+                    rate / baseline,
+                    plan.feasible ? "yes" : "no",
+                    plan.feasible ? plan.totalCost : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <smart_food/algorithms/meal_planner.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+/**
+ * Build a synthetic catalog: every recipe uses three ingredients out of a
+ * shared pool, and is allowed in one or two slot types.
+ */
+MealPlanner makePlanner(std::size_t recipeCount, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, 199);
+    std::uniform_real_distribution<double> grams(50.0, 250.0);
+    std::uniform_real_distribution<double> pricePerGram(0.002, 0.03);
+    std::uniform_real_distribution<double> caloriesPerGram(0.3, 3.5);
+    std::uniform_real_distribution<double> proteinPerGram(0.0, 0.25);
+    std::uniform_int_distribution<int> typePick(0, 3);
+
+    std::vector<std::shared_ptr<Recipe>> recipes;
+    std::vector<std::vector<Meal::Type>> types;
+    for (std::size_t i = 0; i < recipeCount; ++i) {
+        auto recipe = std::make_shared<Recipe>("Recipe " + std::to_string(i));
+        for (int j = 0; j < 3; ++j) {
+            double quantity = grams(rng);
+            auto ingredient = std::make_shared<Ingredient>(
+                "Ingredient " + std::to_string(pick(rng)), quantity, Ingredient::Unit::GRAM);
+            ingredient->setUnitPrice(pricePerGram(rng));
+            ingredient->addNutritionalInfo("calories", quantity * caloriesPerGram(rng));
+            ingredient->addNutritionalInfo("protein", quantity * proteinPerGram(rng));
+            recipe->addIngredient(ingredient);
+        }
+        recipes.push_back(recipe);
+
+        Meal::Type first = static_cast<Meal::Type>(typePick(rng));
+        Meal::Type second = static_cast<Meal::Type>(typePick(rng));
+        types.push_back({first, second});
+    }
+
+    MealPlanner planner(recipes);
+    for (std::size_t i = 0; i < recipeCount; ++i) {
+        planner.setAllowedTypes(recipes[i]->getId(), types[i]);
+    }
+    return planner;
+}
+
+} // namespace
+
+int main() {
+    MealPlanner::Constraints constraints;
+    constraints.days = 7;
+    constraints.nutrients.push_back({"calories", 1800.0, 2400.0});
+    constraints.nutrients.push_back({"protein", 60.0, 1e9});
+
+    MealPlanner::Options options;
+    options.timeLimit = std::chrono::milliseconds(1000);
+
+    std::printf("%-10s %12s %12s %10s %12s %10s %10s %10s %10s\n",
+                "recipes", "solve_ms", "nodes", "optimal", "cost", "gap_pct", "cached_us", "swap_ms", "pantry_ms");
+    for (std::size_t size : {500u, 1000u, 2000u, 5000u, 10000u}) {
+        MealPlanner planner = makePlanner(size, 42);
+        auto cache = std::make_shared<MealPlanner::Cache>(64);
+        planner.setCache(cache);
+        auto plan = planner.plan(constraints, options);
+        // The same request again; runs stopped by the time limit are not cached
+        double cachedUs = -1.0;
+        auto repeated = planner.plan(constraints, options);
+        if (cache->getStats().hits > 0) {
+            cachedUs = static_cast<double>(repeated.solveTime.count());
+        }
+        double gap = plan.feasible && plan.totalCost > 0.0
+                         ? 100.0 * (plan.totalCost - plan.lowerBound) / plan.totalCost
+                         : 0.0;
+        // Interactive edits of the plan just solved
+        double swapMs = 0.0;
+        double pantryMs = 0.0;
+        if (plan.feasible) {
+            swapMs = planner.swapRecipe(3, 2).solveTime.count() / 1000.0;
+            pantryMs = planner.updatePantry({std::make_shared<Ingredient>("Ingredient 5", 2.0, Ingredient::Unit::KILOGRAM)})
+                           .solveTime.count() / 1000.0;
+        }
+        std::printf("%-10zu %12.3f %12zu %10s %12.2f %10.3f %10.0f %10.3f %10.3f\n",
+                    size,
+                    plan.solveTime.count() / 1000.0,
+                    plan.nodesExplored,
+                    plan.optimal ? "yes" : "no",
+                    plan.feasible ? plan.totalCost : 0.0,
+                    gap,
+                    cachedUs,
+                    swapMs,
+                    pantryMs);
+    }
+    return 0;
+}
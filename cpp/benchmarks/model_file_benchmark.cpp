@@ -0,0 +1,161 @@
+#include <smart_food/ml/predictor.hpp>
+#include <smart_food/ml/spoilage_model.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace smart_food::ml;
+
+namespace {
+
+using Steady = std::chrono::steady_clock;
+
+double millisSince(Steady::time_point start) {
+    return std::chrono::duration<double, std::milli>(Steady::now() - start).count();
+}
+
+/// Sum of a field over this process's mappings of a file, from /proc/self/smaps, in KiB
+long mappedKiB(const std::string& path, const std::string& field) {
+    std::ifstream file("/proc/self/smaps");
+    std::string line;
+    bool inFile = false;
+    long total = 0;
+    while (std::getline(file, line)) {
+        if (line.find('-') < line.find(' ')) {  // A mapping's header: address range, permissions, ..., path
+            inFile = line.size() >= path.size() && line.compare(line.size() - path.size(), path.size(), path) == 0;
+        } else if (inFile && line.compare(0, field.size() + 1, field + ":") == 0) {
+            total += std::stol(line.substr(field.size() + 1));
+        }
+    }
+    return total;
+}
+
+SpoilageModel::Tree fullTree(std::mt19937_64& rng, int depth) {
+    SpoilageModel::Tree tree;
+    std::uniform_int_distribution<int> feature(0, 4);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const int splits = (1 << depth) - 1;
+    for (int n = 0; n < 2 * splits + 1; ++n) {
+        SpoilageModel::Node node;
+        if (n < splits) {
+            node.feature = feature(rng);
+            node.threshold = unit(rng) * 20.0f;
+            node.left = static_cast<std::uint32_t>(2 * n + 1);
+            node.right = static_cast<std::uint32_t>(2 * n + 2);
+        } else {
+            node.value = unit(rng) - 0.5f;
+        }
+        tree.nodes.push_back(node);
+    }
+    return tree;
+}
+
+} // namespace
+
+int main() {
+    const std::uint32_t households = 250000;
+    const std::uint32_t ingredients = 8;
+    const int workers = 10;
+    const std::string predictorPath = "/tmp/smart_food_predictor.sfm";
+    const std::string modelPath = "/tmp/smart_food_spoilage";
+    const auto epoch = std::chrono::system_clock::time_point(std::chrono::hours(24 * 20000));
+
+    // 2M series, 28 days of history each
+    Predictor predictor;
+    predictor.reserve(static_cast<std::size_t>(households) * ingredients);
+    for (int day = 0; day < 28; ++day) {
+        for (std::uint32_t household = 0; household < households; ++household) {
+            for (std::uint32_t ingredient = 0; ingredient < ingredients; ++ingredient) {
+                predictor.update(household, ingredient, 1.0 + (household + day) % 9,
+                                 epoch + std::chrono::hours(24 * day + 12));
+            }
+        }
+    }
+    const auto now = epoch + std::chrono::hours(24 * 28);
+
+    auto begin = Steady::now();
+    predictor.saveModelFile(predictorPath);
+    const double saveMillis = millisSince(begin);
+    begin = Steady::now();
+    auto opened = Predictor::openModelFile(predictorPath);
+    const double openMillis = millisSince(begin);
+    std::ifstream sized(predictorPath, std::ios::binary | std::ios::ate);
+    const auto fileMiB = static_cast<double>(sized.tellg()) / (1 << 20);
+    std::printf("predictor: %zu series, %.0f MiB file, save %.0f ms, open (mapping and checksum) %.0f ms\n",
+                opened.size(), fileMiB, saveMillis, openMillis);
+
+#if defined(__linux__)
+    // Workers open the file and forecast every series, touching every page of it, then report while all are alive
+    int done[2];
+    int release[2];
+    if (pipe(done) != 0 || pipe(release) != 0) {
+        return 1;
+    }
+    std::fflush(stdout);
+    for (int w = 0; w < workers; ++w) {
+        if (fork() == 0) {
+            close(release[1]);
+            auto worker = Predictor::openModelFile(predictorPath);
+            double total = 0.0;
+            for (std::uint32_t household = 0; household < households; ++household) {
+                for (std::uint32_t ingredient = 0; ingredient < ingredients; ++ingredient) {
+                    total += worker.forecast(household, ingredient, 1, now);
+                }
+            }
+            const char byte = 1;
+            char ignored;
+            if (write(done[1], &byte, 1) != 1 || read(release[0], &ignored, 1) != 0) {
+                _exit(1);
+            }
+            std::printf("worker %d: forecast total %.0f; model file resident %ld MiB, proportional share %ld MiB, "
+                        "private %ld MiB\n",
+                        w, total, mappedKiB(predictorPath, "Rss") / 1024, mappedKiB(predictorPath, "Pss") / 1024,
+                        (mappedKiB(predictorPath, "Private_Clean") + mappedKiB(predictorPath, "Private_Dirty")) / 1024);
+            std::fflush(stdout);
+            _exit(0);
+        }
+    }
+    for (int w = 0; w < workers; ++w) {
+        char byte;
+        if (read(done[0], &byte, 1) != 1) {
+            return 1;
+        }
+    }
+    std::printf("%d workers and this process map the file; together they hold one copy of it\n", workers);
+    std::fflush(stdout);
+    close(release[1]);
+    for (int w = 0; w < workers; ++w) {
+        wait(nullptr);
+    }
+#endif
+
+    // A spoilage ensemble, loaded from JSON and from a model file
+    std::mt19937_64 rng(42);
+    std::vector<SpoilageModel::Tree> trees;
+    for (int t = 0; t < 1000; ++t) {
+        trees.push_back(fullTree(rng, 6));
+    }
+    SpoilageModel model(trees, 0.0, SpoilageModel::Link::LOGISTIC);
+    model.saveToFile(modelPath + ".json");
+    model.saveModelFile(modelPath + ".sfm");
+    begin = Steady::now();
+    auto fromJson = SpoilageModel::loadFromFile(modelPath + ".json");
+    const double jsonMillis = millisSince(begin);
+    begin = Steady::now();
+    auto fromFile = SpoilageModel::openModelFile(modelPath + ".sfm");
+    const double fileMillis = millisSince(begin);
+    std::printf("spoilage model, %zu trees of 64 leaves: JSON load %.1f ms, model file open %.2f ms\n",
+                fromFile.getTreeCount(), jsonMillis, fileMillis);
+    std::remove(predictorPath.c_str());
+    std::remove((modelPath + ".json").c_str());
+    std::remove((modelPath + ".sfm").c_str());
+    return fromJson.getTreeCount() == fromFile.getTreeCount() ? 0 : 1;
+}
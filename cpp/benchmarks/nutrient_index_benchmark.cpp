@@ -0,0 +1,82 @@
+#include <smart_food/algorithms/nutrient_index.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+using Steady = std::chrono::steady_clock;
+
+double millisSince(Steady::time_point start) {
+    return std::chrono::duration<double, std::milli>(Steady::now() - start).count();
+}
+
+/// Build `recipes` recipes with random macros, cost and time per serving
+std::vector<std::shared_ptr<Recipe>> makeCatalog(int recipes, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::lognormal_distribution<double> calories(6.2, 0.4);
+    std::uniform_real_distribution<double> share(0.05, 0.45);
+    std::uniform_real_distribution<double> cost(0.5, 15.0);
+    std::uniform_int_distribution<int> minutes(5, 150);
+    std::vector<std::shared_ptr<Recipe>> catalog;
+    catalog.reserve(static_cast<std::size_t>(recipes));
+    for (int r = 0; r < recipes; ++r) {
+        const double kcal = calories(rng);
+        const double protein = kcal * share(rng) / 4.0;
+        const double fat = kcal * share(rng) / 9.0;
+        auto ingredient = std::make_shared<Ingredient>("Mix", 1.0, Ingredient::Unit::PIECE);
+        ingredient->setUnitPrice(cost(rng));
+        ingredient->addNutritionalInfo("calories", kcal);
+        ingredient->addNutritionalInfo("protein", protein);
+        ingredient->addNutritionalInfo("fat", fat);
+        ingredient->addNutritionalInfo("carbohydrates", (kcal - 4.0 * protein - 9.0 * fat) / 4.0);
+        auto recipe = std::make_shared<Recipe>("Recipe " + std::to_string(r));
+        recipe->addIngredient(ingredient);
+        recipe->addStep({1, "Cook", std::chrono::minutes(minutes(rng)), std::nullopt, {}});
+        catalog.push_back(recipe);
+    }
+    return catalog;
+}
+
+} // namespace
+
+int main() {
+    const int recipes = 1000000;
+    auto catalog = makeCatalog(recipes, 42);
+
+    auto start = Steady::now();
+    NutrientIndex index(catalog);
+    std::printf("Indexed %d recipes over %zu nutrients in %.0f ms\n", recipes, index.getNutrients().size(),
+                millisSince(start));
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> kcal(300.0, 900.0);
+    std::uniform_real_distribution<double> protein(10.0, 60.0);
+    std::uniform_real_distribution<double> fat(10.0, 40.0);
+    const int queries = 200;
+    for (int variant = 0; variant < 3; ++variant) {
+        std::size_t found = 0;
+        start = Steady::now();
+        for (int q = 0; q < queries; ++q) {
+            NutrientIndex::Query query;
+            query.targets = {{"calories", kcal(rng)}, {"protein", protein(rng)}};
+            if (variant >= 1) {
+                query.ranges = {{"fat", 0.0, fat(rng)}};
+            }
+            if (variant >= 2) {
+                query.maxCostPerServing = 6.0;
+                query.maxTotalTime = std::chrono::minutes(45);
+            }
+            found += index.search(query).size();
+        }
+        const char* names[] = {"targets only", "with a fat bound", "with fat, cost and time bounds"};
+        std::printf("Top-10 query %-32s %.3f ms (%.1f matches)\n", names[variant], millisSince(start) / queries,
+                    static_cast<double>(found) / queries);
+    }
+    return 0;
+}
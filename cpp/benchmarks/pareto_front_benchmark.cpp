@@ -0,0 +1,126 @@
+#include <smart_food/algorithms/meal_planner.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+/**
+ * Build a synthetic catalog: every recipe uses three ingredients out of a
+ * shared pool, takes 10 to 120 minutes and is allowed in one or two slot types.
+ */
+MealPlanner makePlanner(std::size_t recipeCount, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, 199);
+    std::uniform_real_distribution<double> grams(50.0, 250.0);
+    std::uniform_real_distribution<double> pricePerGram(0.002, 0.03);
+    std::uniform_real_distribution<double> caloriesPerGram(0.3, 3.5);
+    std::uniform_real_distribution<double> proteinPerGram(0.0, 0.25);
+    std::uniform_int_distribution<int> minutes(10, 120);
+    std::uniform_int_distribution<int> typePick(0, 3);
+
+    std::vector<std::shared_ptr<Recipe>> recipes;
+    std::vector<std::vector<Meal::Type>> types;
+    for (std::size_t i = 0; i < recipeCount; ++i) {
+        auto recipe = std::make_shared<Recipe>("Recipe " + std::to_string(i));
+        for (int j = 0; j < 3; ++j) {
+            double quantity = grams(rng);
+            auto ingredient = std::make_shared<Ingredient>(
+                "Ingredient " + std::to_string(pick(rng)), quantity, Ingredient::Unit::GRAM);
+            ingredient->setUnitPrice(pricePerGram(rng));
+            ingredient->addNutritionalInfo("calories", quantity * caloriesPerGram(rng));
+            ingredient->addNutritionalInfo("protein", quantity * proteinPerGram(rng));
+            recipe->addIngredient(ingredient);
+        }
+        recipe->addStep({1, "Cook", std::chrono::minutes(minutes(rng)), std::nullopt, {}});
+        recipes.push_back(recipe);
+        types.push_back({static_cast<Meal::Type>(typePick(rng)), static_cast<Meal::Type>(typePick(rng))});
+    }
+
+    MealPlanner planner(recipes);
+    for (std::size_t i = 0; i < recipeCount; ++i) {
+        planner.setAllowedTypes(recipes[i]->getId(), types[i]);
+    }
+    return planner;
+}
+
+} // namespace
+
+int main() {
+    MealPlanner::Constraints constraints;
+    constraints.days = 7;
+    constraints.nutrients.push_back({"calories", 1800.0, 2400.0});
+    constraints.nutrients.push_back({"protein", 60.0, 1e9});
+
+    // A pantry of twenty items, half of them expiring within the week
+    const auto start = std::chrono::system_clock::now();
+    for (int i = 0; i < 20; ++i) {
+        auto item = std::make_shared<Ingredient>("Ingredient " + std::to_string(i * 7), 300.0, Ingredient::Unit::GRAM);
+        item->setUnitPrice(0.01);
+        if (i % 2 == 0) {
+            item->setExpiryDate(start + std::chrono::hours(24 * (1 + i % 5)));
+        }
+        constraints.pantry.push_back(item);
+    }
+
+    MealPlanner planner = makePlanner(5000, 42);
+    MealPlanner::FrontOptions options;
+    options.points = 20;
+    options.seed = 1;
+    options.start = start;
+
+    const std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::size_t> threadCounts;
+    for (std::size_t threads = 1; threads < cores; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(cores);
+
+    std::printf("%-8s %10s %12s %7s %12s %12s %12s %12s\n",
+                "threads", "solve_ms", "evaluations", "points", "cost", "nutrition", "prep_min", "waste");
+    for (std::size_t threads : threadCounts) {
+        options.threads = threads;
+        auto front = planner.planFront(constraints, options);
+        if (front.empty()) {
+            std::printf("%-8zu no feasible plan\n", threads);
+            continue;
+        }
+        auto lowest = front.front().objectives;
+        auto highest = front.front().objectives;
+        for (const auto& point : front) {
+            lowest.cost = std::min(lowest.cost, point.objectives.cost);
+            highest.cost = std::max(highest.cost, point.objectives.cost);
+            lowest.nutritionError = std::min(lowest.nutritionError, point.objectives.nutritionError);
+            highest.nutritionError = std::max(highest.nutritionError, point.objectives.nutritionError);
+            lowest.prepTime = std::min(lowest.prepTime, point.objectives.prepTime);
+            highest.prepTime = std::max(highest.prepTime, point.objectives.prepTime);
+            lowest.waste = std::min(lowest.waste, point.objectives.waste);
+            highest.waste = std::max(highest.waste, point.objectives.waste);
+        }
+        std::printf("%-8zu %10.1f %12zu %7zu %5.1f-%-6.1f %5.2f-%-6.2f %5ld-%-6ld %5.1f-%-6.1f\n",
+                    threads,
+                    front.front().plan.solveTime.count() / 1000.0,
+                    front.front().plan.nodesExplored,
+                    front.size(),
+                    lowest.cost, highest.cost,
+                    lowest.nutritionError, highest.nutritionError,
+                    static_cast<long>(lowest.prepTime.count()), static_cast<long>(highest.prepTime.count()),
+                    lowest.waste, highest.waste);
+    }
+
+    // Reference: the cheapest plan local search finds with its default budget
+    MealPlanner::Options reference;
+    reference.strategy = MealPlanner::Strategy::LOCAL_SEARCH;
+    reference.seed = 1;
+    auto cheapest = planner.plan(constraints, reference);
+    std::printf("local search cheapest plan: %.2f in %.1f ms\n", cheapest.totalCost,
+                cheapest.solveTime.count() / 1000.0);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <smart_food/ml/pattern_analyzer.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_food::ml;
+
+namespace {
+
+using Steady = std::chrono::steady_clock;
+
+double millisSince(Steady::time_point start) {
+    return std::chrono::duration<double, std::milli>(Steady::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    const int recipes = 60;
+    const int ingredients = 300;
+    const std::size_t meals = 10000 * 365 * 3;  // 10k households, a year of 3 meals a day
+
+    // Recipes hold 4-8 fixed ingredients; cooks add up to 3 extras, favouring staples
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> anyIngredient(0, ingredients - 1);
+    std::vector<std::vector<std::string>> recipeItems(recipes);
+    for (int r = 0; r < recipes; ++r) {
+        recipeItems[r].push_back("recipe:" + std::to_string(r));
+        const int size = 4 + r % 5;
+        for (int i = 0; i < size; ++i) {
+            recipeItems[r].push_back("ingredient " + std::to_string(anyIngredient(rng)));
+        }
+    }
+    std::vector<double> popularity;
+    for (int r = 0; r < recipes; ++r) {
+        popularity.push_back(1.0 / (1.0 + r));
+    }
+    std::discrete_distribution<int> recipe(popularity.begin(), popularity.end());
+    std::geometric_distribution<int> staple(0.05);
+    std::uniform_int_distribution<int> extras(0, 3);
+
+    PatternAnalyzer analyzer(std::vector<std::shared_ptr<smart_food::core::Meal>>{});
+    auto begin = Steady::now();
+    std::vector<std::string> items;
+    for (std::size_t m = 0; m < meals; ++m) {
+        items = recipeItems[recipe(rng)];
+        for (int e = extras(rng); e > 0; --e) {
+            items.push_back("ingredient " + std::to_string(staple(rng) % ingredients));
+        }
+        analyzer.addTransaction(items);
+    }
+    std::printf("%zu transactions over %zu items added in %.0f ms\n", analyzer.getTransactionCount(),
+                analyzer.getItemCount(), millisSince(begin));
+
+    for (double minSupport : {0.01, 0.002}) {
+        PatternAnalyzer::Options options;
+        options.minSupport = minSupport;
+        options.maxItems = 0;
+        begin = Steady::now();
+        auto itemsets = analyzer.findFrequentItemsets(options);
+        const double itemsetMillis = millisSince(begin);
+
+        options.maxItems = 4;
+        options.minConfidence = 0.5;
+        options.minLift = 1.5;
+        begin = Steady::now();
+        auto rules = analyzer.findAssociationRules(options);
+        std::printf("min support %.3f: %zu itemsets in %.0f ms, %zu rules (up to 4 items) in %.0f ms\n", minSupport,
+                    itemsets.size(), itemsetMillis, rules.size(), millisSince(begin));
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <smart_food/ml/predictor.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace smart_food::ml;
+
+namespace {
+
+using Steady = std::chrono::steady_clock;
+
+double millisSince(Steady::time_point start) {
+    return std::chrono::duration<double, std::milli>(Steady::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    const std::uint32_t households = 200000;
+    const std::uint32_t ingredients = 20;
+    const int days = 60;
+    const std::size_t eventsPerDay = 400000;
+
+    // Each event consumes one of the 4M series at random, in time order
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<std::uint32_t> household(0, households - 1);
+    std::uniform_int_distribution<std::uint32_t> ingredient(0, ingredients - 1);
+    std::uniform_real_distribution<double> quantity(10.0, 300.0);
+    const auto epoch = std::chrono::system_clock::time_point(std::chrono::hours(24 * 20000));
+    const auto step = std::chrono::microseconds(86400000000LL / static_cast<long long>(eventsPerDay));
+
+    Predictor predictor;
+    std::vector<Predictor::Event> batch(eventsPerDay);
+    double updateMillis = 0.0;
+    for (int day = 0; day < days; ++day) {
+        const auto start = epoch + std::chrono::hours(24 * day);
+        for (std::size_t e = 0; e < eventsPerDay; ++e) {
+            batch[e] = {household(rng), ingredient(rng), quantity(rng),
+                        std::chrono::time_point_cast<std::chrono::system_clock::duration>(start + step * e)};
+        }
+        const auto begin = Steady::now();
+        predictor.update(batch);
+        updateMillis += millisSince(begin);
+    }
+    const double events = static_cast<double>(eventsPerDay) * days;
+    std::printf("%.0fM events into %.2fM series: %.1f ns per event (%.0fM events per minute on one core)\n",
+                events / 1e6, predictor.size() / 1e6, updateMillis * 1e6 / events,
+                events / updateMillis * 60000.0 / 1e6);
+
+    std::vector<Predictor::StockQuery> queries;
+    for (int q = 0; q < 1000000; ++q) {
+        queries.push_back({household(rng), ingredient(rng), quantity(rng) * 10.0});
+    }
+    const auto now = epoch + std::chrono::hours(24 * days);
+    const auto begin = Steady::now();
+    auto result = predictor.daysUntilRunOut(queries, now);
+    const double queryMillis = millisSince(begin);
+    std::size_t finite = 0;
+    double total = 0.0;
+    for (double d : result) {
+        if (std::isfinite(d)) {
+            ++finite;
+            total += d;
+        }
+    }
+    std::printf("%zu run-out queries in %.0f ms (%.0f ns each), %zu with a forecast, mean %.1f days\n",
+                queries.size(), queryMillis, queryMillis * 1e6 / queries.size(), finite,
+                finite > 0 ? total / finite : 0.0);
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <smart_food/core/price_history.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_food::core;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // namespace
+
+/**
+ * Ingest a synthetic catalog: `items` products at 20 stores, one price a
+ * day with a few minutes of jitter for `days` days, changing about once a
+ * week. Then time latest-price lookups and one-year range summaries.
+ */
+int main() {
+    const int stores = 20;
+    const auto start = std::chrono::system_clock::from_time_t(1600000000);
+
+    std::printf("%-8s %8s %12s %12s %10s %12s %14s\n",
+                "items", "days", "points", "ingest_ms", "bytes/pt", "latest_us", "summary_us");
+    for (int items : {100, 1000}) {
+        const int days = 1000;
+        std::mt19937 rng(17);
+        std::bernoulli_distribution changes(1.0 / 7.0);
+        std::uniform_int_distribution<int> cents(99, 999);
+        std::uniform_int_distribution<int> jitter(0, 600);
+
+        std::vector<std::string> itemNames;
+        std::vector<std::string> storeNames;
+        for (int i = 0; i < items; ++i) {
+            itemNames.push_back("Item " + std::to_string(i));
+        }
+        for (int s = 0; s < stores; ++s) {
+            storeNames.push_back("Store " + std::to_string(s));
+        }
+        std::vector<double> prices(static_cast<std::size_t>(items) * stores);
+        for (auto& price : prices) {
+            price = cents(rng) / 100.0;
+        }
+
+        PriceHistory history;
+        auto clock = Clock::now();
+        for (int day = 0; day < days; ++day) {
+            for (int i = 0; i < items; ++i) {
+                for (int s = 0; s < stores; ++s) {
+                    double& price = prices[static_cast<std::size_t>(i) * stores + s];
+                    if (changes(rng)) {
+                        price = cents(rng) / 100.0;
+                    }
+                    history.record(itemNames[i], storeNames[s],
+                                   start + std::chrono::hours(24 * day) + std::chrono::seconds(jitter(rng)), price);
+                }
+            }
+        }
+        const double ingest = millisecondsSince(clock);
+
+        clock = Clock::now();
+        double checksum = 0.0;
+        for (int i = 0; i < items; ++i) {
+            checksum += history.latestPrices(itemNames[i]).front().price;
+        }
+        const double latest = millisecondsSince(clock) * 1000.0 / items;
+
+        clock = Clock::now();
+        const int queries = 1000;
+        for (int q = 0; q < queries; ++q) {
+            const int from = static_cast<int>(rng() % (days - 365));
+            auto summary = history.summarize(itemNames[rng() % items], storeNames[rng() % stores],
+                                             start + std::chrono::hours(24 * from),
+                                             start + std::chrono::hours(24 * (from + 365)));
+            checksum += summary.meanPrice;
+        }
+        const double summary = millisecondsSince(clock) * 1000.0 / queries;
+
+        std::printf("%-8d %8d %12zu %12.1f %10.2f %12.3f %14.3f\n",
+                    items,
+                    days,
+                    history.getPointCount(),
+                    ingest,
+                    static_cast<double>(history.memoryUsage()) / history.getPointCount(),
+                    latest,
+                    summary);
+        if (checksum < 0.0) {
+            std::printf("unreachable\n");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <smart_food/algorithms/recipe_graph.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+using Steady = std::chrono::steady_clock;
+
+double millisSince(Steady::time_point start) {
+    return std::chrono::duration<double, std::milli>(Steady::now() - start).count();
+}
+
+struct Catalog {
+    std::vector<std::shared_ptr<Ingredient>> pantry;  ///< Shared by every recipe using the ingredient
+    std::vector<std::shared_ptr<Recipe>> dishes;      ///< Recipes not used by others
+};
+
+/// Build `dishes` dishes on top of sauces, doughs and stocks, which build on each other
+Catalog makeCatalog(int dishes, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> price(0.001, 0.03);
+    std::uniform_real_distribution<double> amount(20.0, 500.0);
+    std::uniform_int_distribution<int> servings(1, 8);
+    Catalog catalog;
+    for (int i = 0; i < 600; ++i) {
+        auto ingredient = std::make_shared<Ingredient>("Ingredient " + std::to_string(i), amount(rng),
+                                                       Ingredient::Unit::GRAM);
+        ingredient->setUnitPrice(price(rng));
+        ingredient->addNutritionalInfo("calories", amount(rng));
+        ingredient->addNutritionalInfo("protein", amount(rng) / 20.0);
+        catalog.pantry.push_back(ingredient);
+    }
+    std::uniform_int_distribution<std::size_t> pick(0, catalog.pantry.size() - 1);
+    auto makeRecipe = [&](const std::string& name, int ingredients) {
+        auto recipe = std::make_shared<Recipe>(name);
+        recipe->setServings(servings(rng));
+        for (int i = 0; i < ingredients; ++i) {
+            recipe->addIngredient(catalog.pantry[pick(rng)]);
+        }
+        return recipe;
+    };
+
+    // Three layers of components, each using components of the layers below
+    std::vector<std::shared_ptr<Recipe>> components;
+    for (int layer = 0; layer < 3; ++layer) {
+        const std::size_t below = components.size();
+        for (int c = 0; c < 1000; ++c) {
+            auto component = makeRecipe("Component " + std::to_string(layer) + "." + std::to_string(c), 4);
+            for (int u = 0; below > 0 && u < 2; ++u) {
+                component->addComponent(components[rng() % below], 1.0);
+            }
+            components.push_back(component);
+        }
+    }
+    for (int d = 0; d < dishes; ++d) {
+        auto dish = makeRecipe("Dish " + std::to_string(d), 5);
+        for (int u = 0; u < 2; ++u) {
+            dish->addComponent(components[rng() % components.size()], 1.0 + u);
+        }
+        catalog.dishes.push_back(dish);
+    }
+    return catalog;
+}
+
+} // namespace
+
+int main() {
+    const int dishes = 100000;
+    auto catalog = makeCatalog(dishes, 42);
+
+    auto start = Steady::now();
+    RecipeGraph graph(catalog.dishes);
+    std::printf("Linked %zu recipes in %.0f ms\n", graph.size(), millisSince(start));
+
+    start = Steady::now();
+    double total = 0.0;
+    for (const auto& dish : catalog.dishes) {
+        total += graph.evaluate(dish->getId()).cost;
+    }
+    std::printf("Evaluated the catalog in %.0f ms (%llu recipes computed, total cost %.0f)\n", millisSince(start),
+                static_cast<unsigned long long>(graph.getStats().evaluations), total);
+
+    start = Steady::now();
+    double direct = 0.0;
+    for (const auto& dish : catalog.dishes) {
+        direct += dish->calculateTotalCost();
+    }
+    std::printf("Recipe::calculateTotalCost over the catalog: %.0f ms (total cost %.0f)\n", millisSince(start), direct);
+
+    for (std::size_t changed : {std::size_t{0}, std::size_t{17}, std::size_t{301}}) {
+        auto& ingredient = catalog.pantry[changed];
+        ingredient->setUnitPrice(ingredient->getUnitPrice() * 1.1);
+        const auto before = graph.getStats().evaluations;
+        start = Steady::now();
+        const std::size_t stale = graph.invalidateIngredient(ingredient->getName());
+        total = 0.0;
+        for (const auto& dish : catalog.dishes) {
+            total += graph.evaluate(dish->getId()).cost;
+        }
+        std::printf("Price change of %s: %zu recipes stale, %llu recomputed, catalog re-priced in %.1f ms\n",
+                    ingredient->getName().c_str(), stale,
+                    static_cast<unsigned long long>(graph.getStats().evaluations - before), millisSince(start));
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <smart_food/algorithms/shopping_optimizer.hpp>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+/**
+ * Build an institutional plan: meals of 8 ingredients drawn from a pool of
+ * 500, in mixed units, planned over 90 days, with a pantry of 300 lots.
+ */
+void makePlan(std::size_t mealCount, unsigned seed, std::vector<std::shared_ptr<Meal>>& meals,
+              std::vector<std::shared_ptr<Ingredient>>& pantry) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, 499);
+    std::uniform_real_distribution<double> amount(0.05, 2.0);
+    const Ingredient::Unit units[] = {Ingredient::Unit::GRAM, Ingredient::Unit::KILOGRAM,
+                                      Ingredient::Unit::MILLILITER, Ingredient::Unit::CUP,
+                                      Ingredient::Unit::PIECE};
+    const auto start = std::chrono::system_clock::from_time_t(1700000000);
+
+    for (std::size_t m = 0; m < mealCount; ++m) {
+        auto meal = std::make_shared<Meal>("Meal " + std::to_string(m), Meal::Type::LUNCH);
+        meal->setPlannedTime(start + std::chrono::hours(24 * (m % 90)));
+        for (int k = 0; k < 8; ++k) {
+            const int item = pick(rng);
+            auto ingredient = std::make_shared<Ingredient>("Ingredient " + std::to_string(item),
+                                                           100.0 * amount(rng), units[item % 5]);
+            ingredient->setUnitPrice(0.01);
+            meal->addIngredient(ingredient);
+        }
+        meals.push_back(meal);
+    }
+    for (int lot = 0; lot < 300; ++lot) {
+        const int item = pick(rng);
+        auto ingredient = std::make_shared<Ingredient>("Ingredient " + std::to_string(item),
+                                                       1000.0 * amount(rng), units[item % 5]);
+        ingredient->setExpiryDate(start + std::chrono::hours(24 * (lot % 60)));
+        pantry.push_back(ingredient);
+    }
+}
+
+} // namespace
+
+int main() {
+    std::printf("%-10s %12s %10s %12s %14s\n", "meals", "uses", "items", "serial_ms", "parallel_ms");
+    for (std::size_t size : {1000u, 10000u, 50000u}) {
+        std::vector<std::shared_ptr<Meal>> meals;
+        std::vector<std::shared_ptr<Ingredient>> pantry;
+        makePlan(size, 42, meals, pantry);
+        ShoppingOptimizer optimizer(pantry);
+
+        ShoppingOptimizer::Options options;
+        options.now = std::chrono::system_clock::from_time_t(1700000000);
+        options.threads = 1;
+        auto serial = optimizer.buildList(meals, options);
+        options.threads = 0;
+        auto parallel = optimizer.buildList(meals, options);
+
+        std::printf("%-10zu %12zu %10zu %12.3f %14.3f\n",
+                    size,
+                    size * 8,
+                    parallel.items.size(),
+                    serial.buildTime.count() / 1000.0,
+                    parallel.buildTime.count() / 1000.0);
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <smart_food/algorithms/similarity_index.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+using Steady = std::chrono::steady_clock;
+
+double millisSince(Steady::time_point start) {
+    return std::chrono::duration<double, std::milli>(Steady::now() - start).count();
+}
+
+/**
+ * Build an imported catalog of `recipes` recipes of 5 to 14 ingredients
+ * drawn from `names` ingredients, popular ones more often; one recipe in
+ * ten is a near copy of an earlier one with an ingredient changed.
+ */
+std::vector<std::shared_ptr<Recipe>> makeCatalog(int recipes, int names, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::geometric_distribution<int> pick(4.0 / names);
+    std::uniform_int_distribution<int> size(5, 14);
+    std::vector<std::shared_ptr<Ingredient>> ingredients;
+    for (int n = 0; n < names; ++n) {
+        ingredients.push_back(std::make_shared<Ingredient>("Item " + std::to_string(n), 100.0,
+                                                           Ingredient::Unit::GRAM));
+    }
+    std::vector<std::shared_ptr<Recipe>> catalog;
+    catalog.reserve(static_cast<std::size_t>(recipes));
+    for (int r = 0; r < recipes; ++r) {
+        auto recipe = std::make_shared<Recipe>("Recipe " + std::to_string(r));
+        if (r % 10 == 9) {
+            const auto& original = catalog[std::uniform_int_distribution<std::size_t>(0, catalog.size() - 1)(rng)];
+            for (std::size_t i = 1; i < original->getIngredients().size(); ++i) {
+                recipe->addIngredient(original->getIngredients()[i]);
+            }
+        } else {
+            for (int i = size(rng); i > 1; --i) {
+                recipe->addIngredient(ingredients[static_cast<std::size_t>(pick(rng) % names)]);
+            }
+        }
+        recipe->addIngredient(ingredients[static_cast<std::size_t>(pick(rng) % names)]);
+        catalog.push_back(recipe);
+    }
+    return catalog;
+}
+
+} // namespace
+
+int main() {
+    const int recipes = 200000;
+    auto catalog = makeCatalog(recipes, 3000, 42);
+
+    auto start = Steady::now();
+    SimilarityIndex index(catalog);
+    std::printf("Indexed %d recipes in %.0f ms\n", recipes, millisSince(start));
+
+    const int queries = 2000;
+    std::size_t neighbors = 0;
+    start = Steady::now();
+    for (int q = 0; q < queries; ++q) {
+        neighbors += index.findSimilar(catalog[static_cast<std::size_t>(q) * 97]->getId(), 10, 0.3).size();
+    }
+    const double query = millisSince(start) / queries;
+
+    // The brute-force scan the index replaces
+    start = Steady::now();
+    std::size_t scanned = 0;
+    for (const auto& recipe : catalog) {
+        scanned += SimilarityIndex::similarity(*catalog[0], *recipe) >= 0.3;
+    }
+    std::printf("Top-10 query: %.3f ms (%.1f neighbors on average), brute-force scan: %.1f ms\n", query,
+                static_cast<double>(neighbors) / queries, millisSince(start));
+
+    start = Steady::now();
+    auto groups = index.findDuplicates(0.75);
+    std::size_t duplicates = 0;
+    for (const auto& group : groups) {
+        duplicates += group.size();
+    }
+    std::printf("Dedup pass: %zu groups, %zu recipes in %.0f ms\n", groups.size(), duplicates, millisSince(start));
+    return scanned == 0;
+}
@@ -0,0 +1,111 @@
+#include <smart_food/ml/sketches.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace smart_food::ml;
+
+namespace {
+
+using Steady = std::chrono::steady_clock;
+
+double millisSince(Steady::time_point start) {
+    return std::chrono::duration<double, std::milli>(Steady::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    const std::size_t events = 20000000;
+    const int recipes = 100000;
+    const int ingredients = 1000000;
+
+    std::vector<std::string> recipeNames;
+    for (int r = 0; r < recipes; ++r) {
+        recipeNames.push_back("recipe " + std::to_string(r));
+    }
+    std::vector<std::string> ingredientNames;
+    for (int i = 0; i < ingredients; ++i) {
+        ingredientNames.push_back("ingredient " + std::to_string(i));
+    }
+
+    // Recipe popularity is Zipf-like; ingredients and costs are uniform
+    std::mt19937_64 rng(42);
+    std::vector<double> weights;
+    for (int r = 0; r < recipes; ++r) {
+        weights.push_back(1.0 / (r + 1));
+    }
+    std::discrete_distribution<int> recipe(weights.begin(), weights.end());
+    std::uniform_int_distribution<int> ingredient(0, ingredients - 1);
+    std::lognormal_distribution<double> cost(1.5, 0.6);
+    std::vector<int> recipeStream(events);
+    std::vector<int> ingredientStream(events);
+    std::vector<double> costStream(events);
+    for (std::size_t e = 0; e < events; ++e) {
+        recipeStream[e] = recipe(rng);
+        ingredientStream[e] = ingredient(rng);
+        costStream[e] = cost(rng);
+    }
+
+    CountMinSketch popularity(4096, 4, 100);
+    auto begin = Steady::now();
+    for (std::size_t e = 0; e < events; ++e) {
+        popularity.add(recipeNames[recipeStream[e]]);
+    }
+    const double countMinMillis = millisSince(begin);
+
+    HyperLogLog distinct;
+    begin = Steady::now();
+    for (std::size_t e = 0; e < events; ++e) {
+        distinct.add(ingredientNames[ingredientStream[e]]);
+    }
+    const double hyperLogLogMillis = millisSince(begin);
+
+    QuantileSketch costs;
+    begin = Steady::now();
+    for (std::size_t e = 0; e < events; ++e) {
+        costs.add(costStream[e]);
+    }
+    const double quantileMillis = millisSince(begin);
+
+    // Exact answers, for accuracy and for the memory they take
+    std::vector<std::uint64_t> exactCounts(recipes, 0);
+    for (int r : recipeStream) {
+        ++exactCounts[r];
+    }
+    std::unordered_set<int> exactDistinct(ingredientStream.begin(), ingredientStream.end());
+    std::sort(costStream.begin(), costStream.end());
+
+    std::size_t topMatches = 0;
+    auto hitters = popularity.getHeavyHitters();
+    for (std::size_t i = 0; i < 10 && i < hitters.size(); ++i) {
+        topMatches += hitters[i].first == recipeNames[i] ? 1 : 0;
+    }
+    double worstOvercount = 0.0;
+    for (int r = 0; r < recipes; r += 97) {
+        worstOvercount = std::max(worstOvercount, static_cast<double>(popularity.estimate(recipeNames[r]) - exactCounts[r]));
+    }
+    std::printf("%zuM events per sketch\n", events / 1000000);
+    std::printf("count-min:   %5.1f ns/event, %zu KiB, top-10 recipes %zu/10 exact, worst overcount %.2f%% of total\n",
+                countMinMillis * 1e6 / events, popularity.getWidth() * popularity.getDepth() * 8 / 1024, topMatches,
+                100.0 * worstOvercount / events);
+    std::printf("hyperloglog: %5.1f ns/event, 16 KiB, %.0f distinct estimated for %zu (%.2f%% off)\n",
+                hyperLogLogMillis * 1e6 / events, distinct.estimate(), exactDistinct.size(),
+                100.0 * std::abs(distinct.estimate() - exactDistinct.size()) / exactDistinct.size());
+    double worstRank = 0.0;
+    for (double fraction : {0.01, 0.1, 0.5, 0.9, 0.99}) {
+        const double estimate = costs.quantile(fraction);
+        const double trueRank = static_cast<double>(std::upper_bound(costStream.begin(), costStream.end(), estimate) -
+                                                    costStream.begin()) / events;
+        worstRank = std::max(worstRank, std::abs(trueRank - fraction));
+    }
+    std::printf("quantiles:   %5.1f ns/event, %zu values retained (%zu KiB), worst rank error %.3f%%\n",
+                quantileMillis * 1e6 / events, costs.getRetained(), costs.getRetained() * 8 / 1024, 100.0 * worstRank);
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <smart_food/ml/spoilage_model.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace smart_food::ml;
+
+namespace {
+
+using Steady = std::chrono::steady_clock;
+
+double millisSince(Steady::time_point start) {
+    return std::chrono::duration<double, std::milli>(Steady::now() - start).count();
+}
+
+/// Random tree with the given number of leaves, splitting on realistic ranges
+SpoilageModel::Tree randomTree(std::mt19937_64& rng, int leaves) {
+    SpoilageModel::Tree tree;
+    tree.nodes.emplace_back();
+    std::vector<std::uint32_t> open = {0};
+    std::uniform_int_distribution<int> feature(0, 4);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const float scale[5] = {20.0f, 14.0f, 1000.0f, 200.0f, 1000.0f};
+    for (int splits = 1; splits < leaves; ++splits) {
+        const std::size_t pick = std::uniform_int_distribution<std::size_t>(0, open.size() - 1)(rng);
+        const std::uint32_t index = open[pick];
+        open.erase(open.begin() + static_cast<std::ptrdiff_t>(pick));
+        const auto left = static_cast<std::uint32_t>(tree.nodes.size());
+        tree.nodes.emplace_back();
+        tree.nodes.emplace_back();
+        auto& node = tree.nodes[index];
+        node.feature = feature(rng);
+        node.threshold = unit(rng) * scale[node.feature];
+        node.left = left;
+        node.right = left + 1;
+        open.push_back(left);
+        open.push_back(left + 1);
+    }
+    for (auto& node : tree.nodes) {
+        node.value = node.feature < 0 ? unit(rng) - 0.5f : 0.0f;
+    }
+    return tree;
+}
+
+void report(const char* name, const SpoilageModel& model, const SpoilageFeatures& features, std::vector<float>& out) {
+    model.score(features, out.data());  // Warm up
+    const int rounds = 5;
+    const auto begin = Steady::now();
+    for (int round = 0; round < rounds; ++round) {
+        model.score(features, out.data());
+    }
+    const double millis = millisSince(begin) / rounds;
+    std::printf("%-26s %8.1f ms per batch, %7.1fM items/s\n", name, millis, features.size() / millis / 1000.0);
+}
+
+} // namespace
+
+int main() {
+    const std::size_t items = 4000000;
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<std::uint32_t> category(0, 19);
+    std::uniform_real_distribution<float> days(-3.0f, 14.0f);
+    std::lognormal_distribution<float> quantity(5.0f, 1.0f);
+    std::lognormal_distribution<float> usage(3.0f, 1.0f);
+    SpoilageFeatures features;
+    features.reserve(items);
+    for (std::size_t i = 0; i < items; ++i) {
+        features.add(category(rng), days(rng), quantity(rng), usage(rng));
+    }
+    std::vector<float> out(items);
+    std::printf("%zuM items per batch\n", items / 1000000);
+
+    SpoilageModel::Linear linear;
+    linear.intercept = -1.0;
+    linear.weights = {-0.2, 0.001, -0.01, 0.004};
+    linear.categoryWeights.assign(20, 0.1);
+    report("linear", SpoilageModel(linear, SpoilageModel::Link::IDENTITY), features, out);
+    report("logistic", SpoilageModel(linear, SpoilageModel::Link::LOGISTIC), features, out);
+
+    for (auto shape : {std::pair<int, int>{32, 16}, {100, 8}, {100, 32}}) {
+        std::vector<SpoilageModel::Tree> trees;
+        for (int t = 0; t < shape.first; ++t) {
+            trees.push_back(randomTree(rng, shape.second));
+        }
+        char name[64];
+        std::snprintf(name, sizeof(name), "trees %d x %d leaves", shape.first, shape.second);
+        report(name, SpoilageModel(trees, 0.0, SpoilageModel::Link::LOGISTIC), features, out);
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <smart_food/algorithms/shopping_optimizer.hpp>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+/**
+ * Build a synthetic city: home at the center of a 20 x 20 km square, stores
+ * at random points with Euclidean distances, and every store carrying about
+ * two thirds of `items` products in 1 to 3 pack sizes, priced around a
+ * per-store level so that some stores are cheaper overall.
+ */
+ShoppingOptimizer makeCity(int stores, int items, unsigned seed, ShoppingOptimizer::ShoppingList& list) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> coordinate(0.0, 20.0);
+    std::uniform_real_distribution<double> level(0.8, 1.25);
+    std::uniform_real_distribution<double> price(0.8, 1.25);
+    std::uniform_int_distribution<int> sizes(1, 3);
+    std::uniform_int_distribution<int> amount(1, 12);
+    std::bernoulli_distribution carries(0.65);
+    const int packSizes[] = {100, 250, 400, 500, 750, 1000, 1500, 2000};
+
+    std::vector<std::string> names;
+    std::vector<std::pair<double, double>> points{{10.0, 10.0}};
+    for (int s = 0; s < stores; ++s) {
+        names.push_back("Store " + std::to_string(s));
+        points.emplace_back(coordinate(rng), coordinate(rng));
+    }
+    std::vector<std::vector<double>> distances;
+    for (const auto& a : points) {
+        distances.emplace_back();
+        for (const auto& b : points) {
+            distances.back().push_back(std::hypot(a.first - b.first, a.second - b.second));
+        }
+    }
+
+    ShoppingOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{});
+    optimizer.setStores(names, distances);
+    for (int item = 0; item < items; ++item) {
+        const double toBuy = 100.0 * amount(rng);
+        list.items.push_back({"Item " + std::to_string(item), Ingredient::Unit::GRAM, toBuy, 0.0, toBuy, 0.0, 1, {}});
+    }
+    for (int s = 0; s < stores; ++s) {
+        const double storeLevel = level(rng);
+        for (int item = 0; item < items; ++item) {
+            if (!carries(rng)) {
+                continue;
+            }
+            for (int k = sizes(rng); k > 0; --k) {
+                const int size = packSizes[rng() % 8];
+                PackOffer offer(names[s], "Item " + std::to_string(item), size, Ingredient::Unit::GRAM,
+                                size / 250.0 * storeLevel * price(rng));
+                if (rng() % 2) {
+                    offer.addPriceTier(2 + static_cast<int>(rng() % 4), offer.getPackPrice() * 0.85);
+                }
+                optimizer.addOffer(offer);
+            }
+        }
+    }
+    return optimizer;
+}
+
+} // namespace
+
+int main() {
+    std::printf("%-8s %8s %10s %10s %8s %12s %12s %12s %10s\n",
+                "stores", "items", "solver", "solve_ms", "visits", "item_cost", "travel", "total", "covered");
+    for (int stores : {5, 10, 12, 25, 50, 100}) {
+        ShoppingOptimizer::ShoppingList list;
+        ShoppingOptimizer optimizer = makeCity(stores, 60, 11, list);
+        ShoppingOptimizer::TripOptions options;
+        options.costPerDistance = 0.4;  // Per km, fuel and time
+        auto trip = optimizer.planTrip(list, options);
+        std::printf("%-8d %8zu %10s %10.3f %8zu %12.2f %12.2f %12.2f %10s\n",
+                    stores,
+                    list.items.size(),
+                    trip.optimal ? "exact" : "heuristic",
+                    trip.solveTime.count() / 1000.0,
+                    trip.visits.size(),
+                    trip.itemCost,
+                    trip.travelCost,
+                    trip.totalCost,
+                    trip.feasible ? "all" : "partial");
+    }
+    return 0;
+}
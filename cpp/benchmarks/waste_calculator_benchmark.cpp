@@ -0,0 +1,114 @@
+#include <smart_food/algorithms/waste_calculator.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+
+/**
+ * Build a household: a pantry of `pantry` lots over `ingredients` staples,
+ * three meals a day of 6 ingredients for `days` days, and a weekly shop of
+ * 15 lots.
+ */
+void makeHousehold(int days, int pantry, int ingredients, unsigned seed, WasteCalculator& calculator,
+                   std::vector<std::shared_ptr<Meal>>& meals, Clock::time_point start) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, ingredients - 1);
+    std::uniform_int_distribution<int> shelfLife(2, 40);
+    std::uniform_real_distribution<double> amount(50.0, 300.0);
+    std::uniform_real_distribution<double> price(0.002, 0.02);
+    const auto day = std::chrono::hours(24);
+
+    auto makeLot = [&](Clock::time_point from) {
+        auto lot = std::make_shared<Ingredient>("Item " + std::to_string(pick(rng)), 5.0 * amount(rng),
+                                                Ingredient::Unit::GRAM);
+        lot->setUnitPrice(price(rng));
+        lot->setExpiryDate(from + shelfLife(rng) * day);
+        return lot;
+    };
+    std::vector<std::shared_ptr<Ingredient>> inventory;
+    for (int l = 0; l < pantry; ++l) {
+        inventory.push_back(makeLot(start));
+    }
+    calculator.setInventory(inventory);
+    for (int week = 0; week * 7 < days; ++week) {
+        const auto arrival = start + week * 7 * day;
+        for (int l = 0; l < 15; ++l) {
+            calculator.addPurchase(makeLot(arrival), arrival);
+        }
+    }
+    for (int d = 0; d < days; ++d) {
+        for (int m = 0; m < 3; ++m) {
+            auto meal = std::make_shared<Meal>("Meal", static_cast<Meal::Type>(m));
+            meal->setPlannedTime(start + d * day + std::chrono::hours(8 + 5 * m));
+            for (int k = 0; k < 6; ++k) {
+                meal->addIngredient(std::make_shared<Ingredient>("Item " + std::to_string(pick(rng)),
+                                                                 amount(rng) / 2.0, Ingredient::Unit::GRAM));
+            }
+            meals.push_back(meal);
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    const auto start = Clock::from_time_t(1700000000);
+    const int runs = 200;
+
+    std::printf("%-8s %8s %8s %12s %12s %12s %12s\n",
+                "days", "meals", "lots", "simulate_us", "waste_items", "shortages", "waste_cost");
+    for (int days : {7, 30, 90, 365}) {
+        WasteCalculator calculator(std::vector<std::shared_ptr<Ingredient>>{});
+        std::vector<std::shared_ptr<Meal>> meals;
+        makeHousehold(days, 40, 60, 3, calculator, meals, start);
+
+        WasteCalculator::Projection projection;
+        const auto clock = std::chrono::steady_clock::now();
+        for (int run = 0; run < runs; ++run) {
+            projection = calculator.simulate(meals, start, start + std::chrono::hours(24 * days));
+        }
+        const double micros =
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - clock).count() / runs;
+        std::printf("%-8d %8zu %8d %12.1f %12zu %12zu %12.2f\n",
+                    days,
+                    meals.size(),
+                    40 + 15 * ((days + 6) / 7),
+                    micros,
+                    projection.waste.size(),
+                    projection.shortages.size(),
+                    projection.wasteCost);
+    }
+
+    std::printf("\n%-8s %10s %8s %12s %12s %12s %12s\n",
+                "days", "scenarios", "threads", "risk_ms", "expected", "p90", "stddev");
+    for (int days : {30, 90}) {
+        WasteCalculator calculator(std::vector<std::shared_ptr<Ingredient>>{});
+        std::vector<std::shared_ptr<Meal>> meals;
+        makeHousehold(days, 40, 60, 3, calculator, meals, start);
+        for (std::size_t scenarios : {1000u, 10000u}) {
+            for (std::size_t threads : {1u, 0u}) {
+                WasteCalculator::RiskOptions options;
+                options.scenarios = scenarios;
+                options.threads = threads;
+                auto risk = calculator.estimateRisk(meals, start, start + std::chrono::hours(24 * days), options);
+                std::printf("%-8d %10zu %8s %12.2f %12.2f %12.2f %12.2f\n",
+                            days,
+                            scenarios,
+                            threads == 1 ? "1" : "pool",
+                            risk.simulationTime.count() / 1000.0,
+                            risk.expectedCost,
+                            risk.percentileCosts[1],
+                            risk.standardDeviation);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace smart_food {
+namespace algorithms {
+
+/**
+ * @brief Shared flag used to ask a running solver to stop.
+ *
+ * Copies share the same flag, so the caller keeps one copy and hands another
+ * to the solver. Solvers poll it and return their best answer so far.
+ */
+class CancellationToken {
+public:
+    // Constructors
+    CancellationToken();
+
+    // Operations
+    /**
+     * @brief Ask every solver holding a copy of this token to stop
+     */
+    void cancel();
+
+    /**
+     * @brief Check whether cancel() was called on any copy
+     */
+    bool isCancelled() const;
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
+/**
+ * @brief Snapshot of a solver's state, as seen through a SolutionChannel
+ */
+struct SolverProgress {
+    double bestCost = std::numeric_limits<double>::infinity();     ///< Cost of the best solution, infinity if none
+    double lowerBound = -std::numeric_limits<double>::infinity();  ///< Proven lower bound on the optimum
+    std::uint64_t iterations = 0;    ///< Nodes or evaluations so far
+    std::uint64_t improvements = 0;  ///< Solutions published so far
+    bool finished = false;           ///< The solver has returned
+
+    /**
+     * @brief Relative distance between the best cost and the bound
+     * @return 0 when proven optimal, infinity without a solution or bound
+     */
+    double gap() const {
+        if (bestCost == std::numeric_limits<double>::infinity() || lowerBound == -std::numeric_limits<double>::infinity()) {
+            return std::numeric_limits<double>::infinity();
+        }
+        double scale = bestCost < 0.0 ? -bestCost : bestCost;
+        return scale > 0.0 ? (bestCost - lowerBound) / scale : 0.0;
+    }
+};
+
+/**
+ * @brief Lock-free publication of a solver's best solution and progress.
+ *
+ * The solver offers every improving solution and periodically adds to the
+ * iteration count; any number of other threads may read at the same time
+ * without blocking the solver. Published solutions are immutable and kept
+ * until the channel is destroyed, so a pointer returned by best() stays
+ * valid for the channel's lifetime. Only strictly improving solutions are
+ * kept, which bounds the memory by the number of improvements.
+ *
+ * Each field of progress() is read atomically, but a snapshot taken while
+ * the solver runs may combine values from slightly different moments.
+ *
+ * @tparam Solution Solution type, copied once per improvement
+ */
+template <typename Solution>
+class SolutionChannel {
+public:
+    SolutionChannel() = default;
+    SolutionChannel(const SolutionChannel&) = delete;
+    SolutionChannel& operator=(const SolutionChannel&) = delete;
+
+    ~SolutionChannel() {
+        Node* node = head_.load(std::memory_order_acquire);
+        while (node) {
+            Node* previous = node->previous;
+            delete node;
+            node = previous;
+        }
+    }
+
+    // Publishing, called by solvers
+    /**
+     * @brief Check whether a solution of this cost would be kept
+     */
+    bool improves(double cost) const {
+        return cost < bestCost();
+    }
+
+    /**
+     * @brief Publish a solution if it is better than the current best
+     * @param cost Cost of the solution
+     * @param solution The solution
+     * @return true if it became the best solution
+     */
+    bool offer(double cost, Solution solution) {
+        Node* node = new Node{cost, std::move(solution), head_.load(std::memory_order_acquire)};
+        while (!node->previous || cost < node->previous->cost) {
+            if (head_.compare_exchange_weak(node->previous, node, std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+                improvements_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        delete node;
+        return false;
+    }
+
+    /**
+     * @brief Count work done since the last call
+     */
+    void addIterations(std::uint64_t count) {
+        iterations_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Raise the proven lower bound; lower values are ignored
+     */
+    void raiseLowerBound(double bound) {
+        double current = lowerBound_.load(std::memory_order_relaxed);
+        while (bound > current &&
+               !lowerBound_.compare_exchange_weak(current, bound, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief Mark the run as complete
+     */
+    void finish() {
+        finished_.store(true, std::memory_order_release);
+    }
+
+    // Reading, from any thread
+    /**
+     * @brief Get the best solution so far
+     * @return The solution, or nullptr if none was published yet
+     */
+    const Solution* best() const {
+        Node* node = head_.load(std::memory_order_acquire);
+        return node ? &node->solution : nullptr;
+    }
+
+    /**
+     * @brief Get the cost of the best solution, infinity if none
+     */
+    double bestCost() const {
+        Node* node = head_.load(std::memory_order_acquire);
+        return node ? node->cost : std::numeric_limits<double>::infinity();
+    }
+
+    /**
+     * @brief Get the current progress metrics
+     */
+    SolverProgress progress() const {
+        SolverProgress progress;
+        progress.finished = finished_.load(std::memory_order_acquire);
+        progress.bestCost = bestCost();
+        progress.lowerBound = lowerBound_.load(std::memory_order_relaxed);
+        progress.iterations = iterations_.load(std::memory_order_relaxed);
+        progress.improvements = improvements_.load(std::memory_order_relaxed);
+        return progress;
+    }
+
+private:
+    struct Node {
+        double cost;
+        Solution solution;
+        Node* previous;
+    };
+
+    std::atomic<Node*> head_{nullptr};
+    std::atomic<double> lowerBound_{-std::numeric_limits<double>::infinity()};
+    std::atomic<std::uint64_t> iterations_{0};
+    std::atomic<std::uint64_t> improvements_{0};
+    std::atomic<bool> finished_{false};
+};
+
+/**
+ * @brief How long a solver may run and where it reports to
+ *
+ * Solvers taking a SolveControl check it periodically and, once the deadline
+ * passes or the token is cancelled, return the best answer found so far
+ * instead of failing.
+ *
+ * @tparam Solution Solution type published on the channel
+ */
+template <typename Solution>
+struct SolveControl {
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point deadline = Clock::time_point::max();     ///< Latest time to return
+    CancellationToken cancellation;                            ///< Stops the solver when cancelled
+    std::shared_ptr<SolutionChannel<Solution>> channel;        ///< Receives progress, may be null
+
+    /**
+     * @brief Check whether the solver must return now
+     */
+    bool shouldStop() const {
+        return cancellation.isCancelled() || (deadline != Clock::time_point::max() && Clock::now() >= deadline);
+    }
+};
+
+} // namespace algorithms
+} // namespace smart_food
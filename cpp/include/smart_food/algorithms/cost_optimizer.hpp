@@ -0,0 +1,257 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "smart_food/core/ingredient.hpp"
+#include "smart_food/core/pack_offer.hpp"
+#include "smart_food/core/price_history.hpp"
+#include "smart_food/core/recipe.hpp"
+#include "smart_food/utils/result_cache.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+/**
+ * @brief Finds the cheapest mix of foods that meets nutrient targets.
+ *
+ * This is the classic diet problem: every candidate food (an ingredient or a
+ * recipe) can be bought in any non-negative, optionally capped amount, and
+ * the total of each targeted nutrient must stay within its range. The
+ * amounts are continuous, which makes it a linear program; it is solved
+ * with a bounded dual simplex over a sparse nutrient matrix, so catalogs of
+ * thousands of foods solve in milliseconds.
+ *
+ * An ingredient is measured in its own unit: one unit costs getUnitPrice()
+ * and provides its nutritional info divided by getQuantity(). A recipe is
+ * measured in servings: one serving costs calculateTotalCost() divided by
+ * getServings() and provides getNutritionalInfo(), which is per serving.
+ *
+ * A second mode prices a shopping list against what stores actually sell:
+ * given pack offers with tiered prices and limited stock, possibly from
+ * several stores, optimizePurchases() picks for every required ingredient
+ * the cheapest combination of whole packs that covers its total quantity.
+ */
+class CostOptimizer {
+public:
+    /**
+     * @brief Allowed range of one nutrient over the whole mix
+     */
+    struct NutrientTarget {
+        std::string nutrient;  ///< Nutrient name, e.g. "protein"
+        double minimum = 0.0;  ///< Lower bound of the total
+        double maximum = std::numeric_limits<double>::infinity();  ///< Upper bound of the total
+    };
+
+    /**
+     * @brief Solver limits
+     */
+    struct Options {
+        std::size_t maxIterations = 0;  ///< Simplex pivots, 0 for automatic
+        double tolerance = 1e-9;        ///< Feasibility and optimality tolerance, relative to the data scale
+    };
+
+    /**
+     * @brief Outcome of an optimization
+     */
+    enum class Status {
+        OPTIMAL,         ///< The cheapest mix was found
+        INFEASIBLE,      ///< No mix of the foods meets every target
+        ITERATION_LIMIT  ///< Options::maxIterations was reached first
+    };
+
+    /**
+     * @brief Amount of one food in the mix
+     *
+     * Exactly one of ingredient and recipe is set.
+     */
+    struct Purchase {
+        std::shared_ptr<core::Ingredient> ingredient;
+        std::shared_ptr<core::Recipe> recipe;
+        double quantity;  ///< In the ingredient's unit, or in servings
+        double cost;      ///< Cost of that quantity
+    };
+
+    /**
+     * @brief Result of minimizeCost()
+     */
+    struct Solution {
+        Status status = Status::ITERATION_LIMIT;
+        std::vector<Purchase> purchases;            ///< Foods with a positive amount, in the order they were added
+        double totalCost = 0.0;                     ///< Sum of the purchase costs
+        std::map<std::string, double> nutrients;    ///< Targeted nutrient -> total in the mix
+        std::map<std::string, double> marginalCosts;  ///< Targeted nutrient -> cost change per unit increase of its binding bound, 0 if not binding
+        std::size_t iterations = 0;                 ///< Simplex pivots
+        std::chrono::microseconds solveTime{0};     ///< Wall-clock time, model building included
+    };
+
+    /**
+     * @brief Packs bought from one offer
+     */
+    struct PackPurchase {
+        core::PackOffer offer;
+        int packs;        ///< Number of packs
+        double quantity;  ///< packs times the pack size, in the offer's unit
+        double cost;      ///< Price of the packs, discounts applied
+    };
+
+    /**
+     * @brief Result of optimizePurchases()
+     */
+    struct PurchasePlan {
+        bool feasible = true;                      ///< Every requirement is covered
+        std::vector<PackPurchase> purchases;       ///< Grouped by requirement, offers in the order they were added
+        double totalCost = 0.0;                    ///< Sum of the purchase costs
+        std::map<std::string, double> storeCosts;  ///< Store -> cost of the packs bought there
+        std::vector<std::string> uncovered;        ///< Normalized names of requirements the offers cannot cover
+        std::chrono::microseconds solveTime{0};    ///< Wall-clock time
+    };
+
+    /**
+     * @brief Solutions shared between optimizers, see setCache()
+     */
+    using Cache = utils::ResultCache<Solution>;
+
+    // Constructors
+    /**
+     * @brief Create an optimizer over every ingredient held by Storage
+     */
+    CostOptimizer();
+
+    /**
+     * @brief Create an optimizer over a set of ingredients, without caps
+     * @throws std::invalid_argument if an ingredient is null or cannot be scaled
+     */
+    explicit CostOptimizer(const std::vector<std::shared_ptr<core::Ingredient>>& ingredients);
+
+    /**
+     * @brief Create an optimizer over a set of recipes, without caps
+     * @throws std::invalid_argument if a recipe is null or has no servings
+     */
+    explicit CostOptimizer(const std::vector<std::shared_ptr<core::Recipe>>& recipes);
+
+    // Setters
+    /**
+     * @brief Add an ingredient as a candidate food
+     * @param ingredient The ingredient
+     * @param maxQuantity Most that may be used, in the ingredient's unit
+     * @throws std::invalid_argument if the ingredient is null, maxQuantity is
+     *         negative, or it lists nutrients but has no positive quantity
+     */
+    void addIngredient(const std::shared_ptr<core::Ingredient>& ingredient,
+                       double maxQuantity = std::numeric_limits<double>::infinity());
+
+    /**
+     * @brief Add a recipe as a candidate food
+     * @param recipe The recipe
+     * @param maxServings Most servings that may be used
+     * @throws std::invalid_argument if the recipe is null, maxServings is
+     *         negative, or the recipe has no servings
+     */
+    void addRecipe(const std::shared_ptr<core::Recipe>& recipe,
+                   double maxServings = std::numeric_limits<double>::infinity());
+
+    /**
+     * @brief Add a store's pack offer for optimizePurchases()
+     * @param offer The offer
+     */
+    void addOffer(const core::PackOffer& offer);
+
+    /**
+     * @brief Update prices from the latest ones of a price history
+     *
+     * Prices in the history are per base unit (g, ml or piece), keyed by
+     * ingredient name and store. Each pack offer takes the latest price of
+     * its ingredient at its store, scaled to its pack size, with its volume
+     * discounts scaled alike. Each candidate ingredient takes the cheapest
+     * latest price of its name at any store. Anything without a recorded
+     * price keeps its own.
+     *
+     * @param history The history
+     * @return Number of offers and ingredients repriced
+     */
+    std::size_t applyPriceHistory(const core::PriceHistory& history);
+
+    /**
+     * @brief Reuse solutions computed for identical requests
+     *
+     * minimizeCost() first looks up a fingerprint of the candidate foods (as
+     * added: identity, unit cost, cap and nutrients), targets and options,
+     * and on a hit returns the stored solution without solving;
+     * Solution::solveTime then holds the lookup time. Entries are tagged with
+     * core::Storage::getVersion() and ignored once Storage changes.
+     *
+     * @param cache Cache to use, possibly shared with other optimizers; null disables caching
+     */
+    void setCache(std::shared_ptr<Cache> cache);
+
+    // Getters
+    /**
+     * @brief Get the number of candidate foods
+     */
+    std::size_t getFoodCount() const;
+
+    /**
+     * @brief Get the number of pack offers
+     */
+    std::size_t getOfferCount() const;
+
+    // Operations
+    /**
+     * @brief Find the cheapest mix meeting the targets, with default limits
+     * @throws std::invalid_argument if a target is malformed or repeated
+     */
+    Solution minimizeCost(const std::vector<NutrientTarget>& targets) const;
+
+    /**
+     * @brief Find the cheapest mix meeting the targets
+     * @param targets Nutrient ranges; nutrients a food does not list count as 0
+     * @param options Solver limits
+     * @return The mix; Solution::status tells whether it is optimal
+     * @throws std::invalid_argument if a target is malformed or repeated
+     */
+    Solution minimizeCost(const std::vector<NutrientTarget>& targets, const Options& options) const;
+
+    /**
+     * @brief Buy the cheapest packs covering a list of required quantities
+     *
+     * Requirements naming the same ingredient in units of the same dimension
+     * are added up first, so the ingredients of every meal over a planning
+     * horizon can be passed as they are. An ingredient is covered by the
+     * offers with the same normalized name and unit dimension; leftovers from
+     * rounding up to whole packs are accepted, and the price of a pack is
+     * the one of the tier its total count reaches. Each ingredient is solved
+     * exactly on a grid of 0.01 base units (g, ml or pieces) unless that would
+     * need more than a few million cells, in which case the grid is coarsened
+     * and pack sizes are rounded down, so the result still covers the demand.
+     *
+     * @param required Required quantities, e.g. the ingredients of planned recipes
+     * @return The packs to buy; requirements that no combination of offers can
+     *         cover are listed in PurchasePlan::uncovered and bought nothing for
+     * @throws std::invalid_argument if a requirement is null
+     */
+    PurchasePlan optimizePurchases(const std::vector<std::shared_ptr<core::Ingredient>>& required) const;
+
+private:
+    /// A candidate food, scaled to one unit or serving
+    struct Food {
+        std::shared_ptr<core::Ingredient> ingredient;
+        std::shared_ptr<core::Recipe> recipe;
+        double unitCost;
+        double maxAmount;
+        std::map<std::string, double> nutrients;  ///< Per unit or serving
+    };
+
+    std::vector<Food> foods_;
+    std::vector<core::PackOffer> offers_;
+    std::shared_ptr<Cache> cache_;
+
+    utils::Fingerprint requestKey(const std::vector<NutrientTarget>& targets, const Options& options) const;
+};
+
+} // namespace algorithms
+} // namespace smart_food
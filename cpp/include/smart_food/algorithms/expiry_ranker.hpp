@@ -0,0 +1,139 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "smart_food/algorithms/ingredient_index.hpp"
+#include "smart_food/core/ingredient.hpp"
+#include "smart_food/core/recipe.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+/**
+ * @brief Ranks catalog recipes by how much soon-to-expire stock they use up.
+ *
+ * Stock is at risk when it expires within the horizon, and each ingredient
+ * identity (as defined by IngredientIndex) is weighted by the value of its
+ * stock at risk: base quantity times base price, summed over its lots. A
+ * recipe scores the total weight of the at-risk identities it uses, so
+ * recipes that put several expensive, nearly expired items to use rank first.
+ *
+ * Every stocked identity is given a bit, and every recipe keeps a bitset of
+ * the stocked identities it uses, precomputed when the recipe or the
+ * identity is added. Ranking ANDs each recipe's bitset with the at-risk
+ * mask, sums the weights of the remaining bits and keeps the best recipes
+ * in a bounded heap: a few words per recipe, so the whole catalog is
+ * scanned in milliseconds. Changes update the bitsets incrementally through
+ * an inverted index from identities to recipes.
+ */
+class ExpiryRanker {
+public:
+    /**
+     * @brief A ranked recipe
+     */
+    struct Match {
+        std::shared_ptr<core::Recipe> recipe;
+        double atRiskValue;             ///< Sum of the weights of the at-risk identities it uses
+        std::size_t atRiskIngredients;  ///< Number of those identities
+    };
+
+    // Constructors
+    /**
+     * @brief Create a ranker over the recipes and pantry held by Storage, as of now
+     */
+    ExpiryRanker();
+
+    /**
+     * @brief Create a ranker over an explicit recipe catalog, with an empty pantry
+     * @throws std::invalid_argument if a recipe is null
+     */
+    explicit ExpiryRanker(const std::vector<std::shared_ptr<core::Recipe>>& recipes);
+
+    // Setters
+    /**
+     * @brief Add a recipe, replacing any recipe with the same ID
+     * @throws std::invalid_argument if the recipe is null
+     */
+    void addRecipe(const std::shared_ptr<core::Recipe>& recipe);
+
+    /**
+     * @brief Remove a recipe
+     * @return Whether a recipe with that ID was present
+     */
+    bool removeRecipe(const std::string& recipeId);
+
+    /**
+     * @brief Replace the pantry and recompute the stock at risk
+     * @param pantry Stocked lots; quantity, unit, price and expiry date are used
+     * @param now Reference time; lots already expired are not at risk
+     * @param horizon Lots expiring within this time from now are at risk
+     * @throws std::invalid_argument if a lot is null or the horizon is negative
+     */
+    void setPantry(const std::vector<std::shared_ptr<core::Ingredient>>& pantry,
+                   std::chrono::system_clock::time_point now,
+                   std::chrono::hours horizon = std::chrono::hours(72));
+
+    // Operations
+    /**
+     * @brief Catch up with Storage if it changed since the last refresh
+     *
+     * Recipes are matched by ID: new ones are indexed, missing ones removed,
+     * and ones Storage holds as a different object re-indexed. Recipes edited
+     * in place without going through Storage are not detected; add them
+     * again. The pantry is re-read with the last horizon.
+     *
+     * @param now Reference time for the stock at risk
+     * @return Whether Storage had changed
+     */
+    bool refresh(std::chrono::system_clock::time_point now = std::chrono::system_clock::now());
+
+    /**
+     * @brief Get the recipes using the most value at risk
+     * @param limit Most recipes to return
+     * @return Recipes using at least one at-risk identity, best first; ties
+     *         go to the recipe using more of them, then to the one added first
+     */
+    std::vector<Match> rank(std::size_t limit) const;
+
+    // Getters
+    /**
+     * @brief Get the number of recipes indexed
+     */
+    std::size_t getRecipeCount() const;
+
+    /**
+     * @brief Get the number of identities at risk
+     */
+    std::size_t getAtRiskCount() const;
+
+private:
+    IngredientIndex index_;                                ///< Identities of every recipe ingredient
+    std::vector<std::vector<std::uint32_t>> recipesOf_;     ///< Identity -> rows using it, stale rows included
+    std::vector<std::shared_ptr<core::Recipe>> recipes_;   ///< Row -> recipe, null once removed
+    std::vector<std::vector<std::uint32_t>> identities_;   ///< Row -> sorted identities it uses
+    std::unordered_map<std::string, std::uint32_t> rowOf_;  ///< Recipe ID -> row
+    std::size_t alive_ = 0;
+
+    std::vector<std::uint32_t> bitOf_;    ///< Identity -> bit, npos if not stocked
+    std::vector<std::uint32_t> bitOwner_; ///< Bit -> identity
+    std::size_t words_ = 1;               ///< 64-bit words per recipe bitset
+    std::vector<std::uint64_t> bits_;     ///< Row-major recipe bitsets, words_ per row
+    std::vector<double> weights_;         ///< Bit -> value at risk, 0 if not at risk
+    std::vector<std::uint64_t> atRisk_;   ///< Mask of the at-risk bits
+
+    std::chrono::hours horizon_{72};
+    std::uint64_t version_ = std::numeric_limits<std::uint64_t>::max();  ///< Storage version of the last refresh
+
+    void setBit(std::uint32_t row, std::uint32_t bit);
+    std::uint32_t assignBit(std::uint32_t identity);
+    void rebuildBits(const std::vector<std::uint32_t>& stocked);
+};
+
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "smart_food/algorithms/ingredient_index.hpp"
+#include "smart_food/core/ingredient.hpp"
+#include "smart_food/core/recipe.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+/**
+ * @brief Tracks which catalog recipes the pantry holds enough for right now.
+ *
+ * A recipe is cookable when, for every ingredient it uses, the pantry holds
+ * at least the quantity needed at the configured serving count. Ingredients
+ * are matched by IngredientIndex identity and compared in base units, so
+ * 1 kg of flour in stock covers a recipe asking for 250 g; lots already
+ * expired do not count, and a lot without an expiry date always does.
+ *
+ * The catalog is stored column-wise: every identity keeps the quantities
+ * recipes need of it, sorted, next to the recipe they belong to. Whether a
+ * recipe is short of an identity is then a split of that column at the
+ * stock level, and every recipe keeps the count of identities it is short
+ * of. When the stock of an identity changes, only the entries between the
+ * old and new stock levels change side, so pantry updates touch a handful of
+ * entries instead of re-checking the catalog.
+ */
+class FeasibilityEngine {
+public:
+    /**
+     * @brief Quantity of an ingredient missing to cook a recipe
+     */
+    struct Shortfall {
+        std::string ingredient;       ///< Normalized name
+        core::Ingredient::Unit unit;  ///< GRAM, MILLILITER or PIECE
+        double quantity;              ///< Missing quantity, in unit
+    };
+
+    /**
+     * @brief Feasibility of one recipe
+     */
+    struct Result {
+        std::shared_ptr<core::Recipe> recipe;
+        bool cookable;
+        std::vector<Shortfall> shortfalls;  ///< Empty if cookable, by ingredient name
+    };
+
+    // Constructors
+    /**
+     * @brief Create an engine over the recipes and pantry held by Storage, as of now
+     * @param servings Servings to cook, 0 for the servings each recipe is written for
+     * @throws std::invalid_argument if servings is negative
+     */
+    explicit FeasibilityEngine(int servings = 0);
+
+    /**
+     * @brief Create an engine over an explicit recipe catalog, with an empty pantry
+     * @param recipes Recipes to track
+     * @param servings Servings to cook, 0 for the servings each recipe is written for
+     * @throws std::invalid_argument if a recipe or one of its ingredients is
+     *         null, or servings is negative
+     */
+    explicit FeasibilityEngine(const std::vector<std::shared_ptr<core::Recipe>>& recipes, int servings = 0);
+
+    // Setters
+    /**
+     * @brief Add a recipe, replacing any recipe with the same ID
+     * @throws std::invalid_argument if the recipe or one of its ingredients is null
+     */
+    void addRecipe(const std::shared_ptr<core::Recipe>& recipe);
+
+    /**
+     * @brief Remove a recipe
+     * @return Whether a recipe with that ID was present
+     */
+    bool removeRecipe(const std::string& recipeId);
+
+    /**
+     * @brief Change the serving count every recipe is checked at
+     * @param servings Servings to cook, 0 for the servings each recipe is written for
+     * @throws std::invalid_argument if servings is negative
+     */
+    void setServings(int servings);
+
+    /**
+     * @brief Replace the pantry
+     *
+     * Stock is totalled per identity and only identities whose total
+     * changed are updated.
+     *
+     * @param pantry Stocked lots; quantity, unit and expiry date are used
+     * @param now Reference time; lots expired before it are ignored
+     * @throws std::invalid_argument if a lot is null
+     */
+    void setPantry(const std::vector<std::shared_ptr<core::Ingredient>>& pantry,
+                   std::chrono::system_clock::time_point now);
+
+    /**
+     * @brief Add an amount to the stock of its ingredient
+     * @throws std::invalid_argument if the quantity is negative
+     */
+    void addStock(const core::Ingredient& amount);
+
+    /**
+     * @brief Take an amount from the stock of its ingredient, as cooking does
+     *
+     * Stock does not go below zero.
+     *
+     * @throws std::invalid_argument if the quantity is negative
+     */
+    void removeStock(const core::Ingredient& amount);
+
+    // Operations
+    /**
+     * @brief Catch up with Storage
+     *
+     * Recipes are re-read if Storage changed since the last refresh, as in
+     * ExpiryRanker::refresh(); the pantry is re-read every time, since lots
+     * expire as time passes.
+     *
+     * @param now Reference time for expiry
+     * @return Whether Storage had changed
+     */
+    bool refresh(std::chrono::system_clock::time_point now = std::chrono::system_clock::now());
+
+    /**
+     * @brief Check every recipe
+     * @return One result per recipe, in the order they were added
+     */
+    std::vector<Result> evaluate() const;
+
+    // Getters
+    /**
+     * @brief Get the recipes that can be cooked now, in the order they were added
+     */
+    std::vector<std::shared_ptr<core::Recipe>> getCookable() const;
+
+    /**
+     * @brief Whether a recipe can be cooked now
+     * @throws std::out_of_range if the recipe is unknown
+     */
+    bool isCookable(const std::string& recipeId) const;
+
+    /**
+     * @brief Get what is missing to cook a recipe, by ingredient name
+     * @throws std::out_of_range if the recipe is unknown
+     */
+    std::vector<Shortfall> getShortfalls(const std::string& recipeId) const;
+
+    /**
+     * @brief Get the stock of an ingredient, in the base unit of its dimension
+     */
+    double getStock(const std::string& name, core::Ingredient::Unit unit) const;
+
+    /**
+     * @brief Get the serving count recipes are checked at, 0 for as written
+     */
+    int getServings() const;
+
+    /**
+     * @brief Get the number of recipes tracked
+     */
+    std::size_t getRecipeCount() const;
+
+private:
+    /// Quantity a recipe needs of one identity
+    struct Item {
+        std::uint32_t id;
+        double quantity;  ///< Base quantity as written
+    };
+
+    /// Recipes needing one identity, sorted by need
+    struct Column {
+        std::vector<double> need;         ///< Per serving, or as written if servings_ is 0
+        std::vector<std::uint32_t> rows;
+    };
+
+    IngredientIndex index_;  ///< Identities of every recipe ingredient and lot
+    std::vector<std::shared_ptr<core::Recipe>> recipes_;   ///< Row -> recipe, null once removed
+    std::vector<std::vector<Item>> items_;                ///< Row -> items, sorted by identity
+    std::vector<int> written_;                            ///< Row -> servings the recipe is written for
+    std::vector<std::uint32_t> missing_;                  ///< Row -> identities it is short of
+    std::unordered_map<std::string, std::uint32_t> rowOf_;  ///< Recipe ID -> row
+    std::size_t liveItems_ = 0;                           ///< Column entries of current rows
+    std::size_t deadItems_ = 0;                           ///< Column entries of removed rows
+
+    std::vector<Column> columns_;  ///< Identity -> recipes needing it
+    std::vector<double> stock_;    ///< Identity -> base quantity in stock
+    int servings_ = 0;
+
+    std::uint64_t version_ = std::numeric_limits<std::uint64_t>::max();  ///< Storage version of the last refresh
+
+    void addBatch(const std::vector<std::shared_ptr<core::Recipe>>& recipes);
+    std::vector<Item> itemsOf(const core::Recipe& recipe);
+    void retireRow(std::uint32_t row);
+    void indexRow(std::uint32_t row);
+    void rebuildColumns();
+    void recount();
+    void setStock(std::uint32_t id, double stock);
+    double need(std::uint32_t row, const Item& item) const;
+    double threshold(double stock) const;
+    std::vector<Shortfall> shortfallsOf(std::uint32_t row) const;
+    std::uint32_t rowOf(const std::string& recipeId) const;
+};
+
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "smart_food/core/ingredient.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+/**
+ * @brief Maps ingredients to dense integer identities.
+ *
+ * Every Ingredient instance carries its own random ID, so two recipes that
+ * both use "Olive oil" never share an ID. The algorithms identify an
+ * ingredient by its normalized name (lower case, trimmed, single spaces)
+ * together with the physical dimension of its unit, and work on quantities
+ * converted to the base unit of that dimension (grams, milliliters or pieces).
+ * Mass and volume are kept apart because converting between them would need
+ * a density the catalog does not have.
+ */
+class IngredientIndex {
+public:
+    /**
+     * @brief Physical dimension of a unit of measurement
+     */
+    enum class Dimension {
+        MASS,   ///< Base unit: gram
+        VOLUME, ///< Base unit: milliliter
+        COUNT   ///< Base unit: piece
+    };
+
+    /// Returned by find() when the ingredient is unknown
+    static constexpr std::uint32_t npos = 0xFFFFFFFFu;
+
+    /**
+     * @brief Get the identity of an ingredient, registering it if needed
+     * @param ingredient The ingredient to look up
+     * @return Dense identity in [0, size())
+     * @throws std::invalid_argument if the normalized name is empty
+     */
+    std::uint32_t intern(const core::Ingredient& ingredient);
+
+    /**
+     * @brief Get the identity of a name/dimension pair, registering it if needed
+     * @param name Ingredient name (normalized internally)
+     * @param dimension Dimension of the quantities stored under this identity
+     * @return Dense identity in [0, size())
+     * @throws std::invalid_argument if the normalized name is empty
+     */
+    std::uint32_t intern(const std::string& name, Dimension dimension);
+
+    /**
+     * @brief Look up an ingredient without registering it
+     * @param ingredient The ingredient to look up
+     * @return Its identity, or npos if it was never interned
+     */
+    std::uint32_t find(const core::Ingredient& ingredient) const;
+
+    /**
+     * @brief Look up a name/dimension pair without registering it
+     * @return Its identity, or npos if it was never interned
+     */
+    std::uint32_t find(const std::string& name, Dimension dimension) const;
+
+    /**
+     * @brief Number of distinct identities registered so far
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Normalized name of an identity
+     * @throws std::out_of_range if id is not a registered identity
+     */
+    const std::string& getName(std::uint32_t id) const;
+
+    /**
+     * @brief Dimension of an identity
+     * @throws std::out_of_range if id is not a registered identity
+     */
+    Dimension getDimension(std::uint32_t id) const;
+
+    /**
+     * @brief Normalize an ingredient name for identity comparisons
+     * @param name Raw name as entered by the user
+     * @return Lower-cased name with surrounding whitespace trimmed and
+     *         inner whitespace runs collapsed to a single space
+     */
+    static std::string normalizeName(const std::string& name);
+
+    /**
+     * @brief Dimension measured by a unit
+     */
+    static Dimension dimensionOf(core::Ingredient::Unit unit);
+
+    /**
+     * @brief Convert a quantity to the base unit of its dimension
+     * @param value Quantity expressed in unit
+     * @param unit Unit the quantity is expressed in
+     * @return Quantity in grams, milliliters or pieces
+     */
+    static double toBaseQuantity(double value, core::Ingredient::Unit unit);
+
+    /**
+     * @brief Quantity of an ingredient in the base unit of its dimension
+     */
+    static double baseQuantity(const core::Ingredient& ingredient);
+
+    /**
+     * @brief Price of one base unit (gram, milliliter or piece) of an ingredient
+     */
+    static double basePrice(const core::Ingredient& ingredient);
+
+private:
+    std::unordered_map<std::string, std::uint32_t> ids_;  ///< Key -> identity
+    std::vector<std::string> names_;                     ///< Identity -> normalized name
+    std::vector<Dimension> dimensions_;                  ///< Identity -> dimension
+
+    static std::string makeKey(const std::string& normalizedName, Dimension dimension);
+};
+
+} // namespace algorithms
+} // namespace smart_food
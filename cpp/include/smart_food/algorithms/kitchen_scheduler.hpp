@@ -0,0 +1,136 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "smart_food/algorithms/anytime.hpp"
+#include "smart_food/core/recipe.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+/**
+ * @brief Builds a shortest timeline for cooking a batch of recipes in one kitchen.
+ *
+ * Each recipe step becomes a task that may start once the steps it depends
+ * on (Recipe::getStepDependencies()) are done, and that holds the resources
+ * listed in Recipe::Step::resources for its whole duration. The kitchen has
+ * a fixed number of units of every resource, e.g. two ovens, six burners
+ * and three cooks' hands; the scheduler finds start times that never use
+ * more than that while minimizing the time until the last step is done.
+ *
+ * Timelines are built by serial list scheduling: tasks are placed one at a
+ * time, highest priority first among those whose dependencies are placed,
+ * at the earliest minute where their resources are free. The first pass
+ * prioritizes the longest chain of work still ahead; further passes perturb
+ * that priority at random, and every timeline is tightened by
+ * forward-backward improvement (scheduling right-justified from the end,
+ * then left-justified again in the order obtained). Batches of a few steps
+ * are then solved exactly by depth-first branch-and-bound over placement
+ * orders, each task starting no earlier than the one placed before it,
+ * pruned by dependency chains and resource workloads.
+ */
+class KitchenScheduler {
+public:
+    /**
+     * @brief Search limits
+     */
+    struct Options {
+        std::size_t exactSteps = 16;     ///< Batches with at most this many steps are solved exactly
+        std::size_t maxNodes = 2000000;  ///< Exact search nodes before settling for the best timeline found
+        std::size_t samples = 100;       ///< Randomized list-scheduling passes
+        std::uint64_t seed = 0;          ///< Random seed of the randomized passes
+        std::map<std::string, int> defaultResources{{"hands", 1}};  ///< Held by steps listing no resources, if the kitchen has them
+    };
+
+    /**
+     * @brief When one step of the batch runs
+     */
+    struct ScheduledStep {
+        std::size_t recipe;          ///< Position of the recipe in the batch
+        std::size_t step;            ///< Position of the step in Recipe::getSteps()
+        std::chrono::minutes start;  ///< Minutes after the batch starts
+        std::chrono::minutes end;    ///< start plus the step's duration
+    };
+
+    /**
+     * @brief A timeline for a batch
+     */
+    struct Timeline {
+        std::vector<ScheduledStep> steps;           ///< By start, then batch position, then step position
+        std::vector<std::chrono::minutes> finish;   ///< Batch position -> end of its last step
+        std::chrono::minutes makespan{0};           ///< End of the last step
+        std::chrono::minutes lowerBound{0};         ///< No timeline for the batch is shorter
+        bool optimal = false;                       ///< makespan is proven minimal
+    };
+
+    /**
+     * @brief Deadline, cancellation and progress reporting of one schedule() call
+     */
+    using Control = SolveControl<Timeline>;
+
+    // Constructors
+    /**
+     * @brief Create a scheduler for a kitchen
+     * @param capacities Resource name -> units available
+     * @throws std::invalid_argument if a capacity is negative
+     */
+    explicit KitchenScheduler(std::map<std::string, int> capacities);
+
+    // Getters
+    /**
+     * @brief Get the units of every resource of the kitchen
+     */
+    const std::map<std::string, int>& getCapacities() const;
+
+    // Operations
+    /**
+     * @brief Schedule a batch with the default limits
+     * @param batch Recipes to cook; a recipe may appear more than once
+     * @return Shortest timeline found
+     * @throws std::invalid_argument if a recipe is null or a step needs
+     *         more units of a resource than the kitchen has
+     */
+    Timeline schedule(const std::vector<std::shared_ptr<core::Recipe>>& batch) const;
+
+    /**
+     * @brief Schedule a batch
+     * @param batch Recipes to cook; a recipe may appear more than once
+     * @param options Search limits
+     * @return Shortest timeline found
+     * @throws std::invalid_argument if a recipe is null or a step needs
+     *         more units of a resource than the kitchen has
+     */
+    Timeline schedule(const std::vector<std::shared_ptr<core::Recipe>>& batch, const Options& options) const;
+
+    /**
+     * @brief Schedule a batch within a deadline
+     *
+     * The randomized passes and the exact search stop once control.deadline
+     * passes or control.cancellation is cancelled, checked between passes
+     * and every 1024 search nodes, and the shortest timeline found
+     * by then is returned; the first pass always completes. Every shorter
+     * timeline is published on control.channel, if set, at its makespan in
+     * minutes, with the pass and node count and the lower bound; the
+     * channel is marked finished before this returns.
+     *
+     * @param batch Recipes to cook; a recipe may appear more than once
+     * @param options Search limits
+     * @param control Deadline, cancellation token and progress channel
+     * @return Shortest timeline found; optimal is false if the search was cut short
+     * @throws std::invalid_argument if a recipe is null or a step needs
+     *         more units of a resource than the kitchen has
+     */
+    Timeline schedule(const std::vector<std::shared_ptr<core::Recipe>>& batch, const Options& options,
+                      const Control& control) const;
+
+private:
+    std::map<std::string, int> capacities_;
+};
+
+} // namespace algorithms
+} // namespace smart_food
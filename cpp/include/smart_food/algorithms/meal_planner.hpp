@@ -0,0 +1,429 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "smart_food/algorithms/anytime.hpp"
+#include "smart_food/core/ingredient.hpp"
+#include "smart_food/core/meal.hpp"
+#include "smart_food/core/recipe.hpp"
+#include "smart_food/utils/result_cache.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+namespace detail {
+class Replanner;
+class RecipeKeys;
+}
+
+/**
+ * @brief Assigns catalog recipes to the meal slots of a planning horizon.
+ *
+ * A plan covers a number of days, each made of the same sequence of slots
+ * (breakfast, lunch, dinner, snack by default). The planner picks one recipe
+ * per slot so that the total purchase cost is minimal while every day stays
+ * within its nutrient targets, no recipe is used more often than the variety
+ * rules allow, and pantry stock is used before anything is bought.
+ *
+ * The default strategy is an exact depth-first branch-and-bound. Candidates are tried
+ * cheapest first, partial plans are pruned with admissible lower bounds (the
+ * cheapest distinct recipes for the remaining slots, and the best nutritionally
+ * feasible day ignoring variety), and daily nutrient ranges are propagated so
+ * that a recipe is only tried when the rest of its day can still meet them.
+ * For horizons too long to solve exactly, Strategy::LOCAL_SEARCH trades the
+ * optimality proof for a parallel metaheuristic. planFront() instead returns
+ * the trade-offs between cost, nutrition, prep time and projected waste.
+ *
+ * The planner keeps the state of its last plan so that interactive edits
+ * (locking a slot, swapping a recipe, changing servings or the pantry) only
+ * re-solve the days they affect instead of planning from scratch.
+ *
+ * Planners may share a Cache of results keyed by a fingerprint of the
+ * catalog, constraints and options; see setCache().
+ */
+class MealPlanner {
+public:
+    /**
+     * @brief Daily range for one nutrient, per person
+     *
+     * Values are compared against Recipe::getNutritionalInfo(), which holds
+     * nutrients per serving. Recipes that do not list the nutrient count as 0.
+     */
+    struct NutrientTarget {
+        std::string nutrient;  ///< Nutrient name, e.g. "calories"
+        double minPerDay;      ///< Lower bound of the daily sum
+        double maxPerDay;      ///< Upper bound of the daily sum
+    };
+
+    /**
+     * @brief What a valid plan must look like
+     */
+    struct Constraints {
+        int days = 7;                                ///< Planning horizon in days
+        std::vector<core::Meal::Type> slotsPerDay{   ///< Slots filled on every day, in order
+            core::Meal::Type::BREAKFAST,
+            core::Meal::Type::LUNCH,
+            core::Meal::Type::DINNER,
+            core::Meal::Type::SNACK};
+        int servings = 1;                            ///< Servings cooked for each slot
+        std::vector<NutrientTarget> nutrients;       ///< Daily nutrient ranges
+        int maxRepeats = 1;                          ///< Uses of one recipe over the horizon
+        int minDaysBetweenRepeats = 1;               ///< Minimum day distance between two uses
+        std::vector<std::shared_ptr<core::Ingredient>> pantry;  ///< Stock consumed before buying, unless expired by start
+        std::chrono::system_clock::time_point start{};          ///< First day of the plan, epoch for now
+    };
+
+    /**
+     * @brief Search algorithm used by plan()
+     */
+    enum class Strategy {
+        BRANCH_AND_BOUND,  ///< Exact search, proves optimality within Options::relativeGap
+        LOCAL_SEARCH       ///< Parallel simulated annealing with day-level ruin and recreate
+    };
+
+    /**
+     * @brief Search strategy and limits
+     *
+     * For branch-and-bound, branches that cannot improve the incumbent by more
+     * than relativeGap are pruned, so a completed search proves the plan
+     * optimal within that gap. When a limit is hit the best plan found so far
+     * is returned with Plan::optimal set to false.
+     *
+     * Local search runs several annealing chains per thread that exchange
+     * their best plans between epochs. For a given seed and thread count the
+     * result is deterministic unless timeLimit or a SolveControl cuts the run
+     * short.
+     */
+    struct Options {
+        Strategy strategy = Strategy::BRANCH_AND_BOUND;  ///< Search algorithm
+        double relativeGap = 1e-3;               ///< Accepted distance to the optimum, 0 for exact
+        std::size_t maxNodes = 5000000;          ///< Branch-and-bound nodes to expand
+        std::chrono::milliseconds timeLimit{0};  ///< Wall-clock limit, 0 for none
+        std::size_t threads = 0;                 ///< Local search threads, 0 for the shared pool
+        std::uint64_t seed = 0;                  ///< Local search random seed
+        std::size_t maxEvaluations = 2000000;    ///< Local search plan evaluations over all threads
+    };
+
+    /**
+     * @brief One filled slot of a plan
+     */
+    struct Assignment {
+        int day;                               ///< Day index in [0, days)
+        core::Meal::Type type;                 ///< Slot type
+        std::shared_ptr<core::Recipe> recipe;  ///< Recipe cooked in the slot
+        double cost;                           ///< Purchase cost after pantry stock
+    };
+
+    /**
+     * @brief Result of a planning run
+     */
+    struct Plan {
+        std::vector<Assignment> assignments;  ///< Day-major, slots in Constraints order
+        double totalCost = 0.0;               ///< Sum of the assignment costs
+        double lowerBound = 0.0;              ///< Proven lower bound on the optimal cost
+        bool feasible = false;                ///< A plan satisfying all constraints was found
+        bool optimal = false;                 ///< The search completed, so the plan is optimal within the gap
+        std::size_t nodesExplored = 0;        ///< Search nodes expanded, or plans evaluated by local search
+        std::chrono::microseconds solveTime{0};  ///< Wall-clock time of the run
+    };
+
+    /**
+     * @brief How a plan scores on each objective of planFront(), all minimized
+     */
+    struct Objectives {
+        double cost = 0.0;            ///< Plan::totalCost
+        double nutritionError = 0.0;  ///< Mean distance of daily sums from the middle of their ranges, in half-widths
+        std::chrono::minutes prepTime{0};  ///< Sum of Recipe::getTotalTime() over the slots
+        double waste = 0.0;           ///< Value of pantry stock expiring within the horizon left unused
+    };
+
+    /**
+     * @brief Search limits of planFront()
+     *
+     * The front is searched by a genetic algorithm whose population starts
+     * from the cheapest and the quickest plans found by local search with
+     * anchorEvaluations evaluations each, plus greedy plans favoring each
+     * objective. For a given seed and thread count the result is
+     * deterministic unless timeLimit or a FrontControl cuts the run short.
+     */
+    struct FrontOptions {
+        std::size_t points = 20;                 ///< Most plans returned
+        std::size_t population = 96;             ///< Plans kept per generation
+        std::size_t generations = 150;           ///< Generations to breed
+        std::size_t anchorEvaluations = 100000;  ///< Local search budget of each anchor plan, 0 for none
+        std::chrono::milliseconds timeLimit{0};  ///< Wall-clock limit, 0 for none
+        std::size_t threads = 0;                 ///< Evaluation threads, 0 for one per core
+        std::uint64_t seed = 0;                  ///< Random seed
+        std::chrono::system_clock::time_point start{};  ///< First day of the horizon for waste, epoch for Constraints::start
+    };
+
+    /**
+     * @brief A plan on the trade-off front and its objective values
+     */
+    struct FrontPlan {
+        Plan plan;
+        Objectives objectives;
+    };
+
+    /**
+     * @brief Deadline, cancellation and progress reporting of one plan() call
+     */
+    using Control = SolveControl<Plan>;
+
+    /**
+     * @brief Deadline, cancellation and progress reporting of one planFront() call
+     *
+     * Fronts cannot be ranked by one cost, so each front published on the
+     * channel is offered with a cost lower than the one before it (minus its
+     * sequence number): best() is always the latest front.
+     */
+    using FrontControl = SolveControl<std::vector<FrontPlan>>;
+
+    /**
+     * @brief A solved plan with the state needed to edit it
+     */
+    struct CachedPlan;
+
+    /**
+     * @brief Results shared between planners, see setCache()
+     */
+    using Cache = utils::ResultCache<CachedPlan>;
+
+    // Constructors
+    /**
+     * @brief Create a planner over every recipe held by Storage
+     */
+    MealPlanner();
+
+    /**
+     * @brief Create a planner over an explicit recipe catalog
+     * @param recipes Candidate recipes
+     * @throws std::invalid_argument if a recipe is null
+     */
+    explicit MealPlanner(std::vector<std::shared_ptr<core::Recipe>> recipes);
+
+    // Getters
+    /**
+     * @brief Get the candidate recipes
+     */
+    const std::vector<std::shared_ptr<core::Recipe>>& getRecipes() const;
+
+    /**
+     * @brief Get the slot types a recipe may fill
+     * @param recipeId ID of the recipe
+     * @return The configured types, or every type if none were set
+     */
+    std::vector<core::Meal::Type> getAllowedTypes(const std::string& recipeId) const;
+
+    // Setters
+    /**
+     * @brief Restrict the slot types a recipe may fill
+     * @param recipeId ID of the recipe
+     * @param types Allowed slot types
+     * @throws std::invalid_argument if types is empty
+     */
+    void setAllowedTypes(const std::string& recipeId, const std::vector<core::Meal::Type>& types);
+
+    /**
+     * @brief Reuse plans computed for identical requests
+     *
+     * plan() first looks up a fingerprint of the recipes' contents (servings,
+     * nutrients, ingredients with their prices and expiry dates, components),
+     * allowed types, constraints (pantry contents included) and options, and
+     * on a hit returns the stored plan without searching; Plan::solveTime
+     * then holds the lookup time. Entries are also tagged with
+     * core::Storage::getVersion() and ignored once Storage changes.
+     *
+     * The planner keeps each recipe's fingerprint until the recipe's
+     * revision changes (see core::Recipe::getRevision()), so a recipe edited
+     * through its own methods misses while an unchanged catalog costs a
+     * comparison per recipe. Ingredients of recipes edited in place are
+     * noticed after a Storage change or a call to invalidateIngredients().
+     *
+     * Only results that do not depend on timing are stored: completed
+     * searches, and runs that ended on their node or evaluation budget rather
+     * than on a deadline or cancellation.
+     *
+     * @param cache Cache to use, possibly shared with other planners; null disables caching
+     */
+    void setCache(std::shared_ptr<Cache> cache);
+
+    /**
+     * @brief Take ingredients of the recipes edited in place into account
+     *
+     * The next plan() hashes every recipe again; see setCache().
+     */
+    void invalidateIngredients();
+
+    // Operations
+    /**
+     * @brief Compute a minimum-cost plan with the default search limits
+     * @param constraints Horizon, slots, nutrition, variety and pantry rules
+     * @return The best plan found; Plan::feasible is false if none exists
+     * @throws std::invalid_argument if the constraints are malformed
+     */
+    Plan plan(const Constraints& constraints);
+
+    /**
+     * @brief Compute a minimum-cost plan
+     *
+     * A feasible result becomes the starting point of the replanning
+     * operations below, with no slot locked.
+     *
+     * @param constraints Horizon, slots, nutrition, variety and pantry rules
+     * @param options Search strategy and limits
+     * @return The best plan found; Plan::feasible is false if none exists
+     * @throws std::invalid_argument if the constraints are malformed
+     */
+    Plan plan(const Constraints& constraints, const Options& options);
+
+    /**
+     * @brief Compute a minimum-cost plan within a deadline
+     *
+     * The search stops at the earlier of control.deadline and
+     * Options::timeLimit, or soon after control.cancellation is cancelled,
+     * and returns the best plan found by then. Both strategies build a
+     * feasible starting plan before they search, so an answer is normally
+     * available well before the deadline; if none was found in time,
+     * Plan::feasible is false.
+     *
+     * While the search runs, every improving plan and the node or
+     * evaluation count are published on control.channel, if set, so other
+     * threads can watch the bound gap and take the best plan so far without
+     * waiting. The channel is marked finished before this returns.
+     *
+     * @param constraints Horizon, slots, nutrition, variety and pantry rules
+     * @param options Search strategy and limits
+     * @param control Deadline, cancellation token and progress channel
+     * @return The best plan found; Plan::feasible is false if none was found
+     * @throws std::invalid_argument if the constraints are malformed
+     */
+    Plan plan(const Constraints& constraints, const Options& options, const Control& control);
+
+    /**
+     * @brief Compute trade-offs between cost, nutrition, prep time and waste with the default limits
+     * @param constraints Horizon, slots, nutrition, variety and pantry rules
+     * @return Feasible plans no other plan found beats on every objective, by increasing cost
+     * @throws std::invalid_argument if the constraints are malformed
+     */
+    std::vector<FrontPlan> planFront(const Constraints& constraints);
+
+    /**
+     * @brief Compute trade-offs between cost, nutrition, prep time and waste
+     *
+     * Returns up to FrontOptions::points feasible plans of which none is at
+     * least as good as another on every objective, spread along the front
+     * (with the best plan found for each objective when points is at least
+     * 8), so a caller can move between them without solving again. Projected waste
+     * counts pantry items with an expiry date before the end of the horizon,
+     * consumed first among the stock of their kind and in slot order, and
+     * is priced at their unit price.
+     *
+     * The result does not depend on, nor replace, the plan being edited.
+     *
+     * @param constraints Horizon, slots, nutrition, variety and pantry rules
+     * @param options Search limits
+     * @return Front plans by increasing cost; empty if no feasible plan was found
+     * @throws std::invalid_argument if the constraints are malformed, or
+     *         points or population is 0
+     */
+    std::vector<FrontPlan> planFront(const Constraints& constraints, const FrontOptions& options);
+
+    /**
+     * @brief Compute trade-offs between cost, nutrition, prep time and waste within a deadline
+     *
+     * The search stops at the earlier of control.deadline and
+     * FrontOptions::timeLimit, or soon after control.cancellation is
+     * cancelled, checking both once per generation, and returns the front
+     * found by then. Each generation that changes the front publishes it on
+     * control.channel, if set, along with the evaluation count; the channel
+     * is marked finished before this returns.
+     *
+     * @param constraints Horizon, slots, nutrition, variety and pantry rules
+     * @param options Search limits
+     * @param control Deadline, cancellation token and progress channel
+     * @return Front plans by increasing cost; empty if no feasible plan was found
+     * @throws std::invalid_argument if the constraints are malformed, or
+     *         points or population is 0
+     */
+    std::vector<FrontPlan> planFront(const Constraints& constraints, const FrontOptions& options,
+                                     const FrontControl& control);
+
+    // Incremental replanning
+    /**
+     * @brief Pin a recipe to a slot
+     *
+     * The slot's day, and any day whose variety rules the recipe now breaks,
+     * are re-solved with the rest of the plan held fixed. If that cannot meet
+     * every constraint, Plan::feasible is false and the assignments show the
+     * closest plan found. The same applies to the other edits.
+     *
+     * @param day Day index in [0, days)
+     * @param position Index into Constraints::slotsPerDay
+     * @param recipeId Recipe to cook in the slot
+     * @return The updated plan
+     * @throws std::logic_error if there is no feasible plan to edit
+     * @throws std::invalid_argument if the slot or recipe is unknown or the
+     *         recipe is not allowed in the slot's meal type
+     */
+    Plan lockSlot(int day, std::size_t position, const std::string& recipeId);
+
+    /**
+     * @brief Release a slot pinned by lockSlot() so later edits may change it
+     * @throws std::logic_error if there is no feasible plan to edit
+     * @throws std::invalid_argument if the slot is unknown
+     */
+    void unlockSlot(int day, std::size_t position);
+
+    /**
+     * @brief Replace the recipe of a slot with the best other choice
+     *
+     * The replaced recipe stays excluded from that slot in later edits.
+     *
+     * @return The updated plan
+     * @throws std::logic_error if there is no feasible plan to edit
+     * @throws std::invalid_argument if the slot is unknown
+     */
+    Plan swapRecipe(int day, std::size_t position);
+
+    /**
+     * @brief Change the number of servings cooked for every slot
+     * @return The updated plan
+     * @throws std::logic_error if there is no feasible plan to edit
+     * @throws std::invalid_argument if servings is not positive
+     */
+    Plan changeServings(int servings);
+
+    /**
+     * @brief Replace the pantry stock the plan draws from
+     * @return The updated plan
+     * @throws std::logic_error if there is no feasible plan to edit
+     */
+    Plan updatePantry(const std::vector<std::shared_ptr<core::Ingredient>>& pantry);
+
+private:
+    std::vector<std::shared_ptr<core::Recipe>> recipes_;      ///< Candidate recipes
+    std::unordered_map<std::string, std::uint8_t> allowedTypes_;  ///< Recipe ID -> slot type mask
+    std::shared_ptr<Cache> cache_;
+    std::shared_ptr<const CachedPlan> solved_;    ///< Latest plan, if feasible
+    std::shared_ptr<detail::Replanner> session_;  ///< Edit state of the latest plan, created on first edit
+    std::shared_ptr<detail::RecipeKeys> recipeKeys_;  ///< Fingerprints of recipes_, created on first cached plan()
+    std::uint64_t recipeKeysVersion_ = 0;         ///< Storage version recipeKeys_ were taken at
+    utils::Fingerprint allowedTypesKey_;          ///< Fingerprint of allowedTypes_ over recipes_
+    bool allowedTypesKeyValid_ = false;
+
+    /**
+     * @brief Fingerprint a request
+     * @param version Storage version the request is tagged with
+     */
+    utils::Fingerprint requestKey(const Constraints& constraints, const Options& options, std::uint64_t version);
+    detail::Replanner& session();
+};
+
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include "smart_food/core/recipe.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+/**
+ * @brief Finds recipes whose nutrients per serving are closest to a target.
+ *
+ * Every recipe is a point whose coordinates are its nutrients per serving
+ * (Recipe::getNutritionalInfo(); a nutrient it does not list counts as 0),
+ * each divided by that nutrient's standard deviation over the catalog so
+ * that calories and grams of protein weigh alike. A query asks for values
+ * of some nutrients, each with a weight, and optionally bounds nutrients,
+ * cost per serving and total time; recipes are ranked by their weighted
+ * Euclidean distance to the targets among those passing the bounds.
+ *
+ * Points are stored column-wise in the leaf order of a KD-tree that keeps
+ * the bounding box, least cost and least time of every subtree. Queries
+ * walk the tree nearest subtree first and skip subtrees that cannot beat
+ * the k-th match found so far or cannot pass the bounds; leaves are
+ * scanned with a branch-free loop over their columns that the compiler
+ * vectorizes. Small catalogs are a single leaf, scanned in full.
+ */
+class NutrientIndex {
+public:
+    /**
+     * @brief Desired amount of a nutrient per serving
+     */
+    struct Target {
+        std::string nutrient;
+        double value;
+        double weight = 1.0;  ///< Relative importance, >= 0
+    };
+
+    /**
+     * @brief Bounds on a nutrient per serving
+     */
+    struct Range {
+        std::string nutrient;
+        double min = -std::numeric_limits<double>::infinity();
+        double max = std::numeric_limits<double>::infinity();
+    };
+
+    /**
+     * @brief A nearest-neighbor query
+     */
+    struct Query {
+        std::vector<Target> targets;  ///< Nutrients to match; others do not count
+        std::vector<Range> ranges;    ///< Nutrient bounds a match must satisfy
+        double maxCostPerServing = std::numeric_limits<double>::infinity();
+        std::chrono::minutes maxTotalTime = std::chrono::minutes::max();
+        std::size_t limit = 10;       ///< Most matches to return
+    };
+
+    /**
+     * @brief A recipe close to the targets
+     */
+    struct Match {
+        std::shared_ptr<core::Recipe> recipe;
+        double distance;  ///< Weighted distance to the targets, in standard deviations
+    };
+
+    // Constructors
+    /**
+     * @brief Index the recipes held by Storage over every nutrient they list
+     */
+    NutrientIndex();
+
+    /**
+     * @brief Index recipes over every nutrient they list
+     * @throws std::invalid_argument if a recipe is null or has no servings
+     */
+    explicit NutrientIndex(const std::vector<std::shared_ptr<core::Recipe>>& recipes);
+
+    /**
+     * @brief Index recipes over the given nutrients
+     * @throws std::invalid_argument if a recipe is null or has no servings,
+     *         or a nutrient is listed twice
+     */
+    NutrientIndex(const std::vector<std::shared_ptr<core::Recipe>>& recipes, const std::vector<std::string>& nutrients);
+
+    // Operations
+    /**
+     * @brief Find the recipes closest to the targets within the bounds
+     * @return Matches by increasing distance, ties in catalog order
+     * @throws std::invalid_argument if a target or range names a nutrient
+     *         that is not indexed, or a weight is negative or not finite
+     */
+    std::vector<Match> search(const Query& query) const;
+
+    // Getters
+    /**
+     * @brief Get the indexed nutrients, in coordinate order
+     */
+    const std::vector<std::string>& getNutrients() const;
+
+    /**
+     * @brief Get the number of recipes indexed
+     */
+    std::size_t getRecipeCount() const;
+
+private:
+    /// Subtree over points [begin, end)
+    struct Node {
+        std::uint32_t begin;
+        std::uint32_t end;
+        std::uint32_t left;   ///< First child, 0 for a leaf (the root is never a child)
+        std::uint32_t right;
+        double minCost;       ///< Least cost per serving of its points
+        float minTime;        ///< Least total time of its points, in minutes
+    };
+
+    std::vector<std::string> nutrients_;
+    std::vector<double> scales_;  ///< Nutrient -> divisor of its coordinates
+
+    std::vector<std::shared_ptr<core::Recipe>> byCatalog_;  ///< Recipes in catalog order
+    std::vector<std::uint32_t> catalogOrder_;               ///< Point -> position in the catalog
+    std::vector<std::vector<float>> coordinates_;          ///< Nutrient -> point -> scaled value
+    std::vector<double> costs_;                             ///< Point -> cost per serving
+    std::vector<float> times_;                              ///< Point -> total time in minutes
+
+    std::vector<Node> nodes_;   ///< Root first
+    std::vector<float> boxes_;  ///< Node -> lower corner then upper corner, one value per nutrient
+
+    void build(const std::vector<std::shared_ptr<core::Recipe>>& recipes);
+    std::uint32_t buildNode(std::vector<std::uint32_t>& points, std::uint32_t begin, std::uint32_t end,
+                            const std::vector<std::vector<float>>& coordinates, const std::vector<double>& costs,
+                            const std::vector<float>& times);
+    std::size_t nutrientOf(const std::string& nutrient) const;
+};
+
+} // namespace algorithms
+} // namespace smart_food
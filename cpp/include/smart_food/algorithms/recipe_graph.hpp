@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "smart_food/algorithms/ingredient_index.hpp"
+#include "smart_food/core/recipe.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+/**
+ * @brief Memoized cost and nutrition of a catalog of recipes built from sub-recipes.
+ *
+ * Recipes are nodes and Recipe::getComponents() are edges of a directed
+ * acyclic graph, keyed by recipe ID. The totals of a recipe are computed
+ * bottom-up from its ingredients and the memoized totals of its components,
+ * so a sauce used by a thousand recipes is evaluated once.
+ *
+ * Results stay cached until told otherwise: after editing a recipe call
+ * updateRecipe(), and after changing the price or nutrition of ingredients
+ * call invalidateIngredient(). Either marks the affected recipes and every
+ * recipe using them, directly or through other components, as stale; they
+ * are recomputed by the next evaluate() that needs them, and nothing else
+ * is.
+ *
+ * Not thread-safe: evaluate() fills the cache.
+ */
+class RecipeGraph {
+public:
+    /**
+     * @brief Cost and nutrition of all servings of a recipe
+     */
+    struct Totals {
+        double cost = 0.0;                         ///< As Recipe::calculateTotalCost()
+        std::map<std::string, double> nutrition;   ///< Nutrient -> amount, as Recipe::getNutritionalInfo() with fresh components
+    };
+
+    /**
+     * @brief Work counters since construction
+     */
+    struct Stats {
+        std::uint64_t evaluations = 0;    ///< Recipes whose totals were computed
+        std::uint64_t invalidations = 0;  ///< Times a cached recipe was marked stale
+    };
+
+    // Constructors
+    /**
+     * @brief Create an empty graph
+     */
+    RecipeGraph() = default;
+
+    /**
+     * @brief Create a graph of a catalog
+     * @param recipes Recipes to add with addRecipe(), in order
+     * @throws std::invalid_argument as addRecipe()
+     */
+    explicit RecipeGraph(const std::vector<std::shared_ptr<core::Recipe>>& recipes);
+
+    // Getters
+    /**
+     * @brief Get the number of recipes in the graph, components included
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Check whether a recipe is in the graph
+     * @param recipeId Recipe ID
+     */
+    bool contains(const std::string& recipeId) const;
+
+    /**
+     * @brief Get the recipes using a recipe, directly or through other components
+     * @param recipeId Recipe ID
+     * @return IDs of every recipe whose totals depend on it, in no particular order
+     * @throws std::out_of_range if the recipe is not in the graph
+     */
+    std::vector<std::string> getUsers(const std::string& recipeId) const;
+
+    /**
+     * @brief Get every recipe ordered so that components come before their users
+     */
+    std::vector<std::string> getTopologicalOrder() const;
+
+    /**
+     * @brief Get the work counters
+     */
+    Stats getStats() const;
+
+    // Operations
+    /**
+     * @brief Add a recipe and the components not yet in the graph
+     *
+     * A recipe whose ID is already in the graph replaces the old one, as
+     * updateRecipe() would. Components are matched by ID, so a component
+     * already in the graph keeps its node.
+     *
+     * @param recipe Recipe to add
+     * @throws std::invalid_argument if recipe is null or its components,
+     *         matched by ID, would make a recipe use itself; the graph is
+     *         then left unchanged
+     */
+    void addRecipe(const std::shared_ptr<core::Recipe>& recipe);
+
+    /**
+     * @brief Take an edit of a recipe into account
+     *
+     * Re-reads its ingredients and components, adding new components to
+     * the graph, and marks it and its users stale.
+     *
+     * @param recipeId ID of the edited recipe
+     * @throws std::out_of_range if the recipe is not in the graph
+     * @throws std::invalid_argument as addRecipe()
+     */
+    void updateRecipe(const std::string& recipeId);
+
+    /**
+     * @brief Take a change of an ingredient's price or nutrition into account
+     *
+     * Ingredients are matched by normalized name, as IngredientIndex does.
+     *
+     * @param name Name of the changed ingredient
+     * @return Number of recipes newly marked stale
+     */
+    std::size_t invalidateIngredient(const std::string& name);
+
+    /**
+     * @brief Get the totals of a recipe, computing stale ones
+     * @param recipeId Recipe ID
+     * @return Totals, valid until the next change to the graph
+     * @throws std::out_of_range if the recipe is not in the graph
+     */
+    const Totals& evaluate(const std::string& recipeId);
+
+private:
+    struct Edge {
+        std::size_t node;
+        double servings;
+    };
+
+    struct Node {
+        std::shared_ptr<core::Recipe> recipe;
+        std::vector<Edge> components;
+        std::vector<std::size_t> users;         ///< Nodes with an edge to this one
+        std::vector<std::uint32_t> ingredients; ///< IngredientIndex identities used directly
+        Totals totals;
+        bool stale = true;
+    };
+
+    std::vector<Node> nodes_;
+    std::unordered_map<std::string, std::size_t> byId_;
+    IngredientIndex ingredients_;
+    std::vector<std::vector<std::size_t>> ingredientUsers_;  ///< Identity -> nodes using it directly
+    Stats stats_;
+
+    /**
+     * @brief Mark nodes and all their users stale
+     * @return Number of nodes newly marked
+     */
+    std::size_t invalidate(std::vector<std::size_t> nodes);
+
+    /**
+     * @brief Link recipes to their components, adding the missing ones
+     */
+    void link(const std::vector<std::shared_ptr<core::Recipe>>& recipes);
+};
+
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "smart_food/algorithms/anytime.hpp"
+#include "smart_food/algorithms/cost_optimizer.hpp"
+#include "smart_food/core/ingredient.hpp"
+#include "smart_food/core/meal.hpp"
+#include "smart_food/core/pack_offer.hpp"
+#include "smart_food/core/price_history.hpp"
+#include "smart_food/utils/result_cache.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+/**
+ * @brief Turns planned meals into a shopping list.
+ *
+ * Every ingredient of every meal still to be cooked (status PLANNED or
+ * SHOPPING) is converted to the base unit of its dimension and summed per
+ * identity, as defined by IngredientIndex: normalized name plus mass, volume
+ * or count. The totals are then netted against the pantry inventory.
+ *
+ * Netting honors expiry dates. A pantry lot can only serve meals planned
+ * before it expires, and lots already expired at the reference time are
+ * ignored. Each ingredient's meals are served in planned-time order from the
+ * lot that expires first, which uses as much of the stock as any assignment
+ * could.
+ *
+ * Meals are split into chunks aggregated in parallel into chunk-local hash
+ * tables, with unit conversion done per chunk in one batch; the chunk
+ * results are merged in order, so the list does not depend on the thread
+ * count.
+ *
+ * planTrip() then splits the list across stores. Given each store's pack
+ * offers and a distance matrix between home and the stores, it picks the
+ * stores to visit and their order so that the price of the packs plus the
+ * travel cost is lowest: a set cover coupled with a traveling salesman
+ * tour. Up to a dozen useful stores are solved exactly; beyond that an
+ * iterated local search over the store set, with 2-opt and Or-opt on the
+ * tour, runs within a time budget.
+ */
+class ShoppingOptimizer {
+public:
+    /**
+     * @brief Build settings
+     */
+    struct Options {
+        std::size_t threads = 0;    ///< Worker threads, 0 for the shared pool
+        std::size_t chunkSize = 512; ///< Meals aggregated per task
+        /// Time stock expiry is checked against; meals planned earlier are still served
+        std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+    };
+
+    /**
+     * @brief One ingredient to buy
+     */
+    struct Item {
+        std::string ingredient;       ///< Normalized name
+        core::Ingredient::Unit unit;  ///< GRAM, MILLILITER or PIECE
+        double required;              ///< Total needed by the meals, in unit
+        double fromStock;             ///< Part served by the pantry, in unit
+        double toBuy;                 ///< required - fromStock, positive
+        double estimatedCost;         ///< toBuy at the meals' average price per unit
+        std::size_t meals;            ///< Meals that use the ingredient
+        /// Planned time of the first meal the pantry cannot fully serve
+        std::chrono::system_clock::time_point neededBy;
+    };
+
+    /**
+     * @brief Result of buildList()
+     */
+    struct ShoppingList {
+        std::vector<Item> items;                 ///< In order of first use in the meal list
+        double totalCost = 0.0;                  ///< Sum of the estimated item costs
+        std::size_t mealCount = 0;               ///< Meals still to be cooked
+        std::size_t ingredientCount = 0;         ///< Distinct ingredients needed, stocked ones included
+        std::chrono::microseconds buildTime{0};  ///< Wall-clock time
+    };
+
+    /**
+     * @brief Store selection and routing settings
+     */
+    struct TripOptions {
+        double costPerDistance = 1.0;           ///< Travel cost per unit of the distance matrix
+        std::size_t exactStoreLimit = 12;       ///< Solve exactly up to this many useful stores, at most 16
+        std::chrono::milliseconds timeLimit{50}; ///< Budget of the heuristic, checked between moves
+        std::size_t maxRestarts = 200;          ///< Perturbations of the heuristic after its first descent
+        std::uint64_t seed = 0;                 ///< Heuristic random seed
+    };
+
+    /**
+     * @brief Packs bought at one store
+     */
+    struct StoreVisit {
+        std::string store;
+        std::vector<CostOptimizer::PackPurchase> purchases;
+        double itemCost = 0.0;  ///< Sum of the purchase costs
+    };
+
+    /**
+     * @brief Result of planTrip()
+     */
+    struct Trip {
+        std::vector<StoreVisit> visits;         ///< Stores in visiting order, from home and back
+        double itemCost = 0.0;                  ///< Price of every pack bought
+        double distance = 0.0;                  ///< Length of the tour
+        double travelCost = 0.0;                ///< distance times TripOptions::costPerDistance
+        double totalCost = 0.0;                 ///< itemCost plus travelCost
+        bool feasible = true;                   ///< Every item can be bought
+        bool optimal = false;                   ///< Proven optimal by the exact search
+        std::vector<std::string> uncovered;     ///< Items no store can supply in full
+        std::chrono::microseconds solveTime{0}; ///< Wall-clock time
+    };
+
+    /**
+     * @brief Trips shared between optimizers, see setCache()
+     */
+    using Cache = utils::ResultCache<Trip>;
+
+    /**
+     * @brief Deadline, cancellation and progress reporting of one planTrip() call
+     */
+    using Control = SolveControl<Trip>;
+
+    // Constructors
+    /**
+     * @brief Create an optimizer netting against the ingredients held by Storage
+     */
+    ShoppingOptimizer();
+
+    /**
+     * @brief Create an optimizer netting against a given inventory
+     * @param inventory Pantry lots; quantity, unit and expiry date are used
+     * @throws std::invalid_argument if a lot is null
+     */
+    explicit ShoppingOptimizer(const std::vector<std::shared_ptr<core::Ingredient>>& inventory);
+
+    // Setters
+    /**
+     * @brief Replace the pantry inventory
+     * @throws std::invalid_argument if a lot is null
+     */
+    void setInventory(const std::vector<std::shared_ptr<core::Ingredient>>& inventory);
+
+    /**
+     * @brief Set the stores and the distances between them
+     * @param stores Store names
+     * @param distances (stores + 1) square matrix; index 0 is home and store
+     *        i is index i + 1. Distances should be shortest paths, so that
+     *        passing by a store never shortens a trip.
+     * @throws std::invalid_argument if a name is empty or repeated, or the
+     *         matrix is not square, symmetric, finite and non-negative
+     */
+    void setStores(const std::vector<std::string>& stores, const std::vector<std::vector<double>>& distances);
+
+    /**
+     * @brief Add a pack offer of one of the stores
+     */
+    void addOffer(const core::PackOffer& offer);
+
+    /**
+     * @brief Update offer prices from the latest ones of a price history
+     *
+     * Each offer takes the latest price recorded for its ingredient name at
+     * its store, read per base unit (g, ml or piece) and scaled to its pack
+     * size; offers without a series keep their price.
+     *
+     * @return Number of offers repriced
+     */
+    std::size_t applyPriceHistory(const core::PriceHistory& history);
+
+    /**
+     * @brief Reuse trips computed for identical requests
+     *
+     * planTrip() first looks up a fingerprint of the items to buy, stores,
+     * distances, offers and travel cost, and on a hit returns the stored
+     * trip without searching; Trip::solveTime then holds the lookup time.
+     * Only trips proven optimal are stored, as the heuristic's result
+     * depends on its time budget. Entries are tagged with
+     * core::Storage::getVersion() and ignored once Storage changes.
+     *
+     * @param cache Cache to use, possibly shared with other optimizers; null disables caching
+     */
+    void setCache(std::shared_ptr<Cache> cache);
+
+    // Operations
+    /**
+     * @brief Build the shopping list for a set of meals, with default options
+     * @throws std::invalid_argument if a meal or one of its ingredients is null
+     */
+    ShoppingList buildList(const std::vector<std::shared_ptr<core::Meal>>& meals) const;
+
+    /**
+     * @brief Build the shopping list for a set of meals
+     * @param meals Planned meals; their ingredients are already scaled to their servings
+     * @param options Parallelism and the reference time for expiry
+     * @return What to buy
+     * @throws std::invalid_argument if a meal or one of its ingredients is null,
+     *         or chunkSize is 0
+     */
+    ShoppingList buildList(const std::vector<std::shared_ptr<core::Meal>>& meals, const Options& options) const;
+
+    /**
+     * @brief Choose stores and a route for a shopping list, with default options
+     * @throws std::invalid_argument if an offer names an unknown store
+     */
+    Trip planTrip(const ShoppingList& list) const;
+
+    /**
+     * @brief Choose stores and a route for a shopping list
+     *
+     * Each item is bought at one store, as the cheapest packs that store
+     * offers covering ShoppingList::Item::toBuy.
+     *
+     * @param list The list, from buildList()
+     * @param options Travel cost and solver limits
+     * @return The trip; items no store can supply are left out and listed
+     * @throws std::invalid_argument if an offer names an unknown store or
+     *         exactStoreLimit is above 16
+     */
+    Trip planTrip(const ShoppingList& list, const TripOptions& options) const;
+
+    /**
+     * @brief Choose stores and a route for a shopping list within a deadline
+     *
+     * The heuristic stops at the earlier of control.deadline and the end of
+     * TripOptions::timeLimit, or soon after control.cancellation is
+     * cancelled, checking both between moves, and returns the best trip
+     * found by then. The exact search is not interrupted. Every improving
+     * trip is published on control.channel, if set, at its total cost; the
+     * channel is marked finished before this returns.
+     *
+     * @param list The list, from buildList()
+     * @param options Travel cost and solver limits
+     * @param control Deadline, cancellation token and progress channel
+     * @return The trip; items no store can supply are left out and listed
+     * @throws std::invalid_argument if an offer names an unknown store or
+     *         exactStoreLimit is above 16
+     */
+    Trip planTrip(const ShoppingList& list, const TripOptions& options, const Control& control) const;
+
+private:
+    std::vector<std::shared_ptr<core::Ingredient>> inventory_;
+    std::vector<std::string> stores_;
+    std::vector<std::vector<double>> distances_;  ///< Home first, then stores_
+    std::vector<core::PackOffer> offers_;
+    std::shared_ptr<Cache> cache_;
+
+    utils::Fingerprint requestKey(const ShoppingList& list, const TripOptions& options) const;
+};
+
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "smart_food/core/recipe.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+/**
+ * @brief Finds recipes with similar ingredient lists.
+ *
+ * Two recipes are as similar as the Jaccard index of their ingredient sets,
+ * ingredients being compared by normalized name (see
+ * IngredientIndex::normalizeName()) whatever their quantity and unit.
+ *
+ * Every recipe gets a MinHash signature of bands * rows values, one per
+ * hash function, each the minimum of that function over its ingredients;
+ * two recipes agree on a value with a probability equal to their Jaccard
+ * index. The signature is cut into bands and each band hashed into a
+ * bucket, so recipes sharing a bucket in some band are the likely similar
+ * ones: the chance of becoming a candidate rises steeply around a
+ * similarity of (1 / bands)^(1 / rows). Queries then score only those
+ * candidates, by their exact Jaccard index, instead of the whole catalog.
+ */
+class SimilarityIndex {
+public:
+    /**
+     * @brief Signature shape
+     */
+    struct Options {
+        std::size_t bands = 16;  ///< More bands find less similar recipes
+        std::size_t rows = 4;    ///< More rows per band make candidates more selective
+        std::uint64_t seed = 0;  ///< Seed of the hash functions
+    };
+
+    /**
+     * @brief A recipe similar to the query
+     */
+    struct Neighbor {
+        std::shared_ptr<core::Recipe> recipe;
+        double similarity;  ///< Jaccard index of the ingredient sets
+    };
+
+    // Constructors
+    /**
+     * @brief Create an index over the recipes held by Storage
+     */
+    SimilarityIndex();
+
+    /**
+     * @brief Create an index over a recipe catalog, with the default signature shape
+     * @param recipes Recipes to index; a later recipe replaces an earlier one with the same ID
+     * @throws std::invalid_argument if a recipe or one of its ingredients is null
+     */
+    explicit SimilarityIndex(const std::vector<std::shared_ptr<core::Recipe>>& recipes);
+
+    /**
+     * @brief Create an index over a recipe catalog
+     * @param recipes Recipes to index; a later recipe replaces an earlier one with the same ID
+     * @param options Signature shape
+     * @throws std::invalid_argument if a recipe or one of its ingredients is
+     *         null, or bands or rows is 0
+     */
+    SimilarityIndex(const std::vector<std::shared_ptr<core::Recipe>>& recipes, const Options& options);
+
+    // Setters
+    /**
+     * @brief Add a recipe, replacing any recipe with the same ID
+     * @throws std::invalid_argument if the recipe or one of its ingredients is null
+     */
+    void addRecipe(const std::shared_ptr<core::Recipe>& recipe);
+
+    /**
+     * @brief Remove a recipe
+     * @return Whether a recipe with that ID was present
+     */
+    bool removeRecipe(const std::string& recipeId);
+
+    // Operations
+    /**
+     * @brief Find the indexed recipes most similar to a recipe
+     *
+     * The recipe need not be indexed; an indexed recipe with its ID is not
+     * returned. Recipes sharing no bucket with it are never returned, so
+     * neighbors well below the band threshold may be missed.
+     *
+     * @param recipe Query recipe
+     * @param limit Most neighbors to return
+     * @param minSimilarity Least Jaccard index of a neighbor
+     * @return Neighbors by decreasing similarity, ties in the order they were added
+     * @throws std::invalid_argument if one of its ingredients is null
+     */
+    std::vector<Neighbor> findSimilar(const core::Recipe& recipe, std::size_t limit,
+                                      double minSimilarity = 0.0) const;
+
+    /**
+     * @brief Find the recipes most similar to an indexed recipe
+     * @throws std::out_of_range if the recipe is not indexed
+     */
+    std::vector<Neighbor> findSimilar(const std::string& recipeId, std::size_t limit,
+                                      double minSimilarity = 0.0) const;
+
+    /**
+     * @brief Group the indexed recipes that are near duplicates of each other
+     *
+     * Pairs sharing a bucket with a Jaccard index of at least the threshold
+     * are linked, and each group is a connected set of links, so a group
+     * may hold two recipes less similar than the threshold through a third.
+     *
+     * @param threshold Least Jaccard index of a duplicate pair
+     * @return Groups of two or more recipes, each and all in the order they were added
+     * @throws std::invalid_argument if threshold is outside [0, 1]
+     */
+    std::vector<std::vector<std::shared_ptr<core::Recipe>>> findDuplicates(double threshold = 0.8) const;
+
+    /**
+     * @brief Exact Jaccard index of the ingredient sets of two recipes
+     * @throws std::invalid_argument if an ingredient is null
+     */
+    static double similarity(const core::Recipe& first, const core::Recipe& second);
+
+    // Getters
+    /**
+     * @brief Get the number of recipes indexed
+     */
+    std::size_t getRecipeCount() const;
+
+    /**
+     * @brief Get the signature shape
+     */
+    const Options& getOptions() const;
+
+private:
+    Options options_;
+    std::vector<std::uint64_t> multipliers_;  ///< Odd multiplier of each hash function
+    std::vector<std::uint64_t> offsets_;      ///< Offset of each hash function
+
+    std::vector<std::shared_ptr<core::Recipe>> recipes_;    ///< Row -> recipe, null once removed
+    std::vector<std::vector<std::uint64_t>> elements_;     ///< Row -> sorted ingredient hashes
+    std::vector<std::uint32_t> signatures_;                ///< Row-major signatures, bands * rows per row
+    std::unordered_map<std::string, std::uint32_t> rowOf_;  ///< Recipe ID -> row
+
+    /// Rows sharing a band key, chained through next_
+    struct Bucket {
+        std::uint64_t key;
+        std::uint32_t head;  ///< Row added last, kNone if the slot is free
+    };
+
+    /// Open-addressed buckets of one band
+    struct BandTable {
+        std::vector<Bucket> slots;
+        std::size_t used = 0;
+    };
+
+    static constexpr std::uint32_t kNone = 0xFFFFFFFFu;
+
+    std::vector<BandTable> bands_;
+    std::vector<std::uint32_t> next_;  ///< (row * bands + band) -> next row in its bucket
+    std::size_t retired_ = 0;          ///< Removed rows still chained in buckets
+
+    static std::vector<std::uint64_t> elementsOf(const core::Recipe& recipe);
+    static double jaccard(const std::vector<std::uint64_t>& first, const std::vector<std::uint64_t>& second);
+    void sign(const std::vector<std::uint64_t>& elements, std::uint32_t* signature) const;
+    std::uint64_t bandKey(const std::uint32_t* signature, std::size_t band) const;
+    void link(std::uint32_t row);
+    std::uint32_t head(std::size_t band, std::uint64_t key) const;
+    void rebuildBuckets();
+    std::vector<Neighbor> rank(const std::vector<std::uint64_t>& elements, const std::uint32_t* signature,
+                               const std::string& exclude, std::size_t limit, double minSimilarity) const;
+    void setOptions(const Options& options);
+    std::size_t width() const;
+};
+
+} // namespace algorithms
+} // namespace smart_food
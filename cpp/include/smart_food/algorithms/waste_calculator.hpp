@@ -0,0 +1,229 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "smart_food/algorithms/ingredient_index.hpp"
+#include "smart_food/core/ingredient.hpp"
+#include "smart_food/core/meal.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+/**
+ * @brief Projects how much food a meal plan leaves to spoil.
+ *
+ * The pantry is simulated over a planning horizon. Every meal still to be
+ * cooked (status PLANNED or SHOPPING) takes its ingredients at its planned
+ * time from the stocked lot that expires first, purchases add lots when
+ * they arrive, and whatever is left of a lot when its expiry date passes is
+ * projected waste, priced at the lot's unit price. Ingredients are matched
+ * by IngredientIndex identity and quantities converted to base units, as
+ * ShoppingOptimizer does; a lot serves meals planned up to its expiry date,
+ * and a lot without one never spoils.
+ *
+ * Arrivals, meals and expiries are merged into one sorted event sweep, with
+ * a priority queue of lots per ingredient, so a month for a household takes
+ * microseconds and a planner can score candidate plans by their projected
+ * waste.
+ *
+ * estimateRisk() repeats the simulation over random scenarios in which
+ * meals are skipped, portions vary and food spoils earlier or later than
+ * its date. Lots are still used in order of their expiry date, as a
+ * household would, but each spoils at its own sampled time. Random numbers
+ * are a hash of the seed, the scenario and the meal, ingredient use or lot
+ * they apply to, so every scenario is the same whatever the batching and
+ * thread count. Scenarios run in batches of kLanes in lockstep, with lot
+ * state laid out lane-contiguous so the inner loops vectorize.
+ */
+class WasteCalculator {
+public:
+    /**
+     * @brief Food left to spoil in one lot
+     */
+    struct WasteItem {
+        std::string ingredient;       ///< Normalized name
+        core::Ingredient::Unit unit;  ///< GRAM, MILLILITER or PIECE
+        double quantity;              ///< Left in the lot at expiry, in unit
+        double cost;                  ///< quantity at the lot's unit price
+        std::chrono::system_clock::time_point expiredAt;
+    };
+
+    /**
+     * @brief Part of a meal's ingredient the stock could not serve
+     */
+    struct Shortage {
+        std::string ingredient;       ///< Normalized name
+        core::Ingredient::Unit unit;  ///< GRAM, MILLILITER or PIECE
+        double quantity;              ///< Missing quantity, in unit
+        std::chrono::system_clock::time_point neededAt;  ///< Planned time of the meal
+    };
+
+    /**
+     * @brief Result of simulate()
+     */
+    struct Projection {
+        std::vector<WasteItem> waste;            ///< In expiry order
+        std::vector<Shortage> shortages;         ///< In meal order
+        std::vector<double> dailyWasteCost;      ///< Waste cost per day of the horizon, from its start
+        double wasteCost = 0.0;                  ///< Sum of the waste costs
+        std::size_t mealCount = 0;               ///< Meals cooked within the horizon
+        std::chrono::microseconds simulationTime{0};  ///< Wall-clock time
+    };
+
+    /**
+     * @brief Uncertainty model and sampling settings of estimateRisk()
+     */
+    struct RiskOptions {
+        std::size_t scenarios = 2000;       ///< Scenarios sampled
+        double skipProbability = 0.1;       ///< Chance that a meal is not cooked at all
+        double portionSpread = 0.15;        ///< Relative standard deviation of each ingredient use
+        double spoilageSpreadDays = 1.0;    ///< Standard deviation of each dated lot's actual spoilage, in days
+        std::vector<double> percentiles{0.5, 0.9, 0.95};  ///< Waste cost quantiles to report, in [0, 1]
+        std::uint64_t seed = 0;             ///< Random seed
+        std::size_t threads = 0;            ///< Worker threads, 0 for the shared pool
+    };
+
+    /**
+     * @brief Waste risk of one ingredient
+     */
+    struct IngredientRisk {
+        std::string ingredient;       ///< Normalized name
+        core::Ingredient::Unit unit;  ///< GRAM, MILLILITER or PIECE
+        double expectedQuantity;      ///< Mean quantity wasted, in unit
+        double expectedCost;          ///< Mean cost wasted
+        double probability;           ///< Share of scenarios wasting some of it
+    };
+
+    /**
+     * @brief Result of estimateRisk()
+     */
+    struct RiskProfile {
+        double expectedCost = 0.0;           ///< Mean waste cost
+        double standardDeviation = 0.0;      ///< Of the waste cost
+        std::vector<double> percentileCosts; ///< Waste cost at each RiskOptions::percentiles
+        std::vector<IngredientRisk> ingredients;  ///< Ingredients at risk, by decreasing expected cost
+        std::size_t scenarios = 0;
+        std::chrono::microseconds simulationTime{0};  ///< Wall-clock time
+    };
+
+    /// Scenarios simulated together by one task
+    static constexpr std::size_t kLanes = 16;
+
+    // Constructors
+    /**
+     * @brief Create a calculator starting from the ingredients held by Storage
+     */
+    WasteCalculator();
+
+    /**
+     * @brief Create a calculator starting from a given inventory
+     * @param inventory Pantry lots; quantity, unit, price and expiry date are used
+     * @throws std::invalid_argument if a lot is null
+     */
+    explicit WasteCalculator(const std::vector<std::shared_ptr<core::Ingredient>>& inventory);
+
+    // Setters
+    /**
+     * @brief Replace the pantry inventory
+     * @throws std::invalid_argument if a lot is null
+     */
+    void setInventory(const std::vector<std::shared_ptr<core::Ingredient>>& inventory);
+
+    /**
+     * @brief Add a lot that will be bought during the horizon
+     * @param lot The lot; quantity, unit, price and expiry date are used
+     * @param arrival When it reaches the pantry
+     * @throws std::invalid_argument if the lot is null
+     */
+    void addPurchase(const std::shared_ptr<core::Ingredient>& lot, std::chrono::system_clock::time_point arrival);
+
+    /**
+     * @brief Remove every purchase
+     */
+    void clearPurchases();
+
+    // Operations
+    /**
+     * @brief Simulate the pantry over a horizon
+     *
+     * Lots already expired at the start are ignored, as are meals and
+     * arrivals outside the horizon; lots still good at its end are not waste.
+     *
+     * @param meals Planned meals; their ingredients are already scaled to their servings
+     * @param start Start of the horizon
+     * @param end End of the horizon, inclusive
+     * @return Projected waste and shortages
+     * @throws std::invalid_argument if a meal or one of its ingredients is
+     *         null, or end is before start
+     */
+    Projection simulate(const std::vector<std::shared_ptr<core::Meal>>& meals,
+                        std::chrono::system_clock::time_point start,
+                        std::chrono::system_clock::time_point end) const;
+
+    /**
+     * @brief Estimate the distribution of waste over random scenarios
+     *
+     * Horizon and lots are handled as in simulate(), which the estimate
+     * matches exactly when every spread and the skip probability are 0.
+     *
+     * @param meals Planned meals; their ingredients are already scaled to their servings
+     * @param start Start of the horizon
+     * @param end End of the horizon, inclusive
+     * @param options Uncertainty model, sampling and parallelism
+     * @return Expected waste, its percentiles and the ingredients at risk
+     * @throws std::invalid_argument if a meal or one of its ingredients is
+     *         null, end is before start, scenarios is 0, a probability or
+     *         percentile is outside [0, 1] or a spread is negative
+     */
+    RiskProfile estimateRisk(const std::vector<std::shared_ptr<core::Meal>>& meals,
+                             std::chrono::system_clock::time_point start,
+                             std::chrono::system_clock::time_point end,
+                             const RiskOptions& options) const;
+
+private:
+    /// A lot in base units, from the inventory or a purchase
+    struct Lot {
+        std::uint32_t id;     ///< Identity in index_
+        double quantity;      ///< Base quantity
+        double unitCost;      ///< Price per base unit
+        std::chrono::system_clock::time_point expiry;   ///< time_point::max() if it keeps
+        std::chrono::system_clock::time_point arrival;  ///< time_point::min() if in stock
+    };
+
+    /// One ingredient of a meal cooked within the horizon
+    struct Use {
+        std::uint32_t id;    ///< Identity in index_, npos if nothing is ever stocked
+        std::uint32_t meal;  ///< Index among the meals cooked
+        double quantity;     ///< Base quantity
+        std::chrono::system_clock::time_point time;
+        const core::Ingredient* ingredient;
+    };
+
+    IngredientIndex index_;  ///< Identities of every lot
+    std::vector<Lot> stock_;
+    std::vector<Lot> purchases_;
+
+    Lot makeLot(const std::shared_ptr<core::Ingredient>& lot, std::chrono::system_clock::time_point arrival);
+
+    /**
+     * @brief Lots of a horizon: stock still good at its start, then purchases arriving within it
+     * @param stocked Set to the number of stocked lots, which come first
+     */
+    std::vector<Lot> horizonLots(std::chrono::system_clock::time_point start,
+                                 std::chrono::system_clock::time_point end, std::size_t& stocked) const;
+
+    /**
+     * @brief Ingredient uses of the meals cooked within a horizon, in meal order
+     * @param mealCount Set to the number of meals cooked
+     */
+    std::vector<Use> horizonUses(const std::vector<std::shared_ptr<core::Meal>>& meals,
+                                 std::chrono::system_clock::time_point start,
+                                 std::chrono::system_clock::time_point end, std::size_t& mealCount) const;
+};
+
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <limits>
+#include <string>
+#include <vector>
+#include "smart_food/core/ingredient.hpp"
+
+namespace smart_food {
+namespace core {
+
+/**
+ * @brief A store's offer to sell an ingredient in fixed-size packs.
+ *
+ * Stores rarely sell arbitrary quantities: an offer sells whole packs of a
+ * given size at a base price per pack, optionally with volume discounts.
+ * A price tier lowers the price of every pack once at least its minimum
+ * number of packs is bought ("4+ for 1.80 each"). Stock may be limited.
+ *
+ * The ingredient is identified by name and the dimension of the pack unit,
+ * like algorithms::IngredientIndex does, so an offer for "Flour" in
+ * kilograms covers a recipe's "flour" in grams.
+ */
+class PackOffer {
+public:
+    /**
+     * @brief Volume discount: price of every pack once minPacks are bought
+     */
+    struct PriceTier {
+        int minPacks;      ///< Fewest packs for the tier, at least 2
+        double packPrice;  ///< Price of each pack in the tier
+    };
+
+    /// Stock of an offer without a limit
+    static constexpr int kUnlimited = std::numeric_limits<int>::max();
+
+    // Constructors
+    /**
+     * @brief Create an offer
+     * @param store Name of the store
+     * @param ingredient Name of the ingredient sold
+     * @param packSize Quantity in one pack, in unit
+     * @param unit Unit of packSize
+     * @param packPrice Price of one pack without discount
+     * @throws std::invalid_argument if a name is empty, packSize is not
+     *         positive or packPrice is negative
+     */
+    PackOffer(const std::string& store, const std::string& ingredient, double packSize,
+              Ingredient::Unit unit, double packPrice);
+
+    // Getters
+    const std::string& getStore() const;
+    const std::string& getIngredient() const;
+    double getPackSize() const;
+    Ingredient::Unit getUnit() const;
+    double getPackPrice() const;
+
+    /**
+     * @brief Get the volume discounts, by increasing minimum
+     */
+    const std::vector<PriceTier>& getPriceTiers() const;
+
+    /**
+     * @brief Get the most packs the store can sell, kUnlimited if unlimited
+     */
+    int getStock() const;
+
+    // Setters
+    /**
+     * @brief Change the price of one pack without discount
+     *
+     * Price tiers are scaled by the same factor, so each keeps its discount.
+     *
+     * @throws std::invalid_argument if packPrice is negative or not finite
+     */
+    void setPackPrice(double packPrice);
+
+    /**
+     * @brief Add a volume discount, replacing any tier with the same minimum
+     * @param minPacks Fewest packs for the discount
+     * @param packPrice Price of each pack from minPacks on
+     * @throws std::invalid_argument if minPacks is below 2 or packPrice is negative
+     */
+    void addPriceTier(int minPacks, double packPrice);
+
+    /**
+     * @brief Limit the number of packs available
+     * @throws std::invalid_argument if stock is negative
+     */
+    void setStock(int stock);
+
+    // Operations
+    /**
+     * @brief Price of buying a number of packs, discounts applied
+     * @throws std::invalid_argument if packs is negative or above the stock
+     */
+    double priceFor(int packs) const;
+
+private:
+    std::string store_;             ///< Store name
+    std::string ingredient_;        ///< Ingredient name
+    double packSize_;               ///< Quantity per pack, in unit_
+    Ingredient::Unit unit_;         ///< Unit of the pack size
+    double packPrice_;              ///< Base price per pack
+    std::vector<PriceTier> tiers_;  ///< Discounts by increasing minPacks
+    int stock_ = kUnlimited;        ///< Packs available
+};
+
+} // namespace core
+} // namespace smart_food
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace smart_food {
+namespace core {
+
+/**
+ * @brief Price history of catalog items at each store.
+ *
+ * One time series is kept per (item, store) pair. Points are packed into
+ * compressed blocks of kBlockPoints, one column of timestamps and one of
+ * prices, as in time-series databases: a timestamp is stored as the change
+ * in its delta to the previous one, so regular sampling costs one bit, and
+ * a price as the XOR with the previous price, so an unchanged price costs
+ * one bit and a changed one the few bits the two values differ in. A point
+ * takes one to a few bytes instead of a heap object.
+ *
+ * Each block also keeps its time span and the minimum, maximum and sum of
+ * its prices, so range aggregates only decode the blocks at the ends of the
+ * range, and the latest point of every series is kept in clear for O(1)
+ * latest-price lookups.
+ *
+ * Timestamps are stored to the second. Points must be recorded in time
+ * order within a series; series are independent.
+ */
+class PriceHistory {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    /// Points per compressed block
+    static constexpr std::size_t kBlockPoints = 512;
+
+    /**
+     * @brief One recorded price
+     */
+    struct Point {
+        TimePoint time;
+        double price;
+    };
+
+    /**
+     * @brief Latest price of an item at one store
+     */
+    struct StorePrice {
+        std::string store;
+        TimePoint time;  ///< When the price was recorded
+        double price;
+    };
+
+    /**
+     * @brief Aggregate of a series over a time range
+     */
+    struct Summary {
+        std::string store;
+        std::size_t count = 0;    ///< Points in the range; the rest is zero if none
+        double minPrice = 0.0;
+        double maxPrice = 0.0;
+        double meanPrice = 0.0;   ///< Mean over the points, not weighted by time
+        Point first{};            ///< Earliest point in the range
+        Point last{};             ///< Latest point in the range
+    };
+
+    // Operations
+    /**
+     * @brief Record a price
+     * @param item Catalog item name
+     * @param store Store name
+     * @param time When the price was seen; truncated to the second
+     * @param price The price
+     * @throws std::invalid_argument if a name is empty, the price is
+     *         negative or not finite, or time is earlier than the latest
+     *         point of the series
+     */
+    void record(const std::string& item, const std::string& store, TimePoint time, double price);
+
+    /**
+     * @brief Check whether any price was recorded for an item at a store
+     */
+    bool hasSeries(const std::string& item, const std::string& store) const;
+
+    /**
+     * @brief Get the latest price of an item at a store
+     * @throws std::out_of_range if no price was recorded for the pair
+     */
+    Point latestPrice(const std::string& item, const std::string& store) const;
+
+    /**
+     * @brief Get the latest price of an item at every store that sells it
+     * @return One entry per store, cheapest first
+     */
+    std::vector<StorePrice> latestPrices(const std::string& item) const;
+
+    /**
+     * @brief Get the points of a series in a time range
+     * @param from Start of the range, inclusive
+     * @param to End of the range, inclusive
+     * @return The points in time order; empty if the pair is unknown
+     */
+    std::vector<Point> range(const std::string& item, const std::string& store, TimePoint from,
+                             TimePoint to) const;
+
+    /**
+     * @brief Aggregate a series over a time range
+     * @param from Start of the range, inclusive
+     * @param to End of the range, inclusive
+     * @return The summary; count is 0 if the pair is unknown or has no point in range
+     */
+    Summary summarize(const std::string& item, const std::string& store, TimePoint from, TimePoint to) const;
+
+    /**
+     * @brief Aggregate the series of an item at every store over a time range
+     * @return One summary per store with points in range, by increasing mean price
+     */
+    std::vector<Summary> summarizeStores(const std::string& item, TimePoint from, TimePoint to) const;
+
+    // Getters
+    /**
+     * @brief Get the number of (item, store) series
+     */
+    std::size_t getSeriesCount() const;
+
+    /**
+     * @brief Get the number of recorded points
+     */
+    std::size_t getPointCount() const;
+
+    /**
+     * @brief Get the bytes held by the series, blocks and bit streams included
+     */
+    std::size_t memoryUsage() const;
+
+private:
+    /**
+     * @brief Compressed run of up to kBlockPoints points
+     */
+    struct Block {
+        std::int64_t firstTime = 0;  ///< Seconds since the epoch
+        std::int64_t lastTime = 0;
+        double minPrice = 0.0;
+        double maxPrice = 0.0;
+        double sum = 0.0;
+        std::uint32_t count = 0;
+        std::uint64_t bitCount = 0;       ///< Bits used in bits
+        std::vector<std::uint64_t> bits;  ///< Timestamp and price codes, interleaved
+    };
+
+    /**
+     * @brief Series of one (item, store) pair, with the encoder state of its last block
+     */
+    struct Series {
+        std::uint32_t store = 0;
+        std::vector<Block> blocks;
+        std::int64_t lastTime = 0;
+        std::int64_t lastDelta = 0;
+        double lastPrice = 0.0;
+        std::uint8_t leading = 0xFF;  ///< Leading zeros of the last price window, 0xFF if none yet
+        std::uint8_t trailing = 0;    ///< Trailing zeros of the last price window
+    };
+
+    std::unordered_map<std::string, std::uint32_t> items_;   ///< Item -> index into seriesOf_
+    std::unordered_map<std::string, std::uint32_t> stores_;  ///< Store -> index into storeNames_
+    std::vector<std::string> storeNames_;
+    std::vector<std::vector<std::uint32_t>> seriesOf_;       ///< Item -> its series
+    std::vector<Series> series_;
+    std::size_t points_ = 0;
+
+    const Series* findSeries(const std::string& item, const std::string& store) const;
+    Summary summarize(const Series& series, std::int64_t from, std::int64_t to) const;
+};
+
+} // namespace core
+} // namespace smart_food
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
 #include <chrono>
 #include <map>
+#include <optional>
 #include "ingredient.hpp"
 
 namespace smart_food {
@@ -16,6 +18,7 @@ namespace core {
  * This class manages all aspects of a cooking recipe including:
  * - Basic information (name, description, difficulty)
  * - Ingredients list with quantities
+ * - Other recipes used as components, such as a sauce or a dough
  * - Step-by-step preparation instructions
  * - Nutritional information
  * - Serving size management
@@ -33,11 +36,32 @@ public:
 
     /**
      * @brief Represents a single step in the recipe preparation process
+     *
+     * A step starts once the steps it depends on are done. By default that
+     * is the step before it, so steps run one after the other; listing
+     * dependencies explicitly lets independent steps overlap, e.g. making a
+     * sauce while the pasta water heats. Resources name the kitchen
+     * equipment or people the step holds while it runs, such as
+     * {"oven", 1}, {"burner", 2} or {"hands", 1} for attended work.
      */
     struct Step {
         int order;                     ///< The order/sequence number of this step
         std::string description;       ///< Detailed description of what to do in this step
         std::chrono::minutes duration; ///< Estimated time to complete this step
+        std::optional<std::vector<int>> dependsOn;  ///< Orders of the steps to finish first, unset for the previous step
+        std::map<std::string, int> resources;       ///< Resource name -> units held during the step
+    };
+
+    /**
+     * @brief Another recipe used as an ingredient of this one
+     *
+     * Components make the recipes of a catalog a directed acyclic graph:
+     * the component's own ingredients and components count toward this
+     * recipe in proportion to the servings used.
+     */
+    struct Component {
+        std::shared_ptr<Recipe> recipe;  ///< The recipe used
+        double servings;                 ///< Servings of it this recipe uses
     };
 
     // ------------------------
@@ -99,6 +123,12 @@ public:
 
     /**
      * @brief Calculate the total preparation time
+     *
+     * Steps start as soon as the steps they depend on are done, so the
+     * total is the longest chain of dependent steps; for steps without
+     * explicit dependencies it is the sum of their durations. Resources are
+     * not taken into account; see algorithms::KitchenScheduler.
+     *
      * @return Total time needed to prepare the recipe
      */
     std::chrono::minutes getTotalTime() const;
@@ -109,12 +139,45 @@ public:
      */
     const std::vector<std::shared_ptr<Ingredient>>& getIngredients() const;
 
+    /**
+     * @brief Get the revision of the recipe's contents
+     *
+     * Every change through the recipe's setters and operations gives it a
+     * revision no recipe has had before, so results computed from a recipe
+     * stay valid while its revision and its components' are unchanged.
+     * Ingredients edited in place through getIngredients() leave it as is.
+     *
+     * @return Revision, never 0
+     */
+    std::uint64_t getRevision() const;
+
+    /**
+     * @brief Get the revision most recently given to any recipe
+     *
+     * While it is unchanged, no recipe has been created or changed.
+     */
+    static std::uint64_t getLatestRevision();
+
+    /**
+     * @brief Get the recipes used as components
+     * @return Components in the order they were added
+     */
+    const std::vector<Component>& getComponents() const;
+
     /**
      * @brief Get the preparation steps
      * @return Vector of preparation steps in order
      */
     const std::vector<Step>& getSteps() const;
 
+    /**
+     * @brief Get the steps a step waits for
+     * @param index Position of the step in getSteps()
+     * @return Positions in getSteps() of the steps it depends on, in increasing order
+     * @throws std::out_of_range if index is not a step position
+     */
+    std::vector<std::size_t> getStepDependencies(std::size_t index) const;
+
     /**
      * @brief Get the nutritional information
      * @return Map of nutritional values (e.g., "calories" -> 500)
@@ -168,15 +231,55 @@ public:
      */
     void removeIngredient(const std::string& ingredientId);
 
+    /**
+     * @brief Use another recipe as a component
+     *
+     * Using a recipe that is already a component adds to its servings.
+     * The nutritional information is recalculated from the component's
+     * current values; when a component changes later, call
+     * updateNutritionalInfo() or evaluate the catalog with
+     * algorithms::RecipeGraph.
+     *
+     * @param recipe Recipe to use
+     * @param servings Servings of it used by this recipe
+     * @throws std::invalid_argument if recipe is null, servings is not
+     *         positive, or recipe is this recipe or uses it (directly or
+     *         through its own components)
+     */
+    void addComponent(const std::shared_ptr<Recipe>& recipe, double servings);
+
+    /**
+     * @brief Stop using a recipe as a component
+     * @param recipeId ID of the component recipe to remove
+     */
+    void removeComponent(const std::string& recipeId);
+
+    /**
+     * @brief Check whether this recipe uses another one
+     * @param recipe Recipe to look for
+     * @return true if recipe is this recipe or a component of it, directly
+     *         or through other components
+     */
+    bool uses(const Recipe& recipe) const;
+
     /**
      * @brief Add a new preparation step
+     *
+     * If a step already has the order, it and the steps after it move one
+     * order later, and dependencies on them follow.
+     *
      * @param step Step to add to the recipe
-     * @throws std::invalid_argument if step order <= 0
+     * @throws std::invalid_argument if step order <= 0, the duration is
+     *         negative, a resource amount is not positive, or a dependency
+     *         does not name an existing step of lower order
      */
     void addStep(const Step& step);
 
     /**
      * @brief Remove a preparation step
+     *
+     * Steps that depended on it depend on its own dependencies instead.
+     *
      * @param order Order number of the step to remove
      */
     void removeStep(int order);
@@ -185,7 +288,8 @@ public:
      * @brief Change the order of a preparation step
      * @param oldOrder Current order of the step
      * @param newOrder New order for the step
-     * @throws std::invalid_argument if orders <= 0 or step not found
+     * @throws std::invalid_argument if orders <= 0, step not found, or the
+     *         move would put a step before one it depends on
      */
     void reorderStep(int oldOrder, int newOrder);
 
@@ -202,12 +306,31 @@ public:
 
     /**
      * @brief Calculate the total cost of ingredients
+     *
+     * Components cost their own total cost divided by their servings, per
+     * serving used. Shared components are recomputed on every call; to
+     * price a catalog use algorithms::RecipeGraph, which memoizes them.
+     *
      * @return Total cost of the recipe
      */
     double calculateTotalCost() const;
 
     /**
-     * @brief Update the nutritional information based on ingredients
+     * @brief Get the ingredients of all servings, components expanded
+     *
+     * The recipe's own ingredients come first, as getIngredients() returns
+     * them, followed by those of its components, recursively, as copies
+     * scaled by the servings used over the servings the component makes.
+     * A component used in several places is listed once, scaled by all its
+     * uses, so the list is linear in the size of the component graph. The
+     * same ingredient may appear more than once.
+     *
+     * @return Ingredients needed to make the recipe from scratch
+     */
+    std::vector<std::shared_ptr<Ingredient>> expandIngredients() const;
+
+    /**
+     * @brief Update the nutritional information based on ingredients and components
      */
     void updateNutritionalInfo();
 
@@ -217,18 +340,26 @@ public:
 
     /**
      * @brief Check if the recipe is complete and valid
-     * @return true if recipe has name, servings > 0, ingredients, and steps
+     * @return true if recipe has name, servings > 0, ingredients or
+     *         components, and steps
      */
     bool isValid() const;
 
     /**
      * @brief Convert the recipe to a string format for storage
+     *
+     * Components are stored in full inside the recipe that uses them.
+     *
      * @return JSON string representation of the recipe
      */
     std::string serialize() const;
 
     /**
      * @brief Create a recipe from a stored string format
+     *
+     * A component used in several places of the data, identified by its
+     * ID, is restored as one shared recipe.
+     *
      * @param data JSON string containing recipe data
      * @return New Recipe object
      */
@@ -241,8 +372,10 @@ private:
     Difficulty difficulty_;       ///< Difficulty level of preparation
     int servings_;               ///< Number of servings the recipe makes
     std::vector<std::shared_ptr<Ingredient>> ingredients_;  ///< List of ingredients with quantities
+    std::vector<Component> components_;  ///< Recipes used as ingredients
     std::vector<Step> steps_;    ///< Ordered list of preparation steps
     std::map<std::string, double> nutritionalInfo_;  ///< Nutritional values per serving
+    std::uint64_t revision_ = 0;  ///< See getRevision()
 
     /**
      * @brief Generate a unique identifier for the recipe
@@ -250,9 +383,27 @@ private:
     void generateId();
 
     /**
-     * @brief Recalculate nutritional information based on ingredients
+     * @brief Give the recipe a new revision after a change
+     */
+    void touch();
+
+    /**
+     * @brief Find the position of a step by its order
+     * @return Position in steps_, or steps_.size() if there is none
+     */
+    std::size_t findStep(int order) const;
+
+    /**
+     * @brief Recalculate nutritional information based on ingredients and components
      */
     void recalculateNutritionalInfo();
+
+    /**
+     * @brief Deserialize, sharing components already restored from the same data
+     * @param data JSON string containing recipe data
+     * @param restored Recipe ID -> component restored so far
+     */
+    static Recipe deserialize(const std::string& data, std::map<std::string, std::shared_ptr<Recipe>>& restored);
 };
 
 } // namespace core
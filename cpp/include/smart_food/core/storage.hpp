@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 #include <memory>
@@ -51,6 +54,23 @@ public:
     void saveToFile(const std::string& filename) const;
     void clear();
 
+    // Change tracking: incremented by every add, update, remove, clear and load,
+    // so derived results (plans, cached optimizer outputs) can tell they are stale
+    std::uint64_t getVersion() const;
+
+    // Mutation listeners: called after every meal and ingredient add, update and remove,
+    // outside the storage lock, so streaming analytics can follow changes without rescanning.
+    // Recipe changes, clear() and loadFromFile() only bump the version
+    struct Mutation {
+        enum class Kind { ADD, UPDATE, REMOVE };
+        Kind kind;
+        std::shared_ptr<const Meal> meal;              // Set for meal mutations
+        std::shared_ptr<const Ingredient> ingredient;  // Set for ingredient (pantry) mutations
+    };
+    using Listener = std::function<void(const Mutation&)>;
+    std::uint64_t addListener(Listener listener);
+    void removeListener(std::uint64_t id);
+
     // Statistics and analytics
     double calculateTotalInventoryValue() const;
     std::map<std::string, double> getInventoryStatistics() const;
@@ -63,11 +83,17 @@ private:
     std::map<std::string, std::shared_ptr<Meal>> meals_;
     std::map<std::string, std::shared_ptr<Recipe>> recipes_;
     std::map<std::string, std::shared_ptr<Ingredient>> ingredients_;
+    std::atomic<std::uint64_t> version_{0};
+    mutable std::mutex listenersMutex_;
+    std::map<std::uint64_t, Listener> listeners_;
+    std::uint64_t nextListener_ = 1;
 
     // Helper functions
     void validateMeal(const std::shared_ptr<Meal>& meal) const;
     void validateRecipe(const std::shared_ptr<Recipe>& recipe) const;
     void validateIngredient(const std::shared_ptr<Ingredient>& ingredient) const;
+    void bumpVersion();
+    void notify(const Mutation& mutation) const;
 };
 
 } // namespace core
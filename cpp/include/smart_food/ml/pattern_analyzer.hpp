@@ -0,0 +1,259 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "smart_food/core/ingredient.hpp"
+#include "smart_food/core/meal.hpp"
+#include "smart_food/ml/sketches.hpp"
+#include "smart_food/utils/model_file.hpp"
+
+namespace smart_food {
+namespace ml {
+
+/**
+ * @brief Finds ingredients and recipes that are used together.
+ *
+ * Every meal is a transaction holding its recipe, as "recipe:" followed by
+ * the recipe name, and the normalized names of its ingredients and its
+ * recipe's ingredients (see algorithms::IngredientIndex::normalizeName()).
+ * Other transactions, e.g. from households' purchase history, can be added
+ * as plain item lists.
+ *
+ * Frequent itemsets are mined with FP-growth. Items below the support
+ * threshold are dropped, the others are ranked by decreasing frequency, and
+ * the transactions, sorted by rank, are merged into a prefix tree in one
+ * pass: each shares with the tree exactly its common prefix with the one
+ * before it. That sort runs on packed keys, one bucket per leading item and
+ * in parallel. Nodes are 16-byte records in one arena, with each item's nodes
+ * linked together.
+ * The itemsets ending in each item are then mined from the tree of that
+ * item's prefix paths (its conditional tree), recursively; the items of the
+ * first level are mined in parallel, each recursion with its own arenas and
+ * scratch counters. A tree that is a single path yields all its subsets
+ * directly. Association rules are derived from the itemsets found.
+ *
+ * Transactions are kept in full, so mining is exact but memory grows with
+ * history. The vocabulary and transactions can be saved as a binary model
+ * file and opened again in place (see openModelFile()), so worker processes
+ * mining the same history share one copy of it. For analytics over unbounded event streams the analyzer also
+ * maintains Sketches, in fixed memory: recipe popularity with the most cooked
+ * recipes, the number of distinct ingredients, and the distributions of meal
+ * costs and pantry lot values. They are fed by recordMeal() and
+ * recordPantryItem(), or by Storage mutations after watchStorage(), and
+ * serialize and merge across shards (e.g. one analyzer per region).
+ */
+class PatternAnalyzer {
+public:
+    /**
+     * @brief Mining thresholds
+     */
+    struct Options {
+        double minSupport = 0.01;    ///< Least share of transactions holding an itemset, in (0, 1]
+        double minConfidence = 0.0;  ///< Rules only: least share of the antecedent's transactions holding the consequent
+        double minLift = 0.0;        ///< Itemsets of two or more items and rules: least ratio of support to that expected under independence
+        std::size_t maxItems = 4;    ///< Largest itemset, 0 for no limit (rules use itemsets of at most 16 items)
+        std::size_t threads = 0;     ///< Mining threads, 0 for one per core
+    };
+
+    /**
+     * @brief Items found together
+     */
+    struct Itemset {
+        std::vector<std::string> items;  ///< Sorted by name
+        std::size_t count;               ///< Transactions holding all of them
+        double support;                  ///< count over the number of transactions
+        double lift;                     ///< support over the product of the items' supports; 1 for one item
+    };
+
+    /**
+     * @brief Transactions holding the antecedent tend to hold the consequent
+     */
+    struct Rule {
+        std::vector<std::string> antecedent;  ///< Sorted by name
+        std::vector<std::string> consequent;  ///< Sorted by name
+        double support;     ///< Share of transactions holding both
+        double confidence;  ///< Share of the antecedent's transactions holding the consequent
+        double lift;        ///< confidence over the consequent's support
+    };
+
+    /**
+     * @brief Streaming summaries of meals and pantry stock, in bounded memory
+     */
+    struct Sketches {
+        CountMinSketch recipes{4096, 4, 100};  ///< Meals per recipe name, tracking the 100 most cooked
+        HyperLogLog ingredients;               ///< Distinct normalized names of ingredients used or stocked
+        QuantileSketch mealCosts;              ///< Estimated cost of meals
+        QuantileSketch pantryValues;           ///< Value (quantity times unit price) of pantry lots as stocked
+
+        /**
+         * @brief Fold in the sketches of another shard
+         * @throws std::invalid_argument if a sketch differs in shape
+         */
+        void merge(const Sketches& other);
+
+        std::string serialize() const;
+
+        /**
+         * @throws std::invalid_argument if the data does not describe valid sketches
+         */
+        static Sketches deserialize(const std::string& data);
+    };
+
+    // Constructors
+    /**
+     * @brief Create an analyzer over the meals held by Storage, as of now
+     */
+    PatternAnalyzer();
+
+    /**
+     * @brief Create an analyzer over explicit meals
+     * @throws std::invalid_argument if a meal is null
+     */
+    explicit PatternAnalyzer(const std::vector<std::shared_ptr<core::Meal>>& meals);
+
+    /**
+     * @brief Copy transactions and sketches; the copy does not watch Storage
+     */
+    PatternAnalyzer(const PatternAnalyzer& other);
+    PatternAnalyzer& operator=(const PatternAnalyzer& other);
+
+    /**
+     * @brief Open transactions saved by saveModelFile(), reading them from the mapped file in place
+     *
+     * Adding a transaction copies them first. The sketches start empty.
+     *
+     * @throws std::invalid_argument if the file cannot be read, is not a
+     *         pattern file of this version, fails its checksum or is
+     *         inconsistent
+     */
+    static PatternAnalyzer openModelFile(const std::string& filename);
+
+    // Getters
+    /**
+     * @brief Get the number of transactions added
+     */
+    std::size_t getTransactionCount() const;
+
+    /**
+     * @brief Get the number of distinct items seen
+     */
+    std::size_t getItemCount() const;
+
+    /**
+     * @brief Get a snapshot of the sketches
+     */
+    Sketches getSketches() const;
+
+    // Operations
+    /**
+     * @brief Add a meal as a transaction
+     * @param meal Meal to add
+     */
+    void addMeal(const core::Meal& meal);
+
+    /**
+     * @brief Add a transaction
+     * @param items Items of the transaction; duplicates count once
+     */
+    void addTransaction(const std::vector<std::string>& items);
+
+    /**
+     * @brief Find the frequent itemsets with the default thresholds
+     * @return Itemsets by decreasing count, then size, then items
+     */
+    std::vector<Itemset> findFrequentItemsets() const;
+
+    /**
+     * @brief Find the frequent itemsets
+     * @param options Mining thresholds
+     * @return Itemsets by decreasing count, then size, then items
+     * @throws std::invalid_argument if minSupport is not in (0, 1]
+     */
+    std::vector<Itemset> findFrequentItemsets(const Options& options) const;
+
+    /**
+     * @brief Find association rules with the default thresholds
+     * @return Rules by decreasing lift, then confidence, then items
+     */
+    std::vector<Rule> findAssociationRules() const;
+
+    /**
+     * @brief Find association rules between frequent itemsets
+     * @param options Mining thresholds
+     * @return Rules by decreasing lift, then confidence, then items
+     * @throws std::invalid_argument if minSupport is not in (0, 1]
+     */
+    std::vector<Rule> findAssociationRules(const Options& options) const;
+
+    // Streaming analytics; safe to call concurrently with each other and with Storage mutations
+    /**
+     * @brief Record a meal in the sketches: its recipe, its ingredients and its estimated cost
+     * @param meal Meal cooked or planned
+     */
+    void recordMeal(const core::Meal& meal);
+
+    /**
+     * @brief Record a pantry lot in the sketches: its ingredient and its value
+     * @param ingredient Lot stocked
+     */
+    void recordPantryItem(const core::Ingredient& ingredient);
+
+    /**
+     * @brief Record every meal added to Storage and every ingredient added or updated, from now on
+     *
+     * Meal updates and removals leave the sketches unchanged, so that a meal
+     * counts once. The subscription ends with the analyzer.
+     */
+    void watchStorage();
+
+    /**
+     * @brief Fold in the sketches of another shard
+     * @throws std::invalid_argument if a sketch differs in shape
+     */
+    void mergeSketches(const Sketches& other);
+
+    /**
+     * @brief Replace the sketches, e.g. with deserialized ones or ones of another size
+     */
+    void setSketches(const Sketches& sketches);
+
+    /**
+     * @brief Write the vocabulary and transactions as a binary model file, see openModelFile()
+     *
+     * Sketches are not included; they serialize on their own.
+     *
+     * @throws std::invalid_argument if the file cannot be written
+     */
+    void saveModelFile(const std::string& filename) const;
+
+private:
+    struct SketchState;
+
+    std::vector<std::string> items_;                          ///< Item ID -> name
+    std::unordered_map<std::string, std::uint32_t> itemIds_;  ///< Name -> item ID
+    std::vector<std::uint32_t> transactionItems_;             ///< Item IDs of all transactions, each sorted
+    std::vector<std::uint64_t> transactionStarts_{0};         ///< Transaction -> offset in transactionItems_, plus the end
+    std::shared_ptr<const utils::ModelFile> file_;            ///< Model file in use until the first change; the vectors above are empty meanwhile
+    utils::ModelFile::Array<std::uint64_t> fileNameStarts_;   ///< Item ID -> offset of its name in fileNames_, plus the end
+    utils::ModelFile::Array<char> fileNames_;
+    utils::ModelFile::Array<std::uint32_t> fileTransactionItems_;
+    utils::ModelFile::Array<std::uint64_t> fileTransactionStarts_;
+    std::shared_ptr<SketchState> sketchState_;                ///< Shared with the Storage listener, which holds it weakly
+
+    std::uint32_t internItem(const std::string& name);
+    std::string itemName(std::uint32_t item) const;
+    utils::ModelFile::Array<std::uint32_t> transactionItems() const;
+    utils::ModelFile::Array<std::uint64_t> transactionStarts() const;
+
+    /**
+     * @brief Copy the vocabulary and transactions out of the model file, before changing them
+     */
+    void detach();
+};
+
+} // namespace ml
+} // namespace smart_food
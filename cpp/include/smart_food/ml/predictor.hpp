@@ -0,0 +1,241 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "smart_food/utils/model_file.hpp"
+
+namespace smart_food {
+namespace ml {
+
+class SpoilageModel;
+
+/**
+ * @brief Online forecasts of how fast households consume each ingredient.
+ *
+ * Every (household, ingredient) pair is a series of daily consumption,
+ * forecast by additive Holt-Winters smoothing with a damped trend and a
+ * weekly season. Consumption events are added to the quantity of their
+ * day; when an event arrives for a later day, the finished day (and the
+ * days without consumption since) are folded into the level, trend and
+ * seasonal terms. An update therefore costs a hash lookup and at most
+ * Options::maxGapDays smoothing steps, whatever the length of the history;
+ * a series silent for longer starts over.
+ *
+ * Series live in one open-addressing hash table of fixed-size records
+ * (single-precision terms, 56 bytes each), so millions of them stay
+ * compact and an update touches one or two cache lines. Households and
+ * ingredients are identified by integers, e.g. identities from
+ * algorithms::IngredientIndex. Days are UTC calendar days; an event for a
+ * day before its series' current one counts toward the current day.
+ *
+ * The table can be saved as a binary model file and opened again with the
+ * table used in place from the mapped file (see openModelFile()), so worker
+ * processes serving forecasts share one copy; the first update copies it.
+ *
+ * Not thread-safe; shard series over several predictors to update them in
+ * parallel.
+ */
+class Predictor {
+public:
+    /**
+     * @brief Smoothing parameters
+     */
+    struct Options {
+        double levelSmoothing = 0.3;     ///< Weight of a new day in the level, in (0, 1]
+        double trendSmoothing = 0.05;    ///< Weight of a new day in the trend, in [0, 1]
+        double seasonSmoothing = 0.15;   ///< Weight of a new day in its weekday's term, in [0, 1]
+        double trendDamping = 0.9;       ///< Factor applied to the trend per day ahead, in [0, 1]
+        int maxGapDays = 28;             ///< Longer silences restart the series
+        int horizonDays = 365;           ///< Run-outs further ahead are reported as never
+    };
+
+    /**
+     * @brief One consumption of an ingredient by a household
+     */
+    struct Event {
+        std::uint32_t household;
+        std::uint32_t ingredient;
+        double quantity;                              ///< Amount consumed, in the ingredient's unit
+        std::chrono::system_clock::time_point time;   ///< When it was consumed
+    };
+
+    /**
+     * @brief Stock of an ingredient held by a household
+     */
+    struct StockQuery {
+        std::uint32_t household;
+        std::uint32_t ingredient;
+        double stock;  ///< Amount on hand, in the unit of the consumption events
+    };
+
+    /**
+     * @brief Pantry item of a household, for spoilage scoring
+     */
+    struct PantryItem {
+        std::uint32_t household;
+        std::uint32_t ingredient;
+        std::uint32_t category;                         ///< Category code the spoilage model was trained on
+        double quantity;                                ///< Amount on hand, in the unit of the consumption events
+        std::chrono::system_clock::time_point expiry;   ///< When it expires
+    };
+
+    // Constructors
+    /**
+     * @brief Create a predictor with the default smoothing parameters
+     */
+    Predictor();
+
+    /**
+     * @brief Create a predictor
+     * @param options Smoothing parameters
+     * @throws std::invalid_argument if a parameter is out of range
+     */
+    explicit Predictor(const Options& options);
+
+    /**
+     * @brief Open a predictor saved by saveModelFile(), reading its series from the mapped file in place
+     * @throws std::invalid_argument if the file cannot be read, is not a
+     *         predictor file of this version, fails its checksum or is
+     *         inconsistent
+     */
+    static Predictor openModelFile(const std::string& filename);
+
+    // Getters
+    /**
+     * @brief Get the smoothing parameters
+     */
+    const Options& getOptions() const;
+
+    /**
+     * @brief Get the number of series tracked
+     */
+    std::size_t size() const;
+
+    // Operations
+    /**
+     * @brief Make room for a number of series without rehashing
+     * @param series Number of series expected
+     */
+    void reserve(std::size_t series);
+
+    /**
+     * @brief Record a consumption
+     * @param household Household ID
+     * @param ingredient Ingredient ID
+     * @param quantity Amount consumed
+     * @param time When it was consumed
+     * @throws std::invalid_argument if quantity is negative or not finite,
+     *         or both IDs are 0xFFFFFFFF (reserved)
+     */
+    void update(std::uint32_t household, std::uint32_t ingredient, double quantity,
+                std::chrono::system_clock::time_point time);
+
+    /**
+     * @brief Record consumptions in order
+     * @param events Consumption events
+     * @throws std::invalid_argument as update(); earlier events stay recorded
+     */
+    void update(const std::vector<Event>& events);
+
+    /**
+     * @brief Forecast the consumption of an ingredient by a household
+     *
+     * Today counts for what is expected beyond the consumption already
+     * recorded for it.
+     *
+     * @param household Household ID
+     * @param ingredient Ingredient ID
+     * @param days Number of days ahead, today included
+     * @param now Current time
+     * @return Expected amount consumed; 0 for series unknown, silent for
+     *         more than Options::maxGapDays, or without a finished day yet
+     */
+    double forecast(std::uint32_t household, std::uint32_t ingredient, int days,
+                    std::chrono::system_clock::time_point now) const;
+
+    /**
+     * @brief Forecast when stocks run out
+     * @param queries Stocks to check
+     * @param now Current time
+     * @return Per query, days from the start of today until the expected
+     *         consumption reaches the stock (fractional, linear within a
+     *         day); infinity if that is beyond Options::horizonDays or the
+     *         series has no forecast (see forecast())
+     */
+    std::vector<double> daysUntilRunOut(const std::vector<StockQuery>& queries,
+                                        std::chrono::system_clock::time_point now) const;
+
+    /**
+     * @brief Score the risk of pantry items spoiling before they are used
+     *
+     * Builds the model's feature columns in one pass: days to expiry from
+     * now (fractional), the quantity, and the daily usage averaged over the
+     * week's forecast (see forecast()).
+     *
+     * @param model Spoilage model
+     * @param items Items to score
+     * @param now Current time
+     * @return Per item, the model's score
+     */
+    std::vector<float> scoreSpoilage(const SpoilageModel& model, const std::vector<PantryItem>& items,
+                                     std::chrono::system_clock::time_point now) const;
+
+    /**
+     * @brief Write the options and series as a binary model file, see openModelFile()
+     * @throws std::invalid_argument if the file cannot be written
+     */
+    void saveModelFile(const std::string& filename) const;
+
+private:
+    /// Period of the seasonal term, in days
+    static constexpr int kSeason = 7;
+
+    /// One series; key 0 marks a free slot
+    struct Series {
+        std::uint64_t key;          ///< (household << 32 | ingredient) + 1
+        std::int32_t day;           ///< Day of the consumption accumulating in pending
+        float pending;              ///< Consumption recorded for that day so far
+        float level;
+        float trend;
+        float season[kSeason];      ///< By day of the week, as day % kSeason
+        std::uint32_t days;         ///< Finished days folded in, saturating
+    };
+
+    Options options_;
+    float alpha_, beta_, gamma_, phi_;
+    std::vector<Series> table_;  ///< Open addressing with linear probing, power-of-two size; empty while file_ is set
+    std::size_t size_ = 0;
+    std::shared_ptr<const utils::ModelFile> file_;  ///< Model file whose table is used until the first change
+    utils::ModelFile::Array<Series> fileTable_;
+
+    /**
+     * @brief Get the table in use, owned or in the model file
+     */
+    utils::ModelFile::Array<Series> slots() const;
+
+    /**
+     * @brief Copy the table out of the model file, before changing it
+     */
+    void detach();
+
+    const Series* find(std::uint64_t key) const;
+    void grow(std::size_t capacity);
+
+    /**
+     * @brief Fold the pending day and the silent days after it into the terms, up to a day
+     * @return false if the series was silent for longer than Options::maxGapDays
+     */
+    bool advance(Series& series, std::int32_t day) const;
+
+    /**
+     * @brief Copy a series brought up to a day, if it has a forecast for it
+     */
+    bool project(const Series* series, std::int32_t day, Series& state) const;
+};
+
+} // namespace ml
+} // namespace smart_food
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace smart_food {
+namespace ml {
+
+/**
+ * @brief Count-Min sketch of event counts per key, tracking the heaviest keys.
+ *
+ * Counts live in `depth` rows of `width` counters; a key adds to one counter
+ * per row and its estimate is the smallest of them, which never undercounts
+ * and overcounts by at most e / width of the total with probability
+ * 1 - exp(-depth). The `heavyHitters` keys with the largest estimates are
+ * kept in an indexed min-heap, updated as keys are added.
+ *
+ * Keys are hashed with utils::FingerprintBuilder, which is stable across
+ * processes, so sketches of the same shape built on different shards merge
+ * into the sketch of the combined stream.
+ */
+class CountMinSketch {
+public:
+    // Constructors
+    /**
+     * @brief Create an empty sketch
+     * @param width Counters per row
+     * @param depth Rows, at most 16
+     * @param heavyHitters Number of heaviest keys to track, may be 0
+     * @throws std::invalid_argument if width or depth is 0 or depth exceeds 16
+     */
+    CountMinSketch(std::size_t width, std::size_t depth, std::size_t heavyHitters);
+
+    // Getters
+    std::size_t getWidth() const;
+    std::size_t getDepth() const;
+
+    /**
+     * @brief Get the total count added
+     */
+    std::uint64_t getTotal() const;
+
+    /**
+     * @brief Get the heaviest keys with their estimated counts, by decreasing count, then key
+     */
+    std::vector<std::pair<std::string, std::uint64_t>> getHeavyHitters() const;
+
+    // Operations
+    /**
+     * @brief Count occurrences of a key
+     * @param key Key to count
+     * @param count Occurrences
+     */
+    void add(const std::string& key, std::uint64_t count = 1);
+
+    /**
+     * @brief Estimate the count of a key; never below the exact count
+     */
+    std::uint64_t estimate(const std::string& key) const;
+
+    /**
+     * @brief Add another sketch's counts to this one
+     * @throws std::invalid_argument if the sketches differ in width, depth or heavy hitters
+     */
+    void merge(const CountMinSketch& other);
+
+    std::string serialize() const;
+
+    /**
+     * @throws std::invalid_argument if the data does not describe a valid sketch
+     */
+    static CountMinSketch deserialize(const std::string& data);
+
+private:
+    struct Hitter {
+        std::uint64_t count;
+        std::string key;
+    };
+
+    std::size_t width_;
+    std::size_t depth_;
+    std::size_t capacity_;                                    ///< Heavy hitters to keep
+    std::uint64_t total_ = 0;
+    std::vector<std::uint64_t> counters_;                     ///< depth_ rows of width_
+    std::vector<Hitter> heap_;                                ///< Min-heap by count
+    std::unordered_map<std::string, std::size_t> heapIndex_;  ///< Key -> position in heap_
+
+    void slots(const std::string& key, std::size_t* out) const;
+    void offer(const std::string& key, std::uint64_t count);
+    void place(std::size_t position, Hitter hitter);
+    void siftUp(std::size_t position);
+    void siftDown(std::size_t position);
+};
+
+/**
+ * @brief HyperLogLog estimate of the number of distinct keys.
+ *
+ * 2^precision one-byte registers each keep the longest run of leading zeros
+ * among the hashes routed to them; the relative standard error is about
+ * 1.04 / sqrt(2^precision), e.g. 0.8% at the default precision of 14 (16 KiB),
+ * whatever the number of keys. Small cardinalities use linear counting.
+ * Merging takes the register-wise maximum, which gives exactly the sketch of
+ * the union of both streams.
+ */
+class HyperLogLog {
+public:
+    // Constructors
+    /**
+     * @brief Create an empty sketch
+     * @param precision Register index bits, in [4, 18]
+     * @throws std::invalid_argument if precision is out of range
+     */
+    explicit HyperLogLog(unsigned precision = 14);
+
+    // Getters
+    unsigned getPrecision() const;
+
+    // Operations
+    /**
+     * @brief Add a key; repeated keys do not change the estimate
+     */
+    void add(const std::string& key);
+
+    /**
+     * @brief Estimate the number of distinct keys added
+     */
+    double estimate() const;
+
+    /**
+     * @brief Fold in another sketch, giving the sketch of the union
+     * @throws std::invalid_argument if the precisions differ
+     */
+    void merge(const HyperLogLog& other);
+
+    std::string serialize() const;
+
+    /**
+     * @throws std::invalid_argument if the data does not describe a valid sketch
+     */
+    static HyperLogLog deserialize(const std::string& data);
+
+private:
+    unsigned precision_;
+    std::vector<std::uint8_t> registers_;
+};
+
+/**
+ * @brief KLL sketch of a distribution, answering quantile and rank queries.
+ *
+ * Values go into a hierarchy of compactors: when a level fills up it is
+ * sorted and every other value, starting at a random offset, is promoted to
+ * the next level with twice the weight. Capacities shrink geometrically
+ * (by 2/3, to no fewer than 8) below the top level, so at most about 3k
+ * values are retained however many are added, and ranks are off by roughly
+ * 1.7 / k of the count. Merging
+ * concatenates levels and compacts, so shards combine like one stream.
+ */
+class QuantileSketch {
+public:
+    // Constructors
+    /**
+     * @brief Create an empty sketch
+     * @param k Top-level capacity, at least 8; larger is more accurate
+     * @throws std::invalid_argument if k is below 8
+     */
+    explicit QuantileSketch(std::size_t k = 200);
+
+    // Getters
+    std::size_t getK() const;
+
+    /**
+     * @brief Get the number of values added
+     */
+    std::uint64_t getCount() const;
+
+    /**
+     * @brief Get the number of values retained, which bounds memory use
+     */
+    std::size_t getRetained() const;
+
+    // Operations
+    /**
+     * @brief Add a value
+     * @throws std::invalid_argument if the value is not finite
+     */
+    void add(double value);
+
+    /**
+     * @brief Estimate the value at a fraction of the distribution
+     * @param fraction In [0, 1]; 0 gives the minimum and 1 the maximum
+     * @return The estimate, or NaN for an empty sketch
+     * @throws std::invalid_argument if fraction is outside [0, 1]
+     */
+    double quantile(double fraction) const;
+
+    /**
+     * @brief Estimate the fraction of values at most `value`
+     * @return The fraction, or NaN for an empty sketch
+     */
+    double rank(double value) const;
+
+    /**
+     * @brief Fold in another sketch
+     * @throws std::invalid_argument if k differs
+     */
+    void merge(const QuantileSketch& other);
+
+    std::string serialize() const;
+
+    /**
+     * @throws std::invalid_argument if the data does not describe a valid sketch
+     */
+    static QuantileSketch deserialize(const std::string& data);
+
+private:
+    std::size_t k_;
+    std::uint64_t count_ = 0;
+    double min_ = 0.0;
+    double max_ = 0.0;
+    std::uint64_t random_ = 0x9E3779B97F4A7C15ull;  ///< Compaction offsets
+    std::vector<std::vector<double>> levels_;        ///< Level h values weigh 2^h
+
+    std::size_t capacity(std::size_t level) const;
+    void compress(bool allLevels);
+};
+
+} // namespace ml
+} // namespace smart_food
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "smart_food/utils/model_file.hpp"
+
+namespace smart_food {
+namespace ml {
+
+/**
+ * @brief Spoilage features of a batch of pantry items, one column per feature
+ */
+struct SpoilageFeatures {
+    std::vector<std::uint32_t> category;  ///< Ingredient category code
+    std::vector<float> daysToExpiry;      ///< Days until the expiry date, negative once expired
+    std::vector<float> quantity;          ///< Amount on hand
+    std::vector<float> dailyUsage;        ///< Expected consumption per day, e.g. from Predictor
+
+    /**
+     * @brief Get the number of items
+     * @throws std::invalid_argument if the columns differ in length
+     */
+    std::size_t size() const;
+
+    void reserve(std::size_t items);
+    void add(std::uint32_t itemCategory, float itemDaysToExpiry, float itemQuantity, float itemDailyUsage);
+};
+
+/**
+ * @brief Batch inference of spoilage risk: a linear model or gradient-boosted trees.
+ *
+ * Models see five features: the four columns of SpoilageFeatures (the
+ * category as its code) and the derived leftover, the quantity expected to
+ * remain at expiry: max(0, quantity - dailyUsage * max(0, daysToExpiry)).
+ * The raw score is the linear function or the sum of the trees' leaves,
+ * optionally mapped through the logistic function into a probability.
+ *
+ * Scoring works on the columns in blocks. The linear model is a
+ * branch-free pass per column that the compiler vectorizes. Trees are
+ * compiled QuickScorer-style: every split becomes a 64-bit mask of the
+ * leaves that stay reachable when the split's test fails, and the splits
+ * of each feature are sorted by threshold. An item walks each feature's
+ * list only while its value exceeds the threshold, ANDing masks into one
+ * bitvector per tree; the first set bit is the exit leaf. Work is thus
+ * proportional to the failed tests rather than tree depth, without
+ * unpredictable branches on the tree structure. Trees have at most 64
+ * leaves.
+ *
+ * Throughput, one core, 4M-item batches (benchmarks/spoilage_benchmark):
+ * the linear model scores 200-350M items/s and 75-110M with the logistic
+ * link, but ensembles fall well short of tens of millions: about 2.5M items/s
+ * for 32 trees of 16 leaves, 1.6M for 100 of 8 and 0.6M for 100 of 32. Each
+ * item still ANDs one mask per failed split, about half of all splits, into
+ * a bitvector picked by the split's tree, and ends each feature's walk on a
+ * mispredicted branch. Evaluating a block condition by condition instead,
+ * branch-free over the items, measured the same with the SSE2 the build
+ * targets (no 64-bit select) and about 2x faster with AVX2; the cost stays
+ * proportional to items times splits either way.
+ *
+ * Models are read from and written to JSON files (see loadFromFile()) and
+ * to binary model files (see openModelFile()). A model keeps its compiled
+ * arrays in one utils::ModelFile image, so copies share them, and a model
+ * opened from a binary file scores straight from the mapped file.
+ */
+class SpoilageModel {
+public:
+    /// Features, in the order models index them
+    enum class Feature { CATEGORY, DAYS_TO_EXPIRY, QUANTITY, DAILY_USAGE, LEFTOVER };
+    static constexpr std::size_t kFeatureCount = 5;
+
+    /// Mapping of the raw score
+    enum class Link { IDENTITY, LOGISTIC };
+
+    /**
+     * @brief Linear model parameters
+     */
+    struct Linear {
+        double intercept = 0.0;
+        std::vector<double> weights;          ///< Per numeric feature, DAYS_TO_EXPIRY to LEFTOVER; missing ones are 0
+        std::vector<double> categoryWeights;  ///< Per category code; codes beyond are 0
+    };
+
+    /**
+     * @brief Tree node: a split, or a leaf when feature is negative
+     */
+    struct Node {
+        int feature = -1;           ///< Feature index of a split
+        float threshold = 0.0f;     ///< Split: values at most this go left
+        std::uint32_t left = 0;     ///< Split: index of the left child
+        std::uint32_t right = 0;    ///< Split: index of the right child
+        float value = 0.0f;         ///< Leaf output
+    };
+
+    /**
+     * @brief Regression tree; nodes[0] is the root
+     */
+    struct Tree {
+        std::vector<Node> nodes;
+    };
+
+    // Constructors
+    /**
+     * @brief Create a linear or logistic regression model
+     * @throws std::invalid_argument if there are more than 4 weights or a parameter is not finite
+     */
+    SpoilageModel(const Linear& linear, Link link);
+
+    /**
+     * @brief Create a gradient-boosted tree ensemble
+     * @param trees Trees whose leaves are summed
+     * @param baseScore Raw score before the trees
+     * @param link Mapping of the raw score
+     * @throws std::invalid_argument if a tree is not a proper binary tree over
+     *         valid features, has more than 64 leaves or a non-finite value
+     */
+    SpoilageModel(const std::vector<Tree>& trees, double baseScore, Link link);
+
+    /**
+     * @brief Load a model saved by saveToFile()
+     * @throws std::invalid_argument if the file cannot be read or does not describe a valid model
+     */
+    static SpoilageModel loadFromFile(const std::string& filename);
+
+    /**
+     * @brief Open a model saved by saveModelFile(), scoring from the mapped file in place
+     *
+     * Worker processes opening the same file share one copy of it.
+     *
+     * @throws std::invalid_argument if the file cannot be read, is not a
+     *         spoilage model file of this version, fails its checksum or is
+     *         inconsistent
+     */
+    static SpoilageModel openModelFile(const std::string& filename);
+
+    // Getters
+    Link getLink() const;
+
+    /**
+     * @brief Get the number of trees, 0 for a linear model
+     */
+    std::size_t getTreeCount() const;
+
+    // Operations
+    /**
+     * @brief Score a batch
+     * @param features Items to score
+     * @return Per item, the risk score
+     * @throws std::invalid_argument if the feature columns differ in length
+     */
+    std::vector<float> score(const SpoilageFeatures& features) const;
+
+    /**
+     * @brief Score a batch into a caller-provided buffer of features.size() floats
+     * @throws std::invalid_argument if the feature columns differ in length
+     */
+    void score(const SpoilageFeatures& features, float* out) const;
+
+    std::string serialize() const;
+    static SpoilageModel deserialize(const std::string& data);
+    void saveToFile(const std::string& filename) const;
+
+    /**
+     * @brief Write the model as a binary model file, see openModelFile()
+     * @throws std::invalid_argument if the file cannot be written
+     */
+    void saveModelFile(const std::string& filename) const;
+
+private:
+    /// One split, as QuickScorer evaluates it
+    struct Condition {
+        float threshold;
+        std::uint32_t tree;
+        std::uint64_t mask;  ///< Leaves still reachable when the value exceeds the threshold
+    };
+
+    /// Scalars of a model, the first section of its file
+    struct Meta {
+        std::uint32_t link;
+        std::uint32_t treeCount;
+        double baseScore;
+        double intercept;
+        std::uint64_t featureStarts[kFeatureCount + 1];  ///< Feature -> first condition, plus the end
+    };
+
+    std::shared_ptr<const utils::ModelFile> file_;  ///< Holds every array below, mapped or in memory
+    const Meta* meta_ = nullptr;
+    utils::ModelFile::Array<double> weights_;          ///< DAYS_TO_EXPIRY to LEFTOVER
+    utils::ModelFile::Array<double> categoryWeights_;
+    utils::ModelFile::Array<Condition> conditions_;    ///< Grouped by feature, each group by increasing threshold
+    utils::ModelFile::Array<float> leaves_;            ///< 64 per tree, by leaf order (left to right)
+    utils::ModelFile::Array<Node> nodes_;              ///< Source trees, for serialization
+    utils::ModelFile::Array<std::uint32_t> treeStarts_;  ///< Tree -> first node in nodes_, plus the end
+
+    /**
+     * @brief Use the arrays of a model file
+     * @throws std::invalid_argument if they are inconsistent
+     */
+    explicit SpoilageModel(std::shared_ptr<const utils::ModelFile> file);
+
+    /**
+     * @brief Number the leaves of trees and turn their splits into conditions
+     */
+    static void compile(const std::vector<Tree>& trees, Meta& meta, std::vector<Condition>& conditions,
+                        std::vector<float>& leaves);
+};
+
+} // namespace ml
+} // namespace smart_food
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace smart_food {
+namespace utils {
+
+/**
+ * @brief 128-bit content hash identifying a set of inputs
+ */
+struct Fingerprint {
+    std::uint64_t high = 0;
+    std::uint64_t low = 0;
+
+    bool operator==(const Fingerprint& other) const { return high == other.high && low == other.low; }
+    bool operator!=(const Fingerprint& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Streaming builder of a Fingerprint.
+ *
+ * Values are mixed in the order they are added into two independent 64-bit
+ * lanes, so equal sequences give equal fingerprints and a collision between
+ * different inputs is negligible in practice. This is not a cryptographic
+ * hash and must not be used where inputs are adversarial.
+ *
+ * Doubles are hashed by value, with -0.0 equal to 0.0; strings are
+ * length-prefixed, so ("ab", "c") and ("a", "bc") differ.
+ */
+class FingerprintBuilder {
+public:
+    FingerprintBuilder& add(std::uint64_t value);
+    FingerprintBuilder& add(std::int64_t value) { return add(static_cast<std::uint64_t>(value)); }
+    FingerprintBuilder& add(int value) { return add(static_cast<std::uint64_t>(static_cast<std::int64_t>(value))); }
+    FingerprintBuilder& add(double value);
+    FingerprintBuilder& add(bool value) { return add(static_cast<std::uint64_t>(value)); }
+    FingerprintBuilder& add(const std::string& value);
+    FingerprintBuilder& add(const Fingerprint& value);
+
+    /**
+     * @brief Get the fingerprint of everything added so far
+     */
+    Fingerprint finish() const;
+
+private:
+    std::uint64_t a_ = 0x243F6A8885A308D3ull;
+    std::uint64_t b_ = 0x13198A2E03707344ull;
+    std::uint64_t count_ = 0;
+};
+
+} // namespace utils
+} // namespace smart_food
+
+namespace std {
+
+template <>
+struct hash<smart_food::utils::Fingerprint> {
+    std::size_t operator()(const smart_food::utils::Fingerprint& fingerprint) const noexcept {
+        return static_cast<std::size_t>(fingerprint.low);
+    }
+};
+
+} // namespace std
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace smart_food {
+namespace utils {
+
+/**
+ * @brief Binary file of model arrays, laid out to be memory-mapped and used in place.
+ *
+ * A file is a 64-byte header, a table of sections and the sections
+ * themselves, each a flat array of trivially copyable values starting on a
+ * 64-byte boundary. The header holds a magic number, the format version,
+ * the kind and version of the model stored (each model type defines its
+ * own), the file size and a checksum of everything after the header. Values
+ * are in host byte order; files written on a host of the other order are
+ * rejected.
+ *
+ * open() maps the file read-only and shared, so every process opening the
+ * same file uses the same physical pages of the page cache; models keep the
+ * ModelFile alive and point into it rather than copying. Opening costs one
+ * pass over the file for the checksum. Where mmap is unavailable the file is
+ * read into memory instead.
+ *
+ * Writer::save() writes a new file and renames it over the old one, so
+ * processes that have the old file open keep a consistent copy.
+ */
+class ModelFile {
+public:
+    /**
+     * @brief View of a section as an array
+     */
+    template <typename T>
+    struct Array {
+        const T* data = nullptr;
+        std::size_t size = 0;
+
+        const T& operator[](std::size_t index) const { return data[index]; }
+        const T* begin() const { return data; }
+        const T* end() const { return data + size; }
+    };
+
+    /**
+     * @brief Builder of a model file, section by section
+     */
+    class Writer {
+    public:
+        /**
+         * @param kind Model type, see tag()
+         * @param version Version of the model type's layout
+         */
+        Writer(std::uint32_t kind, std::uint32_t version);
+
+        /**
+         * @brief Append a section
+         * @param data First value
+         * @param count Number of values
+         */
+        template <typename T>
+        Writer& add(const T* data, std::size_t count) {
+            static_assert(std::is_trivially_copyable<T>::value, "Model file sections hold plain values");
+            return addBytes(data, count * sizeof(T));
+        }
+
+        template <typename T>
+        Writer& add(const std::vector<T>& values) {
+            return add(values.data(), values.size());
+        }
+
+        /**
+         * @brief Get the file as an in-memory image, without writing it
+         */
+        std::shared_ptr<const ModelFile> finish() const;
+
+        /**
+         * @brief Write the file, replacing any existing one atomically
+         * @throws std::invalid_argument if the file cannot be written
+         */
+        void save(const std::string& filename) const;
+
+    private:
+        std::uint32_t kind_;
+        std::uint32_t version_;
+        std::vector<std::vector<unsigned char>> sections_;
+
+        Writer& addBytes(const void* data, std::size_t bytes);
+        void write(const std::function<void(const void*, std::size_t)>& sink) const;
+        std::vector<std::uint64_t> image() const;
+    };
+
+    /**
+     * @brief Make a model kind from four characters, e.g. tag("SPOI")
+     */
+    static constexpr std::uint32_t tag(const char (&name)[5]) {
+        return static_cast<std::uint32_t>(static_cast<unsigned char>(name[0])) |
+               static_cast<std::uint32_t>(static_cast<unsigned char>(name[1])) << 8 |
+               static_cast<std::uint32_t>(static_cast<unsigned char>(name[2])) << 16 |
+               static_cast<std::uint32_t>(static_cast<unsigned char>(name[3])) << 24;
+    }
+
+    // Constructors
+    /**
+     * @brief Map a model file and check it
+     * @param filename File to open
+     * @param kind Model type expected
+     * @param version Layout version expected
+     * @throws std::invalid_argument if the file cannot be read, is not a model
+     *         file of this kind and version, is truncated or fails the checksum
+     */
+    static std::shared_ptr<const ModelFile> open(const std::string& filename, std::uint32_t kind,
+                                                 std::uint32_t version);
+
+    ~ModelFile();
+    ModelFile(const ModelFile&) = delete;
+    ModelFile& operator=(const ModelFile&) = delete;
+
+    // Getters
+    std::uint32_t getKind() const;
+    std::uint32_t getVersion() const;
+    std::size_t getSectionCount() const;
+
+    /**
+     * @brief Get the size of the file, in bytes
+     */
+    std::size_t getSize() const;
+
+    /**
+     * @brief Check whether the file is memory-mapped rather than read into memory
+     */
+    bool isMapped() const;
+
+    /**
+     * @brief Get a section as an array
+     * @throws std::invalid_argument if there is no such section or its size
+     *         is not a whole number of values
+     */
+    template <typename T>
+    Array<T> section(std::size_t index) const {
+        static_assert(std::is_trivially_copyable<T>::value, "Model file sections hold plain values");
+        std::size_t bytes = 0;
+        const void* data = sectionBytes(index, sizeof(T), bytes);
+        return Array<T>{static_cast<const T*>(data), bytes / sizeof(T)};
+    }
+
+    /**
+     * @brief Write a copy of the file, replacing any existing one atomically
+     * @throws std::invalid_argument if the file cannot be written
+     */
+    void save(const std::string& filename) const;
+
+private:
+    const unsigned char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<std::uint64_t> buffer_;  ///< Contents when not mapped
+
+    ModelFile() = default;
+    void check(std::uint32_t kind, std::uint32_t version) const;
+    const void* sectionBytes(std::size_t index, std::size_t valueSize, std::size_t& bytes) const;
+};
+
+} // namespace utils
+} // namespace smart_food
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "smart_food/utils/fingerprint.hpp"
+
+namespace smart_food {
+namespace utils {
+
+/**
+ * @brief Bounded, thread-safe cache of computed results keyed by fingerprint.
+ *
+ * Entries are spread over independently locked shards, each evicting its
+ * least recently used entry when full, so concurrent lookups of different
+ * keys rarely contend. Values are shared immutable objects: a hit copies a
+ * pointer under the shard lock and nothing else.
+ *
+ * Every entry remembers the data version it was computed against (for
+ * example core::Storage::getVersion()). A lookup with a newer version treats
+ * older entries as misses and drops them, so a change to the underlying
+ * data invalidates every result without walking the cache.
+ *
+ * @tparam Value Cached result type
+ */
+template <typename Value>
+class ResultCache {
+public:
+    /**
+     * @brief Hit and miss counters since construction
+     */
+    struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;      ///< Entries dropped to make room
+        std::uint64_t invalidations = 0;  ///< Entries dropped for being stale
+    };
+
+    // Constructors
+    /**
+     * @brief Create an empty cache
+     * @param capacity Maximum number of entries
+     * @param shards Number of independently locked shards
+     * @throws std::invalid_argument if capacity or shards is 0
+     */
+    explicit ResultCache(std::size_t capacity, std::size_t shards = 16) {
+        if (capacity == 0 || shards == 0) {
+            throw std::invalid_argument("Cache capacity and shard count must be positive");
+        }
+        shards = std::min(shards, capacity);
+        shards_ = std::vector<Shard>(shards);
+        for (std::size_t s = 0; s < shards; ++s) {
+            // Spread the capacity so the shards add up to it exactly
+            shards_[s].capacity = capacity / shards + (s < capacity % shards ? 1 : 0);
+        }
+    }
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    // Operations
+    /**
+     * @brief Look up a result
+     * @param key Fingerprint of the inputs
+     * @param version Current version of the underlying data
+     * @return The cached result, or nullptr if absent or computed against an
+     *         older version
+     */
+    std::shared_ptr<const Value> find(const Fingerprint& key, std::uint64_t version) {
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        if (it->second->version < version) {
+            shard.entries.erase(it->second);
+            shard.index.erase(it);
+            invalidations_.fetch_add(1, std::memory_order_relaxed);
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return it->second->value;
+    }
+
+    /**
+     * @brief Store a result, replacing any entry with the same key
+     * @param key Fingerprint of the inputs
+     * @param version Version of the data the result was computed against
+     * @param value The result
+     */
+    void insert(const Fingerprint& key, std::uint64_t version, std::shared_ptr<const Value> value) {
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            if (it->second->version > version) {
+                return;  // A result for newer data is already there
+            }
+            it->second->version = version;
+            it->second->value = std::move(value);
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return;
+        }
+        if (shard.entries.size() >= shard.capacity) {
+            shard.index.erase(shard.entries.back().key);
+            shard.entries.pop_back();
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        shard.entries.push_front(Entry{key, version, std::move(value)});
+        shard.index.emplace(key, shard.entries.begin());
+    }
+
+    /**
+     * @brief Drop every entry
+     */
+    void clear() {
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.entries.clear();
+            shard.index.clear();
+        }
+    }
+
+    // Getters
+    /**
+     * @brief Get the number of entries, stale ones included
+     */
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total += shard.entries.size();
+        }
+        return total;
+    }
+
+    /**
+     * @brief Get the hit and miss counters
+     */
+    Stats getStats() const {
+        Stats stats;
+        stats.hits = hits_.load(std::memory_order_relaxed);
+        stats.misses = misses_.load(std::memory_order_relaxed);
+        stats.evictions = evictions_.load(std::memory_order_relaxed);
+        stats.invalidations = invalidations_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct Entry {
+        Fingerprint key;
+        std::uint64_t version;
+        std::shared_ptr<const Value> value;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::size_t capacity = 0;
+        std::list<Entry> entries;  ///< Most recently used first
+        std::unordered_map<Fingerprint, typename std::list<Entry>::iterator> index;
+    };
+
+    std::vector<Shard> shards_;
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+    std::atomic<std::uint64_t> invalidations_{0};
+
+    Shard& shardOf(const Fingerprint& key) {
+        // The index hashes the low half; pick the shard from the high half
+        return shards_[key.high % shards_.size()];
+    }
+};
+
+} // namespace utils
+} // namespace smart_food
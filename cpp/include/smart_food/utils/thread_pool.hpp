@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace smart_food {
+namespace utils {
+
+/**
+ * @brief Fixed set of worker threads with per-worker task queues.
+ *
+ * Each worker owns a deque: it takes its own tasks from the back, and when
+ * the deque runs dry it steals from the front of the other workers' deques,
+ * so uneven tasks still keep every core busy. A thread waiting in
+ * parallelFor() runs queued tasks as well, which makes nested calls from
+ * inside a task safe.
+ */
+class ThreadPool {
+public:
+    // Constructors
+    /**
+     * @brief Start the workers
+     * @param threads Number of workers, 0 for one per hardware thread
+     */
+    explicit ThreadPool(std::size_t threads = 0);
+
+    /**
+     * @brief Finish the queued tasks and join the workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Getters
+    /**
+     * @brief Get the number of workers
+     */
+    std::size_t size() const;
+
+    // Operations
+    /**
+     * @brief Run body(i) for every i in [0, count) and wait for all of them
+     * @param count Number of tasks
+     * @param body Task body, called concurrently from several threads
+     * @throws The first exception thrown by a task, once every task has finished
+     */
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& body);
+
+    /**
+     * @brief Shared pool sized to the hardware, created on first use
+     */
+    static ThreadPool& shared();
+
+private:
+    using Task = std::function<void()>;
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<std::size_t> pending_{0};   ///< Tasks pushed but not yet taken
+    std::atomic<std::size_t> nextQueue_{0}; ///< Round-robin start for new batches
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+
+    void workerLoop(std::size_t index);
+    bool takeTask(std::size_t home, Task& task);
+};
+
+} // namespace utils
+} // namespace smart_food
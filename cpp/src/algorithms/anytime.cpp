@@ -0,0 +1,19 @@
+#include "smart_food/algorithms/anytime.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+CancellationToken::CancellationToken()
+    : cancelled_(std::make_shared<std::atomic<bool>>(false)) {
+}
+
+void CancellationToken::cancel() {
+    cancelled_->store(true, std::memory_order_release);
+}
+
+bool CancellationToken::isCancelled() const {
+    return cancelled_->load(std::memory_order_acquire);
+}
+
+} // namespace algorithms
+} // namespace smart_food
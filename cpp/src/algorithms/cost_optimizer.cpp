@@ -0,0 +1,264 @@
+#include "smart_food/algorithms/cost_optimizer.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+#include "smart_food/algorithms/ingredient_index.hpp"
+#include "smart_food/core/storage.hpp"
+#include "linear_program.hpp"
+#include "pack_knapsack.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+
+CostOptimizer::CostOptimizer()
+    : CostOptimizer(core::Storage::getInstance().getIngredients()) {
+}
+
+CostOptimizer::CostOptimizer(const std::vector<std::shared_ptr<core::Ingredient>>& ingredients) {
+    foods_.reserve(ingredients.size());
+    for (const auto& ingredient : ingredients) {
+        addIngredient(ingredient);
+    }
+}
+
+CostOptimizer::CostOptimizer(const std::vector<std::shared_ptr<core::Recipe>>& recipes) {
+    foods_.reserve(recipes.size());
+    for (const auto& recipe : recipes) {
+        addRecipe(recipe);
+    }
+}
+
+void CostOptimizer::addIngredient(const std::shared_ptr<core::Ingredient>& ingredient, double maxQuantity) {
+    if (!ingredient) {
+        throw std::invalid_argument("Cannot optimize with a null ingredient");
+    }
+    if (!(maxQuantity >= 0.0)) {
+        throw std::invalid_argument("Maximum quantity cannot be negative");
+    }
+    Food food{ingredient, nullptr, ingredient->getUnitPrice(), maxQuantity, {}};
+    const auto& info = ingredient->getNutritionalInfo();
+    if (!info.empty()) {
+        // Nutritional info describes the ingredient's whole quantity
+        const double quantity = ingredient->getQuantity();
+        if (!(quantity > 0.0)) {
+            throw std::invalid_argument("Ingredient needs a positive quantity to scale its nutrients: " +
+                                        ingredient->getName());
+        }
+        for (const auto& [nutrient, value] : info) {
+            food.nutrients.emplace(nutrient, value / quantity);
+        }
+    }
+    foods_.push_back(std::move(food));
+}
+
+void CostOptimizer::addRecipe(const std::shared_ptr<core::Recipe>& recipe, double maxServings) {
+    if (!recipe) {
+        throw std::invalid_argument("Cannot optimize with a null recipe");
+    }
+    if (!(maxServings >= 0.0)) {
+        throw std::invalid_argument("Maximum servings cannot be negative");
+    }
+    if (recipe->getServings() <= 0) {
+        throw std::invalid_argument("Recipe must have a positive number of servings: " + recipe->getName());
+    }
+    const double unitCost = recipe->calculateTotalCost() / recipe->getServings();
+    foods_.push_back(Food{nullptr, recipe, unitCost, maxServings, recipe->getNutritionalInfo()});
+}
+
+void CostOptimizer::addOffer(const core::PackOffer& offer) {
+    offers_.push_back(offer);
+}
+
+std::size_t CostOptimizer::applyPriceHistory(const core::PriceHistory& history) {
+    std::size_t repriced = detail::repriceOffers(offers_, history);
+    for (auto& food : foods_) {
+        if (!food.ingredient) {
+            continue;
+        }
+        const auto prices = history.latestPrices(food.ingredient->getName());
+        if (!prices.empty()) {
+            // The cheapest store comes first; one unit of the ingredient in base units
+            food.unitCost = prices.front().price * IngredientIndex::toBaseQuantity(1.0, food.ingredient->getUnit());
+            ++repriced;
+        }
+    }
+    return repriced;
+}
+
+void CostOptimizer::setCache(std::shared_ptr<Cache> cache) {
+    cache_ = std::move(cache);
+}
+
+std::size_t CostOptimizer::getFoodCount() const {
+    return foods_.size();
+}
+
+std::size_t CostOptimizer::getOfferCount() const {
+    return offers_.size();
+}
+
+CostOptimizer::Solution CostOptimizer::minimizeCost(const std::vector<NutrientTarget>& targets) const {
+    return minimizeCost(targets, Options());
+}
+
+CostOptimizer::Solution CostOptimizer::minimizeCost(const std::vector<NutrientTarget>& targets,
+                                                    const Options& options) const {
+    const auto start = std::chrono::steady_clock::now();
+    utils::Fingerprint key;
+    std::uint64_t version = 0;
+    if (cache_) {
+        key = requestKey(targets, options);
+        // Read before solving, so a concurrent Storage change leaves the entry stale
+        version = core::Storage::getInstance().getVersion();
+        if (auto cached = cache_->find(key, version)) {
+            Solution solution = *cached;
+            solution.solveTime =
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+            return solution;
+        }
+    }
+
+    detail::LinearProgram program;
+    std::unordered_map<std::string, std::uint32_t> rowOf;
+    for (const auto& target : targets) {
+        if (target.nutrient.empty()) {
+            throw std::invalid_argument("Nutrient target needs a name");
+        }
+        if (std::isnan(target.minimum) || std::isnan(target.maximum) || target.minimum > target.maximum) {
+            throw std::invalid_argument("Nutrient target minimum exceeds its maximum: " + target.nutrient);
+        }
+        if (!rowOf.emplace(target.nutrient, static_cast<std::uint32_t>(program.rows)).second) {
+            throw std::invalid_argument("Nutrient targeted twice: " + target.nutrient);
+        }
+        program.rowLower.push_back(target.minimum);
+        program.rowUpper.push_back(target.maximum);
+        ++program.rows;
+    }
+
+    // One column per food, holding only the targeted nutrients it provides
+    std::vector<std::pair<std::uint32_t, double>> entries;
+    for (const auto& food : foods_) {
+        entries.clear();
+        for (const auto& [nutrient, value] : food.nutrients) {
+            auto it = rowOf.find(nutrient);
+            if (it != rowOf.end()) {
+                entries.emplace_back(it->second, value);
+            }
+        }
+        program.addColumn(food.unitCost, food.maxAmount, entries);
+    }
+
+    const auto lp = detail::solveDualSimplex(program, options.maxIterations, options.tolerance);
+
+    Solution solution;
+    switch (lp.status) {
+    case detail::LinearSolution::Status::OPTIMAL:
+        solution.status = Status::OPTIMAL;
+        break;
+    case detail::LinearSolution::Status::INFEASIBLE:
+        solution.status = Status::INFEASIBLE;
+        break;
+    case detail::LinearSolution::Status::ITERATION_LIMIT:
+        solution.status = Status::ITERATION_LIMIT;
+        break;
+    }
+    solution.iterations = lp.iterations;
+    if (solution.status != Status::INFEASIBLE) {
+        for (std::size_t j = 0; j < foods_.size(); ++j) {
+            if (lp.x[j] > 0.0) {
+                const auto& food = foods_[j];
+                solution.purchases.push_back({food.ingredient, food.recipe, lp.x[j], food.unitCost * lp.x[j]});
+                solution.totalCost += food.unitCost * lp.x[j];
+            }
+        }
+        for (const auto& target : targets) {
+            const std::uint32_t row = rowOf.at(target.nutrient);
+            solution.nutrients[target.nutrient] = lp.activity[row];
+            solution.marginalCosts[target.nutrient] = lp.rowDual[row];
+        }
+    }
+    solution.solveTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    if (cache_) {
+        cache_->insert(key, version, std::make_shared<const Solution>(solution));
+    }
+    return solution;
+}
+
+CostOptimizer::PurchasePlan CostOptimizer::optimizePurchases(
+    const std::vector<std::shared_ptr<core::Ingredient>>& required) const {
+    const auto start = std::chrono::steady_clock::now();
+
+    // Total demand per ingredient identity, in base units
+    IngredientIndex index;
+    std::vector<double> demand;
+    for (const auto& ingredient : required) {
+        if (!ingredient) {
+            throw std::invalid_argument("Cannot buy a null ingredient");
+        }
+        const std::uint32_t id = index.intern(*ingredient);
+        if (id >= demand.size()) {
+            demand.resize(id + 1, 0.0);
+        }
+        demand[id] += IngredientIndex::baseQuantity(*ingredient);
+    }
+
+    std::vector<std::vector<const core::PackOffer*>> offersOf(index.size());
+    for (const auto& offer : offers_) {
+        const std::uint32_t id = index.find(offer.getIngredient(), IngredientIndex::dimensionOf(offer.getUnit()));
+        if (id != IngredientIndex::npos) {
+            offersOf[id].push_back(&offer);
+        }
+    }
+
+    PurchasePlan plan;
+    for (std::uint32_t id = 0; id < index.size(); ++id) {
+        if (!(demand[id] > 0.0)) {
+            continue;
+        }
+        const auto cover = detail::coverWithOffers(offersOf[id], demand[id]);
+        if (!cover.feasible) {
+            plan.feasible = false;
+            plan.uncovered.push_back(index.getName(id));
+            continue;
+        }
+        for (std::size_t i = 0; i < offersOf[id].size(); ++i) {
+            if (cover.packs[i] == 0) {
+                continue;
+            }
+            const auto& offer = *offersOf[id][i];
+            const int packs = static_cast<int>(cover.packs[i]);
+            const double cost = offer.priceFor(packs);
+            plan.purchases.push_back({offer, packs, packs * offer.getPackSize(), cost});
+            plan.totalCost += cost;
+            plan.storeCosts[offer.getStore()] += cost;
+        }
+    }
+    plan.solveTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    return plan;
+}
+
+utils::Fingerprint CostOptimizer::requestKey(const std::vector<NutrientTarget>& targets,
+                                             const Options& options) const {
+    // Foods are keyed by what was taken from them when added, plus the object they stand for
+    utils::FingerprintBuilder builder;
+    builder.add(static_cast<std::uint64_t>(foods_.size()));
+    for (const auto& food : foods_) {
+        builder.add(static_cast<bool>(food.ingredient));
+        builder.add(food.ingredient ? food.ingredient->getId() : food.recipe->getId());
+        builder.add(food.unitCost).add(food.maxAmount);
+        builder.add(static_cast<std::uint64_t>(food.nutrients.size()));
+        for (const auto& [nutrient, value] : food.nutrients) {
+            builder.add(nutrient).add(value);
+        }
+    }
+    builder.add(static_cast<std::uint64_t>(targets.size()));
+    for (const auto& target : targets) {
+        builder.add(target.nutrient).add(target.minimum).add(target.maximum);
+    }
+    builder.add(static_cast<std::uint64_t>(options.maxIterations)).add(options.tolerance);
+    return builder.finish();
+}
+
+} // namespace algorithms
+} // namespace smart_food
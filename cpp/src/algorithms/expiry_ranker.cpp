@@ -0,0 +1,312 @@
+#include "smart_food/algorithms/expiry_ranker.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+#include "smart_food/core/storage.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+
+constexpr std::uint32_t kNoBit = IngredientIndex::npos;
+
+int popcount(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    int n = 0;
+    for (; x != 0; x &= x - 1) {
+        ++n;
+    }
+    return n;
+#endif
+}
+
+int lowestBit(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int n = 0;
+    for (; !(x & 1); x >>= 1) {
+        ++n;
+    }
+    return n;
+#endif
+}
+
+/// Heap candidate; the heap keeps the worst kept match on top
+struct Candidate {
+    double value;
+    std::uint32_t count;
+    std::uint32_t row;
+};
+
+/// Whether a ranks before b
+bool better(const Candidate& a, const Candidate& b) {
+    if (a.value != b.value) {
+        return a.value > b.value;
+    }
+    if (a.count != b.count) {
+        return a.count > b.count;
+    }
+    return a.row < b.row;
+}
+
+} // namespace
+
+// Constructors
+ExpiryRanker::ExpiryRanker() {
+    refresh(Clock::now());
+}
+
+ExpiryRanker::ExpiryRanker(const std::vector<std::shared_ptr<core::Recipe>>& recipes) {
+    for (const auto& recipe : recipes) {
+        addRecipe(recipe);
+    }
+}
+
+// Setters
+void ExpiryRanker::addRecipe(const std::shared_ptr<core::Recipe>& recipe) {
+    if (!recipe) {
+        throw std::invalid_argument("Cannot rank a null recipe");
+    }
+    const auto ingredients = recipe->expandIngredients();
+    std::vector<std::uint32_t> identities;
+    identities.reserve(ingredients.size());
+    for (const auto& ingredient : ingredients) {
+        if (!ingredient) {
+            throw std::invalid_argument("Recipe has a null ingredient: " + recipe->getName());
+        }
+        identities.push_back(index_.intern(*ingredient));
+    }
+    std::sort(identities.begin(), identities.end());
+    identities.erase(std::unique(identities.begin(), identities.end()), identities.end());
+
+    removeRecipe(recipe->getId());
+    const auto row = static_cast<std::uint32_t>(recipes_.size());
+    recipesOf_.resize(index_.size());
+    bitOf_.resize(index_.size(), kNoBit);
+    recipes_.push_back(recipe);
+    bits_.resize(bits_.size() + words_, 0);
+    for (std::uint32_t id : identities) {
+        recipesOf_[id].push_back(row);
+        if (bitOf_[id] != kNoBit) {
+            setBit(row, bitOf_[id]);
+        }
+    }
+    identities_.push_back(std::move(identities));
+    rowOf_[recipe->getId()] = row;
+    ++alive_;
+}
+
+bool ExpiryRanker::removeRecipe(const std::string& recipeId) {
+    auto it = rowOf_.find(recipeId);
+    if (it == rowOf_.end()) {
+        return false;
+    }
+    // The row is retired rather than reused; postings to it are skipped
+    const std::uint32_t row = it->second;
+    recipes_[row] = nullptr;
+    identities_[row].clear();
+    identities_[row].shrink_to_fit();
+    std::fill_n(bits_.begin() + static_cast<std::ptrdiff_t>(row * words_), words_, 0);
+    rowOf_.erase(it);
+    --alive_;
+    return true;
+}
+
+void ExpiryRanker::setPantry(const std::vector<std::shared_ptr<core::Ingredient>>& pantry, Clock::time_point now,
+                             std::chrono::hours horizon) {
+    if (horizon.count() < 0) {
+        throw std::invalid_argument("Horizon cannot be negative");
+    }
+    horizon_ = horizon;
+
+    // Stocked identities that some recipe uses, and the value of their stock at risk
+    std::vector<std::uint32_t> stocked;
+    std::unordered_map<std::uint32_t, double> atRisk;
+    for (const auto& lot : pantry) {
+        if (!lot) {
+            throw std::invalid_argument("Pantry lot cannot be null");
+        }
+        const bool dated = lot->getExpiryDate() != Clock::time_point{};
+        if ((dated && lot->getExpiryDate() < now) || !(lot->getQuantity() > 0.0)) {
+            continue;
+        }
+        const std::uint32_t id = index_.find(*lot);
+        if (id == IngredientIndex::npos) {
+            continue;
+        }
+        stocked.push_back(id);
+        if (dated && lot->getExpiryDate() <= now + horizon) {
+            atRisk[id] += IngredientIndex::baseQuantity(*lot) * IngredientIndex::basePrice(*lot);
+        }
+    }
+    std::sort(stocked.begin(), stocked.end());
+    stocked.erase(std::unique(stocked.begin(), stocked.end()), stocked.end());
+
+    // Bits of identities no longer stocked linger until they outnumber the live ones
+    if (bitOwner_.size() > 64 && bitOwner_.size() > 2 * stocked.size()) {
+        rebuildBits(stocked);
+    } else {
+        for (std::uint32_t id : stocked) {
+            if (bitOf_[id] == kNoBit) {
+                assignBit(id);
+            }
+        }
+    }
+
+    weights_.assign(bitOwner_.size(), 0.0);
+    atRisk_.assign(words_, 0);
+    for (const auto& entry : atRisk) {
+        const std::uint32_t bit = bitOf_[entry.first];
+        weights_[bit] = entry.second;
+        atRisk_[bit / 64] |= std::uint64_t(1) << (bit % 64);
+    }
+}
+
+// Operations
+bool ExpiryRanker::refresh(Clock::time_point now) {
+    auto& storage = core::Storage::getInstance();
+    const std::uint64_t version = storage.getVersion();
+    const bool changed = version != version_;
+    if (changed) {
+        std::unordered_set<std::string> present;
+        for (const auto& recipe : storage.getRecipes()) {
+            present.insert(recipe->getId());
+            auto it = rowOf_.find(recipe->getId());
+            if (it == rowOf_.end() || recipes_[it->second] != recipe) {
+                addRecipe(recipe);
+            }
+        }
+        std::vector<std::string> gone;
+        for (const auto& entry : rowOf_) {
+            if (!present.count(entry.first)) {
+                gone.push_back(entry.first);
+            }
+        }
+        for (const auto& id : gone) {
+            removeRecipe(id);
+        }
+        version_ = version;
+    }
+    // Stock at risk moves with time even when Storage does not
+    setPantry(storage.getIngredients(), now, horizon_);
+    return changed;
+}
+
+std::vector<ExpiryRanker::Match> ExpiryRanker::rank(std::size_t limit) const {
+    std::vector<Match> matches;
+    if (limit == 0 || std::none_of(atRisk_.begin(), atRisk_.end(), [](std::uint64_t w) { return w != 0; })) {
+        return matches;
+    }
+
+    std::vector<Candidate> heap;
+    heap.reserve(limit + 1);
+    auto consider = [&](std::uint32_t row, const std::uint64_t* bits) {
+        double value = 0.0;
+        int count = 0;
+        for (std::size_t w = 0; w < words_; ++w) {
+            std::uint64_t hit = bits[w] & atRisk_[w];
+            count += popcount(hit);
+            for (; hit != 0; hit &= hit - 1) {
+                value += weights_[w * 64 + static_cast<std::size_t>(lowestBit(hit))];
+            }
+        }
+        const Candidate candidate{value, static_cast<std::uint32_t>(count), row};
+        if (heap.size() < limit) {
+            heap.push_back(candidate);
+            std::push_heap(heap.begin(), heap.end(), better);
+        } else if (better(candidate, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = candidate;
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+    };
+
+    const auto rows = static_cast<std::uint32_t>(recipes_.size());
+    if (words_ == 1) {
+        // One word per recipe: a plain AND scan that rejects most rows
+        const std::uint64_t mask = atRisk_[0];
+        for (std::uint32_t row = 0; row < rows; ++row) {
+            if (bits_[row] & mask) {
+                consider(row, &bits_[row]);
+            }
+        }
+    } else {
+        for (std::uint32_t row = 0; row < rows; ++row) {
+            const std::uint64_t* bits = &bits_[row * words_];
+            std::uint64_t any = 0;
+            for (std::size_t w = 0; w < words_; ++w) {
+                any |= bits[w] & atRisk_[w];
+            }
+            if (any) {
+                consider(row, bits);
+            }
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), better);
+    matches.reserve(heap.size());
+    for (const auto& candidate : heap) {
+        matches.push_back({recipes_[candidate.row], candidate.value, candidate.count});
+    }
+    return matches;
+}
+
+// Getters
+std::size_t ExpiryRanker::getRecipeCount() const {
+    return alive_;
+}
+
+std::size_t ExpiryRanker::getAtRiskCount() const {
+    std::size_t count = 0;
+    for (std::uint64_t word : atRisk_) {
+        count += static_cast<std::size_t>(popcount(word));
+    }
+    return count;
+}
+
+// Helpers
+void ExpiryRanker::setBit(std::uint32_t row, std::uint32_t bit) {
+    bits_[row * words_ + bit / 64] |= std::uint64_t(1) << (bit % 64);
+}
+
+std::uint32_t ExpiryRanker::assignBit(std::uint32_t identity) {
+    const auto bit = static_cast<std::uint32_t>(bitOwner_.size());
+    if (bit >= words_ * 64) {
+        // Widen every bitset, keeping the bits already set
+        const std::size_t words = 2 * words_;
+        std::vector<std::uint64_t> widened(recipes_.size() * words, 0);
+        for (std::size_t row = 0; row < recipes_.size(); ++row) {
+            std::copy_n(bits_.begin() + static_cast<std::ptrdiff_t>(row * words_), words_,
+                        widened.begin() + static_cast<std::ptrdiff_t>(row * words));
+        }
+        bits_ = std::move(widened);
+        words_ = words;
+    }
+    bitOwner_.push_back(identity);
+    bitOf_[identity] = bit;
+    for (std::uint32_t row : recipesOf_[identity]) {
+        if (recipes_[row]) {
+            setBit(row, bit);
+        }
+    }
+    return bit;
+}
+
+void ExpiryRanker::rebuildBits(const std::vector<std::uint32_t>& stocked) {
+    std::fill(bitOf_.begin(), bitOf_.end(), kNoBit);
+    bitOwner_.clear();
+    words_ = std::max<std::size_t>(1, (stocked.size() + 63) / 64);
+    bits_.assign(recipes_.size() * words_, 0);
+    for (std::uint32_t id : stocked) {
+        assignBit(id);
+    }
+}
+
+} // namespace algorithms
+} // namespace smart_food
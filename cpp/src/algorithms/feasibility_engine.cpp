@@ -0,0 +1,379 @@
+#include "smart_food/algorithms/feasibility_engine.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+#include "smart_food/core/storage.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+using Unit = core::Ingredient::Unit;
+
+/// Batches larger than this are indexed by rebuilding the columns
+constexpr std::size_t kRebuildBatch = 256;
+
+Unit baseUnit(IngredientIndex::Dimension dimension) {
+    switch (dimension) {
+        case IngredientIndex::Dimension::MASS:   return Unit::GRAM;
+        case IngredientIndex::Dimension::VOLUME: return Unit::MILLILITER;
+        case IngredientIndex::Dimension::COUNT:  return Unit::PIECE;
+    }
+    return Unit::PIECE;
+}
+
+void validateServings(int servings) {
+    if (servings < 0) {
+        throw std::invalid_argument("Servings cannot be negative");
+    }
+}
+
+} // namespace
+
+// Constructors
+FeasibilityEngine::FeasibilityEngine(int servings) : servings_(servings) {
+    validateServings(servings);
+    refresh(Clock::now());
+}
+
+FeasibilityEngine::FeasibilityEngine(const std::vector<std::shared_ptr<core::Recipe>>& recipes, int servings)
+    : servings_(servings) {
+    validateServings(servings);
+    addBatch(recipes);
+}
+
+// Setters
+void FeasibilityEngine::addRecipe(const std::shared_ptr<core::Recipe>& recipe) {
+    addBatch({recipe});
+}
+
+bool FeasibilityEngine::removeRecipe(const std::string& recipeId) {
+    auto it = rowOf_.find(recipeId);
+    if (it == rowOf_.end()) {
+        return false;
+    }
+    retireRow(it->second);
+    if (deadItems_ > liveItems_) {
+        rebuildColumns();
+    }
+    return true;
+}
+
+void FeasibilityEngine::setServings(int servings) {
+    validateServings(servings);
+    if (servings == servings_) {
+        return;
+    }
+    // Per-serving needs keep their order whatever the serving count, as-written ones do not
+    const bool reorder = (servings == 0) != (servings_ == 0);
+    servings_ = servings;
+    if (reorder) {
+        rebuildColumns();
+    } else {
+        recount();
+    }
+}
+
+void FeasibilityEngine::setPantry(const std::vector<std::shared_ptr<core::Ingredient>>& pantry,
+                                  Clock::time_point now) {
+    std::vector<std::pair<std::uint32_t, double>> lots;
+    lots.reserve(pantry.size());
+    for (const auto& lot : pantry) {
+        if (!lot) {
+            throw std::invalid_argument("Pantry lot cannot be null");
+        }
+        const auto expiry = lot->getExpiryDate();
+        if (expiry != Clock::time_point{} && expiry < now) {
+            continue;
+        }
+        lots.emplace_back(index_.intern(*lot), std::max(0.0, IngredientIndex::baseQuantity(*lot)));
+    }
+    columns_.resize(index_.size());
+    stock_.resize(index_.size(), 0.0);
+
+    std::vector<double> totals(index_.size(), 0.0);
+    for (const auto& lot : lots) {
+        totals[lot.first] += lot.second;
+    }
+    for (std::uint32_t id = 0; id < totals.size(); ++id) {
+        if (totals[id] != stock_[id]) {
+            setStock(id, totals[id]);
+        }
+    }
+}
+
+void FeasibilityEngine::addStock(const core::Ingredient& amount) {
+    const double quantity = IngredientIndex::baseQuantity(amount);
+    if (quantity < 0.0) {
+        throw std::invalid_argument("Stock quantity cannot be negative");
+    }
+    const std::uint32_t id = index_.intern(amount);
+    columns_.resize(index_.size());
+    stock_.resize(index_.size(), 0.0);
+    setStock(id, stock_[id] + quantity);
+}
+
+void FeasibilityEngine::removeStock(const core::Ingredient& amount) {
+    const double quantity = IngredientIndex::baseQuantity(amount);
+    if (quantity < 0.0) {
+        throw std::invalid_argument("Stock quantity cannot be negative");
+    }
+    const std::uint32_t id = index_.find(amount);
+    if (id != IngredientIndex::npos && id < stock_.size()) {
+        setStock(id, std::max(0.0, stock_[id] - quantity));
+    }
+}
+
+// Operations
+bool FeasibilityEngine::refresh(Clock::time_point now) {
+    auto& storage = core::Storage::getInstance();
+    const std::uint64_t version = storage.getVersion();
+    const bool changed = version != version_;
+    if (changed) {
+        std::unordered_set<std::string> present;
+        std::vector<std::shared_ptr<core::Recipe>> added;
+        for (const auto& recipe : storage.getRecipes()) {
+            present.insert(recipe->getId());
+            auto it = rowOf_.find(recipe->getId());
+            if (it == rowOf_.end() || recipes_[it->second] != recipe) {
+                added.push_back(recipe);
+            }
+        }
+        std::vector<std::string> gone;
+        for (const auto& entry : rowOf_) {
+            if (!present.count(entry.first)) {
+                gone.push_back(entry.first);
+            }
+        }
+        for (const auto& id : gone) {
+            removeRecipe(id);
+        }
+        addBatch(added);
+        version_ = version;
+    }
+    setPantry(storage.getIngredients(), now);
+    return changed;
+}
+
+std::vector<FeasibilityEngine::Result> FeasibilityEngine::evaluate() const {
+    std::vector<Result> results;
+    results.reserve(rowOf_.size());
+    for (std::uint32_t row = 0; row < recipes_.size(); ++row) {
+        if (recipes_[row]) {
+            results.push_back({recipes_[row], missing_[row] == 0, shortfallsOf(row)});
+        }
+    }
+    return results;
+}
+
+// Getters
+std::vector<std::shared_ptr<core::Recipe>> FeasibilityEngine::getCookable() const {
+    std::vector<std::shared_ptr<core::Recipe>> cookable;
+    for (std::uint32_t row = 0; row < recipes_.size(); ++row) {
+        if (recipes_[row] && missing_[row] == 0) {
+            cookable.push_back(recipes_[row]);
+        }
+    }
+    return cookable;
+}
+
+bool FeasibilityEngine::isCookable(const std::string& recipeId) const {
+    return missing_[rowOf(recipeId)] == 0;
+}
+
+std::vector<FeasibilityEngine::Shortfall> FeasibilityEngine::getShortfalls(const std::string& recipeId) const {
+    return shortfallsOf(rowOf(recipeId));
+}
+
+double FeasibilityEngine::getStock(const std::string& name, Unit unit) const {
+    const std::uint32_t id = index_.find(name, IngredientIndex::dimensionOf(unit));
+    return id < stock_.size() ? stock_[id] : 0.0;
+}
+
+int FeasibilityEngine::getServings() const {
+    return servings_;
+}
+
+std::size_t FeasibilityEngine::getRecipeCount() const {
+    return rowOf_.size();
+}
+
+// Helpers
+void FeasibilityEngine::addBatch(const std::vector<std::shared_ptr<core::Recipe>>& recipes) {
+    // Validate the whole batch before changing anything
+    std::vector<std::vector<Item>> items;
+    items.reserve(recipes.size());
+    for (const auto& recipe : recipes) {
+        if (!recipe) {
+            throw std::invalid_argument("Cannot check a null recipe");
+        }
+        items.push_back(itemsOf(*recipe));
+    }
+    columns_.resize(index_.size());
+    stock_.resize(index_.size(), 0.0);
+
+    const bool rebuild = recipes.size() > kRebuildBatch;
+    for (std::size_t r = 0; r < recipes.size(); ++r) {
+        auto it = rowOf_.find(recipes[r]->getId());
+        if (it != rowOf_.end()) {
+            retireRow(it->second);
+        }
+        const auto row = static_cast<std::uint32_t>(recipes_.size());
+        recipes_.push_back(recipes[r]);
+        items_.push_back(std::move(items[r]));
+        written_.push_back(std::max(1, recipes[r]->getServings()));
+        missing_.push_back(0);
+        rowOf_[recipes[r]->getId()] = row;
+        liveItems_ += items_[row].size();
+        if (!rebuild) {
+            indexRow(row);
+        }
+    }
+    if (rebuild || deadItems_ > liveItems_) {
+        rebuildColumns();
+    }
+}
+
+std::vector<FeasibilityEngine::Item> FeasibilityEngine::itemsOf(const core::Recipe& recipe) {
+    const auto ingredients = recipe.expandIngredients();
+    std::vector<Item> items;
+    items.reserve(ingredients.size());
+    for (const auto& ingredient : ingredients) {
+        if (!ingredient) {
+            throw std::invalid_argument("Recipe has a null ingredient: " + recipe.getName());
+        }
+        items.push_back({index_.intern(*ingredient), std::max(0.0, IngredientIndex::baseQuantity(*ingredient))});
+    }
+    // The same identity listed twice is needed in total
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.id < b.id; });
+    std::size_t kept = 0;
+    for (const auto& item : items) {
+        if (kept > 0 && items[kept - 1].id == item.id) {
+            items[kept - 1].quantity += item.quantity;
+        } else {
+            items[kept++] = item;
+        }
+    }
+    items.resize(kept);
+    return items;
+}
+
+void FeasibilityEngine::retireRow(std::uint32_t row) {
+    // The row is retired rather than reused; its column entries linger until the next rebuild
+    rowOf_.erase(recipes_[row]->getId());
+    recipes_[row] = nullptr;
+    liveItems_ -= items_[row].size();
+    deadItems_ += items_[row].size();
+}
+
+void FeasibilityEngine::indexRow(std::uint32_t row) {
+    for (const auto& item : items_[row]) {
+        auto& column = columns_[item.id];
+        const double value = need(row, item);
+        const auto at = std::upper_bound(column.need.begin(), column.need.end(), value) - column.need.begin();
+        column.need.insert(column.need.begin() + at, value);
+        column.rows.insert(column.rows.begin() + at, row);
+        if (value > threshold(stock_[item.id])) {
+            ++missing_[row];
+        }
+    }
+}
+
+void FeasibilityEngine::rebuildColumns() {
+    // Gather the live entries per identity, then sort each column by need
+    std::vector<std::vector<std::pair<double, std::uint32_t>>> entries(index_.size());
+    for (std::uint32_t row = 0; row < recipes_.size(); ++row) {
+        if (!recipes_[row]) {
+            items_[row].clear();
+            items_[row].shrink_to_fit();
+            continue;
+        }
+        for (const auto& item : items_[row]) {
+            entries[item.id].emplace_back(need(row, item), row);
+        }
+    }
+    columns_.assign(index_.size(), Column{});
+    for (std::size_t id = 0; id < entries.size(); ++id) {
+        auto& column = entries[id];
+        std::sort(column.begin(), column.end());
+        columns_[id].need.reserve(column.size());
+        columns_[id].rows.reserve(column.size());
+        for (const auto& entry : column) {
+            columns_[id].need.push_back(entry.first);
+            columns_[id].rows.push_back(entry.second);
+        }
+    }
+    deadItems_ = 0;
+    recount();
+}
+
+void FeasibilityEngine::recount() {
+    // Every column splits at its stock level; the entries past the split are short
+    std::fill(missing_.begin(), missing_.end(), 0);
+    for (std::size_t id = 0; id < columns_.size(); ++id) {
+        const auto& column = columns_[id];
+        const auto split = std::upper_bound(column.need.begin(), column.need.end(), threshold(stock_[id])) -
+                           column.need.begin();
+        for (std::size_t k = static_cast<std::size_t>(split); k < column.rows.size(); ++k) {
+            ++missing_[column.rows[k]];
+        }
+    }
+}
+
+void FeasibilityEngine::setStock(std::uint32_t id, double stock) {
+    // Only the entries needing between the old and the new stock change side
+    const auto& column = columns_[id];
+    const auto before = std::upper_bound(column.need.begin(), column.need.end(), threshold(stock_[id]));
+    const auto after = std::upper_bound(column.need.begin(), column.need.end(), threshold(stock));
+    if (after < before) {
+        for (auto k = after - column.need.begin(); k < before - column.need.begin(); ++k) {
+            ++missing_[column.rows[static_cast<std::size_t>(k)]];
+        }
+    } else {
+        for (auto k = before - column.need.begin(); k < after - column.need.begin(); ++k) {
+            --missing_[column.rows[static_cast<std::size_t>(k)]];
+        }
+    }
+    stock_[id] = stock;
+}
+
+double FeasibilityEngine::need(std::uint32_t row, const Item& item) const {
+    return servings_ == 0 ? item.quantity : item.quantity / written_[row];
+}
+
+double FeasibilityEngine::threshold(double stock) const {
+    // Relative slack so that stock equal to the need after unit conversion still covers it
+    const double level = servings_ == 0 ? stock : stock / servings_;
+    return level * (1.0 + 1e-9) + 1e-12;
+}
+
+std::vector<FeasibilityEngine::Shortfall> FeasibilityEngine::shortfallsOf(std::uint32_t row) const {
+    std::vector<Shortfall> shortfalls;
+    if (missing_[row] == 0) {
+        return shortfalls;
+    }
+    const double scale = servings_ == 0 ? 1.0 : static_cast<double>(servings_) / written_[row];
+    for (const auto& item : items_[row]) {
+        if (need(row, item) > threshold(stock_[item.id])) {
+            shortfalls.push_back({index_.getName(item.id), baseUnit(index_.getDimension(item.id)),
+                                  item.quantity * scale - stock_[item.id]});
+        }
+    }
+    std::sort(shortfalls.begin(), shortfalls.end(),
+              [](const Shortfall& a, const Shortfall& b) { return a.ingredient < b.ingredient; });
+    return shortfalls;
+}
+
+std::uint32_t FeasibilityEngine::rowOf(const std::string& recipeId) const {
+    auto it = rowOf_.find(recipeId);
+    if (it == rowOf_.end()) {
+        throw std::out_of_range("Unknown recipe: " + recipeId);
+    }
+    return it->second;
+}
+
+} // namespace algorithms
+} // namespace smart_food
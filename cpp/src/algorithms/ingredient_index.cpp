@@ -0,0 +1,120 @@
+#include "smart_food/algorithms/ingredient_index.hpp"
+#include <cctype>
+#include <stdexcept>
+
+namespace smart_food {
+namespace algorithms {
+
+std::uint32_t IngredientIndex::intern(const core::Ingredient& ingredient) {
+    return intern(ingredient.getName(), dimensionOf(ingredient.getUnit()));
+}
+
+std::uint32_t IngredientIndex::intern(const std::string& name, Dimension dimension) {
+    std::string normalized = normalizeName(name);
+    if (normalized.empty()) {
+        throw std::invalid_argument("Ingredient name cannot be empty");
+    }
+
+    auto [it, inserted] = ids_.emplace(makeKey(normalized, dimension),
+                                       static_cast<std::uint32_t>(names_.size()));
+    if (inserted) {
+        names_.push_back(std::move(normalized));
+        dimensions_.push_back(dimension);
+    }
+    return it->second;
+}
+
+std::uint32_t IngredientIndex::find(const core::Ingredient& ingredient) const {
+    return find(ingredient.getName(), dimensionOf(ingredient.getUnit()));
+}
+
+std::uint32_t IngredientIndex::find(const std::string& name, Dimension dimension) const {
+    auto it = ids_.find(makeKey(normalizeName(name), dimension));
+    return it != ids_.end() ? it->second : npos;
+}
+
+std::size_t IngredientIndex::size() const {
+    return names_.size();
+}
+
+const std::string& IngredientIndex::getName(std::uint32_t id) const {
+    return names_.at(id);
+}
+
+IngredientIndex::Dimension IngredientIndex::getDimension(std::uint32_t id) const {
+    return dimensions_.at(id);
+}
+
+std::string IngredientIndex::normalizeName(const std::string& name) {
+    std::string normalized;
+    normalized.reserve(name.size());
+
+    bool pendingSpace = false;
+    for (unsigned char c : name) {
+        if (std::isspace(c)) {
+            pendingSpace = !normalized.empty();
+            continue;
+        }
+        if (pendingSpace) {
+            normalized.push_back(' ');
+            pendingSpace = false;
+        }
+        normalized.push_back(static_cast<char>(std::tolower(c)));
+    }
+    return normalized;
+}
+
+IngredientIndex::Dimension IngredientIndex::dimensionOf(core::Ingredient::Unit unit) {
+    using Unit = core::Ingredient::Unit;
+    switch (unit) {
+        case Unit::GRAM:
+        case Unit::KILOGRAM:
+        case Unit::OUNCE:
+        case Unit::POUND:
+            return Dimension::MASS;
+        case Unit::MILLILITER:
+        case Unit::LITER:
+        case Unit::TEASPOON:
+        case Unit::TABLESPOON:
+        case Unit::CUP:
+            return Dimension::VOLUME;
+        case Unit::PIECE:
+            return Dimension::COUNT;
+    }
+    throw std::invalid_argument("Unknown unit");
+}
+
+double IngredientIndex::toBaseQuantity(double value, core::Ingredient::Unit unit) {
+    using Unit = core::Ingredient::Unit;
+    switch (unit) {
+        case Unit::GRAM:       return value;
+        case Unit::KILOGRAM:   return value * 1000.0;
+        case Unit::OUNCE:      return value * 28.349523125;
+        case Unit::POUND:      return value * 453.59237;
+        case Unit::MILLILITER: return value;
+        case Unit::LITER:      return value * 1000.0;
+        case Unit::TEASPOON:   return value * 4.92892159375;
+        case Unit::TABLESPOON: return value * 14.78676478125;
+        case Unit::CUP:        return value * 236.5882365;
+        case Unit::PIECE:      return value;
+    }
+    throw std::invalid_argument("Unknown unit");
+}
+
+double IngredientIndex::baseQuantity(const core::Ingredient& ingredient) {
+    return toBaseQuantity(ingredient.getQuantity(), ingredient.getUnit());
+}
+
+double IngredientIndex::basePrice(const core::Ingredient& ingredient) {
+    return ingredient.getUnitPrice() / toBaseQuantity(1.0, ingredient.getUnit());
+}
+
+std::string IngredientIndex::makeKey(const std::string& normalizedName, Dimension dimension) {
+    std::string key = normalizedName;
+    key.push_back('\x1f');
+    key.push_back(static_cast<char>('0' + static_cast<int>(dimension)));
+    return key;
+}
+
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,514 @@
+#include "smart_food/algorithms/kitchen_scheduler.hpp"
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <stdexcept>
+
+namespace smart_food {
+namespace algorithms {
+
+namespace {
+
+/// Exact search nodes between checks of the deadline and cancellation
+constexpr std::size_t kNodesPerCheck = 1024;
+
+/// Tasks of a batch with their dependencies and resource needs in flat arrays
+struct Instance {
+    std::size_t resourceCount = 0;
+    std::vector<int> capacity;    ///< Resource -> units available
+    std::vector<int> duration;    ///< Task -> minutes
+    std::vector<int> demand;      ///< (task, resource) -> units held
+    std::vector<std::vector<std::uint32_t>> predecessors;
+    std::vector<std::vector<std::uint32_t>> successors;
+    std::vector<std::uint32_t> order;  ///< Tasks in an order where dependencies come first
+    std::vector<int> tail;        ///< Task -> longest chain of work from its start to the end
+    int horizon = 0;              ///< Sum of the durations, no task of a list schedule ends later
+
+    std::size_t size() const { return duration.size(); }
+    const int* demandRow(std::size_t task) const { return demand.data() + task * resourceCount; }
+
+    void computeTails() {
+        tail.assign(size(), 0);
+        for (auto it = order.rbegin(); it != order.rend(); ++it) {
+            int longest = 0;
+            for (auto next : successors[*it]) {
+                longest = std::max(longest, tail[next]);
+            }
+            tail[*it] = duration[*it] + longest;
+        }
+    }
+
+    /// The same tasks with every dependency reversed, for scheduling backward from the end
+    Instance reversed() const {
+        Instance mirror = *this;
+        std::swap(mirror.predecessors, mirror.successors);
+        std::reverse(mirror.order.begin(), mirror.order.end());
+        mirror.computeTails();
+        return mirror;
+    }
+};
+
+/// Resource use per minute
+class Profile {
+public:
+    explicit Profile(const Instance& instance)
+        : instance_(instance)
+        , usage_(instance.resourceCount, std::vector<int>(static_cast<std::size_t>(instance.horizon) + 1, 0)) {
+    }
+
+    /// Earliest minute from `from` on at which the task's resources stay free for its whole duration
+    int earliestStart(std::size_t task, int from) const {
+        const int length = instance_.duration[task];
+        const int* need = instance_.demandRow(task);
+        int start = from;
+        for (bool moved = true; moved;) {
+            moved = false;
+            for (std::size_t r = 0; r < instance_.resourceCount && !moved; ++r) {
+                if (need[r] == 0) {
+                    continue;
+                }
+                const int limit = instance_.capacity[r] - need[r];
+                const auto& used = usage_[r];
+                for (int m = start; m < start + length; ++m) {
+                    if (used[m] > limit) {
+                        start = m + 1;
+                        moved = true;
+                        break;
+                    }
+                }
+            }
+        }
+        return start;
+    }
+
+    /// Take (sign 1) or give back (sign -1) the task's resources from `start` on
+    void hold(std::size_t task, int start, int sign) {
+        const int* need = instance_.demandRow(task);
+        const int end = start + instance_.duration[task];
+        for (std::size_t r = 0; r < instance_.resourceCount; ++r) {
+            if (need[r] != 0) {
+                for (int m = start; m < end; ++m) {
+                    usage_[r][m] += sign * need[r];
+                }
+            }
+        }
+    }
+
+    void clear() {
+        for (auto& used : usage_) {
+            std::fill(used.begin(), used.end(), 0);
+        }
+    }
+
+private:
+    const Instance& instance_;
+    std::vector<std::vector<int>> usage_;  ///< Resource -> minute -> units held
+};
+
+/**
+ * Serial schedule generation: tasks whose dependencies are placed are taken
+ * lowest priority value first and placed at their earliest feasible minute.
+ * Returns the makespan.
+ */
+int serialSchedule(const Instance& instance, const std::vector<double>& priority, Profile& profile,
+                   std::vector<int>& start) {
+    const std::size_t n = instance.size();
+    profile.clear();
+    start.assign(n, 0);
+    std::vector<std::size_t> waiting(n);
+    std::vector<int> ready(n, 0);
+    using Entry = std::pair<double, std::uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> eligible;
+    for (std::size_t a = 0; a < n; ++a) {
+        waiting[a] = instance.predecessors[a].size();
+        if (waiting[a] == 0) {
+            eligible.emplace(priority[a], static_cast<std::uint32_t>(a));
+        }
+    }
+
+    int makespan = 0;
+    while (!eligible.empty()) {
+        const std::uint32_t a = eligible.top().second;
+        eligible.pop();
+        start[a] = profile.earliestStart(a, ready[a]);
+        profile.hold(a, start[a], 1);
+        const int end = start[a] + instance.duration[a];
+        makespan = std::max(makespan, end);
+        for (auto next : instance.successors[a]) {
+            ready[next] = std::max(ready[next], end);
+            if (--waiting[next] == 0) {
+                eligible.emplace(priority[next], next);
+            }
+        }
+    }
+    return makespan;
+}
+
+/**
+ * Forward-backward improvement: right-justify the schedule by scheduling
+ * the reversed batch latest end first, then left-justify it again in order
+ * of the new start times, for as long as either pass shortens it.
+ */
+int improve(const Instance& forward, const Instance& backward, Profile& forwardProfile, Profile& backwardProfile,
+            std::vector<int>& start, int makespan) {
+    const std::size_t n = forward.size();
+    std::vector<double> priority(n);
+    std::vector<int> mirrored;
+    std::vector<int> candidate;
+    for (bool improved = true; improved;) {
+        improved = false;
+        for (std::size_t a = 0; a < n; ++a) {
+            priority[a] = -static_cast<double>(start[a] + forward.duration[a]);
+        }
+        const int back = serialSchedule(backward, priority, backwardProfile, mirrored);
+        for (std::size_t a = 0; a < n; ++a) {
+            mirrored[a] = back - mirrored[a] - forward.duration[a];
+            priority[a] = static_cast<double>(mirrored[a]);
+        }
+        if (back < makespan) {
+            start = mirrored;
+            makespan = back;
+            improved = true;
+        }
+        const int next = serialSchedule(forward, priority, forwardProfile, candidate);
+        if (next < makespan) {
+            start = candidate;
+            makespan = next;
+            improved = true;
+        }
+    }
+    return makespan;
+}
+
+/**
+ * Depth-first branch-and-bound over serial placement orders, where every
+ * task starts no earlier than the task placed before it. Placing the tasks
+ * of an optimal schedule by increasing start that way starts each of them
+ * no later than in that schedule, so an optimal schedule is reached.
+ */
+class ExactSearch {
+public:
+    using Improved = std::function<void(const std::vector<int>&, int)>;
+
+    ExactSearch(const Instance& instance, std::size_t maxNodes, const KitchenScheduler::Control& control,
+                const Improved& improved, std::vector<int>& best, int& bestMakespan)
+        : instance_(instance)
+        , maxNodes_(maxNodes)
+        , control_(control)
+        , improved_(improved)
+        , profile_(instance)
+        , best_(best)
+        , bestMakespan_(bestMakespan)
+        , start_(instance.size(), -1)
+        , ready_(instance.size(), 0)
+        , waiting_(instance.size())
+        , earliest_(instance.size(), 0)
+        , remaining_(instance.resourceCount, 0) {
+        for (std::size_t a = 0; a < instance.size(); ++a) {
+            waiting_[a] = instance.predecessors[a].size();
+            for (std::size_t r = 0; r < instance.resourceCount; ++r) {
+                remaining_[r] += instance.duration[a] * instance.demandRow(a)[r];
+            }
+        }
+    }
+
+    /// Returns true if the search completed, proving the best schedule optimal
+    bool run() {
+        visit(0, 0, 0);
+        return !aborted_;
+    }
+
+    std::size_t nodes() const { return nodes_; }
+
+private:
+    const Instance& instance_;
+    const std::size_t maxNodes_;
+    const KitchenScheduler::Control& control_;
+    const Improved& improved_;
+    Profile profile_;
+    std::vector<int>& best_;
+    int& bestMakespan_;
+    std::vector<int> start_;     ///< Task -> start, -1 while unplaced
+    std::vector<int> ready_;     ///< Task -> end of its latest placed dependency
+    std::vector<std::size_t> waiting_;
+    std::vector<int> earliest_;  ///< Scratch: task -> earliest start by dependencies
+    std::vector<int> remaining_; ///< Resource -> unit-minutes still to place
+    std::size_t nodes_ = 0;
+    bool aborted_ = false;
+
+    /// Least makespan of any completion whose tasks start at `floor` or later
+    int bound(int makespan, int floor) {
+        int result = makespan;
+        for (auto a : instance_.order) {
+            if (start_[a] >= 0) {
+                continue;
+            }
+            int earliest = std::max(ready_[a], floor);
+            for (auto before : instance_.predecessors[a]) {
+                if (start_[before] < 0) {
+                    earliest = std::max(earliest, earliest_[before] + instance_.duration[before]);
+                }
+            }
+            earliest_[a] = earliest;
+            result = std::max(result, earliest + instance_.tail[a]);
+        }
+        for (std::size_t r = 0; r < instance_.resourceCount; ++r) {
+            if (remaining_[r] > 0) {
+                const int capacity = instance_.capacity[r];
+                result = std::max(result, floor + (remaining_[r] + capacity - 1) / capacity);
+            }
+        }
+        return result;
+    }
+
+    void visit(std::size_t placed, int makespan, int lastStart) {
+        if (aborted_) {
+            return;
+        }
+        if (++nodes_ > maxNodes_ || (nodes_ % kNodesPerCheck == 0 && control_.shouldStop())) {
+            aborted_ = true;
+            return;
+        }
+        if (placed == instance_.size()) {
+            if (makespan < bestMakespan_) {
+                bestMakespan_ = makespan;
+                best_ = start_;
+                if (improved_) {
+                    improved_(best_, bestMakespan_);
+                }
+            }
+            return;
+        }
+        if (bound(makespan, lastStart) >= bestMakespan_) {
+            return;
+        }
+
+        std::vector<int> saved;
+        for (std::size_t a = 0; a < instance_.size(); ++a) {
+            if (start_[a] >= 0 || waiting_[a] != 0) {
+                continue;
+            }
+            const int start = profile_.earliestStart(a, std::max(ready_[a], lastStart));
+            const int end = start + instance_.duration[a];
+            start_[a] = start;
+            profile_.hold(a, start, 1);
+            for (std::size_t r = 0; r < instance_.resourceCount; ++r) {
+                remaining_[r] -= instance_.duration[a] * instance_.demandRow(a)[r];
+            }
+            saved.clear();
+            for (auto next : instance_.successors[a]) {
+                saved.push_back(ready_[next]);
+                ready_[next] = std::max(ready_[next], end);
+                --waiting_[next];
+            }
+
+            visit(placed + 1, std::max(makespan, end), start);
+
+            for (std::size_t i = instance_.successors[a].size(); i-- > 0;) {
+                const auto next = instance_.successors[a][i];
+                ready_[next] = saved[i];
+                ++waiting_[next];
+            }
+            for (std::size_t r = 0; r < instance_.resourceCount; ++r) {
+                remaining_[r] += instance_.duration[a] * instance_.demandRow(a)[r];
+            }
+            profile_.hold(a, start, -1);
+            start_[a] = -1;
+            if (aborted_) {
+                return;
+            }
+        }
+    }
+};
+
+} // namespace
+
+KitchenScheduler::KitchenScheduler(std::map<std::string, int> capacities)
+    : capacities_(std::move(capacities)) {
+    for (const auto& resource : capacities_) {
+        if (resource.second < 0) {
+            throw std::invalid_argument("Kitchen cannot have a negative amount of " + resource.first);
+        }
+    }
+}
+
+const std::map<std::string, int>& KitchenScheduler::getCapacities() const {
+    return capacities_;
+}
+
+KitchenScheduler::Timeline KitchenScheduler::schedule(const std::vector<std::shared_ptr<core::Recipe>>& batch) const {
+    return schedule(batch, Options());
+}
+
+KitchenScheduler::Timeline KitchenScheduler::schedule(const std::vector<std::shared_ptr<core::Recipe>>& batch,
+                                                      const Options& options) const {
+    return schedule(batch, options, Control());
+}
+
+KitchenScheduler::Timeline KitchenScheduler::schedule(const std::vector<std::shared_ptr<core::Recipe>>& batch,
+                                                      const Options& options, const Control& control) const {
+    Instance instance;
+    std::map<std::string, std::size_t> resourceIndex;
+    for (const auto& resource : capacities_) {
+        resourceIndex.emplace(resource.first, instance.capacity.size());
+        instance.capacity.push_back(resource.second);
+    }
+    instance.resourceCount = instance.capacity.size();
+
+    // Tasks follow the batch and then the step order, so dependencies always come first
+    std::vector<std::pair<std::size_t, std::size_t>> origin;  // task -> (batch position, step position)
+    for (std::size_t b = 0; b < batch.size(); ++b) {
+        if (!batch[b]) {
+            throw std::invalid_argument("Cannot schedule a null recipe");
+        }
+        const auto& steps = batch[b]->getSteps();
+        const std::uint32_t first = static_cast<std::uint32_t>(instance.size());
+        for (std::size_t i = 0; i < steps.size(); ++i) {
+            const std::uint32_t task = static_cast<std::uint32_t>(instance.size());
+            origin.emplace_back(b, i);
+            instance.duration.push_back(static_cast<int>(steps[i].duration.count()));
+            instance.horizon += instance.duration.back();
+            instance.demand.resize(instance.demand.size() + instance.resourceCount, 0);
+            int* need = instance.demand.data() + static_cast<std::size_t>(task) * instance.resourceCount;
+
+            const auto& resources = steps[i].resources.empty() ? options.defaultResources : steps[i].resources;
+            for (const auto& resource : resources) {
+                auto found = resourceIndex.find(resource.first);
+                if (found == resourceIndex.end()) {
+                    if (steps[i].resources.empty()) {
+                        continue;  // The kitchen does without this default resource
+                    }
+                    throw std::invalid_argument("Kitchen has no " + resource.first + " for " +
+                                                batch[b]->getName());
+                }
+                if (resource.second > instance.capacity[found->second]) {
+                    throw std::invalid_argument("Kitchen has too little " + resource.first + " for " +
+                                                batch[b]->getName());
+                }
+                need[found->second] = resource.second;
+            }
+
+            instance.predecessors.emplace_back();
+            instance.successors.emplace_back();
+            for (auto dependency : batch[b]->getStepDependencies(i)) {
+                const std::uint32_t before = first + static_cast<std::uint32_t>(dependency);
+                instance.predecessors[task].push_back(before);
+                instance.successors[before].push_back(task);
+            }
+            instance.order.push_back(task);
+        }
+    }
+    instance.computeTails();
+    const Instance backward = instance.reversed();
+    const std::size_t n = instance.size();
+
+    // Lower bound: the longest dependency chain, and the work each resource must carry
+    int lowerBound = 0;
+    for (std::size_t a = 0; a < n; ++a) {
+        lowerBound = std::max(lowerBound, instance.tail[a]);
+    }
+    for (std::size_t r = 0; r < instance.resourceCount; ++r) {
+        long long work = 0;
+        for (std::size_t a = 0; a < n; ++a) {
+            work += static_cast<long long>(instance.duration[a]) * instance.demandRow(a)[r];
+        }
+        if (work > 0) {
+            const int capacity = instance.capacity[r];
+            lowerBound = std::max(lowerBound, static_cast<int>((work + capacity - 1) / capacity));
+        }
+    }
+
+    auto toTimeline = [&](const std::vector<int>& starts, int makespan) {
+        Timeline timeline;
+        timeline.finish.assign(batch.size(), std::chrono::minutes(0));
+        for (std::size_t a = 0; a < n; ++a) {
+            const auto startTime = std::chrono::minutes(starts[a]);
+            const auto endTime = std::chrono::minutes(starts[a] + instance.duration[a]);
+            timeline.steps.push_back({origin[a].first, origin[a].second, startTime, endTime});
+            timeline.finish[origin[a].first] = std::max(timeline.finish[origin[a].first], endTime);
+        }
+        std::sort(timeline.steps.begin(), timeline.steps.end(), [](const ScheduledStep& a, const ScheduledStep& b) {
+            if (a.start != b.start) {
+                return a.start < b.start;
+            }
+            return a.recipe != b.recipe ? a.recipe < b.recipe : a.step < b.step;
+        });
+        timeline.makespan = std::chrono::minutes(makespan);
+        timeline.lowerBound = std::chrono::minutes(std::min(lowerBound, makespan));
+        return timeline;
+    };
+    // Publish every shorter timeline, as it is found
+    ExactSearch::Improved improved;
+    if (control.channel) {
+        control.channel->raiseLowerBound(lowerBound);
+        improved = [&](const std::vector<int>& starts, int makespan) {
+            if (control.channel->improves(makespan)) {
+                control.channel->offer(makespan, toTimeline(starts, makespan));
+            }
+        };
+    }
+
+    Profile forwardProfile(instance);
+    Profile backwardProfile(backward);
+    std::vector<double> priority(n);
+    std::vector<int> best;
+    std::vector<int> start;
+
+    // Longest remaining chain first, then randomized variants of it
+    for (std::size_t a = 0; a < n; ++a) {
+        priority[a] = -static_cast<double>(instance.tail[a]);
+    }
+    int bestMakespan = serialSchedule(instance, priority, forwardProfile, best);
+    bestMakespan = improve(instance, backward, forwardProfile, backwardProfile, best, bestMakespan);
+    if (improved) {
+        control.channel->addIterations(1);
+        improved(best, bestMakespan);
+    }
+
+    std::mt19937_64 rng(options.seed);
+    std::uniform_real_distribution<double> noise(0.5, 1.5);
+    for (std::size_t sample = 0; sample < options.samples && bestMakespan > lowerBound && !control.shouldStop();
+         ++sample) {
+        for (std::size_t a = 0; a < n; ++a) {
+            priority[a] = -static_cast<double>(instance.tail[a]) * noise(rng);
+        }
+        int makespan = serialSchedule(instance, priority, forwardProfile, start);
+        makespan = improve(instance, backward, forwardProfile, backwardProfile, start, makespan);
+        if (makespan < bestMakespan) {
+            bestMakespan = makespan;
+            best = start;
+            if (improved) {
+                improved(best, bestMakespan);
+            }
+        }
+        if (control.channel) {
+            control.channel->addIterations(1);
+        }
+    }
+
+    bool optimal = bestMakespan <= lowerBound;
+    if (!optimal && n <= options.exactSteps && !control.shouldStop()) {
+        ExactSearch search(instance, options.maxNodes, control, improved, best, bestMakespan);
+        optimal = search.run();
+        if (control.channel) {
+            control.channel->addIterations(search.nodes());
+        }
+    }
+
+    Timeline timeline = toTimeline(best, bestMakespan);
+    timeline.optimal = optimal;
+    if (optimal) {
+        timeline.lowerBound = timeline.makespan;
+    }
+    if (control.channel) {
+        control.channel->offer(bestMakespan, timeline);
+        control.channel->raiseLowerBound(timeline.lowerBound.count());
+        control.channel->finish();
+    }
+    return timeline;
+}
+
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,502 @@
+#include "linear_program.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+void LinearProgram::addColumn(double columnCost, double upper,
+                              const std::vector<std::pair<std::uint32_t, double>>& entries) {
+    for (const auto& entry : entries) {
+        if (entry.first >= rows) {
+            throw std::out_of_range("Column entry refers to a missing row");
+        }
+        if (entry.second != 0.0) {
+            rowIndex.push_back(entry.first);
+            value.push_back(entry.second);
+        }
+    }
+    cost.push_back(columnCost);
+    columnUpper.push_back(upper);
+    columnBegin.push_back(rowIndex.size());
+    ++columns;
+}
+
+namespace {
+
+constexpr std::size_t kRefactorInterval = 64;  ///< Pivots between two fresh inversions of the basis
+constexpr double kPivotTolerance = 1e-9;       ///< Smallest pivot row entry considered nonzero
+constexpr std::size_t kNotBasic = static_cast<std::size_t>(-1);
+
+enum class State : std::uint8_t {
+    BASIC,
+    LOWER,  ///< Nonbasic at its lower bound
+    UPPER   ///< Nonbasic at its upper bound
+};
+
+/**
+ * Bounded dual simplex over the columns of a LinearProgram followed by one
+ * slack per row. Slack i has column -e_i and the bounds of row i, so the
+ * constraints read A x - s = 0.
+ */
+class DualSimplex {
+public:
+    DualSimplex(const LinearProgram& problem, double tolerance)
+        : problem_(problem)
+        , m_(problem.rows)
+        , n_(problem.columns)
+        , tolerance_(tolerance)
+        , rowScale_(m_, 1.0)
+        , scaled_(problem.value.size())
+        , cost_(n_ + m_, 0.0)
+        , lower_(n_ + m_, 0.0)
+        , upper_(n_ + m_, 0.0)
+        , state_(n_ + m_, State::LOWER)
+        , sign_(n_ + m_, 1.0)
+        , x_(n_ + m_, 0.0)
+        , d_(n_ + m_, 0.0)
+        , basis_(m_)
+        , binv_(m_ * m_, 0.0)
+        , rho_(m_)
+        , alphaRow_(n_ + m_, 0.0)
+        , alphaColumn_(m_) {
+        // Scale rows to unit maximum coefficient and costs to unit maximum
+        std::vector<double> rowMax(m_, 0.0);
+        for (std::size_t k = 0; k < problem.value.size(); ++k) {
+            rowMax[problem.rowIndex[k]] = std::max(rowMax[problem.rowIndex[k]], std::abs(problem.value[k]));
+        }
+        for (std::size_t i = 0; i < m_; ++i) {
+            if (rowMax[i] > 0.0) {
+                rowScale_[i] = 1.0 / rowMax[i];
+            }
+        }
+        for (std::size_t k = 0; k < problem.value.size(); ++k) {
+            scaled_[k] = problem.value[k] * rowScale_[problem.rowIndex[k]];
+        }
+        // Row-wise copy for pricing
+        rowBegin_.assign(m_ + 1, 0);
+        for (auto row : problem.rowIndex) {
+            ++rowBegin_[row + 1];
+        }
+        for (std::size_t i = 0; i < m_; ++i) {
+            rowBegin_[i + 1] += rowBegin_[i];
+        }
+        rowColumn_.resize(scaled_.size());
+        rowValue_.resize(scaled_.size());
+        std::vector<std::size_t> next(rowBegin_.begin(), rowBegin_.end() - 1);
+        for (std::size_t j = 0; j < n_; ++j) {
+            for (std::size_t k = problem.columnBegin[j]; k < problem.columnBegin[j + 1]; ++k) {
+                const std::size_t at = next[problem.rowIndex[k]]++;
+                rowColumn_[at] = static_cast<std::uint32_t>(j);
+                rowValue_[at] = scaled_[k];
+            }
+        }
+        double costMax = 0.0;
+        for (double c : problem.cost) {
+            costMax = std::max(costMax, std::abs(c));
+        }
+        costScale_ = costMax > 0.0 ? 1.0 / costMax : 1.0;
+
+        for (std::size_t j = 0; j < n_; ++j) {
+            cost_[j] = problem.cost[j] * costScale_;
+            upper_[j] = problem.columnUpper[j];
+            // Start every column at the bound its cost prefers, which is dual feasible
+            setState(j, cost_[j] < 0.0 ? State::UPPER : State::LOWER);
+            if (state_[j] == State::UPPER) {
+                x_[j] = upper_[j];
+            }
+        }
+        for (std::size_t i = 0; i < m_; ++i) {
+            const std::size_t s = n_ + i;
+            lower_[s] = problem.rowLower[i] * rowScale_[i];
+            upper_[s] = problem.rowUpper[i] * rowScale_[i];
+            setState(s, State::BASIC);
+            basis_[i] = s;
+            binv_[i * m_ + i] = -1.0;
+        }
+        computePrimal();
+        computeDual();
+    }
+
+    LinearSolution run(std::size_t maxIterations) {
+        LinearSolution solution;
+        std::size_t iteration = 0;
+        for (;; ++iteration) {
+            if (iteration > 0 && iteration % kRefactorInterval == 0) {
+                refactor();
+            }
+            const std::size_t r = leavingRow();
+            if (r == kNotBasic) {
+                solution.status = LinearSolution::Status::OPTIMAL;
+                break;
+            }
+            if (iteration >= maxIterations) {
+                solution.status = LinearSolution::Status::ITERATION_LIMIT;
+                break;
+            }
+            if (!pivot(r)) {
+                solution.status = LinearSolution::Status::INFEASIBLE;
+                break;
+            }
+        }
+        if (solution.status == LinearSolution::Status::OPTIMAL) {
+            refactor();
+        }
+        solution.iterations = iteration;
+        extract(solution);
+        return solution;
+    }
+
+private:
+    const LinearProgram& problem_;
+    const std::size_t m_;
+    const std::size_t n_;
+    const double tolerance_;
+
+    std::vector<double> rowScale_;
+    double costScale_ = 1.0;
+    std::vector<double> scaled_;  ///< Entries of A after row scaling, same layout as problem_.value
+    std::vector<std::size_t> rowBegin_;     ///< The same entries by row: row -> first entry
+    std::vector<std::uint32_t> rowColumn_;  ///< Entry -> column
+    std::vector<double> rowValue_;          ///< Entry -> scaled coefficient
+
+    // Per variable: columns first, then slacks
+    std::vector<double> cost_;
+    std::vector<double> lower_;
+    std::vector<double> upper_;
+    std::vector<State> state_;
+    std::vector<double> sign_;  ///< 1 at lower, -1 at upper, 0 if basic or fixed: the direction a variable may move
+    std::vector<double> x_;
+    std::vector<double> d_;  ///< Reduced costs, zero for basic variables
+
+    std::vector<std::size_t> basis_;  ///< Row -> basic variable
+    std::vector<double> binv_;        ///< Basis inverse, column-major m x m
+
+    std::vector<double> rho_;          ///< Scratch: row of the basis inverse
+    std::vector<double> alphaRow_;     ///< Scratch: pivot row over the nonbasic variables
+    std::vector<double> alphaColumn_;  ///< Scratch: entering column in the current basis
+
+    double primalTolerance(double bound) const {
+        return tolerance_ * (1.0 + std::abs(bound));
+    }
+
+    /// v . M_j for a variable's column of [A -I]
+    double dotColumn(const std::vector<double>& v, std::size_t j) const {
+        if (j >= n_) {
+            return -v[j - n_];
+        }
+        double sum = 0.0;
+        for (std::size_t k = problem_.columnBegin[j]; k < problem_.columnBegin[j + 1]; ++k) {
+            sum += scaled_[k] * v[problem_.rowIndex[k]];
+        }
+        return sum;
+    }
+
+    /// out = B^-1 M_j
+    void ftran(std::size_t j, std::vector<double>& out) const {
+        std::fill(out.begin(), out.end(), 0.0);
+        auto addColumn = [&](std::size_t column, double factor) {
+            const double* source = binv_.data() + column * m_;
+            for (std::size_t i = 0; i < m_; ++i) {
+                out[i] += factor * source[i];
+            }
+        };
+        if (j >= n_) {
+            addColumn(j - n_, -1.0);
+            return;
+        }
+        for (std::size_t k = problem_.columnBegin[j]; k < problem_.columnBegin[j + 1]; ++k) {
+            addColumn(problem_.rowIndex[k], scaled_[k]);
+        }
+    }
+
+    /// Basic variables from the nonbasic ones: x_B = -B^-1 N x_N
+    void computePrimal() {
+        std::vector<double> w(m_, 0.0);
+        for (std::size_t j = 0; j < n_ + m_; ++j) {
+            if (state_[j] == State::BASIC || x_[j] == 0.0) {
+                continue;
+            }
+            if (j >= n_) {
+                w[j - n_] -= x_[j];
+            } else {
+                for (std::size_t k = problem_.columnBegin[j]; k < problem_.columnBegin[j + 1]; ++k) {
+                    w[problem_.rowIndex[k]] += scaled_[k] * x_[j];
+                }
+            }
+        }
+        for (std::size_t i = 0; i < m_; ++i) {
+            double value = 0.0;
+            for (std::size_t k = 0; k < m_; ++k) {
+                value -= binv_[k * m_ + i] * w[k];
+            }
+            x_[basis_[i]] = value;
+        }
+    }
+
+    /// Reduced costs d_j = c_j - y^T M_j with y^T = c_B^T B^-1
+    void computeDual() {
+        std::vector<double> y(m_, 0.0);
+        for (std::size_t k = 0; k < m_; ++k) {
+            const double* column = binv_.data() + k * m_;
+            double sum = 0.0;
+            for (std::size_t i = 0; i < m_; ++i) {
+                sum += cost_[basis_[i]] * column[i];
+            }
+            y[k] = sum;
+        }
+        for (std::size_t j = 0; j < n_ + m_; ++j) {
+            if (state_[j] == State::BASIC) {
+                d_[j] = 0.0;
+                continue;
+            }
+            d_[j] = cost_[j] - dotColumn(y, j);
+            clampReducedCost(j);
+        }
+    }
+
+    void setState(std::size_t j, State state) {
+        state_[j] = state;
+        if (state == State::BASIC || lower_[j] == upper_[j]) {
+            sign_[j] = 0.0;
+        } else {
+            sign_[j] = state == State::LOWER ? 1.0 : -1.0;
+        }
+    }
+
+    /// Drop the rounding errors that would make a nonbasic variable dual infeasible
+    void clampReducedCost(std::size_t j) {
+        if ((state_[j] == State::LOWER && d_[j] < 0.0) || (state_[j] == State::UPPER && d_[j] > 0.0)) {
+            d_[j] = 0.0;
+        }
+    }
+
+    /// Invert the basis from scratch and recompute primal and dual values
+    void refactor() {
+        std::vector<double> b(m_ * m_, 0.0);  // Column-major basis matrix
+        for (std::size_t i = 0; i < m_; ++i) {
+            const std::size_t j = basis_[i];
+            double* column = b.data() + i * m_;
+            if (j >= n_) {
+                column[j - n_] = -1.0;
+            } else {
+                for (std::size_t k = problem_.columnBegin[j]; k < problem_.columnBegin[j + 1]; ++k) {
+                    column[problem_.rowIndex[k]] = scaled_[k];
+                }
+            }
+        }
+        std::vector<double> inverse(m_ * m_, 0.0);
+        for (std::size_t i = 0; i < m_; ++i) {
+            inverse[i * m_ + i] = 1.0;
+        }
+        // Gauss-Jordan with partial pivoting on the rows of B
+        auto at = [this](std::vector<double>& matrix, std::size_t row, std::size_t column) -> double& {
+            return matrix[column * m_ + row];
+        };
+        for (std::size_t c = 0; c < m_; ++c) {
+            std::size_t pivotRow = c;
+            for (std::size_t row = c + 1; row < m_; ++row) {
+                if (std::abs(at(b, row, c)) > std::abs(at(b, pivotRow, c))) {
+                    pivotRow = row;
+                }
+            }
+            if (std::abs(at(b, pivotRow, c)) < 1e-12) {
+                return;  // Numerically singular: keep the updated inverse
+            }
+            if (pivotRow != c) {
+                for (std::size_t k = 0; k < m_; ++k) {
+                    std::swap(at(b, pivotRow, k), at(b, c, k));
+                    std::swap(at(inverse, pivotRow, k), at(inverse, c, k));
+                }
+            }
+            const double scale = 1.0 / at(b, c, c);
+            for (std::size_t k = 0; k < m_; ++k) {
+                at(b, c, k) *= scale;
+                at(inverse, c, k) *= scale;
+            }
+            for (std::size_t row = 0; row < m_; ++row) {
+                const double factor = at(b, row, c);
+                if (row == c || factor == 0.0) {
+                    continue;
+                }
+                for (std::size_t k = 0; k < m_; ++k) {
+                    at(b, row, k) -= factor * at(b, c, k);
+                    at(inverse, row, k) -= factor * at(inverse, c, k);
+                }
+            }
+        }
+        binv_.swap(inverse);
+        computePrimal();
+        computeDual();
+    }
+
+    /// Most infeasible basic variable, or kNotBasic if the basis is primal feasible
+    std::size_t leavingRow() const {
+        std::size_t best = kNotBasic;
+        double worst = 0.0;
+        for (std::size_t i = 0; i < m_; ++i) {
+            const std::size_t j = basis_[i];
+            double infeasibility = 0.0;
+            if (x_[j] < lower_[j] - primalTolerance(lower_[j])) {
+                infeasibility = lower_[j] - x_[j];
+            } else if (x_[j] > upper_[j] + primalTolerance(upper_[j])) {
+                infeasibility = x_[j] - upper_[j];
+            }
+            if (infeasibility > worst) {
+                worst = infeasibility;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * One dual simplex pivot on row r. Returns false if no column can enter,
+     * which proves the problem infeasible.
+     */
+    bool pivot(std::size_t r) {
+        const std::size_t leaving = basis_[r];
+        const bool toLower = x_[leaving] < lower_[leaving];
+        for (std::size_t k = 0; k < m_; ++k) {
+            rho_[k] = binv_[k * m_ + r];
+        }
+
+        // Pivot row over every variable, basic ones included, in branch-free
+        // loops: a basic variable has sign 0 and so never qualifies below.
+        // Accumulating row by row streams through the matrix and skips the
+        // rows where the inverse row is zero, which early on is most of them.
+        std::fill(alphaRow_.begin(), alphaRow_.begin() + static_cast<std::ptrdiff_t>(n_), 0.0);
+        for (std::size_t i = 0; i < m_; ++i) {
+            const double weight = rho_[i];
+            if (weight == 0.0) {
+                continue;
+            }
+            for (std::size_t k = rowBegin_[i]; k < rowBegin_[i + 1]; ++k) {
+                alphaRow_[rowColumn_[k]] += weight * rowValue_[k];
+            }
+        }
+        for (std::size_t i = 0; i < m_; ++i) {
+            alphaRow_[n_ + i] = -rho_[i];
+        }
+
+        // A variable can enter if moving it off its bound (direction sign_)
+        // pushes the leaving variable toward the bound it violates, that is
+        // if step > 0; its reduced cost then limits the dual step to
+        // sign_ * d / step.
+        const double toward = toLower ? -1.0 : 1.0;
+        const std::size_t total = n_ + m_;
+        const double* alpha = alphaRow_.data();
+        const double* sign = sign_.data();
+        const double* d = d_.data();
+
+        // Harris ratio test, pass 1: the largest dual step that keeps every
+        // reduced cost within tolerance of its sign
+        double bound = LinearProgram::kInfinity;
+        for (std::size_t j = 0; j < total; ++j) {
+            const double step = sign[j] * toward * alpha[j];
+            const double ratio = step > kPivotTolerance ? (sign[j] * d[j] + tolerance_) / step
+                                                        : LinearProgram::kInfinity;
+            bound = std::min(bound, ratio);
+        }
+        if (bound == LinearProgram::kInfinity) {
+            return false;
+        }
+        // Pass 2: among the variables within that step, the largest pivot
+        std::size_t entering = kNotBasic;
+        double largest = 0.0;
+        for (std::size_t j = 0; j < total; ++j) {
+            const double step = sign[j] * toward * alpha[j];
+            if (step > largest && step > kPivotTolerance && sign[j] * d[j] <= bound * step) {
+                largest = step;
+                entering = j;
+            }
+        }
+
+        // Dual update; for basic variables alpha is 0 apart from the leaving one
+        const double thetaDual = d_[entering] / alphaRow_[entering];
+        for (std::size_t j = 0; j < total; ++j) {
+            const double updated = d_[j] - thetaDual * alpha[j];
+            // Clip rounding across the sign each nonbasic variable requires
+            d_[j] = sign[j] > 0.0 ? std::max(updated, 0.0) : (sign[j] < 0.0 ? std::min(updated, 0.0) : updated);
+        }
+        d_[entering] = 0.0;
+        d_[leaving] = -thetaDual;
+
+        // Primal update: the leaving variable lands on the bound it violated
+        ftran(entering, alphaColumn_);
+        const double target = toLower ? lower_[leaving] : upper_[leaving];
+        const double thetaPrimal = (x_[leaving] - target) / alphaColumn_[r];
+        x_[entering] += thetaPrimal;
+        for (std::size_t i = 0; i < m_; ++i) {
+            if (i != r) {
+                x_[basis_[i]] -= thetaPrimal * alphaColumn_[i];
+            }
+        }
+        x_[leaving] = target;
+        setState(leaving, toLower ? State::LOWER : State::UPPER);
+        setState(entering, State::BASIC);
+        basis_[r] = entering;
+        clampReducedCost(leaving);
+
+        // Product-form update of the inverse: pivot on alphaColumn_[r]
+        const double pivotValue = alphaColumn_[r];
+        for (std::size_t k = 0; k < m_; ++k) {
+            double* column = binv_.data() + k * m_;
+            const double scaled = column[r] / pivotValue;
+            if (scaled != 0.0) {
+                for (std::size_t i = 0; i < m_; ++i) {
+                    column[i] -= alphaColumn_[i] * scaled;
+                }
+            }
+            column[r] = scaled;
+        }
+        return true;
+    }
+
+    void extract(LinearSolution& solution) const {
+        solution.x.assign(n_, 0.0);
+        for (std::size_t j = 0; j < n_; ++j) {
+            // Clip rounding noise off the column bounds
+            solution.x[j] = std::min(std::max(x_[j], 0.0), problem_.columnUpper[j]);
+        }
+        solution.activity.assign(m_, 0.0);
+        solution.objective = 0.0;
+        for (std::size_t j = 0; j < n_; ++j) {
+            const double value = solution.x[j];
+            if (value == 0.0) {
+                continue;
+            }
+            solution.objective += problem_.cost[j] * value;
+            for (std::size_t k = problem_.columnBegin[j]; k < problem_.columnBegin[j + 1]; ++k) {
+                solution.activity[problem_.rowIndex[k]] += problem_.value[k] * value;
+            }
+        }
+        solution.rowDual.assign(m_, 0.0);
+        for (std::size_t i = 0; i < m_; ++i) {
+            if (state_[n_ + i] != State::BASIC) {
+                solution.rowDual[i] = d_[n_ + i] * rowScale_[i] / costScale_;
+            }
+        }
+    }
+};
+
+} // namespace
+
+LinearSolution solveDualSimplex(const LinearProgram& problem, std::size_t maxIterations, double tolerance) {
+    for (std::size_t j = 0; j < problem.columns; ++j) {
+        if (problem.cost[j] < 0.0 && !std::isfinite(problem.columnUpper[j])) {
+            throw std::invalid_argument("A column with negative cost needs a finite upper bound");
+        }
+    }
+    if (maxIterations == 0) {
+        maxIterations = 10 * (problem.rows + problem.columns) + 1000;
+    }
+    DualSimplex simplex(problem, tolerance);
+    return simplex.run(maxIterations);
+}
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+/**
+ * @brief A linear program in bounded row form.
+ *
+ *     minimize    cost^T x
+ *     subject to  rowLower <= A x <= rowUpper
+ *                 0 <= x <= columnUpper
+ *
+ * A is stored column-wise (compressed sparse columns): the entries of
+ * column j are rowIndex/value[columnBegin[j], columnBegin[j + 1]).
+ */
+struct LinearProgram {
+    static constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+    std::size_t rows = 0;
+    std::size_t columns = 0;
+    std::vector<double> cost;         ///< Column -> objective coefficient
+    std::vector<double> columnUpper;  ///< Column -> upper bound, may be infinite
+    std::vector<double> rowLower;     ///< Row -> lower bound, may be -infinity
+    std::vector<double> rowUpper;     ///< Row -> upper bound, may be infinity
+    std::vector<std::size_t> columnBegin{0};
+    std::vector<std::uint32_t> rowIndex;
+    std::vector<double> value;
+
+    /// Append a column; entries are (row, coefficient) pairs
+    void addColumn(double columnCost, double upper, const std::vector<std::pair<std::uint32_t, double>>& entries);
+};
+
+/**
+ * @brief Result of solveDualSimplex()
+ */
+struct LinearSolution {
+    enum class Status {
+        OPTIMAL,
+        INFEASIBLE,
+        ITERATION_LIMIT
+    };
+
+    Status status = Status::ITERATION_LIMIT;
+    std::vector<double> x;            ///< Column values
+    std::vector<double> activity;     ///< Row values A x
+    std::vector<double> rowDual;      ///< Row -> change of the optimum per unit increase of its binding bound
+    double objective = 0.0;
+    std::size_t iterations = 0;
+};
+
+/**
+ * @brief Solve a linear program with the bounded dual simplex method.
+ *
+ * Every row gets a slack variable holding its activity, and the all-slack
+ * basis with each column at the bound its cost prefers is dual feasible, so
+ * no phase 1 is needed. This requires every column with a negative cost to
+ * have a finite upper bound; the caller must check that.
+ *
+ * Each iteration picks the most infeasible basic variable to leave, computes
+ * the pivot row from a row-wise copy of the matrix, and picks the entering column
+ * with a two-pass Harris ratio test. The basis inverse is kept dense, which
+ * suits the few constraint rows of diet-style problems, and is refactored
+ * periodically to limit drift. Rows are scaled to unit maximum coefficient.
+ *
+ * @param problem The program; rows whose bounds are both infinite are allowed but useless
+ * @param maxIterations Pivot limit, 0 for automatic
+ * @param tolerance Feasibility and optimality tolerance on the scaled problem
+ */
+LinearSolution solveDualSimplex(const LinearProgram& problem, std::size_t maxIterations, double tolerance);
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
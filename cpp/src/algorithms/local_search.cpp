@@ -0,0 +1,359 @@
+#include "local_search.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <random>
+#include "smart_food/utils/thread_pool.hpp"
+#include "plan_state.hpp"
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kChainsPerThread = 4;  ///< Chains per thread, so stealing can balance them
+constexpr std::size_t kEpochs = 40;          ///< Exchanges of the best plan per run
+constexpr std::size_t kGreedyWidth = 8;      ///< Cheapest candidates drawn from when building a start
+constexpr std::size_t kWindow = 8;           ///< Consecutive candidates scored together by a slot move
+constexpr double kReplaceShare = 0.7;        ///< Probability of a replace move
+constexpr double kSwapShare = 0.2;           ///< Probability of a swap move, the rest ruins a day
+constexpr std::size_t kCheckInterval = 1024; ///< Evaluations between polls of the control
+
+/// SplitMix64 finalizer, used to derive independent chain seeds from one seed
+std::uint64_t mixSeed(std::uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+struct Chain {
+    explicit Chain(const PlanningProblem& problem) : state(problem) {}
+
+    PlanState state;
+    std::mt19937_64 rng;
+    std::vector<std::uint32_t> best;  ///< Best feasible plan of this chain
+    double bestCost = PlanningProblem::kInfinity;
+    std::size_t evaluations = 0;
+};
+
+class Annealer {
+public:
+    Annealer(const PlanningProblem& problem, const MealPlanner::Options& options,
+             const MealPlanner::Control& control)
+        : problem_(problem)
+        , options_(options)
+        , control_(control)
+        , slotCount_(problem.slotCount()) {
+    }
+
+    MealPlanner::Plan run() {
+        start_ = Clock::now();
+
+        MealPlanner::Plan result;
+        const double bound = problem_.varietyBound();
+        bound_ = bound;
+        if (control_.channel) {
+            control_.channel->raiseLowerBound(bound);
+        }
+        if (bound == PlanningProblem::kInfinity) {
+            // Some slot type does not have enough recipes: provably infeasible
+            result.optimal = true;
+            result.lowerBound = bound;
+            result.solveTime = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start_);
+            return result;
+        }
+
+        // Solves are short and frequent: the shared pool spares a thread spawn per call
+        std::unique_ptr<utils::ThreadPool> ownPool;
+        utils::ThreadPool* pool = &utils::ThreadPool::shared();
+        if (options_.threads > 0) {
+            ownPool = std::make_unique<utils::ThreadPool>(options_.threads);
+            pool = ownPool.get();
+        }
+        const std::size_t threads = pool->size();
+        const std::size_t chainCount = threads * kChainsPerThread;
+        const std::size_t perChain = std::max<std::size_t>(1, options_.maxEvaluations / chainCount);
+        const std::size_t perEpoch = (perChain + kEpochs - 1) / kEpochs;
+
+        std::vector<Chain> chains;
+        chains.reserve(chainCount);
+        double startCost = 0.0;
+        for (std::size_t c = 0; c < chainCount; ++c) {
+            chains.emplace_back(problem_);
+            chains[c].rng.seed(mixSeed(options_.seed ^ mixSeed(c)));
+            chains[c].state.load(greedyStart(chains[c].rng));
+            startCost += chains[c].state.cost();
+        }
+        calibrate(startCost / static_cast<double>(chainCount));
+
+        for (std::size_t epoch = 0; epoch < kEpochs && !stop_.load(); ++epoch) {
+            pool->parallelFor(chainCount, [&](std::size_t c) {
+                anneal(chains[c], epoch * perEpoch, std::min(perChain, (epoch + 1) * perEpoch), perChain);
+            });
+            if (epoch + 1 < kEpochs) {
+                exchange(chains);
+            }
+        }
+
+        const Chain* winner = nullptr;
+        for (const auto& chain : chains) {
+            result.nodesExplored += chain.evaluations;
+            if (chain.bestCost < PlanningProblem::kInfinity && (!winner || chain.bestCost < winner->bestCost)) {
+                winner = &chain;
+            }
+        }
+        const std::size_t evaluations = result.nodesExplored;
+        if (winner) {
+            result = problem_.toPlan(winner->best);
+            result.feasible = true;
+            result.nodesExplored = evaluations;
+        }
+        result.optimal = false;
+        result.lowerBound = winner ? std::min(bound, result.totalCost) : bound;
+        result.solveTime = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start_);
+        return result;
+    }
+
+private:
+    const PlanningProblem& problem_;
+    const MealPlanner::Options& options_;
+    const MealPlanner::Control& control_;
+    const std::size_t slotCount_;
+    Clock::time_point start_;
+    double bound_ = 0.0;
+
+    double penaltyWeight_ = 1.0;   ///< Cost of one unit of normalized violation
+    double startTemperature_ = 1.0;
+    double endTemperature_ = 1e-3;
+
+    std::atomic<bool> stop_{false};
+
+    /// Scale penalty and temperatures to the cost of a typical slot
+    void calibrate(double planCost) {
+        double slotCost = planCost / static_cast<double>(slotCount_);
+        if (!(slotCost > 0.0)) {
+            slotCost = 1.0;
+        }
+        // A whole-day violation outweighs ten days of cost, so feasibility wins
+        penaltyWeight_ = 10.0 * slotCost * problem_.slotsPerDay;
+        startTemperature_ = 0.3 * slotCost;
+        endTemperature_ = 1e-3 * slotCost;
+    }
+
+    /// Random window of a type's candidate list, biased toward the cheap end
+    std::size_t sampleWindow(int type, std::size_t width, std::mt19937_64& rng) const {
+        const std::size_t size = problem_.candidates[type].size();
+        const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        const std::size_t start = static_cast<std::size_t>(u * u * u * size);
+        return std::min(start, size - width);
+    }
+
+    /// Best of a window of candidates for a slot, scored in one batch
+    std::pair<std::uint32_t, double> bestInWindow(PlanState& state, std::size_t slot, std::mt19937_64& rng,
+                                                 std::size_t& done) const {
+        const int type = problem_.slotType[slot % problem_.slotsPerDay];
+        const auto& list = problem_.candidates[type];
+        const std::size_t width = std::min(kWindow, list.size());
+        const std::size_t first = sampleWindow(type, width, rng);
+        std::array<double, kWindow> scores;
+        state.scoreCandidates(slot, first, width, penaltyWeight_, scores.data());
+        done += width;
+
+        std::size_t best = 0;
+        for (std::size_t j = 1; j < width; ++j) {
+            if (scores[j] < scores[best]) {
+                best = j;
+            }
+        }
+        return {list[first + best], scores[best]};
+    }
+
+    /// Cheap plan honoring variety where possible, drawn among the cheapest candidates
+    std::vector<std::uint32_t> greedyStart(std::mt19937_64& rng) const {
+        const int perDay = problem_.slotsPerDay;
+        std::vector<std::uint16_t> uses(problem_.recipes.size(), 0);
+        std::vector<int> last(problem_.recipes.size(), 0);
+        std::vector<std::uint32_t> plan(slotCount_);
+        std::vector<std::uint32_t> options;
+
+        for (std::size_t s = 0; s < slotCount_; ++s) {
+            const int day = static_cast<int>(s) / perDay;
+            const auto& list = problem_.candidates[problem_.slotType[s % perDay]];
+            options.clear();
+            for (auto r : list) {
+                if (uses[r] < problem_.maxRepeats &&
+                    (uses[r] == 0 || day - last[r] >= problem_.minDaysBetweenRepeats)) {
+                    options.push_back(r);
+                    if (options.size() == kGreedyWidth) {
+                        break;
+                    }
+                }
+            }
+            std::uint32_t r;
+            if (options.empty()) {
+                r = list[std::uniform_int_distribution<std::size_t>(0, list.size() - 1)(rng)];
+            } else {
+                r = options[std::uniform_int_distribution<std::size_t>(0, options.size() - 1)(rng)];
+            }
+            plan[s] = r;
+            uses[r]++;
+            last[r] = day;
+        }
+        return plan;
+    }
+
+    /// Metropolis criterion
+    static bool accept(double delta, double temperature, std::mt19937_64& rng) {
+        if (delta <= 0.0) {
+            return true;
+        }
+        return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < std::exp(-delta / temperature);
+    }
+
+    /// Keep the current plan if it is the chain's best feasible one so far
+    void record(Chain& chain) const {
+        if (!chain.state.feasible() || chain.state.cost() >= chain.bestCost - 1e-12) {
+            return;
+        }
+        // Incremental sums drift; confirm with an exact evaluation before keeping it
+        double cost = 0.0;
+        if (problem_.evaluate(chain.state.assignment(), cost) && cost < chain.bestCost) {
+            chain.bestCost = cost;
+            chain.best = chain.state.assignment();
+            if (control_.channel && control_.channel->improves(cost)) {
+                MealPlanner::Plan published = problem_.toPlan(chain.best);
+                published.feasible = true;
+                published.lowerBound = std::min(bound_, cost);
+                published.solveTime = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start_);
+                control_.channel->offer(cost, std::move(published));
+            }
+        }
+    }
+
+    /// Run a chain from evaluation `from` to `to` of its `total` budget
+    void anneal(Chain& chain, std::size_t from, std::size_t to, std::size_t total) {
+        const int perDay = problem_.slotsPerDay;
+        auto& state = chain.state;
+        auto& rng = chain.rng;
+        std::uniform_int_distribution<std::size_t> pickSlot(0, slotCount_ - 1);
+        std::uniform_int_distribution<int> pickDay(0, problem_.days - 1);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        const double ratio = endTemperature_ / startTemperature_;
+        std::vector<std::uint32_t> saved(perDay);
+
+        record(chain);
+        std::size_t done = from;
+        std::size_t reported = from;
+        while (done < to) {
+            if (done >= reported + kCheckInterval || done == from) {
+                report(reported, done);
+                if (control_.shouldStop()) {
+                    stop_ = true;
+                }
+            }
+            if (stop_.load(std::memory_order_relaxed)) {
+                break;
+            }
+            const double temperature =
+                startTemperature_ * std::pow(ratio, static_cast<double>(done) / static_cast<double>(total));
+            const double before = state.score(penaltyWeight_);
+            const double move = unit(rng);
+
+            if (move < kReplaceShare) {
+                const std::size_t slot = pickSlot(rng);
+                const auto choice = bestInWindow(state, slot, rng, done);
+                if (accept(choice.second - before, temperature, rng)) {
+                    state.assign(slot, choice.first);
+                }
+            } else if (move < kReplaceShare + kSwapShare) {
+                const std::size_t a = pickSlot(rng);
+                const std::size_t b = pickSlot(rng);
+                const std::uint32_t ra = state.at(a);
+                const std::uint32_t rb = state.at(b);
+                ++done;
+                if (ra == rb || !(problem_.typeMask[ra] & (1u << problem_.slotType[b % perDay])) ||
+                    !(problem_.typeMask[rb] & (1u << problem_.slotType[a % perDay]))) {
+                    continue;
+                }
+                state.assign(a, rb);
+                state.assign(b, ra);
+                if (!accept(state.score(penaltyWeight_) - before, temperature, rng)) {
+                    state.assign(a, ra);
+                    state.assign(b, rb);
+                }
+            } else {
+                // Rebuild one day slot by slot, each from a window of sampled candidates
+                const std::size_t first = static_cast<std::size_t>(pickDay(rng)) * perDay;
+                for (int pos = 0; pos < perDay; ++pos) {
+                    saved[pos] = state.at(first + pos);
+                }
+                for (int pos = 0; pos < perDay; ++pos) {
+                    const auto choice = bestInWindow(state, first + pos, rng, done);
+                    if (choice.second < state.score(penaltyWeight_)) {
+                        state.assign(first + pos, choice.first);
+                    }
+                }
+                if (!accept(state.score(penaltyWeight_) - before, temperature, rng)) {
+                    for (int pos = 0; pos < perDay; ++pos) {
+                        state.assign(first + pos, saved[pos]);
+                    }
+                }
+            }
+            record(chain);
+        }
+        report(reported, done);
+        chain.evaluations += done - from;
+    }
+
+    /// Add the evaluations since the last report to the progress channel
+    void report(std::size_t& reported, std::size_t done) const {
+        if (control_.channel) {
+            control_.channel->addIterations(done - reported);
+        }
+        reported = done;
+    }
+
+    /// Restart the weaker half of the chains from the best plan found so far
+    void exchange(std::vector<Chain>& chains) const {
+        std::vector<std::size_t> order(chains.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::vector<double> scores(chains.size());
+        for (std::size_t c = 0; c < chains.size(); ++c) {
+            scores[c] = chains[c].state.score(penaltyWeight_);
+        }
+        std::stable_sort(order.begin(), order.end(), [&scores](std::size_t a, std::size_t b) {
+            return scores[a] < scores[b];
+        });
+
+        std::vector<std::uint32_t> seed = chains[order.front()].state.assignment();
+        double bestCost = PlanningProblem::kInfinity;
+        for (const auto& chain : chains) {
+            if (chain.bestCost < bestCost) {
+                bestCost = chain.bestCost;
+                seed = chain.best;
+            }
+        }
+        for (std::size_t i = chains.size() / 2; i < chains.size(); ++i) {
+            chains[order[i]].state.load(seed);
+        }
+    }
+};
+
+} // namespace
+
+MealPlanner::Plan solveLocalSearch(const PlanningProblem& problem, const MealPlanner::Options& options,
+                                   const MealPlanner::Control& control) {
+    Annealer annealer(problem, options, control);
+    return annealer.run();
+}
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "smart_food/algorithms/meal_planner.hpp"
+#include "planning_problem.hpp"
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+/**
+ * @brief Parallel simulated annealing over complete slot assignments.
+ *
+ * Independent chains start from randomized greedy plans and anneal with
+ * three moves: replace the recipe of a slot, swap the recipes of two slots,
+ * and ruin and recreate a whole day. Constraint violations are penalized in
+ * the objective rather than forbidden, so chains can cross infeasible
+ * regions. The run is split into epochs; chains of an epoch are scheduled on
+ * a work-stealing pool and, between epochs, the weaker half of the chains
+ * restarts from the best plan found so far. Every chain owns its random
+ * generator and the exchange step is sequential, which keeps the result a
+ * function of the seed and the number of chains only.
+ *
+ * Chains poll the control every 1024 evaluations and publish their improving
+ * plans on its channel as they find them.
+ */
+MealPlanner::Plan solveLocalSearch(const PlanningProblem& problem, const MealPlanner::Options& options,
+                                   const MealPlanner::Control& control);
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
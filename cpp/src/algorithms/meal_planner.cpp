@@ -0,0 +1,1084 @@
+#include "smart_food/algorithms/meal_planner.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include "smart_food/core/storage.hpp"
+#include "local_search.hpp"
+#include "pareto_search.hpp"
+#include "planning_problem.hpp"
+#include "replanner.hpp"
+#include "request_key.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+namespace {
+
+using detail::PlanningProblem;
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Depth-first branch-and-bound over the slots of a PlanningProblem.
+ *
+ * Slots are filled day by day. At every node the cost so far plus a lower
+ * bound on the remaining slots is compared against the incumbent; candidates
+ * are visited cheapest first so the loop can stop at the first one whose
+ * optimistic completion is no better than the incumbent.
+ */
+class BranchAndBound {
+public:
+    BranchAndBound(const PlanningProblem& problem, const MealPlanner::Options& options,
+                   const MealPlanner::Control& control)
+        : problem_(problem)
+        , options_(options)
+        , control_(control)
+        , slotCount_(problem.slotCount())
+        , used_(problem.recipes.size(), 0)
+        , lastDay_(problem.recipes.size(), 0)
+        , assignment_(slotCount_, 0)
+        , dayCost_(problem.days, 0.0)
+        , dayBound_(problem.days, 0.0)
+        , dayCombo_(problem.days)
+        , levelNutrients_((slotCount_ + 1) * problem.nutrientCount, 0.0)
+        , zeroNutrients_(problem.nutrientCount, 0.0)
+        , stock_(problem.pantryStock) {
+        // Permuting whole days keeps a plan feasible unless repeats are spaced
+        // more than a day apart or pantry consumption order changes the cost,
+        // so otherwise days are only explored in nondecreasing order of cost.
+        breakSymmetry_ = problem.minDaysBetweenRepeats <= 1 && !problem.hasPantry;
+        precomputeSlotTables();
+        precomputeNutrientSuffixes();
+        precomputeCompletionTables();
+        computeMultipliers();
+    }
+
+    MealPlanner::Plan run() {
+        start_ = Clock::now();
+
+        MealPlanner::Plan result;
+        dayOptimum_ = cheapestDay([](std::uint32_t) { return false; }, kRootDayBudget,
+                                  PlanningProblem::kInfinity, cheapestSuffix_[0], &dayCombo_[0]);
+        std::fill(dayBound_.begin(), dayBound_.end(), dayOptimum_);
+        if (dayOptimum_ < PlanningProblem::kInfinity) {
+            rootBound_ = std::max(remainingBound(0, zeroNutrients_.data(), 0),
+                                  lagrangianBound(0, zeroNutrients_.data()));
+            if (control_.channel) {
+                control_.channel->raiseLowerBound(rootBound_);
+            }
+            if (rootBound_ < PlanningProblem::kInfinity) {
+                greedyDays();
+                search(0, 0.0, 0.0);
+            }
+        } else {
+            rootBound_ = PlanningProblem::kInfinity;
+        }
+
+        if (bestCost_ < PlanningProblem::kInfinity) {
+            result = problem_.toPlan(best_);
+            result.feasible = true;
+        }
+        result.optimal = !aborted_;
+        result.lowerBound = aborted_ ? std::min(rootBound_, bestCost_)
+                                     : std::max(std::min(rootBound_, bestCost_), bestCost_ - tolerance());
+        if (!result.feasible && result.optimal) {
+            result.lowerBound = PlanningProblem::kInfinity;
+        }
+        result.nodesExplored = nodes_;
+        result.solveTime = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start_);
+        reportNodes();
+        return result;
+    }
+
+private:
+    const PlanningProblem& problem_;
+    const MealPlanner::Options& options_;
+    const MealPlanner::Control& control_;
+    const std::size_t slotCount_;
+
+    // Per-slot tables
+    std::vector<std::array<int, PlanningProblem::kTypeCount>> remainingOfType_;  ///< Slot -> slots of each type from here on
+    std::vector<std::uint8_t> remainingMask_;     ///< Slot -> types still to fill from here on
+    std::vector<double> cheapestSuffix_;          ///< Position in day -> cheapest fill of the rest of the day
+    std::vector<std::uint32_t> allCandidates_;    ///< Every usable recipe by optimistic cost
+    std::vector<double> suffixMin_;               ///< (position, nutrient) -> least addable by later slots of the day
+    std::vector<double> suffixMax_;               ///< (position, nutrient) -> most addable by later slots of the day
+    std::vector<std::vector<double>> reachCost_;  ///< Nutrient -> (position, bucket) -> cheapest way to add at least the bucket
+    std::vector<std::vector<double>> capCost_;    ///< Nutrient -> (position, bucket) -> cheapest way to add at most the bucket
+    std::vector<double> bucketWidth_;             ///< Nutrient -> width of a table bucket
+    std::vector<double> minMultiplier_;           ///< Nutrient -> Lagrange multiplier of the daily minimum
+    std::vector<double> maxMultiplier_;           ///< Nutrient -> Lagrange multiplier of the daily maximum
+    std::vector<double> reducedCost_;             ///< Recipe -> cost minus its priced nutrients
+    std::vector<std::vector<std::uint32_t>> reducedCandidates_;  ///< Type -> recipes by reduced cost
+    bool useLagrangian_ = false;
+
+    // Search state
+    std::vector<std::uint16_t> used_;
+    std::vector<int> lastDay_;
+    std::vector<std::uint32_t> assignment_;
+    std::vector<double> dayCost_;
+    std::vector<double> dayBound_;      ///< Day -> cheapest feasible day from the recipes left when it started
+    std::vector<std::vector<std::uint32_t>> dayCombo_;  ///< Day -> recipes of that cheapest day, if proven
+    std::vector<double> levelNutrients_;
+    std::vector<double> zeroNutrients_;
+    std::vector<double> stock_;
+    PlanningProblem::StockTrail trail_;
+
+    std::vector<std::uint32_t> best_;
+    double bestCost_ = PlanningProblem::kInfinity;
+    double dayOptimum_ = 0.0;
+    double rootBound_ = 0.0;
+    bool breakSymmetry_ = false;
+
+    std::size_t nodes_ = 0;
+    std::size_t reportedNodes_ = 0;  ///< Nodes already added to the progress channel
+    bool aborted_ = false;
+    mutable bool expired_ = false;   ///< The control asked to stop; sticky once seen
+    Clock::time_point start_;
+
+    void precomputeSlotTables() {
+        const int perDay = problem_.slotsPerDay;
+        remainingOfType_.assign(slotCount_ + 1, {});
+        remainingMask_.assign(slotCount_ + 1, 0);
+        for (std::size_t s = slotCount_; s-- > 0;) {
+            int type = problem_.slotType[s % perDay];
+            remainingOfType_[s] = remainingOfType_[s + 1];
+            remainingOfType_[s][type]++;
+            remainingMask_[s] = static_cast<std::uint8_t>(remainingMask_[s + 1] | (1u << type));
+        }
+
+        cheapestSuffix_.assign(perDay + 1, 0.0);
+        for (int pos = perDay; pos-- > 0;) {
+            const auto& list = problem_.candidates[problem_.slotType[pos]];
+            double cheapest = list.empty() ? PlanningProblem::kInfinity
+                                           : problem_.optimisticCost[list.front()];
+            cheapestSuffix_[pos] = cheapestSuffix_[pos + 1] + cheapest;
+        }
+
+        for (std::size_t r = 0; r < problem_.recipes.size(); ++r) {
+            if (problem_.typeMask[r] & remainingMask_[0]) {
+                allCandidates_.push_back(static_cast<std::uint32_t>(r));
+            }
+        }
+        std::stable_sort(allCandidates_.begin(), allCandidates_.end(), [this](std::uint32_t a, std::uint32_t b) {
+            return problem_.optimisticCost[a] < problem_.optimisticCost[b];
+        });
+    }
+
+    void precomputeNutrientSuffixes() {
+        const int perDay = problem_.slotsPerDay;
+        const std::size_t k = problem_.nutrientCount;
+        suffixMin_.assign((perDay + 1) * k, 0.0);
+        suffixMax_.assign((perDay + 1) * k, 0.0);
+        for (int pos = perDay; pos-- > 0;) {
+            const auto& list = problem_.candidates[problem_.slotType[pos]];
+            for (std::size_t n = 0; n < k; ++n) {
+                double lo = PlanningProblem::kInfinity;
+                double hi = -PlanningProblem::kInfinity;
+                for (auto r : list) {
+                    double value = problem_.nutrientRow(r)[n];
+                    lo = std::min(lo, value);
+                    hi = std::max(hi, value);
+                }
+                if (list.empty()) {
+                    lo = hi = 0.0;
+                }
+                suffixMin_[pos * k + n] = suffixMin_[(pos + 1) * k + n] + lo;
+                suffixMax_[pos * k + n] = suffixMax_[(pos + 1) * k + n] + hi;
+            }
+        }
+    }
+
+    /// Whether adding a recipe at a day position keeps every nutrient range reachable
+    bool nutrientsReachable(const double* partial, std::uint32_t recipe, int pos) const {
+        const std::size_t k = problem_.nutrientCount;
+        const double* row = problem_.nutrientRow(recipe);
+        const double* lo = suffixMin_.data() + (pos + 1) * k;
+        const double* hi = suffixMax_.data() + (pos + 1) * k;
+        for (std::size_t n = 0; n < k; ++n) {
+            double value = partial[n] + row[n];
+            if (value + lo[n] > problem_.nutrientMax[n] || value + hi[n] < problem_.nutrientMin[n]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static constexpr int kBuckets = 256;                   ///< Resolution of the completion tables
+    static constexpr std::size_t kRootDayBudget = 200000;  ///< Nodes for the cheapest day at the root
+    static constexpr std::size_t kDayBudget = 20000;       ///< Nodes for the cheapest day at a day boundary
+
+    /**
+     * Tabulate, per nutrient and day position, the cheapest way to fill the
+     * rest of the day so that the nutrient grows by at least (reachCost_) or
+     * at most (capCost_) a given amount. Amounts are rounded in the direction
+     * that keeps the tables optimistic, so lookups are admissible bounds.
+     */
+    void precomputeCompletionTables() {
+        const int perDay = problem_.slotsPerDay;
+        const std::size_t k = problem_.nutrientCount;
+        const int columns = kBuckets + 1;
+        reachCost_.assign(k, {});
+        capCost_.assign(k, {});
+        bucketWidth_.assign(k, 0.0);
+
+        for (std::size_t n = 0; n < k; ++n) {
+            const bool hasMin = problem_.nutrientMin[n] > 0.0;
+            const bool hasMax = problem_.nutrientMax[n] < suffixMax_[n];
+            if (!hasMin && !hasMax) {
+                continue;
+            }
+            const double range = hasMax ? std::max(problem_.nutrientMax[n], problem_.nutrientMin[n])
+                                        : problem_.nutrientMin[n];
+            if (range <= 0.0) {
+                continue;
+            }
+            const double width = range / kBuckets;
+            bucketWidth_[n] = width;
+
+            auto build = [&](bool atLeast) {
+                std::vector<double> table((perDay + 1) * columns, PlanningProblem::kInfinity);
+                // Past the last slot nothing can be added: only "add at least 0" or
+                // "add at most anything" is free
+                for (int b = 0; b < columns; ++b) {
+                    table[perDay * columns + b] = (atLeast && b > 0) ? PlanningProblem::kInfinity : 0.0;
+                }
+                for (int pos = perDay; pos-- > 0;) {
+                    const auto& list = problem_.candidates[problem_.slotType[pos]];
+                    const double* next = table.data() + (pos + 1) * columns;
+                    double* row = table.data() + pos * columns;
+                    for (int b = 0; b < columns; ++b) {
+                        double best = PlanningProblem::kInfinity;
+                        for (auto r : list) {
+                            const double cost = problem_.optimisticCost[r];
+                            if (cost >= best) {
+                                break;
+                            }
+                            const double value = problem_.nutrientRow(r)[n] / width;
+                            int rest;
+                            if (atLeast) {
+                                rest = std::max(0, b - static_cast<int>(std::ceil(value)));
+                            } else {
+                                rest = b - static_cast<int>(std::floor(value));
+                                if (rest < 0) {
+                                    continue;
+                                }
+                            }
+                            best = std::min(best, cost + next[rest]);
+                        }
+                        row[b] = best;
+                    }
+                }
+                return table;
+            };
+            if (hasMin) {
+                reachCost_[n] = build(true);
+            }
+            if (hasMax) {
+                capCost_[n] = build(false);
+            }
+        }
+    }
+
+    /**
+     * Admissible bound on completing the current day from a day position,
+     * given the nutrients already collected by the earlier slots of the day.
+     */
+    double completionBound(int pos, const double* partial) const {
+        double bound = cheapestSuffix_[pos];
+        const int columns = kBuckets + 1;
+        for (std::size_t n = 0; n < problem_.nutrientCount; ++n) {
+            const double width = bucketWidth_[n];
+            if (width <= 0.0) {
+                continue;
+            }
+            if (!reachCost_[n].empty()) {
+                double need = problem_.nutrientMin[n] - partial[n];
+                if (need > 0.0) {
+                    int b = std::min(kBuckets, static_cast<int>(std::floor(need / width)));
+                    bound = std::max(bound, reachCost_[n][pos * columns + b]);
+                }
+            }
+            if (!capCost_[n].empty()) {
+                double allowance = problem_.nutrientMax[n] - partial[n];
+                if (allowance < 0.0) {
+                    return PlanningProblem::kInfinity;
+                }
+                int b = std::min(kBuckets, static_cast<int>(std::ceil(allowance / width)));
+                bound = std::max(bound, capCost_[n][pos * columns + b]);
+            }
+        }
+        return bound;
+    }
+
+    /// Sum of the `need` cheapest uses left in a candidate list, honoring repeat limits
+    double cheapestUses(const std::vector<std::uint32_t>& list, int need, std::uint8_t mask,
+                        const std::vector<double>& costs) const {
+        double total = 0.0;
+        for (auto r : list) {
+            if (need == 0) {
+                break;
+            }
+            if (!(problem_.typeMask[r] & mask)) {
+                continue;
+            }
+            int available = problem_.maxRepeats - used_[r];
+            if (available <= 0) {
+                continue;
+            }
+            int take = std::min(available, need);
+            total += take * costs[r];
+            need -= take;
+        }
+        return need == 0 ? total : PlanningProblem::kInfinity;
+    }
+
+    /**
+     * Lagrangian bound on slots [slot, slotCount) given the nutrients collected
+     * so far on the current day. The daily nutrient ranges of the remaining
+     * days are summed, priced with fixed multipliers and moved into the
+     * objective, which leaves a problem solved by picking the recipes of
+     * lowest reduced cost per slot type.
+     */
+    double lagrangianBound(std::size_t slot, const double* partial) const {
+        if (!useLagrangian_ || slot >= slotCount_) {
+            return slot >= slotCount_ ? 0.0 : -PlanningProblem::kInfinity;
+        }
+        double bound = 0.0;
+        for (int t = 0; t < PlanningProblem::kTypeCount; ++t) {
+            int need = remainingOfType_[slot][t];
+            if (need > 0) {
+                bound += cheapestUses(reducedCandidates_[t], need, static_cast<std::uint8_t>(1u << t), reducedCost_);
+            }
+        }
+        return bound + lagrangianConstant(static_cast<int>(slot) / problem_.slotsPerDay, partial);
+    }
+
+    /// Priced right-hand sides of the nutrient ranges from a day on, net of `partial`
+    double lagrangianConstant(int day, const double* partial) const {
+        const double daysLeft = static_cast<double>(problem_.days - day);
+        double constant = 0.0;
+        for (std::size_t n = 0; n < problem_.nutrientCount; ++n) {
+            if (minMultiplier_[n] > 0.0) {
+                constant += minMultiplier_[n] * (daysLeft * problem_.nutrientMin[n] - partial[n]);
+            }
+            if (maxMultiplier_[n] > 0.0) {
+                constant -= maxMultiplier_[n] * (daysLeft * problem_.nutrientMax[n] - partial[n]);
+            }
+        }
+        return constant;
+    }
+
+    /// Reduced costs and per-type orderings for the current multipliers
+    void applyMultipliers() {
+        const std::size_t recipeCount = problem_.recipes.size();
+        reducedCost_.resize(recipeCount);
+        for (std::size_t r = 0; r < recipeCount; ++r) {
+            const double* row = problem_.nutrientRow(static_cast<std::uint32_t>(r));
+            double cost = problem_.optimisticCost[r];
+            for (std::size_t n = 0; n < problem_.nutrientCount; ++n) {
+                cost -= (minMultiplier_[n] - maxMultiplier_[n]) * row[n];
+            }
+            reducedCost_[r] = cost;
+        }
+        reducedCandidates_ = problem_.candidates;
+        for (auto& list : reducedCandidates_) {
+            std::stable_sort(list.begin(), list.end(), [this](std::uint32_t a, std::uint32_t b) {
+                return reducedCost_[a] < reducedCost_[b];
+            });
+        }
+    }
+
+    /**
+     * Choose the multipliers by subgradient ascent on the root relaxation,
+     * keeping the best bound seen. Only ranges that can actually bind get a
+     * multiplier.
+     */
+    void computeMultipliers() {
+        const std::size_t k = problem_.nutrientCount;
+        minMultiplier_.assign(k, 0.0);
+        maxMultiplier_.assign(k, 0.0);
+        std::vector<bool> binds(2 * k, false);
+        for (std::size_t n = 0; n < k; ++n) {
+            binds[2 * n] = problem_.nutrientMin[n] > suffixMin_[n];
+            binds[2 * n + 1] = problem_.nutrientMax[n] < suffixMax_[n];
+            useLagrangian_ = useLagrangian_ || binds[2 * n] || binds[2 * n + 1];
+        }
+        if (!useLagrangian_) {
+            return;
+        }
+
+        std::vector<double> bestMin = minMultiplier_;
+        std::vector<double> bestMax = maxMultiplier_;
+        double bestBound = -PlanningProblem::kInfinity;
+        double target = 0.0;
+        double theta = 2.0;
+        int stalled = 0;
+        std::vector<double> collected(k);
+
+        for (int iteration = 0; iteration < 100; ++iteration) {
+            applyMultipliers();
+
+            // Solve the relaxation, remembering the nutrients it collects
+            double bound = lagrangianConstant(0, zeroNutrients_.data());
+            std::fill(collected.begin(), collected.end(), 0.0);
+            for (int t = 0; t < PlanningProblem::kTypeCount; ++t) {
+                int need = remainingOfType_[0][t];
+                for (auto r : reducedCandidates_[t]) {
+                    if (need == 0) {
+                        break;
+                    }
+                    int take = std::min(problem_.maxRepeats, need);
+                    bound += take * reducedCost_[r];
+                    const double* row = problem_.nutrientRow(r);
+                    for (std::size_t n = 0; n < k; ++n) {
+                        collected[n] += take * row[n];
+                    }
+                    need -= take;
+                }
+                if (need > 0) {
+                    bound = PlanningProblem::kInfinity;
+                }
+            }
+            if (bound == PlanningProblem::kInfinity) {
+                break;
+            }
+
+            if (bound > bestBound + 1e-12) {
+                bestBound = bound;
+                bestMin = minMultiplier_;
+                bestMax = maxMultiplier_;
+                stalled = 0;
+            } else if (++stalled >= 5) {
+                theta /= 2.0;
+                stalled = 0;
+            }
+            if (iteration == 0) {
+                target = bound + std::max(1.0, std::abs(bound)) * 0.05;
+            }
+            target = std::max(target, bestBound + 1e-6);
+
+            double norm = 0.0;
+            std::vector<double> gradient(2 * k, 0.0);
+            for (std::size_t n = 0; n < k; ++n) {
+                const double days = static_cast<double>(problem_.days);
+                if (binds[2 * n]) {
+                    gradient[2 * n] = days * problem_.nutrientMin[n] - collected[n];
+                }
+                if (binds[2 * n + 1]) {
+                    gradient[2 * n + 1] = collected[n] - days * problem_.nutrientMax[n];
+                }
+                norm += gradient[2 * n] * gradient[2 * n] + gradient[2 * n + 1] * gradient[2 * n + 1];
+            }
+            if (norm <= 1e-18 || theta < 1e-4) {
+                break;
+            }
+            const double step = theta * (target - bound) / norm;
+            for (std::size_t n = 0; n < k; ++n) {
+                minMultiplier_[n] = std::max(0.0, minMultiplier_[n] + step * gradient[2 * n]);
+                maxMultiplier_[n] = std::max(0.0, maxMultiplier_[n] + step * gradient[2 * n + 1]);
+            }
+        }
+
+        minMultiplier_ = bestMin;
+        maxMultiplier_ = bestMax;
+        applyMultipliers();
+    }
+
+    /**
+     * Admissible bound on the cost of filling slots [slot, slotCount).
+     *
+     * Takes the larger of two relaxations: the cheapest recipe uses still
+     * allowed by the repeat limit (per slot type, and over all remaining slots
+     * together), and the cheapest nutritionally feasible completion of the
+     * current day followed by cheapest feasible days, ignoring variety.
+     * `partial` holds the nutrients of the current day so far, or is null if
+     * they are unknown, in which case only costs bound the current day.
+     * `boundDay` is the latest day whose dayBound_ entry is valid on this path.
+     */
+    double remainingBound(std::size_t slot, const double* partial, std::size_t boundDay) const {
+        if (slot >= slotCount_) {
+            return 0.0;
+        }
+
+        double perType = 0.0;
+        for (int t = 0; t < PlanningProblem::kTypeCount; ++t) {
+            int need = remainingOfType_[slot][t];
+            if (need > 0) {
+                perType += cheapestUses(problem_.candidates[t], need, static_cast<std::uint8_t>(1u << t),
+                                        problem_.optimisticCost);
+            }
+        }
+        double overall = cheapestUses(allCandidates_, static_cast<int>(slotCount_ - slot), remainingMask_[slot],
+                                      problem_.optimisticCost);
+
+        const std::size_t perDay = static_cast<std::size_t>(problem_.slotsPerDay);
+        const std::size_t day = slot / perDay;
+        const std::size_t pos = slot % perDay;
+        // Days that have not started yet are bounded by the last day that has,
+        // which is valid because recipes only get used up further down the path
+        const double laterDay = dayBound_[std::min(day, boundDay)];
+        double today = partial ? completionBound(static_cast<int>(pos), partial) : cheapestSuffix_[pos];
+        if (pos == 0) {
+            today = laterDay;
+        }
+        double daily = today + static_cast<double>(problem_.days - day - 1) * laterDay;
+
+        return std::max({perType, overall, daily});
+    }
+
+    bool shouldStop() {
+        if (nodes_ >= options_.maxNodes) {
+            aborted_ = true;
+        } else if ((nodes_ & 1023) == 1) {
+            // Poll every 1024 nodes, starting with the root
+            reportNodes();
+            aborted_ = expired();
+        } else {
+            aborted_ = expired_;
+        }
+        return aborted_;
+    }
+
+    /// Whether the deadline passed or the run was cancelled
+    bool expired() const {
+        if (!expired_ && control_.shouldStop()) {
+            expired_ = true;
+        }
+        return expired_;
+    }
+
+    void reportNodes() {
+        if (control_.channel) {
+            control_.channel->addIterations(nodes_ - reportedNodes_);
+        }
+        reportedNodes_ = nodes_;
+    }
+
+    /// Make a complete plan the incumbent and publish it
+    void setIncumbent(const std::vector<std::uint32_t>& plan, double cost) {
+        bestCost_ = cost;
+        best_ = plan;
+        if (control_.channel && control_.channel->improves(cost)) {
+            MealPlanner::Plan published = problem_.toPlan(best_);
+            published.feasible = true;
+            published.lowerBound = std::min(rootBound_, cost);
+            published.nodesExplored = nodes_;
+            published.solveTime = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start_);
+            control_.channel->offer(cost, std::move(published));
+        }
+    }
+
+    /// Improvement over the incumbent below which a branch is not worth exploring
+    double tolerance() const {
+        return std::max(options_.relativeGap * std::abs(bestCost_), 1e-9 * std::max(1.0, std::abs(bestCost_)));
+    }
+
+    /// Whether a plan costing at least `bound` could beat the incumbent by more than the gap
+    bool improves(double bound) const {
+        if (bestCost_ == PlanningProblem::kInfinity) {
+            return bound < PlanningProblem::kInfinity;
+        }
+        return bound < bestCost_ - tolerance();
+    }
+
+    /**
+     * Lower bound on the cost of any plan extending the current partial day.
+     *
+     * When days are interchangeable they are explored in nondecreasing order
+     * of cost, so each of the days left (this one included) costs at least as
+     * much as the cheaper of the current day's optimistic total and the
+     * previous day's cost.
+     */
+    double orderedDaysBound(int day, double doneCost, double dayLowerBound) const {
+        if (!breakSymmetry_) {
+            return 0.0;
+        }
+        const double floor = day > 0 ? dayCost_[day - 1] : 0.0;
+        return doneCost + static_cast<double>(problem_.days - day) * std::max(floor, dayLowerBound);
+    }
+
+    void search(std::size_t slot, double doneCost, double dayCost) {
+        ++nodes_;
+        if (shouldStop()) {
+            return;
+        }
+        if (slot == slotCount_) {
+            if (improves(doneCost)) {
+                setIncumbent(assignment_, doneCost);
+            }
+            return;
+        }
+
+        const int perDay = problem_.slotsPerDay;
+        const int day = static_cast<int>(slot) / perDay;
+        const int pos = static_cast<int>(slot) % perDay;
+        const std::size_t k = problem_.nutrientCount;
+        const auto& list = problem_.candidates[problem_.slotType[pos]];
+        // A new day starts from zero instead of the previous day's totals
+        const double* partial = pos == 0 ? zeroNutrients_.data() : levelNutrients_.data() + slot * k;
+        double* next = levelNutrients_.data() + (slot + 1) * k;
+
+        if (pos == 0 && day > 0) {
+            // Every day left costs at least the cheapest day buildable from the unused recipes
+            const double daysLeft = static_cast<double>(problem_.days - day);
+            const double cutoff = bestCost_ < PlanningProblem::kInfinity ? (bestCost_ - doneCost) / daysLeft
+                                                                         : PlanningProblem::kInfinity;
+            auto spent = [this](std::uint32_t r) { return used_[r] >= problem_.maxRepeats; };
+            // The previous day's cheapest day is still cheapest if none of its recipes got spent
+            const auto& previous = dayCombo_[day - 1];
+            if (!previous.empty() && std::none_of(previous.begin(), previous.end(), spent)) {
+                dayBound_[day] = dayBound_[day - 1];
+                dayCombo_[day] = previous;
+            } else {
+                dayBound_[day] = cheapestDay(spent, kDayBudget, cutoff, dayBound_[day - 1], &dayCombo_[day]);
+            }
+            if (dayBound_[day] == PlanningProblem::kInfinity || !improves(doneCost + daysLeft * dayBound_[day])) {
+                return;
+            }
+        }
+
+        const double dayLowerBound = pos == 0 ? dayBound_[day] : dayCost + completionBound(pos, partial);
+        if (!improves(std::max({doneCost + dayCost + remainingBound(slot, partial, day),
+                                doneCost + dayCost + lagrangianBound(slot, partial),
+                                orderedDaysBound(day, doneCost, dayLowerBound)}))) {
+            return;
+        }
+
+        // Bounds of the later slots before this choice; never exceed the bounds after it
+        const double restBound = remainingBound(slot + 1, nullptr, day);
+        double restLagrangian = -PlanningProblem::kInfinity;
+        if (useLagrangian_) {
+            restLagrangian = lagrangianConstant(day, partial);
+            for (int t = 0; t < PlanningProblem::kTypeCount; ++t) {
+                int need = remainingOfType_[slot + 1][t];
+                if (need > 0) {
+                    restLagrangian += cheapestUses(reducedCandidates_[t], need,
+                                                   static_cast<std::uint8_t>(1u << t), reducedCost_);
+                }
+            }
+        }
+        const bool closesDay = pos == perDay - 1;
+        const double dayFloor = breakSymmetry_ && day > 0 ? dayCost_[day - 1] : 0.0;
+
+        for (const std::uint32_t r : list) {
+            const double optimistic = dayCost + problem_.optimisticCost[r];
+            const double bound = std::max(doneCost + optimistic + restBound,
+                                          orderedDaysBound(day, doneCost, optimistic + cheapestSuffix_[pos + 1]));
+            if (!improves(bound)) {
+                break;
+            }
+            if (used_[r] >= problem_.maxRepeats) {
+                continue;
+            }
+            if (used_[r] > 0 && day - lastDay_[r] < problem_.minDaysBetweenRepeats) {
+                continue;
+            }
+            if (closesDay && optimistic < dayFloor) {
+                continue;
+            }
+            if (useLagrangian_ && !improves(doneCost + dayCost + reducedCost_[r] + restLagrangian)) {
+                continue;
+            }
+            if (!nutrientsReachable(partial, r, pos)) {
+                continue;
+            }
+            const double* row = problem_.nutrientRow(r);
+            for (std::size_t n = 0; n < k; ++n) {
+                next[n] = partial[n] + row[n];
+            }
+            if (!closesDay) {
+                const double completed = optimistic + completionBound(pos + 1, next);
+                if (!improves(std::max(doneCost + completed,
+                                       orderedDaysBound(day, doneCost, completed)))) {
+                    continue;
+                }
+            }
+
+            const std::size_t mark = trail_.size();
+            const double slotCost = problem_.hasPantry ? problem_.consumeStock(r, stock_, trail_)
+                                                       : problem_.purchaseCost[r];
+            const int previousDay = lastDay_[r];
+            used_[r]++;
+            lastDay_[r] = day;
+            assignment_[slot] = r;
+
+            if (closesDay) {
+                dayCost_[day] = dayCost + slotCost;
+                search(slot + 1, doneCost + dayCost + slotCost, 0.0);
+            } else {
+                search(slot + 1, doneCost, dayCost + slotCost);
+            }
+
+            used_[r]--;
+            lastDay_[r] = previousDay;
+            PlanningProblem::releaseStock(stock_, trail_, mark);
+            if (aborted_) {
+                return;
+            }
+        }
+    }
+
+    /**
+     * Cost of the cheapest single day meeting the nutrient ranges, ignoring
+     * the other days and the sharing of pantry stock.
+     *
+     * @param blocked Predicate telling which recipes may not be used
+     * @param budget Node budget of the day search
+     * @param cutoff Only days cheaper than this are of interest; returned if none is
+     * @param fallback Bound returned when the budget is exhausted
+     * @param combo If not null, receives the recipes of the cheapest day, or is
+     *              cleared unless a day below the cutoff was found and proven cheapest
+     */
+    template <typename Blocked>
+    double cheapestDay(const Blocked& blocked, std::size_t budget, double cutoff, double fallback,
+                       std::vector<std::uint32_t>* combo = nullptr) const {
+        const int perDay = problem_.slotsPerDay;
+        const std::size_t k = problem_.nutrientCount;
+        const bool distinct = problem_.minDaysBetweenRepeats >= 1;
+        double best = cutoff;
+        std::size_t dayNodes = 0;
+        if (combo) {
+            combo->clear();
+        }
+        std::vector<double> sums((perDay + 1) * k, 0.0);
+        std::vector<std::uint32_t> chosen(perDay, 0);
+
+        auto dfs = [&](auto& self, int pos, double cost) -> void {
+            if (++dayNodes > budget) {
+                return;
+            }
+            if ((dayNodes & 1023) == 0 && expired()) {
+                // Out of time: give up on the day as if the budget ran out
+                dayNodes = budget + 1;
+                return;
+            }
+            if (pos == perDay) {
+                if (cost < best) {
+                    best = cost;
+                    if (combo) {
+                        *combo = chosen;
+                    }
+                }
+                return;
+            }
+            const auto& list = problem_.candidates[problem_.slotType[pos]];
+            const double* partial = sums.data() + pos * k;
+            double* next = sums.data() + (pos + 1) * k;
+            for (auto r : list) {
+                if (cost + problem_.optimisticCost[r] + cheapestSuffix_[pos + 1] >= best) {
+                    break;
+                }
+                if (blocked(r)) {
+                    continue;
+                }
+                if (distinct && std::find(chosen.begin(), chosen.begin() + pos, r) != chosen.begin() + pos) {
+                    continue;
+                }
+                if (!nutrientsReachable(partial, r, pos)) {
+                    continue;
+                }
+                const double* row = problem_.nutrientRow(r);
+                for (std::size_t n = 0; n < k; ++n) {
+                    next[n] = partial[n] + row[n];
+                }
+                if (cost + problem_.optimisticCost[r] + completionBound(pos + 1, next) >= best) {
+                    continue;
+                }
+                chosen[pos] = r;
+                self(self, pos + 1, cost + problem_.optimisticCost[r]);
+                if (dayNodes > budget) {
+                    return;
+                }
+            }
+        };
+        dfs(dfs, 0, 0.0);
+
+        if (dayNodes > budget) {
+            if (combo) {
+                combo->clear();
+            }
+            return fallback;
+        }
+        return best;
+    }
+
+    /**
+     * Primal heuristic: build the plan one day at a time, each day being the
+     * cheapest one that the recipes still available allow. Gives the search a
+     * good incumbent before it starts branching.
+     */
+    void greedyDays() {
+        const int perDay = problem_.slotsPerDay;
+        std::vector<std::uint16_t> uses(problem_.recipes.size(), 0);
+        std::vector<int> last(problem_.recipes.size(), 0);
+        std::vector<std::uint32_t> plan;
+        std::vector<std::uint32_t> combo;
+        plan.reserve(slotCount_);
+
+        for (int day = 0; day < problem_.days; ++day) {
+            auto blocked = [&](std::uint32_t r) {
+                return uses[r] >= problem_.maxRepeats ||
+                       (uses[r] > 0 && day - last[r] < problem_.minDaysBetweenRepeats);
+            };
+            combo.clear();
+            double cost = cheapestDay(blocked, kRootDayBudget, PlanningProblem::kInfinity,
+                                      PlanningProblem::kInfinity, &combo);
+            if (cost == PlanningProblem::kInfinity || combo.size() != static_cast<std::size_t>(perDay)) {
+                return;
+            }
+            for (auto r : combo) {
+                uses[r]++;
+                last[r] = day;
+                plan.push_back(r);
+            }
+        }
+
+        double cost = 0.0;
+        if (problem_.evaluate(plan, cost) && improves(cost)) {
+            setIncumbent(plan, cost);
+        }
+    }
+};
+
+} // namespace
+
+struct MealPlanner::CachedPlan {
+    Plan plan;
+    std::shared_ptr<const detail::PlanningProblem> problem;  ///< Set only for feasible plans
+    std::unordered_map<std::string, std::uint8_t> allowedTypes;
+    Constraints constraints;
+    std::vector<std::uint32_t> assignment;
+};
+
+MealPlanner::MealPlanner()
+    : MealPlanner(core::Storage::getInstance().getRecipes()) {
+}
+
+MealPlanner::MealPlanner(std::vector<std::shared_ptr<core::Recipe>> recipes)
+    : recipes_(std::move(recipes)) {
+    for (const auto& recipe : recipes_) {
+        if (!recipe) {
+            throw std::invalid_argument("Cannot plan with a null recipe");
+        }
+    }
+}
+
+const std::vector<std::shared_ptr<core::Recipe>>& MealPlanner::getRecipes() const {
+    return recipes_;
+}
+
+std::vector<core::Meal::Type> MealPlanner::getAllowedTypes(const std::string& recipeId) const {
+    auto it = allowedTypes_.find(recipeId);
+    std::uint8_t mask = it != allowedTypes_.end() ? it->second : 0x0F;
+
+    std::vector<core::Meal::Type> types;
+    for (int t = 0; t < detail::PlanningProblem::kTypeCount; ++t) {
+        if (mask & (1u << t)) {
+            types.push_back(static_cast<core::Meal::Type>(t));
+        }
+    }
+    return types;
+}
+
+void MealPlanner::setAllowedTypes(const std::string& recipeId, const std::vector<core::Meal::Type>& types) {
+    if (types.empty()) {
+        throw std::invalid_argument("A recipe must be allowed in at least one meal type");
+    }
+    std::uint8_t mask = 0;
+    for (auto type : types) {
+        mask = static_cast<std::uint8_t>(mask | (1u << static_cast<int>(type)));
+    }
+    allowedTypes_[recipeId] = mask;
+    allowedTypesKeyValid_ = false;
+}
+
+void MealPlanner::invalidateIngredients() {
+    if (recipeKeys_) {
+        recipeKeys_->clear();
+    }
+}
+
+MealPlanner::Plan MealPlanner::plan(const Constraints& constraints) {
+    return plan(constraints, Options());
+}
+
+MealPlanner::Plan MealPlanner::plan(const Constraints& constraints, const Options& options) {
+    return plan(constraints, options, Control());
+}
+
+MealPlanner::Plan MealPlanner::plan(const Constraints& constraints, const Options& options,
+                                    const Control& control) {
+    const auto start = Clock::now();
+    Control limits = control;
+    if (options.timeLimit.count() > 0) {
+        limits.deadline = std::min(limits.deadline, start + options.timeLimit);
+    }
+
+    utils::Fingerprint key;
+    std::uint64_t version = 0;
+    std::shared_ptr<const CachedPlan> record;
+    if (cache_) {
+        // Read before solving, so a concurrent Storage change leaves the entry stale
+        version = core::Storage::getInstance().getVersion();
+        key = requestKey(constraints, options, version);
+        record = cache_->find(key, version);
+    }
+
+    Plan result;
+    if (record) {
+        result = record->plan;
+        result.solveTime = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+    } else {
+        auto problem = std::make_shared<const detail::PlanningProblem>(recipes_, allowedTypes_, constraints);
+        if (options.strategy == Strategy::LOCAL_SEARCH) {
+            result = detail::solveLocalSearch(*problem, options, limits);
+        } else {
+            BranchAndBound solver(*problem, options, limits);
+            result = solver.run();
+        }
+
+        auto solved = std::make_shared<CachedPlan>();
+        solved->plan = result;
+        if (result.feasible) {
+            solved->problem = std::move(problem);
+            solved->allowedTypes = allowedTypes_;
+            solved->constraints = constraints;
+            solved->assignment = solved->problem->toAssignment(result);
+        }
+        record = std::move(solved);
+        // A run cut short by the clock is not reproducible, so it is not shared
+        if (cache_ && (result.optimal || !limits.shouldStop())) {
+            cache_->insert(key, version, record);
+        }
+    }
+
+    if (control.channel) {
+        if (result.feasible) {
+            control.channel->offer(result.totalCost, result);
+        }
+        control.channel->raiseLowerBound(result.lowerBound);
+        control.channel->finish();
+    }
+
+    session_.reset();
+    solved_ = result.feasible ? std::move(record) : nullptr;
+    return result;
+}
+
+std::vector<MealPlanner::FrontPlan> MealPlanner::planFront(const Constraints& constraints) {
+    return planFront(constraints, FrontOptions());
+}
+
+std::vector<MealPlanner::FrontPlan> MealPlanner::planFront(const Constraints& constraints,
+                                                           const FrontOptions& options) {
+    return planFront(constraints, options, FrontControl());
+}
+
+std::vector<MealPlanner::FrontPlan> MealPlanner::planFront(const Constraints& constraints,
+                                                           const FrontOptions& options,
+                                                           const FrontControl& control) {
+    if (options.points == 0) {
+        throw std::invalid_argument("A front needs at least one point");
+    }
+    if (options.population == 0) {
+        throw std::invalid_argument("Population must not be empty");
+    }
+    detail::PlanningProblem problem(recipes_, allowedTypes_, constraints);
+    return detail::solveParetoFront(problem, constraints.pantry, options, control);
+}
+
+void MealPlanner::setCache(std::shared_ptr<Cache> cache) {
+    cache_ = std::move(cache);
+}
+
+utils::Fingerprint MealPlanner::requestKey(const Constraints& constraints, const Options& options,
+                                           std::uint64_t version) {
+    // Recipe fingerprints follow their revisions; ingredients edited in place may come with a Storage change
+    if (!recipeKeys_) {
+        recipeKeys_ = std::make_shared<detail::RecipeKeys>();
+    } else if (version != recipeKeysVersion_) {
+        recipeKeys_->clear();
+    }
+    recipeKeysVersion_ = version;
+    if (!allowedTypesKeyValid_) {
+        utils::FingerprintBuilder types;
+        for (const auto& recipe : recipes_) {
+            auto it = allowedTypes_.find(recipe->getId());
+            types.add(static_cast<int>(it != allowedTypes_.end() ? it->second : 0x0F));
+        }
+        allowedTypesKey_ = types.finish();
+        allowedTypesKeyValid_ = true;
+    }
+
+    // The pantry is hashed on every call: it is small and may be edited in place
+    utils::FingerprintBuilder builder;
+    builder.add(recipeKeys_->catalog(recipes_)).add(allowedTypesKey_);
+    builder.add(constraints.days).add(constraints.servings);
+    builder.add(constraints.maxRepeats).add(constraints.minDaysBetweenRepeats);
+    builder.add(static_cast<std::uint64_t>(constraints.slotsPerDay.size()));
+    for (auto type : constraints.slotsPerDay) {
+        builder.add(static_cast<int>(type));
+    }
+    builder.add(static_cast<std::uint64_t>(constraints.nutrients.size()));
+    for (const auto& target : constraints.nutrients) {
+        builder.add(target.nutrient).add(target.minPerDay).add(target.maxPerDay);
+    }
+    // Of the start date, only which lots have expired by then matters
+    const auto start = detail::PlanningProblem::startOf(constraints);
+    builder.add(static_cast<std::uint64_t>(constraints.pantry.size()));
+    for (const auto& item : constraints.pantry) {
+        builder.add(static_cast<bool>(item));
+        if (item) {
+            detail::addToKey(builder, *item);
+            builder.add(detail::PlanningProblem::usable(*item, start));
+        }
+    }
+
+    // The time limit is left out: only results that do not depend on it are stored
+    builder.add(static_cast<int>(options.strategy)).add(options.relativeGap);
+    builder.add(static_cast<std::uint64_t>(options.maxNodes));
+    if (options.strategy == Strategy::LOCAL_SEARCH) {
+        builder.add(static_cast<std::uint64_t>(options.threads)).add(options.seed);
+        builder.add(static_cast<std::uint64_t>(options.maxEvaluations));
+    }
+    return builder.finish();
+}
+
+MealPlanner::Plan MealPlanner::lockSlot(int day, std::size_t position, const std::string& recipeId) {
+    auto& replanner = session();
+    std::size_t slot = replanner.slotIndex(day, position);
+    return replanner.lock(slot, replanner.recipeIndex(recipeId));
+}
+
+void MealPlanner::unlockSlot(int day, std::size_t position) {
+    auto& replanner = session();
+    replanner.unlock(replanner.slotIndex(day, position));
+}
+
+MealPlanner::Plan MealPlanner::swapRecipe(int day, std::size_t position) {
+    auto& replanner = session();
+    return replanner.swap(replanner.slotIndex(day, position));
+}
+
+MealPlanner::Plan MealPlanner::changeServings(int servings) {
+    return session().setServings(servings);
+}
+
+MealPlanner::Plan MealPlanner::updatePantry(const std::vector<std::shared_ptr<core::Ingredient>>& pantry) {
+    return session().setPantry(pantry);
+}
+
+detail::Replanner& MealPlanner::session() {
+    if (!session_) {
+        if (!solved_) {
+            throw std::logic_error("No feasible plan to edit; call plan() first");
+        }
+        session_ = std::make_shared<detail::Replanner>(solved_->problem, solved_->allowedTypes,
+                                                       solved_->constraints, solved_->assignment);
+    }
+    return *session_;
+}
+
+} // namespace algorithms
+} // namespace smart_food
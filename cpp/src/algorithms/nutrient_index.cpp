@@ -0,0 +1,327 @@
+#include "smart_food/algorithms/nutrient_index.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include "smart_food/core/storage.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+namespace {
+
+/// Points per leaf of the tree
+constexpr std::uint32_t kLeafSize = 64;
+
+/// Catalogs up to this size are one leaf, scanned in full
+constexpr std::uint32_t kBruteForceSize = 2048;
+
+std::vector<std::string> listedNutrients(const std::vector<std::shared_ptr<core::Recipe>>& recipes) {
+    std::set<std::string> nutrients;
+    for (const auto& recipe : recipes) {
+        if (!recipe) {
+            throw std::invalid_argument("Cannot index a null recipe");
+        }
+        for (const auto& entry : recipe->getNutritionalInfo()) {
+            nutrients.insert(entry.first);
+        }
+    }
+    return {nutrients.begin(), nutrients.end()};
+}
+
+/// Heap entry of a match: squared distance, then catalog position
+using Candidate = std::pair<float, std::uint32_t>;
+
+} // namespace
+
+// Constructors
+NutrientIndex::NutrientIndex() : NutrientIndex(core::Storage::getInstance().getRecipes()) {}
+
+NutrientIndex::NutrientIndex(const std::vector<std::shared_ptr<core::Recipe>>& recipes)
+    : NutrientIndex(recipes, listedNutrients(recipes)) {}
+
+NutrientIndex::NutrientIndex(const std::vector<std::shared_ptr<core::Recipe>>& recipes,
+                             const std::vector<std::string>& nutrients)
+    : nutrients_(nutrients) {
+    std::set<std::string> unique(nutrients.begin(), nutrients.end());
+    if (unique.size() != nutrients.size()) {
+        throw std::invalid_argument("Nutrients cannot be listed twice");
+    }
+    build(recipes);
+}
+
+// Operations
+std::vector<NutrientIndex::Match> NutrientIndex::search(const Query& query) const {
+    const std::size_t d = nutrients_.size();
+    std::vector<float> target(d, 0.0f);
+    std::vector<float> weight(d, 0.0f);
+    for (const auto& goal : query.targets) {
+        const std::size_t j = nutrientOf(goal.nutrient);
+        if (!(goal.weight >= 0.0) || !std::isfinite(goal.weight) || !std::isfinite(goal.value)) {
+            throw std::invalid_argument("Target of " + goal.nutrient + " needs a finite value and weight >= 0");
+        }
+        target[j] = static_cast<float>(goal.value / scales_[j]);
+        weight[j] = static_cast<float>(goal.weight);
+    }
+    std::vector<float> low(d, -std::numeric_limits<float>::infinity());
+    std::vector<float> high(d, std::numeric_limits<float>::infinity());
+    for (const auto& range : query.ranges) {
+        const std::size_t j = nutrientOf(range.nutrient);
+        low[j] = std::max(low[j], static_cast<float>(range.min / scales_[j]));
+        high[j] = std::min(high[j], static_cast<float>(range.max / scales_[j]));
+    }
+    std::vector<std::size_t> active;
+    std::vector<std::size_t> bounded;
+    for (std::size_t j = 0; j < d; ++j) {
+        if (weight[j] > 0.0f) {
+            active.push_back(j);
+        }
+        if (low[j] > -std::numeric_limits<float>::infinity() || high[j] < std::numeric_limits<float>::infinity()) {
+            bounded.push_back(j);
+        }
+    }
+    const double maxCost = query.maxCostPerServing;
+    const float maxTime = static_cast<float>(query.maxTotalTime.count());
+
+    std::vector<Match> matches;
+    if (query.limit == 0 || nodes_.empty()) {
+        return matches;
+    }
+
+    // Weighted squared distance from the targets to a node's box
+    auto boxBound = [&](std::uint32_t node) {
+        const float* lo = &boxes_[node * 2 * d];
+        const float* hi = lo + d;
+        float bound = 0.0f;
+        for (std::size_t j : active) {
+            const float gap = std::max({lo[j] - target[j], target[j] - hi[j], 0.0f});
+            bound += weight[j] * gap * gap;
+        }
+        return bound;
+    };
+    auto excluded = [&](std::uint32_t node) {
+        const float* lo = &boxes_[node * 2 * d];
+        const float* hi = lo + d;
+        if (nodes_[node].minCost > maxCost || nodes_[node].minTime > maxTime) {
+            return true;
+        }
+        for (std::size_t j : bounded) {
+            if (hi[j] < low[j] || lo[j] > high[j]) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    std::vector<Candidate> heap;
+    heap.reserve(query.limit + 1);
+    std::vector<float> distances;
+    std::vector<std::pair<float, std::uint32_t>> stack{{boxBound(0), 0}};
+    while (!stack.empty()) {
+        const auto entry = stack.back();
+        stack.pop_back();
+        // Ties are broken by catalog position, so only a strictly worse bound is skipped
+        if (heap.size() == query.limit && entry.first > heap.front().first) {
+            continue;
+        }
+        const Node& node = nodes_[entry.second];
+        if (excluded(entry.second)) {
+            continue;
+        }
+        if (node.left != 0) {
+            const float leftBound = boxBound(node.left);
+            const float rightBound = boxBound(node.right);
+            // The nearer child goes on top of the stack
+            if (leftBound <= rightBound) {
+                stack.emplace_back(rightBound, node.right);
+                stack.emplace_back(leftBound, node.left);
+            } else {
+                stack.emplace_back(leftBound, node.left);
+                stack.emplace_back(rightBound, node.right);
+            }
+            continue;
+        }
+
+        // Leaf: distances column by column, then the bounds, then the heap
+        const std::uint32_t count = node.end - node.begin;
+        distances.assign(count, 0.0f);
+        float* distance = distances.data();
+        for (std::size_t j : active) {
+            const float* column = &coordinates_[j][node.begin];
+            const float t = target[j];
+            const float w = weight[j];
+            for (std::uint32_t i = 0; i < count; ++i) {
+                const float diff = column[i] - t;
+                distance[i] += w * diff * diff;
+            }
+        }
+        for (std::uint32_t i = 0; i < count; ++i) {
+            const std::uint32_t point = node.begin + i;
+            if (costs_[point] > maxCost || times_[point] > maxTime) {
+                continue;
+            }
+            bool inside = true;
+            for (std::size_t j : bounded) {
+                const float value = coordinates_[j][point];
+                inside = inside && value >= low[j] && value <= high[j];
+            }
+            if (!inside) {
+                continue;
+            }
+            const Candidate candidate{distance[i], catalogOrder_[point]};
+            if (heap.size() < query.limit) {
+                heap.push_back(candidate);
+                std::push_heap(heap.begin(), heap.end());
+            } else if (candidate < heap.front()) {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back() = candidate;
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end());
+    matches.reserve(heap.size());
+    for (const auto& candidate : heap) {
+        matches.push_back({byCatalog_[candidate.second], std::sqrt(static_cast<double>(candidate.first))});
+    }
+    return matches;
+}
+
+// Getters
+const std::vector<std::string>& NutrientIndex::getNutrients() const {
+    return nutrients_;
+}
+
+std::size_t NutrientIndex::getRecipeCount() const {
+    return byCatalog_.size();
+}
+
+// Helpers
+void NutrientIndex::build(const std::vector<std::shared_ptr<core::Recipe>>& recipes) {
+    const std::size_t d = nutrients_.size();
+    const auto n = static_cast<std::uint32_t>(recipes.size());
+
+    // Raw values, then scaled by each nutrient's standard deviation
+    std::vector<std::vector<double>> values(d, std::vector<double>(n, 0.0));
+    std::vector<double> costs(n);
+    std::vector<float> times(n);
+    for (std::uint32_t r = 0; r < n; ++r) {
+        const auto& recipe = recipes[r];
+        if (!recipe) {
+            throw std::invalid_argument("Cannot index a null recipe");
+        }
+        if (recipe->getServings() <= 0) {
+            throw std::invalid_argument("Recipe has no servings: " + recipe->getName());
+        }
+        const auto& info = recipe->getNutritionalInfo();
+        for (std::size_t j = 0; j < d; ++j) {
+            auto it = info.find(nutrients_[j]);
+            if (it != info.end()) {
+                values[j][r] = it->second;
+            }
+        }
+        costs[r] = recipe->calculateTotalCost() / recipe->getServings();
+        times[r] = static_cast<float>(recipe->getTotalTime().count());
+    }
+    scales_.assign(d, 1.0);
+    std::vector<std::vector<float>> coordinates(d, std::vector<float>(n));
+    for (std::size_t j = 0; j < d; ++j) {
+        if (n > 1) {
+            const double mean = std::accumulate(values[j].begin(), values[j].end(), 0.0) / n;
+            double variance = 0.0;
+            for (double value : values[j]) {
+                variance += (value - mean) * (value - mean);
+            }
+            const double deviation = std::sqrt(variance / n);
+            if (deviation > 0.0 && std::isfinite(deviation)) {
+                scales_[j] = deviation;
+            }
+        }
+        for (std::uint32_t r = 0; r < n; ++r) {
+            coordinates[j][r] = static_cast<float>(values[j][r] / scales_[j]);
+        }
+    }
+
+    byCatalog_ = recipes;
+    std::vector<std::uint32_t> points(n);
+    std::iota(points.begin(), points.end(), 0u);
+    nodes_.clear();
+    boxes_.clear();
+    if (n > 0) {
+        buildNode(points, 0, n, coordinates, costs, times);
+    }
+
+    // Store everything in leaf order so leaves are contiguous
+    catalogOrder_ = points;
+    coordinates_.assign(d, std::vector<float>(n));
+    costs_.resize(n);
+    times_.resize(n);
+    for (std::uint32_t p = 0; p < n; ++p) {
+        for (std::size_t j = 0; j < d; ++j) {
+            coordinates_[j][p] = coordinates[j][points[p]];
+        }
+        costs_[p] = costs[points[p]];
+        times_[p] = times[points[p]];
+    }
+}
+
+std::uint32_t NutrientIndex::buildNode(std::vector<std::uint32_t>& points, std::uint32_t begin, std::uint32_t end,
+                                       const std::vector<std::vector<float>>& coordinates,
+                                       const std::vector<double>& costs, const std::vector<float>& times) {
+    const std::size_t d = nutrients_.size();
+    const auto index = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.push_back({begin, end, 0, 0, std::numeric_limits<double>::infinity(),
+                      std::numeric_limits<float>::infinity()});
+    boxes_.resize(boxes_.size() + 2 * d);
+    float* lo = &boxes_[index * 2 * d];
+    float* hi = lo + d;
+    std::fill_n(lo, d, std::numeric_limits<float>::infinity());
+    std::fill_n(hi, d, -std::numeric_limits<float>::infinity());
+    for (std::uint32_t p = begin; p < end; ++p) {
+        const std::uint32_t point = points[p];
+        for (std::size_t j = 0; j < d; ++j) {
+            lo[j] = std::min(lo[j], coordinates[j][point]);
+            hi[j] = std::max(hi[j], coordinates[j][point]);
+        }
+        nodes_[index].minCost = std::min(nodes_[index].minCost, costs[point]);
+        nodes_[index].minTime = std::min(nodes_[index].minTime, times[point]);
+    }
+
+    const std::uint32_t count = end - begin;
+    if (count <= kLeafSize || (index == 0 && count <= kBruteForceSize)) {
+        return index;
+    }
+    // Split at the median of the widest nutrient
+    std::size_t widest = 0;
+    for (std::size_t j = 1; j < d; ++j) {
+        if (hi[j] - lo[j] > hi[widest] - lo[widest]) {
+            widest = j;
+        }
+    }
+    if (d == 0 || !(hi[widest] > lo[widest])) {
+        return index;
+    }
+    const std::uint32_t middle = begin + count / 2;
+    const auto& column = coordinates[widest];
+    std::nth_element(points.begin() + begin, points.begin() + middle, points.begin() + end,
+                     [&](std::uint32_t a, std::uint32_t b) { return column[a] < column[b]; });
+    const std::uint32_t left = buildNode(points, begin, middle, coordinates, costs, times);
+    const std::uint32_t right = buildNode(points, middle, end, coordinates, costs, times);
+    nodes_[index].left = left;
+    nodes_[index].right = right;
+    return index;
+}
+
+std::size_t NutrientIndex::nutrientOf(const std::string& nutrient) const {
+    auto it = std::find(nutrients_.begin(), nutrients_.end(), nutrient);
+    if (it == nutrients_.end()) {
+        throw std::invalid_argument("Nutrient is not indexed: " + nutrient);
+    }
+    return static_cast<std::size_t>(it - nutrients_.begin());
+}
+
+} // namespace algorithms
+} // namespace smart_food
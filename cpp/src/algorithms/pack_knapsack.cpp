@@ -0,0 +1,263 @@
+#include "pack_knapsack.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include "smart_food/algorithms/ingredient_index.hpp"
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+namespace {
+
+constexpr double kUnreachable = std::numeric_limits<double>::infinity();
+
+/// Finest grid pack quantities are measured on, in base units
+constexpr double kPackResolution = 0.01;
+
+/// Most cells tabulated for one ingredient before the grid is coarsened
+constexpr std::uint64_t kMaxPackCells = std::uint64_t{1} << 22;
+
+/// bits |= bits << shift, for a bitset of bits.size() words
+void shiftOr(std::vector<std::uint64_t>& bits, std::uint64_t shift) {
+    const std::size_t wordShift = shift / 64;
+    const unsigned bitShift = shift % 64;
+    if (wordShift >= bits.size()) {
+        return;
+    }
+    // Downwards, so every source word is read before it is updated
+    for (std::size_t w = bits.size(); w-- > wordShift;) {
+        std::uint64_t moved = bits[w - wordShift] << bitShift;
+        if (bitShift != 0 && w > wordShift) {
+            moved |= bits[w - wordShift - 1] >> (64 - bitShift);
+        }
+        bits[w] |= moved;
+    }
+}
+
+/// Quantities in [0, limit] some choice of packs adds up to
+std::vector<std::uint64_t> reachable(const std::vector<PackItem>& items, std::uint64_t limit) {
+    std::vector<std::uint64_t> bits(limit / 64 + 1, 0);
+    bits[0] = 1;
+    for (const auto& item : items) {
+        if (item.tiers.empty()) {
+            continue;
+        }
+        std::uint64_t count = std::min<std::uint64_t>(item.stock, limit / item.size);
+        // Bundles of 1, 2, 4, ... packs and a remainder reach every count up to the stock
+        for (std::uint64_t bundle = 1; count > 0; bundle <<= 1) {
+            const std::uint64_t take = std::min(bundle, count);
+            shiftOr(bits, take * item.size);
+            count -= take;
+        }
+    }
+    // Clear the bits past the limit in the last word
+    const unsigned tail = (limit + 1) % 64;
+    if (tail != 0) {
+        bits.back() &= (std::uint64_t{1} << tail) - 1;
+    }
+    return bits;
+}
+
+} // namespace
+
+std::uint64_t coverLimit(const std::vector<PackItem>& items, std::uint64_t demand) {
+    if (demand == 0) {
+        return 0;
+    }
+    std::uint64_t overshoot = 0;
+    std::uint64_t supply = 0;
+    for (const auto& item : items) {
+        if (item.stock == 0 || item.tiers.empty()) {
+            continue;
+        }
+        // A minimal cheapest cover drops below the demand when it loses one
+        // pack, or every pack of an item bought at exactly a tier minimum
+        const std::uint64_t packs = std::min<std::uint64_t>(item.stock, std::max(1u, item.tiers.back().first));
+        overshoot = std::max(overshoot, packs * item.size);
+        supply = std::min(supply + std::uint64_t{item.stock} * item.size,
+                          std::numeric_limits<std::uint64_t>::max() / 2);
+    }
+    return std::min(demand - 1 + overshoot, supply);
+}
+
+PackCover coverDemand(const std::vector<PackItem>& items, std::uint64_t demand) {
+    PackCover cover;
+    cover.packs.assign(items.size(), 0);
+    if (demand == 0) {
+        cover.feasible = true;
+        return cover;
+    }
+
+    std::uint64_t limit = coverLimit(items, demand);
+    if (limit < demand) {
+        return cover;
+    }
+    const auto bits = reachable(items, limit);
+    std::uint64_t top = limit + 1;
+    for (std::size_t w = bits.size(); w-- > demand / 64;) {
+        if (bits[w] != 0) {
+            unsigned bit = 63;
+            while ((bits[w] >> bit & 1) == 0) {
+                --bit;
+            }
+            top = w * 64 + bit;
+            break;
+        }
+    }
+    if (top > limit || top < demand) {
+        return cover;
+    }
+    limit = top;
+
+    const std::size_t cells = static_cast<std::size_t>(limit) + 1;
+    std::vector<double> cost(cells, kUnreachable);
+    std::vector<double> next(cells);
+    std::vector<std::vector<std::uint32_t>> choice(items.size());
+    std::vector<std::uint64_t> queue;
+    cost[0] = 0.0;
+
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        const auto& item = items[i];
+        next = cost;
+        choice[i].assign(cells, 0);
+        const std::uint64_t size = item.size;
+        const std::uint64_t maxPacks = std::min<std::uint64_t>(item.stock, limit / size);
+
+        for (std::size_t t = 0; t < item.tiers.size(); ++t) {
+            const std::uint64_t low = item.tiers[t].first;
+            const std::uint64_t high = std::min<std::uint64_t>(
+                maxPacks, t + 1 < item.tiers.size() ? item.tiers[t + 1].first - 1 : maxPacks);
+            if (low > high) {
+                continue;
+            }
+            const double price = item.tiers[t].second;
+            // Buying n in [low, high] packs moves cell r + (k - n) size to r + k size
+            // at n * price; the best source is a window minimum of cost - j * price
+            for (std::uint64_t r = 0; r < size && r < cells; ++r) {
+                const std::uint64_t positions = (limit - r) / size + 1;
+                queue.resize(positions);
+                std::size_t head = 0;
+                std::size_t tail = 0;
+                auto key = [&](std::uint64_t j) { return cost[r + j * size] - static_cast<double>(j) * price; };
+                for (std::uint64_t k = low; k < positions; ++k) {
+                    const std::uint64_t j = k - low;
+                    if (cost[r + j * size] != kUnreachable) {
+                        const double value = key(j);
+                        while (tail > head && key(queue[tail - 1]) >= value) {
+                            --tail;
+                        }
+                        queue[tail++] = j;
+                    }
+                    while (tail > head && queue[head] + high < k) {
+                        ++head;
+                    }
+                    if (tail == head) {
+                        continue;
+                    }
+                    const std::uint64_t source = queue[head];
+                    const double candidate = cost[r + source * size] + static_cast<double>(k - source) * price;
+                    const std::size_t q = r + k * size;
+                    if (candidate < next[q]) {
+                        next[q] = candidate;
+                        choice[i][q] = static_cast<std::uint32_t>(k - source);
+                    }
+                }
+            }
+        }
+        cost.swap(next);
+    }
+
+    std::uint64_t best = demand;
+    for (std::uint64_t q = demand + 1; q <= limit; ++q) {
+        if (cost[q] < cost[best]) {
+            best = q;
+        }
+    }
+    if (cost[best] == kUnreachable) {
+        return cover;
+    }
+    cover.feasible = true;
+    cover.cost = cost[best];
+    cover.cells = best;
+    for (std::size_t i = items.size(); i-- > 0;) {
+        cover.packs[i] = choice[i][best];
+        best -= std::uint64_t{cover.packs[i]} * items[i].size;
+    }
+    return cover;
+}
+
+PackCover coverWithOffers(const std::vector<const core::PackOffer*>& offers, double baseQuantity) {
+    // Pack sizes in grid ticks; cells are the largest grid they are all whole multiples of
+    std::vector<std::uint64_t> ticks(offers.size());
+    std::uint64_t cell = 0;
+    for (std::size_t o = 0; o < offers.size(); ++o) {
+        const double base = IngredientIndex::toBaseQuantity(offers[o]->getPackSize(), offers[o]->getUnit());
+        ticks[o] = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::llround(base / kPackResolution)));
+        cell = std::gcd(cell, ticks[o]);
+    }
+    if (cell == 0) {
+        PackCover cover;
+        cover.feasible = !(baseQuantity > 0.0);
+        return cover;
+    }
+
+    std::vector<PackItem> items;
+    std::vector<std::size_t> itemOffer;
+    auto tabulate = [&](std::uint64_t cellTicks) {
+        items.clear();
+        itemOffer.clear();
+        for (std::size_t o = 0; o < offers.size(); ++o) {
+            PackItem item;
+            item.size = ticks[o] / cellTicks;
+            item.stock = static_cast<std::uint32_t>(offers[o]->getStock());
+            if (item.size == 0 || item.stock == 0) {
+                continue;
+            }
+            item.tiers.emplace_back(1u, offers[o]->getPackPrice());
+            for (const auto& tier : offers[o]->getPriceTiers()) {
+                item.tiers.emplace_back(static_cast<std::uint32_t>(tier.minPacks), tier.packPrice);
+            }
+            items.push_back(std::move(item));
+            itemOffer.push_back(o);
+        }
+        return static_cast<std::uint64_t>(std::ceil(std::max(0.0, baseQuantity) / kPackResolution / cellTicks - 1e-9));
+    };
+
+    std::uint64_t needed = tabulate(cell);
+    const std::uint64_t limit = coverLimit(items, needed);
+    if (limit > kMaxPackCells) {
+        // Rounding pack sizes down keeps the cover sufficient on the coarser grid
+        cell *= (limit + kMaxPackCells - 1) / kMaxPackCells;
+        needed = tabulate(cell);
+    }
+
+    const PackCover onGrid = coverDemand(items, needed);
+    PackCover cover;
+    cover.feasible = onGrid.feasible;
+    cover.cost = onGrid.cost;
+    cover.cells = onGrid.cells;
+    cover.packs.assign(offers.size(), 0);
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        cover.packs[itemOffer[i]] = onGrid.packs[i];
+    }
+    return cover;
+}
+
+std::size_t repriceOffers(std::vector<core::PackOffer>& offers, const core::PriceHistory& history) {
+    std::size_t repriced = 0;
+    for (auto& offer : offers) {
+        if (!history.hasSeries(offer.getIngredient(), offer.getStore())) {
+            continue;
+        }
+        const double unitPrice = history.latestPrice(offer.getIngredient(), offer.getStore()).price;
+        offer.setPackPrice(unitPrice * IngredientIndex::toBaseQuantity(offer.getPackSize(), offer.getUnit()));
+        ++repriced;
+    }
+    return repriced;
+}
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
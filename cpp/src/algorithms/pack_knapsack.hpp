@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "smart_food/core/pack_offer.hpp"
+#include "smart_food/core/price_history.hpp"
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+/**
+ * @brief One way to buy an ingredient: whole packs at tiered prices.
+ *
+ * Quantities are measured in cells, the common grid all pack sizes of the
+ * ingredient are expressed on.
+ */
+struct PackItem {
+    std::uint64_t size = 1;  ///< Cells per pack, positive
+    std::uint32_t stock = 0; ///< Most packs that can be bought
+    /// (minPacks, price per pack) by increasing minPacks; the first has minPacks 1
+    std::vector<std::pair<std::uint32_t, double>> tiers;
+};
+
+/**
+ * @brief Result of coverDemand()
+ */
+struct PackCover {
+    bool feasible = false;
+    std::vector<std::uint32_t> packs;  ///< Item -> packs bought
+    double cost = 0.0;
+    std::uint64_t cells = 0;           ///< Quantity bought
+};
+
+/**
+ * @brief Buy packs covering a demand at the lowest total price.
+ *
+ * A bounded knapsack over quantity. Reachable quantities are found first
+ * with word-parallel shift-or transitions on a bitset, splitting each
+ * item's stock into power-of-two bundles; that settles feasibility and
+ * trims the table to the largest useful quantity. The minimum-cost table
+ * is then filled item by item, one tier at a time: inside a tier the price
+ * is linear in the pack count, so each residue class modulo the pack size
+ * is a sliding-window minimum kept in a monotone queue, which makes every
+ * tier linear in the table size whatever the stock.
+ *
+ * Never buying more than the demand plus one pack (or one discount tier)
+ * of any item bounds the table: a cheaper cover exists otherwise.
+ *
+ * @param items The ways to buy
+ * @param demand Cells to cover; the table has coverLimit() + 1 entries
+ * @return The cheapest cover with the smallest quantity among equal prices
+ */
+PackCover coverDemand(const std::vector<PackItem>& items, std::uint64_t demand);
+
+/**
+ * @brief Largest quantity coverDemand() may need to tabulate for a demand
+ */
+std::uint64_t coverLimit(const std::vector<PackItem>& items, std::uint64_t demand);
+
+/**
+ * @brief Cheapest packs from a set of offers covering a quantity of one ingredient.
+ *
+ * The offers are put on the largest grid of 0.01 base units that divides
+ * every pack size, and coverDemand() runs on it. If that table would exceed
+ * a few million cells the grid is coarsened with pack sizes rounded down,
+ * so the cover stays sufficient at a possibly higher price.
+ *
+ * @param offers Offers for the ingredient, all in units of its dimension
+ * @param baseQuantity Quantity to cover, in the base unit of that dimension
+ * @return The cover; PackCover::packs follows the order of offers
+ */
+PackCover coverWithOffers(const std::vector<const core::PackOffer*>& offers, double baseQuantity);
+
+/**
+ * @brief Reprice offers from the latest prices of a price history.
+ *
+ * An offer reads the series of its ingredient name, as written in the
+ * offer, at its store; the price there is per base unit (g, ml or piece)
+ * and is scaled to the pack size. Offers without a series keep their price.
+ *
+ * @return Number of offers repriced
+ */
+std::size_t repriceOffers(std::vector<core::PackOffer>& offers, const core::PriceHistory& history);
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,615 @@
+#include "pareto_search.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <thread>
+#include "smart_food/utils/thread_pool.hpp"
+#include "local_search.hpp"
+#include "plan_state.hpp"
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kObjectives = 4;       ///< Cost, nutrition error, prep time, waste
+constexpr std::size_t kGreedyWidth = 8;      ///< Best candidates drawn from when building a start
+constexpr std::size_t kWindow = 8;           ///< Consecutive candidates scored together by a repair step
+constexpr std::size_t kRepairSteps = 4;      ///< Repair steps per slot before a child is left infeasible
+constexpr double kCrossoverRate = 0.9;       ///< Probability that a child mixes the days of both parents
+constexpr double kMutationsPerChild = 2.0;   ///< Expected number of slots given a random recipe
+constexpr std::size_t kArchivePerPoint = 4;  ///< Archive capacity per point requested
+
+using Scores = std::array<double, kObjectives>;
+
+/// SplitMix64 finalizer, used to derive independent child seeds from one seed
+std::uint64_t mixSeed(std::uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+struct Individual {
+    std::vector<std::uint32_t> plan;
+    Scores scores{};
+    double violation = 0.0;  ///< PlanState::violation() of the plan
+    bool feasible = false;   ///< Confirmed by PlanningProblem::evaluate()
+    std::size_t rank = 0;    ///< Index of its nondominated front
+    double crowding = 0.0;   ///< Crowding distance within its front
+};
+
+/// Constrained domination: feasible plans first, then less violation, then Pareto dominance
+bool dominates(const Individual& a, const Individual& b) {
+    if (a.feasible != b.feasible) {
+        return a.feasible;
+    }
+    if (!a.feasible) {
+        return a.violation < b.violation;
+    }
+    bool better = false;
+    for (std::size_t k = 0; k < kObjectives; ++k) {
+        if (a.scores[k] > b.scores[k]) {
+            return false;
+        }
+        better = better || a.scores[k] < b.scores[k];
+    }
+    return better;
+}
+
+/// Set the rank of every member and return the fronts, best first
+std::vector<std::vector<std::size_t>> sortFronts(std::vector<Individual>& people) {
+    const std::size_t n = people.size();
+    std::vector<std::vector<std::size_t>> beats(n);
+    std::vector<std::size_t> beatenBy(n, 0);
+    for (std::size_t a = 0; a < n; ++a) {
+        for (std::size_t b = a + 1; b < n; ++b) {
+            if (dominates(people[a], people[b])) {
+                beats[a].push_back(b);
+                ++beatenBy[b];
+            } else if (dominates(people[b], people[a])) {
+                beats[b].push_back(a);
+                ++beatenBy[a];
+            }
+        }
+    }
+
+    std::vector<std::vector<std::size_t>> fronts(1);
+    for (std::size_t a = 0; a < n; ++a) {
+        if (beatenBy[a] == 0) {
+            people[a].rank = 0;
+            fronts[0].push_back(a);
+        }
+    }
+    for (std::size_t f = 0; !fronts[f].empty(); ++f) {
+        std::vector<std::size_t> next;
+        for (auto a : fronts[f]) {
+            for (auto b : beats[a]) {
+                if (--beatenBy[b] == 0) {
+                    people[b].rank = f + 1;
+                    next.push_back(b);
+                }
+            }
+        }
+        fronts.push_back(std::move(next));
+    }
+    fronts.pop_back();
+    return fronts;
+}
+
+/// Crowding distance of the given members among themselves; the extremes of every objective get infinity
+void assignCrowding(std::vector<Individual>& people, const std::vector<std::size_t>& members) {
+    for (auto i : members) {
+        people[i].crowding = 0.0;
+    }
+    if (members.empty()) {
+        return;
+    }
+    std::vector<std::size_t> order(members);
+    for (std::size_t k = 0; k < kObjectives; ++k) {
+        std::sort(order.begin(), order.end(), [&people, k](std::size_t a, std::size_t b) {
+            return people[a].scores[k] < people[b].scores[k] || (people[a].scores[k] == people[b].scores[k] && a < b);
+        });
+        const double low = people[order.front()].scores[k];
+        const double high = people[order.back()].scores[k];
+        people[order.front()].crowding = std::numeric_limits<double>::infinity();
+        people[order.back()].crowding = std::numeric_limits<double>::infinity();
+        if (!(high > low)) {
+            continue;
+        }
+        for (std::size_t j = 1; j + 1 < order.size(); ++j) {
+            people[order[j]].crowding += (people[order[j + 1]].scores[k] - people[order[j - 1]].scores[k]) / (high - low);
+        }
+    }
+}
+
+/// Drop the most crowded member until `count` remain
+void thin(std::vector<Individual>& people, std::size_t count) {
+    std::vector<std::size_t> all;
+    while (people.size() > count) {
+        all.resize(people.size());
+        std::iota(all.begin(), all.end(), 0);
+        assignCrowding(people, all);
+        auto victim = std::min_element(people.begin(), people.end(), [](const Individual& a, const Individual& b) {
+            return a.crowding < b.crowding;
+        });
+        people.erase(victim);
+    }
+}
+
+/// Scratch state of one evaluation thread
+struct Workspace {
+    explicit Workspace(const PlanningProblem& problem) : state(problem) {}
+
+    PlanState state;
+    std::vector<double> stock;
+    PlanningProblem::StockTrail trail;
+    std::vector<double> daily;
+};
+
+class FrontSearch {
+public:
+    FrontSearch(const PlanningProblem& problem, const std::vector<std::shared_ptr<core::Ingredient>>& pantry,
+                const MealPlanner::FrontOptions& options, const MealPlanner::FrontControl& control)
+        : problem_(problem)
+        , options_(options)
+        , control_(control)
+        , slotCount_(problem.slotCount())
+        , minutes_(problem.recipes.size(), 0.0)
+        , expiring_(problem.pantryStock.size(), 0.0)
+        , expiringValue_(problem.pantryStock.size(), 0.0)
+        , repairProblem_(problem) {
+        // Feasibility does not depend on the pantry, and repair is much faster without it
+        repairProblem_.hasPantry = false;
+        repairProblem_.stockSignature = 0;
+        std::fill(repairProblem_.pantryStock.begin(), repairProblem_.pantryStock.end(), 0.0);
+
+        for (std::size_t r = 0; r < problem.recipes.size(); ++r) {
+            minutes_[r] = static_cast<double>(problem.recipes[r]->getTotalTime().count());
+        }
+        for (std::size_t n = 0; n < problem.nutrientCount; ++n) {
+            if (std::isfinite(problem.nutrientMin[n]) && std::isfinite(problem.nutrientMax[n]) &&
+                problem.nutrientMax[n] > problem.nutrientMin[n]) {
+                ranged_.push_back(n);
+            }
+        }
+
+        // Usable stock expiring before the end of the horizon; an epoch expiry date means it keeps
+        const auto first = options.start == std::chrono::system_clock::time_point{} ? problem.start : options.start;
+        const auto end = first + std::chrono::hours(24 * problem.days);
+        for (const auto& item : pantry) {
+            if (!item || item->getExpiryDate() == std::chrono::system_clock::time_point{} ||
+                item->getExpiryDate() >= end || !PlanningProblem::usable(*item, problem.start)) {
+                continue;
+            }
+            std::uint32_t id = problem.ingredients.find(*item);
+            if (id != IngredientIndex::npos) {
+                const double quantity = IngredientIndex::baseQuantity(*item);
+                expiring_[id] += quantity;
+                expiringValue_[id] += quantity * IngredientIndex::basePrice(*item);
+            }
+        }
+        for (std::size_t id = 0; id < expiring_.size(); ++id) {
+            if (expiring_[id] > 0.0) {
+                expiringIds_.push_back(static_cast<std::uint32_t>(id));
+            }
+        }
+
+        // One unit of violation outweighs the cost of any plan, so repair restores feasibility first
+        double total = 0.0;
+        for (double cost : problem.purchaseCost) {
+            total += cost;
+        }
+        const double perSlot = problem.recipes.empty() ? 0.0 : total / static_cast<double>(problem.recipes.size());
+        penaltyWeight_ = 1e3 * std::max(1.0, perSlot * static_cast<double>(slotCount_));
+
+        byTime_ = problem.candidates;
+        byWaste_ = problem.candidates;
+        std::vector<double> rescued(problem.recipes.size(), 0.0);
+        for (std::size_t r = 0; r < problem.recipes.size(); ++r) {
+            for (std::uint32_t i = problem.needBegin[r]; i < problem.needBegin[r + 1]; ++i) {
+                const std::uint32_t id = problem.needId[i];
+                if (expiring_[id] > 0.0) {
+                    rescued[r] += std::min(problem.needQuantity[i], expiring_[id]) * expiringValue_[id] / expiring_[id];
+                }
+            }
+        }
+        for (int t = 0; t < PlanningProblem::kTypeCount; ++t) {
+            std::stable_sort(byTime_[t].begin(), byTime_[t].end(), [this](std::uint32_t a, std::uint32_t b) {
+                return minutes_[a] < minutes_[b];
+            });
+            std::stable_sort(byWaste_[t].begin(), byWaste_[t].end(), [&rescued](std::uint32_t a, std::uint32_t b) {
+                return rescued[a] > rescued[b];
+            });
+        }
+    }
+
+    std::vector<MealPlanner::FrontPlan> run() {
+        start_ = Clock::now();
+        deadline_ = control_.deadline;
+        if (options_.timeLimit.count() > 0) {
+            deadline_ = std::min(deadline_, start_ + options_.timeLimit);
+        }
+        const double bound = problem_.varietyBound();
+        if (bound == PlanningProblem::kInfinity) {
+            // Some slot type does not have enough recipes: provably infeasible
+            if (control_.channel) {
+                control_.channel->finish();
+            }
+            return {};
+        }
+
+        std::size_t threads = options_.threads;
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        utils::ThreadPool pool(threads);
+        std::vector<Workspace> spaces;
+        spaces.reserve(threads);
+        for (std::size_t t = 0; t < threads; ++t) {
+            spaces.emplace_back(repairProblem_);
+        }
+
+        const std::size_t size = options_.population;
+        std::vector<Individual> population = seedPopulation(pool, spaces);
+        for (const auto& front : sortFronts(population)) {
+            assignCrowding(population, front);
+        }
+        keep(population);
+        publish(bound);
+
+        std::vector<Individual> offspring(size);
+        std::vector<std::pair<std::size_t, std::size_t>> parents(size);
+        for (std::size_t generation = 1; generation <= options_.generations && !stopped(); ++generation) {
+            std::mt19937_64 rng(mixSeed(options_.seed ^ mixSeed(generation)));
+            for (auto& pair : parents) {
+                pair = {tournament(population, rng), tournament(population, rng)};
+            }
+            forEach(pool, spaces, size, [&](std::size_t i, Workspace& space) {
+                std::mt19937_64 childRng(mixSeed(options_.seed ^ mixSeed(generation * size + i)));
+                breed(population[parents[i].first], population[parents[i].second], childRng, space, offspring[i]);
+            });
+            count(size);
+
+            // Keep the best of parents and children by front, then by crowding distance
+            std::vector<Individual> combined = std::move(population);
+            combined.insert(combined.end(), offspring.begin(), offspring.end());
+            population.clear();
+            for (const auto& front : sortFronts(combined)) {
+                assignCrowding(combined, front);
+                std::vector<std::size_t> members(front);
+                if (population.size() + members.size() > size) {
+                    std::stable_sort(members.begin(), members.end(), [&combined](std::size_t a, std::size_t b) {
+                        return combined[a].crowding > combined[b].crowding;
+                    });
+                    members.resize(size - population.size());
+                }
+                for (auto i : members) {
+                    population.push_back(std::move(combined[i]));
+                }
+                if (population.size() == size) {
+                    break;
+                }
+            }
+            keep(population);
+            publish(bound);
+        }
+
+        std::vector<MealPlanner::FrontPlan> front = toFront(archive_, bound);
+        if (control_.channel) {
+            control_.channel->offer(-static_cast<double>(++published_), front);
+            control_.channel->finish();
+        }
+        return front;
+    }
+
+private:
+    const PlanningProblem& problem_;
+    const MealPlanner::FrontOptions& options_;
+    const MealPlanner::FrontControl& control_;
+    const std::size_t slotCount_;
+    std::vector<double> minutes_;          ///< Recipe -> total time in minutes
+    std::vector<std::size_t> ranged_;      ///< Nutrients with a finite, non-empty daily range
+    std::vector<double> expiring_;         ///< Identity -> base quantity expiring within the horizon
+    std::vector<double> expiringValue_;    ///< Identity -> value of that quantity
+    std::vector<std::uint32_t> expiringIds_;
+    std::vector<std::vector<std::uint32_t>> byTime_;   ///< Type -> candidates by prep time
+    std::vector<std::vector<std::uint32_t>> byWaste_;  ///< Type -> candidates by expiring stock used, most first
+    PlanningProblem repairProblem_;        ///< The problem without its pantry, for the workspaces
+    double penaltyWeight_ = 1.0;
+    Clock::time_point start_;
+    Clock::time_point deadline_;
+    std::size_t evaluations_ = 0;
+    std::vector<Individual> archive_;      ///< Feasible plans no plan met so far dominates
+    bool archiveChanged_ = false;          ///< The archive changed since the last publish()
+    std::size_t published_ = 0;            ///< Fronts offered on the channel
+
+    /// Add evaluations to the total and the channel's iteration count
+    void count(std::size_t evaluations) {
+        evaluations_ += evaluations;
+        if (control_.channel) {
+            control_.channel->addIterations(evaluations);
+        }
+    }
+
+    bool stopped() const {
+        return Clock::now() >= deadline_ || control_.cancellation.isCancelled();
+    }
+
+    /// Up to options_.points archived plans, thinned by crowding distance, by increasing scores
+    std::vector<MealPlanner::FrontPlan> toFront(std::vector<Individual> members, double bound) const {
+        thin(members, options_.points);
+        std::sort(members.begin(), members.end(), [](const Individual& a, const Individual& b) {
+            return a.scores < b.scores;
+        });
+        const auto solveTime = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start_);
+        std::vector<MealPlanner::FrontPlan> front;
+        front.reserve(members.size());
+        for (const auto& member : members) {
+            MealPlanner::FrontPlan point;
+            point.plan = problem_.toPlan(member.plan);
+            point.plan.feasible = true;
+            point.plan.lowerBound = std::min(bound, point.plan.totalCost);
+            point.plan.nodesExplored = evaluations_;
+            point.plan.solveTime = solveTime;
+            point.objectives.cost = point.plan.totalCost;
+            point.objectives.nutritionError = member.scores[1];
+            point.objectives.prepTime = std::chrono::minutes(std::llround(member.scores[2]));
+            point.objectives.waste = member.scores[3];
+            front.push_back(std::move(point));
+        }
+        return front;
+    }
+
+    /// Offer the current front on the channel if the archive changed; later fronts get lower costs
+    void publish(double bound) {
+        if (!control_.channel || !archiveChanged_ || archive_.empty()) {
+            return;
+        }
+        archiveChanged_ = false;
+        control_.channel->offer(-static_cast<double>(++published_), toFront(archive_, bound));
+    }
+
+    /// Run body(i, workspace) for every i in [0, count), one workspace per task
+    template <typename Body>
+    void forEach(utils::ThreadPool& pool, std::vector<Workspace>& spaces, std::size_t count, const Body& body) const {
+        const std::size_t tasks = spaces.size();
+        pool.parallelFor(tasks, [&](std::size_t task) {
+            for (std::size_t i = task; i < count; i += tasks) {
+                body(i, spaces[task]);
+            }
+        });
+    }
+
+    /// Anchors first, then greedy plans favoring cost, prep time, expiring stock and nothing in turn
+    std::vector<Individual> seedPopulation(utils::ThreadPool& pool, std::vector<Workspace>& spaces) {
+        std::vector<std::vector<std::uint32_t>> anchors;
+        if (options_.anchorEvaluations > 0) {
+            anchors.push_back(anchor(problem_));
+
+            PlanningProblem timed = problem_;
+            timed.purchaseCost = minutes_;
+            timed.optimisticCost = minutes_;
+            std::fill(timed.pantryStock.begin(), timed.pantryStock.end(), 0.0);
+            timed.hasPantry = false;
+            timed.stockSignature = 0;
+            timed.rankCandidates();
+            anchors.push_back(anchor(timed));
+        }
+        anchors.erase(std::remove_if(anchors.begin(), anchors.end(),
+                                     [](const std::vector<std::uint32_t>& plan) { return plan.empty(); }),
+                      anchors.end());
+
+        const std::size_t size = options_.population;
+        std::vector<Individual> population(size);
+        forEach(pool, spaces, size, [&](std::size_t i, Workspace& space) {
+            std::mt19937_64 rng(mixSeed(options_.seed ^ mixSeed(i)));
+            if (i < anchors.size()) {
+                population[i].plan = anchors[i];
+            } else {
+                switch ((i - anchors.size()) % 4) {
+                case 0: population[i].plan = greedyStart(problem_.candidates, kGreedyWidth, rng); break;
+                case 1: population[i].plan = greedyStart(byTime_, kGreedyWidth, rng); break;
+                case 2: population[i].plan = greedyStart(byWaste_, kGreedyWidth, rng); break;
+                default: population[i].plan = greedyStart(problem_.candidates, problem_.recipes.size(), rng); break;
+                }
+            }
+            space.state.load(population[i].plan);
+            repair(space.state, rng);
+            finish(population[i], space);
+        });
+        count(size);
+        return population;
+    }
+
+    /// Best plan of local search on a problem whose purchase costs stand for one objective
+    std::vector<std::uint32_t> anchor(const PlanningProblem& problem) {
+        MealPlanner::Options options;
+        options.strategy = MealPlanner::Strategy::LOCAL_SEARCH;
+        options.threads = options_.threads;
+        options.seed = options_.seed;
+        options.maxEvaluations = options_.anchorEvaluations;
+        MealPlanner::Control control;
+        control.deadline = deadline_;
+        control.cancellation = control_.cancellation;
+        MealPlanner::Plan plan = solveLocalSearch(problem, options, control);
+        count(plan.nodesExplored);
+        return plan.feasible ? problem.toAssignment(plan) : std::vector<std::uint32_t>();
+    }
+
+    /// Plan honoring variety where possible, drawn among the first `width` allowed candidates of each list
+    std::vector<std::uint32_t> greedyStart(const std::vector<std::vector<std::uint32_t>>& lists, std::size_t width,
+                                           std::mt19937_64& rng) const {
+        const int perDay = problem_.slotsPerDay;
+        std::vector<std::uint16_t> uses(problem_.recipes.size(), 0);
+        std::vector<int> last(problem_.recipes.size(), 0);
+        std::vector<std::uint32_t> plan(slotCount_);
+        std::vector<std::uint32_t> options;
+
+        for (std::size_t s = 0; s < slotCount_; ++s) {
+            const int day = static_cast<int>(s) / perDay;
+            const auto& list = lists[problem_.slotType[s % perDay]];
+            options.clear();
+            for (auto r : list) {
+                if (uses[r] < problem_.maxRepeats && (uses[r] == 0 || day - last[r] >= problem_.minDaysBetweenRepeats)) {
+                    options.push_back(r);
+                    if (options.size() == width) {
+                        break;
+                    }
+                }
+            }
+            const auto& pool = options.empty() ? list : options;
+            const std::uint32_t r = pool[std::uniform_int_distribution<std::size_t>(0, pool.size() - 1)(rng)];
+            plan[s] = r;
+            uses[r]++;
+            last[r] = day;
+        }
+        return plan;
+    }
+
+    /// Binary tournament by front, then by crowding distance
+    static std::size_t tournament(const std::vector<Individual>& people, std::mt19937_64& rng) {
+        std::uniform_int_distribution<std::size_t> pick(0, people.size() - 1);
+        const std::size_t a = pick(rng);
+        const std::size_t b = pick(rng);
+        if (people[a].rank != people[b].rank) {
+            return people[a].rank < people[b].rank ? a : b;
+        }
+        return people[b].crowding > people[a].crowding ? b : a;
+    }
+
+    /// Day-wise crossover and slot mutation, then repair and evaluation
+    void breed(const Individual& a, const Individual& b, std::mt19937_64& rng, Workspace& space,
+               Individual& child) const {
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        child.plan = a.plan;
+        if (unit(rng) < kCrossoverRate) {
+            for (int day = 0; day < problem_.days; ++day) {
+                if (rng() & 1u) {
+                    const std::size_t first = static_cast<std::size_t>(day) * problem_.slotsPerDay;
+                    std::copy_n(b.plan.begin() + static_cast<std::ptrdiff_t>(first), problem_.slotsPerDay,
+                                child.plan.begin() + static_cast<std::ptrdiff_t>(first));
+                }
+            }
+        }
+        const double rate = kMutationsPerChild / static_cast<double>(slotCount_);
+        for (std::size_t s = 0; s < slotCount_; ++s) {
+            if (unit(rng) < rate) {
+                const auto& list = problem_.candidates[problem_.slotType[s % problem_.slotsPerDay]];
+                child.plan[s] = list[std::uniform_int_distribution<std::size_t>(0, list.size() - 1)(rng)];
+            }
+        }
+        space.state.load(child.plan);
+        repair(space.state, rng);
+        finish(child, space);
+    }
+
+    /// Replace slots with the best of random candidate windows until the plan is feasible or the budget runs out
+    void repair(PlanState& state, std::mt19937_64& rng) const {
+        std::uniform_int_distribution<std::size_t> pickSlot(0, slotCount_ - 1);
+        std::array<double, kWindow> scores;
+        for (std::size_t step = 0; step < kRepairSteps * slotCount_ && !state.feasible(); ++step) {
+            const std::size_t slot = pickSlot(rng);
+            const auto& list = problem_.candidates[problem_.slotType[slot % problem_.slotsPerDay]];
+            const std::size_t width = std::min(kWindow, list.size());
+            const std::size_t first = std::uniform_int_distribution<std::size_t>(0, list.size() - width)(rng);
+            state.scoreCandidates(slot, first, width, penaltyWeight_, scores.data());
+            const std::size_t best = static_cast<std::size_t>(std::min_element(scores.begin(), scores.begin() + width) -
+                                                              scores.begin());
+            if (scores[best] < state.score(penaltyWeight_)) {
+                state.assign(slot, list[first + best]);
+            }
+        }
+    }
+
+    /// Take the plan held by the workspace and compute its objectives
+    void finish(Individual& person, Workspace& space) const {
+        person.plan = space.state.assignment();
+        person.violation = space.state.violation();
+        double exact = 0.0;
+        person.feasible = space.state.feasible() && problem_.evaluate(person.plan, exact);
+
+        auto& stock = space.stock;
+        stock = problem_.pantryStock;
+        space.trail.clear();
+        auto& daily = space.daily;
+        daily.assign(problem_.nutrientCount, 0.0);
+        double cost = 0.0;
+        double minutes = 0.0;
+        double error = 0.0;
+        for (std::size_t s = 0; s < slotCount_; ++s) {
+            const std::uint32_t r = person.plan[s];
+            cost += problem_.hasPantry ? problem_.consumeStock(r, stock, space.trail) : problem_.purchaseCost[r];
+            minutes += minutes_[r];
+            const double* row = problem_.nutrientRow(r);
+            for (std::size_t n = 0; n < problem_.nutrientCount; ++n) {
+                daily[n] += row[n];
+            }
+            if (static_cast<int>(s % problem_.slotsPerDay) == problem_.slotsPerDay - 1) {
+                for (auto n : ranged_) {
+                    const double middle = 0.5 * (problem_.nutrientMin[n] + problem_.nutrientMax[n]);
+                    const double halfWidth = 0.5 * (problem_.nutrientMax[n] - problem_.nutrientMin[n]);
+                    error += std::abs(daily[n] - middle) / halfWidth;
+                }
+                std::fill(daily.begin(), daily.end(), 0.0);
+            }
+        }
+        if (!ranged_.empty()) {
+            error /= static_cast<double>(problem_.days) * static_cast<double>(ranged_.size());
+        }
+
+        // Expiring stock is consumed first among the stock of its identity
+        double waste = 0.0;
+        for (auto id : expiringIds_) {
+            const double consumed = problem_.pantryStock[id] - stock[id];
+            const double left = std::max(0.0, expiring_[id] - consumed);
+            waste += left * expiringValue_[id] / expiring_[id];
+        }
+        person.scores = {cost, error, minutes, waste};
+    }
+
+    /// Add the feasible first-front members to the archive
+    void keep(const std::vector<Individual>& people) {
+        for (const auto& person : people) {
+            if (!person.feasible || person.rank != 0) {
+                continue;
+            }
+            bool covered = false;
+            for (const auto& member : archive_) {
+                if (member.scores == person.scores || dominates(member, person)) {
+                    covered = true;
+                    break;
+                }
+            }
+            if (covered) {
+                continue;
+            }
+            archive_.erase(std::remove_if(archive_.begin(), archive_.end(),
+                                          [&person](const Individual& member) { return dominates(person, member); }),
+                           archive_.end());
+            archive_.push_back(person);
+            archiveChanged_ = true;
+        }
+        thin(archive_, options_.points * kArchivePerPoint);
+    }
+};
+
+} // namespace
+
+std::vector<MealPlanner::FrontPlan> solveParetoFront(const PlanningProblem& problem,
+                                                     const std::vector<std::shared_ptr<core::Ingredient>>& pantry,
+                                                     const MealPlanner::FrontOptions& options,
+                                                     const MealPlanner::FrontControl& control) {
+    FrontSearch search(problem, pantry, options, control);
+    return search.run();
+}
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
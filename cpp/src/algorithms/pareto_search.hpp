@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "smart_food/algorithms/meal_planner.hpp"
+#include "planning_problem.hpp"
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+/**
+ * @brief NSGA-II search of the cost, nutrition, prep time and waste front.
+ *
+ * The population starts from two anchors, the cheapest and the quickest
+ * plans found by solveLocalSearch() (the quickest on a copy of the problem
+ * whose slot costs are prep minutes), and from randomized greedy plans that
+ * favor cost, prep time, use of expiring stock or nothing. Each generation
+ * breeds as many children as the population by day-wise crossover and slot
+ * mutation, repairs them toward feasibility with the batch scoring of
+ * PlanState on a copy of the problem without its pantry (which feasibility
+ * does not depend on), and keeps the best of parents and children by
+ * nondominated rank and crowding distance. Infeasible plans only beat
+ * plans that violate the constraints more.
+ *
+ * Children are bred and evaluated in parallel, each with its own random
+ * generator derived from the seed, so the result is a function of the seed
+ * and thread count only. Every feasible nondominated plan met is kept in an
+ * archive, which is thinned by crowding distance to the requested number of
+ * points at the end.
+ *
+ * The control is checked between generations and passed on to the anchor
+ * searches. Each generation that changes the archive offers its thinned
+ * front on the channel, as does the end of the run.
+ */
+std::vector<MealPlanner::FrontPlan> solveParetoFront(const PlanningProblem& problem,
+                                                     const std::vector<std::shared_ptr<core::Ingredient>>& pantry,
+                                                     const MealPlanner::FrontOptions& options,
+                                                     const MealPlanner::FrontControl& control);
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,214 @@
+#include "plan_state.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+PlanState::PlanState(const PlanningProblem& problem)
+    : problem_(problem)
+    , assignment_(problem.slotCount(), 0)
+    , dayNutrients_(static_cast<std::size_t>(problem.days) * problem.nutrientCount, 0.0)
+    , dayViolation_(problem.days, 0.0)
+    , useDays_(problem.recipes.size())
+    , inverseScale_(problem.nutrientCount, 1.0)
+    , baseSums_(problem.nutrientCount, 0.0) {
+    for (std::size_t n = 0; n < problem.nutrientCount; ++n) {
+        // Measure violations relative to the target so nutrients of different magnitude weigh alike
+        double target = problem.nutrientMin[n] > 0.0 ? problem.nutrientMin[n] : problem.nutrientMax[n];
+        if (std::isfinite(target) && target > 1.0) {
+            inverseScale_[n] = 1.0 / target;
+        }
+    }
+}
+
+void PlanState::load(const std::vector<std::uint32_t>& assignment) {
+    if (assignment.size() != problem_.slotCount()) {
+        throw std::invalid_argument("Assignment does not cover every slot");
+    }
+    for (auto r : assignment_) {
+        useDays_[r].clear();
+    }
+    std::fill(dayNutrients_.begin(), dayNutrients_.end(), 0.0);
+    assignment_ = assignment;
+    purchaseCost_ = 0.0;
+
+    const std::size_t k = problem_.nutrientCount;
+    for (std::size_t s = 0; s < assignment_.size(); ++s) {
+        const std::uint32_t r = assignment_[s];
+        const int day = static_cast<int>(s) / problem_.slotsPerDay;
+        purchaseCost_ += problem_.purchaseCost[r];
+        useDays_[r].insert(std::upper_bound(useDays_[r].begin(), useDays_[r].end(), day), day);
+        const double* row = problem_.nutrientRow(r);
+        for (std::size_t n = 0; n < k; ++n) {
+            dayNutrients_[day * k + n] += row[n];
+        }
+    }
+
+    nutrientViolation_ = 0.0;
+    for (int day = 0; day < problem_.days; ++day) {
+        dayViolation_[day] = computeDayViolation(day);
+        nutrientViolation_ += dayViolation_[day];
+    }
+    varietyViolation_ = 0.0;
+    for (std::size_t s = 0; s < assignment_.size(); ++s) {
+        const std::uint32_t r = assignment_[s];
+        // Count each recipe once, at its first slot
+        if (std::find(assignment_.begin(), assignment_.begin() + static_cast<std::ptrdiff_t>(s), r) ==
+            assignment_.begin() + static_cast<std::ptrdiff_t>(s)) {
+            varietyViolation_ += recipeViolation(r);
+        }
+    }
+    pantryDirty_ = true;
+}
+
+void PlanState::assign(std::size_t slot, std::uint32_t recipe) {
+    const std::uint32_t old = assignment_[slot];
+    if (old == recipe) {
+        return;
+    }
+    const int day = static_cast<int>(slot) / problem_.slotsPerDay;
+    assignment_[slot] = recipe;
+    const double delta = problem_.purchaseCost[recipe] - problem_.purchaseCost[old];
+    purchaseCost_ += delta;
+    // Recipes that use no stocked ingredient leave everyone else's stock untouched
+    if (!pantryDirty_ && !problem_.touchesStock(old) && !problem_.touchesStock(recipe)) {
+        pantryCost_ += delta;
+    } else {
+        pantryDirty_ = true;
+    }
+
+    const std::size_t k = problem_.nutrientCount;
+    if (k > 0) {
+        const double* removed = problem_.nutrientRow(old);
+        const double* added = problem_.nutrientRow(recipe);
+        double* sums = dayNutrients_.data() + day * k;
+        for (std::size_t n = 0; n < k; ++n) {
+            sums[n] += added[n] - removed[n];
+        }
+        const double updated = computeDayViolation(day);
+        nutrientViolation_ += updated - dayViolation_[day];
+        dayViolation_[day] = updated;
+    }
+
+    varietyViolation_ -= recipeViolation(old) + recipeViolation(recipe);
+    removeUse(old, day);
+    addUse(recipe, day);
+    varietyViolation_ += recipeViolation(old) + recipeViolation(recipe);
+}
+
+double PlanState::cost() const {
+    if (!problem_.hasPantry) {
+        return purchaseCost_;
+    }
+    if (pantryDirty_) {
+        stock_ = problem_.pantryStock;
+        trail_.clear();
+        pantryCost_ = 0.0;
+        for (auto r : assignment_) {
+            pantryCost_ += problem_.consumeStock(r, stock_, trail_);
+        }
+        pantryDirty_ = false;
+    }
+    return pantryCost_;
+}
+
+void PlanState::scoreCandidates(std::size_t slot, std::size_t first, std::size_t count, double penaltyWeight,
+                                double* out) {
+    const int pos = static_cast<int>(slot % problem_.slotsPerDay);
+    const int type = problem_.slotType[pos];
+    const int day = static_cast<int>(slot) / problem_.slotsPerDay;
+    const auto& list = problem_.candidates[type];
+    const std::size_t listSize = list.size();
+    const std::uint32_t old = assignment_[slot];
+    const std::size_t k = problem_.nutrientCount;
+
+    // Everything except the slot's own contribution
+    const double* removed = problem_.nutrientRow(old);
+    for (std::size_t n = 0; n < k; ++n) {
+        baseSums_[n] = dayNutrients_[day * k + n] - removed[n];
+    }
+    const double baseCost = cost() - problem_.purchaseCost[old];
+    double variety = varietyViolation_;
+    if (useDays_[old].size() > 1) {
+        variety -= recipeViolation(old);
+        removeUse(old, day);
+        variety += recipeViolation(old);
+        addUse(old, day);
+    }
+    const double baseViolation = nutrientViolation_ - dayViolation_[day] + variety;
+
+    // Cost and nutrient violation of the slot's day for every candidate
+    const double* costs = problem_.candidateCost[type].data() + first;
+    violations_.assign(count, 0.0);
+    double* violation = violations_.data();
+    for (std::size_t n = 0; n < k; ++n) {
+        const double* column = problem_.candidateNutrients[type].data() + n * listSize + first;
+        const double base = baseSums_[n];
+        const double lo = problem_.nutrientMin[n];
+        const double hi = problem_.nutrientMax[n];
+        const double inverse = inverseScale_[n];
+        for (std::size_t j = 0; j < count; ++j) {
+            const double sum = base + column[j];
+            violation[j] += (std::max(0.0, lo - sum) + std::max(0.0, sum - hi)) * inverse;
+        }
+    }
+    for (std::size_t j = 0; j < count; ++j) {
+        out[j] = baseCost + costs[j] + penaltyWeight * (baseViolation + violation[j]);
+    }
+
+    // The batch assumes the candidate is not used yet and no stock is involved;
+    // try the exceptions for real
+    const bool oldStocked = problem_.hasPantry && problem_.touchesStock(old);
+    for (std::size_t j = 0; j < count; ++j) {
+        const std::uint32_t candidate = list[first + j];
+        if (oldStocked || !useDays_[candidate].empty() ||
+            (problem_.hasPantry && problem_.touchesStock(candidate))) {
+            assign(slot, candidate);
+            out[j] = score(penaltyWeight);
+            assign(slot, old);
+        }
+    }
+}
+
+double PlanState::recipeViolation(std::uint32_t recipe) const {
+    const auto& days = useDays_[recipe];
+    double violation = std::max(0, static_cast<int>(days.size()) - problem_.maxRepeats);
+    for (std::size_t i = 1; i < days.size(); ++i) {
+        if (days[i] - days[i - 1] < problem_.minDaysBetweenRepeats) {
+            violation += 1.0;
+        }
+    }
+    return violation;
+}
+
+double PlanState::computeDayViolation(int day) const {
+    const std::size_t k = problem_.nutrientCount;
+    const double* sums = dayNutrients_.data() + day * k;
+    double violation = 0.0;
+    for (std::size_t n = 0; n < k; ++n) {
+        // Same expression as the batch kernel in scoreCandidates()
+        violation += (std::max(0.0, problem_.nutrientMin[n] - sums[n]) +
+                      std::max(0.0, sums[n] - problem_.nutrientMax[n])) * inverseScale_[n];
+    }
+    return violation;
+}
+
+void PlanState::addUse(std::uint32_t recipe, int day) {
+    auto& days = useDays_[recipe];
+    days.insert(std::upper_bound(days.begin(), days.end(), day), day);
+}
+
+void PlanState::removeUse(std::uint32_t recipe, int day) {
+    auto& days = useDays_[recipe];
+    auto it = std::lower_bound(days.begin(), days.end(), day);
+    if (it != days.end() && *it == day) {
+        days.erase(it);
+    }
+}
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "planning_problem.hpp"
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+/**
+ * @brief A complete slot assignment with incrementally maintained score.
+ *
+ * Reassigning one slot updates the cost, the nutrient sums of its day and the
+ * usage of the two recipes involved, so local search can try a move and undo
+ * it in time independent of the horizon. Constraint violations are kept as a
+ * single normalized measure: each nutrient shortfall or excess counts as a
+ * fraction of the daily target, and each extra or too-close repeat of a
+ * recipe counts as one.
+ *
+ * scoreCandidates() scores a whole run of replacement candidates for one slot
+ * in a single call. It reads the structure-of-arrays candidate tables of the
+ * problem with branch-free loops over contiguous memory, which the compiler
+ * turns into SIMD code, and falls back to trying a candidate for real only
+ * when it interacts with the variety rules or with pantry stock.
+ */
+class PlanState {
+public:
+    explicit PlanState(const PlanningProblem& problem);
+
+    /// Replace the whole assignment; every slot must hold an allowed recipe
+    void load(const std::vector<std::uint32_t>& assignment);
+
+    /// Put a recipe in a slot
+    void assign(std::size_t slot, std::uint32_t recipe);
+
+    std::uint32_t at(std::size_t slot) const { return assignment_[slot]; }
+    const std::vector<std::uint32_t>& assignment() const { return assignment_; }
+
+    /// Purchase cost, with pantry stock consumed in slot order
+    double cost() const;
+
+    /// Normalized constraint violation, 0 for a feasible plan
+    double violation() const { return nutrientViolation_ + varietyViolation_; }
+
+    /// Cost plus weighted violation, the objective minimized by local search
+    double score(double penaltyWeight) const { return cost() + penaltyWeight * violation(); }
+
+    /// Whether the violation is zero up to rounding of the incremental sums
+    bool feasible() const { return violation() <= 1e-9; }
+
+    /**
+     * Score the plans obtained by putting each of `count` consecutive entries
+     * of the slot type's candidate list, starting at `first`, into `slot`.
+     * Writes the score(penaltyWeight) of each plan to `out`; the state itself
+     * is left unchanged.
+     */
+    void scoreCandidates(std::size_t slot, std::size_t first, std::size_t count, double penaltyWeight,
+                         double* out);
+
+private:
+    const PlanningProblem& problem_;
+    std::vector<std::uint32_t> assignment_;
+    std::vector<double> dayNutrients_;       ///< (day, nutrient) -> sum
+    std::vector<double> dayViolation_;       ///< Day -> normalized nutrient violation
+    std::vector<std::vector<int>> useDays_;  ///< Recipe -> sorted days it is used on
+    std::vector<double> inverseScale_;       ///< Nutrient -> violation normalizer
+    double purchaseCost_ = 0.0;
+    double nutrientViolation_ = 0.0;
+    double varietyViolation_ = 0.0;
+    std::vector<double> baseSums_;    ///< Scratch: day sums without the slot being scored
+    std::vector<double> violations_;  ///< Scratch: day violation per scored candidate
+
+    mutable double pantryCost_ = 0.0;
+    mutable bool pantryDirty_ = true;
+    mutable std::vector<double> stock_;
+    mutable PlanningProblem::StockTrail trail_;
+
+    double recipeViolation(std::uint32_t recipe) const;
+    double computeDayViolation(int day) const;
+    void addUse(std::uint32_t recipe, int day);
+    void removeUse(std::uint32_t recipe, int day);
+};
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
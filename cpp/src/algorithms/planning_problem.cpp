@@ -0,0 +1,306 @@
+#include "planning_problem.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+std::chrono::system_clock::time_point PlanningProblem::startOf(const MealPlanner::Constraints& constraints) {
+    return constraints.start == std::chrono::system_clock::time_point{} ? std::chrono::system_clock::now()
+                                                                          : constraints.start;
+}
+
+PlanningProblem::PlanningProblem(const std::vector<std::shared_ptr<core::Recipe>>& catalog,
+                                 const std::unordered_map<std::string, std::uint8_t>& allowedTypes,
+                                 const MealPlanner::Constraints& constraints)
+    : recipes(catalog)
+    , days(constraints.days)
+    , slotsPerDay(static_cast<int>(constraints.slotsPerDay.size()))
+    , servings(constraints.servings)
+    , maxRepeats(constraints.maxRepeats)
+    , minDaysBetweenRepeats(constraints.minDaysBetweenRepeats)
+    , start(startOf(constraints))
+    , nutrientCount(constraints.nutrients.size())
+    , candidates(kTypeCount) {
+    if (days <= 0) {
+        throw std::invalid_argument("Planning horizon must be at least one day");
+    }
+    if (slotsPerDay == 0) {
+        throw std::invalid_argument("At least one meal slot per day is required");
+    }
+    if (servings <= 0) {
+        throw std::invalid_argument("Number of servings must be positive");
+    }
+    if (maxRepeats <= 0) {
+        throw std::invalid_argument("Maximum repeats must be positive");
+    }
+    if (minDaysBetweenRepeats < 0) {
+        throw std::invalid_argument("Minimum days between repeats cannot be negative");
+    }
+
+    for (auto type : constraints.slotsPerDay) {
+        slotType.push_back(static_cast<int>(type));
+    }
+
+    for (const auto& target : constraints.nutrients) {
+        if (target.nutrient.empty()) {
+            throw std::invalid_argument("Nutrient name cannot be empty");
+        }
+        if (target.minPerDay > target.maxPerDay) {
+            throw std::invalid_argument("Nutrient minimum exceeds maximum for " + target.nutrient);
+        }
+        nutrientMin.push_back(target.minPerDay);
+        nutrientMax.push_back(target.maxPerDay);
+    }
+
+    const std::size_t recipeCount = recipes.size();
+    nutrients.assign(recipeCount * nutrientCount, 0.0);
+    typeMask.assign(recipeCount, 0);
+    purchaseCost.assign(recipeCount, 0.0);
+    needBegin.reserve(recipeCount + 1);
+    needBegin.push_back(0);
+
+    for (std::size_t r = 0; r < recipeCount; ++r) {
+        const auto& recipe = recipes[r];
+        if (!recipe) {
+            throw std::invalid_argument("Cannot plan with a null recipe");
+        }
+
+        auto allowed = allowedTypes.find(recipe->getId());
+        typeMask[r] = allowed != allowedTypes.end() ? allowed->second : 0x0F;
+
+        const auto& info = recipe->getNutritionalInfo();
+        for (std::size_t k = 0; k < nutrientCount; ++k) {
+            auto it = info.find(constraints.nutrients[k].nutrient);
+            if (it != info.end()) {
+                nutrients[r * nutrientCount + k] = it->second;
+            }
+        }
+
+        // Merge ingredients sharing an identity so stock is consumed once per need
+        const double scale = static_cast<double>(servings) / recipe->getServings();
+        const std::size_t first = needId.size();
+        for (const auto& ingredient : recipe->expandIngredients()) {
+            std::uint32_t id = ingredients.intern(*ingredient);
+            double quantity = IngredientIndex::baseQuantity(*ingredient) * scale;
+            double price = IngredientIndex::basePrice(*ingredient);
+
+            auto begin = needId.begin() + static_cast<std::ptrdiff_t>(first);
+            auto existing = std::find(begin, needId.end(), id);
+            if (existing != needId.end()) {
+                std::size_t index = static_cast<std::size_t>(existing - needId.begin());
+                double total = needQuantity[index] + quantity;
+                if (total > 0.0) {
+                    needPrice[index] = (needPrice[index] * needQuantity[index] + price * quantity) / total;
+                }
+                needQuantity[index] = total;
+            } else {
+                needId.push_back(id);
+                needQuantity.push_back(quantity);
+                needPrice.push_back(price);
+            }
+        }
+        needBegin.push_back(static_cast<std::uint32_t>(needId.size()));
+
+        for (std::size_t i = first; i < needId.size(); ++i) {
+            purchaseCost[r] += needQuantity[i] * needPrice[i];
+        }
+    }
+
+    pantryStock.assign(ingredients.size(), 0.0);
+    for (const auto& item : constraints.pantry) {
+        if (!item || !usable(*item, start)) {
+            continue;
+        }
+        std::uint32_t id = ingredients.find(*item);
+        if (id != IngredientIndex::npos) {
+            pantryStock[id] += IngredientIndex::baseQuantity(*item);
+            hasPantry = hasPantry || pantryStock[id] > 0.0;
+        }
+    }
+
+    optimisticCost = purchaseCost;
+    if (hasPantry) {
+        for (std::size_t r = 0; r < recipeCount; ++r) {
+            double cost = 0.0;
+            for (std::uint32_t i = needBegin[r]; i < needBegin[r + 1]; ++i) {
+                double missing = std::max(0.0, needQuantity[i] - pantryStock[needId[i]]);
+                cost += missing * needPrice[i];
+            }
+            optimisticCost[r] = cost;
+        }
+    }
+
+    for (int t = 0; t < kTypeCount; ++t) {
+        auto& list = candidates[t];
+        for (std::size_t r = 0; r < recipeCount; ++r) {
+            if (typeMask[r] & (1u << t)) {
+                list.push_back(static_cast<std::uint32_t>(r));
+            }
+        }
+    }
+    rankCandidates();
+
+    signature.assign(recipeCount, 0);
+    for (std::size_t r = 0; r < recipeCount; ++r) {
+        for (std::uint32_t i = needBegin[r]; i < needBegin[r + 1]; ++i) {
+            signature[r] |= std::uint64_t{1} << (needId[i] & 63u);
+        }
+    }
+    for (std::size_t id = 0; id < pantryStock.size(); ++id) {
+        if (pantryStock[id] > 0.0) {
+            stockSignature |= std::uint64_t{1} << (id & 63u);
+        }
+    }
+}
+
+void PlanningProblem::rankCandidates() {
+    candidateCost.resize(kTypeCount);
+    candidateNutrients.resize(kTypeCount);
+    for (int t = 0; t < kTypeCount; ++t) {
+        auto& list = candidates[t];
+        std::stable_sort(list.begin(), list.end(), [this](std::uint32_t a, std::uint32_t b) {
+            return optimisticCost[a] < optimisticCost[b];
+        });
+
+        auto& cost = candidateCost[t];
+        auto& columns = candidateNutrients[t];
+        cost.resize(list.size());
+        columns.resize(nutrientCount * list.size());
+        for (std::size_t j = 0; j < list.size(); ++j) {
+            cost[j] = purchaseCost[list[j]];
+            for (std::size_t n = 0; n < nutrientCount; ++n) {
+                columns[n * list.size() + j] = nutrientRow(list[j])[n];
+            }
+        }
+    }
+}
+
+double PlanningProblem::consumeStock(std::uint32_t recipe, std::vector<double>& stock,
+                                     StockTrail& trail) const {
+    double cost = 0.0;
+    for (std::uint32_t i = needBegin[recipe]; i < needBegin[recipe + 1]; ++i) {
+        double& available = stock[needId[i]];
+        double taken = std::min(available, needQuantity[i]);
+        if (taken > 0.0) {
+            available -= taken;
+            trail.emplace_back(needId[i], taken);
+        }
+        cost += (needQuantity[i] - taken) * needPrice[i];
+    }
+    return cost;
+}
+
+void PlanningProblem::releaseStock(std::vector<double>& stock, StockTrail& trail, std::size_t mark) {
+    while (trail.size() > mark) {
+        stock[trail.back().first] += trail.back().second;
+        trail.pop_back();
+    }
+}
+
+bool PlanningProblem::evaluate(const std::vector<std::uint32_t>& plan, double& cost) const {
+    cost = 0.0;
+    if (plan.size() != slotCount()) {
+        return false;
+    }
+
+    std::vector<double> stock = pantryStock;
+    StockTrail trail;
+    std::unordered_map<std::uint32_t, std::pair<int, int>> uses;  // recipe -> (count, last day)
+    std::vector<double> daily(nutrientCount, 0.0);
+    bool feasible = true;
+
+    for (std::size_t s = 0; s < plan.size(); ++s) {
+        const int day = static_cast<int>(s) / slotsPerDay;
+        const int pos = static_cast<int>(s) % slotsPerDay;
+        const std::uint32_t r = plan[s];
+        if (r >= recipes.size() || !(typeMask[r] & (1u << slotType[pos]))) {
+            return false;
+        }
+
+        auto& use = uses[r];
+        if (use.first > 0 && day - use.second < minDaysBetweenRepeats) {
+            feasible = false;
+        }
+        if (++use.first > maxRepeats) {
+            feasible = false;
+        }
+        use.second = day;
+
+        cost += hasPantry ? consumeStock(r, stock, trail) : purchaseCost[r];
+
+        const double* row = nutrientRow(r);
+        for (std::size_t k = 0; k < nutrientCount; ++k) {
+            daily[k] += row[k];
+        }
+        if (pos == slotsPerDay - 1) {
+            for (std::size_t k = 0; k < nutrientCount; ++k) {
+                if (daily[k] < nutrientMin[k] || daily[k] > nutrientMax[k]) {
+                    feasible = false;
+                }
+            }
+            std::fill(daily.begin(), daily.end(), 0.0);
+        }
+    }
+    return feasible;
+}
+
+double PlanningProblem::varietyBound() const {
+    std::vector<int> need(kTypeCount, 0);
+    for (int t : slotType) {
+        need[t] += days;
+    }
+    double bound = 0.0;
+    for (int t = 0; t < kTypeCount; ++t) {
+        int left = need[t];
+        for (auto r : candidates[t]) {
+            if (left == 0) {
+                break;
+            }
+            int take = std::min(maxRepeats, left);
+            bound += take * optimisticCost[r];
+            left -= take;
+        }
+        if (left > 0) {
+            return kInfinity;
+        }
+    }
+    return bound;
+}
+
+MealPlanner::Plan PlanningProblem::toPlan(const std::vector<std::uint32_t>& plan) const {
+    MealPlanner::Plan result;
+    std::vector<double> stock = pantryStock;
+    StockTrail trail;
+
+    result.assignments.reserve(plan.size());
+    for (std::size_t s = 0; s < plan.size(); ++s) {
+        const std::uint32_t r = plan[s];
+        double cost = hasPantry ? consumeStock(r, stock, trail) : purchaseCost[r];
+        result.assignments.push_back({
+            static_cast<int>(s) / slotsPerDay,
+            static_cast<core::Meal::Type>(slotType[s % slotsPerDay]),
+            recipes[r],
+            cost});
+        result.totalCost += cost;
+    }
+    return result;
+}
+
+std::vector<std::uint32_t> PlanningProblem::toAssignment(const MealPlanner::Plan& plan) const {
+    std::unordered_map<const core::Recipe*, std::uint32_t> index;
+    for (std::size_t r = 0; r < recipes.size(); ++r) {
+        index.emplace(recipes[r].get(), static_cast<std::uint32_t>(r));
+    }
+    std::vector<std::uint32_t> assignment;
+    assignment.reserve(plan.assignments.size());
+    for (const auto& item : plan.assignments) {
+        assignment.push_back(index.at(item.recipe.get()));
+    }
+    return assignment;
+}
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "smart_food/algorithms/ingredient_index.hpp"
+#include "smart_food/algorithms/meal_planner.hpp"
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+/**
+ * @brief Flattened form of a planning request shared by the planner strategies.
+ *
+ * Recipes are referred to by their index in `recipes`. Everything the search
+ * touches per node (costs, nutrients, ingredient needs) lives in contiguous
+ * arrays so that no shared_ptr or std::map is dereferenced while solving.
+ */
+struct PlanningProblem {
+    static constexpr double kInfinity = std::numeric_limits<double>::infinity();
+    static constexpr int kTypeCount = 4;  ///< Number of core::Meal::Type values
+
+    /// (ingredient identity, base quantity taken from stock) pairs, undone on backtrack
+    using StockTrail = std::vector<std::pair<std::uint32_t, double>>;
+
+    std::vector<std::shared_ptr<core::Recipe>> recipes;  ///< Recipe index -> recipe
+
+    int days = 0;                       ///< Planning horizon
+    int slotsPerDay = 0;                ///< Slots on each day
+    std::vector<int> slotType;          ///< Position in day -> type index
+    int servings = 1;                   ///< Servings per slot
+    int maxRepeats = 1;                 ///< Uses of one recipe over the horizon
+    int minDaysBetweenRepeats = 0;      ///< Minimum day distance between two uses
+    std::chrono::system_clock::time_point start;  ///< First day of the plan, Constraints::start or the time of compiling
+
+    std::size_t nutrientCount = 0;      ///< Number of constrained nutrients
+    std::vector<double> nutrientMin;    ///< Daily lower bound per nutrient
+    std::vector<double> nutrientMax;    ///< Daily upper bound per nutrient
+    std::vector<double> nutrients;      ///< recipe * nutrientCount, per serving
+
+    std::vector<std::uint8_t> typeMask;     ///< Recipe -> bit per allowed type
+    std::vector<double> purchaseCost;       ///< Recipe -> cost with an empty pantry
+    std::vector<double> optimisticCost;     ///< Recipe -> cost with the full pantry to itself
+    std::vector<std::vector<std::uint32_t>> candidates;  ///< Type -> recipes by optimistic cost
+
+    IngredientIndex ingredients;            ///< Identities of every needed ingredient
+    std::vector<std::uint32_t> needBegin;   ///< CSR offsets into the need arrays, recipe + 1 entries
+    std::vector<std::uint32_t> needId;      ///< Ingredient identity
+    std::vector<double> needQuantity;       ///< Base quantity for `servings`
+    std::vector<double> needPrice;          ///< Price per base unit
+    std::vector<double> pantryStock;        ///< Identity -> base quantity in stock and not expired at start
+    bool hasPantry = false;                 ///< Whether any needed ingredient is stocked
+
+    // Structure-of-arrays copies of the candidate lists, for batch scoring
+    std::vector<std::vector<double>> candidateCost;       ///< Type -> purchase cost per list position
+    std::vector<std::vector<double>> candidateNutrients;  ///< Type -> nutrient-major columns over list positions
+    std::vector<std::uint64_t> signature;   ///< Recipe -> ingredient identities hashed into 64 bits
+    std::uint64_t stockSignature = 0;       ///< Union of the signatures of stocked identities
+
+    /**
+     * @brief Compile a planning request
+     * @throws std::invalid_argument if the constraints are malformed
+     */
+    PlanningProblem(const std::vector<std::shared_ptr<core::Recipe>>& catalog,
+                    const std::unordered_map<std::string, std::uint8_t>& allowedTypes,
+                    const MealPlanner::Constraints& constraints);
+
+    /**
+     * @brief Resolve Constraints::start, the epoch standing for now
+     */
+    static std::chrono::system_clock::time_point startOf(const MealPlanner::Constraints& constraints);
+
+    /**
+     * @brief Whether a pantry lot can still be used on a plan starting at `start`
+     *
+     * Lots expiring before the start are spoiled; an epoch expiry date means the lot keeps.
+     */
+    static bool usable(const core::Ingredient& item, std::chrono::system_clock::time_point start) {
+        return item.getExpiryDate() == std::chrono::system_clock::time_point{} || item.getExpiryDate() >= start;
+    }
+
+    /// Total number of slots in the horizon
+    std::size_t slotCount() const { return static_cast<std::size_t>(days) * slotsPerDay; }
+
+    /// Whether a recipe may draw on pantry stock; false positives only cost speed
+    bool touchesStock(std::uint32_t recipe) const { return (signature[recipe] & stockSignature) != 0; }
+
+    /// Nutrient row of a recipe
+    const double* nutrientRow(std::uint32_t recipe) const {
+        return nutrients.data() + static_cast<std::size_t>(recipe) * nutrientCount;
+    }
+
+    /**
+     * @brief Sort the candidate lists by optimistic cost and rebuild their batch-scoring copies
+     */
+    void rankCandidates();
+
+    /**
+     * @brief Cost of cooking a recipe, taking what is available from stock
+     * @param recipe Recipe index
+     * @param stock Remaining stock per identity, decreased in place
+     * @param trail Receives what was taken so that releaseStock() can undo it
+     * @return Cost of the quantities that still have to be bought
+     */
+    double consumeStock(std::uint32_t recipe, std::vector<double>& stock, StockTrail& trail) const;
+
+    /**
+     * @brief Put back everything taken after a trail position
+     */
+    static void releaseStock(std::vector<double>& stock, StockTrail& trail, std::size_t mark);
+
+    /**
+     * @brief Check a complete slot assignment and compute its cost
+     * @param plan Recipe index per slot, day-major
+     * @param cost Receives the total cost with pantry consumption in slot order
+     * @return true if the plan meets the type, nutrition and variety rules
+     */
+    bool evaluate(const std::vector<std::uint32_t>& plan, double& cost) const;
+
+    /**
+     * @brief Cheap lower bound on any plan: the cheapest recipe uses per slot type
+     */
+    double varietyBound() const;
+
+    /**
+     * @brief Convert a slot assignment into the public plan representation
+     */
+    MealPlanner::Plan toPlan(const std::vector<std::uint32_t>& plan) const;
+
+    /**
+     * @brief Recover the slot assignment of a plan produced by toPlan()
+     */
+    std::vector<std::uint32_t> toAssignment(const MealPlanner::Plan& plan) const;
+};
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,282 @@
+#include "smart_food/algorithms/recipe_graph.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace smart_food {
+namespace algorithms {
+
+RecipeGraph::RecipeGraph(const std::vector<std::shared_ptr<core::Recipe>>& recipes) {
+    for (const auto& recipe : recipes) {
+        if (!recipe) {
+            throw std::invalid_argument("Cannot add null recipe");
+        }
+    }
+    link(recipes);
+}
+
+std::size_t RecipeGraph::size() const {
+    return nodes_.size();
+}
+
+bool RecipeGraph::contains(const std::string& recipeId) const {
+    return byId_.count(recipeId) > 0;
+}
+
+std::vector<std::string> RecipeGraph::getUsers(const std::string& recipeId) const {
+    auto it = byId_.find(recipeId);
+    if (it == byId_.end()) {
+        throw std::out_of_range("Recipe not in graph: " + recipeId);
+    }
+    std::vector<bool> seen(nodes_.size(), false);
+    std::vector<std::size_t> pending{it->second};
+    std::vector<std::string> users;
+    while (!pending.empty()) {
+        const std::size_t n = pending.back();
+        pending.pop_back();
+        for (auto user : nodes_[n].users) {
+            if (!seen[user]) {
+                seen[user] = true;
+                users.push_back(nodes_[user].recipe->getId());
+                pending.push_back(user);
+            }
+        }
+    }
+    return users;
+}
+
+std::vector<std::string> RecipeGraph::getTopologicalOrder() const {
+    // Kahn's algorithm from the recipes without components
+    std::vector<std::size_t> waiting(nodes_.size());
+    std::vector<std::size_t> ready;
+    for (std::size_t n = 0; n < nodes_.size(); ++n) {
+        waiting[n] = nodes_[n].components.size();
+        if (waiting[n] == 0) {
+            ready.push_back(n);
+        }
+    }
+    std::vector<std::string> order;
+    order.reserve(nodes_.size());
+    for (std::size_t next = 0; next < ready.size(); ++next) {
+        const std::size_t n = ready[next];
+        order.push_back(nodes_[n].recipe->getId());
+        for (auto user : nodes_[n].users) {
+            if (--waiting[user] == 0) {
+                ready.push_back(user);
+            }
+        }
+    }
+    return order;
+}
+
+RecipeGraph::Stats RecipeGraph::getStats() const {
+    return stats_;
+}
+
+void RecipeGraph::addRecipe(const std::shared_ptr<core::Recipe>& recipe) {
+    if (!recipe) {
+        throw std::invalid_argument("Cannot add null recipe");
+    }
+    link({recipe});
+}
+
+void RecipeGraph::updateRecipe(const std::string& recipeId) {
+    auto it = byId_.find(recipeId);
+    if (it == byId_.end()) {
+        throw std::out_of_range("Recipe not in graph: " + recipeId);
+    }
+    link({nodes_[it->second].recipe});
+}
+
+std::size_t RecipeGraph::invalidateIngredient(const std::string& name) {
+    std::vector<std::size_t> seeds;
+    for (auto dimension : {IngredientIndex::Dimension::MASS, IngredientIndex::Dimension::VOLUME,
+                           IngredientIndex::Dimension::COUNT}) {
+        const std::uint32_t id = ingredients_.find(name, dimension);
+        if (id != IngredientIndex::npos) {
+            seeds.insert(seeds.end(), ingredientUsers_[id].begin(), ingredientUsers_[id].end());
+        }
+    }
+    return invalidate(std::move(seeds));
+}
+
+const RecipeGraph::Totals& RecipeGraph::evaluate(const std::string& recipeId) {
+    auto it = byId_.find(recipeId);
+    if (it == byId_.end()) {
+        throw std::out_of_range("Recipe not in graph: " + recipeId);
+    }
+
+    // Post-order over the stale part below the recipe: components are
+    // computed before their users, each once
+    std::vector<std::pair<std::size_t, bool>> pending{{it->second, false}};
+    while (!pending.empty()) {
+        const auto [n, expanded] = pending.back();
+        pending.pop_back();
+        Node& node = nodes_[n];
+        if (!node.stale) {
+            continue;
+        }
+        if (!expanded) {
+            pending.push_back({n, true});
+            for (const auto& edge : node.components) {
+                if (nodes_[edge.node].stale) {
+                    pending.push_back({edge.node, false});
+                }
+            }
+            continue;
+        }
+
+        Totals totals;
+        for (const auto& ingredient : node.recipe->getIngredients()) {
+            totals.cost += ingredient->calculateCost();
+            for (const auto& [nutrient, value] : ingredient->getNutritionalInfo()) {
+                totals.nutrition[nutrient] += value;
+            }
+        }
+        for (const auto& edge : node.components) {
+            const Node& component = nodes_[edge.node];
+            const double share = edge.servings / component.recipe->getServings();
+            totals.cost += component.totals.cost * share;
+            for (const auto& [nutrient, value] : component.totals.nutrition) {
+                totals.nutrition[nutrient] += value * share;
+            }
+        }
+        node.totals = std::move(totals);
+        node.stale = false;
+        ++stats_.evaluations;
+    }
+    return nodes_[it->second].totals;
+}
+
+std::size_t RecipeGraph::invalidate(std::vector<std::size_t> nodes) {
+    // A stale node's users are stale already, so the walk stops there
+    std::size_t marked = 0;
+    while (!nodes.empty()) {
+        const std::size_t n = nodes.back();
+        nodes.pop_back();
+        if (nodes_[n].stale) {
+            continue;
+        }
+        nodes_[n].stale = true;
+        ++marked;
+        nodes.insert(nodes.end(), nodes_[n].users.begin(), nodes_[n].users.end());
+    }
+    stats_.invalidations += marked;
+    return marked;
+}
+
+void RecipeGraph::link(const std::vector<std::shared_ptr<core::Recipe>>& recipes) {
+    // Stage the recipes to (re)read: those given, later ones replacing
+    // earlier ones with the same ID, and components new to the graph
+    std::unordered_map<std::string, std::shared_ptr<core::Recipe>> staged;
+    std::vector<std::string> order;
+    for (const auto& recipe : recipes) {
+        auto inserted = staged.emplace(recipe->getId(), recipe);
+        if (inserted.second) {
+            order.push_back(recipe->getId());
+        } else {
+            inserted.first->second = recipe;
+        }
+    }
+    for (std::size_t next = 0; next < order.size(); ++next) {
+        for (const auto& component : staged.at(order[next])->getComponents()) {
+            const std::string& id = component.recipe->getId();
+            if (!byId_.count(id) && staged.emplace(id, component.recipe).second) {
+                order.push_back(id);
+            }
+        }
+    }
+
+    // Check for cycles by ID before touching the graph: every new cycle
+    // runs through a staged recipe
+    auto componentIds = [&](const std::string& id) {
+        std::vector<std::string> ids;
+        auto it = staged.find(id);
+        if (it != staged.end()) {
+            for (const auto& component : it->second->getComponents()) {
+                ids.push_back(component.recipe->getId());
+            }
+        } else {
+            for (const auto& edge : nodes_[byId_.at(id)].components) {
+                ids.push_back(nodes_[edge.node].recipe->getId());
+            }
+        }
+        return ids;
+    };
+    std::unordered_map<std::string, bool> finished;  // false while on the depth-first path
+    for (const auto& root : order) {
+        if (finished.count(root)) {
+            continue;
+        }
+        std::vector<std::pair<std::string, std::vector<std::string>>> path;
+        finished[root] = false;
+        path.emplace_back(root, componentIds(root));
+        while (!path.empty()) {
+            auto& children = path.back().second;
+            if (children.empty()) {
+                finished[path.back().first] = true;
+                path.pop_back();
+                continue;
+            }
+            std::string child = std::move(children.back());
+            children.pop_back();
+            auto it = finished.find(child);
+            if (it != finished.end()) {
+                if (!it->second) {
+                    throw std::invalid_argument("Recipe " + child + " would use itself through its components");
+                }
+                continue;
+            }
+            finished[child] = false;
+            auto grandchildren = componentIds(child);
+            path.emplace_back(std::move(child), std::move(grandchildren));
+        }
+    }
+
+    // Intern the ingredients first, the only step that may still throw
+    std::vector<std::vector<std::uint32_t>> used(order.size());
+    for (std::size_t s = 0; s < order.size(); ++s) {
+        for (const auto& ingredient : staged.at(order[s])->getIngredients()) {
+            used[s].push_back(ingredients_.intern(*ingredient));
+        }
+        std::sort(used[s].begin(), used[s].end());
+        used[s].erase(std::unique(used[s].begin(), used[s].end()), used[s].end());
+    }
+    ingredientUsers_.resize(ingredients_.size());
+
+    std::vector<std::size_t> changed;
+    for (const auto& id : order) {
+        if (!byId_.count(id)) {
+            byId_.emplace(id, nodes_.size());
+            nodes_.emplace_back();
+        }
+    }
+    auto unlink = [](std::vector<std::size_t>& list, std::size_t n) {
+        list.erase(std::find(list.begin(), list.end(), n));
+    };
+    for (std::size_t s = 0; s < order.size(); ++s) {
+        const std::size_t n = byId_.at(order[s]);
+        Node& node = nodes_[n];
+        for (const auto& edge : node.components) {
+            unlink(nodes_[edge.node].users, n);
+        }
+        for (auto ingredient : node.ingredients) {
+            unlink(ingredientUsers_[ingredient], n);
+        }
+        node.recipe = staged.at(order[s]);
+        node.components.clear();
+        for (const auto& component : node.recipe->getComponents()) {
+            const std::size_t c = byId_.at(component.recipe->getId());
+            node.components.push_back({c, component.servings});
+            nodes_[c].users.push_back(n);
+        }
+        node.ingredients = std::move(used[s]);
+        for (auto ingredient : node.ingredients) {
+            ingredientUsers_[ingredient].push_back(n);
+        }
+        changed.push_back(n);
+    }
+    invalidate(std::move(changed));
+}
+
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,366 @@
+#include "replanner.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include "plan_state.hpp"
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+namespace {
+
+constexpr std::size_t kDayBudget = 50000;          ///< Search nodes per re-solved day
+constexpr std::size_t kPolishEvaluations = 200000; ///< Plan evaluations of the fallback descent
+constexpr std::size_t kPolishWidth = 64;           ///< Cheapest candidates tried per slot by the descent
+
+/// A candidate recipe for one position of the day being re-solved
+struct Option {
+    std::uint32_t recipe;
+    double cost;
+};
+
+} // namespace
+
+Replanner::Replanner(std::shared_ptr<const PlanningProblem> problem,
+                     std::unordered_map<std::string, std::uint8_t> allowedTypes,
+                     MealPlanner::Constraints constraints,
+                     std::vector<std::uint32_t> assignment)
+    : problem_(std::move(problem))
+    , allowedTypes_(std::move(allowedTypes))
+    , constraints_(std::move(constraints))
+    , assignment_(std::move(assignment))
+    , locked_(assignment_.size(), false)
+    , banned_(assignment_.size()) {
+    for (std::size_t r = 0; r < problem_->recipes.size(); ++r) {
+        recipeIds_.emplace(problem_->recipes[r]->getId(), static_cast<std::uint32_t>(r));
+    }
+}
+
+std::size_t Replanner::slotIndex(int day, std::size_t position) const {
+    if (day < 0 || day >= problem_->days || position >= static_cast<std::size_t>(problem_->slotsPerDay)) {
+        throw std::invalid_argument("Slot is outside the plan");
+    }
+    return static_cast<std::size_t>(day) * problem_->slotsPerDay + position;
+}
+
+std::uint32_t Replanner::recipeIndex(const std::string& recipeId) const {
+    auto it = recipeIds_.find(recipeId);
+    if (it == recipeIds_.end()) {
+        throw std::invalid_argument("Recipe is not in the planner catalog: " + recipeId);
+    }
+    return it->second;
+}
+
+MealPlanner::Plan Replanner::lock(std::size_t slot, std::uint32_t recipe) {
+    const auto start = Clock::now();
+    const int type = problem_->slotType[slot % problem_->slotsPerDay];
+    if (!(problem_->typeMask[recipe] & (1u << type))) {
+        throw std::invalid_argument("Recipe is not allowed in this meal slot");
+    }
+    auto& banned = banned_[slot];
+    banned.erase(std::remove(banned.begin(), banned.end(), recipe), banned.end());
+    assignment_[slot] = recipe;
+    locked_[slot] = true;
+
+    const int day = static_cast<int>(slot) / problem_->slotsPerDay;
+    std::vector<int> days = conflictingDays(recipe, day);
+    days.push_back(day);
+    return repair(std::move(days), start);
+}
+
+void Replanner::unlock(std::size_t slot) {
+    locked_[slot] = false;
+}
+
+MealPlanner::Plan Replanner::swap(std::size_t slot) {
+    const auto start = Clock::now();
+    banned_[slot].push_back(assignment_[slot]);
+    locked_[slot] = false;
+    return repair({static_cast<int>(slot) / problem_->slotsPerDay}, start);
+}
+
+MealPlanner::Plan Replanner::setServings(int servings) {
+    const auto start = Clock::now();
+    MealPlanner::Constraints constraints = constraints_;
+    constraints.servings = servings;
+    const bool hadPantry = problem_->hasPantry;
+    recompile(constraints);
+
+    // Without stock every recipe's cost scales by the same factor, so the plan stays optimal
+    std::vector<int> days;
+    if (hadPantry || problem_->hasPantry) {
+        for (int day = 0; day < problem_->days; ++day) {
+            days.push_back(day);
+        }
+    }
+    return repair(std::move(days), start);
+}
+
+MealPlanner::Plan Replanner::setPantry(const std::vector<std::shared_ptr<core::Ingredient>>& pantry) {
+    const auto start = Clock::now();
+    MealPlanner::Constraints constraints = constraints_;
+    constraints.pantry = pantry;
+    recompile(constraints);
+
+    std::vector<int> days;
+    for (int day = 0; day < problem_->days; ++day) {
+        days.push_back(day);
+    }
+    return repair(std::move(days), start);
+}
+
+void Replanner::recompile(const MealPlanner::Constraints& constraints) {
+    problem_ = std::make_shared<const PlanningProblem>(problem_->recipes, allowedTypes_, constraints);
+    constraints_ = constraints;
+}
+
+std::vector<int> Replanner::conflictingDays(std::uint32_t recipe, int day) const {
+    const int perDay = problem_->slotsPerDay;
+    std::vector<int> days;
+    int uses = 0;
+    bool tooClose = false;
+    for (std::size_t s = 0; s < assignment_.size(); ++s) {
+        if (assignment_[s] != recipe) {
+            continue;
+        }
+        ++uses;
+        const int other = static_cast<int>(s) / perDay;
+        if (other != day) {
+            days.push_back(other);
+            tooClose = tooClose || std::abs(other - day) < problem_->minDaysBetweenRepeats;
+        }
+    }
+    if (uses <= problem_->maxRepeats && !tooClose) {
+        days.clear();
+    }
+    return days;
+}
+
+bool Replanner::solveDay(int day) {
+    const PlanningProblem& p = *problem_;
+    const int perDay = p.slotsPerDay;
+    const std::size_t k = p.nutrientCount;
+    const std::size_t first = static_cast<std::size_t>(day) * perDay;
+
+    // How the other days use each recipe: (count, distance to the nearest use)
+    std::unordered_map<std::uint32_t, std::pair<int, int>> others;
+    std::vector<double> stock = p.pantryStock;
+    PlanningProblem::StockTrail trail;
+    for (std::size_t s = 0; s < assignment_.size(); ++s) {
+        if (s >= first && s < first + perDay) {
+            continue;
+        }
+        const std::uint32_t r = assignment_[s];
+        auto& use = others.emplace(r, std::make_pair(0, p.days)).first->second;
+        use.first++;
+        use.second = std::min(use.second, std::abs(static_cast<int>(s) / perDay - day));
+        if (p.hasPantry) {
+            p.consumeStock(r, stock, trail);
+        }
+    }
+    auto usable = [&](std::uint32_t r) {
+        auto it = others.find(r);
+        return it == others.end() ||
+               (it->second.first < p.maxRepeats && it->second.second >= p.minDaysBetweenRepeats);
+    };
+    // Recipes of the day are priced against the stock the other days leave over
+    auto costOf = [&](std::uint32_t r) {
+        if (!p.hasPantry) {
+            return p.purchaseCost[r];
+        }
+        double cost = 0.0;
+        for (std::uint32_t i = p.needBegin[r]; i < p.needBegin[r + 1]; ++i) {
+            cost += std::max(0.0, p.needQuantity[i] - stock[p.needId[i]]) * p.needPrice[i];
+        }
+        return cost;
+    };
+
+    // Locked slots are fixed; the others get candidate lists sorted by cost
+    std::vector<double> base(k, 0.0);
+    std::vector<std::uint32_t> dayRecipes;
+    std::vector<std::size_t> open;
+    std::vector<std::vector<Option>> lists;
+    for (int pos = 0; pos < perDay; ++pos) {
+        const std::size_t slot = first + pos;
+        if (locked_[slot]) {
+            const double* row = p.nutrientRow(assignment_[slot]);
+            for (std::size_t n = 0; n < k; ++n) {
+                base[n] += row[n];
+            }
+            dayRecipes.push_back(assignment_[slot]);
+            continue;
+        }
+        const auto& banned = banned_[slot];
+        std::vector<Option> list;
+        for (auto r : p.candidates[p.slotType[pos]]) {
+            if (usable(r) && std::find(banned.begin(), banned.end(), r) == banned.end()) {
+                list.push_back({r, costOf(r)});
+            }
+        }
+        if (p.hasPantry) {
+            std::stable_sort(list.begin(), list.end(), [](const Option& a, const Option& b) {
+                return a.cost < b.cost;
+            });
+        }
+        if (list.empty()) {
+            return false;
+        }
+        open.push_back(slot);
+        lists.push_back(std::move(list));
+    }
+    if (open.empty()) {
+        return true;
+    }
+
+    // Suffix tables over the open positions: cheapest cost and nutrient range
+    const std::size_t depth = open.size();
+    std::vector<double> cheapest(depth + 1, 0.0);
+    std::vector<double> low((depth + 1) * k, 0.0);
+    std::vector<double> high((depth + 1) * k, 0.0);
+    for (std::size_t i = depth; i-- > 0;) {
+        cheapest[i] = cheapest[i + 1] + lists[i].front().cost;
+        for (std::size_t n = 0; n < k; ++n) {
+            double lo = PlanningProblem::kInfinity;
+            double hi = -PlanningProblem::kInfinity;
+            for (const auto& option : lists[i]) {
+                const double value = p.nutrientRow(option.recipe)[n];
+                lo = std::min(lo, value);
+                hi = std::max(hi, value);
+            }
+            low[i * k + n] = low[(i + 1) * k + n] + lo;
+            high[i * k + n] = high[(i + 1) * k + n] + hi;
+        }
+    }
+
+    const bool distinct = p.minDaysBetweenRepeats >= 1;
+    double best = PlanningProblem::kInfinity;
+    std::vector<std::uint32_t> chosen(depth, 0);
+    std::vector<std::uint32_t> bestChoice;
+    std::vector<double> sums((depth + 1) * k, 0.0);
+    std::copy(base.begin(), base.end(), sums.begin());
+    std::size_t nodes = 0;
+
+    auto dfs = [&](auto& self, std::size_t i, double cost) -> void {
+        if (++nodes > kDayBudget) {
+            return;
+        }
+        if (i == depth) {
+            best = cost;
+            bestChoice = chosen;
+            return;
+        }
+        const double* partial = sums.data() + i * k;
+        double* next = sums.data() + (i + 1) * k;
+        for (const auto& option : lists[i]) {
+            if (cost + option.cost + cheapest[i + 1] >= best) {
+                break;
+            }
+            const std::uint32_t r = option.recipe;
+            const int inDay = static_cast<int>(std::count(dayRecipes.begin(), dayRecipes.end(), r) +
+                                               std::count(chosen.begin(), chosen.begin() + i, r));
+            if (inDay > 0 && (distinct || inDay + 1 > p.maxRepeats - (others.count(r) ? others[r].first : 0))) {
+                continue;
+            }
+            const double* row = p.nutrientRow(r);
+            bool reachable = true;
+            for (std::size_t n = 0; n < k && reachable; ++n) {
+                next[n] = partial[n] + row[n];
+                reachable = next[n] + low[(i + 1) * k + n] <= p.nutrientMax[n] &&
+                            next[n] + high[(i + 1) * k + n] >= p.nutrientMin[n];
+            }
+            if (!reachable) {
+                continue;
+            }
+            chosen[i] = r;
+            self(self, i + 1, cost + option.cost);
+            if (nodes > kDayBudget) {
+                return;
+            }
+        }
+    };
+    dfs(dfs, 0, 0.0);
+    work_ += nodes;
+
+    if (bestChoice.empty()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < depth; ++i) {
+        assignment_[open[i]] = bestChoice[i];
+    }
+    return true;
+}
+
+void Replanner::polish() {
+    const PlanningProblem& p = *problem_;
+    const int perDay = p.slotsPerDay;
+    PlanState state(p);
+    state.load(assignment_);
+
+    double slotCost = state.cost() / static_cast<double>(assignment_.size());
+    if (!(slotCost > 0.0)) {
+        slotCost = 1.0;
+    }
+    const double weight = 100.0 * slotCost * perDay;
+
+    std::vector<double> scores;
+    std::size_t evaluations = 0;
+    bool improved = true;
+    while (improved && !state.feasible() && evaluations < kPolishEvaluations) {
+        improved = false;
+        for (std::size_t s = 0; s < assignment_.size(); ++s) {
+            if (locked_[s]) {
+                continue;
+            }
+            const auto& banned = banned_[s];
+            const auto& list = p.candidates[p.slotType[s % perDay]];
+            const std::size_t width = std::min(list.size(), kPolishWidth);
+            scores.resize(width);
+            state.scoreCandidates(s, 0, width, weight, scores.data());
+            evaluations += width;
+
+            std::uint32_t bestRecipe = state.at(s);
+            double bestScore = state.score(weight);
+            for (std::size_t i = 0; i < width; ++i) {
+                if (scores[i] < bestScore - 1e-12 &&
+                    std::find(banned.begin(), banned.end(), list[i]) == banned.end()) {
+                    bestScore = scores[i];
+                    bestRecipe = list[i];
+                    improved = true;
+                }
+            }
+            state.assign(s, bestRecipe);
+        }
+    }
+    work_ += evaluations;
+    assignment_ = state.assignment();
+}
+
+MealPlanner::Plan Replanner::repair(std::vector<int> days, Clock::time_point start) {
+    work_ = 0;
+    std::sort(days.begin(), days.end());
+    days.erase(std::unique(days.begin(), days.end()), days.end());
+
+    for (int day : days) {
+        solveDay(day);
+    }
+    double cost = 0.0;
+    bool feasible = problem_->evaluate(assignment_, cost);
+    if (!feasible) {
+        polish();
+        feasible = problem_->evaluate(assignment_, cost);
+    }
+
+    MealPlanner::Plan result = problem_->toPlan(assignment_);
+    result.feasible = feasible;
+    result.optimal = false;
+    result.lowerBound = std::min(problem_->varietyBound(), result.totalCost);
+    result.nodesExplored = work_;
+    result.solveTime = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+    return result;
+}
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "smart_food/algorithms/meal_planner.hpp"
+#include "planning_problem.hpp"
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+/**
+ * @brief Solver state kept between edits of a plan.
+ *
+ * Holds the compiled problem, the current assignment and the user's locks
+ * and exclusions. An edit marks the days it can affect as dirty; each dirty
+ * day is then re-solved exactly with every other day held fixed, which
+ * respects the variety rules across days and the nutrient ranges of the day
+ * itself. Only if that leaves the plan infeasible does a penalty-driven
+ * descent over all unlocked slots run, bounded by a fixed evaluation budget.
+ */
+class Replanner {
+public:
+    /**
+     * @brief Start from a solved plan
+     * @param problem The problem the plan was solved for
+     * @param allowedTypes Slot type masks the problem was compiled with
+     * @param constraints Constraints the problem was compiled from
+     * @param assignment Recipe index per slot of the plan
+     */
+    Replanner(std::shared_ptr<const PlanningProblem> problem,
+              std::unordered_map<std::string, std::uint8_t> allowedTypes,
+              MealPlanner::Constraints constraints,
+              std::vector<std::uint32_t> assignment);
+
+    /// Index of a slot, or throws std::invalid_argument if out of range
+    std::size_t slotIndex(int day, std::size_t position) const;
+
+    /// Index of a recipe, or throws std::invalid_argument if not in the catalog
+    std::uint32_t recipeIndex(const std::string& recipeId) const;
+
+    /// Pin a recipe to a slot and repair its day and any day it now conflicts with
+    MealPlanner::Plan lock(std::size_t slot, std::uint32_t recipe);
+
+    /// Let the planner change a slot again
+    void unlock(std::size_t slot);
+
+    /// Exclude the current recipe of a slot and repair its day
+    MealPlanner::Plan swap(std::size_t slot);
+
+    /// Change the servings cooked per slot; only pantry use can make another plan cheaper
+    MealPlanner::Plan setServings(int servings);
+
+    /// Replace the pantry stock and re-solve every day against it
+    MealPlanner::Plan setPantry(const std::vector<std::shared_ptr<core::Ingredient>>& pantry);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::shared_ptr<const PlanningProblem> problem_;
+    std::unordered_map<std::string, std::uint8_t> allowedTypes_;
+    MealPlanner::Constraints constraints_;
+    std::vector<std::uint32_t> assignment_;
+    std::vector<bool> locked_;                        ///< Slot -> pinned by the user
+    std::vector<std::vector<std::uint32_t>> banned_;  ///< Slot -> recipes swapped out of it
+    std::unordered_map<std::string, std::uint32_t> recipeIds_;
+    std::size_t work_ = 0;                            ///< Nodes and evaluations of the current edit
+
+    void recompile(const MealPlanner::Constraints& constraints);
+    std::vector<int> conflictingDays(std::uint32_t recipe, int day) const;
+    bool solveDay(int day);
+    void polish();
+    MealPlanner::Plan repair(std::vector<int> days, Clock::time_point start);
+};
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
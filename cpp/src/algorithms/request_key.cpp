@@ -0,0 +1,130 @@
+#include "request_key.hpp"
+#include <chrono>
+#include <iterator>
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+namespace {
+
+void addNutrients(utils::FingerprintBuilder& builder, const std::map<std::string, double>& nutrients) {
+    builder.add(static_cast<std::uint64_t>(nutrients.size()));
+    for (const auto& [nutrient, value] : nutrients) {
+        builder.add(nutrient).add(value);
+    }
+}
+
+} // namespace
+
+void addToKey(utils::FingerprintBuilder& builder, const core::Ingredient& ingredient) {
+    builder.add(ingredient.getName()).add(ingredient.getQuantity()).add(static_cast<int>(ingredient.getUnit()));
+    builder.add(ingredient.getUnitPrice());
+    builder.add(static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+                                              ingredient.getExpiryDate().time_since_epoch())
+                                              .count()));
+    addNutrients(builder, ingredient.getNutritionalInfo());
+}
+
+void addToKey(utils::FingerprintBuilder& builder, const core::Recipe& recipe) {
+    builder.add(recipe.getId()).add(recipe.getServings());
+    addNutrients(builder, recipe.getNutritionalInfo());
+    builder.add(static_cast<std::uint64_t>(recipe.getIngredients().size()));
+    for (const auto& ingredient : recipe.getIngredients()) {
+        addToKey(builder, *ingredient);
+    }
+}
+
+void addToKey(utils::FingerprintBuilder& builder, const core::PackOffer& offer) {
+    builder.add(offer.getStore()).add(offer.getIngredient());
+    builder.add(offer.getPackSize()).add(static_cast<int>(offer.getUnit())).add(offer.getPackPrice());
+    builder.add(static_cast<std::uint64_t>(offer.getPriceTiers().size()));
+    for (const auto& tier : offer.getPriceTiers()) {
+        builder.add(tier.minPacks).add(tier.packPrice);
+    }
+    builder.add(offer.getStock());
+}
+
+utils::Fingerprint RecipeKeys::catalog(const std::vector<std::shared_ptr<core::Recipe>>& recipes) {
+    if (current(recipes)) {
+        return catalog_;
+    }
+    latest_ = core::Recipe::getLatestRevision();
+    ++pass_;
+    recipes_.clear();
+    reached_.clear();
+    utils::FingerprintBuilder builder;
+    builder.add(static_cast<std::uint64_t>(recipes.size()));
+    for (const auto& recipe : recipes) {
+        recipes_.push_back(recipe.get());
+        builder.add(keyOf(*recipe));
+    }
+    catalog_ = builder.finish();
+
+    // Drop recipes no longer reached once they outnumber the live ones
+    if (entries_.size() > 2 * reached_.size()) {
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            it = it->second.pass == pass_ ? std::next(it) : entries_.erase(it);
+        }
+    }
+    return catalog_;
+}
+
+void RecipeKeys::clear() {
+    latest_ = 0;
+    entries_.clear();
+    recipes_.clear();
+    reached_.clear();
+}
+
+bool RecipeKeys::current(const std::vector<std::shared_ptr<core::Recipe>>& recipes) {
+    if (reached_.empty() || recipes.size() != recipes_.size()) {
+        return false;
+    }
+    for (std::size_t r = 0; r < recipes.size(); ++r) {
+        if (recipes[r].get() != recipes_[r]) {
+            return false;
+        }
+    }
+    // Read first, so a change made during the check is seen next time
+    const std::uint64_t latest = core::Recipe::getLatestRevision();
+    if (latest == latest_) {
+        return true;
+    }
+    // A component may be gone once a recipe using it changed, so stop at the first change, which comes before it
+    for (const auto& [recipe, revision] : reached_) {
+        if (recipe->getRevision() != revision) {
+            return false;
+        }
+    }
+    latest_ = latest;
+    return true;
+}
+
+utils::Fingerprint RecipeKeys::keyOf(const core::Recipe& recipe) {
+    // Entries are nodes, so the reference survives the insertions of the recursion below
+    Entry& entry = entries_[&recipe];
+    if (entry.pass == pass_) {
+        return entry.key;
+    }
+    entry.pass = pass_;
+    reached_.emplace_back(&recipe, recipe.getRevision());
+    if (entry.revision != recipe.getRevision()) {
+        utils::FingerprintBuilder contents;
+        addToKey(contents, recipe);
+        entry.contents = contents.finish();
+        entry.revision = recipe.getRevision();
+    }
+    // Components cannot form cycles, so the recursion ends
+    utils::FingerprintBuilder builder;
+    builder.add(entry.contents).add(static_cast<std::uint64_t>(recipe.getComponents().size()));
+    for (const auto& component : recipe.getComponents()) {
+        builder.add(component.servings).add(keyOf(*component.recipe));
+    }
+    entry.key = builder.finish();
+    return entry.key;
+}
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
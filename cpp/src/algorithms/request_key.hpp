@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "smart_food/core/ingredient.hpp"
+#include "smart_food/core/pack_offer.hpp"
+#include "smart_food/core/recipe.hpp"
+#include "smart_food/utils/fingerprint.hpp"
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+/**
+ * @brief Add everything a solver reads from an ingredient to a request key:
+ * name, quantity, unit, unit price, expiry date and nutritional info
+ */
+void addToKey(utils::FingerprintBuilder& builder, const core::Ingredient& ingredient);
+
+/**
+ * @brief Add a recipe's own contents to a request key: ID, servings,
+ * nutritional info and ingredients; components are left to RecipeKeys
+ */
+void addToKey(utils::FingerprintBuilder& builder, const core::Recipe& recipe);
+
+/**
+ * @brief Add a pack offer to a request key: store, ingredient, pack size,
+ * unit, prices, discount tiers and stock
+ */
+void addToKey(utils::FingerprintBuilder& builder, const core::PackOffer& offer);
+
+/**
+ * @brief Content fingerprints of a catalog of recipes, kept between requests
+ *
+ * Each recipe's fingerprint is stored with its core::Recipe::getRevision()
+ * and its contents are hashed again only once the revision changes. A
+ * recipe whose components changed combines their new fingerprints with its
+ * stored contents, and a component shared by several recipes is visited
+ * once per catalog, so diamond-shaped component graphs cost linear time.
+ * While no recipe of the last catalog changed, catalog() only compares
+ * revisions, and while no recipe at all changed, not even those.
+ *
+ * Ingredients edited in place do not change a revision; call clear()
+ * after such edits. Not thread-safe.
+ */
+class RecipeKeys {
+public:
+    /**
+     * @brief Get the fingerprint of the contents of recipes, in order, components included
+     */
+    utils::Fingerprint catalog(const std::vector<std::shared_ptr<core::Recipe>>& recipes);
+
+    /**
+     * @brief Forget every stored fingerprint
+     */
+    void clear();
+
+private:
+    struct Entry {
+        std::uint64_t revision = 0;   ///< Revision the contents were hashed at, 0 for none
+        utils::Fingerprint contents;  ///< See addToKey()
+        utils::Fingerprint key;       ///< Contents and components
+        std::uint64_t pass = 0;       ///< Last catalog() that computed key
+    };
+
+    std::unordered_map<const core::Recipe*, Entry> entries_;
+    std::vector<const core::Recipe*> recipes_;  ///< Recipes of the last catalog
+    /// Every recipe reachable from recipes_ with its revision, each after a recipe using it
+    std::vector<std::pair<const core::Recipe*, std::uint64_t>> reached_;
+    utils::Fingerprint catalog_;
+    std::uint64_t latest_ = 0;  ///< core::Recipe::getLatestRevision() when reached_ was last checked
+    std::uint64_t pass_ = 0;
+
+    /**
+     * @brief Check that the last catalog is still current
+     */
+    bool current(const std::vector<std::shared_ptr<core::Recipe>>& recipes);
+
+    /**
+     * @brief Get a recipe's fingerprint in the current pass
+     */
+    utils::Fingerprint keyOf(const core::Recipe& recipe);
+};
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
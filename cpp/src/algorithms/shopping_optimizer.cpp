@@ -0,0 +1,543 @@
+#include "smart_food/algorithms/shopping_optimizer.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include "smart_food/algorithms/ingredient_index.hpp"
+#include "smart_food/core/storage.hpp"
+#include "smart_food/utils/thread_pool.hpp"
+#include "pack_knapsack.hpp"
+#include "request_key.hpp"
+#include "store_selection.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+using Unit = core::Ingredient::Unit;
+
+constexpr std::size_t kUnitCount = static_cast<std::size_t>(Unit::POUND) + 1;
+
+/// Quantity below which an item counts as fully served
+constexpr double kQuantityTolerance = 1e-9;
+
+/// One use of a stocked ingredient, kept for expiry-aware netting
+struct Demand {
+    std::uint32_t stocked;  ///< Identity in the stock index
+    Clock::time_point time; ///< Planned time of the meal
+    double quantity;        ///< Base quantity
+};
+
+/// Aggregate of one chunk of meals, keyed by raw name and dimension
+struct ChunkResult {
+    std::array<std::unordered_map<std::string, std::uint32_t>, 3> ids;  ///< Per dimension: raw name -> local id
+    std::vector<const std::string*> names;  ///< Local id -> raw name (a key of ids)
+    std::vector<std::uint8_t> dimensions;   ///< Local id -> dimension
+    std::vector<double> quantity;           ///< Local id -> base quantity
+    std::vector<double> cost;               ///< Local id -> cost at the listed unit prices
+    std::vector<std::uint32_t> meals;       ///< Local id -> meals using it
+    std::vector<Clock::time_point> first;   ///< Local id -> earliest planned use
+    // Every ingredient use, kept for expiry-aware netting of stocked identities
+    std::vector<std::uint32_t> useId;
+    std::vector<std::uint32_t> useMeal;
+    std::vector<double> useQuantity;        ///< Base quantity
+    std::size_t mealCount = 0;
+};
+
+/// Base-unit factor of every unit, so conversion is a table lookup
+std::array<double, kUnitCount> baseFactors() {
+    std::array<double, kUnitCount> factors{};
+    for (std::size_t u = 0; u < kUnitCount; ++u) {
+        factors[u] = IngredientIndex::toBaseQuantity(1.0, static_cast<Unit>(u));
+    }
+    return factors;
+}
+
+Unit baseUnit(IngredientIndex::Dimension dimension) {
+    switch (dimension) {
+        case IngredientIndex::Dimension::MASS:   return Unit::GRAM;
+        case IngredientIndex::Dimension::VOLUME: return Unit::MILLILITER;
+        case IngredientIndex::Dimension::COUNT:  return Unit::PIECE;
+    }
+    throw std::invalid_argument("Unknown dimension");
+}
+
+bool stillToCook(const core::Meal& meal) {
+    return meal.getStatus() == core::Meal::Status::PLANNED || meal.getStatus() == core::Meal::Status::SHOPPING;
+}
+
+void aggregateChunk(const std::vector<std::shared_ptr<core::Meal>>& meals, std::size_t begin, std::size_t end,
+                    ChunkResult& chunk) {
+    static const std::array<double, kUnitCount> factors = baseFactors();
+
+    // Gather every ingredient use of the chunk into flat arrays. Names are
+    // normalized only when the chunks are merged: raw spellings repeat, so a
+    // hash lookup of the raw name identifies almost every use.
+    std::vector<double> amounts;
+    std::vector<double> prices;
+    std::vector<std::uint8_t> units;
+    std::vector<std::uint32_t> lastMeal;
+    for (std::size_t m = begin; m < end; ++m) {
+        const auto& meal = meals[m];
+        if (!meal) {
+            throw std::invalid_argument("Cannot build a shopping list for a null meal");
+        }
+        if (!stillToCook(*meal)) {
+            continue;
+        }
+        ++chunk.mealCount;
+        const auto time = meal->getPlannedTime();
+        for (const auto& ingredient : meal->getIngredients()) {
+            if (!ingredient) {
+                throw std::invalid_argument("Meal has a null ingredient: " + meal->getName());
+            }
+            const auto dimension = IngredientIndex::dimensionOf(ingredient->getUnit());
+            auto& ids = chunk.ids[static_cast<std::size_t>(dimension)];
+            auto it = ids.find(ingredient->getName());
+            if (it == ids.end()) {
+                it = ids.emplace(ingredient->getName(), static_cast<std::uint32_t>(chunk.names.size())).first;
+                chunk.names.push_back(&it->first);
+                chunk.dimensions.push_back(static_cast<std::uint8_t>(dimension));
+                chunk.quantity.push_back(0.0);
+                chunk.cost.push_back(0.0);
+                chunk.meals.push_back(0);
+                chunk.first.push_back(time);
+                lastMeal.push_back(static_cast<std::uint32_t>(-1));
+            }
+            const std::uint32_t id = it->second;
+            if (lastMeal[id] != m) {
+                lastMeal[id] = static_cast<std::uint32_t>(m);
+                ++chunk.meals[id];
+                chunk.first[id] = std::min(chunk.first[id], time);
+            }
+            chunk.useId.push_back(id);
+            chunk.useMeal.push_back(static_cast<std::uint32_t>(m));
+            amounts.push_back(ingredient->getQuantity());
+            prices.push_back(ingredient->getUnitPrice());
+            units.push_back(static_cast<std::uint8_t>(ingredient->getUnit()));
+        }
+    }
+
+    // Convert the whole batch to base units, then scatter into the identities
+    const std::size_t count = chunk.useId.size();
+    chunk.useQuantity.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        chunk.useQuantity[i] = amounts[i] * factors[units[i]];
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        chunk.quantity[chunk.useId[i]] += chunk.useQuantity[i];
+        chunk.cost[chunk.useId[i]] += amounts[i] * prices[i];
+    }
+}
+
+} // namespace
+
+ShoppingOptimizer::ShoppingOptimizer()
+    : ShoppingOptimizer(core::Storage::getInstance().getIngredients()) {
+}
+
+ShoppingOptimizer::ShoppingOptimizer(const std::vector<std::shared_ptr<core::Ingredient>>& inventory) {
+    setInventory(inventory);
+}
+
+void ShoppingOptimizer::setInventory(const std::vector<std::shared_ptr<core::Ingredient>>& inventory) {
+    for (const auto& lot : inventory) {
+        if (!lot) {
+            throw std::invalid_argument("Inventory cannot hold a null ingredient");
+        }
+    }
+    inventory_ = inventory;
+}
+
+void ShoppingOptimizer::setStores(const std::vector<std::string>& stores,
+                                  const std::vector<std::vector<double>>& distances) {
+    std::unordered_map<std::string, std::size_t> seen;
+    for (const auto& store : stores) {
+        if (store.empty()) {
+            throw std::invalid_argument("Store name cannot be empty");
+        }
+        if (!seen.emplace(store, seen.size()).second) {
+            throw std::invalid_argument("Store listed twice: " + store);
+        }
+    }
+    const std::size_t size = stores.size() + 1;
+    if (distances.size() != size) {
+        throw std::invalid_argument("Distance matrix needs one row for home and one per store");
+    }
+    for (std::size_t i = 0; i < size; ++i) {
+        if (distances[i].size() != size) {
+            throw std::invalid_argument("Distance matrix must be square");
+        }
+        for (std::size_t j = 0; j < size; ++j) {
+            const double d = distances[i][j];
+            if (!(d >= 0.0) || std::isinf(d)) {
+                throw std::invalid_argument("Distances must be finite and non-negative");
+            }
+            if (std::fabs(d - distances[j][i]) > 1e-9 * std::max(1.0, d)) {
+                throw std::invalid_argument("Distance matrix must be symmetric");
+            }
+        }
+    }
+    stores_ = stores;
+    distances_ = distances;
+}
+
+void ShoppingOptimizer::addOffer(const core::PackOffer& offer) {
+    offers_.push_back(offer);
+}
+
+std::size_t ShoppingOptimizer::applyPriceHistory(const core::PriceHistory& history) {
+    return detail::repriceOffers(offers_, history);
+}
+
+void ShoppingOptimizer::setCache(std::shared_ptr<Cache> cache) {
+    cache_ = std::move(cache);
+}
+
+ShoppingOptimizer::ShoppingList ShoppingOptimizer::buildList(
+    const std::vector<std::shared_ptr<core::Meal>>& meals) const {
+    return buildList(meals, Options());
+}
+
+ShoppingOptimizer::ShoppingList ShoppingOptimizer::buildList(const std::vector<std::shared_ptr<core::Meal>>& meals,
+                                                             const Options& options) const {
+    const auto start = std::chrono::steady_clock::now();
+    if (options.chunkSize == 0) {
+        throw std::invalid_argument("Chunk size must be positive");
+    }
+
+    // Usable pantry lots per identity: (expiry, base quantity). A lot without
+    // an expiry date keeps; one that expired before the reference time is gone.
+    IngredientIndex stockIndex;
+    std::vector<std::vector<std::pair<Clock::time_point, double>>> lots;
+    for (const auto& lot : inventory_) {
+        const auto expiry = lot->getExpiryDate() == Clock::time_point{} ? Clock::time_point::max()
+                                                                        : lot->getExpiryDate();
+        if (expiry < options.now || !(lot->getQuantity() > 0.0)) {
+            continue;
+        }
+        const std::uint32_t id = stockIndex.intern(*lot);
+        if (id == lots.size()) {
+            lots.emplace_back();
+        }
+        lots[id].emplace_back(expiry, IngredientIndex::baseQuantity(*lot));
+    }
+
+    // Aggregate chunks of meals in parallel
+    const std::size_t chunkCount = (meals.size() + options.chunkSize - 1) / options.chunkSize;
+    std::vector<ChunkResult> chunks(chunkCount);
+    auto body = [&](std::size_t c) {
+        const std::size_t begin = c * options.chunkSize;
+        aggregateChunk(meals, begin, std::min(meals.size(), begin + options.chunkSize), chunks[c]);
+    };
+    if (chunkCount <= 1 || options.threads == 1) {
+        for (std::size_t c = 0; c < chunkCount; ++c) {
+            body(c);
+        }
+    } else if (options.threads == 0) {
+        utils::ThreadPool::shared().parallelFor(chunkCount, body);
+    } else {
+        utils::ThreadPool pool(options.threads);
+        pool.parallelFor(chunkCount, body);
+    }
+
+    // Merge in chunk order, so identities keep their order of first use
+    ShoppingList list;
+    IngredientIndex index;
+    std::array<std::unordered_map<std::string, std::uint32_t>, 3> rawIds;  ///< Per dimension: raw name -> id
+    std::vector<double> quantity;
+    std::vector<double> cost;
+    std::vector<std::size_t> mealsUsing;
+    std::vector<Clock::time_point> first;
+    std::vector<std::uint32_t> stocked;
+    std::vector<std::uint32_t> globalOf;
+    std::vector<Demand> demands;
+    for (auto& chunk : chunks) {
+        list.mealCount += chunk.mealCount;
+        globalOf.resize(chunk.names.size());
+        for (std::uint32_t local = 0; local < chunk.names.size(); ++local) {
+            const auto dimension = static_cast<IngredientIndex::Dimension>(chunk.dimensions[local]);
+            auto& ids = rawIds[chunk.dimensions[local]];
+            auto found = ids.find(*chunk.names[local]);
+            std::uint32_t id;
+            if (found != ids.end()) {
+                id = found->second;
+            } else {
+                id = index.intern(*chunk.names[local], dimension);
+                ids.emplace(*chunk.names[local], id);
+            }
+            if (id == quantity.size()) {
+                quantity.push_back(0.0);
+                cost.push_back(0.0);
+                mealsUsing.push_back(0);
+                first.push_back(chunk.first[local]);
+                stocked.push_back(stockIndex.find(index.getName(id), dimension));
+            }
+            globalOf[local] = id;
+            quantity[id] += chunk.quantity[local];
+            cost[id] += chunk.cost[local];
+            mealsUsing[id] += chunk.meals[local];
+            first[id] = std::min(first[id], chunk.first[local]);
+        }
+        for (std::size_t i = 0; i < chunk.useId.size(); ++i) {
+            const std::uint32_t s = stocked[globalOf[chunk.useId[i]]];
+            if (s != IngredientIndex::npos && chunk.useQuantity[i] > 0.0) {
+                demands.push_back({s, meals[chunk.useMeal[i]]->getPlannedTime(), chunk.useQuantity[i]});
+            }
+        }
+        chunk = ChunkResult();
+    }
+
+    // Net stocked identities: meals in planned order, each served from the
+    // usable lot that expires first
+    std::vector<double> fromStock(stockIndex.size(), 0.0);
+    std::vector<Clock::time_point> shortAt(stockIndex.size(), Clock::time_point::max());
+    std::sort(demands.begin(), demands.end(), [](const Demand& a, const Demand& b) {
+        return a.stocked != b.stocked ? a.stocked < b.stocked : a.time < b.time;
+    });
+    for (std::size_t d = 0; d < demands.size();) {
+        const std::uint32_t s = demands[d].stocked;
+        auto& available = lots[s];
+        std::sort(available.begin(), available.end());
+        std::size_t lot = 0;
+        for (; d < demands.size() && demands[d].stocked == s; ++d) {
+            double missing = demands[d].quantity;
+            while (missing > 0.0 && lot < available.size()) {
+                if (available[lot].first < demands[d].time || available[lot].second <= 0.0) {
+                    ++lot;  // Spoils before this meal, or used up
+                    continue;
+                }
+                const double taken = std::min(missing, available[lot].second);
+                available[lot].second -= taken;
+                missing -= taken;
+                fromStock[s] += taken;
+            }
+            if (missing > kQuantityTolerance * demands[d].quantity) {
+                shortAt[s] = std::min(shortAt[s], demands[d].time);
+            }
+        }
+    }
+
+    list.ingredientCount = quantity.size();
+    for (std::uint32_t id = 0; id < quantity.size(); ++id) {
+        Item item;
+        item.ingredient = index.getName(id);
+        item.unit = baseUnit(index.getDimension(id));
+        item.required = quantity[id];
+        item.fromStock = stocked[id] != IngredientIndex::npos ? std::min(fromStock[stocked[id]], quantity[id]) : 0.0;
+        item.toBuy = item.required - item.fromStock;
+        if (!(item.toBuy > kQuantityTolerance * std::max(1.0, item.required))) {
+            continue;
+        }
+        item.estimatedCost = item.required > 0.0 ? cost[id] * (item.toBuy / item.required) : 0.0;
+        item.meals = mealsUsing[id];
+        item.neededBy = first[id];
+        if (stocked[id] != IngredientIndex::npos && shortAt[stocked[id]] != Clock::time_point::max()) {
+            item.neededBy = shortAt[stocked[id]];
+        }
+        list.totalCost += item.estimatedCost;
+        list.items.push_back(std::move(item));
+    }
+    list.buildTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    return list;
+}
+
+ShoppingOptimizer::Trip ShoppingOptimizer::planTrip(const ShoppingList& list) const {
+    return planTrip(list, TripOptions());
+}
+
+ShoppingOptimizer::Trip ShoppingOptimizer::planTrip(const ShoppingList& list, const TripOptions& options) const {
+    return planTrip(list, options, Control());
+}
+
+ShoppingOptimizer::Trip ShoppingOptimizer::planTrip(const ShoppingList& list, const TripOptions& options,
+                                                    const Control& control) const {
+    const auto start = std::chrono::steady_clock::now();
+    if (options.exactStoreLimit > 16) {
+        throw std::invalid_argument("Exact store selection is limited to 16 stores");
+    }
+    utils::Fingerprint key;
+    std::uint64_t version = 0;
+    if (cache_) {
+        key = requestKey(list, options);
+        // Read before solving, so a concurrent Storage change leaves the entry stale
+        version = core::Storage::getInstance().getVersion();
+        if (auto cached = cache_->find(key, version)) {
+            Trip trip = *cached;
+            trip.solveTime =
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+            if (control.channel) {
+                control.channel->offer(trip.totalCost, trip);
+                control.channel->finish();
+            }
+            return trip;
+        }
+    }
+
+    // Offers per (item, store)
+    std::unordered_map<std::string, std::uint32_t> storeIndex;
+    for (std::uint32_t s = 0; s < stores_.size(); ++s) {
+        storeIndex.emplace(stores_[s], s);
+    }
+    IngredientIndex index;
+    for (const auto& item : list.items) {
+        index.intern(item.ingredient, IngredientIndex::dimensionOf(item.unit));
+    }
+    const std::size_t storeCount = stores_.size();
+    std::vector<std::vector<const core::PackOffer*>> offersAt(index.size() * storeCount);
+    for (const auto& offer : offers_) {
+        auto store = storeIndex.find(offer.getStore());
+        if (store == storeIndex.end()) {
+            throw std::invalid_argument("Offer from an unknown store: " + offer.getStore());
+        }
+        const std::uint32_t id = index.find(offer.getIngredient(), IngredientIndex::dimensionOf(offer.getUnit()));
+        if (id != IngredientIndex::npos) {
+            offersAt[id * storeCount + store->second].push_back(&offer);
+        }
+    }
+
+    // Price of every item at every store; items nobody can supply drop out
+    Trip trip;
+    std::vector<std::uint32_t> itemOf;  ///< Problem item -> list item
+    std::vector<double> prices;         ///< list item * stores
+    std::vector<bool> useful(storeCount, false);
+    for (std::uint32_t i = 0; i < list.items.size(); ++i) {
+        const std::uint32_t id = index.find(list.items[i].ingredient, IngredientIndex::dimensionOf(list.items[i].unit));
+        bool available = false;
+        for (std::size_t s = 0; s < storeCount; ++s) {
+            const auto& offers = offersAt[id * storeCount + s];
+            double price = detail::StoreSelectionProblem::kUnavailable;
+            if (!offers.empty()) {
+                const auto cover = detail::coverWithOffers(offers, list.items[i].toBuy);
+                if (cover.feasible) {
+                    price = cover.cost;
+                    available = true;
+                    useful[s] = true;
+                }
+            }
+            prices.push_back(price);
+        }
+        if (available) {
+            itemOf.push_back(i);
+        } else {
+            trip.feasible = false;
+            trip.uncovered.push_back(list.items[i].ingredient);
+        }
+    }
+
+    // Stores supplying nothing on the list would only lengthen the trip
+    std::vector<std::uint32_t> storeOf;  ///< Problem store -> store
+    for (std::uint32_t s = 0; s < storeCount; ++s) {
+        if (useful[s]) {
+            storeOf.push_back(s);
+        }
+    }
+    detail::StoreSelectionProblem problem;
+    problem.stores = storeOf.size();
+    problem.items = itemOf.size();
+    problem.costPerDistance = options.costPerDistance;
+    for (std::uint32_t i : itemOf) {
+        for (std::uint32_t s : storeOf) {
+            problem.itemCost.push_back(prices[i * storeCount + s]);
+        }
+    }
+    for (std::size_t a = 0; a <= problem.stores; ++a) {
+        for (std::size_t b = 0; b <= problem.stores; ++b) {
+            problem.distance.push_back(distances_[a == 0 ? 0 : storeOf[a - 1] + 1][b == 0 ? 0 : storeOf[b - 1] + 1]);
+        }
+    }
+
+    // Expand chosen stores into their packs
+    auto expand = [&](const detail::StoreSelection& selection) {
+        Trip result = trip;
+        std::vector<std::size_t> visitOf(problem.stores, 0);
+        for (std::size_t v = 0; v < selection.route.size(); ++v) {
+            visitOf[selection.route[v]] = v;
+            result.visits.push_back(StoreVisit{stores_[storeOf[selection.route[v]]], {}, 0.0});
+        }
+        for (std::size_t i = 0; i < problem.items; ++i) {
+            const auto& item = list.items[itemOf[i]];
+            const std::uint32_t id = index.find(item.ingredient, IngredientIndex::dimensionOf(item.unit));
+            const std::size_t store = selection.storeOf[i];
+            const auto& offers = offersAt[id * storeCount + storeOf[store]];
+            const auto cover = detail::coverWithOffers(offers, item.toBuy);
+            auto& visit = result.visits[visitOf[store]];
+            for (std::size_t o = 0; o < offers.size(); ++o) {
+                if (cover.packs[o] == 0) {
+                    continue;
+                }
+                const int packs = static_cast<int>(cover.packs[o]);
+                const double cost = offers[o]->priceFor(packs);
+                visit.purchases.push_back({*offers[o], packs, packs * offers[o]->getPackSize(), cost});
+                visit.itemCost += cost;
+            }
+        }
+        for (const auto& visit : result.visits) {
+            result.itemCost += visit.itemCost;
+        }
+        result.distance = selection.distance;
+        result.travelCost = options.costPerDistance * selection.distance;
+        result.totalCost = result.itemCost + result.travelCost;
+        result.optimal = selection.optimal;
+        result.solveTime =
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        return result;
+    };
+
+    detail::StoreSelection selection;
+    if (problem.stores <= options.exactStoreLimit) {
+        selection = detail::selectStoresExact(problem);
+    } else {
+        std::function<void(const detail::StoreSelection&)> improved;
+        if (control.channel) {
+            improved = [&](const detail::StoreSelection& better) {
+                if (control.channel->improves(better.total)) {
+                    Trip published = expand(better);
+                    control.channel->offer(published.totalCost, std::move(published));
+                }
+            };
+        }
+        selection = detail::selectStoresHeuristic(problem, std::min(control.deadline, start + options.timeLimit),
+                                                  control.cancellation, options.maxRestarts, options.seed, improved);
+    }
+    trip = expand(selection);
+    if (cache_ && trip.optimal) {
+        cache_->insert(key, version, std::make_shared<const Trip>(trip));
+    }
+    if (control.channel) {
+        control.channel->offer(trip.totalCost, trip);
+        control.channel->finish();
+    }
+    return trip;
+}
+
+utils::Fingerprint ShoppingOptimizer::requestKey(const ShoppingList& list, const TripOptions& options) const {
+    // Only what planTrip() reads: the quantities to buy and the store data
+    utils::FingerprintBuilder builder;
+    builder.add(static_cast<std::uint64_t>(list.items.size()));
+    for (const auto& item : list.items) {
+        builder.add(item.ingredient).add(static_cast<int>(item.unit)).add(item.toBuy);
+    }
+    builder.add(static_cast<std::uint64_t>(stores_.size()));
+    for (const auto& store : stores_) {
+        builder.add(store);
+    }
+    for (const auto& row : distances_) {
+        for (double distance : row) {
+            builder.add(distance);
+        }
+    }
+    builder.add(static_cast<std::uint64_t>(offers_.size()));
+    for (const auto& offer : offers_) {
+        detail::addToKey(builder, offer);
+    }
+    builder.add(options.costPerDistance).add(static_cast<std::uint64_t>(options.exactStoreLimit));
+    return builder.finish();
+}
+
+} // namespace algorithms
+} // namespace smart_food
@@ -0,0 +1,357 @@
+#include "smart_food/algorithms/similarity_index.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include "smart_food/algorithms/ingredient_index.hpp"
+#include "smart_food/core/storage.hpp"
+#include "smart_food/utils/fingerprint.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+namespace {
+
+std::uint64_t mix(std::uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+/// Order of neighbors: most similar first, then first added
+bool closer(const std::pair<double, std::uint32_t>& a, const std::pair<double, std::uint32_t>& b) {
+    return a.first != b.first ? a.first > b.first : a.second < b.second;
+}
+
+std::uint32_t findRoot(std::vector<std::uint32_t>& parent, std::uint32_t x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+} // namespace
+
+// Constructors
+SimilarityIndex::SimilarityIndex() : SimilarityIndex(core::Storage::getInstance().getRecipes()) {}
+
+SimilarityIndex::SimilarityIndex(const std::vector<std::shared_ptr<core::Recipe>>& recipes)
+    : SimilarityIndex(recipes, Options()) {}
+
+SimilarityIndex::SimilarityIndex(const std::vector<std::shared_ptr<core::Recipe>>& recipes, const Options& options) {
+    setOptions(options);
+    recipes_.reserve(recipes.size());
+    elements_.reserve(recipes.size());
+    signatures_.reserve(recipes.size() * width());
+    next_.reserve(recipes.size() * options_.bands);
+    for (const auto& recipe : recipes) {
+        addRecipe(recipe);
+    }
+}
+
+// Setters
+void SimilarityIndex::addRecipe(const std::shared_ptr<core::Recipe>& recipe) {
+    if (!recipe) {
+        throw std::invalid_argument("Cannot index a null recipe");
+    }
+    auto elements = elementsOf(*recipe);
+    removeRecipe(recipe->getId());
+
+    const auto row = static_cast<std::uint32_t>(recipes_.size());
+    const std::size_t k = width();
+    signatures_.resize(signatures_.size() + k);
+    next_.resize(next_.size() + options_.bands, kNone);
+    sign(elements, &signatures_[row * k]);
+    recipes_.push_back(recipe);
+    elements_.push_back(std::move(elements));
+    rowOf_[recipe->getId()] = row;
+    link(row);
+}
+
+bool SimilarityIndex::removeRecipe(const std::string& recipeId) {
+    auto it = rowOf_.find(recipeId);
+    if (it == rowOf_.end()) {
+        return false;
+    }
+    // The row is retired rather than reused; it stays chained in its buckets until they are rebuilt
+    const std::uint32_t row = it->second;
+    if (!elements_[row].empty()) {
+        ++retired_;
+    }
+    recipes_[row] = nullptr;
+    elements_[row].clear();
+    elements_[row].shrink_to_fit();
+    rowOf_.erase(it);
+    if (retired_ > rowOf_.size()) {
+        rebuildBuckets();
+    }
+    return true;
+}
+
+// Operations
+std::vector<SimilarityIndex::Neighbor> SimilarityIndex::findSimilar(const core::Recipe& recipe, std::size_t limit,
+                                                                    double minSimilarity) const {
+    const auto elements = elementsOf(recipe);
+    std::vector<std::uint32_t> signature(width());
+    sign(elements, signature.data());
+    return rank(elements, signature.data(), recipe.getId(), limit, minSimilarity);
+}
+
+std::vector<SimilarityIndex::Neighbor> SimilarityIndex::findSimilar(const std::string& recipeId, std::size_t limit,
+                                                                    double minSimilarity) const {
+    auto it = rowOf_.find(recipeId);
+    if (it == rowOf_.end()) {
+        throw std::out_of_range("Unknown recipe: " + recipeId);
+    }
+    const std::uint32_t row = it->second;
+    return rank(elements_[row], &signatures_[row * width()], recipeId, limit, minSimilarity);
+}
+
+std::vector<std::vector<std::shared_ptr<core::Recipe>>> SimilarityIndex::findDuplicates(double threshold) const {
+    if (!(threshold >= 0.0 && threshold <= 1.0)) {
+        throw std::invalid_argument("Duplicate threshold must be in [0, 1]");
+    }
+    std::vector<std::uint32_t> parent(recipes_.size());
+    std::iota(parent.begin(), parent.end(), 0u);
+
+    // Only pairs sharing a bucket are compared; pairs already linked are skipped
+    std::vector<std::uint32_t> rows;
+    for (std::size_t band = 0; band < options_.bands; ++band) {
+        for (const auto& bucket : bands_[band].slots) {
+            rows.clear();
+            for (std::uint32_t row = bucket.head; row != kNone; row = next_[row * options_.bands + band]) {
+                if (recipes_[row]) {
+                    rows.push_back(row);
+                }
+            }
+            for (std::size_t i = 0; i < rows.size(); ++i) {
+                for (std::size_t j = i + 1; j < rows.size(); ++j) {
+                    const std::uint32_t a = findRoot(parent, rows[i]);
+                    const std::uint32_t b = findRoot(parent, rows[j]);
+                    if (a != b && jaccard(elements_[rows[i]], elements_[rows[j]]) >= threshold) {
+                        parent[std::max(a, b)] = std::min(a, b);
+                    }
+                }
+            }
+        }
+    }
+
+    // Roots are the first row of their group, so groups come out in row order
+    std::vector<std::vector<std::shared_ptr<core::Recipe>>> groups;
+    std::vector<std::uint32_t> groupOf(recipes_.size(), std::numeric_limits<std::uint32_t>::max());
+    std::vector<std::size_t> sizes(recipes_.size(), 0);
+    for (std::uint32_t row = 0; row < recipes_.size(); ++row) {
+        ++sizes[findRoot(parent, row)];
+    }
+    for (std::uint32_t row = 0; row < recipes_.size(); ++row) {
+        const std::uint32_t root = findRoot(parent, row);
+        if (sizes[root] < 2) {
+            continue;
+        }
+        if (groupOf[root] == std::numeric_limits<std::uint32_t>::max()) {
+            groupOf[root] = static_cast<std::uint32_t>(groups.size());
+            groups.emplace_back();
+        }
+        groups[groupOf[root]].push_back(recipes_[row]);
+    }
+    return groups;
+}
+
+double SimilarityIndex::similarity(const core::Recipe& first, const core::Recipe& second) {
+    return jaccard(elementsOf(first), elementsOf(second));
+}
+
+// Getters
+std::size_t SimilarityIndex::getRecipeCount() const {
+    return rowOf_.size();
+}
+
+const SimilarityIndex::Options& SimilarityIndex::getOptions() const {
+    return options_;
+}
+
+// Helpers
+std::vector<std::uint64_t> SimilarityIndex::elementsOf(const core::Recipe& recipe) {
+    const auto ingredients = recipe.expandIngredients();
+    std::vector<std::uint64_t> elements;
+    elements.reserve(ingredients.size());
+    for (const auto& ingredient : ingredients) {
+        if (!ingredient) {
+            throw std::invalid_argument("Recipe has a null ingredient: " + recipe.getName());
+        }
+        const auto name = IngredientIndex::normalizeName(ingredient->getName());
+        if (!name.empty()) {
+            elements.push_back(utils::FingerprintBuilder().add(name).finish().low);
+        }
+    }
+    std::sort(elements.begin(), elements.end());
+    elements.erase(std::unique(elements.begin(), elements.end()), elements.end());
+    return elements;
+}
+
+double SimilarityIndex::jaccard(const std::vector<std::uint64_t>& first, const std::vector<std::uint64_t>& second) {
+    if (first.empty() && second.empty()) {
+        return 0.0;
+    }
+    std::size_t shared = 0;
+    auto a = first.begin();
+    auto b = second.begin();
+    while (a != first.end() && b != second.end()) {
+        if (*a < *b) {
+            ++a;
+        } else if (*b < *a) {
+            ++b;
+        } else {
+            ++shared;
+            ++a;
+            ++b;
+        }
+    }
+    return static_cast<double>(shared) / static_cast<double>(first.size() + second.size() - shared);
+}
+
+void SimilarityIndex::sign(const std::vector<std::uint64_t>& elements, std::uint32_t* signature) const {
+    // Hash function i maps x to the high half of multipliers_[i] * x + offsets_[i]
+    const std::size_t k = width();
+    std::fill_n(signature, k, std::numeric_limits<std::uint32_t>::max());
+    for (std::uint64_t x : elements) {
+        for (std::size_t i = 0; i < k; ++i) {
+            const auto value = static_cast<std::uint32_t>((multipliers_[i] * x + offsets_[i]) >> 32);
+            signature[i] = std::min(signature[i], value);
+        }
+    }
+}
+
+std::uint64_t SimilarityIndex::bandKey(const std::uint32_t* signature, std::size_t band) const {
+    std::uint64_t key = band;
+    for (std::size_t r = 0; r < options_.rows; ++r) {
+        key = mix(key ^ signature[band * options_.rows + r]);
+    }
+    return key;
+}
+
+void SimilarityIndex::link(std::uint32_t row) {
+    // A recipe without ingredients resembles nothing, so it joins no bucket
+    if (elements_[row].empty()) {
+        return;
+    }
+    const std::uint32_t* signature = &signatures_[row * width()];
+    for (std::size_t band = 0; band < options_.bands; ++band) {
+        auto& table = bands_[band];
+        if (2 * (table.used + 1) > table.slots.size()) {
+            // Keep the table at most half full, reinserting every bucket
+            std::vector<Bucket> slots(std::max<std::size_t>(16, 2 * table.slots.size()), Bucket{0, kNone});
+            const std::size_t mask = slots.size() - 1;
+            for (const auto& bucket : table.slots) {
+                if (bucket.head != kNone) {
+                    std::size_t i = bucket.key & mask;
+                    while (slots[i].head != kNone) {
+                        i = (i + 1) & mask;
+                    }
+                    slots[i] = bucket;
+                }
+            }
+            table.slots = std::move(slots);
+        }
+        const std::uint64_t key = bandKey(signature, band);
+        const std::size_t mask = table.slots.size() - 1;
+        std::size_t i = key & mask;
+        while (table.slots[i].head != kNone && table.slots[i].key != key) {
+            i = (i + 1) & mask;
+        }
+        if (table.slots[i].head == kNone) {
+            table.slots[i].key = key;
+            ++table.used;
+        }
+        next_[row * options_.bands + band] = table.slots[i].head;
+        table.slots[i].head = row;
+    }
+}
+
+std::uint32_t SimilarityIndex::head(std::size_t band, std::uint64_t key) const {
+    const auto& slots = bands_[band].slots;
+    if (slots.empty()) {
+        return kNone;
+    }
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t i = key & mask; slots[i].head != kNone; i = (i + 1) & mask) {
+        if (slots[i].key == key) {
+            return slots[i].head;
+        }
+    }
+    return kNone;
+}
+
+void SimilarityIndex::rebuildBuckets() {
+    bands_.assign(options_.bands, {});
+    next_.assign(recipes_.size() * options_.bands, kNone);
+    retired_ = 0;
+    for (std::uint32_t row = 0; row < recipes_.size(); ++row) {
+        if (recipes_[row]) {
+            link(row);
+        }
+    }
+}
+
+std::vector<SimilarityIndex::Neighbor> SimilarityIndex::rank(const std::vector<std::uint64_t>& elements,
+                                                             const std::uint32_t* signature,
+                                                             const std::string& exclude, std::size_t limit,
+                                                             double minSimilarity) const {
+    std::vector<Neighbor> neighbors;
+    if (limit == 0 || elements.empty()) {
+        return neighbors;
+    }
+    std::vector<std::uint32_t> candidates;
+    for (std::size_t band = 0; band < options_.bands; ++band) {
+        const std::uint64_t key = bandKey(signature, band);
+        for (std::uint32_t row = head(band, key); row != kNone; row = next_[row * options_.bands + band]) {
+            if (recipes_[row]) {
+                candidates.push_back(row);
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::vector<std::pair<double, std::uint32_t>> scored;
+    for (std::uint32_t row : candidates) {
+        if (recipes_[row]->getId() == exclude) {
+            continue;
+        }
+        const double score = jaccard(elements, elements_[row]);
+        if (score >= minSimilarity) {
+            scored.emplace_back(score, row);
+        }
+    }
+    const std::size_t kept = std::min(limit, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + static_cast<std::ptrdiff_t>(kept), scored.end(), closer);
+    neighbors.reserve(kept);
+    for (std::size_t i = 0; i < kept; ++i) {
+        neighbors.push_back({recipes_[scored[i].second], scored[i].first});
+    }
+    return neighbors;
+}
+
+void SimilarityIndex::setOptions(const Options& options) {
+    if (options.bands == 0 || options.rows == 0) {
+        throw std::invalid_argument("Bands and rows must be positive");
+    }
+    options_ = options;
+    const std::size_t k = width();
+    multipliers_.resize(k);
+    offsets_.resize(k);
+    for (std::size_t i = 0; i < k; ++i) {
+        multipliers_[i] = mix(options.seed + 2 * i) | 1;
+        offsets_[i] = mix(options.seed + 2 * i + 1);
+    }
+    bands_.assign(options.bands, {});
+}
+
+std::size_t SimilarityIndex::width() const {
+    return options_.bands * options_.rows;
+}
+
+} // namespace algorithms
+} // namespace smart_food
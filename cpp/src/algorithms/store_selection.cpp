@@ -0,0 +1,507 @@
+#include "store_selection.hpp"
+#include <algorithm>
+#include <random>
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+namespace {
+
+constexpr double kInfinity = StoreSelectionProblem::kUnavailable;
+
+/// Improvements smaller than this are rounding noise
+constexpr double kEpsilon = 1e-9;
+
+double tourLength(const StoreSelectionProblem& problem, const std::vector<std::uint32_t>& route) {
+    double length = 0.0;
+    std::size_t at = 0;
+    for (std::uint32_t store : route) {
+        length += problem.between(at, store + 1);
+        at = store + 1;
+    }
+    return length + problem.between(at, 0);
+}
+
+/**
+ * @brief Shorten a tour with 2-opt and Or-opt moves until neither applies
+ */
+void improveTour(const StoreSelectionProblem& problem, std::vector<std::uint32_t>& route) {
+    // Work on distance indices with home in front; the tour closes back to nodes[0]
+    std::vector<std::size_t> nodes;
+    nodes.reserve(route.size() + 1);
+    nodes.push_back(0);
+    for (std::uint32_t store : route) {
+        nodes.push_back(store + 1);
+    }
+    const std::size_t count = nodes.size();
+    auto d = [&](std::size_t a, std::size_t b) { return problem.between(a, b); };
+
+    bool improved = count > 3;
+    while (improved) {
+        improved = false;
+        // 2-opt: replace edges (a, b) and (c, e) with (a, c) and (b, e)
+        for (std::size_t i = 0; i + 2 < count; ++i) {
+            for (std::size_t j = i + 2; j < count; ++j) {
+                const std::size_t a = nodes[i];
+                const std::size_t b = nodes[i + 1];
+                const std::size_t c = nodes[j];
+                const std::size_t e = nodes[(j + 1) % count];
+                if (e == a) {
+                    continue;
+                }
+                if (d(a, c) + d(b, e) < d(a, b) + d(c, e) - kEpsilon) {
+                    std::reverse(nodes.begin() + static_cast<std::ptrdiff_t>(i + 1),
+                                 nodes.begin() + static_cast<std::ptrdiff_t>(j + 1));
+                    improved = true;
+                }
+            }
+        }
+        // Or-opt: move a segment of up to three stores elsewhere, possibly reversed
+        for (std::size_t length = 1; length <= 3 && length + 1 < count; ++length) {
+            for (std::size_t i = 1; i + length <= count; ++i) {
+                const std::size_t first = nodes[i];
+                const std::size_t last = nodes[i + length - 1];
+                const std::size_t before = nodes[i - 1];
+                const std::size_t after = nodes[(i + length) % count];
+                const double gain = d(before, first) + d(last, after) - d(before, after);
+
+                std::vector<std::size_t> rest(nodes.begin(), nodes.begin() + static_cast<std::ptrdiff_t>(i));
+                rest.insert(rest.end(), nodes.begin() + static_cast<std::ptrdiff_t>(i + length), nodes.end());
+                double bestCost = gain - kEpsilon;
+                std::size_t bestAt = 0;
+                bool bestReversed = false;
+                for (std::size_t p = 0; p < rest.size(); ++p) {
+                    const std::size_t u = rest[p];
+                    const std::size_t v = rest[(p + 1) % rest.size()];
+                    if (u == before && v == after) {
+                        continue;
+                    }
+                    const double forward = d(u, first) + d(last, v) - d(u, v);
+                    const double backward = d(u, last) + d(first, v) - d(u, v);
+                    if (forward < bestCost) {
+                        bestCost = forward;
+                        bestAt = p + 1;
+                        bestReversed = false;
+                    }
+                    if (backward < bestCost) {
+                        bestCost = backward;
+                        bestAt = p + 1;
+                        bestReversed = true;
+                    }
+                }
+                if (bestAt != 0) {
+                    std::vector<std::size_t> segment(nodes.begin() + static_cast<std::ptrdiff_t>(i),
+                                                     nodes.begin() + static_cast<std::ptrdiff_t>(i + length));
+                    if (bestReversed) {
+                        std::reverse(segment.begin(), segment.end());
+                    }
+                    rest.insert(rest.begin() + static_cast<std::ptrdiff_t>(bestAt), segment.begin(), segment.end());
+                    nodes.swap(rest);
+                    improved = true;
+                }
+            }
+        }
+    }
+
+    for (std::size_t i = 1; i < count; ++i) {
+        route[i - 1] = static_cast<std::uint32_t>(nodes[i] - 1);
+    }
+}
+
+/// Cheapest place to insert a store into a tour: (added length, position in route)
+std::pair<double, std::size_t> cheapestInsertion(const StoreSelectionProblem& problem,
+                                                 const std::vector<std::uint32_t>& route, std::size_t store,
+                                                 std::size_t skip = static_cast<std::size_t>(-1)) {
+    double best = kInfinity;
+    std::size_t bestAt = 0;
+    std::size_t previous = 0;
+    std::size_t at = 0;
+    for (std::size_t p = 0; p <= route.size(); ++p) {
+        if (p < route.size() && p == skip) {
+            continue;
+        }
+        const std::size_t next = p < route.size() ? route[p] + 1 : 0;
+        const double added = problem.between(previous, store + 1) + problem.between(store + 1, next) -
+                             problem.between(previous, next);
+        if (added < best) {
+            best = added;
+            bestAt = at;
+        }
+        previous = next;
+        at = p + 1;
+    }
+    return {best, bestAt};
+}
+
+/// Local search state: the visited stores, their tour and each item's two cheapest stores in it
+class SetSearch {
+public:
+    explicit SetSearch(const StoreSelectionProblem& problem)
+        : problem_(problem)
+        , inSet_(problem.stores, false)
+        , best_(problem.items)
+        , second_(problem.items)
+        , bestCost_(problem.items)
+        , secondCost_(problem.items) {
+    }
+
+    void reset(const std::vector<std::uint32_t>& stores) {
+        std::fill(inSet_.begin(), inSet_.end(), false);
+        route_.clear();
+        for (std::uint32_t s : stores) {
+            insert(s);
+        }
+        improveTour(problem_, route_);
+        refresh();
+    }
+
+    /// Add the cheapest store of every item no visited store supplies
+    void repair() {
+        for (std::size_t i = 0; i < problem_.items; ++i) {
+            if (bestCost_[i] != kInfinity) {
+                continue;
+            }
+            std::size_t cheapest = 0;
+            for (std::size_t s = 1; s < problem_.stores; ++s) {
+                if (problem_.cost(i, s) < problem_.cost(i, cheapest)) {
+                    cheapest = s;
+                }
+            }
+            insert(static_cast<std::uint32_t>(cheapest));
+            refresh();
+        }
+        improveTour(problem_, route_);
+    }
+
+    /// Apply improving add, drop and swap moves until none is left, time runs out or the run is cancelled
+    void descend(std::chrono::steady_clock::time_point deadline, const CancellationToken& cancellation) {
+        while (std::chrono::steady_clock::now() < deadline && !cancellation.isCancelled()) {
+            double bestDelta = -kEpsilon;
+            std::size_t add = npos;
+            std::size_t drop = npos;
+
+            std::vector<std::size_t> positionOf(problem_.stores, npos);
+            for (std::size_t p = 0; p < route_.size(); ++p) {
+                positionOf[route_[p]] = p;
+            }
+            for (std::size_t s = 0; s < problem_.stores; ++s) {
+                if (inSet_[s]) {
+                    const double delta = dropItemDelta(s) + problem_.costPerDistance * removal(positionOf[s]);
+                    if (delta < bestDelta) {
+                        bestDelta = delta;
+                        add = npos;
+                        drop = s;
+                    }
+                    continue;
+                }
+                const double gain = addItemDelta(s);
+                const double added = cheapestInsertion(problem_, route_, s).first;
+                if (gain + problem_.costPerDistance * added < bestDelta) {
+                    bestDelta = gain + problem_.costPerDistance * added;
+                    add = s;
+                    drop = npos;
+                }
+                if (gain >= 0.0) {
+                    continue;  // A swap in of s cannot beat its plain add
+                }
+                for (std::uint32_t out : route_) {
+                    const double delta = swapItemDelta(out, s) +
+                                         problem_.costPerDistance *
+                                             (removal(positionOf[out]) +
+                                              cheapestInsertion(problem_, route_, s, positionOf[out]).first);
+                    if (delta < bestDelta) {
+                        bestDelta = delta;
+                        add = s;
+                        drop = out;
+                    }
+                }
+            }
+            if (add == npos && drop == npos) {
+                return;
+            }
+            if (drop != npos) {
+                inSet_[drop] = false;
+                route_.erase(std::find(route_.begin(), route_.end(), static_cast<std::uint32_t>(drop)));
+            }
+            if (add != npos) {
+                insert(static_cast<std::uint32_t>(add));
+            }
+            improveTour(problem_, route_);
+            refresh();
+        }
+    }
+
+    double total() const {
+        double items = 0.0;
+        for (double cost : bestCost_) {
+            items += cost;
+        }
+        return items + problem_.costPerDistance * tourLength(problem_, route_);
+    }
+
+    StoreSelection snapshot() const {
+        StoreSelection selection;
+        selection.route = route_;
+        selection.storeOf.assign(best_.begin(), best_.end());
+        for (double cost : bestCost_) {
+            selection.itemCost += cost;
+        }
+        selection.distance = tourLength(problem_, route_);
+        selection.total = selection.itemCost + problem_.costPerDistance * selection.distance;
+        return selection;
+    }
+
+    const std::vector<std::uint32_t>& route() const { return route_; }
+
+private:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    const StoreSelectionProblem& problem_;
+    std::vector<bool> inSet_;
+    std::vector<std::uint32_t> route_;
+    std::vector<std::uint32_t> best_;
+    std::vector<std::uint32_t> second_;
+    std::vector<double> bestCost_;
+    std::vector<double> secondCost_;
+
+    void insert(std::uint32_t store) {
+        if (inSet_[store]) {
+            return;
+        }
+        inSet_[store] = true;
+        const auto at = cheapestInsertion(problem_, route_, store).second;
+        route_.insert(route_.begin() + static_cast<std::ptrdiff_t>(at), store);
+    }
+
+    void refresh() {
+        for (std::size_t i = 0; i < problem_.items; ++i) {
+            bestCost_[i] = secondCost_[i] = kInfinity;
+            best_[i] = second_[i] = 0;
+            for (std::uint32_t s : route_) {
+                const double cost = problem_.cost(i, s);
+                if (cost < bestCost_[i]) {
+                    second_[i] = best_[i];
+                    secondCost_[i] = bestCost_[i];
+                    best_[i] = s;
+                    bestCost_[i] = cost;
+                } else if (cost < secondCost_[i]) {
+                    second_[i] = s;
+                    secondCost_[i] = cost;
+                }
+            }
+        }
+    }
+
+    /// Change of tour length when the store at a route position is skipped
+    double removal(std::size_t position) const {
+        const std::size_t previous = position == 0 ? 0 : route_[position - 1] + 1;
+        const std::size_t next = position + 1 < route_.size() ? route_[position + 1] + 1 : 0;
+        const std::size_t store = route_[position] + 1;
+        return problem_.between(previous, next) - problem_.between(previous, store) -
+               problem_.between(store, next);
+    }
+
+    double addItemDelta(std::size_t store) const {
+        double delta = 0.0;
+        for (std::size_t i = 0; i < problem_.items; ++i) {
+            delta += std::min(0.0, problem_.cost(i, store) - bestCost_[i]);
+        }
+        return delta;
+    }
+
+    double dropItemDelta(std::size_t store) const {
+        double delta = 0.0;
+        for (std::size_t i = 0; i < problem_.items; ++i) {
+            if (best_[i] == store) {
+                delta += secondCost_[i] - bestCost_[i];
+            }
+        }
+        return delta;
+    }
+
+    double swapItemDelta(std::size_t out, std::size_t in) const {
+        double delta = 0.0;
+        for (std::size_t i = 0; i < problem_.items; ++i) {
+            const double kept = best_[i] == out ? secondCost_[i] : bestCost_[i];
+            delta += std::min(kept, problem_.cost(i, in)) - bestCost_[i];
+        }
+        return delta;
+    }
+};
+
+} // namespace
+
+StoreSelection selectStoresExact(const StoreSelectionProblem& problem) {
+    const std::size_t n = problem.stores;
+    const std::size_t subsets = std::size_t{1} << n;
+
+    // Held-Karp: shortest path from home through a subset, ending at a store of it
+    std::vector<double> path(subsets * n, kInfinity);
+    for (std::size_t j = 0; j < n; ++j) {
+        path[(std::size_t{1} << j) * n + j] = problem.between(0, j + 1);
+    }
+    for (std::size_t mask = 1; mask < subsets; ++mask) {
+        for (std::size_t j = 0; j < n; ++j) {
+            const double length = path[mask * n + j];
+            if (length == kInfinity) {
+                continue;
+            }
+            for (std::size_t k = 0; k < n; ++k) {
+                if (mask >> k & 1) {
+                    continue;
+                }
+                double& target = path[(mask | std::size_t{1} << k) * n + k];
+                target = std::min(target, length + problem.between(j + 1, k + 1));
+            }
+        }
+    }
+    auto tour = [&](std::size_t mask) {
+        double best = mask == 0 ? 0.0 : kInfinity;
+        for (std::size_t j = 0; j < n; ++j) {
+            best = std::min(best, path[mask * n + j] + problem.between(j + 1, 0));
+        }
+        return best;
+    };
+
+    // Depth-first over subsets in increasing store order, carrying each item's cheapest price
+    std::size_t bestMask = 0;
+    double bestTotal = problem.items == 0 ? 0.0 : kInfinity;
+    std::vector<std::vector<double>> rows(n + 1, std::vector<double>(problem.items, kInfinity));
+    auto walk = [&](auto&& self, std::size_t start, std::size_t mask, std::size_t depth) -> void {
+        for (std::size_t s = start; s < n; ++s) {
+            const auto& row = rows[depth];
+            auto& next = rows[depth + 1];
+            double items = 0.0;
+            for (std::size_t i = 0; i < problem.items; ++i) {
+                next[i] = std::min(row[i], problem.cost(i, s));
+                items += next[i];
+            }
+            const std::size_t subset = mask | std::size_t{1} << s;
+            if (items != kInfinity) {
+                const double total = items + problem.costPerDistance * tour(subset);
+                if (total < bestTotal - kEpsilon) {
+                    bestTotal = total;
+                    bestMask = subset;
+                }
+            }
+            self(self, s + 1, subset, depth + 1);
+        }
+    };
+    walk(walk, 0, 0, 0);
+
+    StoreSelection selection;
+    if (bestTotal == kInfinity) {
+        return selection;
+    }
+    // Walk the Held-Karp table back from the best subset
+    std::size_t mask = bestMask;
+    std::size_t last = n;
+    double length = tour(mask);
+    for (std::size_t j = 0; j < n && mask != 0; ++j) {
+        if (path[mask * n + j] + problem.between(j + 1, 0) <= length + kEpsilon) {
+            last = j;
+            break;
+        }
+    }
+    while (mask != 0) {
+        selection.route.push_back(static_cast<std::uint32_t>(last));
+        const std::size_t previousMask = mask ^ (std::size_t{1} << last);
+        if (previousMask == 0) {
+            break;
+        }
+        const double here = path[mask * n + last];
+        std::size_t previous = n;
+        for (std::size_t k = 0; k < n; ++k) {
+            if ((previousMask >> k & 1) &&
+                path[previousMask * n + k] + problem.between(k + 1, last + 1) <= here + kEpsilon) {
+                previous = k;
+                break;
+            }
+        }
+        mask = previousMask;
+        last = previous;
+    }
+    std::reverse(selection.route.begin(), selection.route.end());
+
+    selection.storeOf.assign(problem.items, 0);
+    for (std::size_t i = 0; i < problem.items; ++i) {
+        double cheapest = kInfinity;
+        for (std::uint32_t s : selection.route) {
+            if (problem.cost(i, s) < cheapest) {
+                cheapest = problem.cost(i, s);
+                selection.storeOf[i] = s;
+            }
+        }
+        selection.itemCost += cheapest;
+    }
+    selection.distance = tourLength(problem, selection.route);
+    selection.total = selection.itemCost + problem.costPerDistance * selection.distance;
+    selection.optimal = true;
+    return selection;
+}
+
+StoreSelection selectStoresHeuristic(const StoreSelectionProblem& problem,
+                                     std::chrono::steady_clock::time_point deadline,
+                                     const CancellationToken& cancellation, std::size_t maxRestarts,
+                                     std::uint64_t seed,
+                                     const std::function<void(const StoreSelection&)>& improved) {
+    if (problem.items == 0) {
+        StoreSelection selection;
+        selection.total = 0.0;
+        return selection;
+    }
+
+    // Start from every item's cheapest store, then let the search drop the detours
+    std::vector<std::uint32_t> start;
+    std::vector<bool> chosen(problem.stores, false);
+    for (std::size_t i = 0; i < problem.items; ++i) {
+        std::size_t cheapest = 0;
+        for (std::size_t s = 1; s < problem.stores; ++s) {
+            if (problem.cost(i, s) < problem.cost(i, cheapest)) {
+                cheapest = s;
+            }
+        }
+        if (!chosen[cheapest]) {
+            chosen[cheapest] = true;
+            start.push_back(static_cast<std::uint32_t>(cheapest));
+        }
+    }
+
+    SetSearch search(problem);
+    search.reset(start);
+    search.descend(deadline, cancellation);
+    StoreSelection best = search.snapshot();
+    if (improved) {
+        improved(best);
+    }
+
+    std::mt19937_64 rng(seed);
+    for (std::size_t restart = 0;
+         restart < maxRestarts && std::chrono::steady_clock::now() < deadline && !cancellation.isCancelled();
+         ++restart) {
+        // Drop up to three visited stores, visit up to two others, repair and descend again
+        std::vector<std::uint32_t> stores = best.route;
+        std::shuffle(stores.begin(), stores.end(), rng);
+        const std::size_t dropped = std::min<std::size_t>(stores.size(), 1 + rng() % 3);
+        stores.resize(stores.size() - dropped);
+        const std::size_t added = rng() % 3;
+        for (std::size_t a = 0; a < added; ++a) {
+            stores.push_back(static_cast<std::uint32_t>(rng() % problem.stores));
+        }
+        search.reset(stores);
+        search.repair();
+        search.descend(deadline, cancellation);
+        if (search.total() < best.total - kEpsilon) {
+            best = search.snapshot();
+            if (improved) {
+                improved(best);
+            }
+        }
+    }
+    return best;
+}
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
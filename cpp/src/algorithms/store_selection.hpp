@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+#include "smart_food/algorithms/anytime.hpp"
+
+namespace smart_food {
+namespace algorithms {
+namespace detail {
+
+/**
+ * @brief Which stores to visit, and in what order, to buy a list of items.
+ *
+ * Every item is bought at the cheapest store of the visited set, and the
+ * trip starts and ends at home. The cost is the item cost plus the tour
+ * length times costPerDistance.
+ */
+struct StoreSelectionProblem {
+    static constexpr double kUnavailable = std::numeric_limits<double>::infinity();
+
+    std::size_t stores = 0;
+    std::size_t items = 0;
+    std::vector<double> itemCost;   ///< items * stores, row-major; kUnavailable if the store cannot supply the item
+    std::vector<double> distance;   ///< (stores + 1)^2, symmetric; index 0 is home, store s is s + 1
+    double costPerDistance = 1.0;
+
+    double cost(std::size_t item, std::size_t store) const { return itemCost[item * stores + store]; }
+    double between(std::size_t from, std::size_t to) const { return distance[from * (stores + 1) + to]; }
+};
+
+/**
+ * @brief Result of the store selection solvers
+ */
+struct StoreSelection {
+    std::vector<std::uint32_t> route;    ///< Stores in visiting order
+    std::vector<std::uint32_t> storeOf;  ///< Item -> store it is bought at
+    double itemCost = 0.0;
+    double distance = 0.0;               ///< Tour length, home to home
+    double total = StoreSelectionProblem::kUnavailable;
+    bool optimal = false;
+};
+
+/**
+ * @brief Solve exactly by enumerating every store subset.
+ *
+ * Tour lengths of all subsets come from one Held-Karp table, and item costs
+ * from a depth-first walk over the subsets that extends the per-item minima
+ * one store at a time; both are O(2^stores) in the number of subsets, so
+ * this is meant for a dozen or so stores. Every item must be available at
+ * some store.
+ */
+StoreSelection selectStoresExact(const StoreSelectionProblem& problem);
+
+/**
+ * @brief Solve heuristically with iterated local search.
+ *
+ * Starts from the stores that are cheapest for some item. The local search
+ * adds, drops and swaps stores, pricing item costs from each item's best and
+ * second-best store in the set and travel from insertion and removal
+ * deltas on the current tour, which 2-opt and Or-opt then tighten. Once it
+ * converges the set is perturbed by dropping a few random stores, repaired
+ * and searched again, keeping the best trip, until the deadline, the
+ * restart limit or cancellation. Every item must be available at some store.
+ *
+ * @param problem The instance
+ * @param deadline Time to return by, after finishing the current move
+ * @param cancellation Checked with the deadline, between moves
+ * @param maxRestarts Perturbations after the first descent
+ * @param seed Random seed for the perturbations
+ * @param improved Called with the first descent's selection and every better one found after it, if set
+ */
+StoreSelection selectStoresHeuristic(const StoreSelectionProblem& problem,
+                                     std::chrono::steady_clock::time_point deadline,
+                                     const CancellationToken& cancellation, std::size_t maxRestarts,
+                                     std::uint64_t seed,
+                                     const std::function<void(const StoreSelection&)>& improved = {});
+
+} // namespace detail
+} // namespace algorithms
+} // namespace smart_food
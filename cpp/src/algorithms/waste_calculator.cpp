@@ -0,0 +1,569 @@
+#include "smart_food/algorithms/waste_calculator.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include "smart_food/core/storage.hpp"
+#include "smart_food/utils/thread_pool.hpp"
+
+namespace smart_food {
+namespace algorithms {
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+using Unit = core::Ingredient::Unit;
+
+/// Quantity below which a lot counts as used up
+constexpr double kQuantityTolerance = 1e-9;
+
+/// Event kinds, in the order they are handled at the same time: a lot can
+/// serve a meal planned at its arrival, and one planned at its expiry
+enum class EventKind : std::uint8_t { ARRIVAL, MEAL, EXPIRY };
+
+struct Event {
+    Clock::time_point time;
+    EventKind kind;
+    std::uint32_t index;  ///< Lot for arrivals and expiries, use for meals
+};
+
+Unit baseUnit(IngredientIndex::Dimension dimension) {
+    switch (dimension) {
+        case IngredientIndex::Dimension::MASS:   return Unit::GRAM;
+        case IngredientIndex::Dimension::VOLUME: return Unit::MILLILITER;
+        case IngredientIndex::Dimension::COUNT:  return Unit::PIECE;
+    }
+    throw std::invalid_argument("Unknown dimension");
+}
+
+bool stillToCook(const core::Meal& meal) {
+    return meal.getStatus() == core::Meal::Status::PLANNED || meal.getStatus() == core::Meal::Status::SHOPPING;
+}
+
+constexpr std::size_t kLanes = WasteCalculator::kLanes;
+
+/// Random streams of estimateRisk(), one per kind of event sampled
+enum class Stream : std::uint64_t { SKIP = 1, PORTION = 2, SPOILAGE = 3 };
+
+/// SplitMix64 finalizer
+std::uint64_t mix(std::uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+/// Key of a scenario's random streams; hoisted out of the per-draw hash
+std::uint64_t scenarioKey(std::uint64_t seed, std::uint64_t scenario) {
+    return mix(seed ^ mix(scenario));
+}
+
+/**
+ * Counter-based random bits: a pure function of the scenario key, the
+ * stream and the counter, so a scenario draws the same numbers whichever
+ * thread and batch it runs in.
+ */
+std::uint64_t draw(std::uint64_t key, Stream stream, std::uint64_t counter) {
+    return mix(key ^ (static_cast<std::uint64_t>(stream) << 56) ^ counter);
+}
+
+/// Uniform in (0, 1)
+double uniform(std::uint64_t key, Stream stream, std::uint64_t counter) {
+    return (static_cast<double>(draw(key, stream, counter) >> 11) + 0.5) * 0x1.0p-53;
+}
+
+/// Inverse of the standard normal CDF, by Acklam's rational approximation
+double normalQuantile(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    auto tail = [&](double q) {
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    };
+    if (p < 0.02425) {
+        return tail(std::sqrt(-2.0 * std::log(p)));
+    }
+    if (p > 1.0 - 0.02425) {
+        return -tail(std::sqrt(-2.0 * std::log(1.0 - p)));
+    }
+    const double q = p - 0.5;
+    const double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+}
+
+/// Quantiles of the standard normal at the edges of kNormalBins equally likely bins
+constexpr int kNormalBits = 12;
+constexpr std::size_t kNormalBins = std::size_t(1) << kNormalBits;
+
+std::array<double, kNormalBins + 1> normalTable() {
+    std::array<double, kNormalBins + 1> table{};
+    for (std::size_t i = 0; i <= kNormalBins; ++i) {
+        // The outer edges are clipped at the 2^-14 quantile, about 3.8 deviations
+        const double p = std::min(std::max(static_cast<double>(i) / kNormalBins, 0x1.0p-14), 1.0 - 0x1.0p-14);
+        table[i] = normalQuantile(p);
+    }
+    return table;
+}
+
+/**
+ * Standard normal from one draw by inverse transform: the top bits pick an
+ * equally likely bin of the quantile table and the next ones interpolate
+ * in it. A table lookup instead of a log and a cosine per variate, which
+ * dominated the scenario sweep; the tails are cut at about 3.8 deviations.
+ */
+double normal(std::uint64_t key, Stream stream, std::uint64_t counter) {
+    static const std::array<double, kNormalBins + 1> table = normalTable();
+    const std::uint64_t bits = draw(key, stream, counter);
+    const std::size_t bin = static_cast<std::size_t>(bits >> (64 - kNormalBits));
+    const double fraction = static_cast<double>((bits >> (32 - kNormalBits)) & 0xFFFFFFFFu) * 0x1.0p-32;
+    return table[bin] + fraction * (table[bin + 1] - table[bin]);
+}
+
+/// Lots and uses of one identity, for the lockstep scenario sweep
+struct RiskGroup {
+    std::uint32_t id;
+    std::vector<std::uint32_t> lots;  ///< By expiry date, the order they are used in
+    std::vector<std::uint32_t> uses;  ///< In time order
+};
+
+/// Waste of one batch of scenarios
+struct BatchResult {
+    std::array<double, kLanes> cost{};
+    std::vector<double> quantity;  ///< Group -> quantity wasted, summed over the batch
+    std::vector<double> groupCost; ///< Group -> cost wasted, summed over the batch
+    std::vector<double> wasting;   ///< Group -> scenarios of the batch wasting some
+};
+
+} // namespace
+
+// Constructors
+WasteCalculator::WasteCalculator()
+    : WasteCalculator(core::Storage::getInstance().getIngredients()) {
+}
+
+WasteCalculator::WasteCalculator(const std::vector<std::shared_ptr<core::Ingredient>>& inventory) {
+    setInventory(inventory);
+}
+
+// Setters
+void WasteCalculator::setInventory(const std::vector<std::shared_ptr<core::Ingredient>>& inventory) {
+    std::vector<Lot> stock;
+    stock.reserve(inventory.size());
+    for (const auto& lot : inventory) {
+        stock.push_back(makeLot(lot, Clock::time_point::min()));
+    }
+    stock_ = std::move(stock);
+}
+
+void WasteCalculator::addPurchase(const std::shared_ptr<core::Ingredient>& lot, Clock::time_point arrival) {
+    purchases_.push_back(makeLot(lot, arrival));
+}
+
+void WasteCalculator::clearPurchases() {
+    purchases_.clear();
+}
+
+// Operations
+WasteCalculator::Projection WasteCalculator::simulate(const std::vector<std::shared_ptr<core::Meal>>& meals,
+                                                      Clock::time_point start, Clock::time_point end) const {
+    const auto clockStart = std::chrono::steady_clock::now();
+    if (end < start) {
+        throw std::invalid_argument("Horizon ends before it starts");
+    }
+
+    Projection projection;
+    std::size_t stocked = 0;
+    const std::vector<Lot> lots = horizonLots(start, end, stocked);
+    const std::vector<Use> uses = horizonUses(meals, start, end, projection.mealCount);
+
+    std::vector<Event> events;
+    events.reserve(2 * lots.size() + uses.size());
+    for (std::uint32_t l = 0; l < lots.size(); ++l) {
+        if (l >= stocked) {
+            events.push_back({lots[l].arrival, EventKind::ARRIVAL, l});
+        }
+        if (lots[l].expiry <= end) {
+            // A lot that arrives spoiled is wasted on arrival
+            events.push_back({std::max(lots[l].expiry, lots[l].arrival), EventKind::EXPIRY, l});
+        }
+    }
+    for (std::uint32_t u = 0; u < uses.size(); ++u) {
+        events.push_back({uses[u].time, EventKind::MEAL, u});
+    }
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return a.time != b.time ? a.time < b.time : a.kind < b.kind;
+    });
+
+    // Sweep: lots of each identity in a queue by expiry, lazily dropping the
+    // ones used up or spoiled
+    using Entry = std::pair<Clock::time_point, std::uint32_t>;
+    using Queue = std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>;
+    std::vector<Queue> queues(index_.size());
+    std::vector<double> remaining(lots.size());
+    for (std::uint32_t l = 0; l < lots.size(); ++l) {
+        remaining[l] = lots[l].quantity;
+        if (l < stocked) {
+            queues[lots[l].id].emplace(lots[l].expiry, l);
+        }
+    }
+    const auto day = std::chrono::hours(24);
+    projection.dailyWasteCost.assign(static_cast<std::size_t>((end - start) / day) + 1, 0.0);
+
+    for (const auto& event : events) {
+        switch (event.kind) {
+            case EventKind::ARRIVAL: {
+                const Lot& lot = lots[event.index];
+                queues[lot.id].emplace(lot.expiry, event.index);
+                break;
+            }
+            case EventKind::MEAL: {
+                const Use& use = uses[event.index];
+                double missing = use.quantity;
+                if (use.id != IngredientIndex::npos) {
+                    auto& queue = queues[use.id];
+                    while (missing > 0.0 && !queue.empty()) {
+                        const std::uint32_t l = queue.top().second;
+                        if (lots[l].expiry < event.time || remaining[l] <= 0.0) {
+                            queue.pop();
+                            continue;
+                        }
+                        const double taken = std::min(missing, remaining[l]);
+                        remaining[l] -= taken;
+                        missing -= taken;
+                        if (remaining[l] <= kQuantityTolerance * lots[l].quantity) {
+                            remaining[l] = 0.0;
+                            queue.pop();
+                        }
+                    }
+                }
+                if (missing > kQuantityTolerance * use.quantity) {
+                    projection.shortages.push_back({IngredientIndex::normalizeName(use.ingredient->getName()),
+                                                    baseUnit(IngredientIndex::dimensionOf(use.ingredient->getUnit())),
+                                                    missing, event.time});
+                }
+                break;
+            }
+            case EventKind::EXPIRY: {
+                const Lot& lot = lots[event.index];
+                if (remaining[event.index] > 0.0) {
+                    const double cost = remaining[event.index] * lot.unitCost;
+                    projection.waste.push_back({index_.getName(lot.id), baseUnit(index_.getDimension(lot.id)),
+                                                remaining[event.index], cost, event.time});
+                    projection.wasteCost += cost;
+                    projection.dailyWasteCost[static_cast<std::size_t>((event.time - start) / day)] += cost;
+                    remaining[event.index] = 0.0;
+                }
+                break;
+            }
+        }
+    }
+
+    projection.simulationTime =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - clockStart);
+    return projection;
+}
+
+WasteCalculator::RiskProfile WasteCalculator::estimateRisk(const std::vector<std::shared_ptr<core::Meal>>& meals,
+                                                           Clock::time_point start, Clock::time_point end,
+                                                           const RiskOptions& options) const {
+    const auto clockStart = std::chrono::steady_clock::now();
+    if (end < start) {
+        throw std::invalid_argument("Horizon ends before it starts");
+    }
+    if (options.scenarios == 0) {
+        throw std::invalid_argument("At least one scenario is needed");
+    }
+    if (!(options.skipProbability >= 0.0 && options.skipProbability <= 1.0)) {
+        throw std::invalid_argument("Skip probability must be in [0, 1]");
+    }
+    if (!(options.portionSpread >= 0.0) || !(options.spoilageSpreadDays >= 0.0) ||
+        std::isinf(options.portionSpread) || std::isinf(options.spoilageSpreadDays)) {
+        throw std::invalid_argument("Spreads must be finite and non-negative");
+    }
+    for (double p : options.percentiles) {
+        if (!(p >= 0.0 && p <= 1.0)) {
+            throw std::invalid_argument("Percentiles must be in [0, 1]");
+        }
+    }
+
+    std::size_t stocked = 0;
+    std::size_t mealCount = 0;
+    const std::vector<Lot> lots = horizonLots(start, end, stocked);
+    const std::vector<Use> uses = horizonUses(meals, start, end, mealCount);
+
+    // Times in seconds from the start; stock is there from the beginning and
+    // an undated lot never spoils
+    const double inf = std::numeric_limits<double>::infinity();
+    auto seconds = [&](Clock::time_point time) { return std::chrono::duration<double>(time - start).count(); };
+    const double horizon = seconds(end);
+    std::vector<double> arrival(lots.size());
+    std::vector<double> expiry(lots.size());
+    for (std::size_t l = 0; l < lots.size(); ++l) {
+        arrival[l] = l < stocked ? -inf : seconds(lots[l].arrival);
+        expiry[l] = lots[l].expiry == Clock::time_point::max() ? inf : seconds(lots[l].expiry);
+    }
+    std::vector<double> useTime(uses.size());
+    for (std::size_t u = 0; u < uses.size(); ++u) {
+        useTime[u] = seconds(uses[u].time);
+    }
+
+    std::vector<RiskGroup> groups;
+    std::vector<std::uint32_t> groupOf(index_.size(), IngredientIndex::npos);
+    for (std::uint32_t l = 0; l < lots.size(); ++l) {
+        if (groupOf[lots[l].id] == IngredientIndex::npos) {
+            groupOf[lots[l].id] = static_cast<std::uint32_t>(groups.size());
+            groups.push_back({lots[l].id, {}, {}});
+        }
+        groups[groupOf[lots[l].id]].lots.push_back(l);
+    }
+    for (std::uint32_t u = 0; u < uses.size(); ++u) {
+        if (uses[u].id != IngredientIndex::npos && groupOf[uses[u].id] != IngredientIndex::npos) {
+            groups[groupOf[uses[u].id]].uses.push_back(u);
+        }
+    }
+    for (auto& group : groups) {
+        std::stable_sort(group.lots.begin(), group.lots.end(),
+                         [&](std::uint32_t a, std::uint32_t b) { return lots[a].expiry < lots[b].expiry; });
+        std::stable_sort(group.uses.begin(), group.uses.end(),
+                         [&](std::uint32_t a, std::uint32_t b) { return uses[a].time < uses[b].time; });
+    }
+
+    // Each batch sweeps every group once with kLanes scenarios side by side
+    const std::size_t batchCount = (options.scenarios + kLanes - 1) / kLanes;
+    std::vector<BatchResult> batches(batchCount);
+    const double spoilageSpread = options.spoilageSpreadDays * 86400.0;
+    auto body = [&](std::size_t b) {
+        BatchResult& result = batches[b];
+        result.quantity.assign(groups.size(), 0.0);
+        result.groupCost.assign(groups.size(), 0.0);
+        result.wasting.assign(groups.size(), 0.0);
+        const std::size_t first = b * kLanes;
+        const std::size_t lanes = std::min(kLanes, options.scenarios - first);
+
+        std::array<std::uint64_t, kLanes> keys;
+        for (std::size_t lane = 0; lane < kLanes; ++lane) {
+            keys[lane] = scenarioKey(options.seed, first + lane);
+        }
+        std::vector<double> cooked(mealCount * kLanes, 1.0);
+        if (options.skipProbability > 0.0) {
+            for (std::size_t m = 0; m < mealCount; ++m) {
+                for (std::size_t lane = 0; lane < kLanes; ++lane) {
+                    if (uniform(keys[lane], Stream::SKIP, m) < options.skipProbability) {
+                        cooked[m * kLanes + lane] = 0.0;
+                    }
+                }
+            }
+        }
+
+        std::vector<double> remaining;
+        std::vector<double> spoils;
+        alignas(64) double need[kLanes];
+        for (std::size_t g = 0; g < groups.size(); ++g) {
+            const RiskGroup& group = groups[g];
+            const std::size_t count = group.lots.size();
+            remaining.resize(count * kLanes);
+            spoils.resize(count * kLanes);
+            for (std::size_t k = 0; k < count; ++k) {
+                const std::uint32_t l = group.lots[k];
+                for (std::size_t lane = 0; lane < kLanes; ++lane) {
+                    remaining[k * kLanes + lane] = lots[l].quantity;
+                    spoils[k * kLanes + lane] =
+                        expiry[l] == inf || spoilageSpread == 0.0
+                            ? expiry[l]
+                            : expiry[l] + spoilageSpread * normal(keys[lane], Stream::SPOILAGE, l);
+                }
+            }
+
+            for (std::uint32_t u : group.uses) {
+                const double time = useTime[u];
+                for (std::size_t lane = 0; lane < kLanes; ++lane) {
+                    double portion = 1.0;
+                    if (options.portionSpread > 0.0) {
+                        portion = std::max(0.0, 1.0 + options.portionSpread *
+                                                          normal(keys[lane], Stream::PORTION, u));
+                    }
+                    need[lane] = uses[u].quantity * portion * cooked[uses[u].meal * kLanes + lane];
+                }
+                for (std::size_t k = 0; k < count; ++k) {
+                    if (arrival[group.lots[k]] > time) {
+                        continue;
+                    }
+                    double* rem = &remaining[k * kLanes];
+                    const double* spoil = &spoils[k * kLanes];
+                    double left = 0.0;
+                    for (std::size_t lane = 0; lane < kLanes; ++lane) {
+                        const double taken = spoil[lane] >= time ? std::min(need[lane], rem[lane]) : 0.0;
+                        rem[lane] -= taken;
+                        need[lane] -= taken;
+                        left = std::max(left, need[lane]);
+                    }
+                    if (!(left > 0.0)) {
+                        break;
+                    }
+                }
+            }
+
+            // Whatever is left of a lot spoiling within the horizon is waste
+            bool wastes[kLanes] = {};
+            for (std::size_t k = 0; k < count; ++k) {
+                const Lot& lot = lots[group.lots[k]];
+                for (std::size_t lane = 0; lane < lanes; ++lane) {
+                    const double rem = remaining[k * kLanes + lane];
+                    if (spoils[k * kLanes + lane] <= horizon && rem > kQuantityTolerance * lot.quantity) {
+                        result.cost[lane] += rem * lot.unitCost;
+                        result.quantity[g] += rem;
+                        result.groupCost[g] += rem * lot.unitCost;
+                        wastes[lane] = true;
+                    }
+                }
+            }
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                result.wasting[g] += wastes[lane] ? 1.0 : 0.0;
+            }
+        }
+    };
+    if (batchCount <= 1 || options.threads == 1) {
+        for (std::size_t b = 0; b < batchCount; ++b) {
+            body(b);
+        }
+    } else if (options.threads == 0) {
+        utils::ThreadPool::shared().parallelFor(batchCount, body);
+    } else {
+        utils::ThreadPool pool(options.threads);
+        pool.parallelFor(batchCount, body);
+    }
+
+    // Reduce in scenario order, so the sums do not depend on the thread count
+    RiskProfile profile;
+    profile.scenarios = options.scenarios;
+    std::vector<double> costs;
+    costs.reserve(options.scenarios);
+    std::vector<double> quantity(groups.size(), 0.0);
+    std::vector<double> groupCost(groups.size(), 0.0);
+    std::vector<double> wasting(groups.size(), 0.0);
+    for (std::size_t b = 0; b < batchCount; ++b) {
+        const std::size_t lanes = std::min(kLanes, options.scenarios - b * kLanes);
+        costs.insert(costs.end(), batches[b].cost.begin(), batches[b].cost.begin() + lanes);
+        for (std::size_t g = 0; g < groups.size(); ++g) {
+            quantity[g] += batches[b].quantity[g];
+            groupCost[g] += batches[b].groupCost[g];
+            wasting[g] += batches[b].wasting[g];
+        }
+    }
+    const double n = static_cast<double>(options.scenarios);
+    double sum = 0.0;
+    for (double cost : costs) {
+        sum += cost;
+    }
+    profile.expectedCost = sum / n;
+    double squares = 0.0;
+    for (double cost : costs) {
+        squares += (cost - profile.expectedCost) * (cost - profile.expectedCost);
+    }
+    profile.standardDeviation = std::sqrt(squares / n);
+    std::sort(costs.begin(), costs.end());
+    for (double p : options.percentiles) {
+        const double rank = p * (n - 1.0);
+        const std::size_t below = static_cast<std::size_t>(rank);
+        const std::size_t above = std::min(below + 1, costs.size() - 1);
+        profile.percentileCosts.push_back(costs[below] + (rank - below) * (costs[above] - costs[below]));
+    }
+
+    for (std::size_t g = 0; g < groups.size(); ++g) {
+        if (wasting[g] > 0.0) {
+            const std::uint32_t id = groups[g].id;
+            profile.ingredients.push_back({index_.getName(id), baseUnit(index_.getDimension(id)), quantity[g] / n,
+                                           groupCost[g] / n, wasting[g] / n});
+        }
+    }
+    std::sort(profile.ingredients.begin(), profile.ingredients.end(),
+              [](const IngredientRisk& a, const IngredientRisk& b) {
+                  return a.expectedCost != b.expectedCost ? a.expectedCost > b.expectedCost
+                                                          : a.ingredient < b.ingredient;
+              });
+
+    profile.simulationTime =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - clockStart);
+    return profile;
+}
+
+// Helpers
+WasteCalculator::Lot WasteCalculator::makeLot(const std::shared_ptr<core::Ingredient>& lot,
+                                              Clock::time_point arrival) {
+    if (!lot) {
+        throw std::invalid_argument("Cannot simulate a null lot");
+    }
+    const auto expiry = lot->getExpiryDate() == Clock::time_point{} ? Clock::time_point::max()
+                                                                    : lot->getExpiryDate();
+    return Lot{index_.intern(*lot), std::max(0.0, IngredientIndex::baseQuantity(*lot)),
+               IngredientIndex::basePrice(*lot), expiry, arrival};
+}
+
+std::vector<WasteCalculator::Lot> WasteCalculator::horizonLots(Clock::time_point start, Clock::time_point end,
+                                                               std::size_t& stocked) const {
+    std::vector<Lot> lots;
+    lots.reserve(stock_.size() + purchases_.size());
+    for (const auto& lot : stock_) {
+        if (lot.expiry >= start) {
+            lots.push_back(lot);
+        }
+    }
+    stocked = lots.size();
+    for (const auto& lot : purchases_) {
+        if (lot.arrival >= start && lot.arrival <= end) {
+            lots.push_back(lot);
+        }
+    }
+    return lots;
+}
+
+std::vector<WasteCalculator::Use> WasteCalculator::horizonUses(const std::vector<std::shared_ptr<core::Meal>>& meals,
+                                                               Clock::time_point start, Clock::time_point end,
+                                                               std::size_t& mealCount) const {
+    // Raw spellings repeat across meals, so they are resolved once each
+    // instead of normalizing every ingredient name
+    std::vector<Use> uses;
+    std::array<std::unordered_map<std::string, std::uint32_t>, 3> idOf;
+    mealCount = 0;
+    for (const auto& meal : meals) {
+        if (!meal) {
+            throw std::invalid_argument("Cannot simulate a null meal");
+        }
+        const auto time = meal->getPlannedTime();
+        if (!stillToCook(*meal) || time < start || time > end) {
+            continue;
+        }
+        for (const auto& ingredient : meal->getIngredients()) {
+            if (!ingredient) {
+                throw std::invalid_argument("Meal has a null ingredient: " + meal->getName());
+            }
+            const double quantity = IngredientIndex::baseQuantity(*ingredient);
+            if (!(quantity > 0.0)) {
+                continue;
+            }
+            const auto dimension = IngredientIndex::dimensionOf(ingredient->getUnit());
+            auto& ids = idOf[static_cast<std::size_t>(dimension)];
+            auto known = ids.find(ingredient->getName());
+            if (known == ids.end()) {
+                known = ids.emplace(ingredient->getName(), index_.find(ingredient->getName(), dimension)).first;
+            }
+            uses.push_back({known->second, static_cast<std::uint32_t>(mealCount), quantity, time, ingredient.get()});
+        }
+        ++mealCount;
+    }
+    return uses;
+}
+
+} // namespace algorithms
+} // namespace smart_food
@@ -97,9 +97,9 @@ void Meal::setPlannedTime(const std::chrono::system_clock::time_point& time) {
 void Meal::setRecipe(const std::shared_ptr<Recipe>& recipe) {
     recipe_ = recipe;
     if (recipe_) {
-        // Clear existing ingredients and copy from recipe
+        // Clear existing ingredients and copy from recipe, including those of its components
         ingredients_.clear();
-        for (const auto& ingredient : recipe_->getIngredients()) {
+        for (const auto& ingredient : recipe_->expandIngredients()) {
             ingredients_.push_back(std::make_shared<Ingredient>(*ingredient));
         }
         scaleServings(servings_);
@@ -0,0 +1,112 @@
+#include "smart_food/core/pack_offer.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace smart_food {
+namespace core {
+
+// Constructors
+PackOffer::PackOffer(const std::string& store, const std::string& ingredient, double packSize,
+                     Ingredient::Unit unit, double packPrice)
+    : store_(store)
+    , ingredient_(ingredient)
+    , packSize_(packSize)
+    , unit_(unit)
+    , packPrice_(packPrice) {
+    if (store.empty()) {
+        throw std::invalid_argument("Store name cannot be empty");
+    }
+    if (ingredient.empty()) {
+        throw std::invalid_argument("Ingredient name cannot be empty");
+    }
+    if (!(packSize > 0.0) || packSize == std::numeric_limits<double>::infinity()) {
+        throw std::invalid_argument("Pack size must be positive");
+    }
+    if (!(packPrice >= 0.0) || packPrice == std::numeric_limits<double>::infinity()) {
+        throw std::invalid_argument("Pack price cannot be negative");
+    }
+}
+
+// Getters
+const std::string& PackOffer::getStore() const {
+    return store_;
+}
+
+const std::string& PackOffer::getIngredient() const {
+    return ingredient_;
+}
+
+double PackOffer::getPackSize() const {
+    return packSize_;
+}
+
+Ingredient::Unit PackOffer::getUnit() const {
+    return unit_;
+}
+
+double PackOffer::getPackPrice() const {
+    return packPrice_;
+}
+
+const std::vector<PackOffer::PriceTier>& PackOffer::getPriceTiers() const {
+    return tiers_;
+}
+
+int PackOffer::getStock() const {
+    return stock_;
+}
+
+// Setters
+void PackOffer::setPackPrice(double packPrice) {
+    if (!(packPrice >= 0.0) || packPrice == std::numeric_limits<double>::infinity()) {
+        throw std::invalid_argument("Pack price cannot be negative");
+    }
+    if (packPrice_ > 0.0) {
+        const double scale = packPrice / packPrice_;
+        for (auto& tier : tiers_) {
+            tier.packPrice *= scale;
+        }
+    }
+    packPrice_ = packPrice;
+}
+
+void PackOffer::addPriceTier(int minPacks, double packPrice) {
+    if (minPacks < 2) {
+        throw std::invalid_argument("A price tier needs at least 2 packs");
+    }
+    if (!(packPrice >= 0.0) || packPrice == std::numeric_limits<double>::infinity()) {
+        throw std::invalid_argument("Pack price cannot be negative");
+    }
+    auto it = std::lower_bound(tiers_.begin(), tiers_.end(), minPacks,
+                               [](const PriceTier& tier, int packs) { return tier.minPacks < packs; });
+    if (it != tiers_.end() && it->minPacks == minPacks) {
+        it->packPrice = packPrice;
+    } else {
+        tiers_.insert(it, PriceTier{minPacks, packPrice});
+    }
+}
+
+void PackOffer::setStock(int stock) {
+    if (stock < 0) {
+        throw std::invalid_argument("Stock cannot be negative");
+    }
+    stock_ = stock;
+}
+
+// Operations
+double PackOffer::priceFor(int packs) const {
+    if (packs < 0 || packs > stock_) {
+        throw std::invalid_argument("Pack count outside the available stock");
+    }
+    double price = packPrice_;
+    for (const auto& tier : tiers_) {
+        if (tier.minPacks > packs) {
+            break;
+        }
+        price = tier.packPrice;
+    }
+    return packs * price;
+}
+
+} // namespace core
+} // namespace smart_food
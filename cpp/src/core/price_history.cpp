@@ -0,0 +1,425 @@
+#include "smart_food/core/price_history.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace smart_food {
+namespace core {
+
+namespace {
+
+std::int64_t toSeconds(PriceHistory::TimePoint time) {
+    return std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+}
+
+PriceHistory::TimePoint fromSeconds(std::int64_t seconds) {
+    return PriceHistory::TimePoint(std::chrono::seconds(seconds));
+}
+
+std::uint64_t bitsOf(double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    return bits;
+}
+
+double valueOf(std::uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof value);
+    return value;
+}
+
+int leadingZeros(std::uint64_t x) {
+    int n = 0;
+    for (std::uint64_t bit = std::uint64_t(1) << 63; bit != 0 && !(x & bit); bit >>= 1) {
+        ++n;
+    }
+    return n;
+}
+
+int trailingZeros(std::uint64_t x) {
+    int n = 0;
+    for (; n < 64 && !(x & (std::uint64_t(1) << n)); ++n) {
+    }
+    return n;
+}
+
+/**
+ * Appends codes of up to 64 bits, most significant bit first.
+ */
+class BitWriter {
+public:
+    BitWriter(std::vector<std::uint64_t>& words, std::uint64_t& bitCount) : words_(words), bitCount_(bitCount) {}
+
+    void write(std::uint64_t value, int width) {
+        if (width < 64) {
+            value &= (std::uint64_t(1) << width) - 1;
+        }
+        while (width > 0) {
+            const int used = static_cast<int>(bitCount_ % 64);
+            if (used == 0) {
+                words_.push_back(0);
+            }
+            const int take = std::min(width, 64 - used);
+            const std::uint64_t chunk = take == 64 ? value : (value >> (width - take)) & ((std::uint64_t(1) << take) - 1);
+            words_.back() |= take == 64 ? chunk : chunk << (64 - used - take);
+            width -= take;
+            bitCount_ += take;
+        }
+    }
+
+private:
+    std::vector<std::uint64_t>& words_;
+    std::uint64_t& bitCount_;
+};
+
+class BitReader {
+public:
+    explicit BitReader(const std::vector<std::uint64_t>& words) : words_(words) {}
+
+    std::uint64_t read(int width) {
+        std::uint64_t value = 0;
+        while (width > 0) {
+            const int used = static_cast<int>(position_ % 64);
+            const int take = std::min(width, 64 - used);
+            const std::uint64_t word = words_[position_ / 64];
+            const std::uint64_t chunk =
+                take == 64 ? word : (word >> (64 - used - take)) & ((std::uint64_t(1) << take) - 1);
+            value = take == 64 ? chunk : (value << take) | chunk;
+            width -= take;
+            position_ += take;
+        }
+        return value;
+    }
+
+    bool readBit() { return read(1) != 0; }
+
+private:
+    const std::vector<std::uint64_t>& words_;
+    std::uint64_t position_ = 0;
+};
+
+std::int64_t signExtend(std::uint64_t value, int width) {
+    const std::uint64_t sign = std::uint64_t(1) << (width - 1);
+    return static_cast<std::int64_t>((value ^ sign) - sign);
+}
+
+// Timestamp codes: the change in delta in the smallest two's complement bucket that holds it
+void writeTimestamp(BitWriter& out, std::int64_t deltaOfDelta) {
+    if (deltaOfDelta == 0) {
+        out.write(0, 1);
+    } else if (deltaOfDelta >= -64 && deltaOfDelta <= 63) {
+        out.write(0b10, 2);
+        out.write(static_cast<std::uint64_t>(deltaOfDelta), 7);
+    } else if (deltaOfDelta >= -256 && deltaOfDelta <= 255) {
+        out.write(0b110, 3);
+        out.write(static_cast<std::uint64_t>(deltaOfDelta), 9);
+    } else if (deltaOfDelta >= -2048 && deltaOfDelta <= 2047) {
+        out.write(0b1110, 4);
+        out.write(static_cast<std::uint64_t>(deltaOfDelta), 12);
+    } else {
+        out.write(0b1111, 4);
+        out.write(static_cast<std::uint64_t>(deltaOfDelta), 64);
+    }
+}
+
+std::int64_t readTimestamp(BitReader& in) {
+    if (!in.readBit()) {
+        return 0;
+    }
+    if (!in.readBit()) {
+        return signExtend(in.read(7), 7);
+    }
+    if (!in.readBit()) {
+        return signExtend(in.read(9), 9);
+    }
+    if (!in.readBit()) {
+        return signExtend(in.read(12), 12);
+    }
+    return static_cast<std::int64_t>(in.read(64));
+}
+
+/**
+ * Decodes the points of a block in order.
+ */
+template <typename Visit>
+void decodeBlock(const std::vector<std::uint64_t>& bits, std::int64_t firstTime, std::uint32_t count, Visit&& visit) {
+    BitReader in(bits);
+    std::int64_t time = firstTime;
+    std::int64_t delta = 0;
+    std::uint64_t value = in.read(64);
+    int leading = 0;
+    int trailing = 0;
+    visit(time, valueOf(value));
+    for (std::uint32_t i = 1; i < count; ++i) {
+        delta += readTimestamp(in);
+        time += delta;
+        if (in.readBit()) {
+            if (in.readBit()) {
+                leading = static_cast<int>(in.read(5));
+                const int length = static_cast<int>(in.read(6));
+                trailing = 64 - leading - (length == 0 ? 64 : length);
+            }
+            value ^= in.read(64 - leading - trailing) << trailing;
+        }
+        visit(time, valueOf(value));
+    }
+}
+
+} // namespace
+
+// Operations
+void PriceHistory::record(const std::string& item, const std::string& store, TimePoint time, double price) {
+    if (item.empty()) {
+        throw std::invalid_argument("Item name cannot be empty");
+    }
+    if (store.empty()) {
+        throw std::invalid_argument("Store name cannot be empty");
+    }
+    if (!(price >= 0.0) || price == std::numeric_limits<double>::infinity()) {
+        throw std::invalid_argument("Price must be finite and non-negative");
+    }
+    const std::int64_t seconds = toSeconds(time);
+
+    // Look up the series without creating it until the point is known to be valid
+    auto itemIt = items_.find(item);
+    auto storeIt = stores_.find(store);
+    Series* target = nullptr;
+    if (itemIt != items_.end() && storeIt != stores_.end()) {
+        for (std::uint32_t s : seriesOf_[itemIt->second]) {
+            if (series_[s].store == storeIt->second) {
+                target = &series_[s];
+                break;
+            }
+        }
+    }
+    if (target && seconds < target->lastTime) {
+        throw std::invalid_argument("Prices must be recorded in time order");
+    }
+    if (!target) {
+        if (itemIt == items_.end()) {
+            itemIt = items_.emplace(item, static_cast<std::uint32_t>(seriesOf_.size())).first;
+            seriesOf_.emplace_back();
+        }
+        if (storeIt == stores_.end()) {
+            storeIt = stores_.emplace(store, static_cast<std::uint32_t>(storeNames_.size())).first;
+            storeNames_.push_back(store);
+        }
+        seriesOf_[itemIt->second].push_back(static_cast<std::uint32_t>(series_.size()));
+        series_.emplace_back();
+        target = &series_.back();
+        target->store = storeIt->second;
+    }
+
+    Series& series = *target;
+    if (series.blocks.empty() || series.blocks.back().count == kBlockPoints) {
+        if (!series.blocks.empty()) {
+            series.blocks.back().bits.shrink_to_fit();
+        }
+        series.blocks.emplace_back();
+        Block& block = series.blocks.back();
+        block.firstTime = block.lastTime = seconds;
+        block.minPrice = block.maxPrice = price;
+        BitWriter(block.bits, block.bitCount).write(bitsOf(price), 64);
+        series.lastDelta = 0;
+        series.leading = 0xFF;
+    } else {
+        Block& block = series.blocks.back();
+        BitWriter out(block.bits, block.bitCount);
+        const std::int64_t delta = seconds - series.lastTime;
+        writeTimestamp(out, delta - series.lastDelta);
+        series.lastDelta = delta;
+
+        const std::uint64_t diff = bitsOf(price) ^ bitsOf(series.lastPrice);
+        if (diff == 0) {
+            out.write(0, 1);
+        } else {
+            const int leading = std::min(leadingZeros(diff), 31);
+            const int trailing = trailingZeros(diff);
+            if (series.leading != 0xFF && leading >= series.leading && trailing >= series.trailing) {
+                // Fits the previous window: only its bits are written
+                out.write(0b10, 2);
+                out.write(diff >> series.trailing, 64 - series.leading - series.trailing);
+            } else {
+                const int length = 64 - leading - trailing;
+                out.write(0b11, 2);
+                out.write(static_cast<std::uint64_t>(leading), 5);
+                out.write(static_cast<std::uint64_t>(length == 64 ? 0 : length), 6);
+                out.write(diff >> trailing, length);
+                series.leading = static_cast<std::uint8_t>(leading);
+                series.trailing = static_cast<std::uint8_t>(trailing);
+            }
+        }
+        block.lastTime = seconds;
+        block.minPrice = std::min(block.minPrice, price);
+        block.maxPrice = std::max(block.maxPrice, price);
+    }
+    Block& block = series.blocks.back();
+    block.sum += price;
+    ++block.count;
+    series.lastTime = seconds;
+    series.lastPrice = price;
+    ++points_;
+}
+
+bool PriceHistory::hasSeries(const std::string& item, const std::string& store) const {
+    return findSeries(item, store) != nullptr;
+}
+
+PriceHistory::Point PriceHistory::latestPrice(const std::string& item, const std::string& store) const {
+    const Series* series = findSeries(item, store);
+    if (!series) {
+        throw std::out_of_range("No price recorded for " + item + " at " + store);
+    }
+    return Point{fromSeconds(series->lastTime), series->lastPrice};
+}
+
+std::vector<PriceHistory::StorePrice> PriceHistory::latestPrices(const std::string& item) const {
+    std::vector<StorePrice> prices;
+    auto it = items_.find(item);
+    if (it == items_.end()) {
+        return prices;
+    }
+    for (std::uint32_t s : seriesOf_[it->second]) {
+        const Series& series = series_[s];
+        prices.push_back({storeNames_[series.store], fromSeconds(series.lastTime), series.lastPrice});
+    }
+    std::sort(prices.begin(), prices.end(), [](const StorePrice& a, const StorePrice& b) {
+        return a.price != b.price ? a.price < b.price : a.store < b.store;
+    });
+    return prices;
+}
+
+std::vector<PriceHistory::Point> PriceHistory::range(const std::string& item, const std::string& store,
+                                                     TimePoint from, TimePoint to) const {
+    std::vector<Point> points;
+    const Series* series = findSeries(item, store);
+    if (!series) {
+        return points;
+    }
+    const std::int64_t first = toSeconds(from);
+    const std::int64_t last = toSeconds(to);
+    // Blocks are in time order: skip to the first one that reaches the range
+    auto block = std::lower_bound(series->blocks.begin(), series->blocks.end(), first,
+                                  [](const Block& b, std::int64_t time) { return b.lastTime < time; });
+    for (; block != series->blocks.end() && block->firstTime <= last; ++block) {
+        decodeBlock(block->bits, block->firstTime, block->count, [&](std::int64_t time, double price) {
+            if (time >= first && time <= last) {
+                points.push_back({fromSeconds(time), price});
+            }
+        });
+    }
+    return points;
+}
+
+PriceHistory::Summary PriceHistory::summarize(const std::string& item, const std::string& store, TimePoint from,
+                                              TimePoint to) const {
+    const Series* series = findSeries(item, store);
+    if (!series) {
+        Summary summary;
+        summary.store = store;
+        return summary;
+    }
+    return summarize(*series, toSeconds(from), toSeconds(to));
+}
+
+std::vector<PriceHistory::Summary> PriceHistory::summarizeStores(const std::string& item, TimePoint from,
+                                                                 TimePoint to) const {
+    std::vector<Summary> summaries;
+    auto it = items_.find(item);
+    if (it == items_.end()) {
+        return summaries;
+    }
+    for (std::uint32_t s : seriesOf_[it->second]) {
+        Summary summary = summarize(series_[s], toSeconds(from), toSeconds(to));
+        if (summary.count > 0) {
+            summaries.push_back(std::move(summary));
+        }
+    }
+    std::sort(summaries.begin(), summaries.end(), [](const Summary& a, const Summary& b) {
+        return a.meanPrice != b.meanPrice ? a.meanPrice < b.meanPrice : a.store < b.store;
+    });
+    return summaries;
+}
+
+// Getters
+std::size_t PriceHistory::getSeriesCount() const {
+    return series_.size();
+}
+
+std::size_t PriceHistory::getPointCount() const {
+    return points_;
+}
+
+std::size_t PriceHistory::memoryUsage() const {
+    std::size_t bytes = series_.capacity() * sizeof(Series);
+    for (const auto& series : series_) {
+        bytes += series.blocks.capacity() * sizeof(Block);
+        for (const auto& block : series.blocks) {
+            bytes += block.bits.capacity() * sizeof(std::uint64_t);
+        }
+    }
+    for (const auto& list : seriesOf_) {
+        bytes += sizeof(list) + list.capacity() * sizeof(std::uint32_t);
+    }
+    return bytes;
+}
+
+// Helpers
+const PriceHistory::Series* PriceHistory::findSeries(const std::string& item, const std::string& store) const {
+    auto itemIt = items_.find(item);
+    auto storeIt = stores_.find(store);
+    if (itemIt == items_.end() || storeIt == stores_.end()) {
+        return nullptr;
+    }
+    for (std::uint32_t s : seriesOf_[itemIt->second]) {
+        if (series_[s].store == storeIt->second) {
+            return &series_[s];
+        }
+    }
+    return nullptr;
+}
+
+PriceHistory::Summary PriceHistory::summarize(const Series& series, std::int64_t from, std::int64_t to) const {
+    Summary summary;
+    summary.store = storeNames_[series.store];
+    double sum = 0.0;
+    auto add = [&](std::int64_t time, double price) {
+        if (summary.count == 0) {
+            summary.first = {fromSeconds(time), price};
+            summary.minPrice = summary.maxPrice = price;
+        }
+        summary.minPrice = std::min(summary.minPrice, price);
+        summary.maxPrice = std::max(summary.maxPrice, price);
+        summary.last = {fromSeconds(time), price};
+        sum += price;
+        ++summary.count;
+    };
+
+    auto block = std::lower_bound(series.blocks.begin(), series.blocks.end(), from,
+                                  [](const Block& b, std::int64_t time) { return b.lastTime < time; });
+    for (; block != series.blocks.end() && block->firstTime <= to; ++block) {
+        if (block->firstTime >= from && block->lastTime <= to && summary.count > 0 &&
+            std::next(block) != series.blocks.end() && std::next(block)->firstTime <= to) {
+            // Inside the range and neither end: the block statistics are enough
+            summary.minPrice = std::min(summary.minPrice, block->minPrice);
+            summary.maxPrice = std::max(summary.maxPrice, block->maxPrice);
+            sum += block->sum;
+            summary.count += block->count;
+            continue;
+        }
+        decodeBlock(block->bits, block->firstTime, block->count, [&](std::int64_t time, double price) {
+            if (time >= from && time <= to) {
+                add(time, price);
+            }
+        });
+    }
+    if (summary.count > 0) {
+        summary.meanPrice = sum / summary.count;
+    }
+    return summary;
+}
+
+} // namespace core
+} // namespace smart_food
@@ -1,13 +1,24 @@
 #include "smart_food/core/recipe.hpp" 
+#include <algorithm>
+#include <atomic>
 #include <stdexcept>
 #include <sstream>
 #include <random>
+#include <unordered_map>
+#include <unordered_set>
 #include <nlohmann/json.hpp>
 
 using nlohmann::json;
 namespace smart_food {
 namespace core {
 
+namespace {
+
+/// Shared by all recipes, so no two states of any recipes have the same revision
+std::atomic<std::uint64_t> latestRevision{0};
+
+} // namespace
+
 /**
  * Default constructor. Creates a new recipe with default values.
  */
@@ -17,6 +28,7 @@ Recipe::Recipe()
     , difficulty_(Difficulty::EASY)
     , servings_(1) {
     generateId();
+    touch();
 }
 
 /**
@@ -32,6 +44,7 @@ Recipe::Recipe(const std::string& name)
         throw std::invalid_argument("Recipe name cannot be empty");
     }
     generateId();
+    touch();
 }
 
 /**
@@ -48,6 +61,7 @@ Recipe::Recipe(const std::string& name, const std::string& description)
         throw std::invalid_argument("Recipe name cannot be empty");
     }
     generateId();
+    touch();
 }
 
 // Getters
@@ -90,9 +104,16 @@ int Recipe::getServings() const {
 
 // Remaining getter implementations
 std::chrono::minutes Recipe::getTotalTime() const {
+    // Dependencies always have a lower order, so one pass in order sees them finished
     std::chrono::minutes total{0};
-    for (const auto& step : steps_) {
-        total += step.duration;
+    std::vector<std::chrono::minutes> finish(steps_.size());
+    for (std::size_t i = 0; i < steps_.size(); ++i) {
+        std::chrono::minutes start{0};
+        for (auto dependency : getStepDependencies(i)) {
+            start = std::max(start, finish[dependency]);
+        }
+        finish[i] = start + steps_[i].duration;
+        total = std::max(total, finish[i]);
     }
     return total;
 }
@@ -101,10 +122,39 @@ const std::vector<std::shared_ptr<Ingredient>>& Recipe::getIngredients() const {
     return ingredients_;
 }
 
+std::uint64_t Recipe::getRevision() const {
+    return revision_;
+}
+
+std::uint64_t Recipe::getLatestRevision() {
+    return latestRevision.load(std::memory_order_relaxed);
+}
+
+const std::vector<Recipe::Component>& Recipe::getComponents() const {
+    return components_;
+}
+
 const std::vector<Recipe::Step>& Recipe::getSteps() const {
     return steps_;
 }
 
+std::vector<std::size_t> Recipe::getStepDependencies(std::size_t index) const {
+    const Step& step = steps_.at(index);
+    std::vector<std::size_t> dependencies;
+    if (!step.dependsOn) {
+        if (index > 0) {
+            dependencies.push_back(index - 1);
+        }
+        return dependencies;
+    }
+    for (int order : *step.dependsOn) {
+        dependencies.push_back(findStep(order));
+    }
+    std::sort(dependencies.begin(), dependencies.end());
+    dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+    return dependencies;
+}
+
 const std::map<std::string, double>& Recipe::getNutritionalInfo() const {
     return nutritionalInfo_;
 }
@@ -115,14 +165,17 @@ void Recipe::setName(const std::string& name) {
         throw std::invalid_argument("Recipe name cannot be empty");
     }
     name_ = name;
+    touch();
 }
 
 void Recipe::setDescription(const std::string& description) {
     description_ = description;
+    touch();
 }
 
 void Recipe::setDifficulty(Difficulty difficulty) {
     difficulty_ = difficulty;
+    touch();
 }
 
 void Recipe::setServings(int servings) {
@@ -130,6 +183,7 @@ void Recipe::setServings(int servings) {
         throw std::invalid_argument("Number of servings must be positive");
     }
     servings_ = servings;
+    touch();
 }
 
 // Operation implementations
@@ -139,6 +193,7 @@ void Recipe::addIngredient(const std::shared_ptr<Ingredient>& ingredient) {
     }
     ingredients_.push_back(ingredient);
     recalculateNutritionalInfo();
+    touch();
 }
 
 void Recipe::removeIngredient(const std::string& ingredientId) {
@@ -150,13 +205,84 @@ void Recipe::removeIngredient(const std::string& ingredientId) {
     if (it != ingredients_.end()) {
         ingredients_.erase(it);
         recalculateNutritionalInfo();
+        touch();
+    }
+}
+
+void Recipe::addComponent(const std::shared_ptr<Recipe>& recipe, double servings) {
+    if (!recipe) {
+        throw std::invalid_argument("Cannot add null component");
     }
+    if (!(servings > 0.0)) {
+        throw std::invalid_argument("Component servings must be positive");
+    }
+    if (recipe->uses(*this)) {
+        throw std::invalid_argument("Component " + recipe->getName() + " would make the recipe use itself");
+    }
+    auto it = std::find_if(components_.begin(), components_.end(),
+        [&recipe](const auto& component) {
+            return component.recipe == recipe;
+        });
+    if (it != components_.end()) {
+        it->servings += servings;
+    } else {
+        components_.push_back({recipe, servings});
+    }
+    recalculateNutritionalInfo();
+    touch();
+}
+
+void Recipe::removeComponent(const std::string& recipeId) {
+    auto it = std::find_if(components_.begin(), components_.end(),
+        [&recipeId](const auto& component) {
+            return component.recipe->getId() == recipeId;
+        });
+
+    if (it != components_.end()) {
+        components_.erase(it);
+        recalculateNutritionalInfo();
+        touch();
+    }
+}
+
+bool Recipe::uses(const Recipe& recipe) const {
+    // Depth-first over the components, visiting each shared one once
+    std::vector<const Recipe*> pending{this};
+    std::unordered_set<const Recipe*> visited{this};
+    while (!pending.empty()) {
+        const Recipe* current = pending.back();
+        pending.pop_back();
+        if (current == &recipe) {
+            return true;
+        }
+        for (const auto& component : current->components_) {
+            if (visited.insert(component.recipe.get()).second) {
+                pending.push_back(component.recipe.get());
+            }
+        }
+    }
+    return false;
 }
 
 void Recipe::addStep(const Step& step) {
     if (step.order <= 0) {
         throw std::invalid_argument("Step order must be positive");
     }
+    if (step.duration.count() < 0) {
+        throw std::invalid_argument("Step duration cannot be negative");
+    }
+    for (const auto& resource : step.resources) {
+        if (resource.second <= 0) {
+            throw std::invalid_argument("Step must hold a positive amount of " + resource.first);
+        }
+    }
+    if (step.dependsOn) {
+        for (int order : *step.dependsOn) {
+            if (order >= step.order || findStep(order) == steps_.size()) {
+                throw std::invalid_argument("Step can only depend on an existing earlier step");
+            }
+        }
+    }
     
     // Check for duplicate order
     auto it = std::find_if(steps_.begin(), steps_.end(),
@@ -170,6 +296,13 @@ void Recipe::addStep(const Step& step) {
             if (existing.order >= step.order) {
                 existing.order++;
             }
+            if (existing.dependsOn) {
+                for (int& order : *existing.dependsOn) {
+                    if (order >= step.order) {
+                        order++;
+                    }
+                }
+            }
         }
     }
     
@@ -180,6 +313,7 @@ void Recipe::addStep(const Step& step) {
         [](const auto& a, const auto& b) {
             return a.order < b.order;
         });
+    touch();
 }
 
 void Recipe::removeStep(int order) {
@@ -189,13 +323,38 @@ void Recipe::removeStep(int order) {
         });
     
     if (it != steps_.end()) {
+        // Steps waiting for the removed one wait for what it waited for
+        const std::size_t removed = static_cast<std::size_t>(it - steps_.begin());
+        std::vector<int> inherited;
+        for (auto dependency : getStepDependencies(removed)) {
+            inherited.push_back(steps_[dependency].order);
+        }
+        for (auto& step : steps_) {
+            if (step.dependsOn) {
+                auto& orders = *step.dependsOn;
+                if (std::find(orders.begin(), orders.end(), order) != orders.end()) {
+                    orders.erase(std::remove(orders.begin(), orders.end(), order), orders.end());
+                    orders.insert(orders.end(), inherited.begin(), inherited.end());
+                }
+            }
+        }
         steps_.erase(it);
         
         // Reorder remaining steps
+        std::map<int, int> renumbered;
         int newOrder = 1;
         for (auto& step : steps_) {
+            renumbered[step.order] = newOrder;
             step.order = newOrder++;
         }
+        for (auto& step : steps_) {
+            if (step.dependsOn) {
+                for (int& dependency : *step.dependsOn) {
+                    dependency = renumbered.at(dependency);
+                }
+            }
+        }
+        touch();
     }
 }
 
@@ -213,30 +372,52 @@ void Recipe::reorderStep(int oldOrder, int newOrder) {
         throw std::invalid_argument("Step with old order not found");
     }
     
+    // New order of every step, used for the steps themselves and for dependencies
+    auto moved = [oldOrder, newOrder](int order) {
+        if (order == oldOrder) {
+            return newOrder;
+        }
+        if (oldOrder < newOrder && order > oldOrder && order <= newOrder) {
+            return order - 1;
+        }
+        if (newOrder < oldOrder && order >= newOrder && order < oldOrder) {
+            return order + 1;
+        }
+        return order;
+    };
+    for (const auto& existing : steps_) {
+        if (existing.dependsOn) {
+            for (int order : *existing.dependsOn) {
+                if (moved(order) >= moved(existing.order)) {
+                    throw std::invalid_argument("Step cannot move before a step it depends on");
+                }
+            }
+        }
+    }
+
     Step step = *it;
     steps_.erase(it);
     step.order = newOrder;
     
     // Adjust orders of other steps
     for (auto& existing : steps_) {
-        if (oldOrder < newOrder) {
-            if (existing.order > oldOrder && existing.order <= newOrder) {
-                existing.order--;
-            }
-        } else {
-            if (existing.order >= newOrder && existing.order < oldOrder) {
-                existing.order++;
+        existing.order = moved(existing.order);
+    }
+    steps_.push_back(step);
+    for (auto& existing : steps_) {
+        if (existing.dependsOn) {
+            for (int& order : *existing.dependsOn) {
+                order = moved(order);
             }
         }
     }
     
-    steps_.push_back(step);
-    
     // Sort steps by order
     std::sort(steps_.begin(), steps_.end(),
         [](const auto& a, const auto& b) {
             return a.order < b.order;
         });
+    touch();
 }
 
 double Recipe::calculateTotalCost() const {
@@ -244,17 +425,57 @@ double Recipe::calculateTotalCost() const {
     for (const auto& ingredient : ingredients_) {
         totalCost += ingredient->calculateCost();
     }
+    for (const auto& component : components_) {
+        totalCost += component.recipe->calculateTotalCost() * component.servings / component.recipe->getServings();
+    }
     return totalCost;
 }
 
+std::vector<std::shared_ptr<Ingredient>> Recipe::expandIngredients() const {
+    // Order the recipes so that each comes after every recipe using it
+    std::vector<const Recipe*> order;
+    std::unordered_set<const Recipe*> visited{this};
+    auto visit = [&](auto&& self, const Recipe* recipe) -> void {
+        for (const auto& component : recipe->components_) {
+            if (visited.insert(component.recipe.get()).second) {
+                self(self, component.recipe.get());
+            }
+        }
+        order.push_back(recipe);
+    };
+    visit(visit, this);
+    std::reverse(order.begin(), order.end());
+
+    // A recipe's share is complete once its users are done, however many paths lead to it
+    std::unordered_map<const Recipe*, double> share{{this, 1.0}};
+    std::vector<std::shared_ptr<Ingredient>> ingredients;
+    for (const Recipe* recipe : order) {
+        const double factor = share[recipe];
+        for (const auto& ingredient : recipe->ingredients_) {
+            if (recipe == this) {
+                ingredients.push_back(ingredient);
+            } else {
+                auto scaled = std::make_shared<Ingredient>(*ingredient);
+                scaled->scale(factor);
+                ingredients.push_back(scaled);
+            }
+        }
+        for (const auto& component : recipe->components_) {
+            share[component.recipe.get()] += factor * component.servings / component.recipe->getServings();
+        }
+    }
+    return ingredients;
+}
+
 void Recipe::updateNutritionalInfo() {
     recalculateNutritionalInfo();
+    touch();
 }
 
 bool Recipe::isValid() const {
     return !name_.empty() && 
            servings_ > 0 && 
-           !ingredients_.empty() && 
+           (!ingredients_.empty() || !components_.empty()) && 
            !steps_.empty();
 }
 
@@ -270,6 +491,16 @@ std::string Recipe::serialize() const {
     for (const auto& ingredient : ingredients_) {
         j["ingredients"].push_back(ingredient->serialize());
     }
+
+    if (!components_.empty()) {
+        j["components"] = json::array();
+        for (const auto& component : components_) {
+            json componentJson;
+            componentJson["recipe"] = component.recipe->serialize();
+            componentJson["servings"] = component.servings;
+            j["components"].push_back(componentJson);
+        }
+    }
     
     j["steps"] = json::array();
     for (const auto& step : steps_) {
@@ -277,6 +508,12 @@ std::string Recipe::serialize() const {
         stepJson["order"] = step.order;
         stepJson["description"] = step.description;
         stepJson["duration"] = step.duration.count();
+        if (step.dependsOn) {
+            stepJson["dependsOn"] = *step.dependsOn;
+        }
+        if (!step.resources.empty()) {
+            stepJson["resources"] = step.resources;
+        }
         j["steps"].push_back(stepJson);
     }
     
@@ -286,6 +523,11 @@ std::string Recipe::serialize() const {
 }
 
 Recipe Recipe::deserialize(const std::string& data) {
+    std::map<std::string, std::shared_ptr<Recipe>> restored;
+    return deserialize(data, restored);
+}
+
+Recipe Recipe::deserialize(const std::string& data, std::map<std::string, std::shared_ptr<Recipe>>& restored) {
     json j = json::parse(data);
     
     Recipe recipe(j["name"].get<std::string>(), j["description"].get<std::string>());
@@ -294,8 +536,21 @@ Recipe Recipe::deserialize(const std::string& data) {
     recipe.setServings(j["servings"].get<int>());
     
     for (const auto& ingredientJson : j["ingredients"]) {
-        recipe.addIngredient(std::make_shared<Ingredient>(
-            Ingredient::deserialize(ingredientJson.dump())));
+        // serialize() stores ingredients as JSON strings
+        recipe.addIngredient(std::make_shared<Ingredient>(Ingredient::deserialize(
+            ingredientJson.is_string() ? ingredientJson.get<std::string>() : ingredientJson.dump())));
+    }
+
+    if (j.contains("components")) {
+        for (const auto& componentJson : j["components"]) {
+            const std::string componentData = componentJson["recipe"].get<std::string>();
+            const std::string componentId = json::parse(componentData)["id"].get<std::string>();
+            auto& component = restored[componentId];
+            if (!component) {
+                component = std::make_shared<Recipe>(deserialize(componentData, restored));
+            }
+            recipe.components_.push_back({component, componentJson["servings"].get<double>()});
+        }
     }
     
     for (const auto& stepJson : j["steps"]) {
@@ -303,6 +558,12 @@ Recipe Recipe::deserialize(const std::string& data) {
         step.order = stepJson["order"].get<int>();
         step.description = stepJson["description"].get<std::string>();
         step.duration = std::chrono::minutes(stepJson["duration"].get<int>());
+        if (stepJson.contains("dependsOn")) {
+            step.dependsOn = stepJson["dependsOn"].get<std::vector<int>>();
+        }
+        if (stepJson.contains("resources")) {
+            step.resources = stepJson["resources"].get<std::map<std::string, int>>();
+        }
         recipe.addStep(step);
     }
     
@@ -311,6 +572,18 @@ Recipe Recipe::deserialize(const std::string& data) {
     return recipe;
 }
 
+std::size_t Recipe::findStep(int order) const {
+    auto it = std::find_if(steps_.begin(), steps_.end(),
+        [order](const auto& step) {
+            return step.order == order;
+        });
+    return static_cast<std::size_t>(it - steps_.begin());
+}
+
+void Recipe::touch() {
+    revision_ = latestRevision.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
 void Recipe::generateId() {
     static std::random_device rd;
     static std::mt19937 gen(rd());
@@ -333,6 +606,12 @@ void Recipe::recalculateNutritionalInfo() {
             nutritionalInfo_[nutrient] += value;
         }
     }
+    for (const auto& component : components_) {
+        const double share = component.servings / component.recipe->getServings();
+        for (const auto& [nutrient, value] : component.recipe->getNutritionalInfo()) {
+            nutritionalInfo_[nutrient] += value * share;
+        }
+    }
 }
 } // namespace core
 } // namespace smart_food
\ No newline at end of file
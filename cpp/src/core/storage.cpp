@@ -0,0 +1,427 @@
+#include "smart_food/core/storage.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+using nlohmann::json;
+
+namespace smart_food {
+namespace core {
+
+namespace {
+
+// Stock expiring within this window counts as expiring soon
+constexpr std::chrono::hours kExpiringWindow(24 * 3);
+
+template <typename T>
+std::vector<std::shared_ptr<T>> valuesOf(const std::map<std::string, std::shared_ptr<T>>& items) {
+    std::vector<std::shared_ptr<T>> values;
+    values.reserve(items.size());
+    for (const auto& entry : items) {
+        values.push_back(entry.second);
+    }
+    return values;
+}
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+} // namespace
+
+Storage& Storage::getInstance() {
+    static Storage instance;
+    return instance;
+}
+
+// Meal management; meals are keyed by name
+std::shared_ptr<Meal> Storage::getMeal(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = meals_.find(id);
+    return it == meals_.end() ? nullptr : it->second;
+}
+
+std::vector<std::shared_ptr<Meal>> Storage::getMeals() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return valuesOf(meals_);
+}
+
+std::vector<std::shared_ptr<Meal>> Storage::getMealsByDate(const std::chrono::system_clock::time_point& date) const {
+    const auto day = std::chrono::duration_cast<std::chrono::hours>(date.time_since_epoch()).count() / 24;
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::shared_ptr<Meal>> meals;
+    for (const auto& entry : meals_) {
+        const auto planned = entry.second->getPlannedTime().time_since_epoch();
+        if (std::chrono::duration_cast<std::chrono::hours>(planned).count() / 24 == day) {
+            meals.push_back(entry.second);
+        }
+    }
+    return meals;
+}
+
+void Storage::addMeal(const std::shared_ptr<Meal>& meal) {
+    validateMeal(meal);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!meals_.emplace(meal->getName(), meal).second) {
+            throw std::invalid_argument("Meal already exists: " + meal->getName());
+        }
+        bumpVersion();
+    }
+    notify(Mutation{Mutation::Kind::ADD, meal, nullptr});
+}
+
+void Storage::updateMeal(const std::shared_ptr<Meal>& meal) {
+    validateMeal(meal);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = meals_.find(meal->getName());
+        if (it == meals_.end()) {
+            throw std::invalid_argument("Meal not found: " + meal->getName());
+        }
+        it->second = meal;
+        bumpVersion();
+    }
+    notify(Mutation{Mutation::Kind::UPDATE, meal, nullptr});
+}
+
+void Storage::removeMeal(const std::string& id) {
+    std::shared_ptr<Meal> removed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = meals_.find(id);
+        if (it == meals_.end()) {
+            throw std::invalid_argument("Meal not found: " + id);
+        }
+        removed = std::move(it->second);
+        meals_.erase(it);
+        bumpVersion();
+    }
+    notify(Mutation{Mutation::Kind::REMOVE, removed, nullptr});
+}
+
+// Recipe management
+std::shared_ptr<Recipe> Storage::getRecipe(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = recipes_.find(id);
+    return it == recipes_.end() ? nullptr : it->second;
+}
+
+std::vector<std::shared_ptr<Recipe>> Storage::getRecipes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return valuesOf(recipes_);
+}
+
+std::vector<std::shared_ptr<Recipe>> Storage::searchRecipes(const std::string& query) const {
+    const std::string needle = toLower(query);
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::shared_ptr<Recipe>> matches;
+    for (const auto& entry : recipes_) {
+        const auto& recipe = entry.second;
+        if (toLower(recipe->getName()).find(needle) != std::string::npos ||
+            toLower(recipe->getDescription()).find(needle) != std::string::npos) {
+            matches.push_back(recipe);
+        }
+    }
+    return matches;
+}
+
+void Storage::addRecipe(const std::shared_ptr<Recipe>& recipe) {
+    validateRecipe(recipe);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!recipes_.emplace(recipe->getId(), recipe).second) {
+        throw std::invalid_argument("Recipe already exists: " + recipe->getId());
+    }
+    bumpVersion();
+}
+
+void Storage::updateRecipe(const std::shared_ptr<Recipe>& recipe) {
+    validateRecipe(recipe);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = recipes_.find(recipe->getId());
+    if (it == recipes_.end()) {
+        throw std::invalid_argument("Recipe not found: " + recipe->getId());
+    }
+    it->second = recipe;
+    bumpVersion();
+}
+
+void Storage::removeRecipe(const std::string& id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (recipes_.erase(id) == 0) {
+        throw std::invalid_argument("Recipe not found: " + id);
+    }
+    bumpVersion();
+}
+
+// Ingredient management
+std::shared_ptr<Ingredient> Storage::getIngredient(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = ingredients_.find(id);
+    return it == ingredients_.end() ? nullptr : it->second;
+}
+
+std::vector<std::shared_ptr<Ingredient>> Storage::getIngredients() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return valuesOf(ingredients_);
+}
+
+std::vector<std::shared_ptr<Ingredient>> Storage::getLowStockIngredients() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::shared_ptr<Ingredient>> low;
+    for (const auto& entry : ingredients_) {
+        if (entry.second->isLowQuantity()) {
+            low.push_back(entry.second);
+        }
+    }
+    return low;
+}
+
+std::vector<std::shared_ptr<Ingredient>> Storage::getExpiringIngredients() const {
+    const auto now = std::chrono::system_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::shared_ptr<Ingredient>> expiring;
+    for (const auto& entry : ingredients_) {
+        const auto& expiry = entry.second->getExpiryDate();
+        if (expiry >= now && expiry <= now + kExpiringWindow) {
+            expiring.push_back(entry.second);
+        }
+    }
+    return expiring;
+}
+
+void Storage::addIngredient(const std::shared_ptr<Ingredient>& ingredient) {
+    validateIngredient(ingredient);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ingredients_.emplace(ingredient->getId(), ingredient).second) {
+            throw std::invalid_argument("Ingredient already exists: " + ingredient->getId());
+        }
+        bumpVersion();
+    }
+    notify(Mutation{Mutation::Kind::ADD, nullptr, ingredient});
+}
+
+void Storage::updateIngredient(const std::shared_ptr<Ingredient>& ingredient) {
+    validateIngredient(ingredient);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = ingredients_.find(ingredient->getId());
+        if (it == ingredients_.end()) {
+            throw std::invalid_argument("Ingredient not found: " + ingredient->getId());
+        }
+        it->second = ingredient;
+        bumpVersion();
+    }
+    notify(Mutation{Mutation::Kind::UPDATE, nullptr, ingredient});
+}
+
+void Storage::removeIngredient(const std::string& id) {
+    std::shared_ptr<Ingredient> removed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = ingredients_.find(id);
+        if (it == ingredients_.end()) {
+            throw std::invalid_argument("Ingredient not found: " + id);
+        }
+        removed = std::move(it->second);
+        ingredients_.erase(it);
+        bumpVersion();
+    }
+    notify(Mutation{Mutation::Kind::REMOVE, nullptr, removed});
+}
+
+// Persistence operations
+void Storage::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::invalid_argument("Cannot open storage file: " + filename);
+    }
+    std::stringstream data;
+    data << file.rdbuf();
+
+    // Parse everything before touching the current contents, so a bad file leaves them intact
+    std::map<std::string, std::shared_ptr<Meal>> meals;
+    std::map<std::string, std::shared_ptr<Recipe>> recipes;
+    std::map<std::string, std::shared_ptr<Ingredient>> ingredients;
+    try {
+        const json j = json::parse(data.str());
+        for (const auto& item : j.at("recipes")) {
+            auto recipe = std::make_shared<Recipe>(Recipe::deserialize(item.dump()));
+            recipes[recipe->getId()] = recipe;
+        }
+        for (const auto& item : j.at("ingredients")) {
+            auto ingredient = std::make_shared<Ingredient>(Ingredient::deserialize(item.dump()));
+            ingredients[ingredient->getId()] = ingredient;
+        }
+        for (const auto& item : j.at("meals")) {
+            auto meal = std::make_shared<Meal>(Meal::deserialize(item.dump()));
+            meals[meal->getName()] = meal;
+        }
+    } catch (const json::exception& e) {
+        throw std::invalid_argument("Invalid storage file " + filename + ": " + e.what());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    meals_ = std::move(meals);
+    recipes_ = std::move(recipes);
+    ingredients_ = std::move(ingredients);
+    bumpVersion();
+}
+
+void Storage::saveToFile(const std::string& filename) const {
+    json j;
+    j["meals"] = json::array();
+    j["recipes"] = json::array();
+    j["ingredients"] = json::array();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : meals_) {
+            j["meals"].push_back(json::parse(entry.second->serialize()));
+        }
+        for (const auto& entry : recipes_) {
+            j["recipes"].push_back(json::parse(entry.second->serialize()));
+        }
+        for (const auto& entry : ingredients_) {
+            j["ingredients"].push_back(json::parse(entry.second->serialize()));
+        }
+    }
+    std::ofstream file(filename);
+    if (!file) {
+        throw std::invalid_argument("Cannot write storage file: " + filename);
+    }
+    file << j.dump(2);
+}
+
+void Storage::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    meals_.clear();
+    recipes_.clear();
+    ingredients_.clear();
+    bumpVersion();
+}
+
+// Statistics and analytics
+double Storage::calculateTotalInventoryValue() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double total = 0.0;
+    for (const auto& entry : ingredients_) {
+        total += entry.second->calculateCost();
+    }
+    return total;
+}
+
+std::map<std::string, double> Storage::getInventoryStatistics() const {
+    const auto now = std::chrono::system_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, double> stats = {{"total_items", 0.0}, {"total_value", 0.0}, {"low_stock_items", 0.0},
+                                           {"expiring_items", 0.0}, {"expired_items", 0.0}};
+    for (const auto& entry : ingredients_) {
+        const auto& ingredient = *entry.second;
+        stats["total_items"] += 1.0;
+        stats["total_value"] += ingredient.calculateCost();
+        if (ingredient.isLowQuantity()) {
+            stats["low_stock_items"] += 1.0;
+        }
+        if (ingredient.getExpiryDate() < now) {
+            stats["expired_items"] += 1.0;
+        } else if (ingredient.getExpiryDate() <= now + kExpiringWindow) {
+            stats["expiring_items"] += 1.0;
+        }
+    }
+    stats["recipes"] = static_cast<double>(recipes_.size());
+    stats["meals"] = static_cast<double>(meals_.size());
+    return stats;
+}
+
+std::map<std::string, double> Storage::getWasteStatistics() const {
+    const auto now = std::chrono::system_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    double expiredValue = 0.0;
+    double totalValue = 0.0;
+    double expiredItems = 0.0;
+    for (const auto& entry : ingredients_) {
+        const double cost = entry.second->calculateCost();
+        totalValue += cost;
+        if (entry.second->getExpiryDate() < now) {
+            expiredValue += cost;
+            expiredItems += 1.0;
+        }
+    }
+    return {{"expired_items", expiredItems},
+            {"expired_value", expiredValue},
+            {"waste_ratio", totalValue > 0.0 ? expiredValue / totalValue : 0.0}};
+}
+
+// Helper functions
+void Storage::validateMeal(const std::shared_ptr<Meal>& meal) const {
+    if (!meal) {
+        throw std::invalid_argument("Meal cannot be null");
+    }
+    if (meal->getName().empty()) {
+        throw std::invalid_argument("Meal name cannot be empty");
+    }
+}
+
+void Storage::validateRecipe(const std::shared_ptr<Recipe>& recipe) const {
+    if (!recipe) {
+        throw std::invalid_argument("Recipe cannot be null");
+    }
+    if (recipe->getId().empty()) {
+        throw std::invalid_argument("Recipe id cannot be empty");
+    }
+}
+
+void Storage::validateIngredient(const std::shared_ptr<Ingredient>& ingredient) const {
+    if (!ingredient) {
+        throw std::invalid_argument("Ingredient cannot be null");
+    }
+    if (ingredient->getId().empty()) {
+        throw std::invalid_argument("Ingredient id cannot be empty");
+    }
+}
+
+std::uint64_t Storage::getVersion() const {
+    return version_.load(std::memory_order_acquire);
+}
+
+void Storage::bumpVersion() {
+    version_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+std::uint64_t Storage::addListener(Listener listener) {
+    if (!listener) {
+        throw std::invalid_argument("Listener cannot be empty");
+    }
+    std::lock_guard<std::mutex> lock(listenersMutex_);
+    const std::uint64_t id = nextListener_++;
+    listeners_.emplace(id, std::move(listener));
+    return id;
+}
+
+void Storage::removeListener(std::uint64_t id) {
+    std::lock_guard<std::mutex> lock(listenersMutex_);
+    listeners_.erase(id);
+}
+
+void Storage::notify(const Mutation& mutation) const {
+    // Listeners run on a snapshot, so they may add or remove listeners themselves
+    std::vector<Listener> listeners;
+    {
+        std::lock_guard<std::mutex> lock(listenersMutex_);
+        for (const auto& entry : listeners_) {
+            listeners.push_back(entry.second);
+        }
+    }
+    for (const auto& listener : listeners) {
+        listener(mutation);
+    }
+}
+
+} // namespace core
+} // namespace smart_food
@@ -0,0 +1,800 @@
+#include "smart_food/ml/pattern_analyzer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include "smart_food/algorithms/ingredient_index.hpp"
+#include "smart_food/core/storage.hpp"
+#include "smart_food/utils/fingerprint.hpp"
+#include "smart_food/utils/thread_pool.hpp"
+#include <nlohmann/json.hpp>
+
+using nlohmann::json;
+
+namespace smart_food {
+namespace ml {
+
+namespace {
+
+constexpr std::uint32_t kNone = 0xFFFFFFFFu;
+constexpr std::size_t kMaxRuleItems = 16;
+constexpr std::uint32_t kFileKind = utils::ModelFile::tag("PATT");
+constexpr std::uint32_t kFileVersion = 1;
+
+/// A frequent itemset as item ranks, with its count
+struct Found {
+    std::vector<std::uint32_t> ranks;  ///< Increasing
+    std::uint32_t count;
+};
+
+/// Prefix tree node; items are ranks, by decreasing global frequency
+struct Node {
+    std::uint32_t item;
+    std::uint32_t count;
+    std::uint32_t parent;
+    std::uint32_t link;  ///< Next node of the same item, or kNone
+};
+
+/**
+ * @brief Prefix tree over item ranks in one arena; nodes[0] is the root
+ */
+struct Tree {
+    std::vector<Node> nodes;
+    std::vector<std::uint32_t> items;   ///< Ranks in the tree, increasing
+    std::vector<std::uint32_t> heads;   ///< Per entry of items: first node of the item
+    std::vector<std::uint32_t> counts;  ///< Per entry of items: total count of its nodes
+
+    /// Nodes are created along paths, so a single path is a chain in arena order
+    bool singlePath() const {
+        for (std::size_t n = 1; n < nodes.size(); ++n) {
+            if (nodes[n].parent != n - 1) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Weighted paths of increasing ranks, stored flat
+ */
+struct Paths {
+    std::vector<std::uint32_t> items;
+    std::vector<std::size_t> starts{0};
+    std::vector<std::uint32_t> weights;
+
+    void clear() {
+        items.clear();
+        starts.assign(1, 0);
+        weights.clear();
+    }
+};
+
+/**
+ * @brief Build a tree from paths over the ranks in `items`
+ *
+ * Paths are merged in lexicographic order: the part a path shares with the
+ * tree is then exactly its common prefix with the path before it, so nodes
+ * are found without searching children.
+ *
+ * @param local Rank -> position in items, for every rank on the paths
+ * @param pool Pool to sort with, or null to sort on this thread
+ */
+void buildTree(const Paths& paths, const std::vector<std::uint32_t>& items, const std::vector<std::uint32_t>& local,
+               Tree& tree, utils::ThreadPool* pool = nullptr) {
+    auto begin = [&](std::uint32_t p) { return paths.items.begin() + static_cast<std::ptrdiff_t>(paths.starts[p]); };
+    auto end = [&](std::uint32_t p) { return paths.items.begin() + static_cast<std::ptrdiff_t>(paths.starts[p + 1]); };
+
+    // Sort on the leading ranks packed into a 128-bit key, each as rank + 1 so that shorter paths come
+    // first, then on the rest; nearly all paths fit in the key, sparing random reads of the paths
+    const std::uint32_t maxRank = items.empty() ? 0u : items.back();
+    unsigned bits = 1;
+    while (bits < 32 && (maxRank + 1u) >> bits != 0) {
+        ++bits;
+    }
+    const std::size_t depth = 64 / bits;
+    struct Keyed {
+        std::uint64_t high;
+        std::uint64_t low;
+        std::uint32_t path;
+    };
+
+    // Paths are first bucketed by their first rank, and the buckets sorted separately
+    const std::size_t count = paths.weights.size();
+    std::vector<std::size_t> buckets(static_cast<std::size_t>(maxRank) + 2, 0);
+    for (std::uint32_t p = 0; p < count; ++p) {
+        ++buckets[*begin(p) + 1];
+    }
+    std::partial_sum(buckets.begin(), buckets.end(), buckets.begin());
+    std::vector<Keyed> order(count);
+    std::vector<std::size_t> next(buckets.begin(), buckets.end() - 1);
+    for (std::uint32_t p = 0; p < count; ++p) {
+        std::uint64_t key[2] = {0, 0};
+        auto it = begin(p);
+        for (auto& word : key) {
+            for (std::size_t i = 0; i < depth; ++i) {
+                word = (word << bits) | (it != end(p) ? *it++ + 1u : 0u);
+            }
+        }
+        order[next[*begin(p)]++] = Keyed{key[0], key[1], p};
+    }
+    auto rest = [&](std::uint32_t p) {
+        return begin(p) + static_cast<std::ptrdiff_t>(std::min(2 * depth, paths.starts[p + 1] - paths.starts[p]));
+    };
+    auto sortBucket = [&](std::size_t bucket) {
+        std::sort(order.begin() + static_cast<std::ptrdiff_t>(buckets[bucket]),
+                  order.begin() + static_cast<std::ptrdiff_t>(buckets[bucket + 1]), [&](const Keyed& a, const Keyed& b) {
+                      if (a.high != b.high || a.low != b.low) {
+                          return std::tie(a.high, a.low) < std::tie(b.high, b.low);
+                      }
+                      return std::lexicographical_compare(rest(a.path), end(a.path), rest(b.path), end(b.path));
+                  });
+    };
+    if (pool != nullptr) {
+        pool->parallelFor(buckets.size() - 1, sortBucket);
+    } else {
+        for (std::size_t bucket = 0; bucket + 1 < buckets.size(); ++bucket) {
+            sortBucket(bucket);
+        }
+    }
+
+    tree.nodes.assign(1, Node{kNone, 0, kNone, kNone});
+    tree.items = items;
+    tree.heads.assign(items.size(), kNone);
+    tree.counts.assign(items.size(), 0);
+    std::vector<std::uint32_t> stack;  // Nodes of the previous path
+    std::uint32_t previous = kNone;
+    for (const auto& entry : order) {
+        const std::uint32_t p = entry.path;
+        std::size_t shared = 0;
+        if (previous != kNone) {
+            auto mismatch = std::mismatch(begin(p), end(p), begin(previous), end(previous));
+            shared = static_cast<std::size_t>(mismatch.first - begin(p));
+        }
+        stack.resize(shared);
+        for (auto it = begin(p) + static_cast<std::ptrdiff_t>(shared); it != end(p); ++it) {
+            const std::uint32_t position = local[*it];
+            const auto node = static_cast<std::uint32_t>(tree.nodes.size());
+            tree.nodes.push_back(Node{*it, 0, stack.empty() ? 0u : stack.back(), tree.heads[position]});
+            tree.heads[position] = node;
+            stack.push_back(node);
+        }
+        tree.nodes[stack.back()].count += paths.weights[p];
+        previous = p;
+    }
+
+    // Each path counted at its last node so far; children follow their parents in the arena
+    for (auto n = tree.nodes.size(); n-- > 1;) {
+        const Node& node = tree.nodes[n];
+        if (node.parent != 0) {
+            tree.nodes[node.parent].count += node.count;
+        }
+        tree.counts[local[node.item]] += node.count;
+    }
+}
+
+/**
+ * @brief Recursive FP-growth with scratch space for one thread
+ */
+class Miner {
+public:
+    Miner(std::uint32_t minCount, std::size_t maxItems, std::size_t ranks, std::vector<Found>& found)
+        : minCount_(minCount), maxItems_(maxItems), counts_(ranks, 0), local_(ranks, kNone), found_(found) {}
+
+    /// Emit every itemset ending with the item at `index` of the tree, extended by prefix
+    void mineItem(const Tree& tree, std::size_t index, std::vector<std::uint32_t>& prefix) {
+        prefix.push_back(tree.items[index]);
+        emit(prefix, tree.counts[index]);
+        if (maxItems_ == 0 || prefix.size() < maxItems_) {
+            Tree conditional;
+            if (buildConditional(tree, index, conditional)) {
+                mineTree(conditional, prefix);
+            }
+        }
+        prefix.pop_back();
+    }
+
+private:
+    std::uint32_t minCount_;
+    std::size_t maxItems_;
+    std::vector<std::uint32_t> counts_;  ///< Rank -> count in the pattern base being read
+    std::vector<std::uint32_t> local_;   ///< Rank -> position in the conditional tree being built
+    std::vector<std::uint32_t> touched_;
+    Paths paths_;
+    std::vector<std::uint32_t> path_;
+    std::vector<Found>& found_;
+
+    void emit(const std::vector<std::uint32_t>& prefix, std::uint32_t count) {
+        Found itemset{prefix, count};
+        std::sort(itemset.ranks.begin(), itemset.ranks.end());
+        found_.push_back(std::move(itemset));
+    }
+
+    void mineTree(const Tree& tree, std::vector<std::uint32_t>& prefix) {
+        if (tree.singlePath()) {
+            mineChain(tree, 1, prefix);
+            return;
+        }
+        for (std::size_t index = tree.items.size(); index-- > 0;) {
+            mineItem(tree, index, prefix);
+        }
+    }
+
+    /// Every subset of a chain, counted at its deepest node
+    void mineChain(const Tree& tree, std::size_t from, std::vector<std::uint32_t>& prefix) {
+        for (std::size_t n = from; n < tree.nodes.size(); ++n) {
+            prefix.push_back(tree.nodes[n].item);
+            emit(prefix, tree.nodes[n].count);
+            if (maxItems_ == 0 || prefix.size() < maxItems_) {
+                mineChain(tree, n + 1, prefix);
+            }
+            prefix.pop_back();
+        }
+    }
+
+    /// Tree of the prefix paths of an item, without the items they rarely hold
+    bool buildConditional(const Tree& tree, std::size_t index, Tree& conditional) {
+        for (auto n = tree.heads[index]; n != kNone; n = tree.nodes[n].link) {
+            for (auto a = tree.nodes[n].parent; a != 0; a = tree.nodes[a].parent) {
+                const std::uint32_t item = tree.nodes[a].item;
+                if (counts_[item] == 0) {
+                    touched_.push_back(item);
+                }
+                counts_[item] += tree.nodes[n].count;
+            }
+        }
+        std::vector<std::uint32_t> items;
+        for (auto item : touched_) {
+            if (counts_[item] >= minCount_) {
+                items.push_back(item);
+            }
+        }
+        std::sort(items.begin(), items.end());
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            local_[items[i]] = static_cast<std::uint32_t>(i);
+        }
+
+        if (!items.empty()) {
+            paths_.clear();
+            for (auto n = tree.heads[index]; n != kNone; n = tree.nodes[n].link) {
+                path_.clear();
+                for (auto a = tree.nodes[n].parent; a != 0; a = tree.nodes[a].parent) {
+                    if (local_[tree.nodes[a].item] != kNone) {
+                        path_.push_back(tree.nodes[a].item);
+                    }
+                }
+                if (!path_.empty()) {
+                    paths_.items.insert(paths_.items.end(), path_.rbegin(), path_.rend());
+                    paths_.starts.push_back(paths_.items.size());
+                    paths_.weights.push_back(tree.nodes[n].count);
+                }
+            }
+            buildTree(paths_, items, local_, conditional);
+        }
+
+        for (auto item : touched_) {
+            counts_[item] = 0;
+            local_[item] = kNone;
+        }
+        touched_.clear();
+        return !items.empty();
+    }
+};
+
+/**
+ * @brief Mine every itemset reaching the support threshold
+ * @param rankedItems Receives rank -> item ID, by decreasing count
+ * @param rankCounts Receives rank -> number of transactions holding the item
+ */
+std::vector<Found> mineItemsets(utils::ModelFile::Array<std::uint32_t> transactionItems,
+                                utils::ModelFile::Array<std::uint64_t> transactionStarts, std::size_t itemCount,
+                                const PatternAnalyzer::Options& options, std::vector<std::uint32_t>& rankedItems,
+                                std::vector<std::uint32_t>& rankCounts) {
+    if (!(options.minSupport > 0.0 && options.minSupport <= 1.0)) {
+        throw std::invalid_argument("Minimum support must be in (0, 1]");
+    }
+    const std::size_t transactions = transactionStarts.size - 1;
+    const auto minCount = static_cast<std::uint32_t>(
+        std::max(1.0, std::ceil(options.minSupport * static_cast<double>(transactions) - 1e-9)));
+
+    std::vector<std::uint32_t> itemCounts(itemCount, 0);
+    for (auto item : transactionItems) {
+        ++itemCounts[item];
+    }
+    rankedItems.clear();
+    for (std::uint32_t item = 0; item < itemCount; ++item) {
+        if (itemCounts[item] >= minCount) {
+            rankedItems.push_back(item);
+        }
+    }
+    std::sort(rankedItems.begin(), rankedItems.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return itemCounts[a] != itemCounts[b] ? itemCounts[a] > itemCounts[b] : a < b;
+    });
+    const std::size_t ranks = rankedItems.size();
+    std::vector<std::uint32_t> rankOf(itemCount, kNone);
+    rankCounts.assign(ranks, 0);
+    for (std::size_t r = 0; r < ranks; ++r) {
+        rankOf[rankedItems[r]] = static_cast<std::uint32_t>(r);
+        rankCounts[r] = itemCounts[rankedItems[r]];
+    }
+
+    // Transactions as increasing ranks of their frequent items
+    Paths paths;
+    paths.items.reserve(transactionItems.size);
+    paths.starts.reserve(transactions + 1);
+    paths.weights.reserve(transactions);
+    std::vector<std::uint32_t> path;
+    for (std::size_t t = 0; t < transactions; ++t) {
+        path.clear();
+        for (auto i = transactionStarts[t]; i < transactionStarts[t + 1]; ++i) {
+            if (rankOf[transactionItems[i]] != kNone) {
+                path.push_back(rankOf[transactionItems[i]]);
+            }
+        }
+        if (!path.empty()) {
+            std::sort(path.begin(), path.end());
+            paths.items.insert(paths.items.end(), path.begin(), path.end());
+            paths.starts.push_back(paths.items.size());
+            paths.weights.push_back(1);
+        }
+    }
+    std::unique_ptr<utils::ThreadPool> ownPool;
+    utils::ThreadPool* pool = nullptr;
+    if (options.threads == 0) {
+        pool = &utils::ThreadPool::shared();
+    } else if (options.threads > 1) {
+        ownPool = std::make_unique<utils::ThreadPool>(options.threads);
+        pool = ownPool.get();
+    }
+    std::vector<std::uint32_t> identity(ranks);
+    std::iota(identity.begin(), identity.end(), 0u);
+    Tree tree;
+    buildTree(paths, identity, identity, tree, pool);
+    paths = Paths{};
+
+    // Each item's conditional tree is mined on its own; rarer items have larger ones, so they go first
+    std::vector<std::vector<Found>> found(ranks);
+    auto body = [&](std::size_t task) {
+        const std::size_t index = ranks - 1 - task;
+        Miner miner(minCount, options.maxItems, ranks, found[index]);
+        std::vector<std::uint32_t> prefix;
+        miner.mineItem(tree, index, prefix);
+    };
+    if (pool != nullptr && ranks > 1) {
+        pool->parallelFor(ranks, body);
+    } else {
+        for (std::size_t task = 0; task < ranks; ++task) {
+            body(task);
+        }
+    }
+
+    std::vector<Found> all;
+    for (auto& part : found) {
+        all.insert(all.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+    }
+    return all;
+}
+
+void recordMealInto(std::mutex& mutex, PatternAnalyzer::Sketches& sketches, const core::Meal& meal) {
+    std::vector<std::string> names;
+    if (meal.getRecipe()) {
+        for (const auto& ingredient : meal.getRecipe()->getIngredients()) {
+            names.push_back(algorithms::IngredientIndex::normalizeName(ingredient->getName()));
+        }
+    }
+    for (const auto& ingredient : meal.getIngredients()) {
+        names.push_back(algorithms::IngredientIndex::normalizeName(ingredient->getName()));
+    }
+    const double cost = meal.getEstimatedCost();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (meal.getRecipe()) {
+        sketches.recipes.add(meal.getRecipe()->getName());
+    }
+    for (const auto& name : names) {
+        sketches.ingredients.add(name);
+    }
+    if (std::isfinite(cost)) {
+        sketches.mealCosts.add(cost);
+    }
+}
+
+void recordPantryItemInto(std::mutex& mutex, PatternAnalyzer::Sketches& sketches, const core::Ingredient& ingredient) {
+    const std::string name = algorithms::IngredientIndex::normalizeName(ingredient.getName());
+    const double value = ingredient.getQuantity() * ingredient.getUnitPrice();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    sketches.ingredients.add(name);
+    if (std::isfinite(value)) {
+        sketches.pantryValues.add(value);
+    }
+}
+
+utils::Fingerprint fingerprintOf(const std::uint32_t* ranks, std::size_t size) {
+    utils::FingerprintBuilder builder;
+    for (std::size_t i = 0; i < size; ++i) {
+        builder.add(static_cast<std::uint64_t>(ranks[i]));
+    }
+    return builder.finish();
+}
+
+} // namespace
+
+/**
+ * @brief Sketches with their lock and the Storage subscription feeding them
+ */
+struct PatternAnalyzer::SketchState {
+    mutable std::mutex mutex;
+    Sketches sketches;
+    std::uint64_t listener = 0;  ///< Storage listener ID, 0 when not watching
+
+    SketchState() = default;
+    explicit SketchState(Sketches initial) : sketches(std::move(initial)) {}
+    SketchState(const SketchState&) = delete;
+    SketchState& operator=(const SketchState&) = delete;
+
+    ~SketchState() {
+        if (listener != 0) {
+            core::Storage::getInstance().removeListener(listener);
+        }
+    }
+};
+
+void PatternAnalyzer::Sketches::merge(const Sketches& other) {
+    // Check every shape first, so that a mismatch leaves the sketches unchanged
+    if (other.recipes.getWidth() != recipes.getWidth() || other.recipes.getDepth() != recipes.getDepth() ||
+        other.ingredients.getPrecision() != ingredients.getPrecision() ||
+        other.mealCosts.getK() != mealCosts.getK() || other.pantryValues.getK() != pantryValues.getK()) {
+        throw std::invalid_argument("Cannot merge sketches of different shapes");
+    }
+    recipes.merge(other.recipes);
+    ingredients.merge(other.ingredients);
+    mealCosts.merge(other.mealCosts);
+    pantryValues.merge(other.pantryValues);
+}
+
+std::string PatternAnalyzer::Sketches::serialize() const {
+    json j;
+    j["recipes"] = recipes.serialize();
+    j["ingredients"] = ingredients.serialize();
+    j["mealCosts"] = mealCosts.serialize();
+    j["pantryValues"] = pantryValues.serialize();
+    return j.dump();
+}
+
+PatternAnalyzer::Sketches PatternAnalyzer::Sketches::deserialize(const std::string& data) {
+    try {
+        json j = json::parse(data);
+        return Sketches{CountMinSketch::deserialize(j.at("recipes").get<std::string>()),
+                        HyperLogLog::deserialize(j.at("ingredients").get<std::string>()),
+                        QuantileSketch::deserialize(j.at("mealCosts").get<std::string>()),
+                        QuantileSketch::deserialize(j.at("pantryValues").get<std::string>())};
+    } catch (const json::exception& e) {
+        throw std::invalid_argument(std::string("Invalid sketches: ") + e.what());
+    }
+}
+
+PatternAnalyzer::PatternAnalyzer() : sketchState_(std::make_shared<SketchState>()) {
+    for (const auto& meal : core::Storage::getInstance().getMeals()) {
+        addMeal(*meal);
+    }
+}
+
+PatternAnalyzer::PatternAnalyzer(const std::vector<std::shared_ptr<core::Meal>>& meals)
+    : sketchState_(std::make_shared<SketchState>()) {
+    for (const auto& meal : meals) {
+        if (!meal) {
+            throw std::invalid_argument("Cannot add null meal");
+        }
+        addMeal(*meal);
+    }
+}
+
+PatternAnalyzer::PatternAnalyzer(const PatternAnalyzer& other)
+    : items_(other.items_),
+      itemIds_(other.itemIds_),
+      transactionItems_(other.transactionItems_),
+      transactionStarts_(other.transactionStarts_),
+      file_(other.file_),
+      fileNameStarts_(other.fileNameStarts_),
+      fileNames_(other.fileNames_),
+      fileTransactionItems_(other.fileTransactionItems_),
+      fileTransactionStarts_(other.fileTransactionStarts_),
+      sketchState_(std::make_shared<SketchState>(other.getSketches())) {}
+
+PatternAnalyzer& PatternAnalyzer::operator=(const PatternAnalyzer& other) {
+    if (this != &other) {
+        items_ = other.items_;
+        itemIds_ = other.itemIds_;
+        transactionItems_ = other.transactionItems_;
+        transactionStarts_ = other.transactionStarts_;
+        file_ = other.file_;
+        fileNameStarts_ = other.fileNameStarts_;
+        fileNames_ = other.fileNames_;
+        fileTransactionItems_ = other.fileTransactionItems_;
+        fileTransactionStarts_ = other.fileTransactionStarts_;
+        setSketches(other.getSketches());
+    }
+    return *this;
+}
+
+std::size_t PatternAnalyzer::getTransactionCount() const {
+    return transactionStarts().size - 1;
+}
+
+std::size_t PatternAnalyzer::getItemCount() const {
+    return file_ ? fileNameStarts_.size - 1 : items_.size();
+}
+
+PatternAnalyzer::Sketches PatternAnalyzer::getSketches() const {
+    std::lock_guard<std::mutex> lock(sketchState_->mutex);
+    return sketchState_->sketches;
+}
+
+void PatternAnalyzer::addMeal(const core::Meal& meal) {
+    std::vector<std::string> items;
+    if (meal.getRecipe()) {
+        items.push_back("recipe:" + meal.getRecipe()->getName());
+        for (const auto& ingredient : meal.getRecipe()->getIngredients()) {
+            items.push_back(algorithms::IngredientIndex::normalizeName(ingredient->getName()));
+        }
+    }
+    for (const auto& ingredient : meal.getIngredients()) {
+        items.push_back(algorithms::IngredientIndex::normalizeName(ingredient->getName()));
+    }
+    addTransaction(items);
+}
+
+void PatternAnalyzer::addTransaction(const std::vector<std::string>& items) {
+    detach();
+    const std::size_t start = transactionItems_.size();
+    for (const auto& item : items) {
+        transactionItems_.push_back(internItem(item));
+    }
+    auto first = transactionItems_.begin() + static_cast<std::ptrdiff_t>(start);
+    std::sort(first, transactionItems_.end());
+    transactionItems_.erase(std::unique(first, transactionItems_.end()), transactionItems_.end());
+    transactionStarts_.push_back(transactionItems_.size());
+}
+
+std::vector<PatternAnalyzer::Itemset> PatternAnalyzer::findFrequentItemsets() const {
+    return findFrequentItemsets(Options{});
+}
+
+std::vector<PatternAnalyzer::Itemset> PatternAnalyzer::findFrequentItemsets(const Options& options) const {
+    std::vector<std::uint32_t> rankedItems;
+    std::vector<std::uint32_t> rankCounts;
+    auto found = mineItemsets(transactionItems(), transactionStarts(), getItemCount(), options, rankedItems, rankCounts);
+
+    const auto transactions = static_cast<double>(getTransactionCount());
+    std::vector<Itemset> itemsets;
+    for (const auto& entry : found) {
+        const double support = entry.count / transactions;
+        double expected = 1.0;
+        for (auto rank : entry.ranks) {
+            expected *= rankCounts[rank] / transactions;
+        }
+        const double lift = entry.ranks.size() > 1 ? support / expected : 1.0;
+        if (entry.ranks.size() > 1 && lift < options.minLift) {
+            continue;
+        }
+        Itemset itemset{{}, entry.count, support, lift};
+        for (auto rank : entry.ranks) {
+            itemset.items.push_back(itemName(rankedItems[rank]));
+        }
+        std::sort(itemset.items.begin(), itemset.items.end());
+        itemsets.push_back(std::move(itemset));
+    }
+    std::sort(itemsets.begin(), itemsets.end(), [](const Itemset& a, const Itemset& b) {
+        if (a.count != b.count) {
+            return a.count > b.count;
+        }
+        if (a.items.size() != b.items.size()) {
+            return a.items.size() < b.items.size();
+        }
+        return a.items < b.items;
+    });
+    return itemsets;
+}
+
+std::vector<PatternAnalyzer::Rule> PatternAnalyzer::findAssociationRules() const {
+    return findAssociationRules(Options{});
+}
+
+std::vector<PatternAnalyzer::Rule> PatternAnalyzer::findAssociationRules(const Options& options) const {
+    std::vector<std::uint32_t> rankedItems;
+    std::vector<std::uint32_t> rankCounts;
+    auto found = mineItemsets(transactionItems(), transactionStarts(), getItemCount(), options, rankedItems, rankCounts);
+
+    // Every subset of a frequent itemset is frequent, so its count is at hand
+    std::unordered_map<utils::Fingerprint, std::uint32_t> counts;
+    for (const auto& entry : found) {
+        counts.emplace(fingerprintOf(entry.ranks.data(), entry.ranks.size()), entry.count);
+    }
+
+    const auto transactions = static_cast<double>(getTransactionCount());
+    auto names = [&](const std::vector<std::uint32_t>& ranks) {
+        std::vector<std::string> result;
+        for (auto rank : ranks) {
+            result.push_back(itemName(rankedItems[rank]));
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    };
+    std::vector<Rule> rules;
+    std::vector<std::uint32_t> antecedent;
+    std::vector<std::uint32_t> consequent;
+    for (const auto& entry : found) {
+        const std::size_t size = entry.ranks.size();
+        if (size < 2 || size > kMaxRuleItems) {
+            continue;
+        }
+        for (std::uint32_t mask = 1; mask + 1 < (1u << size); ++mask) {
+            antecedent.clear();
+            consequent.clear();
+            for (std::size_t i = 0; i < size; ++i) {
+                (mask & (1u << i) ? antecedent : consequent).push_back(entry.ranks[i]);
+            }
+            const double confidence =
+                static_cast<double>(entry.count) / counts.at(fingerprintOf(antecedent.data(), antecedent.size()));
+            const double lift =
+                confidence / (counts.at(fingerprintOf(consequent.data(), consequent.size())) / transactions);
+            if (confidence >= options.minConfidence && lift >= options.minLift) {
+                rules.push_back(Rule{names(antecedent), names(consequent), entry.count / transactions, confidence, lift});
+            }
+        }
+    }
+    std::sort(rules.begin(), rules.end(), [](const Rule& a, const Rule& b) {
+        if (a.lift != b.lift) {
+            return a.lift > b.lift;
+        }
+        if (a.confidence != b.confidence) {
+            return a.confidence > b.confidence;
+        }
+        return std::tie(a.antecedent, a.consequent) < std::tie(b.antecedent, b.consequent);
+    });
+    return rules;
+}
+
+void PatternAnalyzer::recordMeal(const core::Meal& meal) {
+    recordMealInto(sketchState_->mutex, sketchState_->sketches, meal);
+}
+
+void PatternAnalyzer::recordPantryItem(const core::Ingredient& ingredient) {
+    recordPantryItemInto(sketchState_->mutex, sketchState_->sketches, ingredient);
+}
+
+void PatternAnalyzer::watchStorage() {
+    std::lock_guard<std::mutex> lock(sketchState_->mutex);
+    if (sketchState_->listener != 0) {
+        return;
+    }
+    // The listener holds the state weakly: a mutation racing with the analyzer's destruction is dropped
+    std::weak_ptr<SketchState> weak = sketchState_;
+    sketchState_->listener = core::Storage::getInstance().addListener([weak](const core::Storage::Mutation& mutation) {
+        auto state = weak.lock();
+        if (!state || mutation.kind == core::Storage::Mutation::Kind::REMOVE) {
+            return;
+        }
+        if (mutation.meal && mutation.kind == core::Storage::Mutation::Kind::ADD) {
+            recordMealInto(state->mutex, state->sketches, *mutation.meal);
+        } else if (mutation.ingredient) {
+            recordPantryItemInto(state->mutex, state->sketches, *mutation.ingredient);
+        }
+    });
+}
+
+void PatternAnalyzer::mergeSketches(const Sketches& other) {
+    std::lock_guard<std::mutex> lock(sketchState_->mutex);
+    sketchState_->sketches.merge(other);
+}
+
+void PatternAnalyzer::setSketches(const Sketches& sketches) {
+    std::lock_guard<std::mutex> lock(sketchState_->mutex);
+    sketchState_->sketches = sketches;
+}
+
+void PatternAnalyzer::saveModelFile(const std::string& filename) const {
+    if (file_) {
+        file_->save(filename);
+        return;
+    }
+    std::vector<std::uint64_t> nameStarts = {0};
+    std::string names;
+    for (const auto& item : items_) {
+        names += item;
+        nameStarts.push_back(names.size());
+    }
+    utils::ModelFile::Writer(kFileKind, kFileVersion)
+        .add(nameStarts)
+        .add(names.data(), names.size())
+        .add(transactionItems_)
+        .add(transactionStarts_)
+        .save(filename);
+}
+
+PatternAnalyzer PatternAnalyzer::openModelFile(const std::string& filename) {
+    auto file = utils::ModelFile::open(filename, kFileKind, kFileVersion);
+    if (file->getSectionCount() != 4) {
+        throw std::invalid_argument("Pattern file is inconsistent");
+    }
+    const auto nameStarts = file->section<std::uint64_t>(0);
+    const auto names = file->section<char>(1);
+    const auto items = file->section<std::uint32_t>(2);
+    const auto starts = file->section<std::uint64_t>(3);
+
+    // Mining indexes by these without further checks; transactions hold increasing item IDs
+    bool consistent = nameStarts.size > 0 && nameStarts[0] == 0 && nameStarts[nameStarts.size - 1] == names.size &&
+                      starts.size > 0 && starts[0] == 0 && starts[starts.size - 1] == items.size;
+    for (std::size_t i = 1; consistent && i < nameStarts.size; ++i) {
+        consistent = nameStarts[i - 1] <= nameStarts[i];
+    }
+    for (std::size_t t = 1; consistent && t < starts.size; ++t) {
+        consistent = starts[t - 1] <= starts[t];
+        for (auto i = starts[t - 1]; consistent && i < starts[t]; ++i) {
+            consistent = items[i] < nameStarts.size - 1 && (i == starts[t - 1] || items[i - 1] < items[i]);
+        }
+    }
+    if (!consistent) {
+        throw std::invalid_argument("Pattern file is inconsistent");
+    }
+
+    PatternAnalyzer analyzer{std::vector<std::shared_ptr<core::Meal>>{}};
+    analyzer.transactionStarts_.clear();
+    analyzer.fileNameStarts_ = nameStarts;
+    analyzer.fileNames_ = names;
+    analyzer.fileTransactionItems_ = items;
+    analyzer.fileTransactionStarts_ = starts;
+    analyzer.file_ = std::move(file);
+    return analyzer;
+}
+
+std::uint32_t PatternAnalyzer::internItem(const std::string& name) {
+    auto [it, inserted] = itemIds_.emplace(name, static_cast<std::uint32_t>(items_.size()));
+    if (inserted) {
+        items_.push_back(name);
+    }
+    return it->second;
+}
+
+std::string PatternAnalyzer::itemName(std::uint32_t item) const {
+    if (!file_) {
+        return items_[item];
+    }
+    return std::string(fileNames_.data + fileNameStarts_[item], fileNames_.data + fileNameStarts_[item + 1]);
+}
+
+utils::ModelFile::Array<std::uint32_t> PatternAnalyzer::transactionItems() const {
+    return file_ ? fileTransactionItems_
+                 : utils::ModelFile::Array<std::uint32_t>{transactionItems_.data(), transactionItems_.size()};
+}
+
+utils::ModelFile::Array<std::uint64_t> PatternAnalyzer::transactionStarts() const {
+    return file_ ? fileTransactionStarts_
+                 : utils::ModelFile::Array<std::uint64_t>{transactionStarts_.data(), transactionStarts_.size()};
+}
+
+void PatternAnalyzer::detach() {
+    if (!file_) {
+        return;
+    }
+    const std::size_t itemCount = getItemCount();
+    items_.clear();
+    itemIds_.clear();
+    for (std::uint32_t item = 0; item < itemCount; ++item) {
+        items_.push_back(itemName(item));
+        itemIds_.emplace(items_.back(), item);
+    }
+    transactionItems_.assign(fileTransactionItems_.begin(), fileTransactionItems_.end());
+    transactionStarts_.assign(fileTransactionStarts_.begin(), fileTransactionStarts_.end());
+    file_.reset();
+    fileNameStarts_ = {};
+    fileNames_ = {};
+    fileTransactionItems_ = {};
+    fileTransactionStarts_ = {};
+}
+
+} // namespace ml
+} // namespace smart_food
@@ -0,0 +1,324 @@
+#include "smart_food/ml/predictor.hpp"
+#include "smart_food/ml/spoilage_model.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace smart_food {
+namespace ml {
+
+namespace {
+
+using Days = std::chrono::duration<std::int64_t, std::ratio<86400>>;
+
+constexpr std::size_t kMinCapacity = 16;
+constexpr std::uint32_t kFileKind = utils::ModelFile::tag("PRED");
+constexpr std::uint32_t kFileVersion = 1;
+
+/// Options and size of a predictor, the first section of its file
+struct FileMeta {
+    double levelSmoothing;
+    double trendSmoothing;
+    double seasonSmoothing;
+    double trendDamping;
+    std::int32_t maxGapDays;
+    std::int32_t horizonDays;
+    std::uint64_t size;
+};
+
+std::int32_t dayOf(std::chrono::system_clock::time_point time) {
+    return static_cast<std::int32_t>(std::chrono::floor<Days>(time.time_since_epoch()).count());
+}
+
+int weekday(std::int32_t day) {
+    const int index = day % 7;
+    return index < 0 ? index + 7 : index;
+}
+
+std::uint64_t makeKey(std::uint32_t household, std::uint32_t ingredient) {
+    return ((static_cast<std::uint64_t>(household) << 32) | ingredient) + 1;
+}
+
+/// SplitMix64 finalizer: consecutive keys land far apart
+std::uint64_t hashKey(std::uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+bool inUnitRange(double value) {
+    return value >= 0.0 && value <= 1.0;
+}
+
+} // namespace
+
+Predictor::Predictor() : Predictor(Options{}) {}
+
+Predictor::Predictor(const Options& options) : options_(options) {
+    if (!(options.levelSmoothing > 0.0 && options.levelSmoothing <= 1.0) || !inUnitRange(options.trendSmoothing) ||
+        !inUnitRange(options.seasonSmoothing) || !inUnitRange(options.trendDamping)) {
+        throw std::invalid_argument("Smoothing parameters must be in [0, 1], the level's above 0");
+    }
+    if (options.maxGapDays < 0 || options.horizonDays <= 0) {
+        throw std::invalid_argument("Gap must be non-negative and horizon positive");
+    }
+    alpha_ = static_cast<float>(options.levelSmoothing);
+    beta_ = static_cast<float>(options.trendSmoothing);
+    gamma_ = static_cast<float>(options.seasonSmoothing);
+    phi_ = static_cast<float>(options.trendDamping);
+}
+
+const Predictor::Options& Predictor::getOptions() const {
+    return options_;
+}
+
+std::size_t Predictor::size() const {
+    return size_;
+}
+
+void Predictor::reserve(std::size_t series) {
+    std::size_t capacity = kMinCapacity;
+    while (capacity < 2 * series) {
+        capacity *= 2;
+    }
+    detach();
+    if (capacity > table_.size()) {
+        grow(capacity);
+    }
+}
+
+void Predictor::update(std::uint32_t household, std::uint32_t ingredient, double quantity,
+                       std::chrono::system_clock::time_point time) {
+    if (!(quantity >= 0.0) || std::isinf(quantity)) {
+        throw std::invalid_argument("Consumed quantity must be finite and non-negative");
+    }
+    const std::uint64_t key = makeKey(household, ingredient);
+    if (key == 0) {
+        throw std::invalid_argument("Household and ingredient IDs 0xFFFFFFFF are reserved");
+    }
+    detach();
+    if (2 * (size_ + 1) > table_.size()) {
+        grow(std::max(kMinCapacity, 2 * table_.size()));
+    }
+
+    const std::int32_t day = dayOf(time);
+    const std::size_t mask = table_.size() - 1;
+    for (std::size_t slot = hashKey(key) & mask;; slot = (slot + 1) & mask) {
+        Series& series = table_[slot];
+        if (series.key == key) {
+            if (day > series.day && !advance(series, day)) {
+                series = Series{key, day, 0.0f, 0.0f, 0.0f, {}, 0};
+            }
+            series.pending += static_cast<float>(quantity);
+            return;
+        }
+        if (series.key == 0) {
+            series = Series{key, day, static_cast<float>(quantity), 0.0f, 0.0f, {}, 0};
+            ++size_;
+            return;
+        }
+    }
+}
+
+void Predictor::update(const std::vector<Event>& events) {
+    for (const auto& event : events) {
+        update(event.household, event.ingredient, event.quantity, event.time);
+    }
+}
+
+double Predictor::forecast(std::uint32_t household, std::uint32_t ingredient, int days,
+                           std::chrono::system_clock::time_point now) const {
+    const std::int32_t today = dayOf(now);
+    Series state;
+    if (days <= 0 || !project(find(makeKey(household, ingredient)), today, state)) {
+        return 0.0;
+    }
+    double total = 0.0;
+    float damped = 0.0f;
+    float power = 1.0f;
+    for (int ahead = 0; ahead < days; ++ahead) {
+        power *= phi_;
+        damped += power;
+        double expected = std::max(0.0f, state.level + damped * state.trend + state.season[weekday(today + ahead)]);
+        if (ahead == 0) {
+            expected = std::max(expected - state.pending, 0.0);  // Part of today may be consumed already
+        }
+        total += expected;
+    }
+    return total;
+}
+
+std::vector<double> Predictor::daysUntilRunOut(const std::vector<StockQuery>& queries,
+                                               std::chrono::system_clock::time_point now) const {
+    const std::int32_t today = dayOf(now);
+    std::vector<double> result(queries.size(), std::numeric_limits<double>::infinity());
+    for (std::size_t q = 0; q < queries.size(); ++q) {
+        const auto& query = queries[q];
+        Series state;
+        if (!project(find(makeKey(query.household, query.ingredient)), today, state)) {
+            continue;
+        }
+        double need = query.stock;
+        if (need <= 0.0) {
+            result[q] = 0.0;
+            continue;
+        }
+        float damped = 0.0f;
+        float power = 1.0f;
+        for (int ahead = 0; ahead < options_.horizonDays; ++ahead) {
+            power *= phi_;
+            damped += power;
+            double expected = std::max(0.0f, state.level + damped * state.trend + state.season[weekday(today + ahead)]);
+            if (ahead == 0) {
+                expected = std::max(expected - state.pending, 0.0);
+            }
+            if (expected >= need && expected > 0.0) {
+                result[q] = ahead + need / expected;
+                break;
+            }
+            need -= expected;
+        }
+    }
+    return result;
+}
+
+std::vector<float> Predictor::scoreSpoilage(const SpoilageModel& model, const std::vector<PantryItem>& items,
+                                            std::chrono::system_clock::time_point now) const {
+    SpoilageFeatures features;
+    features.reserve(items.size());
+    for (const auto& item : items) {
+        const double days = std::chrono::duration<double, std::ratio<86400>>(item.expiry - now).count();
+        const double usage = forecast(item.household, item.ingredient, kSeason, now) / kSeason;
+        features.add(item.category, static_cast<float>(days), static_cast<float>(item.quantity),
+                     static_cast<float>(usage));
+    }
+    return model.score(features);
+}
+
+void Predictor::saveModelFile(const std::string& filename) const {
+    FileMeta meta{};
+    meta.levelSmoothing = options_.levelSmoothing;
+    meta.trendSmoothing = options_.trendSmoothing;
+    meta.seasonSmoothing = options_.seasonSmoothing;
+    meta.trendDamping = options_.trendDamping;
+    meta.maxGapDays = options_.maxGapDays;
+    meta.horizonDays = options_.horizonDays;
+    meta.size = size_;
+    const auto table = slots();
+    utils::ModelFile::Writer(kFileKind, kFileVersion).add(&meta, 1).add(table.data, table.size).save(filename);
+}
+
+Predictor Predictor::openModelFile(const std::string& filename) {
+    auto file = utils::ModelFile::open(filename, kFileKind, kFileVersion);
+    const auto meta = file->section<FileMeta>(0);
+    if (meta.size != 1 || file->getSectionCount() != 2) {
+        throw std::invalid_argument("Predictor file is inconsistent");
+    }
+    Options options;
+    options.levelSmoothing = meta[0].levelSmoothing;
+    options.trendSmoothing = meta[0].trendSmoothing;
+    options.seasonSmoothing = meta[0].seasonSmoothing;
+    options.trendDamping = meta[0].trendDamping;
+    options.maxGapDays = meta[0].maxGapDays;
+    options.horizonDays = meta[0].horizonDays;
+    Predictor predictor(options);
+
+    // Lookups probe until a free slot, so one must exist; the stored size alone does not prove it
+    const auto table = file->section<Series>(1);
+    std::size_t free = 0;
+    for (const auto& series : table) {
+        free += series.key == 0 ? 1 : 0;
+    }
+    if ((table.size & (table.size - 1)) != 0 || (table.size > 0 && free == 0) || meta[0].size != table.size - free) {
+        throw std::invalid_argument("Predictor file is inconsistent");
+    }
+    predictor.size_ = static_cast<std::size_t>(meta[0].size);
+    predictor.fileTable_ = table;
+    predictor.file_ = std::move(file);
+    return predictor;
+}
+
+utils::ModelFile::Array<Predictor::Series> Predictor::slots() const {
+    return file_ ? fileTable_ : utils::ModelFile::Array<Series>{table_.data(), table_.size()};
+}
+
+void Predictor::detach() {
+    if (file_) {
+        table_.assign(fileTable_.begin(), fileTable_.end());
+        fileTable_ = {};
+        file_.reset();
+    }
+}
+
+const Predictor::Series* Predictor::find(std::uint64_t key) const {
+    const auto table = slots();
+    if (table.size == 0 || key == 0) {
+        return nullptr;
+    }
+    const std::size_t mask = table.size - 1;
+    for (std::size_t slot = hashKey(key) & mask;; slot = (slot + 1) & mask) {
+        if (table[slot].key == key) {
+            return &table[slot];
+        }
+        if (table[slot].key == 0) {
+            return nullptr;
+        }
+    }
+}
+
+void Predictor::grow(std::size_t capacity) {
+    std::vector<Series> old(capacity, Series{0, 0, 0.0f, 0.0f, 0.0f, {}, 0});
+    old.swap(table_);
+    const std::size_t mask = capacity - 1;
+    for (const auto& series : old) {
+        if (series.key != 0) {
+            std::size_t slot = hashKey(series.key) & mask;
+            while (table_[slot].key != 0) {
+                slot = (slot + 1) & mask;
+            }
+            table_[slot] = series;
+        }
+    }
+}
+
+bool Predictor::advance(Series& series, std::int32_t day) const {
+    if (day <= series.day) {
+        return true;
+    }
+    if (static_cast<std::int64_t>(day) - series.day - 1 > options_.maxGapDays) {
+        return false;
+    }
+    for (std::int32_t d = series.day; d < day; ++d) {
+        const float y = d == series.day ? series.pending : 0.0f;
+        float& season = series.season[weekday(d)];
+        if (series.days == 0) {
+            series.level = y;
+        } else {
+            const float previous = series.level;
+            series.level = alpha_ * (y - season) + (1.0f - alpha_) * (previous + phi_ * series.trend);
+            series.trend = beta_ * (series.level - previous) + (1.0f - beta_) * phi_ * series.trend;
+            season = gamma_ * (y - series.level) + (1.0f - gamma_) * season;
+        }
+        series.days += series.days < std::numeric_limits<std::uint32_t>::max() ? 1 : 0;
+    }
+    series.day = day;
+    series.pending = 0.0f;
+    return true;
+}
+
+bool Predictor::project(const Series* series, std::int32_t day, Series& state) const {
+    if (series == nullptr) {
+        return false;
+    }
+    state = *series;
+    const float pending = day == state.day ? state.pending : 0.0f;
+    if (!advance(state, day) || state.days == 0) {
+        return false;
+    }
+    state.pending = pending;
+    return true;
+}
+
+} // namespace ml
+} // namespace smart_food
@@ -0,0 +1,475 @@
+#include "smart_food/ml/sketches.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+#include "smart_food/utils/fingerprint.hpp"
+
+using nlohmann::json;
+
+namespace smart_food {
+namespace ml {
+
+namespace {
+
+constexpr std::size_t kMaxDepth = 16;
+constexpr unsigned kMinPrecision = 4;
+constexpr unsigned kMaxPrecision = 18;
+constexpr std::size_t kMinK = 8;
+constexpr std::size_t kMinLevelCapacity = 8;
+
+utils::Fingerprint hashKey(const std::string& key) {
+    return utils::FingerprintBuilder().add(key).finish();
+}
+
+/// Parse serialized sketch data, reporting malformed input as std::invalid_argument
+template <typename Read>
+auto parse(const std::string& data, const char* what, Read read) {
+    try {
+        return read(json::parse(data));
+    } catch (const json::exception& e) {
+        throw std::invalid_argument(std::string("Invalid ") + what + ": " + e.what());
+    }
+}
+
+} // namespace
+
+// CountMinSketch
+
+CountMinSketch::CountMinSketch(std::size_t width, std::size_t depth, std::size_t heavyHitters)
+    : width_(width), depth_(depth), capacity_(heavyHitters) {
+    if (width == 0 || depth == 0 || depth > kMaxDepth) {
+        throw std::invalid_argument("Count-Min sketch needs a width and 1 to 16 rows");
+    }
+    counters_.assign(width * depth, 0);
+    heap_.reserve(capacity_);
+}
+
+std::size_t CountMinSketch::getWidth() const {
+    return width_;
+}
+
+std::size_t CountMinSketch::getDepth() const {
+    return depth_;
+}
+
+std::uint64_t CountMinSketch::getTotal() const {
+    return total_;
+}
+
+std::vector<std::pair<std::string, std::uint64_t>> CountMinSketch::getHeavyHitters() const {
+    std::vector<std::pair<std::string, std::uint64_t>> result;
+    for (const auto& hitter : heap_) {
+        result.emplace_back(hitter.key, estimate(hitter.key));
+    }
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    return result;
+}
+
+void CountMinSketch::add(const std::string& key, std::uint64_t count) {
+    if (count == 0) {
+        return;
+    }
+    std::size_t slot[kMaxDepth];
+    slots(key, slot);
+    std::uint64_t estimate = std::numeric_limits<std::uint64_t>::max();
+    for (std::size_t row = 0; row < depth_; ++row) {
+        counters_[slot[row]] += count;
+        estimate = std::min(estimate, counters_[slot[row]]);
+    }
+    total_ += count;
+    offer(key, estimate);
+}
+
+std::uint64_t CountMinSketch::estimate(const std::string& key) const {
+    std::size_t slot[kMaxDepth];
+    slots(key, slot);
+    std::uint64_t estimate = std::numeric_limits<std::uint64_t>::max();
+    for (std::size_t row = 0; row < depth_; ++row) {
+        estimate = std::min(estimate, counters_[slot[row]]);
+    }
+    return estimate;
+}
+
+void CountMinSketch::merge(const CountMinSketch& other) {
+    if (other.width_ != width_ || other.depth_ != depth_ || other.capacity_ != capacity_) {
+        throw std::invalid_argument("Cannot merge Count-Min sketches of different shapes");
+    }
+    for (std::size_t i = 0; i < counters_.size(); ++i) {
+        counters_[i] += other.counters_[i];
+    }
+    total_ += other.total_;
+
+    // The heaviest keys of the union are among the heaviest of either side
+    std::vector<std::string> candidates;
+    for (const auto& hitter : heap_) {
+        candidates.push_back(hitter.key);
+    }
+    for (const auto& hitter : other.heap_) {
+        candidates.push_back(hitter.key);
+    }
+    heap_.clear();
+    heapIndex_.clear();
+    for (const auto& key : candidates) {
+        offer(key, estimate(key));
+    }
+}
+
+std::string CountMinSketch::serialize() const {
+    json j;
+    j["width"] = width_;
+    j["depth"] = depth_;
+    j["heavyHitters"] = capacity_;
+    j["total"] = total_;
+    j["counters"] = counters_;
+    j["hitters"] = json::array();
+    for (const auto& hitter : heap_) {
+        j["hitters"].push_back({hitter.key, hitter.count});
+    }
+    return j.dump();
+}
+
+CountMinSketch CountMinSketch::deserialize(const std::string& data) {
+    return parse(data, "Count-Min sketch", [](const json& j) {
+        CountMinSketch sketch(j.at("width").get<std::size_t>(), j.at("depth").get<std::size_t>(),
+                              j.at("heavyHitters").get<std::size_t>());
+        auto counters = j.at("counters").get<std::vector<std::uint64_t>>();
+        if (counters.size() != sketch.counters_.size()) {
+            throw std::invalid_argument("Invalid Count-Min sketch: wrong number of counters");
+        }
+        sketch.counters_ = std::move(counters);
+        sketch.total_ = j.at("total").get<std::uint64_t>();
+        for (const auto& hitter : j.at("hitters")) {
+            sketch.offer(hitter.at(0).get<std::string>(), hitter.at(1).get<std::uint64_t>());
+        }
+        return sketch;
+    });
+}
+
+void CountMinSketch::slots(const std::string& key, std::size_t* out) const {
+    // Rows index with h1 + row * h2 (double hashing), from the two lanes of one fingerprint
+    const auto fingerprint = hashKey(key);
+    const std::uint64_t step = fingerprint.high | 1u;
+    std::uint64_t hash = fingerprint.low;
+    for (std::size_t row = 0; row < depth_; ++row, hash += step) {
+        out[row] = row * width_ + static_cast<std::size_t>(hash % width_);
+    }
+}
+
+void CountMinSketch::offer(const std::string& key, std::uint64_t count) {
+    auto it = heapIndex_.find(key);
+    if (it != heapIndex_.end()) {
+        if (count > heap_[it->second].count) {
+            heap_[it->second].count = count;
+            siftDown(it->second);
+        }
+        return;
+    }
+    if (heap_.size() < capacity_) {
+        heap_.push_back(Hitter{count, key});
+        heapIndex_[key] = heap_.size() - 1;
+        siftUp(heap_.size() - 1);
+    } else if (capacity_ > 0 && count > heap_.front().count) {
+        heapIndex_.erase(heap_.front().key);
+        place(0, Hitter{count, key});
+        siftDown(0);
+    }
+}
+
+void CountMinSketch::place(std::size_t position, Hitter hitter) {
+    heapIndex_[hitter.key] = position;
+    heap_[position] = std::move(hitter);
+}
+
+void CountMinSketch::siftUp(std::size_t position) {
+    Hitter hitter = std::move(heap_[position]);
+    while (position > 0) {
+        const std::size_t parent = (position - 1) / 2;
+        if (heap_[parent].count <= hitter.count) {
+            break;
+        }
+        place(position, std::move(heap_[parent]));
+        position = parent;
+    }
+    place(position, std::move(hitter));
+}
+
+void CountMinSketch::siftDown(std::size_t position) {
+    Hitter hitter = std::move(heap_[position]);
+    while (true) {
+        std::size_t child = 2 * position + 1;
+        if (child >= heap_.size()) {
+            break;
+        }
+        if (child + 1 < heap_.size() && heap_[child + 1].count < heap_[child].count) {
+            ++child;
+        }
+        if (hitter.count <= heap_[child].count) {
+            break;
+        }
+        place(position, std::move(heap_[child]));
+        position = child;
+    }
+    place(position, std::move(hitter));
+}
+
+// HyperLogLog
+
+HyperLogLog::HyperLogLog(unsigned precision) : precision_(precision) {
+    if (precision < kMinPrecision || precision > kMaxPrecision) {
+        throw std::invalid_argument("HyperLogLog precision must be in [4, 18]");
+    }
+    registers_.assign(std::size_t{1} << precision, 0);
+}
+
+unsigned HyperLogLog::getPrecision() const {
+    return precision_;
+}
+
+void HyperLogLog::add(const std::string& key) {
+    // The top bits pick the register, the rank is the position of the first 1 in the rest
+    const std::uint64_t hash = hashKey(key).low;
+    const auto index = static_cast<std::size_t>(hash >> (64 - precision_));
+    std::uint64_t rest = hash << precision_;
+    const unsigned maxRank = 64 - precision_ + 1;
+    unsigned rank = 1;
+    while (rank < maxRank && (rest & (std::uint64_t{1} << 63)) == 0) {
+        ++rank;
+        rest <<= 1;
+    }
+    registers_[index] = std::max(registers_[index], static_cast<std::uint8_t>(rank));
+}
+
+double HyperLogLog::estimate() const {
+    const auto m = static_cast<double>(registers_.size());
+    double alpha = 0.7213 / (1.0 + 1.079 / m);
+    if (registers_.size() == 16) {
+        alpha = 0.673;
+    } else if (registers_.size() == 32) {
+        alpha = 0.697;
+    } else if (registers_.size() == 64) {
+        alpha = 0.709;
+    }
+    double sum = 0.0;
+    std::size_t zeros = 0;
+    for (auto value : registers_) {
+        sum += std::ldexp(1.0, -static_cast<int>(value));
+        zeros += value == 0 ? 1 : 0;
+    }
+    const double raw = alpha * m * m / sum;
+    if (raw <= 2.5 * m && zeros > 0) {
+        return m * std::log(m / static_cast<double>(zeros));
+    }
+    return raw;
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    if (other.precision_ != precision_) {
+        throw std::invalid_argument("Cannot merge HyperLogLog sketches of different precisions");
+    }
+    for (std::size_t i = 0; i < registers_.size(); ++i) {
+        registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+}
+
+std::string HyperLogLog::serialize() const {
+    json j;
+    j["precision"] = precision_;
+    j["registers"] = registers_;
+    return j.dump();
+}
+
+HyperLogLog HyperLogLog::deserialize(const std::string& data) {
+    return parse(data, "HyperLogLog sketch", [](const json& j) {
+        HyperLogLog sketch(j.at("precision").get<unsigned>());
+        auto registers = j.at("registers").get<std::vector<std::uint8_t>>();
+        if (registers.size() != sketch.registers_.size() ||
+            std::any_of(registers.begin(), registers.end(),
+                        [&](std::uint8_t value) { return value > 64 - sketch.precision_ + 1; })) {
+            throw std::invalid_argument("Invalid HyperLogLog sketch: wrong registers");
+        }
+        sketch.registers_ = std::move(registers);
+        return sketch;
+    });
+}
+
+// QuantileSketch
+
+QuantileSketch::QuantileSketch(std::size_t k) : k_(k) {
+    if (k < kMinK) {
+        throw std::invalid_argument("Quantile sketch k must be at least 8");
+    }
+}
+
+std::size_t QuantileSketch::getK() const {
+    return k_;
+}
+
+std::uint64_t QuantileSketch::getCount() const {
+    return count_;
+}
+
+std::size_t QuantileSketch::getRetained() const {
+    std::size_t retained = 0;
+    for (const auto& level : levels_) {
+        retained += level.size();
+    }
+    return retained;
+}
+
+void QuantileSketch::add(double value) {
+    if (!std::isfinite(value)) {
+        throw std::invalid_argument("Quantile sketch values must be finite");
+    }
+    min_ = count_ == 0 ? value : std::min(min_, value);
+    max_ = count_ == 0 ? value : std::max(max_, value);
+    ++count_;
+    if (levels_.empty()) {
+        levels_.emplace_back();
+    }
+    levels_[0].push_back(value);
+    if (levels_[0].size() >= capacity(0)) {
+        compress(false);
+    }
+}
+
+double QuantileSketch::quantile(double fraction) const {
+    if (!(fraction >= 0.0 && fraction <= 1.0)) {
+        throw std::invalid_argument("Quantile fraction must be in [0, 1]");
+    }
+    if (count_ == 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (fraction == 0.0) {
+        return min_;
+    }
+    if (fraction == 1.0) {
+        return max_;
+    }
+    std::vector<std::pair<double, std::uint64_t>> weighted;
+    std::uint64_t total = 0;
+    for (std::size_t h = 0; h < levels_.size(); ++h) {
+        for (double value : levels_[h]) {
+            weighted.emplace_back(value, std::uint64_t{1} << h);
+            total += std::uint64_t{1} << h;
+        }
+    }
+    std::sort(weighted.begin(), weighted.end());
+    const double target = fraction * static_cast<double>(total);
+    std::uint64_t seen = 0;
+    for (const auto& entry : weighted) {
+        seen += entry.second;
+        if (static_cast<double>(seen) >= target) {
+            return entry.first;
+        }
+    }
+    return max_;
+}
+
+double QuantileSketch::rank(double value) const {
+    if (count_ == 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    std::uint64_t below = 0;
+    std::uint64_t total = 0;
+    for (std::size_t h = 0; h < levels_.size(); ++h) {
+        for (double retained : levels_[h]) {
+            below += retained <= value ? std::uint64_t{1} << h : 0;
+            total += std::uint64_t{1} << h;
+        }
+    }
+    return static_cast<double>(below) / static_cast<double>(total);
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    if (other.k_ != k_) {
+        throw std::invalid_argument("Cannot merge quantile sketches with different k");
+    }
+    if (other.count_ == 0) {
+        return;
+    }
+    min_ = count_ == 0 ? other.min_ : std::min(min_, other.min_);
+    max_ = count_ == 0 ? other.max_ : std::max(max_, other.max_);
+    count_ += other.count_;
+    if (levels_.size() < other.levels_.size()) {
+        levels_.resize(other.levels_.size());
+    }
+    for (std::size_t h = 0; h < other.levels_.size(); ++h) {
+        levels_[h].insert(levels_[h].end(), other.levels_[h].begin(), other.levels_[h].end());
+    }
+    compress(true);
+}
+
+std::string QuantileSketch::serialize() const {
+    json j;
+    j["k"] = k_;
+    j["count"] = count_;
+    j["min"] = min_;
+    j["max"] = max_;
+    j["random"] = random_;
+    j["levels"] = levels_;
+    return j.dump();
+}
+
+QuantileSketch QuantileSketch::deserialize(const std::string& data) {
+    return parse(data, "quantile sketch", [](const json& j) {
+        QuantileSketch sketch(j.at("k").get<std::size_t>());
+        sketch.count_ = j.at("count").get<std::uint64_t>();
+        sketch.min_ = j.at("min").get<double>();
+        sketch.max_ = j.at("max").get<double>();
+        sketch.random_ = j.at("random").get<std::uint64_t>();
+        sketch.levels_ = j.at("levels").get<std::vector<std::vector<double>>>();
+        if ((sketch.count_ == 0) != (sketch.getRetained() == 0) || sketch.random_ == 0) {
+            throw std::invalid_argument("Invalid quantile sketch: inconsistent state");
+        }
+        return sketch;
+    });
+}
+
+std::size_t QuantileSketch::capacity(std::size_t level) const {
+    const auto belowTop = static_cast<double>(levels_.size() - 1 - level);
+    const double capacity = std::ceil(static_cast<double>(k_) * std::pow(2.0 / 3.0, belowTop));
+    return std::max(kMinLevelCapacity, static_cast<std::size_t>(capacity));
+}
+
+void QuantileSketch::compress(bool allLevels) {
+    // After an add only level 0 has grown, and compaction only feeds the level above, so a pass can
+    // stop at the first level that fits. A merge grows every level and a new top level shrinks the
+    // capacities below it, so those passes check every level
+    bool compacted = true;
+    while (compacted) {
+        compacted = false;
+        for (std::size_t h = 0; h < levels_.size(); ++h) {
+            if (levels_[h].size() < capacity(h)) {
+                if (!allLevels) {
+                    break;
+                }
+                continue;
+            }
+            if (h + 1 == levels_.size()) {
+                levels_.emplace_back();
+                allLevels = true;
+            }
+            auto& level = levels_[h];
+            auto& next = levels_[h + 1];
+            std::sort(level.begin(), level.end());
+
+            // With an odd size the smallest value stays; of the rest, every other one moves up
+            random_ ^= random_ << 13;
+            random_ ^= random_ >> 7;
+            random_ ^= random_ << 17;
+            const std::size_t kept = level.size() % 2;
+            for (std::size_t i = kept + (random_ & 1u); i < level.size(); i += 2) {
+                next.push_back(level[i]);
+            }
+            level.resize(kept);
+            compacted = true;
+        }
+    }
+}
+
+} // namespace ml
+} // namespace smart_food
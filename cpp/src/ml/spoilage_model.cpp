@@ -0,0 +1,466 @@
+#include "smart_food/ml/spoilage_model.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+using nlohmann::json;
+
+namespace smart_food {
+namespace ml {
+
+namespace {
+
+constexpr std::uint32_t kFileKind = utils::ModelFile::tag("SPOI");
+constexpr std::uint32_t kFileVersion = 1;
+constexpr std::size_t kMaxLeaves = 64;
+constexpr std::size_t kBlock = 64;
+constexpr std::size_t kNumericWeights = SpoilageModel::kFeatureCount - 1;
+
+const char* const kFeatureNames[SpoilageModel::kFeatureCount] = {"category", "daysToExpiry", "quantity",
+                                                                 "dailyUsage", "leftover"};
+
+int featureIndex(const std::string& name) {
+    for (std::size_t f = 0; f < SpoilageModel::kFeatureCount; ++f) {
+        if (name == kFeatureNames[f]) {
+            return static_cast<int>(f);
+        }
+    }
+    throw std::invalid_argument("Unknown spoilage feature: " + name);
+}
+
+int lowestBit(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int n = 0;
+    for (; !(x & 1); x >>= 1) {
+        ++n;
+    }
+    return n;
+#endif
+}
+
+/// Quantity expected to remain at expiry
+float leftover(float daysToExpiry, float quantity, float dailyUsage) {
+    return std::max(0.0f, quantity - dailyUsage * std::max(0.0f, daysToExpiry));
+}
+
+/**
+ * @brief e^x in single precision, branch-free so that loops over it vectorize
+ *
+ * 2^t with t = x log2(e) split into the nearest integer, set directly as the
+ * exponent, and a remainder in [-0.5, 0.5] from a degree-6 polynomial;
+ * relative error below 1e-6. Inputs are clamped to [-87, 88].
+ */
+float fastExp(float x) {
+    x = std::min(std::max(x, -87.0f), 88.0f);
+    const float t = x * 1.44269504f;
+    const int whole = static_cast<int>(t + 128.5f) - 128;  // Nearest integer; the argument is positive
+    const float f = (t - static_cast<float>(whole)) * 0.693147181f;
+    const float p =
+        1.0f + f * (1.0f + f * (0.5f + f * (0.166666667f + f * (0.0416666667f + f * (0.00833333333f + f * 0.00138888889f)))));
+    const std::int32_t bits = (whole + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+void checkFinite(double value, const char* what) {
+    if (!std::isfinite(value)) {
+        throw std::invalid_argument(std::string("Spoilage model ") + what + " must be finite");
+    }
+}
+
+} // namespace
+
+std::size_t SpoilageFeatures::size() const {
+    const std::size_t items = category.size();
+    if (daysToExpiry.size() != items || quantity.size() != items || dailyUsage.size() != items) {
+        throw std::invalid_argument("Spoilage feature columns differ in length");
+    }
+    return items;
+}
+
+void SpoilageFeatures::reserve(std::size_t items) {
+    category.reserve(items);
+    daysToExpiry.reserve(items);
+    quantity.reserve(items);
+    dailyUsage.reserve(items);
+}
+
+void SpoilageFeatures::add(std::uint32_t itemCategory, float itemDaysToExpiry, float itemQuantity,
+                           float itemDailyUsage) {
+    category.push_back(itemCategory);
+    daysToExpiry.push_back(itemDaysToExpiry);
+    quantity.push_back(itemQuantity);
+    dailyUsage.push_back(itemDailyUsage);
+}
+
+SpoilageModel::SpoilageModel(const Linear& linear, Link link) {
+    if (linear.weights.size() > kNumericWeights) {
+        throw std::invalid_argument("Linear spoilage model has at most 4 weights");
+    }
+    checkFinite(linear.intercept, "intercept");
+    for (double weight : linear.weights) {
+        checkFinite(weight, "weights");
+    }
+    for (double weight : linear.categoryWeights) {
+        checkFinite(weight, "weights");
+    }
+    Meta meta{};
+    meta.link = static_cast<std::uint32_t>(link);
+    meta.intercept = linear.intercept;
+    std::vector<double> weights = linear.weights;
+    weights.resize(kNumericWeights, 0.0);
+    const std::uint32_t treeStarts[] = {0};
+    *this = SpoilageModel(utils::ModelFile::Writer(kFileKind, kFileVersion)
+                              .add(&meta, 1)
+                              .add(weights)
+                              .add(linear.categoryWeights)
+                              .add(std::vector<Condition>{})
+                              .add(std::vector<float>{})
+                              .add(std::vector<Node>{})
+                              .add(treeStarts, 1)
+                              .finish());
+}
+
+SpoilageModel::SpoilageModel(const std::vector<Tree>& trees, double baseScore, Link link) {
+    checkFinite(baseScore, "base score");
+    Meta meta{};
+    meta.link = static_cast<std::uint32_t>(link);
+    meta.baseScore = baseScore;
+    std::vector<Condition> conditions;
+    std::vector<float> leaves;
+    compile(trees, meta, conditions, leaves);
+    std::vector<Node> nodes;
+    std::vector<std::uint32_t> treeStarts = {0};
+    for (const auto& tree : trees) {
+        nodes.insert(nodes.end(), tree.nodes.begin(), tree.nodes.end());
+        treeStarts.push_back(static_cast<std::uint32_t>(nodes.size()));
+    }
+    *this = SpoilageModel(utils::ModelFile::Writer(kFileKind, kFileVersion)
+                              .add(&meta, 1)
+                              .add(std::vector<double>(kNumericWeights, 0.0))
+                              .add(std::vector<double>{})
+                              .add(conditions)
+                              .add(leaves)
+                              .add(nodes)
+                              .add(treeStarts)
+                              .finish());
+}
+
+SpoilageModel::SpoilageModel(std::shared_ptr<const utils::ModelFile> file) : file_(std::move(file)) {
+    const auto meta = file_->section<Meta>(0);
+    if (meta.size != 1 || file_->getSectionCount() != 7) {
+        throw std::invalid_argument("Spoilage model file is inconsistent");
+    }
+    meta_ = meta.data;
+    weights_ = file_->section<double>(1);
+    categoryWeights_ = file_->section<double>(2);
+    conditions_ = file_->section<Condition>(3);
+    leaves_ = file_->section<float>(4);
+    nodes_ = file_->section<Node>(5);
+    treeStarts_ = file_->section<std::uint32_t>(6);
+
+    // Scoring indexes by these without further checks
+    bool consistent = meta_->link <= static_cast<std::uint32_t>(Link::LOGISTIC) && weights_.size == kNumericWeights &&
+                      leaves_.size == std::size_t{meta_->treeCount} * kMaxLeaves &&
+                      treeStarts_.size == std::size_t{meta_->treeCount} + 1 && treeStarts_[0] == 0 &&
+                      treeStarts_[meta_->treeCount] == nodes_.size && meta_->featureStarts[0] == 0 &&
+                      meta_->featureStarts[kFeatureCount] == conditions_.size;
+    for (std::size_t t = 0; consistent && t < meta_->treeCount; ++t) {
+        consistent = treeStarts_[t] <= treeStarts_[t + 1];
+    }
+    for (std::size_t f = 0; consistent && f < kFeatureCount; ++f) {
+        consistent = meta_->featureStarts[f] <= meta_->featureStarts[f + 1];
+    }
+    for (std::size_t c = 0; consistent && c < conditions_.size; ++c) {
+        consistent = conditions_[c].tree < meta_->treeCount;
+    }
+
+    // Children stay within their tree and features within range, for serialize(). A compiled tree's
+    // rightmost leaf is in no split's left subtree, so it survives every mask: scoring always finds a leaf
+    std::vector<std::uint64_t> survivors(consistent ? meta_->treeCount : 0);
+    for (std::size_t t = 0; consistent && t < meta_->treeCount; ++t) {
+        const std::uint32_t size = treeStarts_[t + 1] - treeStarts_[t];
+        std::size_t leafCount = 0;
+        for (std::size_t n = treeStarts_[t]; consistent && n < treeStarts_[t + 1]; ++n) {
+            const Node& node = nodes_[n];
+            if (node.feature < 0) {
+                ++leafCount;
+            } else {
+                consistent = node.feature < static_cast<int>(kFeatureCount) && node.left < size && node.right < size;
+            }
+        }
+        consistent = consistent && leafCount > 0 && leafCount <= kMaxLeaves;
+        survivors[t] = leafCount >= kMaxLeaves ? ~std::uint64_t{0} : (std::uint64_t{1} << leafCount) - 1;
+    }
+    for (std::size_t c = 0; consistent && c < conditions_.size; ++c) {
+        survivors[conditions_[c].tree] &= conditions_[c].mask;
+    }
+    for (std::size_t t = 0; consistent && t < meta_->treeCount; ++t) {
+        consistent = survivors[t] != 0;
+    }
+    if (!consistent) {
+        throw std::invalid_argument("Spoilage model file is inconsistent");
+    }
+}
+
+SpoilageModel SpoilageModel::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::invalid_argument("Cannot open spoilage model file: " + filename);
+    }
+    std::stringstream data;
+    data << file.rdbuf();
+    return deserialize(data.str());
+}
+
+SpoilageModel SpoilageModel::openModelFile(const std::string& filename) {
+    return SpoilageModel(utils::ModelFile::open(filename, kFileKind, kFileVersion));
+}
+
+SpoilageModel::Link SpoilageModel::getLink() const {
+    return static_cast<Link>(meta_->link);
+}
+
+std::size_t SpoilageModel::getTreeCount() const {
+    return meta_->treeCount;
+}
+
+std::vector<float> SpoilageModel::score(const SpoilageFeatures& features) const {
+    std::vector<float> result(features.size());
+    score(features, result.data());
+    return result;
+}
+
+void SpoilageModel::score(const SpoilageFeatures& features, float* out) const {
+    const std::size_t items = features.size();
+    const std::uint32_t* category = features.category.data();
+    const float* days = features.daysToExpiry.data();
+    const float* quantity = features.quantity.data();
+    const float* usage = features.dailyUsage.data();
+
+    if (meta_->treeCount == 0) {
+        const auto intercept = static_cast<float>(meta_->intercept);
+        const auto wDays = static_cast<float>(weights_[0]);
+        const auto wQuantity = static_cast<float>(weights_[1]);
+        const auto wUsage = static_cast<float>(weights_[2]);
+        const auto wLeftover = static_cast<float>(weights_[3]);
+        for (std::size_t i = 0; i < items; ++i) {
+            out[i] = intercept + wDays * days[i] + wQuantity * quantity[i] + wUsage * usage[i] +
+                     wLeftover * leftover(days[i], quantity[i], usage[i]);
+        }
+        const std::size_t categories = categoryWeights_.size;
+        if (categories > 0) {
+            for (std::size_t i = 0; i < items; ++i) {
+                out[i] += category[i] < categories ? static_cast<float>(categoryWeights_[category[i]]) : 0.0f;
+            }
+        }
+    } else {
+        // Blocks of items keep their feature values and leaf bitvectors in L1
+        const std::size_t treeCount = meta_->treeCount;
+        std::vector<std::uint64_t> bits(kBlock * treeCount);
+        float values[kFeatureCount][kBlock];
+        const auto base = static_cast<float>(meta_->baseScore);
+        for (std::size_t first = 0; first < items; first += kBlock) {
+            const std::size_t count = std::min(kBlock, items - first);
+            for (std::size_t i = 0; i < count; ++i) {
+                const std::size_t item = first + i;
+                values[0][i] = static_cast<float>(category[item]);
+                values[1][i] = days[item];
+                values[2][i] = quantity[item];
+                values[3][i] = usage[item];
+                values[4][i] = leftover(days[item], quantity[item], usage[item]);
+            }
+            std::fill(bits.begin(), bits.begin() + static_cast<std::ptrdiff_t>(count * treeCount), ~std::uint64_t{0});
+
+            // A split fails for every threshold below the value; the walk stops at the first that holds
+            for (std::size_t f = 0; f < kFeatureCount; ++f) {
+                const Condition* begin = conditions_.data + meta_->featureStarts[f];
+                const Condition* end = conditions_.data + meta_->featureStarts[f + 1];
+                for (std::size_t i = 0; i < count; ++i) {
+                    const float value = values[f][i];
+                    std::uint64_t* itemBits = bits.data() + i * treeCount;
+                    for (const Condition* c = begin; c != end && c->threshold < value; ++c) {
+                        itemBits[c->tree] &= c->mask;
+                    }
+                }
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+                const std::uint64_t* itemBits = bits.data() + i * treeCount;
+                float total = base;
+                for (std::size_t t = 0; t < treeCount; ++t) {
+                    total += leaves_[t * kMaxLeaves + static_cast<std::size_t>(lowestBit(itemBits[t]))];
+                }
+                out[first + i] = total;
+            }
+        }
+    }
+
+    if (getLink() == Link::LOGISTIC) {
+        for (std::size_t i = 0; i < items; ++i) {
+            out[i] = 1.0f / (1.0f + fastExp(-out[i]));
+        }
+    }
+}
+
+std::string SpoilageModel::serialize() const {
+    json j;
+    j["link"] = getLink() == Link::LOGISTIC ? "logistic" : "identity";
+    if (meta_->treeCount == 0) {
+        json weights = json::object();
+        for (std::size_t w = 0; w < kNumericWeights; ++w) {
+            if (weights_[w] != 0.0) {
+                weights[kFeatureNames[w + 1]] = weights_[w];
+            }
+        }
+        j["linear"] = {{"intercept", meta_->intercept},
+                       {"weights", weights},
+                       {"categoryWeights", std::vector<double>(categoryWeights_.begin(), categoryWeights_.end())}};
+    } else {
+        j["baseScore"] = meta_->baseScore;
+        j["trees"] = json::array();
+        for (std::size_t t = 0; t < meta_->treeCount; ++t) {
+            json nodes = json::array();
+            for (std::size_t n = treeStarts_[t]; n < treeStarts_[t + 1]; ++n) {
+                const Node& node = nodes_[n];
+                if (node.feature < 0) {
+                    nodes.push_back(json{{"value", node.value}});
+                } else {
+                    nodes.push_back(json{{"feature", kFeatureNames[node.feature]},
+                                         {"threshold", node.threshold},
+                                         {"left", node.left},
+                                         {"right", node.right}});
+                }
+            }
+            j["trees"].push_back(json{{"nodes", nodes}});
+        }
+    }
+    return j.dump();
+}
+
+SpoilageModel SpoilageModel::deserialize(const std::string& data) {
+    try {
+        json j = json::parse(data);
+        const auto linkName = j.at("link").get<std::string>();
+        if (linkName != "identity" && linkName != "logistic") {
+            throw std::invalid_argument("Unknown spoilage model link: " + linkName);
+        }
+        const Link link = linkName == "logistic" ? Link::LOGISTIC : Link::IDENTITY;
+
+        if (j.contains("linear")) {
+            const json& parameters = j.at("linear");
+            Linear linear;
+            linear.intercept = parameters.value("intercept", 0.0);
+            linear.weights.assign(kNumericWeights, 0.0);
+            const json weights = parameters.value("weights", json::object());
+            for (const auto& weight : weights.items()) {
+                const int feature = featureIndex(weight.key());
+                if (feature == static_cast<int>(Feature::CATEGORY)) {
+                    throw std::invalid_argument("Category weights go in categoryWeights");
+                }
+                linear.weights[static_cast<std::size_t>(feature) - 1] = weight.value().get<double>();
+            }
+            linear.categoryWeights = parameters.value("categoryWeights", std::vector<double>{});
+            return SpoilageModel(linear, link);
+        }
+
+        std::vector<Tree> trees;
+        for (const auto& treeJson : j.at("trees")) {
+            Tree tree;
+            for (const auto& nodeJson : treeJson.at("nodes")) {
+                Node node;
+                if (nodeJson.contains("feature")) {
+                    node.feature = featureIndex(nodeJson.at("feature").get<std::string>());
+                    node.threshold = nodeJson.at("threshold").get<float>();
+                    node.left = nodeJson.at("left").get<std::uint32_t>();
+                    node.right = nodeJson.at("right").get<std::uint32_t>();
+                } else {
+                    node.value = nodeJson.at("value").get<float>();
+                }
+                tree.nodes.push_back(node);
+            }
+            trees.push_back(std::move(tree));
+        }
+        return SpoilageModel(trees, j.value("baseScore", 0.0), link);
+    } catch (const json::exception& e) {
+        throw std::invalid_argument(std::string("Invalid spoilage model: ") + e.what());
+    }
+}
+
+void SpoilageModel::saveToFile(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file) {
+        throw std::invalid_argument("Cannot write spoilage model file: " + filename);
+    }
+    file << serialize();
+}
+
+void SpoilageModel::saveModelFile(const std::string& filename) const {
+    file_->save(filename);
+}
+
+void SpoilageModel::compile(const std::vector<Tree>& trees, Meta& meta, std::vector<Condition>& conditions,
+                            std::vector<float>& leaves) {
+    std::vector<std::vector<Condition>> byFeature(kFeatureCount);
+    leaves.assign(trees.size() * kMaxLeaves, 0.0f);
+    for (std::size_t t = 0; t < trees.size(); ++t) {
+        const auto& nodes = trees[t].nodes;
+        if (nodes.empty()) {
+            throw std::invalid_argument("Spoilage model tree has no nodes");
+        }
+
+        // Number the leaves left to right; each split's left subtree holds a contiguous range of them
+        std::vector<bool> seen(nodes.size(), false);
+        std::size_t leafCount = 0;
+        auto visit = [&](auto&& self, std::uint32_t index) -> void {
+            if (index >= nodes.size() || seen[index]) {
+                throw std::invalid_argument("Spoilage model tree is not a tree");
+            }
+            seen[index] = true;
+            const Node& node = nodes[index];
+            if (node.feature < 0) {
+                checkFinite(node.value, "leaf values");
+                if (leafCount == kMaxLeaves) {
+                    throw std::invalid_argument("Spoilage model trees have at most 64 leaves");
+                }
+                leaves[t * kMaxLeaves + leafCount++] = node.value;
+                return;
+            }
+            if (node.feature >= static_cast<int>(kFeatureCount) || std::isnan(node.threshold)) {
+                throw std::invalid_argument("Spoilage model split has an invalid feature or threshold");
+            }
+            const std::size_t first = leafCount;
+            self(self, node.left);
+            const std::size_t width = leafCount - first;
+            const std::uint64_t left = (width == kMaxLeaves ? ~std::uint64_t{0} : (std::uint64_t{1} << width) - 1) << first;
+            byFeature[static_cast<std::size_t>(node.feature)].push_back(
+                Condition{node.threshold, static_cast<std::uint32_t>(t), ~left});
+            self(self, node.right);
+        };
+        visit(visit, 0);
+        if (std::find(seen.begin(), seen.end(), false) != seen.end()) {
+            throw std::invalid_argument("Spoilage model tree has unreachable nodes");
+        }
+    }
+
+    meta.treeCount = static_cast<std::uint32_t>(trees.size());
+    conditions.clear();
+    for (std::size_t f = 0; f < kFeatureCount; ++f) {
+        auto& list = byFeature[f];
+        std::stable_sort(list.begin(), list.end(),
+                         [](const Condition& a, const Condition& b) { return a.threshold < b.threshold; });
+        meta.featureStarts[f] = conditions.size();
+        conditions.insert(conditions.end(), list.begin(), list.end());
+    }
+    meta.featureStarts[kFeatureCount] = conditions.size();
+}
+
+} // namespace ml
+} // namespace smart_food
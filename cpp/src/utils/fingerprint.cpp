@@ -0,0 +1,66 @@
+#include "smart_food/utils/fingerprint.hpp"
+#include <cstring>
+
+namespace smart_food {
+namespace utils {
+
+namespace {
+
+/// SplitMix64 finalizer
+std::uint64_t mix(std::uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+std::uint64_t rotate(std::uint64_t x, int bits) {
+    return (x << bits) | (x >> (64 - bits));
+}
+
+} // namespace
+
+FingerprintBuilder& FingerprintBuilder::add(std::uint64_t value) {
+    a_ = rotate(a_ ^ mix(value + 0x9E3779B97F4A7C15ull), 27) * 0x9E3779B97F4A7C15ull;
+    b_ = rotate(b_ + mix(value ^ 0xC2B2AE3D27D4EB4Full), 31) * 0xC2B2AE3D27D4EB4Full + count_;
+    ++count_;
+    return *this;
+}
+
+FingerprintBuilder& FingerprintBuilder::add(double value) {
+    if (value == 0.0) {
+        value = 0.0;  // -0.0 compares equal, so it must hash equal
+    }
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return add(bits);
+}
+
+FingerprintBuilder& FingerprintBuilder::add(const std::string& value) {
+    add(static_cast<std::uint64_t>(value.size()));
+    std::size_t i = 0;
+    for (; i + sizeof(std::uint64_t) <= value.size(); i += sizeof(std::uint64_t)) {
+        std::uint64_t chunk;
+        std::memcpy(&chunk, value.data() + i, sizeof(chunk));
+        add(chunk);
+    }
+    if (i < value.size()) {
+        std::uint64_t chunk = 0;
+        std::memcpy(&chunk, value.data() + i, value.size() - i);
+        add(chunk);
+    }
+    return *this;
+}
+
+FingerprintBuilder& FingerprintBuilder::add(const Fingerprint& value) {
+    return add(value.high).add(value.low);
+}
+
+Fingerprint FingerprintBuilder::finish() const {
+    Fingerprint fingerprint;
+    fingerprint.high = mix(a_ ^ rotate(b_, 32) ^ count_);
+    fingerprint.low = mix(b_ + rotate(a_, 17) + count_ * 0x9E3779B97F4A7C15ull);
+    return fingerprint;
+}
+
+} // namespace utils
+} // namespace smart_food
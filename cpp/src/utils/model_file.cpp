@@ -0,0 +1,386 @@
+#include "smart_food/utils/model_file.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SMART_FOOD_HAVE_MMAP 1
+#endif
+
+namespace smart_food {
+namespace utils {
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'F', 'M', 'O', 'D', 'E', 'L', '\0'};
+constexpr std::uint32_t kByteOrder = 0x01020304;
+constexpr std::uint32_t kFormatVersion = 1;
+constexpr std::size_t kAlignment = 64;
+
+struct Header {
+    char magic[8];
+    std::uint32_t byteOrder;
+    std::uint32_t formatVersion;
+    std::uint32_t kind;
+    std::uint32_t version;
+    std::uint64_t sectionCount;
+    std::uint64_t fileSize;
+    std::uint64_t checksum;  ///< Of the header fields above and every byte after the header
+    std::uint64_t reserved[2];
+};
+static_assert(sizeof(Header) == kAlignment, "Model file header is one cache line");
+
+struct SectionEntry {
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+
+std::size_t alignUp(std::size_t value) {
+    return (value + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+std::uint64_t rotate(std::uint64_t x, int bits) {
+    return (x << bits) | (x >> (64 - bits));
+}
+
+/**
+ * @brief 64-bit checksum over 32-byte blocks, in four independent lanes so that it runs at memory speed
+ */
+class Checksum {
+public:
+    explicit Checksum(const Header& header)
+        : lanes_{header.kind + kPrime1, header.version + kPrime2, header.sectionCount, header.fileSize - kPrime1} {}
+
+    /// Add bytes; the total must come to whole blocks
+    void add(const unsigned char* data, std::size_t bytes) {
+        while (bytes > 0 && pending_ > 0) {
+            block_[pending_++] = *data++;
+            --bytes;
+            if (pending_ == sizeof(block_)) {
+                mixBlock(block_);
+                pending_ = 0;
+            }
+        }
+        for (; bytes >= sizeof(block_); data += sizeof(block_), bytes -= sizeof(block_)) {
+            mixBlock(data);
+        }
+        if (bytes > 0) {  // Empty sections pass a null pointer, which memcpy must not see even for zero bytes
+            std::memcpy(block_, data, bytes);
+        }
+        pending_ = bytes;
+    }
+
+    std::uint64_t finish() const {
+        std::uint64_t hash = rotate(lanes_[0], 1) + rotate(lanes_[1], 7) + rotate(lanes_[2], 12) + rotate(lanes_[3], 18);
+        hash = (hash ^ (hash >> 33)) * kPrime2;
+        return hash ^ (hash >> 29);
+    }
+
+private:
+    static constexpr std::uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+    static constexpr std::uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+
+    std::uint64_t lanes_[4];
+    unsigned char block_[32];
+    std::size_t pending_ = 0;
+
+    void mixBlock(const unsigned char* data) {
+        for (int lane = 0; lane < 4; ++lane) {
+            std::uint64_t word;
+            std::memcpy(&word, data + 8 * lane, sizeof(word));
+            lanes_[lane] = rotate(lanes_[lane] + word * kPrime2, 31) * kPrime1;
+        }
+    }
+};
+
+/**
+ * @brief Pass the bytes of a model file after its header to a sink, in order
+ */
+template <typename Sink>
+void emitBody(const std::vector<std::vector<unsigned char>>& sections, const std::vector<SectionEntry>& table,
+              Sink&& sink) {
+    static const unsigned char kZeros[kAlignment] = {};
+    std::size_t offset = sizeof(Header);
+    auto padTo = [&](std::size_t target) {
+        sink(kZeros, target - offset);
+        offset = target;
+    };
+    if (!table.empty()) {
+        sink(reinterpret_cast<const unsigned char*>(table.data()), table.size() * sizeof(SectionEntry));
+        offset += table.size() * sizeof(SectionEntry);
+    }
+    for (std::size_t s = 0; s < sections.size(); ++s) {
+        padTo(static_cast<std::size_t>(table[s].offset));
+        sink(sections[s].data(), sections[s].size());
+        offset += sections[s].size();
+    }
+    padTo(alignUp(offset));
+}
+
+/**
+ * @brief Create an empty file next to `filename` under a name no other writer holds
+ *
+ * Concurrent saves of the same file, from threads or processes, each get their own
+ * file, so one never truncates or renames another's half-written bytes.
+ * @throws std::invalid_argument if no such file can be created
+ */
+std::string createTemporary(const std::string& filename) {
+    static std::atomic<unsigned> counter{0};
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        std::string temporary = filename + ".tmp." + std::to_string(counter.fetch_add(1));
+#ifdef SMART_FOOD_HAVE_MMAP
+        temporary += "." + std::to_string(::getpid());
+        // O_EXCL claims the name; mode 0666 leaves permissions to the umask, as for the file it replaces
+        const int descriptor = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+        if (descriptor >= 0) {
+            ::close(descriptor);
+            return temporary;
+        }
+        if (errno != EEXIST) {
+            break;
+        }
+#else
+        if (std::FILE* probe = std::fopen(temporary.c_str(), "rb")) {
+            std::fclose(probe);
+            continue;
+        }
+        return temporary;
+#endif
+    }
+    throw std::invalid_argument("Cannot write model file: " + filename);
+}
+
+/**
+ * @brief Write a file under a temporary name and rename it over the target
+ */
+template <typename Contents>
+void saveAtomically(const std::string& filename, Contents&& contents) {
+    const std::string temporary = createTemporary(filename);
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::remove(temporary.c_str());
+            throw std::invalid_argument("Cannot write model file: " + filename);
+        }
+        try {
+            contents(file);
+        } catch (...) {
+            file.close();
+            std::remove(temporary.c_str());
+            throw;
+        }
+        if (!file.flush()) {
+            file.close();
+            std::remove(temporary.c_str());
+            throw std::invalid_argument("Cannot write model file: " + filename);
+        }
+    }
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::invalid_argument("Cannot replace model file: " + filename);
+    }
+}
+
+} // namespace
+
+ModelFile::Writer::Writer(std::uint32_t kind, std::uint32_t version) : kind_(kind), version_(version) {}
+
+ModelFile::Writer& ModelFile::Writer::addBytes(const void* data, std::size_t bytes) {
+    const auto* first = static_cast<const unsigned char*>(data);
+    sections_.emplace_back(first, first + bytes);
+    return *this;
+}
+
+void ModelFile::Writer::write(const std::function<void(const void*, std::size_t)>& sink) const {
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.byteOrder = kByteOrder;
+    header.formatVersion = kFormatVersion;
+    header.kind = kind_;
+    header.version = version_;
+    header.sectionCount = sections_.size();
+    std::size_t size = alignUp(sizeof(Header) + sections_.size() * sizeof(SectionEntry));
+    std::vector<SectionEntry> table;
+    for (const auto& section : sections_) {
+        table.push_back(SectionEntry{size, section.size()});
+        size = alignUp(size + section.size());
+    }
+    header.fileSize = size;
+
+    Checksum checksum(header);
+    emitBody(sections_, table, [&](const unsigned char* data, std::size_t bytes) { checksum.add(data, bytes); });
+    header.checksum = checksum.finish();
+    sink(&header, sizeof(header));
+    emitBody(sections_, table, [&](const unsigned char* data, std::size_t bytes) { sink(data, bytes); });
+}
+
+std::vector<std::uint64_t> ModelFile::Writer::image() const {
+    std::vector<std::uint64_t> words;
+    std::size_t offset = 0;
+    write([&](const void* data, std::size_t bytes) {
+        if (bytes == 0) {
+            return;
+        }
+        words.resize((offset + bytes + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+        std::memcpy(reinterpret_cast<unsigned char*>(words.data()) + offset, data, bytes);
+        offset += bytes;
+    });
+    return words;
+}
+
+std::shared_ptr<const ModelFile> ModelFile::Writer::finish() const {
+    std::shared_ptr<ModelFile> file(new ModelFile());
+    file->buffer_ = image();
+    file->data_ = reinterpret_cast<const unsigned char*>(file->buffer_.data());
+    file->size_ = file->buffer_.size() * sizeof(std::uint64_t);
+    return file;
+}
+
+void ModelFile::Writer::save(const std::string& filename) const {
+    saveAtomically(filename, [&](std::ofstream& file) {
+        write([&](const void* data, std::size_t bytes) {
+            file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        });
+    });
+}
+
+std::shared_ptr<const ModelFile> ModelFile::open(const std::string& filename, std::uint32_t kind,
+                                                 std::uint32_t version) {
+    std::shared_ptr<ModelFile> file(new ModelFile());
+#ifdef SMART_FOOD_HAVE_MMAP
+    const int descriptor = ::open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::invalid_argument("Cannot open model file: " + filename);
+    }
+    struct stat status;
+    if (::fstat(descriptor, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(descriptor);
+        throw std::invalid_argument("Not a model file: " + filename);
+    }
+    void* mapping = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+    ::close(descriptor);  // The mapping keeps the file open
+    if (mapping == MAP_FAILED) {
+        throw std::invalid_argument("Cannot map model file: " + filename);
+    }
+    file->data_ = static_cast<const unsigned char*>(mapping);
+    file->size_ = static_cast<std::size_t>(status.st_size);
+    file->mapped_ = true;
+#else
+    std::ifstream stream(filename, std::ios::binary | std::ios::ate);
+    if (!stream) {
+        throw std::invalid_argument("Cannot open model file: " + filename);
+    }
+    const auto size = static_cast<std::size_t>(stream.tellg());
+    file->buffer_.resize((size + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+    stream.seekg(0);
+    if (!stream.read(reinterpret_cast<char*>(file->buffer_.data()), static_cast<std::streamsize>(size))) {
+        throw std::invalid_argument("Cannot read model file: " + filename);
+    }
+    file->data_ = reinterpret_cast<const unsigned char*>(file->buffer_.data());
+    file->size_ = size;
+#endif
+    file->check(kind, version);
+    return file;
+}
+
+ModelFile::~ModelFile() {
+#ifdef SMART_FOOD_HAVE_MMAP
+    if (mapped_) {
+        ::munmap(const_cast<unsigned char*>(data_), size_);
+    }
+#endif
+}
+
+std::uint32_t ModelFile::getKind() const {
+    Header header;
+    std::memcpy(&header, data_, sizeof(header));
+    return header.kind;
+}
+
+std::uint32_t ModelFile::getVersion() const {
+    Header header;
+    std::memcpy(&header, data_, sizeof(header));
+    return header.version;
+}
+
+std::size_t ModelFile::getSectionCount() const {
+    Header header;
+    std::memcpy(&header, data_, sizeof(header));
+    return static_cast<std::size_t>(header.sectionCount);
+}
+
+std::size_t ModelFile::getSize() const {
+    return size_;
+}
+
+bool ModelFile::isMapped() const {
+    return mapped_;
+}
+
+void ModelFile::save(const std::string& filename) const {
+    saveAtomically(filename, [&](std::ofstream& file) {
+        file.write(reinterpret_cast<const char*>(data_), static_cast<std::streamsize>(size_));
+    });
+}
+
+void ModelFile::check(std::uint32_t kind, std::uint32_t version) const {
+    Header header;
+    if (size_ < sizeof(Header)) {
+        throw std::invalid_argument("Not a model file");
+    }
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::invalid_argument("Not a model file");
+    }
+    if (header.byteOrder != kByteOrder) {
+        throw std::invalid_argument("Model file was written with another byte order");
+    }
+    if (header.formatVersion != kFormatVersion) {
+        throw std::invalid_argument("Unsupported model file format version " + std::to_string(header.formatVersion));
+    }
+    if (header.kind != kind) {
+        throw std::invalid_argument("Model file holds another kind of model");
+    }
+    if (header.version != version) {
+        throw std::invalid_argument("Unsupported model version " + std::to_string(header.version));
+    }
+    if (header.fileSize != size_ || size_ % kAlignment != 0 ||
+        header.sectionCount > (size_ - sizeof(Header)) / sizeof(SectionEntry)) {
+        throw std::invalid_argument("Model file is truncated");
+    }
+    for (std::size_t s = 0; s < header.sectionCount; ++s) {
+        SectionEntry entry;
+        std::memcpy(&entry, data_ + sizeof(Header) + s * sizeof(SectionEntry), sizeof(entry));
+        if (entry.offset % kAlignment != 0 || entry.offset > size_ || entry.size > size_ - entry.offset) {
+            throw std::invalid_argument("Model file is truncated");
+        }
+    }
+    Checksum checksum(header);
+    checksum.add(data_ + sizeof(Header), size_ - sizeof(Header));
+    if (checksum.finish() != header.checksum) {
+        throw std::invalid_argument("Model file fails its checksum");
+    }
+}
+
+const void* ModelFile::sectionBytes(std::size_t index, std::size_t valueSize, std::size_t& bytes) const {
+    if (index >= getSectionCount()) {
+        throw std::invalid_argument("Model file has no section " + std::to_string(index));
+    }
+    SectionEntry entry;
+    std::memcpy(&entry, data_ + sizeof(Header) + index * sizeof(SectionEntry), sizeof(entry));
+    if (entry.size % valueSize != 0) {
+        throw std::invalid_argument("Model file section " + std::to_string(index) + " has the wrong value size");
+    }
+    bytes = static_cast<std::size_t>(entry.size);
+    return data_ + entry.offset;
+}
+
+} // namespace utils
+} // namespace smart_food
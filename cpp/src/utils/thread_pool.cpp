@@ -0,0 +1,148 @@
+#include "smart_food/utils/thread_pool.hpp"
+#include <algorithm>
+#include <exception>
+
+namespace smart_food {
+namespace utils {
+
+namespace {
+
+/// Completion state shared by the tasks of one parallelFor() call
+struct Batch {
+    std::atomic<std::size_t> remaining{0};
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+};
+
+} // namespace
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    queues_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+std::size_t ThreadPool::size() const {
+    return workers_.size();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+
+    auto batch = std::make_shared<Batch>();
+    batch->remaining = count;
+
+    // Count the tasks before publishing them so takers never see a negative balance
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        pending_ += count;
+    }
+
+    // Deal the tasks round-robin; stealing evens out whatever imbalance is left
+    const std::size_t queueCount = queues_.size();
+    const std::size_t start = nextQueue_.fetch_add(1) % queueCount;
+    for (std::size_t i = 0; i < count; ++i) {
+        Queue& queue = *queues_[(start + i) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.emplace_back([batch, &body, i]() {
+            try {
+                body(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                if (!batch->error) {
+                    batch->error = std::current_exception();
+                }
+            }
+            if (batch->remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                batch->done.notify_all();
+            }
+        });
+    }
+    wake_.notify_all();
+
+    // Help out instead of blocking, then wait for tasks still running elsewhere
+    Task task;
+    while (batch->remaining.load() > 0 && takeTask(start, task)) {
+        task();
+        task = nullptr;
+    }
+    {
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->done.wait(lock, [&batch]() { return batch->remaining.load() == 0; });
+    }
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+bool ThreadPool::takeTask(std::size_t home, Task& task) {
+    const std::size_t queueCount = queues_.size();
+    {
+        Queue& own = *queues_[home];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            --pending_;
+            return true;
+        }
+    }
+    for (std::size_t offset = 1; offset < queueCount; ++offset) {
+        Queue& victim = *queues_[(home + offset) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --pending_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(std::size_t index) {
+    Task task;
+    while (true) {
+        if (takeTask(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this]() { return stopping_ || pending_.load() > 0; });
+        if (stopping_ && pending_.load() == 0) {
+            return;
+        }
+    }
+}
+
+} // namespace utils
+} // namespace smart_food
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <smart_food/algorithms/anytime.hpp>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using namespace smart_food::algorithms;
+
+TEST(AnytimeTest, CancellationIsSharedByCopies) {
+    CancellationToken token;
+    CancellationToken copy = token;
+    EXPECT_FALSE(copy.isCancelled());
+
+    token.cancel();
+    EXPECT_TRUE(copy.isCancelled());
+    EXPECT_FALSE(CancellationToken().isCancelled());
+}
+
+TEST(AnytimeTest, ControlStopsAtDeadline) {
+    SolveControl<int> control;
+    EXPECT_FALSE(control.shouldStop());
+
+    control.deadline = SolveControl<int>::Clock::now() - std::chrono::milliseconds(1);
+    EXPECT_TRUE(control.shouldStop());
+
+    SolveControl<int> cancelled;
+    cancelled.cancellation.cancel();
+    EXPECT_TRUE(cancelled.shouldStop());
+}
+
+TEST(AnytimeTest, ChannelKeepsOnlyImprovements) {
+    SolutionChannel<std::vector<int>> channel;
+    EXPECT_EQ(channel.best(), nullptr);
+    EXPECT_TRUE(std::isinf(channel.progress().gap()));
+
+    EXPECT_TRUE(channel.offer(10.0, {1, 2}));
+    EXPECT_FALSE(channel.offer(12.0, {3}));
+    EXPECT_FALSE(channel.offer(10.0, {4}));
+    EXPECT_TRUE(channel.improves(9.0));
+    EXPECT_TRUE(channel.offer(8.0, {5}));
+
+    ASSERT_NE(channel.best(), nullptr);
+    EXPECT_EQ(*channel.best(), std::vector<int>{5});
+
+    channel.raiseLowerBound(6.0);
+    channel.raiseLowerBound(4.0);
+    channel.addIterations(100);
+    channel.addIterations(20);
+    channel.finish();
+
+    auto progress = channel.progress();
+    EXPECT_DOUBLE_EQ(progress.bestCost, 8.0);
+    EXPECT_DOUBLE_EQ(progress.lowerBound, 6.0);
+    EXPECT_DOUBLE_EQ(progress.gap(), 0.25);
+    EXPECT_EQ(progress.iterations, 120u);
+    EXPECT_EQ(progress.improvements, 2u);
+    EXPECT_TRUE(progress.finished);
+}
+
+TEST(AnytimeTest, ConcurrentOffersKeepTheMinimum) {
+    SolutionChannel<int> channel;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&channel, t] {
+            for (int i = 1000; i >= 0; --i) {
+                const int value = i * 4 + t;
+                channel.offer(static_cast<double>(value), value);
+                channel.addIterations(1);
+            }
+        });
+    }
+
+    // Readers only ever see a published solution matching its cost, and costs never go up
+    double last = std::numeric_limits<double>::infinity();
+    while (channel.progress().iterations < 4 * 1001) {
+        double cost = channel.bestCost();
+        EXPECT_LE(cost, last);
+        last = cost;
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+
+    ASSERT_NE(channel.best(), nullptr);
+    EXPECT_EQ(*channel.best(), 0);
+    EXPECT_DOUBLE_EQ(channel.bestCost(), 0.0);
+}
@@ -0,0 +1,348 @@
+#include <gtest/gtest.h>
+#include <smart_food/algorithms/cost_optimizer.hpp>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+/// An ingredient sold per piece, with nutrients per piece
+std::shared_ptr<Ingredient> makeFood(const std::string& name, double price, double protein, double calories) {
+    auto ingredient = std::make_shared<Ingredient>(name, 1.0, Ingredient::Unit::PIECE);
+    ingredient->setUnitPrice(price);
+    ingredient->addNutritionalInfo("protein", protein);
+    ingredient->addNutritionalInfo("calories", calories);
+    return ingredient;
+}
+
+double amountOf(const CostOptimizer::Solution& solution, const std::shared_ptr<Ingredient>& ingredient) {
+    for (const auto& purchase : solution.purchases) {
+        if (purchase.ingredient == ingredient) {
+            return purchase.quantity;
+        }
+    }
+    return 0.0;
+}
+
+} // namespace
+
+TEST(CostOptimizerTest, SolvesTwoFoodDiet) {
+    auto a = makeFood("A", 2.0, 4.0, 1.0);
+    auto b = makeFood("B", 3.0, 1.0, 5.0);
+    CostOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{a, b});
+
+    auto solution = optimizer.minimizeCost({{"protein", 8.0}, {"calories", 10.0}});
+
+    ASSERT_EQ(solution.status, CostOptimizer::Status::OPTIMAL);
+    EXPECT_NEAR(solution.totalCost, 156.0 / 19.0, 1e-9);
+    EXPECT_NEAR(amountOf(solution, a), 30.0 / 19.0, 1e-9);
+    EXPECT_NEAR(amountOf(solution, b), 32.0 / 19.0, 1e-9);
+    EXPECT_NEAR(solution.nutrients["protein"], 8.0, 1e-9);
+    // Both minimums bind; the dual prices reproduce the optimal cost
+    EXPECT_GT(solution.marginalCosts["protein"], 0.0);
+    EXPECT_NEAR(8.0 * solution.marginalCosts["protein"] + 10.0 * solution.marginalCosts["calories"],
+                solution.totalCost, 1e-9);
+}
+
+TEST(CostOptimizerTest, ReusesCachedSolutions) {
+    auto cache = std::make_shared<CostOptimizer::Cache>(16, 1);
+    auto a = makeFood("A", 2.0, 4.0, 1.0);
+    auto b = makeFood("B", 3.0, 1.0, 5.0);
+    const std::vector<CostOptimizer::NutrientTarget> targets = {{"protein", 8.0}, {"calories", 10.0}};
+    CostOptimizer first(std::vector<std::shared_ptr<Ingredient>>{a, b});
+    first.setCache(cache);
+    auto solved = first.minimizeCost(targets);
+    EXPECT_EQ(cache->getStats().misses, 1u);
+
+    // Another optimizer over the same foods gets the stored solution
+    CostOptimizer second(std::vector<std::shared_ptr<Ingredient>>{a, b});
+    second.setCache(cache);
+    auto reused = second.minimizeCost(targets);
+    EXPECT_EQ(cache->getStats().hits, 1u);
+    EXPECT_DOUBLE_EQ(reused.totalCost, solved.totalCost);
+    EXPECT_DOUBLE_EQ(amountOf(reused, a), amountOf(solved, a));
+
+    // A cap or a different target is a different request
+    second.addIngredient(makeFood("C", 1.0, 1.0, 1.0), 2.0);
+    second.minimizeCost(targets);
+    first.minimizeCost({{"protein", 9.0}, {"calories", 10.0}});
+    EXPECT_EQ(cache->getStats().misses, 3u);
+    EXPECT_EQ(cache->size(), 3u);
+}
+
+TEST(CostOptimizerTest, ScalesIngredientsAndRecipes) {
+    // 0.5 protein per gram at 0.01 per gram
+    auto beans = std::make_shared<Ingredient>("Beans", 200.0, Ingredient::Unit::GRAM);
+    beans->setUnitPrice(0.01);
+    beans->addNutritionalInfo("protein", 100.0);
+    CostOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{beans});
+
+    auto solution = optimizer.minimizeCost({{"protein", 30.0}});
+    ASSERT_EQ(solution.status, CostOptimizer::Status::OPTIMAL);
+    EXPECT_NEAR(amountOf(solution, beans), 60.0, 1e-9);
+    EXPECT_NEAR(solution.totalCost, 0.6, 1e-9);
+
+    // A recipe of 200 g beans serving 4 gives 25 protein per serving
+    auto stew = std::make_shared<Recipe>("Stew");
+    stew->addIngredient(beans);
+    stew->setServings(4);
+    CostOptimizer recipes(std::vector<std::shared_ptr<Recipe>>{stew});
+    auto servings = recipes.minimizeCost({{"protein", 50.0}});
+    ASSERT_EQ(servings.status, CostOptimizer::Status::OPTIMAL);
+    ASSERT_EQ(servings.purchases.size(), 1u);
+    EXPECT_EQ(servings.purchases[0].recipe, stew);
+    EXPECT_NEAR(servings.purchases[0].quantity, 50.0 / stew->getNutritionalInfo().at("protein"), 1e-9);
+}
+
+TEST(CostOptimizerTest, HonorsCapsAndMaximums) {
+    auto cheap = makeFood("Cheap", 1.0, 10.0, 500.0);
+    auto lean = makeFood("Lean", 4.0, 10.0, 100.0);
+    CostOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{cheap, lean});
+
+    // The calorie cap forces part of the protein to come from the lean food
+    auto solution = optimizer.minimizeCost({{"protein", 50.0}, {"calories", 0.0, 1500.0}});
+    ASSERT_EQ(solution.status, CostOptimizer::Status::OPTIMAL);
+    EXPECT_NEAR(amountOf(solution, cheap), 2.5, 1e-9);
+    EXPECT_NEAR(amountOf(solution, lean), 2.5, 1e-9);
+    EXPECT_LT(solution.marginalCosts["calories"], 0.0);
+
+    CostOptimizer capped(std::vector<std::shared_ptr<Ingredient>>{});
+    capped.addIngredient(cheap, 1.0);
+    capped.addIngredient(lean);
+    solution = capped.minimizeCost({{"protein", 50.0}});
+    ASSERT_EQ(solution.status, CostOptimizer::Status::OPTIMAL);
+    EXPECT_NEAR(amountOf(solution, cheap), 1.0, 1e-9);
+    EXPECT_NEAR(amountOf(solution, lean), 4.0, 1e-9);
+}
+
+TEST(CostOptimizerTest, DetectsInfeasibleTargets) {
+    CostOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{});
+    optimizer.addIngredient(makeFood("A", 1.0, 10.0, 500.0), 2.0);
+    EXPECT_EQ(optimizer.minimizeCost({{"protein", 30.0}}).status, CostOptimizer::Status::INFEASIBLE);
+    EXPECT_EQ(optimizer.minimizeCost({{"fiber", 1.0}}).status, CostOptimizer::Status::INFEASIBLE);
+    // Protein needs two units, which exceed the calorie cap
+    EXPECT_EQ(optimizer.minimizeCost({{"protein", 20.0}, {"calories", 0.0, 900.0}}).status,
+              CostOptimizer::Status::INFEASIBLE);
+}
+
+TEST(CostOptimizerTest, RandomDietsAreProvablyOptimal) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> price(0.5, 5.0);
+    std::uniform_real_distribution<double> amount(0.0, 20.0);
+    std::bernoulli_distribution has(0.4);
+    const std::vector<std::string> names{"n0", "n1", "n2", "n3", "n4", "n5", "n6", "n7"};
+
+    std::vector<std::shared_ptr<Ingredient>> foods;
+    for (int i = 0; i < 300; ++i) {
+        auto food = std::make_shared<Ingredient>("Food " + std::to_string(i), 1.0, Ingredient::Unit::PIECE);
+        food->setUnitPrice(price(rng));
+        for (const auto& name : names) {
+            if (has(rng)) {
+                food->addNutritionalInfo(name, amount(rng));
+            }
+        }
+        foods.push_back(food);
+    }
+    std::vector<CostOptimizer::NutrientTarget> targets;
+    for (std::size_t n = 0; n < names.size(); ++n) {
+        targets.push_back({names[n], 40.0 + 10.0 * n, n % 3 == 0 ? 90.0 + 10.0 * n : INFINITY});
+    }
+
+    CostOptimizer optimizer(foods);
+    auto solution = optimizer.minimizeCost(targets);
+    ASSERT_EQ(solution.status, CostOptimizer::Status::OPTIMAL);
+
+    // Primal feasibility
+    for (const auto& target : targets) {
+        EXPECT_GE(solution.nutrients[target.nutrient], target.minimum - 1e-6);
+        EXPECT_LE(solution.nutrients[target.nutrient], target.maximum + 1e-6);
+    }
+    // Dual feasibility: no food is cheaper than the nutrients it provides, at the dual prices
+    for (const auto& food : foods) {
+        double value = 0.0;
+        for (const auto& [nutrient, quantity] : food->getNutritionalInfo()) {
+            value += solution.marginalCosts[nutrient] * quantity;
+        }
+        EXPECT_LE(value, food->getUnitPrice() + 1e-7);
+    }
+    // Strong duality
+    double dual = 0.0;
+    for (const auto& target : targets) {
+        double price = solution.marginalCosts[target.nutrient];
+        if (price != 0.0) {
+            dual += price * (price > 0.0 ? target.minimum : target.maximum);
+        }
+    }
+    EXPECT_NEAR(dual, solution.totalCost, 1e-6 * solution.totalCost);
+}
+
+TEST(CostOptimizerTest, RejectsMalformedInput) {
+    CostOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{});
+    EXPECT_THROW(optimizer.addIngredient(nullptr), std::invalid_argument);
+    EXPECT_THROW(optimizer.addIngredient(makeFood("A", 1.0, 1.0, 1.0), -1.0), std::invalid_argument);
+    EXPECT_THROW(optimizer.minimizeCost({{"protein", 5.0, 1.0}}), std::invalid_argument);
+    EXPECT_THROW(optimizer.minimizeCost({{"protein", 1.0}, {"protein", 2.0}}), std::invalid_argument);
+    EXPECT_THROW(optimizer.minimizeCost({{"", 1.0}}), std::invalid_argument);
+}
+
+TEST(CostOptimizerTest, PricesPackTiers) {
+    PackOffer eggs("Corner shop", "Eggs", 6.0, Ingredient::Unit::PIECE, 2.0);
+    eggs.addPriceTier(4, 1.6);
+    eggs.addPriceTier(2, 1.8);
+    eggs.addPriceTier(4, 1.5);
+    ASSERT_EQ(eggs.getPriceTiers().size(), 2u);
+    EXPECT_EQ(eggs.getPriceTiers()[0].minPacks, 2);
+    EXPECT_DOUBLE_EQ(eggs.priceFor(0), 0.0);
+    EXPECT_DOUBLE_EQ(eggs.priceFor(1), 2.0);
+    EXPECT_DOUBLE_EQ(eggs.priceFor(3), 5.4);
+    EXPECT_DOUBLE_EQ(eggs.priceFor(5), 7.5);
+
+    eggs.setStock(4);
+    EXPECT_THROW(eggs.priceFor(5), std::invalid_argument);
+    EXPECT_THROW(eggs.addPriceTier(1, 1.0), std::invalid_argument);
+    EXPECT_THROW(PackOffer("", "Eggs", 6.0, Ingredient::Unit::PIECE, 2.0), std::invalid_argument);
+    EXPECT_THROW(PackOffer("Shop", "Eggs", 0.0, Ingredient::Unit::PIECE, 2.0), std::invalid_argument);
+}
+
+TEST(CostOptimizerTest, BuysCheapestPacksAcrossStores) {
+    CostOptimizer optimizer;
+    optimizer.addOffer(PackOffer("Market", "Flour", 1.0, Ingredient::Unit::KILOGRAM, 2.0));
+    optimizer.addOffer(PackOffer("Market", "Flour", 500.0, Ingredient::Unit::GRAM, 1.2));
+    optimizer.addOffer(PackOffer("Grocer", "flour", 250.0, Ingredient::Unit::GRAM, 0.55));
+    optimizer.addOffer(PackOffer("Grocer", "Flour", 1.0, Ingredient::Unit::LITER, 0.01));
+
+    // Two recipes' worth of flour add up to 1.2 kg; the volume offer does not apply
+    auto plan = optimizer.optimizePurchases({std::make_shared<Ingredient>("Flour", 700.0, Ingredient::Unit::GRAM),
+                                             std::make_shared<Ingredient>(" flour", 0.5, Ingredient::Unit::KILOGRAM)});
+
+    ASSERT_TRUE(plan.feasible);
+    ASSERT_EQ(plan.purchases.size(), 2u);
+    EXPECT_EQ(plan.purchases[0].offer.getStore(), "Market");
+    EXPECT_EQ(plan.purchases[0].packs, 1);
+    EXPECT_EQ(plan.purchases[1].offer.getStore(), "Grocer");
+    EXPECT_EQ(plan.purchases[1].packs, 1);
+    EXPECT_DOUBLE_EQ(plan.purchases[1].quantity, 250.0);
+    EXPECT_NEAR(plan.totalCost, 2.55, 1e-9);
+    EXPECT_NEAR(plan.storeCosts["Market"], 2.0, 1e-9);
+    EXPECT_NEAR(plan.storeCosts["Grocer"], 0.55, 1e-9);
+}
+
+TEST(CostOptimizerTest, UsesDiscountsAndStock) {
+    CostOptimizer optimizer;
+    PackOffer six("Market", "Eggs", 6.0, Ingredient::Unit::PIECE, 2.0);
+    six.addPriceTier(2, 1.5);
+    optimizer.addOffer(six);
+    optimizer.addOffer(PackOffer("Grocer", "Eggs", 12.0, Ingredient::Unit::PIECE, 3.3));
+
+    // Two discounted six-packs beat a dozen
+    auto plan = optimizer.optimizePurchases({std::make_shared<Ingredient>("Eggs", 10.0, Ingredient::Unit::PIECE)});
+    ASSERT_EQ(plan.purchases.size(), 1u);
+    EXPECT_EQ(plan.purchases[0].packs, 2);
+    EXPECT_NEAR(plan.totalCost, 3.0, 1e-9);
+
+    // With one six-pack left, the dozen is the only cover
+    CostOptimizer limited;
+    six.setStock(1);
+    limited.addOffer(six);
+    limited.addOffer(PackOffer("Grocer", "Eggs", 12.0, Ingredient::Unit::PIECE, 3.3));
+    plan = limited.optimizePurchases({std::make_shared<Ingredient>("Eggs", 10.0, Ingredient::Unit::PIECE),
+                                      std::make_shared<Ingredient>("Saffron", 1.0, Ingredient::Unit::GRAM)});
+    EXPECT_FALSE(plan.feasible);
+    ASSERT_EQ(plan.uncovered.size(), 1u);
+    EXPECT_EQ(plan.uncovered[0], "saffron");
+    ASSERT_EQ(plan.purchases.size(), 1u);
+    EXPECT_EQ(plan.purchases[0].offer.getStore(), "Grocer");
+    EXPECT_NEAR(plan.totalCost, 3.3, 1e-9);
+
+    EXPECT_THROW(optimizer.optimizePurchases({nullptr}), std::invalid_argument);
+}
+
+TEST(CostOptimizerTest, RandomPackPurchasesMatchEnumeration) {
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> sizeDist(1, 12);
+    std::uniform_int_distribution<int> demandDist(1, 4000);
+    std::uniform_real_distribution<double> priceDist(0.5, 5.0);
+
+    for (int round = 0; round < 40; ++round) {
+        const double needed = demandDist(rng);
+        std::vector<PackOffer> offers;
+        for (int o = 0; o < 3; ++o) {
+            PackOffer offer("Store " + std::to_string(o), "Rice", sizeDist(rng) * 125.0, Ingredient::Unit::GRAM,
+                            priceDist(rng));
+            if (rng() % 2) {
+                offer.addPriceTier(2 + static_cast<int>(rng() % 4), offer.getPackPrice() * 0.8);
+            }
+            if (rng() % 3 == 0) {
+                offer.setStock(static_cast<int>(rng() % 6));
+            }
+            offers.push_back(offer);
+        }
+
+        // Enumerate every combination of up to 40 packs per offer
+        double best = std::numeric_limits<double>::infinity();
+        const int cap[3] = {std::min(offers[0].getStock(), 40), std::min(offers[1].getStock(), 40),
+                            std::min(offers[2].getStock(), 40)};
+        for (int a = 0; a <= cap[0]; ++a) {
+            for (int b = 0; b <= cap[1]; ++b) {
+                for (int c = 0; c <= cap[2]; ++c) {
+                    const double quantity = a * offers[0].getPackSize() + b * offers[1].getPackSize() +
+                                            c * offers[2].getPackSize();
+                    if (quantity >= needed) {
+                        best = std::min(best, offers[0].priceFor(a) + offers[1].priceFor(b) + offers[2].priceFor(c));
+                    }
+                }
+            }
+        }
+
+        CostOptimizer optimizer;
+        for (const auto& offer : offers) {
+            optimizer.addOffer(offer);
+        }
+        auto plan = optimizer.optimizePurchases({std::make_shared<Ingredient>("Rice", needed, Ingredient::Unit::GRAM)});
+        ASSERT_EQ(plan.feasible, best != std::numeric_limits<double>::infinity()) << "round " << round;
+        if (!plan.feasible) {
+            continue;
+        }
+        EXPECT_NEAR(plan.totalCost, best, 1e-9) << "round " << round;
+        double quantity = 0.0;
+        for (const auto& purchase : plan.purchases) {
+            quantity += purchase.quantity;
+        }
+        EXPECT_GE(quantity, needed);
+    }
+}
+
+TEST(CostOptimizerTest, RepricesFromPriceHistory) {
+    CostOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{});
+    PackOffer rice("Market", "Rice", 1.0, Ingredient::Unit::KILOGRAM, 3.0);
+    rice.addPriceTier(3, 2.4);
+    optimizer.addOffer(rice);
+    optimizer.addOffer(PackOffer("Grocer", "Rice", 500.0, Ingredient::Unit::GRAM, 1.0));
+    auto oats = std::make_shared<Ingredient>("Oats", 1.0, Ingredient::Unit::KILOGRAM);
+    oats->setUnitPrice(9.0);
+    oats->addNutritionalInfo("fiber", 100.0);
+    optimizer.addIngredient(oats);
+
+    // Prices per gram; the Market's latest one halves its pack price
+    PriceHistory history;
+    const auto monday = std::chrono::system_clock::from_time_t(1700000000);
+    history.record("Rice", "Market", monday, 0.003);
+    history.record("Rice", "Market", monday + std::chrono::hours(24), 0.0015);
+    history.record("Oats", "Grocer", monday, 0.004);
+    history.record("Oats", "Market", monday, 0.005);
+    EXPECT_EQ(optimizer.applyPriceHistory(history), 2u);
+
+    auto plan = optimizer.optimizePurchases({std::make_shared<Ingredient>("Rice", 3.0, Ingredient::Unit::KILOGRAM)});
+    ASSERT_EQ(plan.purchases.size(), 1u);
+    EXPECT_EQ(plan.purchases[0].offer.getStore(), "Market");
+    EXPECT_EQ(plan.purchases[0].packs, 3);
+    EXPECT_NEAR(plan.totalCost, 3 * 1.2, 1e-9);
+
+    // Oats take the cheapest store's price, 4 per kilogram
+    auto solution = optimizer.minimizeCost({{"fiber", 50.0, std::numeric_limits<double>::infinity()}});
+    ASSERT_EQ(solution.status, CostOptimizer::Status::OPTIMAL);
+    EXPECT_NEAR(solution.totalCost, 2.0, 1e-9);
+}
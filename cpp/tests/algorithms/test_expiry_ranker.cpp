@@ -0,0 +1,271 @@
+#include <gtest/gtest.h>
+#include <smart_food/algorithms/expiry_ranker.hpp>
+#include <smart_food/core/storage.hpp>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <set>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+
+const Clock::time_point kNow = Clock::from_time_t(1700000000);
+
+Clock::time_point day(int offset) {
+    return kNow + std::chrono::hours(24 * offset);
+}
+
+std::shared_ptr<Ingredient> makeLot(const std::string& name, double quantity, Ingredient::Unit unit,
+                                    double unitPrice, Clock::time_point expiry = Clock::time_point{}) {
+    auto lot = std::make_shared<Ingredient>(name, quantity, unit);
+    lot->setUnitPrice(unitPrice);
+    lot->setExpiryDate(expiry);
+    return lot;
+}
+
+std::shared_ptr<Recipe> makeRecipe(const std::string& name, const std::vector<std::string>& ingredients) {
+    auto recipe = std::make_shared<Recipe>(name);
+    for (const auto& ingredient : ingredients) {
+        recipe->addIngredient(makeLot(ingredient, 100.0, Ingredient::Unit::GRAM, 0.0));
+    }
+    return recipe;
+}
+
+/// Score every recipe directly from its ingredient names, as rank() should
+std::vector<std::pair<std::string, double>> bruteForce(const std::vector<std::shared_ptr<Recipe>>& recipes,
+                                                       const std::map<std::string, double>& atRisk,
+                                                       std::size_t limit) {
+    std::vector<std::tuple<double, std::size_t, std::size_t>> scored;
+    for (std::size_t r = 0; r < recipes.size(); ++r) {
+        std::set<std::string> names;
+        for (const auto& ingredient : recipes[r]->getIngredients()) {
+            names.insert(IngredientIndex::normalizeName(ingredient->getName()));
+        }
+        double value = 0.0;
+        std::size_t count = 0;
+        for (const auto& name : names) {
+            auto it = atRisk.find(name);
+            if (it != atRisk.end()) {
+                value += it->second;
+                ++count;
+            }
+        }
+        if (count > 0) {
+            scored.emplace_back(-value, static_cast<std::size_t>(0) - count, r);
+        }
+    }
+    std::sort(scored.begin(), scored.end());
+    std::vector<std::pair<std::string, double>> best;
+    for (std::size_t i = 0; i < std::min(limit, scored.size()); ++i) {
+        best.emplace_back(recipes[std::get<2>(scored[i])]->getId(), -std::get<0>(scored[i]));
+    }
+    return best;
+}
+
+/// Random catalog over `names` ingredients and a pantry dating some of them
+void makeCatalog(int recipes, int names, unsigned seed, std::vector<std::shared_ptr<Recipe>>& catalog,
+                 std::vector<std::shared_ptr<Ingredient>>& pantry, std::map<std::string, double>& atRisk) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, names - 1);
+    std::uniform_int_distribution<int> size(3, 9);
+    std::uniform_int_distribution<int> shelfLife(-2, 10);
+    for (int r = 0; r < recipes; ++r) {
+        std::vector<std::string> ingredients;
+        for (int i = size(rng); i > 0; --i) {
+            ingredients.push_back("Item " + std::to_string(pick(rng)));
+        }
+        catalog.push_back(makeRecipe("Recipe " + std::to_string(r), ingredients));
+    }
+    for (int n = 0; n < names; n += 2) {
+        const int life = shelfLife(rng);
+        const double grams = 100.0 + n;
+        pantry.push_back(makeLot("Item " + std::to_string(n), grams, Ingredient::Unit::GRAM, 0.01, day(life)));
+        if (life >= 0 && life <= 3) {
+            atRisk["item " + std::to_string(n)] += grams * 0.01;
+        }
+    }
+}
+
+std::vector<std::pair<std::string, double>> ids(const std::vector<ExpiryRanker::Match>& matches) {
+    std::vector<std::pair<std::string, double>> result;
+    for (const auto& match : matches) {
+        result.emplace_back(match.recipe->getId(), match.atRiskValue);
+    }
+    return result;
+}
+
+void expectSameRanking(const std::vector<std::pair<std::string, double>>& actual,
+                       const std::vector<std::pair<std::string, double>>& expected) {
+    ASSERT_EQ(actual.size(), expected.size());
+    for (std::size_t i = 0; i < actual.size(); ++i) {
+        EXPECT_NEAR(actual[i].second, expected[i].second, 1e-9) << "at " << i;
+    }
+    // Ids may differ within ties of value, which may also straddle the limit
+    for (std::size_t i = 0; i + 1 < actual.size(); ++i) {
+        if ((i == 0 || expected[i - 1].second - expected[i].second > 1e-9) &&
+            expected[i].second - expected[i + 1].second > 1e-9) {
+            EXPECT_EQ(actual[i].first, expected[i].first) << "at " << i;
+        }
+    }
+}
+
+} // namespace
+
+TEST(ExpiryRankerTest, RanksByValueAtRisk) {
+    auto omelette = makeRecipe("Omelette", {"Eggs", "Milk", "Cheese"});
+    auto pancakes = makeRecipe("Pancakes", {"eggs", "Flour", " milk"});
+    auto salad = makeRecipe("Salad", {"Lettuce", "Tomato"});
+    auto toast = makeRecipe("Toast", {"Bread", "Cheese"});
+    ExpiryRanker ranker({omelette, pancakes, salad, toast});
+    EXPECT_EQ(ranker.getRecipeCount(), 4u);
+    EXPECT_TRUE(ranker.rank(10).empty());
+
+    // Recipe ingredients are weighed, so the pantry must be too to share their identities
+    ranker.setPantry({makeLot("Milk", 1.0, Ingredient::Unit::KILOGRAM, 1.0, day(1)),     // 1.00 at risk
+                      makeLot("Cheese", 200.0, Ingredient::Unit::GRAM, 0.02, day(2)),    // 4.00 at risk
+                      makeLot("Eggs", 300.0, Ingredient::Unit::GRAM, 0.01, day(30)),     // keeps
+                      makeLot("Lettuce", 300.0, Ingredient::Unit::GRAM, 0.01, day(-1)),  // already gone
+                      makeLot("Bread", 500.0, Ingredient::Unit::GRAM, 0.01)},            // no date
+                     kNow, std::chrono::hours(72));
+    EXPECT_EQ(ranker.getAtRiskCount(), 2u);
+
+    auto matches = ranker.rank(10);
+    ASSERT_EQ(matches.size(), 3u);
+    EXPECT_EQ(matches[0].recipe, omelette);
+    EXPECT_NEAR(matches[0].atRiskValue, 5.0, 1e-9);
+    EXPECT_EQ(matches[0].atRiskIngredients, 2u);
+    EXPECT_EQ(matches[1].recipe, toast);
+    EXPECT_NEAR(matches[1].atRiskValue, 4.0, 1e-9);
+    EXPECT_EQ(matches[2].recipe, pancakes);
+    EXPECT_NEAR(matches[2].atRiskValue, 1.0, 1e-9);
+
+    matches = ranker.rank(1);
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].recipe, omelette);
+
+    // A shorter horizon leaves only the milk at risk
+    ranker.setPantry({makeLot("Milk", 1.0, Ingredient::Unit::KILOGRAM, 1.0, day(1)),
+                      makeLot("Cheese", 200.0, Ingredient::Unit::GRAM, 0.02, day(2))},
+                     kNow, std::chrono::hours(24));
+    matches = ranker.rank(10);
+    ASSERT_EQ(matches.size(), 2u);
+    EXPECT_EQ(matches[0].recipe, omelette);  // Ties on value go to the recipe added first
+    EXPECT_EQ(matches[1].recipe, pancakes);
+}
+
+TEST(ExpiryRankerTest, MatchesBruteForceAcrossManyIdentities) {
+    // 300 ingredient names stock 150 identities: three words per bitset
+    std::vector<std::shared_ptr<Recipe>> catalog;
+    std::vector<std::shared_ptr<Ingredient>> pantry;
+    std::map<std::string, double> atRisk;
+    makeCatalog(2000, 300, 7, catalog, pantry, atRisk);
+
+    ExpiryRanker ranker(catalog);
+    ranker.setPantry(pantry, kNow);
+    EXPECT_EQ(ranker.getAtRiskCount(), atRisk.size());
+    expectSameRanking(ids(ranker.rank(50)), bruteForce(catalog, atRisk, 50));
+    expectSameRanking(ids(ranker.rank(5000)), bruteForce(catalog, atRisk, 5000));
+}
+
+TEST(ExpiryRankerTest, IncrementalUpdatesMatchFreshBuild) {
+    std::vector<std::shared_ptr<Recipe>> catalog;
+    std::vector<std::shared_ptr<Ingredient>> pantry;
+    std::map<std::string, double> atRisk;
+    makeCatalog(1000, 200, 11, catalog, pantry, atRisk);
+
+    // Start with half the catalog and a small pantry, then grow both
+    ExpiryRanker ranker(std::vector<std::shared_ptr<Recipe>>(catalog.begin(), catalog.begin() + 500));
+    ranker.setPantry(std::vector<std::shared_ptr<Ingredient>>(pantry.begin(), pantry.begin() + 10), kNow);
+    for (std::size_t r = 500; r < catalog.size(); ++r) {
+        ranker.addRecipe(catalog[r]);
+    }
+    ranker.setPantry(pantry, kNow);
+    expectSameRanking(ids(ranker.rank(100)), bruteForce(catalog, atRisk, 100));
+
+    // Remove every third recipe and replace one with a different recipe under the same ID
+    std::vector<std::shared_ptr<Recipe>> kept;
+    for (std::size_t r = 0; r < catalog.size(); ++r) {
+        if (r % 3 == 0) {
+            EXPECT_TRUE(ranker.removeRecipe(catalog[r]->getId()));
+        } else {
+            kept.push_back(catalog[r]);
+        }
+    }
+    EXPECT_FALSE(ranker.removeRecipe(catalog[0]->getId()));
+    EXPECT_EQ(ranker.getRecipeCount(), kept.size());
+    expectSameRanking(ids(ranker.rank(100)), bruteForce(kept, atRisk, 100));
+
+    auto replacement = std::make_shared<Recipe>(*kept[0]);
+    for (const auto& ingredient : kept[0]->getIngredients()) {
+        replacement->removeIngredient(ingredient->getId());
+    }
+    replacement->addIngredient(makeLot("Unknown", 1.0, Ingredient::Unit::GRAM, 0.0));
+    ranker.addRecipe(replacement);
+    kept[0] = replacement;
+    EXPECT_EQ(ranker.getRecipeCount(), kept.size());
+
+    // Shrink the pantry to a few identities so stale bits get compacted away
+    std::vector<std::shared_ptr<Ingredient>> small(pantry.begin(), pantry.begin() + 5);
+    std::map<std::string, double> smallRisk;
+    for (const auto& lot : small) {
+        auto name = IngredientIndex::normalizeName(lot->getName());
+        if (atRisk.count(name)) {
+            smallRisk[name] = atRisk[name];
+        }
+    }
+    ranker.setPantry(small, kNow);
+    EXPECT_EQ(ranker.getAtRiskCount(), smallRisk.size());
+    expectSameRanking(ids(ranker.rank(100)), bruteForce(kept, smallRisk, 100));
+
+    ExpiryRanker fresh(kept);
+    fresh.setPantry(small, kNow);
+    expectSameRanking(ids(ranker.rank(100)), ids(fresh.rank(100)));
+}
+
+TEST(ExpiryRankerTest, FollowsStorageBetweenRefreshes) {
+    auto& storage = Storage::getInstance();
+    storage.clear();
+    auto omelette = makeRecipe("Omelette", {"Eggs", "Cheese"});
+    auto toast = makeRecipe("Toast", {"Bread", "Cheese"});
+    storage.addRecipe(omelette);
+    storage.addIngredient(makeLot("Cheese", 200.0, Ingredient::Unit::GRAM, 0.02, day(1)));
+
+    ExpiryRanker ranker;
+    EXPECT_EQ(ranker.getRecipeCount(), 1u);
+    EXPECT_FALSE(ranker.refresh(kNow));
+    auto matches = ranker.rank(10);
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].recipe, omelette);
+
+    // Each Storage change is picked up by the next refresh only
+    storage.addRecipe(toast);
+    EXPECT_TRUE(ranker.refresh(kNow));
+    EXPECT_FALSE(ranker.refresh(kNow));
+    EXPECT_EQ(ranker.rank(10).size(), 2u);
+    storage.removeRecipe(omelette->getId());
+    EXPECT_TRUE(ranker.refresh(kNow));
+    matches = ranker.rank(10);
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].recipe, toast);
+
+    // So are pantry changes
+    storage.addIngredient(makeLot("Bread", 500.0, Ingredient::Unit::GRAM, 0.01, day(2)));
+    EXPECT_TRUE(ranker.refresh(kNow));
+    EXPECT_EQ(ranker.getAtRiskCount(), 2u);
+    storage.clear();
+    EXPECT_TRUE(ranker.refresh(kNow));
+    EXPECT_EQ(ranker.getRecipeCount(), 0u);
+}
+
+TEST(ExpiryRankerTest, RejectsInvalidInput) {
+    EXPECT_THROW(ExpiryRanker({nullptr}), std::invalid_argument);
+    ExpiryRanker ranker({makeRecipe("Toast", {"Bread"})});
+    EXPECT_THROW(ranker.addRecipe(nullptr), std::invalid_argument);
+    EXPECT_THROW(ranker.setPantry({nullptr}, kNow), std::invalid_argument);
+    EXPECT_THROW(ranker.setPantry({}, kNow, std::chrono::hours(-1)), std::invalid_argument);
+    EXPECT_TRUE(ranker.rank(0).empty());
+}
@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include <smart_food/algorithms/feasibility_engine.hpp>
+#include <smart_food/core/storage.hpp>
+#include <map>
+#include <random>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+
+const Clock::time_point kNow = Clock::from_time_t(1700000000);
+
+std::shared_ptr<Ingredient> makeLot(const std::string& name, double quantity, Ingredient::Unit unit,
+                                    Clock::time_point expiry = Clock::time_point{}) {
+    auto lot = std::make_shared<Ingredient>(name, quantity, unit);
+    lot->setExpiryDate(expiry);
+    return lot;
+}
+
+std::shared_ptr<Recipe> makeRecipe(const std::string& name, int servings,
+                                   const std::vector<std::shared_ptr<Ingredient>>& ingredients) {
+    auto recipe = std::make_shared<Recipe>(name);
+    recipe->setServings(servings);
+    for (const auto& ingredient : ingredients) {
+        recipe->addIngredient(ingredient);
+    }
+    return recipe;
+}
+
+} // namespace
+
+TEST(FeasibilityEngineTest, ComparesQuantitiesAfterUnitConversion) {
+    auto pancakes = makeRecipe("Pancakes", 2,
+                               {makeLot("Flour", 250.0, Ingredient::Unit::GRAM),
+                                makeLot("Eggs", 2.0, Ingredient::Unit::PIECE),
+                                makeLot("Milk", 300.0, Ingredient::Unit::MILLILITER)});
+    auto toast = makeRecipe("Toast", 1, {makeLot("Bread", 2.0, Ingredient::Unit::PIECE)});
+    FeasibilityEngine engine({pancakes, toast});
+    EXPECT_EQ(engine.getRecipeCount(), 2u);
+    EXPECT_TRUE(engine.getCookable().empty());
+
+    engine.setPantry({makeLot("flour", 1.0, Ingredient::Unit::KILOGRAM),
+                      makeLot("Eggs", 1.0, Ingredient::Unit::PIECE),
+                      makeLot("Eggs", 6.0, Ingredient::Unit::PIECE, kNow - std::chrono::hours(1)),  // expired
+                      makeLot("Milk", 0.3, Ingredient::Unit::LITER, kNow + std::chrono::hours(48)),
+                      makeLot("Bread", 4.0, Ingredient::Unit::PIECE)},
+                     kNow);
+    EXPECT_FALSE(engine.isCookable(pancakes->getId()));
+    EXPECT_TRUE(engine.isCookable(toast->getId()));
+    auto shortfalls = engine.getShortfalls(pancakes->getId());
+    ASSERT_EQ(shortfalls.size(), 1u);
+    EXPECT_EQ(shortfalls[0].ingredient, "eggs");
+    EXPECT_EQ(shortfalls[0].unit, Ingredient::Unit::PIECE);
+    EXPECT_NEAR(shortfalls[0].quantity, 1.0, 1e-9);
+
+    engine.addStock(*makeLot("eggs", 1.0, Ingredient::Unit::PIECE));
+    EXPECT_TRUE(engine.isCookable(pancakes->getId()));
+    EXPECT_EQ(engine.getCookable().size(), 2u);
+
+    // Four servings double the pancakes and toast for four needs 8 slices
+    engine.setServings(4);
+    auto results = engine.evaluate();
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[0].recipe, pancakes);
+    EXPECT_FALSE(results[0].cookable);
+    ASSERT_EQ(results[0].shortfalls.size(), 2u);
+    EXPECT_EQ(results[0].shortfalls[0].ingredient, "eggs");
+    EXPECT_NEAR(results[0].shortfalls[0].quantity, 2.0, 1e-9);
+    EXPECT_EQ(results[0].shortfalls[1].ingredient, "milk");
+    EXPECT_NEAR(results[0].shortfalls[1].quantity, 300.0, 1e-9);
+    EXPECT_FALSE(results[1].cookable);
+    EXPECT_NEAR(results[1].shortfalls[0].quantity, 4.0, 1e-9);
+
+    engine.setServings(0);
+    EXPECT_EQ(engine.getCookable().size(), 2u);
+    engine.removeStock(*makeLot("Flour", 800.0, Ingredient::Unit::GRAM));
+    EXPECT_NEAR(engine.getStock("FLOUR", Ingredient::Unit::GRAM), 200.0, 1e-9);
+    EXPECT_FALSE(engine.isCookable(pancakes->getId()));
+    engine.removeStock(*makeLot("Flour", 1.0, Ingredient::Unit::KILOGRAM));
+    EXPECT_EQ(engine.getStock("Flour", Ingredient::Unit::GRAM), 0.0);
+}
+
+TEST(FeasibilityEngineTest, IncrementalUpdatesMatchBruteForce) {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> pick(0, 29);
+    std::uniform_int_distribution<int> size(1, 6);
+    std::uniform_int_distribution<int> servings(1, 4);
+    std::uniform_int_distribution<int> grams(1, 20);
+    auto name = [](int n) { return "Item " + std::to_string(n); };
+
+    std::vector<std::shared_ptr<Recipe>> catalog;
+    for (int r = 0; r < 400; ++r) {
+        std::vector<std::shared_ptr<Ingredient>> ingredients;
+        for (int i = size(rng); i > 0; --i) {
+            ingredients.push_back(makeLot(name(pick(rng)), 50.0 * grams(rng), Ingredient::Unit::GRAM));
+        }
+        catalog.push_back(makeRecipe("Recipe " + std::to_string(r), servings(rng), ingredients));
+    }
+    // Half the catalog up front, the rest one by one
+    FeasibilityEngine engine(std::vector<std::shared_ptr<Recipe>>(catalog.begin(), catalog.begin() + 200), 2);
+    for (std::size_t r = 200; r < catalog.size(); ++r) {
+        engine.addRecipe(catalog[r]);
+    }
+
+    std::map<std::string, double> stock;
+    auto check = [&](int servingCount) {
+        std::size_t cookable = 0;
+        for (const auto& recipe : catalog) {
+            std::map<std::string, double> needs;
+            for (const auto& ingredient : recipe->getIngredients()) {
+                needs[IngredientIndex::normalizeName(ingredient->getName())] += ingredient->getQuantity();
+            }
+            const double scale = servingCount == 0 ? 1.0 : static_cast<double>(servingCount) / recipe->getServings();
+            bool expected = true;
+            for (const auto& need : needs) {
+                expected = expected && need.second * scale <= stock[need.first] + 1e-9;
+            }
+            ASSERT_EQ(engine.isCookable(recipe->getId()), expected) << recipe->getName();
+            cookable += expected ? 1 : 0;
+        }
+        EXPECT_EQ(engine.getCookable().size(), cookable);
+    };
+
+    for (int step = 0; step < 300; ++step) {
+        const int n = pick(rng);
+        const double quantity = 100.0 * grams(rng);
+        if (step % 50 == 49) {
+            // Replace the whole pantry
+            std::vector<std::shared_ptr<Ingredient>> pantry;
+            stock.clear();
+            for (int i = 0; i < 40; ++i) {
+                const int item = pick(rng);
+                const double amount = 100.0 * grams(rng);
+                pantry.push_back(makeLot(name(item), amount, Ingredient::Unit::GRAM));
+                stock["item " + std::to_string(item)] += amount;
+            }
+            engine.setPantry(pantry, kNow);
+        } else if (step % 3 == 2) {
+            engine.removeStock(*makeLot(name(n), quantity, Ingredient::Unit::GRAM));
+            auto& level = stock["item " + std::to_string(n)];
+            level = std::max(0.0, level - quantity);
+        } else {
+            engine.addStock(*makeLot(name(n), quantity, Ingredient::Unit::GRAM));
+            stock["item " + std::to_string(n)] += quantity;
+        }
+        if (step % 25 == 0) {
+            check(2);
+        }
+    }
+    check(2);
+    engine.setServings(3);
+    check(3);
+    engine.setServings(0);
+    check(0);
+}
+
+TEST(FeasibilityEngineTest, TracksCatalogChanges) {
+    auto soup = makeRecipe("Soup", 1, {makeLot("Carrot", 3.0, Ingredient::Unit::PIECE)});
+    auto salad = makeRecipe("Salad", 1, {makeLot("Carrot", 1.0, Ingredient::Unit::PIECE)});
+    FeasibilityEngine engine({soup, salad});
+    engine.addStock(*makeLot("Carrot", 2.0, Ingredient::Unit::PIECE));
+    EXPECT_EQ(engine.getCookable(), std::vector<std::shared_ptr<Recipe>>{salad});
+
+    // A lighter soup under the same ID replaces the old one
+    auto lighter = std::make_shared<Recipe>(*soup);
+    lighter->removeIngredient(soup->getIngredients()[0]->getId());
+    lighter->addIngredient(makeLot("Carrot", 2.0, Ingredient::Unit::PIECE));
+    engine.addRecipe(lighter);
+    EXPECT_EQ(engine.getRecipeCount(), 2u);
+    EXPECT_EQ(engine.getCookable(), (std::vector<std::shared_ptr<Recipe>>{salad, lighter}));
+
+    EXPECT_TRUE(engine.removeRecipe(salad->getId()));
+    EXPECT_FALSE(engine.removeRecipe(salad->getId()));
+    EXPECT_THROW(engine.isCookable(salad->getId()), std::out_of_range);
+    EXPECT_THROW(engine.getShortfalls("missing"), std::out_of_range);
+    EXPECT_EQ(engine.getCookable(), std::vector<std::shared_ptr<Recipe>>{lighter});
+    engine.removeStock(*makeLot("Carrot", 1.0, Ingredient::Unit::PIECE));
+    EXPECT_TRUE(engine.getCookable().empty());
+}
+
+TEST(FeasibilityEngineTest, FollowsStorageBetweenRefreshes) {
+    auto& storage = Storage::getInstance();
+    storage.clear();
+    auto soup = makeRecipe("Soup", 1, {makeLot("Carrot", 3.0, Ingredient::Unit::PIECE)});
+    auto salad = makeRecipe("Salad", 1, {makeLot("Carrot", 1.0, Ingredient::Unit::PIECE)});
+    auto carrots = makeLot("Carrot", 2.0, Ingredient::Unit::PIECE);
+    storage.addRecipe(soup);
+    storage.addIngredient(carrots);
+
+    FeasibilityEngine engine;
+    EXPECT_FALSE(engine.refresh(kNow));
+    EXPECT_TRUE(engine.getCookable().empty());
+
+    // Each Storage change is picked up by the next refresh only
+    storage.addRecipe(salad);
+    EXPECT_TRUE(engine.refresh(kNow));
+    EXPECT_FALSE(engine.refresh(kNow));
+    EXPECT_EQ(engine.getCookable(), std::vector<std::shared_ptr<Recipe>>{salad});
+    storage.addIngredient(makeLot("Carrot", 1.0, Ingredient::Unit::PIECE));
+    EXPECT_TRUE(engine.refresh(kNow));
+    EXPECT_EQ(engine.getCookable().size(), 2u);
+    storage.removeRecipe(salad->getId());
+    EXPECT_TRUE(engine.refresh(kNow));
+    EXPECT_EQ(engine.getCookable(), std::vector<std::shared_ptr<Recipe>>{soup});
+    storage.clear();
+    EXPECT_TRUE(engine.refresh(kNow));
+    EXPECT_EQ(engine.getRecipeCount(), 0u);
+}
+
+TEST(FeasibilityEngineTest, RejectsInvalidInput) {
+    EXPECT_THROW(FeasibilityEngine({nullptr}), std::invalid_argument);
+    EXPECT_THROW(FeasibilityEngine(std::vector<std::shared_ptr<Recipe>>{}, -1), std::invalid_argument);
+    FeasibilityEngine engine(std::vector<std::shared_ptr<Recipe>>{});
+    EXPECT_THROW(engine.addRecipe(nullptr), std::invalid_argument);
+    EXPECT_THROW(engine.setServings(-2), std::invalid_argument);
+    EXPECT_THROW(engine.setPantry({nullptr}, kNow), std::invalid_argument);
+}
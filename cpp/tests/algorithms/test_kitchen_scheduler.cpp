@@ -0,0 +1,320 @@
+#include <gtest/gtest.h>
+#include <smart_food/algorithms/kitchen_scheduler.hpp>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+using std::chrono::minutes;
+
+Recipe::Step makeStep(int order, int duration, std::map<std::string, int> resources,
+                      std::optional<std::vector<int>> dependsOn = std::nullopt) {
+    return Recipe::Step{order, "Step " + std::to_string(order), minutes(duration), std::move(dependsOn),
+                        std::move(resources)};
+}
+
+/// Check dependencies, durations and capacities of a timeline
+void expectValid(const KitchenScheduler& scheduler, const std::vector<std::shared_ptr<Recipe>>& batch,
+                 const KitchenScheduler::Timeline& timeline) {
+    std::map<std::pair<std::size_t, std::size_t>, KitchenScheduler::ScheduledStep> placed;
+    for (const auto& entry : timeline.steps) {
+        placed[{entry.recipe, entry.step}] = entry;
+    }
+    std::size_t total = 0;
+    std::map<std::string, std::vector<int>> usage;
+    for (std::size_t b = 0; b < batch.size(); ++b) {
+        const auto& steps = batch[b]->getSteps();
+        total += steps.size();
+        for (std::size_t i = 0; i < steps.size(); ++i) {
+            const auto& entry = placed.at({b, i});
+            EXPECT_EQ(entry.end - entry.start, steps[i].duration);
+            EXPECT_LE(entry.end, timeline.makespan);
+            EXPECT_LE(entry.end, timeline.finish[b]);
+            for (auto dependency : batch[b]->getStepDependencies(i)) {
+                EXPECT_GE(entry.start, placed.at({b, dependency}).end);
+            }
+            auto resources = steps[i].resources.empty() ? std::map<std::string, int>{{"hands", 1}} : steps[i].resources;
+            for (const auto& resource : resources) {
+                auto& used = usage[resource.first];
+                used.resize(std::max<std::size_t>(used.size(), entry.end.count()), 0);
+                for (auto m = entry.start.count(); m < entry.end.count(); ++m) {
+                    used[m] += resource.second;
+                }
+            }
+        }
+    }
+    EXPECT_EQ(timeline.steps.size(), total);
+    for (const auto& resource : usage) {
+        for (int used : resource.second) {
+            EXPECT_LE(used, scheduler.getCapacities().at(resource.first)) << resource.first;
+        }
+    }
+    EXPECT_LE(timeline.lowerBound, timeline.makespan);
+}
+
+/// Shortest makespan over every dependency-respecting placement order, each task placed as early as possible
+int bruteForce(const std::vector<std::shared_ptr<Recipe>>& batch, const std::map<std::string, int>& capacities) {
+    struct Task {
+        int duration;
+        std::map<std::string, int> resources;
+        std::vector<std::size_t> before;
+    };
+    std::vector<Task> tasks;
+    for (const auto& recipe : batch) {
+        const std::size_t first = tasks.size();
+        for (std::size_t i = 0; i < recipe->getSteps().size(); ++i) {
+            Task task{static_cast<int>(recipe->getSteps()[i].duration.count()), recipe->getSteps()[i].resources, {}};
+            for (auto dependency : recipe->getStepDependencies(i)) {
+                task.before.push_back(first + dependency);
+            }
+            tasks.push_back(task);
+        }
+    }
+    std::vector<std::size_t> order(tasks.size());
+    std::iota(order.begin(), order.end(), 0);
+    int best = std::numeric_limits<int>::max();
+    do {
+        std::vector<int> end(tasks.size(), -1);
+        std::map<std::string, std::vector<int>> usage;
+        int makespan = 0;
+        bool valid = true;
+        for (auto a : order) {
+            int start = 0;
+            for (auto dependency : tasks[a].before) {
+                valid = valid && end[dependency] >= 0;
+                start = std::max(start, end[dependency]);
+            }
+            if (!valid) {
+                break;
+            }
+            for (bool fits = false; !fits; fits = fits || (++start, false)) {
+                fits = true;
+                for (const auto& resource : tasks[a].resources) {
+                    auto& used = usage[resource.first];
+                    used.resize(std::max<std::size_t>(used.size(), start + tasks[a].duration + 1), 0);
+                    for (int m = start; m < start + tasks[a].duration; ++m) {
+                        fits = fits && used[m] + resource.second <= capacities.at(resource.first);
+                    }
+                }
+            }
+            for (const auto& resource : tasks[a].resources) {
+                for (int m = start; m < start + tasks[a].duration; ++m) {
+                    usage[resource.first][m] += resource.second;
+                }
+            }
+            end[a] = start + tasks[a].duration;
+            makespan = std::max(makespan, end[a]);
+        }
+        if (valid) {
+            best = std::min(best, makespan);
+        }
+    } while (std::next_permutation(order.begin(), order.end()));
+    return best;
+}
+
+/// Recipes of six steps each using the oven, a burner and hands, or hands alone
+std::vector<std::shared_ptr<Recipe>> largeBatch(int recipes) {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> length(2, 40);
+    std::uniform_int_distribution<int> kind(0, 3);
+    std::vector<std::shared_ptr<Recipe>> batch;
+    for (int r = 0; r < recipes; ++r) {
+        auto recipe = std::make_shared<Recipe>("Recipe " + std::to_string(r));
+        for (int s = 1; s <= 6; ++s) {
+            const int k = kind(rng);
+            std::map<std::string, int> needs = k == 0 ? std::map<std::string, int>{{"oven", 1}}
+                                             : k == 1 ? std::map<std::string, int>{{"burner", 1}, {"hands", 1}}
+                                                      : std::map<std::string, int>{{"hands", 1}};
+            recipe->addStep(makeStep(s, length(rng), needs));
+        }
+        batch.push_back(recipe);
+    }
+    return batch;
+}
+
+} // namespace
+
+TEST(KitchenSchedulerTest, StepDependenciesShapeTotalTime) {
+    Recipe pasta("Pasta");
+    pasta.addStep(makeStep(1, 10, {{"burner", 1}}));                // Boil water
+    pasta.addStep(makeStep(2, 12, {{"burner", 1}}));                // Cook pasta, after the water
+    pasta.addStep(makeStep(3, 15, {{"hands", 1}}, std::vector<int>{}));  // Make the sauce meanwhile
+    pasta.addStep(makeStep(4, 3, {{"hands", 1}}, std::vector<int>{2, 3}));
+    EXPECT_EQ(pasta.getTotalTime(), minutes(25));
+    EXPECT_EQ(pasta.getStepDependencies(1), (std::vector<std::size_t>{0}));
+    EXPECT_TRUE(pasta.getStepDependencies(2).empty());
+    EXPECT_EQ(pasta.getStepDependencies(3), (std::vector<std::size_t>{1, 2}));
+
+    EXPECT_THROW(pasta.addStep(makeStep(5, 1, {}, std::vector<int>{5})), std::invalid_argument);
+    EXPECT_THROW(pasta.addStep(makeStep(5, 1, {}, std::vector<int>{9})), std::invalid_argument);
+    EXPECT_THROW(pasta.addStep(makeStep(5, -1, {})), std::invalid_argument);
+    EXPECT_THROW(pasta.addStep(makeStep(5, 1, {{"oven", 0}})), std::invalid_argument);
+    EXPECT_THROW(pasta.reorderStep(4, 1), std::invalid_argument);
+
+    // Dependencies survive serialization and follow steps that move
+    Recipe copy = Recipe::deserialize(pasta.serialize());
+    EXPECT_EQ(copy.getTotalTime(), minutes(25));
+    EXPECT_EQ(copy.getSteps()[3].resources, (std::map<std::string, int>{{"hands", 1}}));
+    pasta.addStep(makeStep(1, 5, {{"hands", 1}}));  // Fetch pots, first of all
+    EXPECT_EQ(pasta.getSteps()[4].dependsOn, (std::vector<int>{3, 4}));
+    EXPECT_EQ(pasta.getTotalTime(), minutes(30));
+
+    // Removing the water makes the pasta follow the pots, and the sauce step keeps its place
+    pasta.removeStep(2);
+    EXPECT_EQ(pasta.getSteps()[3].dependsOn, (std::vector<int>{2, 3}));
+    EXPECT_EQ(pasta.getTotalTime(), minutes(20));
+    pasta.reorderStep(3, 2);
+    EXPECT_EQ(pasta.getSteps()[3].dependsOn, (std::vector<int>{3, 2}));
+    EXPECT_EQ(pasta.getStepDependencies(3), (std::vector<std::size_t>{1, 2}));
+}
+
+TEST(KitchenSchedulerTest, OverlapsRecipesAroundSharedResources) {
+    // Prepare by hand, then bake unattended: the second prep overlaps the first bake
+    std::vector<std::shared_ptr<Recipe>> batch;
+    for (const char* name : {"Lasagna", "Gratin"}) {
+        auto recipe = std::make_shared<Recipe>(name);
+        recipe->addStep(makeStep(1, 10, {{"hands", 1}}));
+        recipe->addStep(makeStep(2, 30, {{"oven", 1}}));
+        batch.push_back(recipe);
+    }
+    KitchenScheduler scheduler({{"hands", 1}, {"oven", 1}});
+    auto timeline = scheduler.schedule(batch);
+    expectValid(scheduler, batch, timeline);
+    EXPECT_EQ(timeline.makespan, minutes(70));
+    EXPECT_TRUE(timeline.optimal);
+    EXPECT_EQ(std::min(timeline.finish[0], timeline.finish[1]), minutes(40));
+
+    // A second oven bakes both at once
+    KitchenScheduler bigger({{"hands", 1}, {"oven", 2}});
+    timeline = bigger.schedule(batch);
+    expectValid(bigger, batch, timeline);
+    EXPECT_EQ(timeline.makespan, minutes(50));
+    EXPECT_TRUE(timeline.optimal);
+
+    // Steps listing no resources take a pair of hands by default
+    auto salad = std::make_shared<Recipe>("Salad");
+    salad->addStep(makeStep(1, 5, {}));
+    salad->addStep(makeStep(2, 5, {}));
+    timeline = scheduler.schedule({salad, salad});
+    expectValid(scheduler, {salad, salad}, timeline);
+    EXPECT_EQ(timeline.makespan, minutes(20));
+    EXPECT_EQ(scheduler.schedule({}).makespan, minutes(0));
+}
+
+TEST(KitchenSchedulerTest, ExactSearchMatchesBruteForce) {
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> length(1, 9);
+    std::uniform_int_distribution<int> resource(0, 2);
+    std::uniform_int_distribution<int> units(1, 2);
+    const std::map<std::string, int> capacities{{"burner", 2}, {"hands", 2}, {"oven", 1}};
+    const char* names[] = {"burner", "hands", "oven"};
+    KitchenScheduler scheduler(capacities);
+    KitchenScheduler::Options exact;
+    exact.samples = 0;  // Leave the work to the exact search
+
+    for (int trial = 0; trial < 25; ++trial) {
+        std::vector<std::shared_ptr<Recipe>> batch;
+        for (int r = 0; r < 3; ++r) {
+            auto recipe = std::make_shared<Recipe>("Recipe " + std::to_string(r));
+            const int steps = 1 + (trial + r) % 3;
+            for (int s = 1; s <= steps; ++s) {
+                std::map<std::string, int> needs;
+                const char* name = names[resource(rng)];
+                needs[name] = std::string(name) == "oven" ? 1 : units(rng);
+                // Later steps sometimes start right away instead of after the previous one
+                std::optional<std::vector<int>> after;
+                if (s > 1 && rng() % 3 == 0) {
+                    after = std::vector<int>{};
+                }
+                recipe->addStep(makeStep(s, length(rng), needs, after));
+            }
+            batch.push_back(recipe);
+        }
+        auto timeline = scheduler.schedule(batch, exact);
+        expectValid(scheduler, batch, timeline);
+        EXPECT_TRUE(timeline.optimal) << "trial " << trial;
+        EXPECT_EQ(timeline.makespan.count(), bruteForce(batch, capacities)) << "trial " << trial;
+
+        // The heuristic alone is never better than optimal
+        KitchenScheduler::Options heuristic;
+        heuristic.exactSteps = 0;
+        EXPECT_GE(scheduler.schedule(batch, heuristic).makespan, timeline.makespan);
+    }
+}
+
+TEST(KitchenSchedulerTest, SchedulesLargeBatchesWithinCapacity) {
+    auto batch = largeBatch(30);
+    int sequential = 0;
+    for (const auto& recipe : batch) {
+        sequential += static_cast<int>(recipe->getTotalTime().count());
+    }
+    KitchenScheduler scheduler({{"burner", 4}, {"hands", 3}, {"oven", 2}});
+    auto timeline = scheduler.schedule(batch);
+    expectValid(scheduler, batch, timeline);
+    EXPECT_FALSE(timeline.optimal && timeline.makespan > timeline.lowerBound);
+    EXPECT_LT(timeline.makespan.count(), sequential / 2);
+    EXPECT_LE(timeline.makespan.count(), timeline.lowerBound.count() * 5 / 4);
+}
+
+TEST(KitchenSchedulerTest, StopsAtTheControlsDeadline) {
+    // A batch whose first timeline is well above the lower bound, so the search has work left
+    auto batch = largeBatch(6);
+    KitchenScheduler scheduler({{"burner", 4}, {"hands", 3}, {"oven", 2}});
+    KitchenScheduler::Options endless;
+    endless.samples = std::numeric_limits<std::size_t>::max();
+    endless.exactSteps = std::numeric_limits<std::size_t>::max();
+    endless.maxNodes = std::numeric_limits<std::size_t>::max();
+
+    // Both the randomized passes and the exact search give way to the deadline
+    for (std::size_t samples : {endless.samples, std::size_t{0}}) {
+        endless.samples = samples;
+        KitchenScheduler::Control control;
+        control.deadline = KitchenScheduler::Control::Clock::now() + std::chrono::milliseconds(100);
+        control.channel = std::make_shared<SolutionChannel<KitchenScheduler::Timeline>>();
+        auto timeline = scheduler.schedule(batch, endless, control);
+        expectValid(scheduler, batch, timeline);
+        auto progress = control.channel->progress();
+        EXPECT_TRUE(progress.finished);
+        EXPECT_GE(progress.improvements, 1u);
+        EXPECT_GE(progress.iterations, 1u);
+        EXPECT_DOUBLE_EQ(progress.bestCost, timeline.makespan.count());
+        EXPECT_DOUBLE_EQ(progress.lowerBound, timeline.lowerBound.count());
+        ASSERT_NE(control.channel->best(), nullptr);
+        EXPECT_EQ(control.channel->best()->makespan, timeline.makespan);
+        EXPECT_EQ(control.channel->best()->steps.size(), timeline.steps.size());
+    }
+
+    // A cancelled run returns its first pass
+    KitchenScheduler::Control cancelled;
+    cancelled.cancellation.cancel();
+    auto first = scheduler.schedule(batch, endless, cancelled);
+    expectValid(scheduler, batch, first);
+    KitchenScheduler::Options single;
+    single.samples = 0;
+    single.exactSteps = 0;
+    EXPECT_EQ(first.makespan, scheduler.schedule(batch, single).makespan);
+}
+
+TEST(KitchenSchedulerTest, RejectsInvalidInput) {
+    EXPECT_THROW(KitchenScheduler({{"oven", -1}}), std::invalid_argument);
+    KitchenScheduler scheduler({{"oven", 1}, {"hands", 1}});
+    EXPECT_THROW(scheduler.schedule({nullptr}), std::invalid_argument);
+
+    auto recipe = std::make_shared<Recipe>("Stir fry");
+    recipe->addStep(makeStep(1, 5, {{"wok", 1}}));
+    EXPECT_THROW(scheduler.schedule({recipe}), std::invalid_argument);
+    auto roast = std::make_shared<Recipe>("Roast");
+    roast->addStep(makeStep(1, 60, {{"oven", 2}}));
+    EXPECT_THROW(scheduler.schedule({roast}), std::invalid_argument);
+
+    // Default resources the kitchen lacks are simply not held
+    KitchenScheduler ovenOnly({{"oven", 1}});
+    auto toast = std::make_shared<Recipe>("Toast");
+    toast->addStep(makeStep(1, 3, {}));
+    EXPECT_EQ(ovenOnly.schedule({toast, toast}).makespan, minutes(3));
+}
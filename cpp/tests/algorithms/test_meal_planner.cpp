@@ -0,0 +1,744 @@
+#include <gtest/gtest.h>
+#include <smart_food/algorithms/meal_planner.hpp>
+#include <smart_food/core/storage.hpp>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <set>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+class MealPlannerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Prices and calories chosen so that the cheapest recipes are also the lightest
+        const double prices[] = {1.0, 1.5, 2.0, 2.5, 3.0, 4.0, 5.0, 6.5};
+        const double calories[] = {150.0, 200.0, 350.0, 300.0, 600.0, 700.0, 800.0, 900.0};
+        for (int i = 0; i < 8; ++i) {
+            recipes.push_back(makeRecipe("Recipe " + std::to_string(i), prices[i], calories[i]));
+        }
+    }
+
+    static std::shared_ptr<Recipe> makeRecipe(const std::string& name, double price, double calories) {
+        auto ingredient = std::make_shared<Ingredient>(name + " base", 100.0, Ingredient::Unit::GRAM);
+        ingredient->setUnitPrice(price / 100.0);
+        ingredient->addNutritionalInfo("calories", calories);
+
+        auto recipe = std::make_shared<Recipe>(name);
+        recipe->addIngredient(ingredient);
+        return recipe;
+    }
+
+    static MealPlanner::Constraints smallConstraints() {
+        MealPlanner::Constraints constraints;
+        constraints.days = 2;
+        constraints.slotsPerDay = {Meal::Type::LUNCH, Meal::Type::DINNER};
+        return constraints;
+    }
+
+    // Exhaustive search over every assignment, used as the reference optimum
+    double bruteForce(const MealPlanner::Constraints& constraints) const {
+        const std::size_t slots = constraints.days * constraints.slotsPerDay.size();
+        std::vector<int> plan(slots, 0);
+        double best = std::numeric_limits<double>::infinity();
+
+        std::function<void(std::size_t)> visit = [&](std::size_t slot) {
+            if (slot == slots) {
+                std::set<int> distinct(plan.begin(), plan.end());
+                if (distinct.size() != slots) {
+                    return;
+                }
+                double cost = 0.0;
+                for (std::size_t day = 0; day < static_cast<std::size_t>(constraints.days); ++day) {
+                    double dayCalories = 0.0;
+                    for (std::size_t pos = 0; pos < constraints.slotsPerDay.size(); ++pos) {
+                        const auto& recipe = recipes[plan[day * constraints.slotsPerDay.size() + pos]];
+                        dayCalories += recipe->getNutritionalInfo().at("calories");
+                        cost += recipe->calculateTotalCost();
+                    }
+                    for (const auto& target : constraints.nutrients) {
+                        if (dayCalories < target.minPerDay || dayCalories > target.maxPerDay) {
+                            return;
+                        }
+                    }
+                }
+                best = std::min(best, cost);
+                return;
+            }
+            for (std::size_t r = 0; r < recipes.size(); ++r) {
+                plan[slot] = static_cast<int>(r);
+                visit(slot + 1);
+            }
+        };
+        visit(0);
+        return best;
+    }
+
+    std::vector<std::shared_ptr<Recipe>> recipes;
+};
+
+TEST_F(MealPlannerTest, PicksCheapestDistinctRecipes) {
+    MealPlanner planner(recipes);
+    auto plan = planner.plan(smallConstraints());
+
+    ASSERT_TRUE(plan.feasible);
+    EXPECT_TRUE(plan.optimal);
+    ASSERT_EQ(plan.assignments.size(), 4);
+    EXPECT_DOUBLE_EQ(plan.totalCost, 1.0 + 1.5 + 2.0 + 2.5);
+
+    std::set<std::string> ids;
+    for (const auto& assignment : plan.assignments) {
+        ids.insert(assignment.recipe->getId());
+    }
+    EXPECT_EQ(ids.size(), 4);
+}
+
+TEST_F(MealPlannerTest, AssignmentsFollowSlotOrder) {
+    MealPlanner planner(recipes);
+    auto plan = planner.plan(smallConstraints());
+
+    ASSERT_EQ(plan.assignments.size(), 4);
+    EXPECT_EQ(plan.assignments[0].day, 0);
+    EXPECT_EQ(plan.assignments[0].type, Meal::Type::LUNCH);
+    EXPECT_EQ(plan.assignments[1].type, Meal::Type::DINNER);
+    EXPECT_EQ(plan.assignments[3].day, 1);
+}
+
+TEST_F(MealPlannerTest, MatchesExhaustiveSearchUnderNutrientTargets) {
+    auto constraints = smallConstraints();
+    constraints.nutrients.push_back({"calories", 800.0, 1100.0});
+    MealPlanner::Options options;
+    options.relativeGap = 0.0;
+
+    MealPlanner planner(recipes);
+    auto plan = planner.plan(constraints, options);
+
+    ASSERT_TRUE(plan.feasible);
+    EXPECT_TRUE(plan.optimal);
+    EXPECT_NEAR(plan.totalCost, bruteForce(constraints), 1e-9);
+    EXPECT_NEAR(plan.lowerBound, plan.totalCost, 1e-6);
+
+    for (int day = 0; day < constraints.days; ++day) {
+        double calories = 0.0;
+        for (const auto& assignment : plan.assignments) {
+            if (assignment.day == day) {
+                calories += assignment.recipe->getNutritionalInfo().at("calories");
+            }
+        }
+        EXPECT_GE(calories, 800.0);
+        EXPECT_LE(calories, 1100.0);
+    }
+}
+
+TEST_F(MealPlannerTest, HonorsAllowedTypes) {
+    MealPlanner planner(recipes);
+    planner.setAllowedTypes(recipes[0]->getId(), {Meal::Type::BREAKFAST});
+    planner.setAllowedTypes(recipes[1]->getId(), {Meal::Type::DINNER});
+
+    auto plan = planner.plan(smallConstraints());
+    ASSERT_TRUE(plan.feasible);
+    for (const auto& assignment : plan.assignments) {
+        EXPECT_NE(assignment.recipe, recipes[0]);
+        if (assignment.recipe == recipes[1]) {
+            EXPECT_EQ(assignment.type, Meal::Type::DINNER);
+        }
+    }
+    EXPECT_EQ(planner.getAllowedTypes(recipes[1]->getId()).size(), 1);
+    EXPECT_EQ(planner.getAllowedTypes(recipes[2]->getId()).size(), 4);
+}
+
+TEST_F(MealPlannerTest, AllowsRepeatsOnDifferentDays) {
+    auto constraints = smallConstraints();
+    constraints.maxRepeats = 2;
+
+    MealPlanner planner(recipes);
+    auto plan = planner.plan(constraints);
+
+    ASSERT_TRUE(plan.feasible);
+    EXPECT_DOUBLE_EQ(plan.totalCost, 2 * (1.0 + 1.5));
+    EXPECT_NE(plan.assignments[0].recipe, plan.assignments[1].recipe);
+}
+
+TEST_F(MealPlannerTest, UsesPantryStockFirst) {
+    auto constraints = smallConstraints();
+    // Enough stock for one serving of the fifth recipe makes it free
+    constraints.pantry.push_back(std::make_shared<Ingredient>("recipe 4 BASE", 0.1, Ingredient::Unit::KILOGRAM));
+
+    MealPlanner planner(recipes);
+    auto plan = planner.plan(constraints);
+
+    ASSERT_TRUE(plan.feasible);
+    EXPECT_NEAR(plan.totalCost, 1.0 + 1.5 + 2.0, 1e-9);
+    bool usesStock = false;
+    for (const auto& assignment : plan.assignments) {
+        if (assignment.recipe == recipes[4]) {
+            usesStock = true;
+            EXPECT_NEAR(assignment.cost, 0.0, 1e-9);
+        }
+    }
+    EXPECT_TRUE(usesStock);
+}
+
+TEST_F(MealPlannerTest, IgnoresExpiredPantryLots) {
+    const auto start = std::chrono::system_clock::from_time_t(1700000000);
+    auto constraints = smallConstraints();
+    constraints.start = start;
+    auto lot = std::make_shared<Ingredient>("recipe 4 BASE", 0.1, Ingredient::Unit::KILOGRAM);
+    constraints.pantry.push_back(lot);
+
+    // One shard, so every request below stays stored
+    auto cache = std::make_shared<MealPlanner::Cache>(16, 1);
+    MealPlanner planner(recipes);
+    planner.setCache(cache);
+    const double withoutStock = planner.plan(smallConstraints()).totalCost;
+
+    // An epoch expiry date means the lot keeps
+    EXPECT_NEAR(planner.plan(constraints).totalCost, 1.0 + 1.5 + 2.0, 1e-9);
+    lot->setExpiryDate(start + std::chrono::hours(1));
+    EXPECT_NEAR(planner.plan(constraints).totalCost, 1.0 + 1.5 + 2.0, 1e-9);
+
+    // A lot spoiled before the first day is not used, nor is the plan that used it
+    constraints.start = start + std::chrono::hours(2);
+    auto plan = planner.plan(constraints);
+    ASSERT_TRUE(plan.feasible);
+    EXPECT_NEAR(plan.totalCost, withoutStock, 1e-9);
+    EXPECT_EQ(cache->getStats().hits, 0u);
+
+    // With no start given, the plan starts now
+    constraints.start = {};
+    lot->setExpiryDate(std::chrono::system_clock::now() - std::chrono::hours(24));
+    EXPECT_NEAR(planner.plan(constraints).totalCost, withoutStock, 1e-9);
+}
+
+TEST_F(MealPlannerTest, PricesComponentsOfCompositeRecipes) {
+    auto spaghetti = std::make_shared<Ingredient>("Spaghetti", 100.0, Ingredient::Unit::GRAM);
+    spaghetti->setUnitPrice(0.002);
+    auto tomato = std::make_shared<Ingredient>("Tomato", 800.0, Ingredient::Unit::GRAM);
+    tomato->setUnitPrice(0.01);
+    auto sauce = std::make_shared<Recipe>("Sauce");
+    sauce->addIngredient(tomato);
+    sauce->setServings(2);
+    auto pasta = std::make_shared<Recipe>("Pasta");
+    pasta->addIngredient(spaghetti);
+    pasta->addComponent(sauce, 1.0);  // Half the sauce: 400 g of tomato
+    ASSERT_NEAR(pasta->calculateTotalCost(), 4.2, 1e-9);
+
+    MealPlanner::Constraints constraints;
+    constraints.days = 1;
+    constraints.slotsPerDay = {Meal::Type::DINNER};
+    MealPlanner planner({pasta});
+    auto plan = planner.plan(constraints);
+    ASSERT_TRUE(plan.feasible);
+    EXPECT_NEAR(plan.totalCost, 4.2, 1e-9);
+
+    // Stock of a component's ingredient nets against the recipe using it
+    constraints.pantry.push_back(std::make_shared<Ingredient>("Tomato", 400.0, Ingredient::Unit::GRAM));
+    plan = planner.plan(constraints);
+    ASSERT_TRUE(plan.feasible);
+    EXPECT_NEAR(plan.totalCost, 0.2, 1e-9);
+}
+
+TEST_F(MealPlannerTest, ReportsInfeasibleTargets) {
+    auto constraints = smallConstraints();
+    constraints.nutrients.push_back({"calories", 5000.0, 6000.0});
+
+    MealPlanner planner(recipes);
+    auto plan = planner.plan(constraints);
+
+    EXPECT_FALSE(plan.feasible);
+    EXPECT_TRUE(plan.optimal);
+    EXPECT_TRUE(plan.assignments.empty());
+}
+
+TEST_F(MealPlannerTest, StopsAtNodeLimit) {
+    auto constraints = smallConstraints();
+    constraints.nutrients.push_back({"calories", 800.0, 1100.0});
+    MealPlanner::Options options;
+    options.maxNodes = 3;
+
+    MealPlanner planner(recipes);
+    auto plan = planner.plan(constraints, options);
+
+    EXPECT_FALSE(plan.optimal);
+    EXPECT_LE(plan.nodesExplored, 3);
+}
+
+TEST_F(MealPlannerTest, InvalidConstraints) {
+    MealPlanner planner(recipes);
+
+    auto constraints = smallConstraints();
+    constraints.days = 0;
+    EXPECT_THROW(planner.plan(constraints), std::invalid_argument);
+
+    constraints = smallConstraints();
+    constraints.slotsPerDay.clear();
+    EXPECT_THROW(planner.plan(constraints), std::invalid_argument);
+
+    constraints = smallConstraints();
+    constraints.nutrients.push_back({"calories", 900.0, 100.0});
+    EXPECT_THROW(planner.plan(constraints), std::invalid_argument);
+
+    EXPECT_THROW(planner.setAllowedTypes(recipes[0]->getId(), {}), std::invalid_argument);
+    EXPECT_THROW(MealPlanner({nullptr}), std::invalid_argument);
+}
+
+TEST_F(MealPlannerTest, LocalSearchMatchesExhaustiveSearch) {
+    auto constraints = smallConstraints();
+    constraints.nutrients.push_back({"calories", 800.0, 1100.0});
+    MealPlanner::Options options;
+    options.strategy = MealPlanner::Strategy::LOCAL_SEARCH;
+    options.threads = 2;
+    options.maxEvaluations = 20000;
+
+    MealPlanner planner(recipes);
+    auto plan = planner.plan(constraints, options);
+
+    ASSERT_TRUE(plan.feasible);
+    EXPECT_FALSE(plan.optimal);
+    EXPECT_NEAR(plan.totalCost, bruteForce(constraints), 1e-9);
+    EXPECT_LE(plan.lowerBound, plan.totalCost);
+    EXPECT_GT(plan.nodesExplored, 0);
+}
+
+TEST_F(MealPlannerTest, LocalSearchIsDeterministicPerSeed) {
+    auto constraints = smallConstraints();
+    constraints.days = 3;
+    constraints.maxRepeats = 2;
+    constraints.nutrients.push_back({"calories", 700.0, 1200.0});
+    MealPlanner::Options options;
+    options.strategy = MealPlanner::Strategy::LOCAL_SEARCH;
+    options.threads = 3;
+    options.seed = 7;
+    options.maxEvaluations = 5000;
+
+    MealPlanner planner(recipes);
+    auto first = planner.plan(constraints, options);
+    auto second = planner.plan(constraints, options);
+
+    ASSERT_TRUE(first.feasible);
+    ASSERT_EQ(first.assignments.size(), second.assignments.size());
+    for (std::size_t i = 0; i < first.assignments.size(); ++i) {
+        EXPECT_EQ(first.assignments[i].recipe, second.assignments[i].recipe);
+    }
+    EXPECT_EQ(first.nodesExplored, second.nodesExplored);
+}
+
+TEST_F(MealPlannerTest, LocalSearchReportsMissingRecipes) {
+    MealPlanner planner(recipes);
+    // Only one recipe may be served at dinner, but two dinners are needed
+    for (std::size_t i = 1; i < recipes.size(); ++i) {
+        planner.setAllowedTypes(recipes[i]->getId(), {Meal::Type::LUNCH});
+    }
+    MealPlanner::Options options;
+    options.strategy = MealPlanner::Strategy::LOCAL_SEARCH;
+
+    auto plan = planner.plan(smallConstraints(), options);
+    EXPECT_FALSE(plan.feasible);
+    EXPECT_TRUE(plan.optimal);
+}
+
+TEST_F(MealPlannerTest, LockSlotRepairsAroundPinnedRecipe) {
+    auto constraints = smallConstraints();
+    constraints.nutrients.push_back({"calories", 800.0, 1100.0});
+    MealPlanner planner(recipes);
+    auto initial = planner.plan(constraints);
+    ASSERT_TRUE(initial.feasible);
+
+    auto plan = planner.lockSlot(1, 0, recipes[5]->getId());
+    ASSERT_TRUE(plan.feasible);
+    EXPECT_EQ(plan.assignments[2].recipe, recipes[5]);
+
+    // The pinned recipe must not appear anywhere else, and every day stays in range
+    double cost = 0.0;
+    for (std::size_t i = 0; i < plan.assignments.size(); ++i) {
+        if (i != 2) {
+            EXPECT_NE(plan.assignments[i].recipe, recipes[5]);
+        }
+        cost += plan.assignments[i].cost;
+    }
+    EXPECT_NEAR(plan.totalCost, cost, 1e-9);
+    EXPECT_GE(plan.totalCost, initial.totalCost);
+
+    // A later swap elsewhere keeps the pinned slot
+    auto swapped = planner.swapRecipe(0, 1);
+    ASSERT_TRUE(swapped.feasible);
+    EXPECT_EQ(swapped.assignments[2].recipe, recipes[5]);
+    EXPECT_NE(swapped.assignments[1].recipe, plan.assignments[1].recipe);
+}
+
+TEST_F(MealPlannerTest, SwapRecipeExcludesReplacedRecipe) {
+    MealPlanner planner(recipes);
+    auto initial = planner.plan(smallConstraints());
+    ASSERT_TRUE(initial.feasible);
+
+    auto first = planner.swapRecipe(0, 0);
+    ASSERT_TRUE(first.feasible);
+    EXPECT_NE(first.assignments[0].recipe, initial.assignments[0].recipe);
+    // Only the swapped day changes
+    EXPECT_EQ(first.assignments[2].recipe, initial.assignments[2].recipe);
+    EXPECT_EQ(first.assignments[3].recipe, initial.assignments[3].recipe);
+
+    auto second = planner.swapRecipe(0, 0);
+    EXPECT_NE(second.assignments[0].recipe, initial.assignments[0].recipe);
+    EXPECT_NE(second.assignments[0].recipe, first.assignments[0].recipe);
+}
+
+TEST_F(MealPlannerTest, ChangeServingsAndPantryReprice) {
+    MealPlanner planner(recipes);
+    auto initial = planner.plan(smallConstraints());
+    ASSERT_TRUE(initial.feasible);
+
+    auto doubled = planner.changeServings(2);
+    ASSERT_TRUE(doubled.feasible);
+    EXPECT_NEAR(doubled.totalCost, 2.0 * initial.totalCost, 1e-9);
+
+    // Two servings of the fifth recipe in stock make it the cheapest choice
+    auto stocked = planner.updatePantry({std::make_shared<Ingredient>("Recipe 4 base", 200.0, Ingredient::Unit::GRAM)});
+    ASSERT_TRUE(stocked.feasible);
+    EXPECT_NEAR(stocked.totalCost, 2.0 * (1.0 + 1.5 + 2.0), 1e-9);
+
+    EXPECT_THROW(planner.changeServings(0), std::invalid_argument);
+}
+
+TEST_F(MealPlannerTest, EditsRequireFeasiblePlan) {
+    MealPlanner planner(recipes);
+    EXPECT_THROW(planner.swapRecipe(0, 0), std::logic_error);
+
+    auto constraints = smallConstraints();
+    constraints.nutrients.push_back({"calories", 5000.0, 6000.0});
+    planner.plan(constraints);
+    EXPECT_THROW(planner.changeServings(2), std::logic_error);
+
+    planner.plan(smallConstraints());
+    EXPECT_THROW(planner.lockSlot(2, 0, recipes[0]->getId()), std::invalid_argument);
+    EXPECT_THROW(planner.lockSlot(0, 0, "missing"), std::invalid_argument);
+    planner.setAllowedTypes(recipes[0]->getId(), {Meal::Type::BREAKFAST});
+    planner.plan(smallConstraints());
+    EXPECT_THROW(planner.lockSlot(0, 0, recipes[0]->getId()), std::invalid_argument);
+}
+
+TEST_F(MealPlannerTest, PublishesProgressWhileSolving) {
+    auto constraints = smallConstraints();
+    constraints.nutrients.push_back({"calories", 800.0, 1100.0});
+
+    for (auto strategy : {MealPlanner::Strategy::BRANCH_AND_BOUND, MealPlanner::Strategy::LOCAL_SEARCH}) {
+        MealPlanner::Options options;
+        options.strategy = strategy;
+        options.threads = 2;
+        options.maxEvaluations = 20000;
+        MealPlanner::Control control;
+        control.channel = std::make_shared<SolutionChannel<MealPlanner::Plan>>();
+
+        MealPlanner planner(recipes);
+        auto plan = planner.plan(constraints, options, control);
+
+        ASSERT_TRUE(plan.feasible);
+        auto progress = control.channel->progress();
+        EXPECT_TRUE(progress.finished);
+        EXPECT_EQ(progress.iterations, plan.nodesExplored);
+        EXPECT_GE(progress.improvements, 1u);
+        EXPECT_NEAR(progress.bestCost, plan.totalCost, 1e-9);
+        EXPECT_LE(progress.lowerBound, progress.bestCost + 1e-9);
+        ASSERT_NE(control.channel->best(), nullptr);
+        EXPECT_TRUE(control.channel->best()->feasible);
+        EXPECT_EQ(control.channel->best()->assignments.size(), plan.assignments.size());
+    }
+}
+
+TEST_F(MealPlannerTest, CancelledRunReturnsBestSoFar) {
+    auto constraints = smallConstraints();
+    constraints.nutrients.push_back({"calories", 800.0, 1100.0});
+    MealPlanner::Control control;
+    control.cancellation.cancel();
+    control.channel = std::make_shared<SolutionChannel<MealPlanner::Plan>>();
+
+    // The starting plan is built before the first poll
+    MealPlanner planner(recipes);
+    auto plan = planner.plan(constraints, MealPlanner::Options(), control);
+    EXPECT_FALSE(plan.optimal);
+    ASSERT_TRUE(plan.feasible);
+    ASSERT_EQ(plan.assignments.size(), 4u);
+    ASSERT_NE(control.channel->best(), nullptr);
+    EXPECT_NEAR(control.channel->bestCost(), plan.totalCost, 1e-9);
+    for (std::size_t i = 0; i < plan.assignments.size(); ++i) {
+        EXPECT_EQ(control.channel->best()->assignments[i].recipe, plan.assignments[i].recipe);
+    }
+
+    MealPlanner::Options options;
+    options.strategy = MealPlanner::Strategy::LOCAL_SEARCH;
+    options.threads = 1;
+    control.deadline = MealPlanner::Control::Clock::now();
+    control.cancellation = CancellationToken();
+    control.channel = std::make_shared<SolutionChannel<MealPlanner::Plan>>();
+    plan = planner.plan(constraints, options, control);
+    EXPECT_FALSE(plan.optimal);
+    ASSERT_TRUE(plan.feasible);
+    EXPECT_NEAR(control.channel->bestCost(), plan.totalCost, 1e-9);
+    // Chains stop at their first poll, before any move
+    EXPECT_EQ(plan.nodesExplored, 0u);
+}
+
+TEST_F(MealPlannerTest, ReusesCachedPlans) {
+    // One shard, so the three requests below cannot evict each other
+    auto cache = std::make_shared<MealPlanner::Cache>(16, 1);
+    auto constraints = smallConstraints();
+    constraints.nutrients.push_back({"calories", 800.0, 1100.0});
+
+    MealPlanner first(recipes);
+    first.setCache(cache);
+    auto solved = first.plan(constraints);
+    ASSERT_TRUE(solved.feasible);
+    EXPECT_EQ(cache->getStats().misses, 1u);
+
+    // A second planner over the same catalog gets the stored plan and can edit it
+    MealPlanner second(recipes);
+    second.setCache(cache);
+    auto reused = second.plan(constraints);
+    EXPECT_EQ(cache->getStats().hits, 1u);
+    ASSERT_EQ(reused.assignments.size(), solved.assignments.size());
+    for (std::size_t i = 0; i < solved.assignments.size(); ++i) {
+        EXPECT_EQ(reused.assignments[i].recipe, solved.assignments[i].recipe);
+    }
+    EXPECT_EQ(reused.nodesExplored, solved.nodesExplored);
+    auto swapped = second.swapRecipe(0, 0);
+    EXPECT_NE(swapped.assignments[0].recipe, solved.assignments[0].recipe);
+
+    // Different constraints or allowed types are different requests
+    constraints.nutrients[0].maxPerDay = 1200.0;
+    second.plan(constraints);
+    second.setAllowedTypes(recipes[0]->getId(), {Meal::Type::LUNCH});
+    second.plan(constraints);
+    EXPECT_EQ(cache->getStats().misses, 3u);
+
+    // So is a recipe edited through its methods, and ingredients edited in place once reported
+    recipes[1]->setServings(2);
+    second.plan(constraints);
+    EXPECT_EQ(cache->getStats().misses, 4u);
+    recipes[1]->getIngredients()[0]->setUnitPrice(0.5);
+    second.invalidateIngredients();
+    second.plan(constraints);
+    EXPECT_EQ(cache->getStats().misses, 5u);
+    second.plan(constraints);
+    EXPECT_EQ(cache->getStats().hits, 2u);
+    EXPECT_EQ(cache->size(), 5u);
+
+    // A Storage change makes every stored plan stale
+    auto& storage = Storage::getInstance();
+    auto flour = std::make_shared<Ingredient>("Flour", 500.0, Ingredient::Unit::GRAM);
+    storage.addIngredient(flour);
+    second.plan(constraints);
+    storage.removeIngredient(flour->getId());
+    EXPECT_EQ(cache->getStats().misses, 6u);
+    EXPECT_EQ(cache->getStats().invalidations, 1u);
+
+    // Runs stopped by the clock are not stored
+    MealPlanner::Control control;
+    control.cancellation.cancel();
+    second.plan(smallConstraints(), MealPlanner::Options(), control);
+    EXPECT_EQ(cache->size(), 5u);
+}
+
+TEST_F(MealPlannerTest, CacheKeysFollowSharedComponents) {
+    // Each level uses the one below twice: 2^40 paths, one recipe per level
+    auto below = std::make_shared<Recipe>("Stock");
+    below->addIngredient(std::make_shared<Ingredient>("Bones", 100.0, Ingredient::Unit::GRAM));
+    const auto stock = below;
+    for (int level = 0; level < 40; ++level) {
+        auto half = std::make_shared<Recipe>("Half " + std::to_string(level));
+        half->addComponent(below, 1.0);
+        auto above = std::make_shared<Recipe>("Level " + std::to_string(level));
+        above->addComponent(below, 1.0);
+        above->addComponent(half, 1.0);
+        below = above;
+    }
+    recipes.push_back(below);
+    auto cache = std::make_shared<MealPlanner::Cache>(16, 1);
+    MealPlanner planner(recipes);
+    planner.setCache(cache);
+    planner.plan(smallConstraints());
+    planner.plan(smallConstraints());
+    EXPECT_EQ(cache->getStats().hits, 1u);
+
+    // An edit deep below changes the request
+    stock->setServings(2);
+    planner.plan(smallConstraints());
+    EXPECT_EQ(cache->getStats().misses, 2u);
+}
+
+TEST_F(MealPlannerTest, FrontTradesCostForPrepTime) {
+    // Recipe i costs i + 1 and takes 80 - 10 i minutes, so every plan with
+    // the same sum of indices scores the same and each sum is a front point
+    recipes.clear();
+    for (int i = 0; i < 8; ++i) {
+        auto recipe = makeRecipe("Recipe " + std::to_string(i), i + 1.0, 100.0);
+        recipe->addStep({1, "Cook", std::chrono::minutes(80 - 10 * i), std::nullopt, {}});
+        recipes.push_back(recipe);
+    }
+    auto constraints = smallConstraints();
+    MealPlanner::FrontOptions options;
+    options.threads = 2;
+    options.seed = 5;
+
+    MealPlanner planner(recipes);
+    auto front = planner.planFront(constraints, options);
+    ASSERT_EQ(front.size(), 17u);
+    for (std::size_t i = 0; i < front.size(); ++i) {
+        const auto& point = front[i];
+        ASSERT_TRUE(point.plan.feasible);
+        ASSERT_EQ(point.plan.assignments.size(), 4u);
+        std::set<std::shared_ptr<Recipe>> distinct;
+        std::chrono::minutes prepTime{0};
+        for (const auto& assignment : point.plan.assignments) {
+            distinct.insert(assignment.recipe);
+            prepTime += assignment.recipe->getTotalTime();
+        }
+        EXPECT_EQ(distinct.size(), 4u);
+        EXPECT_NEAR(point.objectives.cost, 10.0 + i, 1e-9);
+        EXPECT_NEAR(point.plan.totalCost, point.objectives.cost, 1e-9);
+        EXPECT_EQ(point.objectives.prepTime, prepTime);
+        EXPECT_EQ(point.objectives.prepTime.count(), 260 - 10 * static_cast<int>(i));
+        EXPECT_DOUBLE_EQ(point.objectives.nutritionError, 0.0);
+        EXPECT_DOUBLE_EQ(point.objectives.waste, 0.0);
+    }
+
+    // The same seed and thread count give the same front
+    auto again = planner.planFront(constraints, options);
+    ASSERT_EQ(again.size(), front.size());
+    for (std::size_t i = 0; i < front.size(); ++i) {
+        for (std::size_t s = 0; s < front[i].plan.assignments.size(); ++s) {
+            EXPECT_EQ(again[i].plan.assignments[s].recipe, front[i].plan.assignments[s].recipe);
+        }
+    }
+
+    // Fewer points keep both ends
+    options.points = 5;
+    front = planner.planFront(constraints, options);
+    ASSERT_EQ(front.size(), 5u);
+    EXPECT_NEAR(front.front().objectives.cost, 10.0, 1e-9);
+    EXPECT_NEAR(front.back().objectives.cost, 26.0, 1e-9);
+}
+
+TEST_F(MealPlannerTest, FrontPublishesProgressAndStops) {
+    recipes.clear();
+    for (int i = 0; i < 8; ++i) {
+        auto recipe = makeRecipe("Recipe " + std::to_string(i), i + 1.0, 100.0);
+        recipe->addStep({1, "Cook", std::chrono::minutes(80 - 10 * i), std::nullopt, {}});
+        recipes.push_back(recipe);
+    }
+    auto constraints = smallConstraints();
+    MealPlanner::FrontOptions options;
+    options.threads = 2;
+    options.seed = 5;
+    MealPlanner::FrontControl control;
+    control.channel = std::make_shared<SolutionChannel<std::vector<MealPlanner::FrontPlan>>>();
+
+    MealPlanner planner(recipes);
+    auto front = planner.planFront(constraints, options, control);
+    ASSERT_FALSE(front.empty());
+    auto progress = control.channel->progress();
+    EXPECT_TRUE(progress.finished);
+    EXPECT_GE(progress.improvements, 2u);
+    EXPECT_EQ(progress.iterations, front.front().plan.nodesExplored);
+    // The latest front published is the one returned
+    const auto* best = control.channel->best();
+    ASSERT_NE(best, nullptr);
+    ASSERT_EQ(best->size(), front.size());
+    for (std::size_t i = 0; i < front.size(); ++i) {
+        EXPECT_NEAR((*best)[i].objectives.cost, front[i].objectives.cost, 1e-9);
+    }
+
+    // A cancelled run stops before its first generation
+    options.generations = std::numeric_limits<std::size_t>::max();
+    options.anchorEvaluations = std::numeric_limits<std::size_t>::max();
+    MealPlanner::FrontControl cancelled;
+    cancelled.cancellation.cancel();
+    cancelled.channel = std::make_shared<SolutionChannel<std::vector<MealPlanner::FrontPlan>>>();
+    front = planner.planFront(constraints, options, cancelled);
+    EXPECT_TRUE(cancelled.channel->progress().finished);
+    for (const auto& point : front) {
+        EXPECT_TRUE(point.plan.feasible);
+    }
+
+    // So does one past its deadline
+    MealPlanner::FrontControl late;
+    late.deadline = MealPlanner::FrontControl::Clock::now();
+    planner.planFront(constraints, options, late);
+}
+
+TEST_F(MealPlannerTest, FrontScoresNutritionAndExpiringStock) {
+    auto pie = std::make_shared<Recipe>("Spinach pie");
+    auto spinach = std::make_shared<Ingredient>("Spinach", 200.0, Ingredient::Unit::GRAM);
+    spinach->setUnitPrice(0.02);
+    spinach->addNutritionalInfo("calories", 500.0);
+    pie->addIngredient(spinach);
+    recipes.push_back(pie);
+
+    auto constraints = smallConstraints();
+    constraints.nutrients.push_back({"calories", 800.0, 1100.0});
+    auto stock = std::make_shared<Ingredient>("Spinach", 200.0, Ingredient::Unit::GRAM);
+    stock->setUnitPrice(0.02);
+    const auto start = std::chrono::system_clock::now();
+    stock->setExpiryDate(start + std::chrono::hours(30));
+    constraints.pantry.push_back(stock);
+    MealPlanner::FrontOptions options;
+    options.threads = 2;
+    options.start = start;
+
+    MealPlanner planner(recipes);
+    auto front = planner.planFront(constraints, options);
+    ASSERT_FALSE(front.empty());
+    bool rescued = false;
+    for (std::size_t i = 0; i < front.size(); ++i) {
+        const auto& point = front[i];
+        double error = 0.0;
+        bool usesPie = false;
+        for (int day = 0; day < 2; ++day) {
+            double calories = 0.0;
+            for (int pos = 0; pos < 2; ++pos) {
+                const auto& recipe = point.plan.assignments[day * 2 + pos].recipe;
+                calories += recipe->getNutritionalInfo().at("calories");
+                usesPie = usesPie || recipe == pie;
+            }
+            EXPECT_GE(calories, 800.0);
+            EXPECT_LE(calories, 1100.0);
+            error += std::abs(calories - 950.0) / 150.0;
+        }
+        EXPECT_NEAR(point.objectives.nutritionError, error / 2.0, 1e-9);
+        EXPECT_NEAR(point.objectives.waste, usesPie ? 0.0 : 4.0, 1e-9);
+        rescued = rescued || usesPie;
+        if (i > 0) {
+            EXPECT_LE(front[i - 1].objectives.cost, point.objectives.cost);
+        }
+        // No point is beaten on every objective by another
+        for (const auto& other : front) {
+            const auto& a = other.objectives;
+            const auto& b = point.objectives;
+            EXPECT_FALSE(a.cost <= b.cost && a.nutritionError <= b.nutritionError && a.prepTime <= b.prepTime &&
+                         a.waste <= b.waste &&
+                         (a.cost < b.cost || a.nutritionError < b.nutritionError || a.waste < b.waste));
+        }
+    }
+    EXPECT_TRUE(rescued);
+
+    // Stock that keeps past the horizon is not waste
+    stock->setExpiryDate(start + std::chrono::hours(24 * 5));
+    for (const auto& point : planner.planFront(constraints, options)) {
+        EXPECT_DOUBLE_EQ(point.objectives.waste, 0.0);
+    }
+}
+
+TEST_F(MealPlannerTest, FrontRejectsInvalidOptions) {
+    MealPlanner planner(recipes);
+    MealPlanner::FrontOptions options;
+    options.points = 0;
+    EXPECT_THROW(planner.planFront(smallConstraints(), options), std::invalid_argument);
+    options.points = 20;
+    options.population = 0;
+    EXPECT_THROW(planner.planFront(smallConstraints(), options), std::invalid_argument);
+
+    // Five days of two distinct recipes need more than the eight available
+    auto constraints = smallConstraints();
+    constraints.days = 5;
+    EXPECT_TRUE(planner.planFront(constraints).empty());
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <smart_food/algorithms/nutrient_index.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <tuple>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+/// A recipe of the given nutrients, cost and time per serving
+std::shared_ptr<Recipe> makeRecipe(const std::string& name, double calories, double protein, double fat,
+                                   double cost = 1.0, int minutes = 30) {
+    auto ingredient = std::make_shared<Ingredient>("Mix", 1.0, Ingredient::Unit::PIECE);
+    ingredient->setUnitPrice(cost);
+    ingredient->addNutritionalInfo("calories", calories);
+    ingredient->addNutritionalInfo("protein", protein);
+    ingredient->addNutritionalInfo("fat", fat);
+    auto recipe = std::make_shared<Recipe>(name);
+    recipe->addIngredient(ingredient);
+    recipe->addStep({1, "Cook", std::chrono::minutes(minutes), std::nullopt, {}});
+    return recipe;
+}
+
+/// Exhaustive search with the same scaling and ordering as NutrientIndex
+std::vector<std::pair<std::shared_ptr<Recipe>, double>> bruteForce(const std::vector<std::shared_ptr<Recipe>>& recipes,
+                                                                   const NutrientIndex::Query& query) {
+    const std::vector<std::string> nutrients{"calories", "fat", "protein"};
+    std::map<std::string, double> scales;
+    for (const auto& nutrient : nutrients) {
+        double sum = 0.0;
+        double squares = 0.0;
+        for (const auto& recipe : recipes) {
+            const double value = recipe->getNutritionalInfo().at(nutrient);
+            sum += value;
+            squares += value * value;
+        }
+        const double mean = sum / recipes.size();
+        scales[nutrient] = std::sqrt(squares / recipes.size() - mean * mean);
+    }
+    std::vector<std::tuple<double, std::size_t>> scored;
+    for (std::size_t r = 0; r < recipes.size(); ++r) {
+        const auto& info = recipes[r]->getNutritionalInfo();
+        bool inside = recipes[r]->calculateTotalCost() <= query.maxCostPerServing &&
+                      recipes[r]->getTotalTime() <= query.maxTotalTime;
+        for (const auto& range : query.ranges) {
+            inside = inside && info.at(range.nutrient) >= range.min && info.at(range.nutrient) <= range.max;
+        }
+        if (!inside) {
+            continue;
+        }
+        double distance = 0.0;
+        for (const auto& target : query.targets) {
+            const double diff = (info.at(target.nutrient) - target.value) / scales[target.nutrient];
+            distance += target.weight * diff * diff;
+        }
+        scored.emplace_back(std::sqrt(distance), r);
+    }
+    std::sort(scored.begin(), scored.end());
+    std::vector<std::pair<std::shared_ptr<Recipe>, double>> best;
+    for (std::size_t i = 0; i < std::min(query.limit, scored.size()); ++i) {
+        best.emplace_back(recipes[std::get<1>(scored[i])], std::get<0>(scored[i]));
+    }
+    return best;
+}
+
+} // namespace
+
+TEST(NutrientIndexTest, FindsClosestRecipeWithinBounds) {
+    auto salad = makeRecipe("Salad", 350.0, 12.0, 18.0, 4.0, 15);
+    auto steak = makeRecipe("Steak", 650.0, 45.0, 35.0, 12.0, 25);
+    auto chicken = makeRecipe("Chicken bowl", 600.0, 42.0, 15.0, 6.0, 40);
+    auto pasta = makeRecipe("Pasta", 620.0, 20.0, 12.0, 3.0, 20);
+    auto curry = makeRecipe("Curry", 580.0, 38.0, 19.0, 5.0, 90);
+    NutrientIndex index({salad, steak, chicken, pasta, curry});
+    EXPECT_EQ(index.getRecipeCount(), 5u);
+    EXPECT_EQ(index.getNutrients(), (std::vector<std::string>{"calories", "fat", "protein"}));
+
+    // "A dinner around 600 kcal, 40 g protein, under 20 g fat"
+    NutrientIndex::Query query;
+    query.targets = {{"calories", 600.0}, {"protein", 40.0}};
+    query.ranges = {{"fat", -std::numeric_limits<double>::infinity(), 20.0}};
+    query.limit = 3;
+    auto matches = index.search(query);
+    ASSERT_EQ(matches.size(), 3u);
+    EXPECT_EQ(matches[0].recipe, chicken);
+    EXPECT_EQ(matches[1].recipe, curry);
+    EXPECT_EQ(matches[2].recipe, pasta);
+    EXPECT_LT(matches[0].distance, matches[1].distance);
+
+    // Under 45 minutes and 5.50 a serving leaves the pasta and the salad
+    query.maxTotalTime = std::chrono::minutes(45);
+    query.maxCostPerServing = 5.5;
+    matches = index.search(query);
+    ASSERT_EQ(matches.size(), 2u);
+    EXPECT_EQ(matches[0].recipe, pasta);
+    EXPECT_EQ(matches[1].recipe, salad);
+
+    // Only protein counts once calories weigh nothing
+    query = NutrientIndex::Query();
+    query.targets = {{"calories", 0.0, 0.0}, {"protein", 45.0}};
+    query.limit = 1;
+    matches = index.search(query);
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].recipe, steak);
+    EXPECT_NEAR(matches[0].distance, 0.0, 1e-6);
+}
+
+TEST(NutrientIndexTest, MatchesBruteForceOnLargeCatalog) {
+    std::mt19937 rng(17);
+    std::normal_distribution<double> calories(550.0, 180.0);
+    std::uniform_real_distribution<double> protein(5.0, 60.0);
+    std::uniform_real_distribution<double> fat(2.0, 45.0);
+    std::uniform_real_distribution<double> cost(1.0, 15.0);
+    std::uniform_int_distribution<int> minutes(5, 120);
+    std::vector<std::shared_ptr<Recipe>> recipes;
+    for (int r = 0; r < 20000; ++r) {
+        recipes.push_back(makeRecipe("Recipe " + std::to_string(r), std::max(50.0, calories(rng)), protein(rng),
+                                     fat(rng), cost(rng), minutes(rng)));
+    }
+    NutrientIndex index(recipes);
+
+    std::uniform_real_distribution<double> weight(0.2, 3.0);
+    for (int q = 0; q < 40; ++q) {
+        NutrientIndex::Query query;
+        query.targets = {{"calories", calories(rng), weight(rng)}, {"protein", protein(rng), weight(rng)}};
+        if (q % 2 == 0) {
+            query.targets.push_back({"fat", fat(rng), weight(rng)});
+        }
+        if (q % 3 == 0) {
+            query.ranges = {{"fat", -std::numeric_limits<double>::infinity(), fat(rng)}};
+        }
+        if (q % 4 == 0) {
+            query.maxCostPerServing = cost(rng);
+            query.maxTotalTime = std::chrono::minutes(minutes(rng));
+        }
+        query.limit = q % 5 == 0 ? 1 : 25;
+
+        auto matches = index.search(query);
+        auto expected = bruteForce(recipes, query);
+        ASSERT_EQ(matches.size(), expected.size()) << "query " << q;
+        for (std::size_t i = 0; i < matches.size(); ++i) {
+            EXPECT_NEAR(matches[i].distance, expected[i].second, 1e-4) << "query " << q << " at " << i;
+            if (matches[i].recipe != expected[i].first) {
+                // Only near ties, computed in float by the index, may come in another order
+                const bool tied = (i > 0 && expected[i].second - expected[i - 1].second < 1e-4) ||
+                                  (i + 1 < expected.size() && expected[i + 1].second - expected[i].second < 1e-4);
+                EXPECT_TRUE(tied) << "query " << q << " at " << i;
+            }
+        }
+    }
+}
+
+TEST(NutrientIndexTest, RejectsInvalidInput) {
+    EXPECT_THROW(NutrientIndex({nullptr}), std::invalid_argument);
+    EXPECT_THROW(NutrientIndex({makeRecipe("Salad", 350.0, 12.0, 18.0)}, {"fat", "fat"}), std::invalid_argument);
+
+    NutrientIndex index({makeRecipe("Salad", 350.0, 12.0, 18.0)}, {"calories", "protein"});
+    NutrientIndex::Query query;
+    query.targets = {{"fat", 10.0}};
+    EXPECT_THROW(index.search(query), std::invalid_argument);
+    query.targets = {{"calories", 300.0, -1.0}};
+    EXPECT_THROW(index.search(query), std::invalid_argument);
+    query.targets = {{"calories", 300.0}};
+    query.ranges = {{"sugar", 0.0, 10.0}};
+    EXPECT_THROW(index.search(query), std::invalid_argument);
+
+    query.ranges.clear();
+    query.limit = 0;
+    EXPECT_TRUE(index.search(query).empty());
+    EXPECT_TRUE(NutrientIndex(std::vector<std::shared_ptr<Recipe>>{}).search(NutrientIndex::Query()).empty());
+}
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <smart_food/algorithms/recipe_graph.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+std::shared_ptr<Ingredient> makeIngredient(const std::string& name, double quantity, double price, double kcal) {
+    auto ingredient = std::make_shared<Ingredient>(name, quantity, Ingredient::Unit::GRAM);
+    ingredient->setUnitPrice(price);
+    ingredient->addNutritionalInfo("calories", kcal);
+    return ingredient;
+}
+
+std::shared_ptr<Recipe> makeRecipe(const std::string& name, int servings) {
+    auto recipe = std::make_shared<Recipe>(name);
+    recipe->setServings(servings);
+    recipe->addStep({1, "Cook", std::chrono::minutes(10), std::nullopt, {}});
+    return recipe;
+}
+
+std::size_t position(const std::vector<std::string>& order, const std::string& id) {
+    return static_cast<std::size_t>(std::find(order.begin(), order.end(), id) - order.begin());
+}
+
+} // namespace
+
+TEST(RecipeGraphTest, RecipesUseOtherRecipes) {
+    auto sauce = makeRecipe("Tomato sauce", 4);
+    auto tomato = makeIngredient("Tomato", 800.0, 0.005, 160.0);
+    sauce->addIngredient(tomato);
+    auto pasta = makeRecipe("Pasta", 2);
+    pasta->addIngredient(makeIngredient("Spaghetti", 200.0, 0.01, 700.0));
+    pasta->addComponent(sauce, 1.0);
+
+    // One of four servings of sauce: a quarter of its cost and calories
+    EXPECT_DOUBLE_EQ(pasta->calculateTotalCost(), 2.0 + 1.0);
+    EXPECT_DOUBLE_EQ(pasta->getNutritionalInfo().at("calories"), 700.0 + 40.0);
+    pasta->addComponent(sauce, 1.0);
+    ASSERT_EQ(pasta->getComponents().size(), 1u);
+    EXPECT_DOUBLE_EQ(pasta->getComponents()[0].servings, 2.0);
+    EXPECT_DOUBLE_EQ(pasta->calculateTotalCost(), 4.0);
+
+    // Sub-recipes must not use the recipes using them
+    EXPECT_TRUE(pasta->uses(*sauce));
+    EXPECT_FALSE(sauce->uses(*pasta));
+    EXPECT_THROW(sauce->addComponent(pasta, 1.0), std::invalid_argument);
+    EXPECT_THROW(pasta->addComponent(pasta, 1.0), std::invalid_argument);
+    EXPECT_THROW(pasta->addComponent(nullptr, 1.0), std::invalid_argument);
+    EXPECT_THROW(pasta->addComponent(sauce, 0.0), std::invalid_argument);
+
+    // A component shared twice within the data is restored once
+    auto lasagna = makeRecipe("Lasagna", 6);
+    lasagna->addComponent(sauce, 2.0);
+    lasagna->addComponent(pasta, 1.0);
+    EXPECT_TRUE(lasagna->isValid());
+    Recipe copy = Recipe::deserialize(lasagna->serialize());
+    ASSERT_EQ(copy.getComponents().size(), 2u);
+    EXPECT_EQ(copy.getComponents()[0].recipe->getId(), sauce->getId());
+    EXPECT_EQ(copy.getComponents()[0].recipe, copy.getComponents()[1].recipe->getComponents()[0].recipe);
+    EXPECT_DOUBLE_EQ(copy.calculateTotalCost(), lasagna->calculateTotalCost());
+
+    // Expanded, the sauce counts once: two servings directly and one of pasta's two through it
+    auto expanded = lasagna->expandIngredients();
+    ASSERT_EQ(expanded.size(), 2u);
+    EXPECT_EQ(expanded[0]->getName(), "Spaghetti");
+    EXPECT_DOUBLE_EQ(expanded[0]->getQuantity(), 100.0);
+    EXPECT_EQ(expanded[1]->getName(), "Tomato");
+    EXPECT_DOUBLE_EQ(expanded[1]->getQuantity(), 600.0);
+    EXPECT_DOUBLE_EQ(tomato->getQuantity(), 800.0);
+
+    pasta->removeComponent(sauce->getId());
+    EXPECT_TRUE(pasta->getComponents().empty());
+    EXPECT_DOUBLE_EQ(pasta->getNutritionalInfo().at("calories"), 700.0);
+}
+
+TEST(RecipeGraphTest, ExpandsSharedComponentsOnce) {
+    // Each level uses the one below twice: 2^40 paths, two recipes per level
+    auto below = makeRecipe("Stock", 1);
+    below->addIngredient(makeIngredient("Bones", 1.0, 0.0, 0.0));
+    for (int level = 0; level < 40; ++level) {
+        auto half = makeRecipe("Half " + std::to_string(level), 1);
+        half->addComponent(below, 1.0);
+        auto above = makeRecipe("Level " + std::to_string(level), 1);
+        above->addComponent(below, 1.0);
+        above->addComponent(half, 1.0);
+        below = above;
+    }
+    auto expanded = below->expandIngredients();
+    ASSERT_EQ(expanded.size(), 1u);
+    EXPECT_DOUBLE_EQ(expanded[0]->getQuantity(), std::ldexp(1.0, 40));
+}
+
+TEST(RecipeGraphTest, EvaluatesSharedComponentsOnce) {
+    auto dough = makeRecipe("Dough", 4);
+    dough->addIngredient(makeIngredient("Flour", 1000.0, 0.002, 3640.0));
+    auto sauce = makeRecipe("Tomato sauce", 4);
+    sauce->addIngredient(makeIngredient("Tomato", 800.0, 0.005, 160.0));
+    std::vector<std::shared_ptr<Recipe>> pizzas;
+    for (const char* name : {"Margherita", "Marinara", "Funghi"}) {
+        auto pizza = makeRecipe(name, 1);
+        pizza->addComponent(dough, 1.0);
+        pizza->addComponent(sauce, 1.0);
+        pizza->addIngredient(makeIngredient("Cheese", 100.0, 0.02, 300.0));
+        pizzas.push_back(pizza);
+    }
+
+    RecipeGraph graph(pizzas);
+    EXPECT_EQ(graph.size(), 5u);
+    for (const auto& pizza : pizzas) {
+        const auto& totals = graph.evaluate(pizza->getId());
+        EXPECT_DOUBLE_EQ(totals.cost, pizza->calculateTotalCost());
+        EXPECT_DOUBLE_EQ(totals.nutrition.at("calories"), 910.0 + 40.0 + 300.0);
+    }
+    EXPECT_EQ(graph.getStats().evaluations, 5u);
+    graph.evaluate(pizzas[0]->getId());
+    EXPECT_EQ(graph.getStats().evaluations, 5u);
+
+    auto order = graph.getTopologicalOrder();
+    ASSERT_EQ(order.size(), 5u);
+    for (const auto& pizza : pizzas) {
+        EXPECT_LT(position(order, dough->getId()), position(order, pizza->getId()));
+        EXPECT_LT(position(order, sauce->getId()), position(order, pizza->getId()));
+    }
+    auto users = graph.getUsers(dough->getId());
+    EXPECT_EQ(users.size(), 3u);
+    EXPECT_TRUE(graph.getUsers(pizzas[0]->getId()).empty());
+    EXPECT_THROW(graph.evaluate("rec_missing"), std::out_of_range);
+    EXPECT_THROW(graph.addRecipe(nullptr), std::invalid_argument);
+}
+
+TEST(RecipeGraphTest, ChangesRecomputeOnlyAffectedRecipes) {
+    auto tomato = makeIngredient("Tomato", 800.0, 0.005, 160.0);
+    auto sauce = makeRecipe("Tomato sauce", 4);
+    sauce->addIngredient(tomato);
+    auto ragu = makeRecipe("Ragu", 4);
+    ragu->addComponent(sauce, 2.0);
+    ragu->addIngredient(makeIngredient("Beef", 500.0, 0.012, 1250.0));
+    auto lasagna = makeRecipe("Lasagna", 6);
+    lasagna->addComponent(ragu, 4.0);
+    auto salad = makeRecipe("Salad", 2);
+    salad->addIngredient(makeIngredient("Lettuce", 300.0, 0.004, 45.0));
+
+    RecipeGraph graph({lasagna, salad});
+    EXPECT_EQ(graph.size(), 4u);
+    for (const auto& id : graph.getTopologicalOrder()) {
+        graph.evaluate(id);
+    }
+    ASSERT_EQ(graph.getStats().evaluations, 4u);
+
+    // A price change reaches the sauce and everything built on it, not the salad
+    tomato->setUnitPrice(0.01);
+    EXPECT_EQ(graph.invalidateIngredient("  tomato "), 3u);
+    EXPECT_EQ(graph.invalidateIngredient("Tomato"), 0u);
+    EXPECT_EQ(graph.invalidateIngredient("Saffron"), 0u);
+    EXPECT_DOUBLE_EQ(graph.evaluate(lasagna->getId()).cost, lasagna->calculateTotalCost());
+    EXPECT_DOUBLE_EQ(graph.evaluate(lasagna->getId()).cost, (8.0 / 4.0 * 2.0 + 6.0) / 4.0 * 4.0);
+    graph.evaluate(salad->getId());
+    EXPECT_EQ(graph.getStats().evaluations, 7u);
+
+    // Editing a recipe picks up new components and invalidates its users only
+    auto stock = makeRecipe("Stock", 10);
+    stock->addIngredient(makeIngredient("Bones", 1000.0, 0.003, 400.0));
+    ragu->addComponent(stock, 1.0);
+    graph.updateRecipe(ragu->getId());
+    EXPECT_TRUE(graph.contains(stock->getId()));
+    EXPECT_DOUBLE_EQ(graph.evaluate(lasagna->getId()).cost, lasagna->calculateTotalCost());
+    EXPECT_DOUBLE_EQ(graph.evaluate(lasagna->getId()).nutrition.at("calories"),
+                     lasagna->getNutritionalInfo().at("calories") + 40.0);
+    EXPECT_EQ(graph.getStats().evaluations, 10u);
+    EXPECT_THROW(graph.updateRecipe("rec_missing"), std::out_of_range);
+}
+
+TEST(RecipeGraphTest, RejectsCyclesById) {
+    auto sauce = makeRecipe("Sauce", 2);
+    sauce->addIngredient(makeIngredient("Tomato", 400.0, 0.005, 80.0));
+    auto pasta = makeRecipe("Pasta", 2);
+    pasta->addComponent(sauce, 1.0);
+    RecipeGraph graph({pasta});
+
+    // A copy of the sauce is a different object with the same ID, so the
+    // recipe itself cannot see the cycle the graph would get
+    auto copy = std::make_shared<Recipe>(Recipe::deserialize(sauce->serialize()));
+    copy->addComponent(pasta, 1.0);
+    EXPECT_THROW(graph.addRecipe(copy), std::invalid_argument);
+    EXPECT_EQ(graph.size(), 2u);
+    EXPECT_TRUE(graph.getUsers(pasta->getId()).empty());
+    EXPECT_DOUBLE_EQ(graph.evaluate(pasta->getId()).cost, 1.0);
+}
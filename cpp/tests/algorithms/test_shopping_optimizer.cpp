@@ -0,0 +1,460 @@
+#include <gtest/gtest.h>
+#include <smart_food/algorithms/shopping_optimizer.hpp>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+
+const Clock::time_point kMonday = Clock::from_time_t(1700000000);
+
+Clock::time_point day(int offset) {
+    return kMonday + std::chrono::hours(24 * offset);
+}
+
+std::shared_ptr<Ingredient> makeIngredient(const std::string& name, double quantity, Ingredient::Unit unit,
+                                           double unitPrice = 0.0) {
+    auto ingredient = std::make_shared<Ingredient>(name, quantity, unit);
+    ingredient->setUnitPrice(unitPrice);
+    return ingredient;
+}
+
+std::shared_ptr<Meal> makeMeal(int dayOffset, const std::vector<std::shared_ptr<Ingredient>>& ingredients) {
+    auto meal = std::make_shared<Meal>("Meal", Meal::Type::DINNER);
+    meal->setPlannedTime(day(dayOffset));
+    for (const auto& ingredient : ingredients) {
+        meal->addIngredient(ingredient);
+    }
+    return meal;
+}
+
+ShoppingOptimizer::Options at(Clock::time_point now) {
+    ShoppingOptimizer::Options options;
+    options.now = now;
+    return options;
+}
+
+const ShoppingOptimizer::Item* findItem(const ShoppingOptimizer::ShoppingList& list, const std::string& name) {
+    for (const auto& item : list.items) {
+        if (item.ingredient == name) {
+            return &item;
+        }
+    }
+    return nullptr;
+}
+
+ShoppingOptimizer::Item makeItem(const std::string& name, double toBuy) {
+    return {name, Ingredient::Unit::GRAM, toBuy, 0.0, toBuy, 0.0, 1, day(0)};
+}
+
+/**
+ * Stores at random points of a 10 x 10 city, home at the center, each
+ * selling every item as one pack of exactly the quantity needed, or not
+ * selling it at all.
+ */
+struct City {
+    std::vector<std::string> stores;
+    std::vector<std::vector<double>> distances;
+    std::vector<std::vector<double>> prices;  ///< item x store, negative if not sold
+    ShoppingOptimizer::ShoppingList list;
+};
+
+City makeCity(int stores, int items, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> coordinate(0.0, 10.0);
+    std::uniform_real_distribution<double> price(1.0, 6.0);
+    std::bernoulli_distribution sold(0.6);
+
+    City city;
+    std::vector<std::pair<double, double>> points{{5.0, 5.0}};
+    for (int s = 0; s < stores; ++s) {
+        city.stores.push_back("Store " + std::to_string(s));
+        points.emplace_back(coordinate(rng), coordinate(rng));
+    }
+    for (const auto& a : points) {
+        city.distances.emplace_back();
+        for (const auto& b : points) {
+            city.distances.back().push_back(std::hypot(a.first - b.first, a.second - b.second));
+        }
+    }
+    for (int i = 0; i < items; ++i) {
+        city.list.items.push_back(makeItem("Item " + std::to_string(i), 100.0));
+        city.prices.emplace_back();
+        for (int s = 0; s < stores; ++s) {
+            city.prices.back().push_back(sold(rng) || s == i % stores ? price(rng) : -1.0);
+        }
+    }
+    return city;
+}
+
+ShoppingOptimizer makeOptimizer(const City& city) {
+    ShoppingOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{});
+    optimizer.setStores(city.stores, city.distances);
+    for (std::size_t i = 0; i < city.prices.size(); ++i) {
+        for (std::size_t s = 0; s < city.stores.size(); ++s) {
+            if (city.prices[i][s] >= 0.0) {
+                optimizer.addOffer(PackOffer(city.stores[s], city.list.items[i].ingredient, 100.0,
+                                             Ingredient::Unit::GRAM, city.prices[i][s]));
+            }
+        }
+    }
+    return optimizer;
+}
+
+/**
+ * Cheapest trip by trying every ordered sequence of distinct stores.
+ */
+double bruteForceTrip(const City& city) {
+    const std::size_t stores = city.stores.size();
+    double best = std::numeric_limits<double>::infinity();
+    std::vector<std::size_t> route;
+    std::vector<bool> used(stores, false);
+    std::function<void(double)> extend = [&](double length) {
+        double items = 0.0;
+        for (const auto& row : city.prices) {
+            double cheapest = std::numeric_limits<double>::infinity();
+            for (std::size_t s : route) {
+                if (row[s] >= 0.0) {
+                    cheapest = std::min(cheapest, row[s]);
+                }
+            }
+            items += cheapest;
+        }
+        const double back = route.empty() ? 0.0 : city.distances[route.back() + 1][0];
+        best = std::min(best, items + length + back);
+        for (std::size_t s = 0; s < stores; ++s) {
+            if (!used[s]) {
+                const double step = city.distances[route.empty() ? 0 : route.back() + 1][s + 1];
+                used[s] = true;
+                route.push_back(s);
+                extend(length + step);
+                route.pop_back();
+                used[s] = false;
+            }
+        }
+    };
+    extend(0.0);
+    return best;
+}
+
+} // namespace
+
+TEST(ShoppingOptimizerTest, AggregatesAcrossMealsAndUnits) {
+    std::vector<std::shared_ptr<Meal>> meals{
+        makeMeal(0, {makeIngredient("Flour", 500.0, Ingredient::Unit::GRAM, 0.002),
+                     makeIngredient("Milk", 1.0, Ingredient::Unit::LITER, 1.2)}),
+        makeMeal(1, {makeIngredient("  flour ", 1.0, Ingredient::Unit::KILOGRAM, 1.5),
+                     makeIngredient("Eggs", 3.0, Ingredient::Unit::PIECE, 0.3),
+                     makeIngredient("Milk", 250.0, Ingredient::Unit::MILLILITER, 0.001)}),
+        makeMeal(2, {makeIngredient("Milk", 2.0, Ingredient::Unit::CUP)})};
+
+    ShoppingOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{});
+    auto list = optimizer.buildList(meals, at(day(0)));
+
+    EXPECT_EQ(list.mealCount, 3u);
+    ASSERT_EQ(list.items.size(), 3u);
+    EXPECT_EQ(list.items[0].ingredient, "flour");
+    EXPECT_EQ(list.items[0].unit, Ingredient::Unit::GRAM);
+    EXPECT_DOUBLE_EQ(list.items[0].toBuy, 1500.0);
+    EXPECT_EQ(list.items[0].meals, 2u);
+    EXPECT_NEAR(list.items[0].estimatedCost, 2.5, 1e-12);
+    EXPECT_EQ(list.items[0].neededBy, day(0));
+
+    EXPECT_EQ(list.items[1].ingredient, "milk");
+    EXPECT_EQ(list.items[1].unit, Ingredient::Unit::MILLILITER);
+    EXPECT_NEAR(list.items[1].required, 1250.0 + 2.0 * 236.5882365, 1e-9);
+    EXPECT_EQ(list.items[1].meals, 3u);
+
+    EXPECT_EQ(list.items[2].ingredient, "eggs");
+    EXPECT_EQ(list.items[2].neededBy, day(1));
+    EXPECT_NEAR(list.totalCost, 2.5 + 1.45 + 0.9, 1e-12);
+}
+
+TEST(ShoppingOptimizerTest, NetsStockHonoringExpiry) {
+    auto milk = makeIngredient("Milk", 1.0, Ingredient::Unit::LITER);
+    milk->setExpiryDate(day(2));
+    auto soured = makeIngredient("Milk", 5.0, Ingredient::Unit::LITER);
+    soured->setExpiryDate(day(-1));
+    auto rice = makeIngredient("Rice", 2.0, Ingredient::Unit::KILOGRAM);  // No expiry date: keeps
+    // Tomatoes: the early lot must go to the early meal for both meals to be served
+    auto ripe = makeIngredient("Tomato", 3.0, Ingredient::Unit::PIECE);
+    ripe->setExpiryDate(day(2));
+    auto green = makeIngredient("Tomato", 4.0, Ingredient::Unit::PIECE);
+    green->setExpiryDate(day(10));
+
+    std::vector<std::shared_ptr<Meal>> meals{
+        makeMeal(1, {makeIngredient("Milk", 500.0, Ingredient::Unit::MILLILITER, 0.002),
+                     makeIngredient("Tomato", 3.0, Ingredient::Unit::PIECE)}),
+        makeMeal(3, {makeIngredient("Milk", 800.0, Ingredient::Unit::MILLILITER, 0.002),
+                     makeIngredient("Rice", 1500.0, Ingredient::Unit::GRAM),
+                     makeIngredient("Tomato", 4.0, Ingredient::Unit::PIECE)})};
+
+    ShoppingOptimizer optimizer({milk, soured, rice, ripe, green});
+    auto list = optimizer.buildList(meals, at(day(0)));
+
+    ASSERT_EQ(list.items.size(), 1u);
+    EXPECT_EQ(list.ingredientCount, 3u);
+    const auto* needed = findItem(list, "milk");
+    ASSERT_NE(needed, nullptr);
+    // Half a liter serves Monday; the rest spoils before Thursday
+    EXPECT_DOUBLE_EQ(needed->fromStock, 500.0);
+    EXPECT_DOUBLE_EQ(needed->toBuy, 800.0);
+    EXPECT_EQ(needed->neededBy, day(3));
+    EXPECT_NEAR(needed->estimatedCost, 1.6, 1e-12);
+
+    // A week later only the rice is still usable
+    list = optimizer.buildList(meals, at(day(5)));
+    EXPECT_EQ(findItem(list, "rice"), nullptr);
+    ASSERT_NE(findItem(list, "tomato"), nullptr);
+    EXPECT_DOUBLE_EQ(findItem(list, "tomato")->fromStock, 4.0);
+    EXPECT_DOUBLE_EQ(findItem(list, "milk")->toBuy, 1300.0);
+}
+
+TEST(ShoppingOptimizerTest, ListsIngredientsOfRecipeComponents) {
+    auto sauce = std::make_shared<Recipe>("Sauce");
+    sauce->addIngredient(makeIngredient("Tomato", 800.0, Ingredient::Unit::GRAM, 0.01));
+    sauce->setServings(2);
+    auto pasta = std::make_shared<Recipe>("Pasta");
+    pasta->addIngredient(makeIngredient("Spaghetti", 100.0, Ingredient::Unit::GRAM, 0.002));
+    pasta->addComponent(sauce, 1.0);
+    auto meal = makeMeal(1, {});
+    meal->setRecipe(pasta);
+
+    ShoppingOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{});
+    auto list = optimizer.buildList({meal}, at(day(0)));
+    ASSERT_EQ(list.items.size(), 2u);
+    ASSERT_NE(findItem(list, "tomato"), nullptr);
+    EXPECT_DOUBLE_EQ(findItem(list, "tomato")->toBuy, 400.0);
+    EXPECT_DOUBLE_EQ(findItem(list, "spaghetti")->toBuy, 100.0);
+    EXPECT_NEAR(list.totalCost, pasta->calculateTotalCost(), 1e-12);
+    // The recipe's own ingredients are left as they were
+    EXPECT_DOUBLE_EQ(sauce->getIngredients()[0]->getQuantity(), 800.0);
+}
+
+TEST(ShoppingOptimizerTest, SkipsCookedMealsAndRejectsNull) {
+    auto cooked = makeMeal(0, {makeIngredient("Beans", 200.0, Ingredient::Unit::GRAM)});
+    cooked->setStatus(Meal::Status::CONSUMED);
+    auto planned = makeMeal(1, {makeIngredient("Beans", 100.0, Ingredient::Unit::GRAM)});
+
+    ShoppingOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{});
+    auto list = optimizer.buildList({cooked, planned}, at(day(0)));
+    EXPECT_EQ(list.mealCount, 1u);
+    ASSERT_EQ(list.items.size(), 1u);
+    EXPECT_DOUBLE_EQ(list.items[0].toBuy, 100.0);
+
+    EXPECT_THROW(optimizer.buildList({planned, nullptr}), std::invalid_argument);
+    ShoppingOptimizer::Options options;
+    options.chunkSize = 0;
+    EXPECT_THROW(optimizer.buildList({planned}, options), std::invalid_argument);
+    EXPECT_THROW(ShoppingOptimizer(std::vector<std::shared_ptr<Ingredient>>{nullptr}), std::invalid_argument);
+}
+
+TEST(ShoppingOptimizerTest, ParallelChunksMatchSerialBuild) {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> pick(0, 99);
+    std::uniform_int_distribution<int> unit(0, 4);
+    std::uniform_real_distribution<double> amount(0.1, 3.0);
+
+    std::vector<std::shared_ptr<Ingredient>> pantry;
+    for (int i = 0; i < 40; ++i) {
+        auto lot = makeIngredient("Item " + std::to_string(pick(rng)), 5.0 * amount(rng), Ingredient::Unit::KILOGRAM);
+        lot->setExpiryDate(day(pick(rng) % 20));
+        pantry.push_back(lot);
+    }
+    std::vector<std::shared_ptr<Meal>> meals;
+    for (int m = 0; m < 3000; ++m) {
+        std::vector<std::shared_ptr<Ingredient>> ingredients;
+        for (int k = 0; k < 6; ++k) {
+            ingredients.push_back(makeIngredient("Item " + std::to_string(pick(rng)), amount(rng),
+                                                 static_cast<Ingredient::Unit>(unit(rng)), 0.01));
+        }
+        meals.push_back(makeMeal(m % 30, ingredients));
+    }
+
+    ShoppingOptimizer optimizer(pantry);
+    auto options = at(day(0));
+    options.chunkSize = 64;
+    options.threads = 1;
+    auto serial = optimizer.buildList(meals, options);
+    options.threads = 4;
+    auto parallel = optimizer.buildList(meals, options);
+
+    EXPECT_EQ(serial.mealCount, 3000u);
+    ASSERT_EQ(parallel.items.size(), serial.items.size());
+    for (std::size_t i = 0; i < serial.items.size(); ++i) {
+        EXPECT_EQ(parallel.items[i].ingredient, serial.items[i].ingredient);
+        EXPECT_EQ(parallel.items[i].unit, serial.items[i].unit);
+        EXPECT_EQ(parallel.items[i].toBuy, serial.items[i].toBuy);
+        EXPECT_EQ(parallel.items[i].meals, serial.items[i].meals);
+        EXPECT_EQ(parallel.items[i].neededBy, serial.items[i].neededBy);
+    }
+    EXPECT_EQ(parallel.totalCost, serial.totalCost);
+}
+
+TEST(ShoppingOptimizerTest, TripTradesPriceAgainstTravel) {
+    // The near store is dearer; the far one is only worth it when travel is cheap
+    ShoppingOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{});
+    optimizer.setStores({"Corner", "Outlet"}, {{0.0, 1.0, 10.0}, {1.0, 0.0, 10.0}, {10.0, 10.0, 0.0}});
+    optimizer.addOffer(PackOffer("Corner", "Rice", 500.0, Ingredient::Unit::GRAM, 5.0));
+    optimizer.addOffer(PackOffer("Outlet", "Rice", 1000.0, Ingredient::Unit::GRAM, 4.0));
+
+    ShoppingOptimizer::ShoppingList list;
+    list.items.push_back(makeItem("rice", 1000.0));
+
+    auto trip = optimizer.planTrip(list);
+    EXPECT_TRUE(trip.feasible);
+    EXPECT_TRUE(trip.optimal);
+    ASSERT_EQ(trip.visits.size(), 1u);
+    EXPECT_EQ(trip.visits[0].store, "Corner");
+    ASSERT_EQ(trip.visits[0].purchases.size(), 1u);
+    EXPECT_EQ(trip.visits[0].purchases[0].packs, 2);
+    EXPECT_DOUBLE_EQ(trip.itemCost, 10.0);
+    EXPECT_DOUBLE_EQ(trip.distance, 2.0);
+    EXPECT_DOUBLE_EQ(trip.totalCost, 12.0);
+
+    ShoppingOptimizer::TripOptions options;
+    options.costPerDistance = 0.1;
+    trip = optimizer.planTrip(list, options);
+    ASSERT_EQ(trip.visits.size(), 1u);
+    EXPECT_EQ(trip.visits[0].store, "Outlet");
+    EXPECT_DOUBLE_EQ(trip.totalCost, 4.0 + 0.1 * 20.0);
+}
+
+TEST(ShoppingOptimizerTest, ReusesCachedTrips) {
+    auto cache = std::make_shared<ShoppingOptimizer::Cache>(16, 1);
+    ShoppingOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{});
+    optimizer.setStores({"Corner", "Outlet"}, {{0.0, 1.0, 10.0}, {1.0, 0.0, 10.0}, {10.0, 10.0, 0.0}});
+    optimizer.addOffer(PackOffer("Corner", "Rice", 500.0, Ingredient::Unit::GRAM, 5.0));
+    optimizer.addOffer(PackOffer("Outlet", "Rice", 1000.0, Ingredient::Unit::GRAM, 4.0));
+    optimizer.setCache(cache);
+    ShoppingOptimizer::ShoppingList list;
+    list.items.push_back(makeItem("rice", 1000.0));
+
+    auto trip = optimizer.planTrip(list);
+    auto reused = optimizer.planTrip(list);
+    EXPECT_EQ(cache->getStats().hits, 1u);
+    ASSERT_EQ(reused.visits.size(), 1u);
+    EXPECT_EQ(reused.visits[0].store, trip.visits[0].store);
+    EXPECT_DOUBLE_EQ(reused.totalCost, trip.totalCost);
+
+    // A repriced offer is a different request
+    optimizer.addOffer(PackOffer("Corner", "Rice", 1000.0, Ingredient::Unit::GRAM, 3.0));
+    EXPECT_DOUBLE_EQ(optimizer.planTrip(list).totalCost, 5.0);
+    EXPECT_EQ(cache->getStats().misses, 2u);
+
+    // Heuristic trips depend on the time budget and are not stored
+    ShoppingOptimizer::TripOptions options;
+    options.exactStoreLimit = 0;
+    optimizer.planTrip(list, options);
+    EXPECT_EQ(cache->size(), 2u);
+}
+
+TEST(ShoppingOptimizerTest, TripMatchesBruteForce) {
+    for (unsigned seed = 0; seed < 6; ++seed) {
+        City city = makeCity(7, 12, seed);
+        ShoppingOptimizer optimizer = makeOptimizer(city);
+
+        ShoppingOptimizer::TripOptions options;
+        options.costPerDistance = 0.5 + seed;
+        auto exact = optimizer.planTrip(city.list, options);
+        EXPECT_TRUE(exact.optimal);
+        EXPECT_TRUE(exact.feasible);
+
+        // Costs are checked against the brute force at the same travel weight
+        for (auto& row : city.distances) {
+            for (auto& d : row) {
+                d *= options.costPerDistance;
+            }
+        }
+        const double reference = bruteForceTrip(city);
+        EXPECT_NEAR(exact.totalCost, reference, 1e-9) << "seed " << seed;
+
+        double bought = 0.0;
+        std::size_t purchases = 0;
+        for (const auto& visit : exact.visits) {
+            bought += visit.itemCost;
+            purchases += visit.purchases.size();
+        }
+        EXPECT_EQ(purchases, city.list.items.size());
+        EXPECT_NEAR(bought, exact.itemCost, 1e-9);
+        EXPECT_NEAR(exact.travelCost, options.costPerDistance * exact.distance, 1e-9);
+
+        options.exactStoreLimit = 0;
+        options.timeLimit = std::chrono::milliseconds(1000);
+        options.seed = seed;
+        auto heuristic = optimizer.planTrip(city.list, options);
+        EXPECT_FALSE(heuristic.optimal);
+        EXPECT_GE(heuristic.totalCost, reference - 1e-9);
+        EXPECT_LE(heuristic.totalCost, reference * 1.02) << "seed " << seed;
+    }
+}
+
+TEST(ShoppingOptimizerTest, TripHonorsControl) {
+    City city = makeCity(30, 40, 3);
+    ShoppingOptimizer optimizer = makeOptimizer(city);
+    ShoppingOptimizer::TripOptions options;
+    options.exactStoreLimit = 0;
+    options.timeLimit = std::chrono::milliseconds(60000);
+    options.maxRestarts = std::numeric_limits<std::size_t>::max();
+
+    // The control's deadline wins over the longer time limit
+    ShoppingOptimizer::Control control;
+    control.deadline = ShoppingOptimizer::Control::Clock::now() + std::chrono::milliseconds(100);
+    control.channel = std::make_shared<SolutionChannel<ShoppingOptimizer::Trip>>();
+    const auto start = std::chrono::steady_clock::now();
+    auto trip = optimizer.planTrip(city.list, options, control);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(10));
+    EXPECT_TRUE(trip.feasible);
+    auto progress = control.channel->progress();
+    EXPECT_TRUE(progress.finished);
+    EXPECT_GE(progress.improvements, 1u);
+    ASSERT_NE(control.channel->best(), nullptr);
+    EXPECT_NEAR(control.channel->bestCost(), trip.totalCost, 1e-9);
+    EXPECT_EQ(control.channel->best()->visits.size(), trip.visits.size());
+
+    // A cancelled run keeps the cheapest store of every item
+    ShoppingOptimizer::Control cancelled;
+    cancelled.cancellation.cancel();
+    cancelled.channel = std::make_shared<SolutionChannel<ShoppingOptimizer::Trip>>();
+    auto first = optimizer.planTrip(city.list, options, cancelled);
+    EXPECT_TRUE(first.feasible);
+    EXPECT_FALSE(first.visits.empty());
+    EXPECT_GE(first.totalCost, trip.totalCost - 1e-9);
+    EXPECT_TRUE(cancelled.channel->progress().finished);
+    EXPECT_NEAR(cancelled.channel->bestCost(), first.totalCost, 1e-9);
+}
+
+TEST(ShoppingOptimizerTest, TripReportsUncoveredAndRejectsBadInput) {
+    ShoppingOptimizer optimizer(std::vector<std::shared_ptr<Ingredient>>{});
+    optimizer.setStores({"Market"}, {{0.0, 2.0}, {2.0, 0.0}});
+    optimizer.addOffer(PackOffer("Market", "Oats", 500.0, Ingredient::Unit::GRAM, 2.0));
+
+    ShoppingOptimizer::ShoppingList list;
+    list.items.push_back(makeItem("Oats", 400.0));
+    list.items.push_back(makeItem("Saffron", 1.0));
+    auto trip = optimizer.planTrip(list);
+    EXPECT_FALSE(trip.feasible);
+    ASSERT_EQ(trip.uncovered.size(), 1u);
+    EXPECT_EQ(trip.uncovered[0], "Saffron");
+    ASSERT_EQ(trip.visits.size(), 1u);
+    EXPECT_DOUBLE_EQ(trip.totalCost, 6.0);
+
+    ShoppingOptimizer::TripOptions options;
+    options.exactStoreLimit = 17;
+    EXPECT_THROW(optimizer.planTrip(list, options), std::invalid_argument);
+    optimizer.addOffer(PackOffer("Bakery", "Oats", 500.0, Ingredient::Unit::GRAM, 1.0));
+    EXPECT_THROW(optimizer.planTrip(list), std::invalid_argument);
+
+    EXPECT_THROW(optimizer.setStores({"A", "A"}, {{0, 1, 1}, {1, 0, 1}, {1, 1, 0}}), std::invalid_argument);
+    EXPECT_THROW(optimizer.setStores({""}, {{0, 1}, {1, 0}}), std::invalid_argument);
+    EXPECT_THROW(optimizer.setStores({"A"}, {{0, 1}}), std::invalid_argument);
+    EXPECT_THROW(optimizer.setStores({"A"}, {{0, 1}, {2, 0}}), std::invalid_argument);
+    EXPECT_THROW(optimizer.setStores({"A"}, {{0, -1}, {-1, 0}}), std::invalid_argument);
+}
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <smart_food/algorithms/similarity_index.hpp>
+#include <algorithm>
+#include <random>
+#include <set>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+std::shared_ptr<Recipe> makeRecipe(const std::string& name, const std::vector<std::string>& ingredients) {
+    auto recipe = std::make_shared<Recipe>(name);
+    for (const auto& ingredient : ingredients) {
+        recipe->addIngredient(std::make_shared<Ingredient>(ingredient, 100.0, Ingredient::Unit::GRAM));
+    }
+    return recipe;
+}
+
+/// Random catalog where every fifth recipe is a variant of an earlier one with one ingredient swapped
+std::vector<std::shared_ptr<Recipe>> makeCatalog(int recipes, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, 499);
+    std::uniform_int_distribution<int> size(6, 12);
+    std::vector<std::vector<std::string>> lists;
+    std::vector<std::shared_ptr<Recipe>> catalog;
+    for (int r = 0; r < recipes; ++r) {
+        std::vector<std::string> ingredients;
+        if (r % 5 == 4) {
+            ingredients = lists[std::uniform_int_distribution<std::size_t>(0, lists.size() - 1)(rng)];
+            ingredients[0] = "Item " + std::to_string(pick(rng));
+        } else {
+            for (int i = size(rng); i > 0; --i) {
+                ingredients.push_back("Item " + std::to_string(pick(rng)));
+            }
+        }
+        lists.push_back(ingredients);
+        catalog.push_back(makeRecipe("Recipe " + std::to_string(r), ingredients));
+    }
+    return catalog;
+}
+
+} // namespace
+
+TEST(SimilarityIndexTest, ComparesIngredientNamesOnly) {
+    auto pesto = makeRecipe("Pesto", {"Basil", "Pine nuts", "Parmesan", "Garlic", "Olive oil"});
+    auto variant = std::make_shared<Recipe>("Pesto variant");
+    for (const auto& name : {"basil", " PINE  nuts", "Parmesan", "Garlic", "Olive oil", "Basil"}) {
+        variant->addIngredient(std::make_shared<Ingredient>(name, 2.0, Ingredient::Unit::TABLESPOON));
+    }
+    auto walnut = makeRecipe("Walnut pesto", {"Basil", "Walnuts", "Parmesan", "Garlic", "Olive oil"});
+    auto cake = makeRecipe("Cake", {"Flour", "Sugar", "Eggs", "Butter"});
+    EXPECT_DOUBLE_EQ(SimilarityIndex::similarity(*pesto, *variant), 1.0);
+    EXPECT_DOUBLE_EQ(SimilarityIndex::similarity(*pesto, *walnut), 4.0 / 6.0);
+    EXPECT_DOUBLE_EQ(SimilarityIndex::similarity(*pesto, *cake), 0.0);
+
+    SimilarityIndex index({pesto, variant, walnut, cake}, {32, 2, 1});
+    EXPECT_EQ(index.getRecipeCount(), 4u);
+    auto neighbors = index.findSimilar(pesto->getId(), 10);
+    ASSERT_EQ(neighbors.size(), 2u);
+    EXPECT_EQ(neighbors[0].recipe, variant);
+    EXPECT_DOUBLE_EQ(neighbors[0].similarity, 1.0);
+    EXPECT_EQ(neighbors[1].recipe, walnut);
+    EXPECT_TRUE(index.findSimilar(cake->getId(), 10).empty());
+
+    // Queries need not be indexed
+    auto query = makeRecipe("Query", {"Basil", "Pine nuts", "Parmesan", "Garlic"});
+    neighbors = index.findSimilar(*query, 1, 0.5);
+    ASSERT_EQ(neighbors.size(), 1u);
+    EXPECT_EQ(neighbors[0].recipe, pesto);  // Ties go to the recipe added first
+    EXPECT_DOUBLE_EQ(neighbors[0].similarity, 0.8);
+}
+
+TEST(SimilarityIndexTest, FindsNearDuplicatesLikeBruteForce) {
+    auto catalog = makeCatalog(2000, 3);
+    SimilarityIndex index(catalog);
+
+    // Every pair at 0.7 or more should be found, and nothing below the threshold
+    std::vector<std::set<std::string>> names;
+    for (const auto& recipe : catalog) {
+        names.emplace_back();
+        for (const auto& ingredient : recipe->getIngredients()) {
+            names.back().insert(ingredient->getName());
+        }
+    }
+    std::set<std::pair<std::size_t, std::size_t>> expected;
+    for (std::size_t a = 0; a < catalog.size(); ++a) {
+        for (std::size_t b = a + 1; b < catalog.size(); ++b) {
+            std::size_t shared = 0;
+            for (const auto& name : names[a]) {
+                shared += names[b].count(name);
+            }
+            if (shared >= 0.7 * static_cast<double>(names[a].size() + names[b].size() - shared)) {
+                expected.insert({a, b});
+            }
+        }
+    }
+    ASSERT_GT(expected.size(), 300u);
+    std::size_t found = 0;
+    for (const auto& pair : expected) {
+        auto neighbors = index.findSimilar(catalog[pair.first]->getId(), 50, 0.7);
+        for (const auto& neighbor : neighbors) {
+            EXPECT_GE(neighbor.similarity, 0.7);
+            EXPECT_DOUBLE_EQ(neighbor.similarity, SimilarityIndex::similarity(*catalog[pair.first], *neighbor.recipe));
+        }
+        found += std::any_of(neighbors.begin(), neighbors.end(),
+                             [&](const SimilarityIndex::Neighbor& n) { return n.recipe == catalog[pair.second]; });
+    }
+    EXPECT_GE(static_cast<double>(found), 0.97 * expected.size());
+
+    // Every duplicate group is linked by such pairs
+    auto groups = index.findDuplicates(0.7);
+    std::size_t grouped = 0;
+    for (const auto& group : groups) {
+        ASSERT_GE(group.size(), 2u);
+        grouped += group.size();
+        for (const auto& recipe : group) {
+            bool linked = false;
+            for (const auto& other : group) {
+                linked = linked || (other != recipe && SimilarityIndex::similarity(*recipe, *other) >= 0.7);
+            }
+            EXPECT_TRUE(linked) << recipe->getName();
+        }
+    }
+    std::set<std::size_t> inPairs;
+    for (const auto& pair : expected) {
+        inPairs.insert(pair.first);
+        inPairs.insert(pair.second);
+    }
+    EXPECT_GE(static_cast<double>(grouped), 0.97 * inPairs.size());
+    EXPECT_LE(grouped, inPairs.size());
+}
+
+TEST(SimilarityIndexTest, TracksCatalogChanges) {
+    auto soup = makeRecipe("Soup", {"Carrot", "Onion", "Celery", "Stock"});
+    auto stew = makeRecipe("Stew", {"Carrot", "Onion", "Celery", "Beef"});
+    SimilarityIndex index({soup, stew}, {32, 2, 0});
+    EXPECT_EQ(index.findSimilar(soup->getId(), 5).size(), 1u);
+    EXPECT_EQ(index.findDuplicates(0.5).size(), 1u);
+
+    // A soup under the same ID, now unlike the stew
+    auto broth = std::make_shared<Recipe>(*soup);
+    broth->removeIngredient(soup->getIngredients()[0]->getId());
+    broth->removeIngredient(soup->getIngredients()[1]->getId());
+    broth->removeIngredient(soup->getIngredients()[2]->getId());
+    broth->addIngredient(std::make_shared<Ingredient>("Bones", 1.0, Ingredient::Unit::KILOGRAM));
+    index.addRecipe(broth);
+    EXPECT_EQ(index.getRecipeCount(), 2u);
+    EXPECT_TRUE(index.findSimilar(stew->getId(), 5).empty());
+    EXPECT_TRUE(index.findDuplicates(0.5).empty());
+
+    EXPECT_TRUE(index.removeRecipe(stew->getId()));
+    EXPECT_FALSE(index.removeRecipe(stew->getId()));
+    EXPECT_THROW(index.findSimilar(stew->getId(), 5), std::out_of_range);
+    EXPECT_TRUE(index.findSimilar(*stew, 5).empty());
+}
+
+TEST(SimilarityIndexTest, RejectsInvalidInput) {
+    EXPECT_THROW(SimilarityIndex({nullptr}), std::invalid_argument);
+    EXPECT_THROW(SimilarityIndex({}, {0, 4, 0}), std::invalid_argument);
+    EXPECT_THROW(SimilarityIndex({}, {16, 0, 0}), std::invalid_argument);
+    auto empty = makeRecipe("Nothing", {});
+    SimilarityIndex index({makeRecipe("Toast", {"Bread"}), empty});
+    EXPECT_THROW(index.addRecipe(nullptr), std::invalid_argument);
+    EXPECT_THROW(index.findDuplicates(1.5), std::invalid_argument);
+    EXPECT_TRUE(index.findSimilar(empty->getId(), 5).empty());
+    EXPECT_TRUE(index.removeRecipe(empty->getId()));
+}
@@ -0,0 +1,309 @@
+#include <gtest/gtest.h>
+#include <smart_food/algorithms/waste_calculator.hpp>
+#include <algorithm>
+#include <random>
+
+using namespace smart_food::core;
+using namespace smart_food::algorithms;
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+
+const Clock::time_point kMonday = Clock::from_time_t(1700000000);
+
+Clock::time_point day(double offset) {
+    return kMonday + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(86400.0 * offset));
+}
+
+std::shared_ptr<Ingredient> makeLot(const std::string& name, double quantity, Ingredient::Unit unit,
+                                    double unitPrice, Clock::time_point expiry = Clock::time_point{}) {
+    auto lot = std::make_shared<Ingredient>(name, quantity, unit);
+    lot->setUnitPrice(unitPrice);
+    lot->setExpiryDate(expiry);
+    return lot;
+}
+
+std::shared_ptr<Meal> makeMeal(Clock::time_point time, const std::vector<std::shared_ptr<Ingredient>>& ingredients) {
+    auto meal = std::make_shared<Meal>("Meal", Meal::Type::DINNER);
+    meal->setPlannedTime(time);
+    for (const auto& ingredient : ingredients) {
+        meal->addIngredient(ingredient);
+    }
+    return meal;
+}
+
+} // namespace
+
+TEST(WasteCalculatorTest, ConsumesFirstExpiringLotFirst) {
+    // 1 L of milk going off on day 2 and 1 L on day 5; meals drink 1.2 L by day 4
+    WasteCalculator calculator({makeLot("Milk", 1.0, Ingredient::Unit::LITER, 1.0, day(5)),
+                                makeLot("milk ", 1000.0, Ingredient::Unit::MILLILITER, 0.002, day(2)),
+                                makeLot("Rice", 1.0, Ingredient::Unit::KILOGRAM, 2.0)});
+    std::vector<std::shared_ptr<Meal>> meals{
+        makeMeal(day(1), {makeLot("Milk", 600.0, Ingredient::Unit::MILLILITER, 0.0),
+                          makeLot("Rice", 200.0, Ingredient::Unit::GRAM, 0.0)}),
+        makeMeal(day(4), {makeLot("Milk", 600.0, Ingredient::Unit::MILLILITER, 0.0)})};
+
+    auto projection = calculator.simulate(meals, day(0), day(7));
+    EXPECT_EQ(projection.mealCount, 2u);
+    EXPECT_TRUE(projection.shortages.empty());
+    ASSERT_EQ(projection.waste.size(), 2u);
+    // 400 ml of the early lot spoil on day 2, then 400 ml of the late one on day 5
+    EXPECT_EQ(projection.waste[0].ingredient, "milk");
+    EXPECT_EQ(projection.waste[0].unit, Ingredient::Unit::MILLILITER);
+    EXPECT_NEAR(projection.waste[0].quantity, 400.0, 1e-9);
+    EXPECT_NEAR(projection.waste[0].cost, 0.8, 1e-9);
+    EXPECT_EQ(projection.waste[0].expiredAt, day(2));
+    EXPECT_NEAR(projection.waste[1].quantity, 400.0, 1e-9);
+    EXPECT_NEAR(projection.waste[1].cost, 0.4, 1e-9);
+    EXPECT_NEAR(projection.wasteCost, 1.2, 1e-9);
+    ASSERT_EQ(projection.dailyWasteCost.size(), 8u);
+    EXPECT_NEAR(projection.dailyWasteCost[2], 0.8, 1e-9);
+    EXPECT_NEAR(projection.dailyWasteCost[5], 0.4, 1e-9);
+
+    // Rice keeps and the horizon ends before the second lot spoils
+    projection = calculator.simulate(meals, day(0), day(4.5));
+    EXPECT_NEAR(projection.wasteCost, 0.8, 1e-9);
+}
+
+TEST(WasteCalculatorTest, HandlesArrivalsShortagesAndExpiryDay) {
+    WasteCalculator calculator({makeLot("Bread", 1.0, Ingredient::Unit::PIECE, 3.0, day(1))});
+    calculator.addPurchase(makeLot("Bread", 2.0, Ingredient::Unit::PIECE, 2.5, day(6)), day(3));
+    calculator.addPurchase(makeLot("Fish", 500.0, Ingredient::Unit::GRAM, 0.02, day(2)), day(4));
+
+    std::vector<std::shared_ptr<Meal>> meals{
+        makeMeal(day(1), {makeLot("Bread", 1.0, Ingredient::Unit::PIECE, 0.0)}),   // Last day of the first loaf
+        makeMeal(day(2), {makeLot("Bread", 1.0, Ingredient::Unit::PIECE, 0.0)}),   // Before the purchase
+        makeMeal(day(3), {makeLot("Bread", 1.0, Ingredient::Unit::PIECE, 0.0)}),   // On arrival
+        makeMeal(day(4), {makeLot("Fish", 200.0, Ingredient::Unit::GRAM, 0.0),     // Arrives spoiled
+                          makeLot("Eggs", 2.0, Ingredient::Unit::PIECE, 0.0)})};   // Never stocked
+    auto cooked = makeMeal(day(2), {makeLot("Bread", 5.0, Ingredient::Unit::PIECE, 0.0)});
+    cooked->setStatus(Meal::Status::CONSUMED);
+    meals.push_back(cooked);
+
+    auto projection = calculator.simulate(meals, day(0), day(10));
+    EXPECT_EQ(projection.mealCount, 4u);
+    ASSERT_EQ(projection.shortages.size(), 3u);
+    EXPECT_EQ(projection.shortages[0].ingredient, "bread");
+    EXPECT_EQ(projection.shortages[0].neededAt, day(2));
+    EXPECT_EQ(projection.shortages[1].ingredient, "fish");
+    EXPECT_NEAR(projection.shortages[1].quantity, 200.0, 1e-9);
+    EXPECT_EQ(projection.shortages[2].ingredient, "eggs");
+    ASSERT_EQ(projection.waste.size(), 2u);
+    EXPECT_EQ(projection.waste[0].ingredient, "fish");
+    EXPECT_EQ(projection.waste[0].expiredAt, day(4));
+    EXPECT_NEAR(projection.waste[0].cost, 10.0, 1e-9);
+    EXPECT_EQ(projection.waste[1].ingredient, "bread");
+    EXPECT_NEAR(projection.waste[1].cost, 2.5, 1e-9);
+
+    // Purchases arriving after the horizon are left out
+    projection = calculator.simulate(meals, day(0), day(2.5));
+    EXPECT_EQ(projection.shortages.size(), 1u);
+    EXPECT_DOUBLE_EQ(projection.wasteCost, 0.0);
+
+    calculator.clearPurchases();
+    projection = calculator.simulate(meals, day(0), day(10));
+    EXPECT_EQ(projection.shortages.size(), 4u);
+    EXPECT_DOUBLE_EQ(projection.wasteCost, 0.0);
+}
+
+TEST(WasteCalculatorTest, RandomHouseholdsMatchReference) {
+    // Reference: meals in time order take from the earliest-expiring usable
+    // lot; what is left of lots expiring within the horizon is waste
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> item(0, 7);
+    std::uniform_real_distribution<double> when(0.0, 30.0);
+    std::uniform_real_distribution<double> amount(50.0, 800.0);
+    std::uniform_real_distribution<double> price(0.001, 0.02);
+    std::bernoulli_distribution keeps(0.2);
+
+    for (int round = 0; round < 20; ++round) {
+        struct RefLot {
+            int item;
+            double quantity;
+            double price;
+            Clock::time_point arrival;
+            Clock::time_point expiry;
+        };
+        std::vector<RefLot> lots;
+        std::vector<std::shared_ptr<Ingredient>> inventory;
+        WasteCalculator calculator(std::vector<std::shared_ptr<Ingredient>>{});
+        for (int l = 0; l < 30; ++l) {
+            RefLot lot{item(rng), amount(rng), price(rng), Clock::time_point::min(),
+                       keeps(rng) ? Clock::time_point::max() : day(when(rng))};
+            auto ingredient = makeLot("Item " + std::to_string(lot.item), lot.quantity, Ingredient::Unit::GRAM,
+                                      lot.price, lot.expiry == Clock::time_point::max() ? Clock::time_point{}
+                                                                                          : lot.expiry);
+            if (l % 2) {
+                lot.arrival = day(when(rng));
+                calculator.addPurchase(ingredient, lot.arrival);
+            } else {
+                inventory.push_back(ingredient);
+            }
+            lots.push_back(lot);
+        }
+        calculator.setInventory(inventory);
+
+        std::vector<std::shared_ptr<Meal>> meals;
+        std::vector<std::pair<Clock::time_point, std::pair<int, double>>> uses;
+        for (int m = 0; m < 60; ++m) {
+            const auto time = day(when(rng));
+            const int used = item(rng);
+            const double quantity = amount(rng) / 3.0;
+            meals.push_back(makeMeal(time, {makeLot("item " + std::to_string(used), quantity,
+                                                    Ingredient::Unit::GRAM, 0.0)}));
+            uses.push_back({time, {used, quantity}});
+        }
+        std::sort(uses.begin(), uses.end());
+
+        double shortage = 0.0;
+        for (const auto& use : uses) {
+            double missing = use.second.second;
+            while (missing > 1e-12) {
+                RefLot* best = nullptr;
+                for (auto& lot : lots) {
+                    if (lot.item == use.second.first && lot.quantity > 0.0 && lot.arrival <= use.first &&
+                        lot.expiry >= use.first && (!best || lot.expiry < best->expiry)) {
+                        best = &lot;
+                    }
+                }
+                if (!best) {
+                    break;
+                }
+                const double taken = std::min(missing, best->quantity);
+                best->quantity -= taken;
+                missing -= taken;
+            }
+            shortage += missing;
+        }
+        double waste = 0.0;
+        for (const auto& lot : lots) {
+            if (lot.expiry <= day(30)) {
+                waste += lot.quantity * lot.price;
+            }
+        }
+
+        auto projection = calculator.simulate(meals, day(0), day(30));
+        double missing = 0.0;
+        for (const auto& s : projection.shortages) {
+            missing += s.quantity;
+        }
+        double daily = 0.0;
+        for (double cost : projection.dailyWasteCost) {
+            daily += cost;
+        }
+        EXPECT_NEAR(projection.wasteCost, waste, 1e-9) << "round " << round;
+        EXPECT_NEAR(daily, waste, 1e-9) << "round " << round;
+        EXPECT_NEAR(missing, shortage, 1e-6) << "round " << round;
+    }
+}
+
+TEST(WasteCalculatorTest, RiskWithoutUncertaintyMatchesSimulation) {
+    std::mt19937 rng(4);
+    std::uniform_int_distribution<int> item(0, 5);
+    std::uniform_real_distribution<double> when(0.0, 14.0);
+    std::uniform_real_distribution<double> amount(100.0, 600.0);
+
+    std::vector<std::shared_ptr<Ingredient>> inventory;
+    for (int l = 0; l < 12; ++l) {
+        inventory.push_back(makeLot("Item " + std::to_string(item(rng)), amount(rng), Ingredient::Unit::GRAM, 0.01,
+                                    day(when(rng))));
+    }
+    WasteCalculator calculator(inventory);
+    calculator.addPurchase(makeLot("Item 1", 500.0, Ingredient::Unit::GRAM, 0.02, day(9)), day(5));
+    std::vector<std::shared_ptr<Meal>> meals;
+    for (int m = 0; m < 20; ++m) {
+        meals.push_back(makeMeal(day(when(rng)), {makeLot("Item " + std::to_string(item(rng)), amount(rng) / 2.0,
+                                                          Ingredient::Unit::GRAM, 0.0)}));
+    }
+
+    WasteCalculator::RiskOptions options;
+    options.scenarios = 37;
+    options.skipProbability = 0.0;
+    options.portionSpread = 0.0;
+    options.spoilageSpreadDays = 0.0;
+    auto risk = calculator.estimateRisk(meals, day(0), day(14), options);
+    auto projection = calculator.simulate(meals, day(0), day(14));
+    EXPECT_GT(projection.wasteCost, 0.0);
+    EXPECT_NEAR(risk.expectedCost, projection.wasteCost, 1e-9);
+    EXPECT_NEAR(risk.standardDeviation, 0.0, 1e-9);
+    ASSERT_EQ(risk.percentileCosts.size(), 3u);
+    for (double cost : risk.percentileCosts) {
+        EXPECT_NEAR(cost, projection.wasteCost, 1e-9);
+    }
+    double byIngredient = 0.0;
+    for (const auto& ingredient : risk.ingredients) {
+        EXPECT_DOUBLE_EQ(ingredient.probability, 1.0);
+        byIngredient += ingredient.expectedCost;
+    }
+    EXPECT_NEAR(byIngredient, projection.wasteCost, 1e-9);
+}
+
+TEST(WasteCalculatorTest, RiskIsReproducibleAndCalibrated) {
+    // A liter of milk is wasted exactly when the one meal using it is skipped
+    WasteCalculator calculator({makeLot("Milk", 1000.0, Ingredient::Unit::MILLILITER, 0.002, day(3)),
+                                makeLot("Cheese", 200.0, Ingredient::Unit::GRAM, 0.02, day(4))});
+    std::vector<std::shared_ptr<Meal>> meals{
+        makeMeal(day(2), {makeLot("Milk", 1.0, Ingredient::Unit::LITER, 0.0)}),
+        makeMeal(day(3.5), {makeLot("Cheese", 150.0, Ingredient::Unit::GRAM, 0.0)})};
+
+    WasteCalculator::RiskOptions options;
+    options.scenarios = 4000;
+    options.skipProbability = 0.3;
+    options.portionSpread = 0.2;
+    options.spoilageSpreadDays = 0.5;
+    options.seed = 99;
+    options.threads = 1;
+    auto serial = calculator.estimateRisk(meals, day(0), day(7), options);
+    options.threads = 4;
+    auto parallel = calculator.estimateRisk(meals, day(0), day(7), options);
+
+    EXPECT_EQ(parallel.expectedCost, serial.expectedCost);
+    EXPECT_EQ(parallel.standardDeviation, serial.standardDeviation);
+    EXPECT_EQ(parallel.percentileCosts, serial.percentileCosts);
+    ASSERT_EQ(parallel.ingredients.size(), serial.ingredients.size());
+    for (std::size_t i = 0; i < serial.ingredients.size(); ++i) {
+        EXPECT_EQ(parallel.ingredients[i].expectedCost, serial.ingredients[i].expectedCost);
+    }
+
+    // Milk: 2 wasted when skipped, and an over-poured meal leaves nothing
+    const WasteCalculator::IngredientRisk* milk = nullptr;
+    for (const auto& ingredient : serial.ingredients) {
+        if (ingredient.ingredient == "milk") {
+            milk = &ingredient;
+        }
+    }
+    ASSERT_NE(milk, nullptr);
+    EXPECT_GT(milk->probability, 0.3 - 0.03);
+    EXPECT_LT(milk->probability, 0.3 + 0.55 * 0.7);
+    EXPECT_GT(serial.expectedCost, 0.3 * 2.0 * 0.9);
+    EXPECT_LE(serial.percentileCosts[0], serial.percentileCosts[2]);
+
+    options.seed = 100;
+    auto reseeded = calculator.estimateRisk(meals, day(0), day(7), options);
+    EXPECT_NE(reseeded.expectedCost, serial.expectedCost);
+}
+
+TEST(WasteCalculatorTest, RejectsMalformedInput) {
+    WasteCalculator calculator(std::vector<std::shared_ptr<Ingredient>>{});
+    EXPECT_THROW(calculator.simulate({}, day(2), day(1)), std::invalid_argument);
+    EXPECT_THROW(calculator.simulate({nullptr}, day(0), day(1)), std::invalid_argument);
+    EXPECT_THROW(calculator.addPurchase(nullptr, day(0)), std::invalid_argument);
+    EXPECT_THROW(WasteCalculator(std::vector<std::shared_ptr<Ingredient>>{nullptr}), std::invalid_argument);
+    EXPECT_EQ(calculator.simulate({}, day(0), day(0)).dailyWasteCost.size(), 1u);
+
+    WasteCalculator::RiskOptions options;
+    EXPECT_THROW(calculator.estimateRisk({}, day(2), day(1), options), std::invalid_argument);
+    options.scenarios = 0;
+    EXPECT_THROW(calculator.estimateRisk({}, day(0), day(1), options), std::invalid_argument);
+    options.scenarios = 10;
+    options.skipProbability = 1.5;
+    EXPECT_THROW(calculator.estimateRisk({}, day(0), day(1), options), std::invalid_argument);
+    options.skipProbability = 0.1;
+    options.portionSpread = -0.1;
+    EXPECT_THROW(calculator.estimateRisk({}, day(0), day(1), options), std::invalid_argument);
+    options.portionSpread = 0.1;
+    options.percentiles = {0.5, 1.2};
+    EXPECT_THROW(calculator.estimateRisk({}, day(0), day(1), options), std::invalid_argument);
+}
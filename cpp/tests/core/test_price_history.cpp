@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include <smart_food/core/price_history.hpp>
+#include <algorithm>
+#include <random>
+
+using namespace smart_food::core;
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+
+const Clock::time_point kStart = Clock::from_time_t(1700000000);
+
+Clock::time_point hours(long offset) {
+    return kStart + std::chrono::hours(offset);
+}
+
+} // namespace
+
+TEST(PriceHistoryTest, RoundTripsIrregularSeries) {
+    // Irregular gaps, repeated timestamps and prices that jump around
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> gap(0, 200000);
+    std::uniform_int_distribution<int> cents(1, 2000);
+    std::bernoulli_distribution changes(0.3);
+
+    PriceHistory history;
+    std::vector<PriceHistory::Point> expected;
+    Clock::time_point time = kStart;
+    double price = 2.49;
+    for (int i = 0; i < 3000; ++i) {
+        time += std::chrono::seconds(i % 7 == 0 ? 0 : gap(rng));
+        if (changes(rng)) {
+            price = cents(rng) / 100.0;
+        }
+        if (i == 1500) {
+            price = 1e-300;  // Extreme values survive the XOR coding
+        }
+        history.record("Milk 1L", "Corner", time, price);
+        expected.push_back({time, price});
+    }
+
+    auto points = history.range("Milk 1L", "Corner", kStart, time);
+    ASSERT_EQ(points.size(), expected.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        EXPECT_EQ(points[i].time, expected[i].time) << i;
+        EXPECT_EQ(points[i].price, expected[i].price) << i;
+    }
+    EXPECT_EQ(history.getPointCount(), 3000u);
+    EXPECT_EQ(history.latestPrice("Milk 1L", "Corner").price, price);
+    EXPECT_EQ(history.latestPrice("Milk 1L", "Corner").time, time);
+}
+
+TEST(PriceHistoryTest, RoundTripsTimestampBucketBoundaries) {
+    // Each change in the gap, and its negation, lands on either side of every code bucket's limits
+    const long changes[] = {1, 63, 64, 65, 255, 256, 257, 2047, 2048, 2049, 1000000};
+    PriceHistory history;
+    std::vector<Clock::time_point> expected = {kStart};
+    Clock::time_point time = kStart;
+    long gap = 2000000;
+    history.record("Eggs 6", "Corner", time, 1.99);
+    for (long change : changes) {
+        for (long signedChange : {change, -change, -change, change}) {
+            gap += signedChange;
+            time += std::chrono::seconds(gap);
+            history.record("Eggs 6", "Corner", time, 1.99);
+            expected.push_back(time);
+        }
+    }
+
+    auto points = history.range("Eggs 6", "Corner", kStart, time);
+    ASSERT_EQ(points.size(), expected.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        EXPECT_EQ(points[i].time, expected[i]) << i;
+    }
+}
+
+TEST(PriceHistoryTest, SummarizesRangesAcrossBlocks) {
+    PriceHistory history;
+    std::vector<double> prices;
+    for (int h = 0; h < 5000; ++h) {
+        const double price = 1.0 + (h % 97) / 100.0;
+        history.record("Rice 1kg", "Outlet", hours(h), price);
+        prices.push_back(price);
+    }
+
+    for (auto range : {std::make_pair(0, 4999), std::make_pair(100, 3100), std::make_pair(511, 513),
+                       std::make_pair(1024, 1024)}) {
+        auto summary = history.summarize("Rice 1kg", "Outlet", hours(range.first), hours(range.second));
+        auto first = prices.begin() + range.first;
+        auto last = prices.begin() + range.second + 1;
+        double sum = 0.0;
+        for (auto it = first; it != last; ++it) {
+            sum += *it;
+        }
+        EXPECT_EQ(summary.store, "Outlet");
+        EXPECT_EQ(summary.count, static_cast<std::size_t>(last - first));
+        EXPECT_DOUBLE_EQ(summary.minPrice, *std::min_element(first, last));
+        EXPECT_DOUBLE_EQ(summary.maxPrice, *std::max_element(first, last));
+        EXPECT_NEAR(summary.meanPrice, sum / (last - first), 1e-9);
+        EXPECT_EQ(summary.first.time, hours(range.first));
+        EXPECT_EQ(summary.last.time, hours(range.second));
+        EXPECT_EQ(summary.last.price, prices[range.second]);
+    }
+    EXPECT_EQ(history.summarize("Rice 1kg", "Outlet", hours(6000), hours(7000)).count, 0u);
+    EXPECT_EQ(history.summarize("Rice 1kg", "Elsewhere", hours(0), hours(10)).count, 0u);
+}
+
+TEST(PriceHistoryTest, ComparesStores) {
+    PriceHistory history;
+    history.record("Eggs", "Corner", hours(0), 3.20);
+    history.record("Eggs", "Corner", hours(24), 3.40);
+    history.record("Eggs", "Market", hours(0), 3.50);
+    history.record("Eggs", "Market", hours(30), 2.90);
+    history.record("Eggs", "Outlet", hours(1), 3.00);
+    history.record("Flour", "Corner", hours(2), 1.10);
+
+    auto latest = history.latestPrices("Eggs");
+    ASSERT_EQ(latest.size(), 3u);
+    EXPECT_EQ(latest[0].store, "Market");
+    EXPECT_DOUBLE_EQ(latest[0].price, 2.90);
+    EXPECT_EQ(latest[0].time, hours(30));
+    EXPECT_EQ(latest[1].store, "Outlet");
+    EXPECT_EQ(latest[2].store, "Corner");
+    EXPECT_TRUE(history.latestPrices("Butter").empty());
+
+    auto summaries = history.summarizeStores("Eggs", hours(0), hours(24));
+    ASSERT_EQ(summaries.size(), 3u);
+    EXPECT_EQ(summaries[0].store, "Outlet");
+    EXPECT_EQ(summaries[1].store, "Corner");
+    EXPECT_DOUBLE_EQ(summaries[1].meanPrice, 3.30);
+    EXPECT_EQ(summaries[2].store, "Market");
+    EXPECT_EQ(summaries[2].count, 1u);
+    EXPECT_EQ(history.getSeriesCount(), 4u);
+}
+
+TEST(PriceHistoryTest, StaysCompactAndRejectsBadInput) {
+    // A daily price over ten years at 200 stores, changing about weekly
+    PriceHistory history;
+    std::mt19937 rng(9);
+    std::bernoulli_distribution changes(1.0 / 7.0);
+    std::uniform_int_distribution<int> cents(150, 450);
+    for (int store = 0; store < 200; ++store) {
+        double price = cents(rng) / 100.0;
+        for (int day = 0; day < 3650; ++day) {
+            if (changes(rng)) {
+                price = cents(rng) / 100.0;
+            }
+            history.record("Butter 250g", "Store " + std::to_string(store), hours(24L * day), price);
+        }
+    }
+    EXPECT_EQ(history.getPointCount(), 730000u);
+    EXPECT_LT(static_cast<double>(history.memoryUsage()) / history.getPointCount(), 3.0);
+
+    EXPECT_THROW(history.record("", "Corner", hours(0), 1.0), std::invalid_argument);
+    EXPECT_THROW(history.record("Butter 250g", "", hours(0), 1.0), std::invalid_argument);
+    EXPECT_THROW(history.record("Butter 250g", "Corner", hours(0), -1.0), std::invalid_argument);
+    EXPECT_THROW(history.record("Butter 250g", "Corner", hours(0), std::nan("")), std::invalid_argument);
+    EXPECT_THROW(history.record("Butter 250g", "Store 0", hours(0), 1.0), std::invalid_argument);
+    EXPECT_THROW(history.latestPrice("Butter 250g", "Corner"), std::out_of_range);
+    EXPECT_FALSE(history.hasSeries("Butter 250g", "Corner"));
+    EXPECT_EQ(history.getSeriesCount(), 200u);
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <smart_food/core/storage.hpp>
+#include <cstdio>
+
+using namespace smart_food::core;
+
+class StorageTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Storage::getInstance().clear();
+    }
+
+    void TearDown() override {
+        Storage::getInstance().clear();
+    }
+};
+
+TEST_F(StorageTest, ManagesRecipesIngredientsAndMeals) {
+    auto& storage = Storage::getInstance();
+    auto recipe = std::make_shared<Recipe>("Tomato Soup", "Slow-cooked tomatoes");
+    auto tomato = std::make_shared<Ingredient>("Tomato", 500.0, Ingredient::Unit::GRAM);
+    auto lunch = std::make_shared<Meal>("Monday lunch", Meal::Type::LUNCH);
+    storage.addRecipe(recipe);
+    storage.addIngredient(tomato);
+    storage.addMeal(lunch);
+
+    EXPECT_EQ(storage.getRecipe(recipe->getId()), recipe);
+    EXPECT_EQ(storage.getIngredient(tomato->getId()), tomato);
+    EXPECT_EQ(storage.getMeal("Monday lunch"), lunch);
+    EXPECT_EQ(storage.searchRecipes("tomatoes").size(), 1u);
+    EXPECT_TRUE(storage.searchRecipes("curry").empty());
+    EXPECT_THROW(storage.addRecipe(recipe), std::invalid_argument);
+    EXPECT_THROW(storage.addIngredient(nullptr), std::invalid_argument);
+
+    storage.removeRecipe(recipe->getId());
+    EXPECT_EQ(storage.getRecipe(recipe->getId()), nullptr);
+    EXPECT_THROW(storage.removeRecipe(recipe->getId()), std::invalid_argument);
+    EXPECT_THROW(storage.updateRecipe(recipe), std::invalid_argument);
+}
+
+TEST_F(StorageTest, EveryMutationBumpsTheVersion) {
+    auto& storage = Storage::getInstance();
+    auto recipe = std::make_shared<Recipe>("Pancakes");
+    auto flour = std::make_shared<Ingredient>("Flour", 1000.0, Ingredient::Unit::GRAM);
+    auto breakfast = std::make_shared<Meal>("Sunday breakfast");
+
+    std::uint64_t version = storage.getVersion();
+    auto bumped = [&]() {
+        const std::uint64_t current = storage.getVersion();
+        const bool changed = current > version;
+        version = current;
+        return changed;
+    };
+    storage.addRecipe(recipe);
+    EXPECT_TRUE(bumped());
+    storage.updateRecipe(recipe);
+    EXPECT_TRUE(bumped());
+    storage.addIngredient(flour);
+    EXPECT_TRUE(bumped());
+    storage.updateIngredient(flour);
+    EXPECT_TRUE(bumped());
+    storage.addMeal(breakfast);
+    EXPECT_TRUE(bumped());
+    storage.updateMeal(breakfast);
+    EXPECT_TRUE(bumped());
+
+    const std::string path = ::testing::TempDir() + "storage.json";
+    storage.saveToFile(path);
+    EXPECT_FALSE(bumped());
+    storage.removeMeal("Sunday breakfast");
+    EXPECT_TRUE(bumped());
+    storage.removeIngredient(flour->getId());
+    EXPECT_TRUE(bumped());
+    storage.removeRecipe(recipe->getId());
+    EXPECT_TRUE(bumped());
+    storage.clear();
+    EXPECT_TRUE(bumped());
+
+    // Loading restores the saved contents
+    storage.loadFromFile(path);
+    EXPECT_TRUE(bumped());
+    std::remove(path.c_str());
+    EXPECT_EQ(storage.getRecipes().size(), 1u);
+    EXPECT_EQ(storage.getIngredients().size(), 1u);
+    EXPECT_EQ(storage.getMeals().size(), 1u);
+
+    // Failed mutations leave the version alone
+    EXPECT_THROW(storage.removeRecipe("missing"), std::invalid_argument);
+    EXPECT_THROW(storage.loadFromFile(path), std::invalid_argument);
+    EXPECT_FALSE(bumped());
+}
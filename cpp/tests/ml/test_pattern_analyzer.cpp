@@ -0,0 +1,284 @@
+#include <gtest/gtest.h>
+#include <smart_food/ml/pattern_analyzer.hpp>
+#include <smart_food/core/storage.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+
+using namespace smart_food::core;
+using namespace smart_food::ml;
+
+namespace {
+
+using Items = std::vector<std::string>;
+using Meals = std::vector<std::shared_ptr<Meal>>;
+
+std::map<Items, std::size_t> byItems(const std::vector<PatternAnalyzer::Itemset>& itemsets) {
+    std::map<Items, std::size_t> result;
+    for (const auto& itemset : itemsets) {
+        result[itemset.items] = itemset.count;
+    }
+    return result;
+}
+
+PatternAnalyzer textbook() {
+    PatternAnalyzer analyzer(Meals{});
+    analyzer.addTransaction({"bread", "milk"});
+    analyzer.addTransaction({"bread", "diapers", "beer", "eggs"});
+    analyzer.addTransaction({"milk", "diapers", "beer", "cola"});
+    analyzer.addTransaction({"bread", "milk", "diapers", "beer"});
+    analyzer.addTransaction({"bread", "milk", "diapers", "cola", "cola"});
+    return analyzer;
+}
+
+} // namespace
+
+TEST(PatternAnalyzerTest, MinesTextbookTransactions) {
+    auto analyzer = textbook();
+    EXPECT_EQ(analyzer.getTransactionCount(), 5u);
+    EXPECT_EQ(analyzer.getItemCount(), 6u);
+
+    PatternAnalyzer::Options options;
+    options.minSupport = 0.6;
+    auto itemsets = analyzer.findFrequentItemsets(options);
+    std::map<Items, std::size_t> expected{
+        {{"bread"}, 4}, {{"diapers"}, 4}, {{"milk"}, 4}, {{"beer"}, 3},
+        {{"bread", "diapers"}, 3}, {{"bread", "milk"}, 3}, {{"diapers", "milk"}, 3}, {{"beer", "diapers"}, 3}};
+    EXPECT_EQ(byItems(itemsets), expected);
+    EXPECT_EQ(itemsets.front().count, 4u);
+    EXPECT_EQ(itemsets.back().items, (Items{"diapers", "milk"}));
+    EXPECT_DOUBLE_EQ(itemsets.back().support, 0.6);
+    EXPECT_DOUBLE_EQ(itemsets.back().lift, 0.6 / (0.8 * 0.8));
+
+    // Beer buyers always buy diapers, more often than shoppers at large
+    options.minConfidence = 0.9;
+    auto rules = analyzer.findAssociationRules(options);
+    ASSERT_EQ(rules.size(), 1u);
+    EXPECT_EQ(rules[0].antecedent, Items{"beer"});
+    EXPECT_EQ(rules[0].consequent, Items{"diapers"});
+    EXPECT_DOUBLE_EQ(rules[0].confidence, 1.0);
+    EXPECT_DOUBLE_EQ(rules[0].lift, 1.25);
+
+    // Pairs that are less frequent than independence predicts are dropped
+    options.minLift = 1.0;
+    auto lifted = byItems(analyzer.findFrequentItemsets(options));
+    EXPECT_EQ(lifted.count({"bread", "milk"}), 0u);
+    EXPECT_EQ(lifted.count({"beer", "diapers"}), 1u);
+    EXPECT_EQ(lifted.count({"bread"}), 1u);
+}
+
+TEST(PatternAnalyzerTest, OpensModelFileInPlace) {
+    auto analyzer = textbook();
+    const std::string path = ::testing::TempDir() + "patterns.sfm";
+    analyzer.saveModelFile(path);
+
+    auto opened = PatternAnalyzer::openModelFile(path);
+    EXPECT_EQ(opened.getTransactionCount(), 5u);
+    EXPECT_EQ(opened.getItemCount(), 6u);
+    PatternAnalyzer::Options options;
+    options.minSupport = 0.4;
+    EXPECT_EQ(byItems(opened.findFrequentItemsets(options)), byItems(analyzer.findFrequentItemsets(options)));
+    EXPECT_EQ(opened.findAssociationRules(options).size(), analyzer.findAssociationRules(options).size());
+
+    // Saving an opened analyzer copies the file; adding to it copies the transactions out first
+    const std::string copyPath = ::testing::TempDir() + "patterns_copy.sfm";
+    auto copy = opened;
+    copy.saveModelFile(copyPath);
+    opened.addTransaction({"beer", "diapers", "crisps"});
+    analyzer.addTransaction({"beer", "diapers", "crisps"});
+    EXPECT_EQ(opened.getItemCount(), 7u);
+    EXPECT_EQ(byItems(opened.findFrequentItemsets(options)), byItems(analyzer.findFrequentItemsets(options)));
+    EXPECT_EQ(PatternAnalyzer::openModelFile(copyPath).getTransactionCount(), 5u);
+    EXPECT_EQ(copy.getTransactionCount(), 5u);
+
+    std::remove(path.c_str());
+    std::remove(copyPath.c_str());
+    EXPECT_THROW(PatternAnalyzer::openModelFile(path), std::invalid_argument);
+}
+
+TEST(PatternAnalyzerTest, MatchesBruteForce) {
+    // Skewed item frequencies give deep trees with shared prefixes
+    std::mt19937 rng(3);
+    const int itemCount = 12;
+    PatternAnalyzer analyzer(Meals{});
+    std::vector<std::vector<int>> transactions;
+    for (int t = 0; t < 400; ++t) {
+        std::vector<int> transaction;
+        Items names;
+        for (int i = 0; i < itemCount; ++i) {
+            if (std::uniform_real_distribution<double>(0.0, 1.0)(rng) < 0.7 / (1.0 + 0.3 * i)) {
+                transaction.push_back(i);
+                names.push_back("item " + std::to_string(i));
+            }
+        }
+        if (t % 5 == 0 && transaction.size() > 2) {
+            names.push_back(names.front());  // Duplicates count once
+        }
+        transactions.push_back(transaction);
+        analyzer.addTransaction(names);
+    }
+
+    for (std::size_t maxItems : {std::size_t{0}, std::size_t{3}}) {
+        std::map<Items, std::size_t> expected;
+        for (int mask = 1; mask < (1 << itemCount); ++mask) {
+            Items items;
+            for (int i = 0; i < itemCount; ++i) {
+                if (mask & (1 << i)) {
+                    items.push_back("item " + std::to_string(i));
+                }
+            }
+            if (maxItems != 0 && items.size() > maxItems) {
+                continue;
+            }
+            std::size_t count = 0;
+            for (const auto& transaction : transactions) {
+                int held = 0;
+                for (int i : transaction) {
+                    held |= 1 << i;
+                }
+                count += (held & mask) == mask ? 1 : 0;
+            }
+            if (count >= 20) {
+                std::sort(items.begin(), items.end());
+                expected[items] = count;
+            }
+        }
+        for (std::size_t threads : {std::size_t{1}, std::size_t{3}}) {
+            PatternAnalyzer::Options options;
+            options.minSupport = 0.05;
+            options.maxItems = maxItems;
+            options.threads = threads;
+            auto itemsets = analyzer.findFrequentItemsets(options);
+            EXPECT_EQ(itemsets.size(), expected.size());
+            EXPECT_EQ(byItems(itemsets), expected);
+        }
+    }
+}
+
+TEST(PatternAnalyzerTest, AnalyzesMeals) {
+    auto pasta = std::make_shared<Recipe>("Pasta");
+    pasta->addIngredient(std::make_shared<Ingredient>("Spaghetti", 200.0, Ingredient::Unit::GRAM));
+    pasta->addIngredient(std::make_shared<Ingredient>("Tomato ", 300.0, Ingredient::Unit::GRAM));
+    Meals meals;
+    for (int i = 0; i < 10; ++i) {
+        auto meal = std::make_shared<Meal>("Dinner " + std::to_string(i), Meal::Type::DINNER);
+        if (i < 6) {
+            meal->setRecipe(pasta);
+            if (i < 4) {
+                meal->addIngredient(std::make_shared<Ingredient>("Parmesan", 20.0, Ingredient::Unit::GRAM));
+            }
+        } else {
+            meal->addIngredient(std::make_shared<Ingredient>("tomato", 100.0, Ingredient::Unit::GRAM));
+        }
+        meals.push_back(meal);
+    }
+    PatternAnalyzer analyzer(meals);
+    EXPECT_EQ(analyzer.getTransactionCount(), 10u);
+
+    PatternAnalyzer::Options options;
+    options.minSupport = 0.3;
+    auto itemsets = byItems(analyzer.findFrequentItemsets(options));
+    EXPECT_EQ(itemsets.at({"tomato"}), 10u);
+    EXPECT_EQ(itemsets.at({"recipe:Pasta", "spaghetti", "tomato"}), 6u);
+    EXPECT_EQ(itemsets.at({"parmesan", "recipe:Pasta", "spaghetti", "tomato"}), 4u);
+
+    // Parmesan only comes with pasta; tomato comes with everything, so predicting it has no lift
+    options.minConfidence = 1.0;
+    options.minLift = 1.5;
+    auto rules = analyzer.findAssociationRules(options);
+    ASSERT_FALSE(rules.empty());
+    bool parmesanToPasta = false;
+    for (const auto& rule : rules) {
+        EXPECT_NEAR(rule.lift, 10.0 / 6.0, 1e-9);
+        EXPECT_EQ(std::count(rule.consequent.begin(), rule.consequent.end(), "parmesan"), 0);
+        EXPECT_NE(rule.consequent, Items{"tomato"});
+        parmesanToPasta |= rule.antecedent == Items{"parmesan"} && rule.consequent == Items{"recipe:Pasta", "spaghetti"};
+    }
+    EXPECT_TRUE(parmesanToPasta);
+
+    EXPECT_THROW(PatternAnalyzer(Meals{nullptr}), std::invalid_argument);
+    options.minSupport = 0.0;
+    EXPECT_THROW(analyzer.findFrequentItemsets(options), std::invalid_argument);
+    EXPECT_TRUE(PatternAnalyzer(Meals{}).findFrequentItemsets().empty());
+}
+
+TEST(PatternAnalyzerTest, SketchesMealsAndPantry) {
+    auto soup = std::make_shared<Recipe>("Soup");
+    soup->addIngredient(std::make_shared<Ingredient>("Leek", 200.0, Ingredient::Unit::GRAM));
+    soup->addIngredient(std::make_shared<Ingredient>("Potato", 300.0, Ingredient::Unit::GRAM));
+    auto salad = std::make_shared<Recipe>("Salad");
+    salad->addIngredient(std::make_shared<Ingredient>("Lettuce", 100.0, Ingredient::Unit::GRAM));
+
+    // Two regions, each summarized on its own shard
+    PatternAnalyzer north(Meals{});
+    PatternAnalyzer south(Meals{});
+    for (int i = 0; i < 30; ++i) {
+        Meal meal("Meal " + std::to_string(i));
+        meal.setRecipe(i % 3 == 0 ? salad : soup);
+        (i % 2 == 0 ? north : south).recordMeal(meal);
+    }
+    Ingredient lot("potato ", 2.0, Ingredient::Unit::KILOGRAM);
+    lot.setUnitPrice(1.5);
+    south.recordPantryItem(lot);
+    Ingredient rice("Rice", 1.0, Ingredient::Unit::KILOGRAM);
+    rice.setUnitPrice(2.0);
+    south.recordPantryItem(rice);
+    EXPECT_EQ(north.getTransactionCount(), 0u);  // Sketches keep no transactions
+
+    auto southSketches = PatternAnalyzer::Sketches::deserialize(south.getSketches().serialize());
+    EXPECT_NEAR(southSketches.ingredients.estimate(), 4.0, 0.1);
+    EXPECT_DOUBLE_EQ(southSketches.pantryValues.quantile(1.0), 3.0);
+    north.mergeSketches(southSketches);
+
+    auto sketches = north.getSketches();
+    auto hitters = sketches.recipes.getHeavyHitters();
+    ASSERT_EQ(hitters.size(), 2u);
+    EXPECT_EQ(hitters[0], (std::pair<std::string, std::uint64_t>{"Soup", 20}));
+    EXPECT_EQ(hitters[1], (std::pair<std::string, std::uint64_t>{"Salad", 10}));
+    EXPECT_NEAR(sketches.ingredients.estimate(), 4.0, 0.1);
+    EXPECT_EQ(sketches.mealCosts.getCount(), 30u);
+    EXPECT_EQ(sketches.pantryValues.getCount(), 2u);
+
+    PatternAnalyzer copy(north);
+    copy.recordMeal(Meal("No recipe"));
+    EXPECT_EQ(copy.getSketches().mealCosts.getCount(), 31u);
+    EXPECT_EQ(north.getSketches().mealCosts.getCount(), 30u);
+
+    PatternAnalyzer::Sketches other;
+    other.recipes = CountMinSketch(64, 2, 5);
+    EXPECT_THROW(north.mergeSketches(other), std::invalid_argument);
+    EXPECT_EQ(north.getSketches().mealCosts.getCount(), 30u);
+    north.setSketches(PatternAnalyzer::Sketches());
+    EXPECT_EQ(north.getSketches().recipes.getTotal(), 0u);
+}
+
+TEST(PatternAnalyzerTest, WatchesStorageMutations) {
+    auto& storage = Storage::getInstance();
+    storage.clear();
+    auto soup = std::make_shared<Recipe>("Soup");
+    soup->addIngredient(std::make_shared<Ingredient>("Leek", 200.0, Ingredient::Unit::GRAM));
+    auto rice = std::make_shared<Ingredient>("Rice", 1.0, Ingredient::Unit::KILOGRAM);
+    rice->setUnitPrice(2.0);
+    {
+        PatternAnalyzer analyzer(Meals{});
+        analyzer.watchStorage();
+        auto lunch = std::make_shared<Meal>("Lunch");
+        lunch->setRecipe(soup);
+        storage.addMeal(lunch);
+        storage.updateMeal(lunch);
+        storage.addIngredient(rice);
+        storage.updateIngredient(rice);
+        storage.removeMeal("Lunch");
+
+        // Meals count once; pantry lots count each time they are stocked
+        auto sketches = analyzer.getSketches();
+        EXPECT_EQ(sketches.recipes.estimate("Soup"), 1u);
+        EXPECT_EQ(sketches.mealCosts.getCount(), 1u);
+        EXPECT_EQ(sketches.pantryValues.getCount(), 2u);
+        EXPECT_DOUBLE_EQ(sketches.pantryValues.quantile(1.0), 2.0);
+    }
+    // Mutations after the analyzer is gone reach no listener
+    storage.removeIngredient(rice->getId());
+    storage.clear();
+}
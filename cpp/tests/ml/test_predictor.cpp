@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <smart_food/ml/predictor.hpp>
+#include <smart_food/utils/model_file.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace smart_food::ml;
+
+namespace {
+
+using Clock = std::chrono::system_clock;
+
+/// Hour `hour` of day `day`, counted from a Monday
+Clock::time_point at(int day, int hour = 12) {
+    return Clock::time_point(std::chrono::hours(24 * (20003 + day) + hour));
+}
+
+/// Expected consumption on the day `ahead` days after `now`
+double onDay(const Predictor& predictor, std::uint32_t household, std::uint32_t ingredient, int ahead,
+             Clock::time_point now) {
+    return predictor.forecast(household, ingredient, ahead + 1, now) - predictor.forecast(household, ingredient, ahead, now);
+}
+
+} // namespace
+
+TEST(PredictorTest, LearnsSteadyConsumption) {
+    Predictor predictor;
+    for (int day = 0; day < 56; ++day) {
+        predictor.update(1, 7, 120.0, at(day, 8));
+        predictor.update(1, 7, 80.0, at(day, 19));
+    }
+    EXPECT_EQ(predictor.size(), 1u);
+    EXPECT_NEAR(predictor.forecast(1, 7, 7, at(56, 0)), 1400.0, 14.0);
+
+    // A litre lasts five days; half of today's share is drunk already
+    auto days = predictor.daysUntilRunOut({{1, 7, 1000.0}, {1, 7, 0.0}, {1, 8, 1000.0}, {2, 7, 1000.0}}, at(56, 0));
+    ASSERT_EQ(days.size(), 4u);
+    EXPECT_NEAR(days[0], 5.0, 0.05);
+    EXPECT_DOUBLE_EQ(days[1], 0.0);
+    EXPECT_TRUE(std::isinf(days[2]));
+    EXPECT_TRUE(std::isinf(days[3]));
+    predictor.update(1, 7, 100.0, at(56, 9));
+    EXPECT_NEAR(predictor.daysUntilRunOut({{1, 7, 1000.0}}, at(56, 10))[0], 5.5, 0.05);
+    EXPECT_NEAR(predictor.forecast(1, 7, 1, at(56, 10)), 100.0, 2.0);
+}
+
+TEST(PredictorTest, LearnsWeeklyPattern) {
+    // Little during the week, a big cook-up on Saturdays
+    Predictor predictor;
+    for (int day = 0; day < 140; ++day) {
+        predictor.update(3, 4, day % 7 == 5 ? 700.0 : 100.0, at(day));
+    }
+    const auto monday = at(140, 0);
+    EXPECT_NEAR(onDay(predictor, 3, 4, 0, monday), 100.0, 25.0);
+    EXPECT_NEAR(onDay(predictor, 3, 4, 3, monday), 100.0, 25.0);
+    EXPECT_NEAR(onDay(predictor, 3, 4, 5, monday), 700.0, 50.0);
+    EXPECT_NEAR(predictor.forecast(3, 4, 7, monday), 1300.0, 80.0);
+
+    // Enough for the weekdays runs out on Saturday
+    auto days = predictor.daysUntilRunOut({{3, 4, 800.0}}, monday)[0];
+    EXPECT_GT(days, 5.0);
+    EXPECT_LT(days, 6.0);
+}
+
+TEST(PredictorTest, FollowsTrendsAndForgetsLongSilences) {
+    Predictor::Options options;
+    options.trendSmoothing = 0.2;
+    options.maxGapDays = 10;
+    Predictor predictor(options);
+    for (int day = 0; day < 60; ++day) {
+        predictor.update(9, 9, 10.0 * day, at(day));
+    }
+    const double next = onDay(predictor, 9, 9, 0, at(60, 0));
+    EXPECT_GT(next, 570.0);
+    EXPECT_LT(onDay(predictor, 9, 9, 1, at(60, 0)) - next, 10.0);  // The trend is damped further ahead
+    EXPECT_GT(onDay(predictor, 9, 9, 1, at(60, 0)), next);
+
+    // Silent days lower the forecast until the series is forgotten
+    EXPECT_LT(onDay(predictor, 9, 9, 0, at(65, 0)), next);
+    EXPECT_DOUBLE_EQ(predictor.forecast(9, 9, 7, at(72, 0)), 0.0);
+    EXPECT_TRUE(std::isinf(predictor.daysUntilRunOut({{9, 9, 50.0}}, at(72, 0))[0]));
+
+    // Then it starts over from the next consumption
+    predictor.update(9, 9, 30.0, at(80));
+    EXPECT_DOUBLE_EQ(predictor.forecast(9, 9, 7, at(80, 20)), 0.0);
+    EXPECT_NEAR(predictor.forecast(9, 9, 1, at(81, 0)), 30.0, 1e-3);
+    EXPECT_EQ(predictor.size(), 1u);
+}
+
+TEST(PredictorTest, TracksManySeries) {
+    Predictor predictor;
+    std::vector<Predictor::Event> events;
+    for (int day = 0; day < 14; ++day) {
+        for (std::uint32_t household = 0; household < 500; ++household) {
+            for (std::uint32_t ingredient = 0; ingredient < 20; ++ingredient) {
+                events.push_back({household, ingredient, 1.0 + household % 7 + ingredient, at(day)});
+            }
+        }
+    }
+    predictor.update(events);
+    EXPECT_EQ(predictor.size(), 10000u);
+
+    std::vector<Predictor::StockQuery> queries;
+    for (std::uint32_t household = 0; household < 500; household += 7) {
+        for (std::uint32_t ingredient = 0; ingredient < 20; ++ingredient) {
+            queries.push_back({household, ingredient, 10.0 * (1.0 + household % 7 + ingredient)});
+        }
+    }
+    auto days = predictor.daysUntilRunOut(queries, at(14, 0));
+    for (double d : days) {
+        EXPECT_NEAR(d, 10.0, 0.01);
+    }
+
+    predictor.reserve(50000);
+    EXPECT_NEAR(predictor.forecast(499, 19, 2, at(14, 0)), 2.0 * (1.0 + 499 % 7 + 19), 1e-3);
+}
+
+TEST(PredictorTest, OpensModelFileInPlace) {
+    Predictor::Options options;
+    options.horizonDays = 90;
+    Predictor predictor(options);
+    for (int day = 0; day < 42; ++day) {
+        for (std::uint32_t household = 0; household < 300; ++household) {
+            predictor.update(household, household % 11, 10.0 + household % 5 + (day % 7 == 5 ? 20.0 : 0.0), at(day));
+        }
+    }
+    const std::string path = ::testing::TempDir() + "predictor.sfm";
+    predictor.saveModelFile(path);
+
+    auto opened = Predictor::openModelFile(path);
+    EXPECT_EQ(opened.size(), predictor.size());
+    EXPECT_EQ(opened.getOptions().horizonDays, 90);
+    for (std::uint32_t household = 0; household < 300; household += 13) {
+        EXPECT_DOUBLE_EQ(opened.forecast(household, household % 11, 7, at(42)),
+                         predictor.forecast(household, household % 11, 7, at(42)));
+    }
+    std::vector<Predictor::StockQuery> queries = {{1, 1, 100.0}, {2, 2, 50.0}, {3, 4, 10.0}};
+    EXPECT_EQ(opened.daysUntilRunOut(queries, at(42)), predictor.daysUntilRunOut(queries, at(42)));
+
+    // Updates go to a private copy; the file and copies made before stay as saved
+    auto copy = opened;
+    opened.update(1, 1, 500.0, at(42));
+    opened.update(5000, 1, 1.0, at(42));
+    EXPECT_EQ(opened.size(), predictor.size() + 1);
+    predictor.update(1, 1, 500.0, at(42));
+    EXPECT_DOUBLE_EQ(opened.forecast(1, 1, 7, at(43)), predictor.forecast(1, 1, 7, at(43)));
+    EXPECT_EQ(copy.size(), predictor.size());
+    EXPECT_EQ(Predictor::openModelFile(path).size(), predictor.size());
+
+    // A stored size that miscounts the occupied slots is rejected, whatever the table holds
+    {
+        using smart_food::utils::ModelFile;
+        auto file = ModelFile::open(path, ModelFile::tag("PRED"), 1);
+        auto metaBytes = file->section<unsigned char>(0);
+        auto tableBytes = file->section<unsigned char>(1);
+        std::vector<unsigned char> meta(metaBytes.begin(), metaBytes.end());
+        const std::uint64_t understated = predictor.size() - 1;
+        std::memcpy(meta.data() + 40, &understated, sizeof(understated));  // After 4 doubles and 2 int32
+        ModelFile::Writer(ModelFile::tag("PRED"), 1)
+            .add(meta)
+            .add(std::vector<unsigned char>(tableBytes.begin(), tableBytes.end()))
+            .save(path);
+    }
+    EXPECT_THROW(Predictor::openModelFile(path), std::invalid_argument);
+
+    Predictor().saveModelFile(path);
+    EXPECT_EQ(Predictor::openModelFile(path).size(), 0u);
+    EXPECT_DOUBLE_EQ(Predictor::openModelFile(path).forecast(1, 1, 7, at(42)), 0.0);
+    std::remove(path.c_str());
+    EXPECT_THROW(Predictor::openModelFile(path), std::invalid_argument);
+}
+
+TEST(PredictorTest, RejectsInvalidInput) {
+    Predictor::Options options;
+    options.levelSmoothing = 0.0;
+    EXPECT_THROW(Predictor{options}, std::invalid_argument);
+    options = Predictor::Options{};
+    options.trendDamping = 1.5;
+    EXPECT_THROW(Predictor{options}, std::invalid_argument);
+    options = Predictor::Options{};
+    options.horizonDays = 0;
+    EXPECT_THROW(Predictor{options}, std::invalid_argument);
+
+    Predictor predictor;
+    EXPECT_THROW(predictor.update(1, 1, -1.0, at(0)), std::invalid_argument);
+    EXPECT_THROW(predictor.update(1, 1, std::nan(""), at(0)), std::invalid_argument);
+    EXPECT_THROW(predictor.update(0xFFFFFFFFu, 0xFFFFFFFFu, 1.0, at(0)), std::invalid_argument);
+    EXPECT_EQ(predictor.size(), 0u);
+    EXPECT_DOUBLE_EQ(predictor.forecast(1, 1, 7, at(0)), 0.0);
+}
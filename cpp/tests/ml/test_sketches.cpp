@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <smart_food/ml/sketches.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <random>
+
+using namespace smart_food::ml;
+
+namespace {
+
+/// Zipf-distributed keys: key i is drawn with weight 1 / (i + 1)
+std::vector<std::string> zipfStream(std::size_t events, int keys, unsigned seed) {
+    std::vector<double> weights;
+    for (int i = 0; i < keys; ++i) {
+        weights.push_back(1.0 / (i + 1));
+    }
+    std::mt19937 rng(seed);
+    std::discrete_distribution<int> key(weights.begin(), weights.end());
+    std::vector<std::string> stream;
+    for (std::size_t e = 0; e < events; ++e) {
+        stream.push_back("recipe " + std::to_string(key(rng)));
+    }
+    return stream;
+}
+
+} // namespace
+
+TEST(SketchesTest, CountMinFindsHeavyHitters) {
+    const auto stream = zipfStream(200000, 5000, 1);
+    std::map<std::string, std::uint64_t> exact;
+    CountMinSketch sketch(2048, 4, 10);
+    CountMinSketch first(2048, 4, 10);
+    CountMinSketch second(2048, 4, 10);
+    for (std::size_t e = 0; e < stream.size(); ++e) {
+        ++exact[stream[e]];
+        sketch.add(stream[e]);
+        (e % 3 == 0 ? first : second).add(stream[e]);
+    }
+    EXPECT_EQ(sketch.getTotal(), stream.size());
+
+    // Never under, and over by at most e / width of the total for nearly every key
+    std::size_t far = 0;
+    for (const auto& entry : exact) {
+        const auto estimate = sketch.estimate(entry.first);
+        EXPECT_GE(estimate, entry.second);
+        far += estimate - entry.second > 2.72 * stream.size() / 2048 ? 1 : 0;
+    }
+    EXPECT_LT(far, exact.size() / 50);
+    EXPECT_EQ(sketch.estimate("never seen") <= 2.72 * stream.size() / 2048, true);
+
+    auto hitters = sketch.getHeavyHitters();
+    ASSERT_EQ(hitters.size(), 10u);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(hitters[i].first, "recipe " + std::to_string(i));
+    }
+
+    // Shards merge into the sketch of the whole stream
+    first.merge(second);
+    EXPECT_EQ(first.getTotal(), sketch.getTotal());
+    EXPECT_EQ(first.getHeavyHitters(), hitters);
+    for (int i = 0; i < 100; ++i) {
+        const std::string key = "recipe " + std::to_string(i * 37);
+        EXPECT_EQ(first.estimate(key), sketch.estimate(key));
+    }
+
+    auto restored = CountMinSketch::deserialize(sketch.serialize());
+    EXPECT_EQ(restored.getHeavyHitters(), hitters);
+    EXPECT_EQ(restored.estimate("recipe 42"), sketch.estimate("recipe 42"));
+    restored.add("recipe 4999", 100000);
+    EXPECT_EQ(restored.getHeavyHitters().front().first, "recipe 4999");
+
+    EXPECT_THROW(sketch.merge(CountMinSketch(1024, 4, 10)), std::invalid_argument);
+    EXPECT_THROW(CountMinSketch(0, 4, 10), std::invalid_argument);
+    EXPECT_THROW(CountMinSketch(64, 17, 10), std::invalid_argument);
+    EXPECT_THROW(CountMinSketch::deserialize("{\"width\": 4}"), std::invalid_argument);
+}
+
+TEST(SketchesTest, HyperLogLogCountsDistinctKeys) {
+    HyperLogLog small;
+    for (int repeat = 0; repeat < 5; ++repeat) {
+        for (int i = 0; i < 100; ++i) {
+            small.add("ingredient " + std::to_string(i));
+        }
+    }
+    EXPECT_NEAR(small.estimate(), 100.0, 2.0);
+
+    // Two overlapping shards of 150k distinct keys each, 200k together
+    HyperLogLog first;
+    HyperLogLog second;
+    for (int i = 0; i < 150000; ++i) {
+        first.add("ingredient " + std::to_string(i));
+        second.add("ingredient " + std::to_string(i + 50000));
+    }
+    EXPECT_NEAR(first.estimate(), 150000.0, 150000.0 * 0.03);
+    first.merge(second);
+    EXPECT_NEAR(first.estimate(), 200000.0, 200000.0 * 0.03);
+
+    auto restored = HyperLogLog::deserialize(first.serialize());
+    EXPECT_DOUBLE_EQ(restored.estimate(), first.estimate());
+    EXPECT_THROW(first.merge(HyperLogLog(10)), std::invalid_argument);
+    EXPECT_THROW(HyperLogLog(3), std::invalid_argument);
+    EXPECT_THROW(HyperLogLog::deserialize("not json"), std::invalid_argument);
+}
+
+TEST(SketchesTest, QuantileSketchStaysSmallAndAccurate) {
+    const int count = 1000000;
+    std::vector<double> values(count);
+    std::iota(values.begin(), values.end(), 0.0);
+    std::shuffle(values.begin(), values.end(), std::mt19937(5));
+
+    QuantileSketch sketch;
+    std::vector<QuantileSketch> shards(4);
+    for (int i = 0; i < count; ++i) {
+        sketch.add(values[i]);
+        shards[i % 4].add(values[i]);
+    }
+    EXPECT_EQ(sketch.getCount(), static_cast<std::uint64_t>(count));
+    EXPECT_LT(sketch.getRetained(), 3u * sketch.getK() + 64);
+    EXPECT_DOUBLE_EQ(sketch.quantile(0.0), 0.0);
+    EXPECT_DOUBLE_EQ(sketch.quantile(1.0), count - 1.0);
+    for (double fraction : {0.01, 0.25, 0.5, 0.9, 0.99}) {
+        EXPECT_NEAR(sketch.quantile(fraction) / count, fraction, 0.02);
+        EXPECT_NEAR(sketch.rank(fraction * count), fraction, 0.02);
+    }
+
+    for (std::size_t s = 1; s < shards.size(); ++s) {
+        shards[0].merge(shards[s]);
+    }
+    EXPECT_EQ(shards[0].getCount(), static_cast<std::uint64_t>(count));
+    EXPECT_LT(shards[0].getRetained(), 3u * sketch.getK() + 64);
+    EXPECT_NEAR(shards[0].quantile(0.5) / count, 0.5, 0.02);
+
+    auto restored = QuantileSketch::deserialize(sketch.serialize());
+    EXPECT_DOUBLE_EQ(restored.quantile(0.9), sketch.quantile(0.9));
+    restored.add(-1.0);
+    EXPECT_DOUBLE_EQ(restored.quantile(0.0), -1.0);
+
+    QuantileSketch empty;
+    EXPECT_TRUE(std::isnan(empty.quantile(0.5)));
+    EXPECT_THROW(empty.add(std::nan("")), std::invalid_argument);
+    EXPECT_THROW(sketch.quantile(1.5), std::invalid_argument);
+    EXPECT_THROW(sketch.merge(QuantileSketch(100)), std::invalid_argument);
+    EXPECT_THROW(QuantileSketch(4), std::invalid_argument);
+}
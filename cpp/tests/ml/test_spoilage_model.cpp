@@ -0,0 +1,271 @@
+#include <gtest/gtest.h>
+#include <smart_food/ml/predictor.hpp>
+#include <smart_food/ml/spoilage_model.hpp>
+#include <smart_food/utils/model_file.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+
+using namespace smart_food::ml;
+
+namespace {
+
+using Node = SpoilageModel::Node;
+using Tree = SpoilageModel::Tree;
+
+float leftoverOf(float days, float quantity, float usage) {
+    return std::max(0.0f, quantity - usage * std::max(0.0f, days));
+}
+
+/// Random tree with up to `leaves` leaves; thresholds are small integers so that values tie with them
+Tree randomTree(std::mt19937& rng, int leaves) {
+    Tree tree;
+    tree.nodes.push_back(Node{});
+    std::vector<std::uint32_t> open = {0};
+    std::uniform_int_distribution<int> feature(0, 4);
+    std::uniform_int_distribution<int> threshold(0, 6);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    for (int splits = 1; splits < leaves; ++splits) {
+        const std::size_t pick = std::uniform_int_distribution<std::size_t>(0, open.size() - 1)(rng);
+        const std::uint32_t index = open[pick];
+        open.erase(open.begin() + static_cast<std::ptrdiff_t>(pick));
+        const auto left = static_cast<std::uint32_t>(tree.nodes.size());
+        tree.nodes.push_back(Node{});
+        tree.nodes.push_back(Node{});
+        tree.nodes[index].feature = feature(rng);
+        tree.nodes[index].threshold = static_cast<float>(threshold(rng));
+        tree.nodes[index].left = left;
+        tree.nodes[index].right = left + 1;
+        open.push_back(left);
+        open.push_back(left + 1);
+    }
+    for (auto& node : tree.nodes) {
+        node.value = node.feature < 0 ? value(rng) : 0.0f;
+    }
+    return tree;
+}
+
+/// Plain root-to-leaf evaluation
+double traverse(const std::vector<Tree>& trees, double baseScore, const float values[5]) {
+    double total = baseScore;
+    for (const auto& tree : trees) {
+        std::uint32_t index = 0;
+        while (tree.nodes[index].feature >= 0) {
+            const auto& node = tree.nodes[index];
+            index = values[node.feature] <= node.threshold ? node.left : node.right;
+        }
+        total += tree.nodes[index].value;
+    }
+    return total;
+}
+
+/// Rewrite a model file with one section edited, as a valid file with a matching checksum
+void patchSection(const std::string& path, std::size_t index,
+                  const std::function<void(std::vector<unsigned char>&)>& edit) {
+    using smart_food::utils::ModelFile;
+    std::vector<std::vector<unsigned char>> sections;
+    {
+        auto file = ModelFile::open(path, ModelFile::tag("SPOI"), 1);
+        for (std::size_t s = 0; s < file->getSectionCount(); ++s) {
+            auto bytes = file->section<unsigned char>(s);
+            sections.emplace_back(bytes.begin(), bytes.end());
+        }
+    }
+    edit(sections[index]);
+    ModelFile::Writer writer(ModelFile::tag("SPOI"), 1);
+    for (const auto& section : sections) {
+        writer.add(section);
+    }
+    writer.save(path);
+}
+
+} // namespace
+
+TEST(SpoilageModelTest, LinearAndLogisticScores) {
+    SpoilageModel::Linear linear;
+    linear.intercept = 0.5;
+    linear.weights = {-0.25, 0.1, 0.0, 0.05};
+    linear.categoryWeights = {0.0, 1.0};
+
+    SpoilageFeatures features;
+    features.add(1, 2.0f, 10.0f, 1.0f);   // 8 left over
+    features.add(0, -1.0f, 4.0f, 3.0f);   // Expired: all 4 left over
+    features.add(7, 10.0f, 2.0f, 1.0f);   // Unknown category, used up in time
+    SpoilageModel identity(linear, SpoilageModel::Link::IDENTITY);
+    EXPECT_EQ(identity.getTreeCount(), 0u);
+    auto scores = identity.score(features);
+    ASSERT_EQ(scores.size(), 3u);
+    EXPECT_NEAR(scores[0], 0.5 - 0.5 + 1.0 + 1.0 + 0.4, 1e-5);
+    EXPECT_NEAR(scores[1], 0.5 + 0.25 + 0.4 + 0.2, 1e-5);
+    EXPECT_NEAR(scores[2], 0.5 - 2.5 + 0.2, 1e-5);
+
+    SpoilageModel logistic(linear, SpoilageModel::Link::LOGISTIC);
+    auto probabilities = logistic.score(features);
+    for (std::size_t i = 0; i < scores.size(); ++i) {
+        EXPECT_NEAR(probabilities[i], 1.0 / (1.0 + std::exp(-scores[i])), 1e-6);
+    }
+    SpoilageFeatures extremes;
+    extremes.add(0, -1000.0f, 0.0f, 0.0f);
+    extremes.add(0, 1000.0f, 0.0f, 0.0f);
+    auto saturated = logistic.score(extremes);
+    EXPECT_NEAR(saturated[0], 1.0, 1e-6);
+    EXPECT_NEAR(saturated[1], 0.0, 1e-6);
+
+    features.quantity.pop_back();
+    EXPECT_THROW(identity.score(features), std::invalid_argument);
+    linear.weights.push_back(1.0);
+    EXPECT_THROW(SpoilageModel(linear, SpoilageModel::Link::IDENTITY), std::invalid_argument);
+}
+
+TEST(SpoilageModelTest, TreesMatchTraversal) {
+    std::mt19937 rng(17);
+    std::vector<Tree> trees;
+    for (int t = 0; t < 40; ++t) {
+        trees.push_back(randomTree(rng, t == 0 ? 1 : 1 + t % 64));
+    }
+    trees.push_back(randomTree(rng, 64));
+    SpoilageModel model(trees, 0.25, SpoilageModel::Link::IDENTITY);
+    EXPECT_EQ(model.getTreeCount(), trees.size());
+
+    // Integer-valued features hit the thresholds exactly; a batch spans several blocks
+    SpoilageFeatures features;
+    std::uniform_int_distribution<int> small(-1, 7);
+    std::uniform_real_distribution<float> any(-2.0f, 8.0f);
+    for (int i = 0; i < 1000; ++i) {
+        const bool ties = i % 2 == 0;
+        features.add(static_cast<std::uint32_t>(small(rng) + 1), ties ? small(rng) : any(rng),
+                     ties ? small(rng) : any(rng), ties ? small(rng) : any(rng));
+    }
+    auto scores = model.score(features);
+    ASSERT_EQ(scores.size(), features.size());
+    for (std::size_t i = 0; i < features.size(); ++i) {
+        const float values[5] = {static_cast<float>(features.category[i]), features.daysToExpiry[i],
+                                 features.quantity[i], features.dailyUsage[i],
+                                 leftoverOf(features.daysToExpiry[i], features.quantity[i], features.dailyUsage[i])};
+        EXPECT_NEAR(scores[i], traverse(trees, 0.25, values), 1e-4) << "item " << i;
+    }
+
+    SpoilageModel logistic(trees, 0.25, SpoilageModel::Link::LOGISTIC);
+    auto probabilities = logistic.score(features);
+    for (std::size_t i = 0; i < features.size(); i += 37) {
+        EXPECT_NEAR(probabilities[i], 1.0 / (1.0 + std::exp(-scores[i])), 1e-6);
+    }
+    EXPECT_TRUE(model.score(SpoilageFeatures{}).empty());
+}
+
+TEST(SpoilageModelTest, RoundTripsAndRejectsInvalidModels) {
+    std::mt19937 rng(3);
+    std::vector<Tree> trees = {randomTree(rng, 12), randomTree(rng, 5)};
+    SpoilageModel model(trees, -0.5, SpoilageModel::Link::LOGISTIC);
+    SpoilageFeatures features;
+    for (int i = 0; i < 100; ++i) {
+        features.add(static_cast<std::uint32_t>(i % 5), i % 9 - 1.0f, i % 7 * 0.5f, i % 3 * 0.75f);
+    }
+
+    const std::string path = ::testing::TempDir() + "spoilage_model.json";
+    model.saveToFile(path);
+    auto loaded = SpoilageModel::loadFromFile(path);
+    std::remove(path.c_str());
+    EXPECT_EQ(loaded.getLink(), SpoilageModel::Link::LOGISTIC);
+    EXPECT_EQ(loaded.score(features), model.score(features));
+
+    // Binary model files are scored from in place
+    const std::string binaryPath = ::testing::TempDir() + "spoilage_model.sfm";
+    model.saveModelFile(binaryPath);
+    auto opened = SpoilageModel::openModelFile(binaryPath);
+    EXPECT_EQ(opened.getTreeCount(), 2u);
+    EXPECT_EQ(opened.getLink(), SpoilageModel::Link::LOGISTIC);
+    EXPECT_EQ(opened.score(features), model.score(features));
+    EXPECT_EQ(opened.serialize(), model.serialize());
+    EXPECT_THROW(Predictor::openModelFile(binaryPath), std::invalid_argument);
+    std::remove(binaryPath.c_str());
+
+    SpoilageModel::Linear linear;
+    linear.intercept = 1.5;
+    linear.weights = {0.0, 0.2};
+    linear.categoryWeights = {0.1, -0.1};
+    SpoilageModel linearModel(linear, SpoilageModel::Link::IDENTITY);
+    EXPECT_EQ(SpoilageModel::deserialize(linearModel.serialize()).score(features), linearModel.score(features));
+    linearModel.saveModelFile(binaryPath);
+    EXPECT_EQ(SpoilageModel::openModelFile(binaryPath).score(features), linearModel.score(features));
+    std::remove(binaryPath.c_str());
+    auto parsed = SpoilageModel::deserialize(
+        R"({"link": "identity", "linear": {"intercept": 1.0, "weights": {"leftover": 2.0}}})");
+    SpoilageFeatures one;
+    one.add(0, 1.0f, 3.0f, 1.0f);
+    EXPECT_FLOAT_EQ(parsed.score(one)[0], 5.0f);
+
+    EXPECT_THROW(SpoilageModel::loadFromFile(path), std::invalid_argument);
+    EXPECT_THROW(SpoilageModel::deserialize("not json"), std::invalid_argument);
+    EXPECT_THROW(SpoilageModel::deserialize(R"({"link": "probit", "trees": []})"), std::invalid_argument);
+    EXPECT_THROW(SpoilageModel::deserialize(
+                     R"({"link": "identity", "trees": [{"nodes": [{"feature": "colour", "threshold": 1, "left": 1, "right": 2}]}]})"),
+                 std::invalid_argument);
+
+    // Cycles, dangling children, unreachable nodes and oversized trees
+    Tree cycle;
+    cycle.nodes = {Node{0, 1.0f, 1, 0}, Node{}};
+    EXPECT_THROW(SpoilageModel({cycle}, 0.0, SpoilageModel::Link::IDENTITY), std::invalid_argument);
+    Tree dangling;
+    dangling.nodes = {Node{0, 1.0f, 1, 5}, Node{}};
+    EXPECT_THROW(SpoilageModel({dangling}, 0.0, SpoilageModel::Link::IDENTITY), std::invalid_argument);
+    Tree unreachable;
+    unreachable.nodes = {Node{}, Node{}};
+    EXPECT_THROW(SpoilageModel({unreachable}, 0.0, SpoilageModel::Link::IDENTITY), std::invalid_argument);
+    EXPECT_THROW(SpoilageModel({randomTree(rng, 65)}, 0.0, SpoilageModel::Link::IDENTITY), std::invalid_argument);
+    EXPECT_THROW(SpoilageModel({Tree{}}, 0.0, SpoilageModel::Link::IDENTITY), std::invalid_argument);
+}
+
+TEST(SpoilageModelTest, RejectsModelFilesThatWouldReadOutOfBounds) {
+    std::mt19937 rng(5);
+    SpoilageModel model({randomTree(rng, 12), randomTree(rng, 5)}, 0.0, SpoilageModel::Link::IDENTITY);
+    const std::string path = ::testing::TempDir() + "spoilage_patched.sfm";
+    auto expectRejected = [&](std::size_t section, const std::function<void(std::vector<unsigned char>&)>& edit) {
+        model.saveModelFile(path);
+        EXPECT_NO_THROW(SpoilageModel::openModelFile(path));
+        patchSection(path, section, edit);
+        EXPECT_THROW(SpoilageModel::openModelFile(path), std::invalid_argument);
+    };
+
+    // Conditions are {float threshold, uint32 tree, uint64 mask}: masks leaving no leaf, or only leaves past the tree's
+    auto setMask = [](std::uint64_t mask) {
+        return [mask](std::vector<unsigned char>& conditions) { std::memcpy(conditions.data() + 8, &mask, 8); };
+    };
+    expectRejected(3, setMask(0));
+    expectRejected(3, setMask(~std::uint64_t{0} << 12));
+    // Nodes are {int feature, float threshold, uint32 left, uint32 right, float value}; node 0 is a split
+    auto setNodeField = [](std::size_t offset, std::uint32_t value) {
+        return [offset, value](std::vector<unsigned char>& nodes) { std::memcpy(nodes.data() + offset, &value, 4); };
+    };
+    expectRejected(5, setNodeField(0, 9));
+    expectRejected(5, setNodeField(8, 1000));
+    expectRejected(5, setNodeField(12, 1000));
+    std::remove(path.c_str());
+}
+
+TEST(SpoilageModelTest, PredictorScoresPantryItems) {
+    using Clock = std::chrono::system_clock;
+    const Clock::time_point start(std::chrono::hours(24 * 20003));
+    Predictor predictor;
+    for (int day = 0; day < 56; ++day) {
+        predictor.update(1, 7, 200.0, start + std::chrono::hours(24 * day + 12));
+    }
+
+    // Risk is the share of the stock left over at expiry
+    SpoilageModel::Linear linear;
+    linear.weights = {0.0, 0.0, 0.0, 0.001};
+    SpoilageModel model(linear, SpoilageModel::Link::IDENTITY);
+    const auto now = start + std::chrono::hours(24 * 56);
+    auto scores = predictor.scoreSpoilage(model,
+                                          {{1, 7, 0, 1000.0, now + std::chrono::hours(36)},
+                                           {1, 7, 0, 1000.0, now + std::chrono::hours(24 * 10)},
+                                           {2, 7, 0, 1000.0, now + std::chrono::hours(36)}},
+                                          now);
+    ASSERT_EQ(scores.size(), 3u);
+    EXPECT_NEAR(scores[0], 0.7, 0.02);
+    EXPECT_NEAR(scores[1], 0.0, 1e-6);
+    EXPECT_NEAR(scores[2], 1.0, 1e-6);
+}
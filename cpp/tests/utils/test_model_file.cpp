@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <smart_food/utils/model_file.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace smart_food::utils;
+
+namespace {
+
+constexpr std::uint32_t kKind = ModelFile::tag("TEST");
+
+struct Record {
+    std::uint32_t id;
+    float weight;
+};
+
+std::string tempPath(const std::string& name) {
+    return ::testing::TempDir() + name;
+}
+
+std::vector<char> readBytes(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void writeBytes(const std::string& path, const std::vector<char>& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+} // namespace
+
+TEST(ModelFileTest, SectionsRoundTripInPlace) {
+    const std::vector<double> coefficients = {0.5, -1.25, 3.0};
+    const std::vector<Record> records = {{1, 0.5f}, {2, 1.5f}, {3, -2.0f}};
+    const std::string vocabulary = "tomatobasil";
+    ModelFile::Writer writer(kKind, 3);
+    writer.add(coefficients).add(records).add(vocabulary.data(), vocabulary.size()).add(std::vector<float>{});
+
+    const std::string path = tempPath("sections.sfm");
+    writer.save(path);
+    auto file = ModelFile::open(path, kKind, 3);
+    EXPECT_EQ(file->getKind(), kKind);
+    EXPECT_EQ(file->getVersion(), 3u);
+    ASSERT_EQ(file->getSectionCount(), 4u);
+    EXPECT_EQ(file->getSize() % 64, 0u);
+#if defined(__unix__) || defined(__APPLE__)
+    EXPECT_TRUE(file->isMapped());
+#endif
+
+    auto mappedCoefficients = file->section<double>(0);
+    EXPECT_EQ(std::vector<double>(mappedCoefficients.begin(), mappedCoefficients.end()), coefficients);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(mappedCoefficients.data) % 64, 0u);
+    auto mappedRecords = file->section<Record>(1);
+    ASSERT_EQ(mappedRecords.size, 3u);
+    EXPECT_EQ(mappedRecords[2].id, 3u);
+    EXPECT_FLOAT_EQ(mappedRecords[2].weight, -2.0f);
+    auto mappedVocabulary = file->section<char>(2);
+    EXPECT_EQ(std::string(mappedVocabulary.begin(), mappedVocabulary.end()), vocabulary);
+    EXPECT_EQ(file->section<float>(3).size, 0u);
+    EXPECT_THROW(file->section<double>(4), std::invalid_argument);
+    EXPECT_THROW(file->section<Record>(2), std::invalid_argument);
+
+    // The in-memory image matches the file byte for byte
+    auto image = writer.finish();
+    EXPECT_FALSE(image->isMapped());
+    const std::string copy = tempPath("sections_copy.sfm");
+    image->save(copy);
+    EXPECT_EQ(readBytes(copy), readBytes(path));
+
+    // Replacing the file leaves the mapping of the old one intact
+    ModelFile::Writer(kKind, 3).add(std::vector<double>{9.0}).save(path);
+    EXPECT_DOUBLE_EQ(file->section<double>(0)[1], -1.25);
+    EXPECT_DOUBLE_EQ(ModelFile::open(path, kKind, 3)->section<double>(0)[0], 9.0);
+    std::remove(path.c_str());
+    std::remove(copy.c_str());
+}
+
+TEST(ModelFileTest, RejectsDamagedAndForeignFiles) {
+    const std::string path = tempPath("damaged.sfm");
+    ModelFile::Writer(kKind, 1).add(std::vector<std::uint64_t>(100, 7)).save(path);
+    const auto bytes = readBytes(path);
+    EXPECT_NO_THROW(ModelFile::open(path, kKind, 1));
+    EXPECT_THROW(ModelFile::open(path, ModelFile::tag("ELSE"), 1), std::invalid_argument);
+    EXPECT_THROW(ModelFile::open(path, kKind, 2), std::invalid_argument);
+
+    auto flipped = bytes;
+    flipped[bytes.size() - 100] ^= 1;
+    writeBytes(path, flipped);
+    EXPECT_THROW(ModelFile::open(path, kKind, 1), std::invalid_argument);
+
+    writeBytes(path, std::vector<char>(bytes.begin(), bytes.end() - 64));
+    EXPECT_THROW(ModelFile::open(path, kKind, 1), std::invalid_argument);
+
+    auto magic = bytes;
+    magic[0] = 'X';
+    writeBytes(path, magic);
+    EXPECT_THROW(ModelFile::open(path, kKind, 1), std::invalid_argument);
+
+    writeBytes(path, std::vector<char>(10, 'x'));
+    EXPECT_THROW(ModelFile::open(path, kKind, 1), std::invalid_argument);
+    std::remove(path.c_str());
+    EXPECT_THROW(ModelFile::open(path, kKind, 1), std::invalid_argument);
+}
+
+TEST(ModelFileTest, ConcurrentSavesEachWriteTheirOwnTemporary) {
+    const std::string path = tempPath("concurrent.sfm");
+    std::ofstream(path + ".tmp") << "left behind by an older writer";
+    std::vector<std::thread> writers;
+    std::vector<int> failures(8, 0);
+    for (int w = 0; w < 8; ++w) {
+        writers.emplace_back([&, w] {
+            for (int round = 0; round < 20; ++round) {
+                try {
+                    ModelFile::Writer(kKind, 1).add(std::vector<double>(1000, w)).save(path);
+                } catch (const std::invalid_argument&) {
+                    ++failures[w];
+                }
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    EXPECT_EQ(failures, std::vector<int>(8, 0));
+
+    // The file holds one writer's section whole
+    auto file = ModelFile::open(path, kKind, 1);
+    auto values = file->section<double>(0);
+    ASSERT_EQ(values.size, 1000u);
+    EXPECT_EQ(std::count(values.begin(), values.end(), values[0]), 1000);
+    std::remove(path.c_str());
+    std::remove((path + ".tmp").c_str());
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <smart_food/utils/result_cache.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace smart_food::utils;
+
+namespace {
+
+Fingerprint key(int value) {
+    return FingerprintBuilder().add(value).finish();
+}
+
+} // namespace
+
+TEST(ResultCacheTest, FingerprintDependsOnContentAndOrder) {
+    auto a = FingerprintBuilder().add(std::string("ab")).add(std::string("c")).finish();
+    auto b = FingerprintBuilder().add(std::string("a")).add(std::string("bc")).finish();
+    auto c = FingerprintBuilder().add(std::string("ab")).add(std::string("c")).finish();
+    EXPECT_NE(a, b);
+    EXPECT_EQ(a, c);
+
+    EXPECT_NE(FingerprintBuilder().add(1).add(2).finish(), FingerprintBuilder().add(2).add(1).finish());
+    EXPECT_EQ(FingerprintBuilder().add(0.0).finish(), FingerprintBuilder().add(-0.0).finish());
+    EXPECT_NE(FingerprintBuilder().add(1.0).finish(), FingerprintBuilder().add(1.0 + 1e-12).finish());
+}
+
+TEST(ResultCacheTest, EvictsLeastRecentlyUsed) {
+    ResultCache<int> cache(2, 1);
+    cache.insert(key(1), 0, std::make_shared<int>(10));
+    cache.insert(key(2), 0, std::make_shared<int>(20));
+    ASSERT_NE(cache.find(key(1), 0), nullptr);  // 2 is now the oldest
+    cache.insert(key(3), 0, std::make_shared<int>(30));
+
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_EQ(*cache.find(key(1), 0), 10);
+    EXPECT_EQ(cache.find(key(2), 0), nullptr);
+    EXPECT_EQ(*cache.find(key(3), 0), 30);
+    EXPECT_EQ(cache.getStats().evictions, 1u);
+    EXPECT_THROW(ResultCache<int>(0), std::invalid_argument);
+}
+
+TEST(ResultCacheTest, NewerVersionInvalidates) {
+    ResultCache<int> cache(8);
+    cache.insert(key(1), 3, std::make_shared<int>(10));
+    EXPECT_NE(cache.find(key(1), 3), nullptr);
+    EXPECT_EQ(cache.find(key(1), 4), nullptr);
+    EXPECT_EQ(cache.size(), 0u);
+
+    // A late result computed against old data does not replace a fresh one
+    cache.insert(key(2), 5, std::make_shared<int>(50));
+    cache.insert(key(2), 4, std::make_shared<int>(40));
+    EXPECT_EQ(*cache.find(key(2), 5), 50);
+
+    auto stats = cache.getStats();
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.invalidations, 1u);
+}
+
+TEST(ResultCacheTest, ConcurrentAccessStaysBounded) {
+    ResultCache<int> cache(64, 8);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, t] {
+            for (int i = 0; i < 2000; ++i) {
+                const int k = (i * 7 + t) % 100;
+                auto hit = cache.find(key(k), 0);
+                if (hit) {
+                    EXPECT_EQ(*hit, k);
+                } else {
+                    cache.insert(key(k), 0, std::make_shared<int>(k));
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_LE(cache.size(), 64u);
+    auto stats = cache.getStats();
+    EXPECT_EQ(stats.hits + stats.misses, 8000u);
+}
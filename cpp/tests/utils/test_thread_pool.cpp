@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <smart_food/utils/thread_pool.hpp>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace smart_food::utils;
+
+TEST(ThreadPoolTest, RunsEveryIndexOnce) {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.size(), 4);
+
+    std::vector<std::atomic<int>> hits(1000);
+    pool.parallelFor(hits.size(), [&hits](std::size_t i) { hits[i]++; });
+    for (const auto& hit : hits) {
+        EXPECT_EQ(hit.load(), 1);
+    }
+}
+
+TEST(ThreadPoolTest, BalancesUnevenTasks) {
+    ThreadPool pool(3);
+    std::atomic<long> total{0};
+    // The first tasks are much longer than the rest, so idle workers must steal
+    pool.parallelFor(64, [&total](std::size_t i) {
+        long sum = 0;
+        for (long j = 0; j < (i < 4 ? 2000000 : 1000); ++j) {
+            sum += j % 7;
+        }
+        total += sum > 0 ? 1 : 0;
+    });
+    EXPECT_EQ(total.load(), 64);
+}
+
+TEST(ThreadPoolTest, SupportsNestedCalls) {
+    ThreadPool pool(2);
+    std::atomic<int> count{0};
+    pool.parallelFor(4, [&](std::size_t) {
+        pool.parallelFor(8, [&count](std::size_t) { count++; });
+    });
+    EXPECT_EQ(count.load(), 32);
+}
+
+TEST(ThreadPoolTest, RethrowsTaskErrors) {
+    ThreadPool pool(2);
+    std::atomic<int> finished{0};
+    EXPECT_THROW(pool.parallelFor(16, [&finished](std::size_t i) {
+        if (i == 5) {
+            throw std::runtime_error("task failed");
+        }
+        finished++;
+    }), std::runtime_error);
+    EXPECT_EQ(finished.load(), 15);
+}